@@ -0,0 +1,40 @@
+/**
+ * @brief 内存子系统微基准
+ *
+ * 用法：
+ *   memory_benchmarks [Google Benchmark选项]
+ *
+ * 常用选项：
+ *   --benchmark_filter=<正则>             只跑匹配的基准，如 'BM_MemoryPool|BM_Malloc'
+ *   --benchmark_out=<文件>                 结果另存一份，配合--benchmark_out_format=json
+ *   --benchmark_repetitions=<次数>         重复次数，报告会带均值/中位数/标准差
+ *
+ * 对照jemalloc/tcmalloc：LD_PRELOAD对应的库再跑一次，BM_Malloc即为该实现的数字，
+ * 实际生效的malloc记录在输出的context.malloc里。
+ * 两次结果的比较：Google Benchmark源码里的tools/compare.py benchmarks old.json new.json
+ */
+#include <benchmark/benchmark.h>
+
+#ifdef FFMPEG_AVAILABLE
+extern "C" {
+#include <libavutil/avutil.h>
+}
+#endif
+
+#include "memory/baseline_allocators.h"
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    benchmark::AddCustomContext("malloc", bench::detectMallocImplementation());
+#ifdef FFMPEG_AVAILABLE
+    benchmark::AddCustomContext("ffmpeg", av_version_info());
+#endif
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,105 @@
+// bench_frame_allocator.cpp - FFmpegFrameAllocator与av_frame_get_buffer的对比
+//
+// 1080p YUV420P同样字节数的malloc/线程缓存/pmr数字见bench_memory_pool.cpp。
+
+#include <benchmark/benchmark.h>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include "media/allocator/ffmpeg_allocator/ffmpeg_frame_allocator.h"
+
+namespace {
+
+media::FFmpegFrameAllocator& sharedAllocator() {
+    static media::FFmpegFrameAllocator allocator;
+    return allocator;
+}
+
+media::FrameSpec specFor(const benchmark::State& state) {
+    return media::FrameSpec(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+                            media::FFmpegFormats::YUV420P, 32);
+}
+
+void setFrameBytes(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * 3 / 2);
+}
+
+/**
+ * @brief 通用接口：allocateFrame/deallocateFrame（FrameData包装）
+ */
+void BM_FrameAllocator(benchmark::State& state) {
+    media::FFmpegFrameAllocator& allocator = sharedAllocator();
+    const media::FrameSpec spec = specFor(state);
+
+    for (auto _ : state) {
+        try {
+            media::AllocatedFrame frame = allocator.allocateFrame(spec);
+            static_cast<uint8_t*>(frame.frame->data[0])[0] = 1;
+            benchmark::DoNotOptimize(frame.frame->data[0]);
+            allocator.deallocateFrame(std::move(frame.frame));
+        } catch (const media::AllocatorException& e) {
+            state.SkipWithError(e.what());
+            break;
+        }
+    }
+    setFrameBytes(state);
+}
+
+/**
+ * @brief 管线用的引用计数帧：allocateSharedFrame，最后一个引用释放时归还
+ */
+void BM_FrameAllocatorShared(benchmark::State& state) {
+    media::FFmpegFrameAllocator& allocator = sharedAllocator();
+    const media::FrameSpec spec = specFor(state);
+
+    for (auto _ : state) {
+        std::shared_ptr<AVFrame> frame = allocator.allocateSharedFrame(spec);
+        if (!frame) {
+            state.SkipWithError("allocateSharedFrame failed");
+            break;
+        }
+        frame->data[0][0] = 1;
+        benchmark::DoNotOptimize(frame->data[0]);
+    }
+    setFrameBytes(state);
+}
+
+/**
+ * @brief 对照：不用池时的默认路径，av_frame_get_buffer每次都av_buffer_alloc
+ */
+void BM_AvFrameGetBuffer(benchmark::State& state) {
+    for (auto _ : state) {
+        AVFrame* frame = av_frame_alloc();
+        if (!frame) {
+            state.SkipWithError("av_frame_alloc failed");
+            break;
+        }
+        frame->width = static_cast<int>(state.range(0));
+        frame->height = static_cast<int>(state.range(1));
+        frame->format = AV_PIX_FMT_YUV420P;
+        if (av_frame_get_buffer(frame, 32) < 0) {
+            av_frame_free(&frame);
+            state.SkipWithError("av_frame_get_buffer failed");
+            break;
+        }
+        frame->data[0][0] = 1;
+        benchmark::DoNotOptimize(frame->data[0]);
+        av_frame_free(&frame);
+    }
+    setFrameBytes(state);
+}
+
+void applyResolutionsAndThreads(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"width", "height"});
+    bench->Args({640, 360})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+    bench->ThreadRange(1, 4)->UseRealTime();
+}
+
+} // namespace
+
+BENCHMARK(BM_FrameAllocator)->Apply(applyResolutionsAndThreads);
+BENCHMARK(BM_FrameAllocatorShared)->Apply(applyResolutionsAndThreads);
+BENCHMARK(BM_AvFrameGetBuffer)->Apply(applyResolutionsAndThreads);
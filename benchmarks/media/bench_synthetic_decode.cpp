@@ -0,0 +1,191 @@
+// bench_synthetic_decode.cpp - 合成测试媒体上的解封装与解码基准
+//
+// 输入由SyntheticMediaGenerator按基准参数生成，缓存在SYNTH_MEDIA_DIR（默认当前目录下的synthetic_media）：
+// 第一次运行时生成（不计入计时），之后直接复用。同一FFmpeg和编码器版本下文件逐字节一致，
+// 不需要随仓库分发样片，不同机器上的数字可以直接比较。
+//
+// 参数：编解码器 × 画面高度（16:9）× 关键帧间隔（1为全I帧，其余带2个B帧）。
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include "media/decoder/ffmpeg_decoder.h"
+#include "media/demux/ffmpeg_demuxer.h"
+#include "media/input/input_source.h"
+#include "media/synthetic/synthetic_media.h"
+
+namespace {
+
+const media::EncoderCodec kCodecs[] = {
+    media::EncoderCodec::H264,
+    media::EncoderCodec::H265,
+    media::EncoderCodec::Mpeg4
+};
+
+std::string mediaDirectory() {
+    const char* directory = std::getenv("SYNTH_MEDIA_DIR");
+    return directory && *directory ? directory : "synthetic_media";
+}
+
+/**
+ * @brief 按基准参数取输入文件：range(0)编解码器，range(1)画面高度，range(2)关键帧间隔
+ */
+bool ensureMedia(benchmark::State& state, media::SyntheticMediaGenerator::Spec* spec, std::string* path) {
+    spec->codec = kCodecs[state.range(0)];
+    spec->height = static_cast<int>(state.range(1));
+    spec->width = (spec->height * 16 / 9) & ~1;
+    spec->gop_size = static_cast<int>(state.range(2));
+    spec->max_b_frames = spec->gop_size > 1 ? 2 : 0;
+    spec->duration_s = 4.0;
+    spec->audio = false;
+    state.SetLabel(spec->name());
+
+    if (!media::FFmpegVideoEncoder::isAvailable(spec->codec)) {
+        state.SkipWithError("encoder not built into FFmpeg");
+        return false;
+    }
+
+    // 各基准在同一线程上依次运行，锁只防止将来并行注册时重复生成
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    media::SyntheticMediaGenerator generator;
+    media::SyntheticMediaGenerator::Result result;
+    if (!generator.ensure(*spec, mediaDirectory(), &result)) {
+        state.SkipWithError(generator.getLastError().c_str());
+        return false;
+    }
+    *path = result.path;
+    return true;
+}
+
+struct OpenMedia {
+    std::shared_ptr<media::IInputSource> input;
+    media::FFmpegDemuxer demuxer;
+    int video_index = -1;
+
+    bool open(const std::string& path) {
+        input = media::InputSourceFactory::create(path);
+        if (!input || !input->open(path) || !demuxer.initialize(input)) {
+            return false;
+        }
+        video_index = demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+        return video_index >= 0;
+    }
+
+    ~OpenMedia() {
+        if (input) {
+            input->close();
+        }
+    }
+};
+
+/**
+ * @brief 只解封装：从头读完整个文件的视频数据包
+ */
+void BM_DemuxSynthetic(benchmark::State& state) {
+    media::SyntheticMediaGenerator::Spec spec;
+    std::string path;
+    if (!ensureMedia(state, &spec, &path)) {
+        return;
+    }
+    OpenMedia media_file;
+    if (!media_file.open(path)) {
+        state.SkipWithError("open failed");
+        return;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    int64_t packets = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        media_file.demuxer.seekToTime(0);
+        while (media_file.demuxer.readPacket(packet)) {
+            if (packet->stream_index == media_file.video_index) {
+                ++packets;
+                bytes += packet->size;
+            }
+            av_packet_unref(packet);
+        }
+    }
+    av_packet_free(&packet);
+    state.SetItemsProcessed(packets);
+    state.SetBytesProcessed(bytes);
+}
+
+/**
+ * @brief 解封装 + 软件解码全部视频帧（单线程解码，衡量每核吞吐）
+ */
+void BM_DecodeSynthetic(benchmark::State& state) {
+    media::SyntheticMediaGenerator::Spec spec;
+    std::string path;
+    if (!ensureMedia(state, &spec, &path)) {
+        return;
+    }
+    OpenMedia media_file;
+    if (!media_file.open(path)) {
+        state.SkipWithError("open failed");
+        return;
+    }
+    media::FFmpegVideoDecoder::Config config;
+    config.thread_count = 1;
+    media::FFmpegVideoDecoder decoder(config);
+    if (!decoder.initialize(media_file.demuxer.getCodecParameters(media_file.video_index))) {
+        state.SkipWithError("decoder initialize failed");
+        return;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    int64_t frames = 0;
+    auto drain = [&]() {
+        while (decoder.receiveFrame(frame)) {
+            benchmark::DoNotOptimize(frame->data[0]);
+            ++frames;
+            av_frame_unref(frame);
+        }
+    };
+    for (auto _ : state) {
+        media_file.demuxer.seekToTime(0);
+        decoder.flush();
+        while (media_file.demuxer.readPacket(packet)) {
+            if (packet->stream_index == media_file.video_index) {
+                decoder.sendPacket(packet);
+                drain();
+            }
+            av_packet_unref(packet);
+        }
+        decoder.sendPacket(nullptr);
+        drain();
+    }
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+
+    state.SetItemsProcessed(frames);
+    state.SetBytesProcessed(frames * spec.width * spec.height * 3 / 2);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(frames), benchmark::Counter::kIsRate);
+}
+
+void syntheticArgs(benchmark::internal::Benchmark* benchmark) {
+    for (int64_t codec = 0; codec < static_cast<int64_t>(sizeof(kCodecs) / sizeof(kCodecs[0])); ++codec) {
+        for (int64_t height : {360, 720, 1080}) {
+            for (int64_t gop : {1, 60}) {
+                benchmark->Args({codec, height, gop});
+            }
+        }
+    }
+    benchmark->ArgNames({"codec", "height", "gop"});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+BENCHMARK(BM_DemuxSynthetic)->Apply(syntheticArgs);
+BENCHMARK(BM_DecodeSynthetic)->Apply(syntheticArgs);
@@ -0,0 +1,155 @@
+#include "baseline_allocators.h"
+
+#include <dlfcn.h>
+
+#ifdef __GLIBC__
+#include <gnu/libc-version.h>
+#endif
+
+namespace bench {
+
+namespace {
+
+constexpr size_t kHeaderSize = 16;              // 级别 + 空闲链表指针，同时保证16字节对齐
+constexpr int kMinShift = 4;                    // 最小级别16B
+constexpr int kMaxShift = 20;                   // 最大级别1MB
+constexpr int kClassCount = kMaxShift - kMinShift + 1;
+constexpr uint32_t kDirectClass = 0xFFFFFFFFu;  // 超出分级，直接malloc
+constexpr size_t kMaxCachedBlocks = 64;         // 每级最多缓存的块数
+constexpr size_t kMaxCachedBytes = 4 * 1024 * 1024;  // 每级最多缓存的字节数
+
+struct BlockHeader {
+    uint32_t size_class;
+    uint32_t reserved;
+    BlockHeader* next;          // 只在空闲链表里使用
+};
+static_assert(sizeof(BlockHeader) == kHeaderSize, "block header must keep 16-byte alignment");
+
+struct Bin {
+    BlockHeader* head = nullptr;
+    size_t count = 0;
+};
+
+struct ThreadCache {
+    Bin bins[kClassCount];
+
+    ~ThreadCache() { flush(); }
+
+    void flush() {
+        for (Bin& bin : bins) {
+            while (bin.head) {
+                BlockHeader* block = bin.head;
+                bin.head = block->next;
+                std::free(block);
+            }
+            bin.count = 0;
+        }
+    }
+};
+
+thread_local ThreadCache t_cache;
+
+inline uint32_t sizeClassOf(size_t size) {
+    if (size <= (size_t(1) << kMinShift)) {
+        return 0;
+    }
+    const int shift = 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+    return shift > kMaxShift ? kDirectClass : static_cast<uint32_t>(shift - kMinShift);
+}
+
+inline size_t classBytes(uint32_t size_class) {
+    return size_t(1) << (size_class + kMinShift);
+}
+
+inline size_t classCapacity(uint32_t size_class) {
+    const size_t by_bytes = kMaxCachedBytes / classBytes(size_class);
+    return by_bytes < kMaxCachedBlocks ? (by_bytes > 0 ? by_bytes : 1) : kMaxCachedBlocks;
+}
+
+} // namespace
+
+void* ThreadCacheAllocator::allocate(size_t size) {
+    const uint32_t size_class = sizeClassOf(size);
+    if (size_class != kDirectClass) {
+        Bin& bin = t_cache.bins[size_class];
+        if (bin.head) {
+            BlockHeader* block = bin.head;
+            bin.head = block->next;
+            --bin.count;
+            return reinterpret_cast<uint8_t*>(block) + kHeaderSize;
+        }
+    }
+
+    const size_t bytes = size_class != kDirectClass ? classBytes(size_class) : size;
+    auto* block = static_cast<BlockHeader*>(std::malloc(kHeaderSize + bytes));
+    if (!block) {
+        return nullptr;
+    }
+    block->size_class = size_class;
+    return reinterpret_cast<uint8_t*>(block) + kHeaderSize;
+}
+
+void ThreadCacheAllocator::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(ptr) - kHeaderSize);
+    if (block->size_class != kDirectClass) {
+        Bin& bin = t_cache.bins[block->size_class];
+        if (bin.count < classCapacity(block->size_class)) {
+            block->next = bin.head;
+            bin.head = block;
+            ++bin.count;
+            return;
+        }
+    }
+    std::free(block);
+}
+
+void ThreadCacheAllocator::flushThreadCache() {
+    t_cache.flush();
+}
+
+std::string detectMallocImplementation() {
+    // 各实现独有的导出符号（jemalloc可能带je_前缀）
+    if (dlsym(RTLD_DEFAULT, "mallctl") || dlsym(RTLD_DEFAULT, "je_mallctl")) {
+        return "jemalloc";
+    }
+    if (dlsym(RTLD_DEFAULT, "tc_malloc")) {
+        return "tcmalloc";
+    }
+    if (dlsym(RTLD_DEFAULT, "mi_malloc")) {
+        return "mimalloc";
+    }
+#ifdef __GLIBC__
+    return std::string("glibc ") + gnu_get_libc_version();
+#else
+    return "system";
+#endif
+}
+
+MemoryPool& MemoryPoolPolicy::pool() {
+    static MemoryPool instance;
+    return instance;
+}
+
+std::pmr::pool_options pmrPoolOptions() {
+    std::pmr::pool_options options;
+    options.max_blocks_per_chunk = 0;                       // 实现默认
+    options.largest_required_pool_block = 4 * 1024 * 1024;  // 覆盖到1080p帧大小
+    return options;
+}
+
+std::pmr::memory_resource& PmrSyncPolicy::resource() {
+    static std::pmr::synchronized_pool_resource instance(pmrPoolOptions(),
+                                                         std::pmr::new_delete_resource());
+    return instance;
+}
+
+std::pmr::memory_resource& PmrUnsyncPolicy::resource() {
+    thread_local std::pmr::unsynchronized_pool_resource instance(pmrPoolOptions(),
+                                                                 std::pmr::new_delete_resource());
+    return instance;
+}
+
+} // namespace bench
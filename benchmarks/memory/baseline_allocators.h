@@ -0,0 +1,95 @@
+#ifndef BASELINE_ALLOCATORS_H
+#define BASELINE_ALLOCATORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <string>
+
+#include "memory/memory_pool.h"
+
+namespace bench {
+
+/**
+ * @brief jemalloc风格的线程缓存分配器（基准对照用）
+ *
+ * 设计特点：
+ * 1. 大小分级：16B到1MB按2的幂分级，每次分配向上取整到所在级别
+ * 2. 线程缓存：每个线程每个级别一条空闲链表，分配和释放都不加锁（对应jemalloc的tcache）
+ * 3. 有界缓存：每级缓存的块数和字节数都有上限，超出的直接还给malloc
+ * 4. 超出1MB的请求直接走malloc
+ *
+ * 块头16字节记录级别，所以返回的指针16字节对齐；跨线程释放时块进入释放线程的缓存。
+ * 这里只用来衡量"每线程无锁快速路径"能做到多快，不是生产用分配器。
+ */
+class ThreadCacheAllocator {
+public:
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr);
+
+    /**
+     * @brief 释放当前线程缓存的全部块（线程退出时自动调用）
+     */
+    static void flushThreadCache();
+};
+
+/**
+ * @brief 当前进程实际使用的malloc实现
+ *
+ * 通过符号探测：LD_PRELOAD了jemalloc/tcmalloc/mimalloc时malloc基准就是它们的数字。
+ * @return 例如"jemalloc"、"tcmalloc"、"glibc 2.36"
+ */
+std::string detectMallocImplementation();
+
+// ---- 统一的分配策略，供模板化基准使用 ----
+
+/**
+ * @brief 被测的MemoryPool（所有线程共享一个实例，与播放器里的用法一致）
+ */
+struct MemoryPoolPolicy {
+    static MemoryPool& pool();
+    static void* allocate(size_t size) { return pool().allocate(size); }
+    static void deallocate(void* ptr, size_t) { pool().deallocate(ptr); }
+};
+
+struct MallocPolicy {
+    static void* allocate(size_t size) { return std::malloc(size); }
+    static void deallocate(void* ptr, size_t) { std::free(ptr); }
+};
+
+struct ThreadCachePolicy {
+    static void* allocate(size_t size) { return ThreadCacheAllocator::allocate(size); }
+    static void deallocate(void* ptr, size_t) { ThreadCacheAllocator::deallocate(ptr); }
+};
+
+/**
+ * @brief std::pmr::synchronized_pool_resource，所有线程共享
+ */
+struct PmrSyncPolicy {
+    static std::pmr::memory_resource& resource();
+    static void* allocate(size_t size) { return resource().allocate(size, kAlignment); }
+    static void deallocate(void* ptr, size_t size) { resource().deallocate(ptr, size, kAlignment); }
+
+    static constexpr size_t kAlignment = 32;    // 与MemoryPool默认对齐一致
+};
+
+/**
+ * @brief std::pmr::unsynchronized_pool_resource，每线程一个
+ */
+struct PmrUnsyncPolicy {
+    static std::pmr::memory_resource& resource();
+    static void* allocate(size_t size) { return resource().allocate(size, kAlignment); }
+    static void deallocate(void* ptr, size_t size) { resource().deallocate(ptr, size, kAlignment); }
+
+    static constexpr size_t kAlignment = 32;
+};
+
+/**
+ * @brief pool resource的池上限：不超过它的请求由池管理，超过的直接转给上游
+ */
+std::pmr::pool_options pmrPoolOptions();
+
+} // namespace bench
+
+#endif // BASELINE_ALLOCATORS_H
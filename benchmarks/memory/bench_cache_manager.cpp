@@ -0,0 +1,143 @@
+// bench_cache_manager.cpp - CacheManager命中/未命中路径，对照加锁哈希表
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory/cache_manager.h"
+
+namespace {
+
+using ThumbnailCache = CacheManager<std::string, std::vector<uint8_t>>;
+
+constexpr size_t kKeysPerSize = 256;        // 三档值大小共768个键，全部落在L1（默认容量1000）
+constexpr size_t kKeyStride = 97;           // 与键数互质，访问顺序打散但覆盖全部键
+
+std::string makeKey(const char* prefix, int64_t value_size, size_t index) {
+    return std::string(prefix) + std::to_string(value_size) + "/" + std::to_string(index);
+}
+
+/**
+ * @brief 预先生成的键，循环里不构造字符串
+ */
+struct KeySet {
+    std::vector<std::string> hits;
+    std::vector<std::string> misses;
+
+    explicit KeySet(int64_t value_size) {
+        for (size_t i = 0; i < kKeysPerSize; ++i) {
+            hits.push_back(makeKey("thumb/", value_size, i));
+            misses.push_back(makeKey("absent/", value_size, i));
+        }
+    }
+};
+
+const KeySet& keysFor(int64_t value_size) {
+    static const KeySet small(1024);
+    static const KeySet medium(16 * 1024);
+    static const KeySet large(64 * 1024);
+    return value_size <= 1024 ? small : (value_size <= 16 * 1024 ? medium : large);
+}
+
+ThumbnailCache::Config benchConfig() {
+    ThumbnailCache::Config config;
+    config.enable_compression = false;      // 只测查找和返回路径
+    config.enable_prefetch = false;
+    config.cleanup_interval_ms = 0;         // 不启动维护线程
+    return config;
+}
+
+ThumbnailCache& sharedCache() {
+    static ThumbnailCache cache(benchConfig());
+    static const bool filled = [] {
+        for (int64_t value_size : {1024, 16 * 1024, 64 * 1024}) {
+            for (const std::string& key : keysFor(value_size).hits) {
+                cache.put(key, std::vector<uint8_t>(static_cast<size_t>(value_size), 0x5A),
+                          static_cast<size_t>(value_size));
+            }
+        }
+        return true;
+    }();
+    (void)filled;
+    return cache;
+}
+
+/**
+ * @brief 对照：加锁哈希表直接返回共享指针（不拷贝值）
+ */
+struct BaselineMap {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const std::vector<uint8_t>>> entries;
+
+    std::shared_ptr<const std::vector<uint8_t>> get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        return it != entries.end() ? it->second : nullptr;
+    }
+};
+
+BaselineMap& sharedBaseline() {
+    static BaselineMap map;
+    static const bool filled = [] {
+        for (int64_t value_size : {1024, 16 * 1024, 64 * 1024}) {
+            for (const std::string& key : keysFor(value_size).hits) {
+                map.entries[key] = std::make_shared<const std::vector<uint8_t>>(
+                    static_cast<size_t>(value_size), 0x5A);
+            }
+        }
+        return true;
+    }();
+    (void)filled;
+    return map;
+}
+
+template<typename Cache>
+void runLookups(benchmark::State& state, Cache& cache, const std::vector<std::string>& keys,
+                bool expect_hit) {
+    size_t index = static_cast<size_t>(state.thread_index()) * kKeyStride;
+    for (auto _ : state) {
+        auto value = cache.get(keys[index % keys.size()]);
+        if (static_cast<bool>(value) != expect_hit) {
+            state.SkipWithError(expect_hit ? "unexpected miss" : "unexpected hit");
+            break;
+        }
+        benchmark::DoNotOptimize(value.get());
+        index += kKeyStride;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (expect_hit) {
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+}
+
+void BM_CacheHit(benchmark::State& state) {
+    runLookups(state, sharedCache(), keysFor(state.range(0)).hits, true);
+}
+
+void BM_CacheMiss(benchmark::State& state) {
+    runLookups(state, sharedCache(), keysFor(state.range(0)).misses, false);
+}
+
+void BM_CacheBaselineHit(benchmark::State& state) {
+    runLookups(state, sharedBaseline(), keysFor(state.range(0)).hits, true);
+}
+
+void BM_CacheBaselineMiss(benchmark::State& state) {
+    runLookups(state, sharedBaseline(), keysFor(state.range(0)).misses, false);
+}
+
+void applyValueSizesAndThreads(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("value_size")->Arg(1024)->Arg(16 * 1024)->Arg(64 * 1024);
+    bench->ThreadRange(1, 8)->UseRealTime();
+}
+
+} // namespace
+
+BENCHMARK(BM_CacheHit)->Apply(applyValueSizesAndThreads);
+BENCHMARK(BM_CacheMiss)->Apply(applyValueSizesAndThreads);
+BENCHMARK(BM_CacheBaselineHit)->Apply(applyValueSizesAndThreads);
+BENCHMARK(BM_CacheBaselineMiss)->Apply(applyValueSizesAndThreads);
@@ -0,0 +1,98 @@
+// bench_memory_pool.cpp - MemoryPool与各基准分配器的分配/释放对比
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+
+#include "baseline_allocators.h"
+
+namespace {
+
+// 每个线程保持的在用块数：比"分配完立刻释放"更接近解码队列的生命周期
+constexpr size_t kLiveBlocks = 16;
+
+/**
+ * @brief 环形替换：释放最旧的块、分配一块新的并写第一个字节
+ */
+template<typename Policy>
+void runAllocFree(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+
+    std::array<void*, kLiveBlocks> live{};
+    for (void*& ptr : live) {
+        ptr = Policy::allocate(size);
+    }
+
+    size_t slot = 0;
+    for (auto _ : state) {
+        Policy::deallocate(live[slot], size);
+        live[slot] = Policy::allocate(size);
+        if (!live[slot]) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        static_cast<volatile uint8_t*>(live[slot])[0] = 1;
+        slot = (slot + 1) % kLiveBlocks;
+    }
+
+    for (void* ptr : live) {
+        if (ptr) {
+            Policy::deallocate(ptr, size);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+
+/**
+ * @brief 尺寸覆盖MemoryPool的三层和典型数据包/帧大小，线程数1到8
+ */
+void applySizesAndThreads(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("size");
+    for (int64_t size : {64, 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024,
+                         1920 * 1080 * 3 / 2}) {     // 最后一档是1080p YUV420P帧
+        bench->Arg(size);
+    }
+    bench->ThreadRange(1, 8)->UseRealTime();
+}
+
+void BM_MemoryPool(benchmark::State& state) {
+    MemoryPool& pool = bench::MemoryPoolPolicy::pool();
+    const auto before = pool.getStatistics();
+
+    runAllocFree<bench::MemoryPoolPolicy>(state);
+
+    // 计数器按线程求和，只由0号线程报告池自身的指标
+    if (state.thread_index() == 0) {
+        const auto after = pool.getStatistics();
+        const double allocations = static_cast<double>(after.allocation_count - before.allocation_count);
+        const double hits = static_cast<double>(after.pool_hit_count - before.pool_hit_count);
+        state.counters["pool_hit_rate"] = allocations > 0 ? hits / allocations : 0.0;
+        state.counters["fragmentation"] = pool.getFragmentationRate();
+    }
+}
+
+void BM_Malloc(benchmark::State& state) {
+    runAllocFree<bench::MallocPolicy>(state);
+}
+
+void BM_ThreadCache(benchmark::State& state) {
+    runAllocFree<bench::ThreadCachePolicy>(state);
+}
+
+void BM_PmrSynchronized(benchmark::State& state) {
+    runAllocFree<bench::PmrSyncPolicy>(state);
+}
+
+void BM_PmrUnsynchronized(benchmark::State& state) {
+    runAllocFree<bench::PmrUnsyncPolicy>(state);
+}
+
+} // namespace
+
+BENCHMARK(BM_MemoryPool)->Apply(applySizesAndThreads);
+BENCHMARK(BM_Malloc)->Apply(applySizesAndThreads);
+BENCHMARK(BM_ThreadCache)->Apply(applySizesAndThreads);
+BENCHMARK(BM_PmrSynchronized)->Apply(applySizesAndThreads);
+BENCHMARK(BM_PmrUnsynchronized)->Apply(applySizesAndThreads);
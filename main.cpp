@@ -1,5 +1,23 @@
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QTimer>
+#include <QtQml>
+
+#include "core/startup_coordinator.h"
+#include "media/renderer/video_item.h"
+#include "media/thumbnail/thumbnail_service.h"
+#include "ui/performance_overlay_model.h"
+#include "utils/perf_counters.h"
+
+namespace {
+
+// 启动基准：首帧（无媒体时为首次出窗口）之后输出报告并退出
+constexpr int kStartupBenchmarkTimeoutMs = 15000;
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
@@ -8,7 +26,60 @@ int main(int argc, char *argv[])
 #endif
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("media"), QStringLiteral("启动时打开的媒体文件或URL"));
+    QCommandLineOption benchmarkOption(QStringLiteral("startup-benchmark"),
+                                       QStringLiteral("测量出窗口和首帧时间，输出报告后退出"));
+    QCommandLineOption serialOption(QStringLiteral("startup-serial"),
+                                    QStringLiteral("串行初始化（与并行启动对比）"));
+    QCommandLineOption allocTraceOption(QStringLiteral("alloc-trace"),
+                                        QStringLiteral("记录播放管道的分配轨迹，退出时写入文件（用alloc_replay回放）"),
+                                        QStringLiteral("file"));
+    QCommandLineOption perfCountersOption(QStringLiteral("perf-counters"),
+                                          QStringLiteral("按阶段统计硬件性能计数器（周期、指令、末级缓存未命中、分支预测失败）"));
+    parser.addOption(benchmarkOption);
+    parser.addOption(serialOption);
+    parser.addOption(allocTraceOption);
+    parser.addOption(perfCountersOption);
+    parser.process(app);
+
+    // 计数组在各线程首次进入阶段时打开；这里先在主线程探测一次，不可用时说明原因
+    if (parser.isSet(perfCountersOption)) {
+        const media::PerfCounters::Status status = media::PerfCounters::status();
+        if (status.available) {
+            media::PerfCounters::setEnabled(true);
+        } else {
+            qWarning().noquote() << "硬件性能计数器不可用:" << QString::fromStdString(status.error);
+        }
+    }
+
+    // 后台初始化FFmpeg和共享服务、打开第一个媒体，与下面的QML加载并行
+    media::StartupCoordinator::Config startupConfig;
+    if (!parser.positionalArguments().isEmpty()) {
+        startupConfig.media_url = parser.positionalArguments().first();
+    }
+    startupConfig.parallel = !parser.isSet(serialOption);
+    startupConfig.alloc_trace_path = parser.value(allocTraceOption);
+    media::StartupCoordinator startup(startupConfig);
+    QObject::connect(&startup, &media::StartupCoordinator::mediaFailed, &app, [](const QString& error) {
+        qWarning().noquote() << "打开媒体失败:" << error;
+    });
+    startup.startBackground();
+
+    // 注册QML类型
+    qmlRegisterType<media::VideoItem>("FFplay.Media", 1, 0, "VideoItem");
+
+    // 缩略图服务必须比engine活得久（图片提供器引用它）
+    media::ThumbnailService thumbnailService;
+
+    // 性能浮层数据源：浮层隐藏时不采样
+    media::PerformanceOverlayModel performanceModel;
+
     QQmlApplicationEngine engine;
+    engine.addImageProvider(QStringLiteral("thumbnails"), new media::ThumbnailImageProvider(&thumbnailService));
+    engine.rootContext()->setContextProperty(QStringLiteral("thumbnailService"), &thumbnailService);
+    engine.rootContext()->setContextProperty(QStringLiteral("performanceModel"), &performanceModel);
     const QUrl url(QStringLiteral("qrc:/resources/qml/main.qml"));
     QObject::connect(
         &engine,
@@ -20,6 +91,33 @@ int main(int argc, char *argv[])
         },
         Qt::QueuedConnection);
     engine.load(url);
+    startup.markQmlLoaded();
+
+    // 播放管道的视频回调引用VideoItem，必须先于engine停止
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &startup, &media::StartupCoordinator::shutdown);
+
+    if (!engine.rootObjects().isEmpty()) {
+        auto* window = qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+        auto* videoItem = window ? window->findChild<media::VideoItem*>(QStringLiteral("videoItem")) : nullptr;
+        startup.attach(window, videoItem);
+    }
+
+    if (parser.isSet(benchmarkOption)) {
+        auto finish = [&startup](int code) {
+            qInfo().noquote() << startup.report();
+            QCoreApplication::exit(code);
+        };
+        if (startupConfig.media_url.isEmpty()) {
+            QObject::connect(&startup, &media::StartupCoordinator::windowShown, &app, [finish]() { finish(0); });
+        } else {
+            QObject::connect(&startup, &media::StartupCoordinator::firstFrameShown, &app, [finish]() { finish(0); });
+            QObject::connect(&startup, &media::StartupCoordinator::mediaFailed, &app, [finish]() { finish(1); });
+        }
+        QTimer::singleShot(kStartupBenchmarkTimeoutMs, &app, [finish]() {
+            qWarning() << "启动基准超时";
+            finish(1);
+        });
+    }
 
     return app.exec();
 }
@@ -0,0 +1,150 @@
+import QtQuick 2.15
+
+// 性能浮层：显示MetricsRegistry中的阶段fps/耗时、队列深度、池命中率、响度、硬件计数、内存压力和丢帧
+// 用法：PerformanceOverlay { model: performanceModel; visible: showStats }
+// 隐藏时model.active随visible变为false，采样定时器停止
+Rectangle {
+    id: overlay
+
+    property var model: null
+    property int intervalMs: 500
+
+    width: content.implicitWidth + 16
+    height: content.implicitHeight + 16
+    radius: 4
+    color: "#b0000000"
+
+    Binding {
+        target: overlay.model
+        property: "active"
+        value: overlay.visible
+        when: overlay.model !== null
+    }
+
+    Binding {
+        target: overlay.model
+        property: "intervalMs"
+        value: overlay.intervalMs
+        when: overlay.model !== null
+    }
+
+    function pressureColor(level) {
+        switch (level) {
+        case 0: return "#7cd67c"
+        case 1: return "#e6d35a"
+        case 2: return "#f0a040"
+        case 3: return "#ff5050"
+        default: return "#a0a0a0"
+        }
+    }
+
+    // 响度值：负无穷（静音或尚未测满一个窗口）显示为-inf
+    function level(value) {
+        return (isFinite(value) ? value.toFixed(1) : "-inf").padStart(6)
+    }
+
+    Column {
+        id: content
+        x: 8
+        y: 8
+        spacing: 2
+
+        Text {
+            color: "white"
+            font.family: "monospace"
+            font.bold: true
+            text: "stage            fps   avg ms  max ms"
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.stages : []
+            Text {
+                color: "white"
+                font.family: "monospace"
+                text: modelData.name.padEnd(14) + " "
+                      + modelData.fps.toFixed(1).padStart(6) + " "
+                      + modelData.latencyMs.toFixed(2).padStart(8) + " "
+                      + modelData.maxLatencyMs.toFixed(2).padStart(7)
+            }
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.queues : []
+            Text {
+                color: "#c0e0ff"
+                font.family: "monospace"
+                text: "queue " + modelData.name.padEnd(20) + " " + modelData.depth.toFixed(0)
+            }
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.pools : []
+            Text {
+                color: "#c0ffc0"
+                font.family: "monospace"
+                text: "pool  " + modelData.name.padEnd(20) + " " + (modelData.hitRate * 100).toFixed(1) + "%"
+            }
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.drops : []
+            Text {
+                color: modelData.perSecond > 0 ? "#ff8080" : "#d0d0d0"
+                font.family: "monospace"
+                text: "drop  " + modelData.name.padEnd(20) + " " + modelData.total
+                      + " (" + modelData.perSecond.toFixed(1) + "/s)"
+            }
+        }
+
+        Text {
+            visible: overlay.model !== null && overlay.model.loudness.length > 0
+            color: "white"
+            font.family: "monospace"
+            font.bold: true
+            text: "loudness            M      S      I    LRA     TP"
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.loudness : []
+            Text {
+                // EBU R128：真峰值不超过-1 dBTP
+                color: modelData.truePeak > -1.0 ? "#ff8080" : "#ffe0a0"
+                font.family: "monospace"
+                text: modelData.name.padEnd(14) + " "
+                      + overlay.level(modelData.momentary) + " "
+                      + overlay.level(modelData.shortTerm) + " "
+                      + overlay.level(modelData.integrated) + " "
+                      + modelData.range.toFixed(1).padStart(6) + " "
+                      + overlay.level(modelData.truePeak)
+            }
+        }
+
+        Text {
+            visible: overlay.model !== null && overlay.model.counters.length > 0
+            color: "white"
+            font.family: "monospace"
+            font.bold: true
+            text: "counters          IPC  LLC/ki   BR/ki  kcyc/call"
+        }
+
+        Repeater {
+            model: overlay.model ? overlay.model.counters : []
+            Text {
+                color: "#e0c0ff"
+                font.family: "monospace"
+                text: modelData.name.padEnd(14) + " "
+                      + modelData.ipc.toFixed(2).padStart(6) + " "
+                      + modelData.llcMpki.toFixed(2).padStart(7) + " "
+                      + modelData.branchMpki.toFixed(2).padStart(7) + " "
+                      + modelData.kcyclesPerCall.toFixed(1).padStart(10)
+            }
+        }
+
+        Text {
+            color: overlay.pressureColor(overlay.model ? overlay.model.memoryPressureLevel : -1)
+            font.family: "monospace"
+            text: "memory pressure: " + (overlay.model ? overlay.model.memoryPressure : "N/A")
+                  + "   dropped: " + (overlay.model ? overlay.model.droppedFrames : 0)
+        }
+    }
+}
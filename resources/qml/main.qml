@@ -1,9 +1,42 @@
 import QtQuick 2.15
 import QtQuick.Window 2.15
+import FFplay.Media 1.0
 
 Window {
     width: 640
     height: 480
     visible: true
+    color: "black"
     title: qsTr("Hello World")
+
+    property bool showPerformance: false
+
+    VideoItem {
+        id: videoItem
+        objectName: "videoItem"
+        anchors.fill: parent
+    }
+
+    // F3切换性能浮层；第一次打开时才创建，不占用启动时间
+    Loader {
+        id: performanceOverlay
+        objectName: "performanceOverlay"
+        anchors.top: parent.top
+        anchors.left: parent.left
+        anchors.margins: 8
+        active: false
+        asynchronous: true
+        sourceComponent: PerformanceOverlay {
+            model: performanceModel
+            visible: showPerformance
+        }
+    }
+
+    Shortcut {
+        sequence: "F3"
+        onActivated: {
+            showPerformance = !showPerformance
+            performanceOverlay.active = true
+        }
+    }
 }
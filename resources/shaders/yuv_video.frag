@@ -0,0 +1,30 @@
+#version 440
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    mat4 colorMatrix;
+    float qt_Opacity;
+    int planeLayout;     // 0: Y/U/V 三平面  1: Y + UV交错（NV12）
+};
+
+layout(binding = 1) uniform sampler2D yTexture;
+layout(binding = 2) uniform sampler2D uTexture;
+layout(binding = 3) uniform sampler2D vTexture;
+
+void main()
+{
+    float y = texture(yTexture, texCoord).r;
+    vec2 uv;
+    if (planeLayout == 1) {
+        uv = texture(uTexture, texCoord).rg;
+    } else {
+        uv = vec2(texture(uTexture, texCoord).r, texture(vTexture, texCoord).r);
+    }
+
+    // YUV -> RGB 在GPU上完成，矩阵已包含范围（limited/full）和色彩空间（BT.601/709/2020）
+    vec4 rgb = colorMatrix * vec4(y, uv, 1.0);
+    fragColor = vec4(clamp(rgb.rgb, 0.0, 1.0), 1.0) * qt_Opacity;
+}
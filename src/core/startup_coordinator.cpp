@@ -0,0 +1,293 @@
+#include "startup_coordinator.h"
+#include "../media/media_pipeline.h"
+#include "../media/renderer/video_item.h"
+#include "../media/snapshot/snapshot_service.h"
+#include "../utils/metrics_registry.h"
+#include "../memory/memory_tracker.h"
+#include "../memory/copy_accounting.h"
+
+#include <QDebug>
+#include <QQuickWindow>
+#include <QTextStream>
+#include <QUrl>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace media {
+
+StartupCoordinator::StartupCoordinator(const Config& config, QObject* parent)
+    : QObject(parent)
+    , config_(config) {
+    clock_.start();
+
+    if (!config_.alloc_trace_path.isEmpty()) {
+        MemoryTracker::Config tracker_config;
+        tracker_config.enable_history = false;      // 不需要后台快照线程
+        memory_tracker_ = std::make_shared<MemoryTracker>(tracker_config);
+        memory_tracker_->startTrace();
+    }
+}
+
+StartupCoordinator::~StartupCoordinator() {
+    shutdown();
+}
+
+double StartupCoordinator::nowMs() const {
+    return clock_.nsecsElapsed() / 1000000.0;
+}
+
+void StartupCoordinator::runTask(const QString& name, const std::function<bool()>& task) {
+    TaskTiming timing;
+    timing.name = name;
+    timing.start_ms = nowMs();
+    timing.success = task();
+    timing.end_ms = nowMs();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.append(timing);
+}
+
+void StartupCoordinator::launch(std::function<void()> job) {
+    if (config_.parallel) {
+        threads_.emplace_back(std::move(job));
+    } else {
+        job();
+    }
+}
+
+void StartupCoordinator::startBackground() {
+    // FFmpeg初始化（含网络）要先于打开网络流，两者放在同一线程内先后执行
+    launch([this]() {
+        runTask(QStringLiteral("ffmpeg_init"), &StartupCoordinator::initializeFFmpeg);
+        if (!config_.media_url.isEmpty()) {
+            runTask(QStringLiteral("media_open"), [this]() { return openMedia(); });
+        }
+    });
+    launch([this]() {
+        runTask(QStringLiteral("services"), &StartupCoordinator::initializeServices);
+    });
+}
+
+void StartupCoordinator::markQmlLoaded() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    qml_loaded_ms_ = nowMs();
+}
+
+void StartupCoordinator::attach(QQuickWindow* window, VideoItem* video_item) {
+    if (window_) {
+        disconnect(window_, nullptr, this, nullptr);
+    }
+    window_ = window;
+    video_item_ = video_item;
+    watched_item_.store(video_item);
+
+    if (window) {
+        // 渲染线程直接回调，记录的是真正交换缓冲的时刻
+        connect(window, &QQuickWindow::frameSwapped, this, &StartupCoordinator::onFrameSwapped,
+                Qt::DirectConnection);
+    }
+    startPlayback();
+}
+
+void StartupCoordinator::shutdown() {
+    if (shut_down_) {
+        return;
+    }
+    shut_down_ = true;
+
+    if (window_) {
+        disconnect(window_, nullptr, this, nullptr);
+    }
+    watched_item_.store(nullptr);
+
+    // 先停管道：视频回调引用了VideoItem
+    if (pipeline_) {
+        pipeline_->stop();
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    pipeline_.reset();
+    playing_ = false;
+
+    saveAllocationTrace();
+
+#ifdef COPY_ACCOUNTING_ENABLED
+    qInfo().noquote() << QString::fromStdString(CopyAccounting::instance().report());
+#endif
+}
+
+void StartupCoordinator::saveAllocationTrace() {
+    if (!memory_tracker_ || !memory_tracker_->isTracing()) {
+        return;
+    }
+
+    // 渲染器还持有的帧在轨迹里没有释放，回放时最后统一归还
+    const AllocationTrace trace = memory_tracker_->stopTrace();
+    if (!trace.save(config_.alloc_trace_path.toStdString())) {
+        qWarning().noquote() << "保存分配轨迹失败:" << QString::fromStdString(trace.getLastError());
+        return;
+    }
+    qInfo().noquote() << "分配轨迹已写入" << config_.alloc_trace_path
+                      << QStringLiteral("(%1个事件, %2个线程)").arg(trace.eventCount()).arg(trace.threadCount());
+}
+
+StartupCoordinator::Timeline StartupCoordinator::timeline() const {
+    Timeline timeline;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timeline.qml_loaded_ms = qml_loaded_ms_;
+        timeline.media_ready_ms = media_ready_ms_;
+        timeline.tasks = tasks_;
+    }
+    timeline.window_shown_ms = window_shown_ms_.load();
+    timeline.first_frame_ms = first_frame_ms_.load();
+    return timeline;
+}
+
+QString StartupCoordinator::report() const {
+    const Timeline line = timeline();
+    auto format = [](double ms) {
+        return ms < 0.0 ? QStringLiteral("-") : QString::number(ms, 'f', 1);
+    };
+
+    QString text;
+    QTextStream out(&text);
+    out << "启动时间线（毫秒，" << (config_.parallel ? "并行" : "串行") << "）\n";
+    out << "  QML加载完成:  " << format(line.qml_loaded_ms) << "\n";
+    out << "  首次出窗口:    " << format(line.window_shown_ms) << "\n";
+    out << "  媒体就绪:      " << format(line.media_ready_ms) << "\n";
+    out << "  首帧上屏:      " << format(line.first_frame_ms) << "\n";
+    out << "  后台任务:\n";
+    for (const TaskTiming& task : line.tasks) {
+        out << "    " << task.name << ": " << format(task.start_ms) << " -> " << format(task.end_ms)
+            << " (" << format(task.end_ms - task.start_ms) << ")" << (task.success ? "" : " 失败") << "\n";
+    }
+    out.flush();
+    return text;
+}
+
+bool StartupCoordinator::initializeFFmpeg() {
+    avformat_network_init();
+    // 首次查找编解码器会初始化内部表，提前在后台完成
+    avcodec_find_decoder(AV_CODEC_ID_H264);
+    avcodec_find_decoder(AV_CODEC_ID_HEVC);
+    avcodec_find_decoder(AV_CODEC_ID_AAC);
+    return true;
+}
+
+bool StartupCoordinator::initializeServices() {
+    // 这些单例首次使用时才创建；截图服务会启动工作线程，不放在GUI线程上
+    MetricsRegistry::instance();
+    SnapshotService::instance();
+    return true;
+}
+
+bool StartupCoordinator::openMedia() {
+    // 支持file:// URL和本地路径
+    const QUrl url(config_.media_url);
+    const QString path = url.isLocalFile() ? url.toLocalFile() : config_.media_url;
+
+    // 打开包括输入源、解封装探测和解码器上下文创建，是启动中最慢的一步
+    auto pipeline = std::make_shared<MediaPipeline>();
+    pipeline->setMemoryTracker(memory_tracker_);
+    if (!pipeline->open(path.toStdString())) {
+        const QString error = QString::fromStdString(pipeline->getLastError());
+        QMetaObject::invokeMethod(this, [this, error]() {
+            emit mediaFailed(error);
+        }, Qt::QueuedConnection);
+        return false;
+    }
+
+    QMetaObject::invokeMethod(this, [this, pipeline]() {
+        onMediaOpened(pipeline);
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+void StartupCoordinator::onMediaOpened(std::shared_ptr<MediaPipeline> pipeline) {
+    if (shut_down_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        media_ready_ms_ = nowMs();
+    }
+    pipeline_ = std::move(pipeline);
+    emit mediaReady();
+    startPlayback();
+}
+
+void StartupCoordinator::startPlayback() {
+    if (playing_ || shut_down_ || !pipeline_ || !video_item_ || !config_.auto_play) {
+        return;
+    }
+
+    VideoItem* item = video_item_;
+    pipeline_->setVideoFrameCallback([item](AVFrame* frame) {
+        // 回调返回后帧即被复用：只增加缓冲引用，不复制像素
+        AVFrame* ref = av_frame_clone(frame);
+        if (ref) {
+            item->presentFrame(ffmpeg::SharedPointerFactory::wrapFrame(ref));
+        }
+    });
+
+    warmupStaging();
+
+    if (!pipeline_->start()) {
+        emit mediaFailed(QString::fromStdString(pipeline_->getLastError()));
+        return;
+    }
+    playing_ = true;
+}
+
+void StartupCoordinator::warmupStaging() {
+    const StreamInfo info = pipeline_->getVideoStreamInfo();
+    if (info.width <= 0 || info.height <= 0) {
+        return;
+    }
+
+    // 渲染路径需要转换时，首帧会从暂存池取帧；提前在后台分配好
+    const AVPixelFormat format = video_item_->stagingFormatFor(info.pix_fmt);
+    if (format == AV_PIX_FMT_NONE) {
+        return;
+    }
+    std::shared_ptr<FFmpegFrameAllocator> allocator = video_item_->stagingAllocator();
+    const FrameSpec spec(info.width, info.height, format);
+    launch([this, allocator, spec]() {
+        runTask(QStringLiteral("staging_warmup"), [allocator, spec]() {
+            allocator->preallocateFrames(spec, VideoItem::kStagingFrames);
+            return true;
+        });
+    });
+}
+
+void StartupCoordinator::onFrameSwapped() {
+    const double now = nowMs();
+
+    double expected = -1.0;
+    if (window_shown_ms_.compare_exchange_strong(expected, now)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            emit windowShown();
+        }, Qt::QueuedConnection);
+    }
+
+    // 首帧：VideoItem在本次同步中显示了第一帧
+    VideoItem* item = watched_item_.load();
+    if (item && first_frame_ms_.load() < 0.0 && item->pacingSnapshot().presented_frames > 0) {
+        expected = -1.0;
+        if (first_frame_ms_.compare_exchange_strong(expected, now)) {
+            QMetaObject::invokeMethod(this, [this]() {
+                emit firstFrameShown();
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+} // namespace media
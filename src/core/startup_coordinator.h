@@ -0,0 +1,164 @@
+#ifndef STARTUP_COORDINATOR_H
+#define STARTUP_COORDINATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QQuickWindow;
+class MemoryTracker;
+
+namespace media {
+
+class MediaPipeline;
+class VideoItem;
+
+/**
+ * @brief 启动协调器
+ *
+ * 设计特点：
+ * 1. 先出窗口：FFmpeg初始化、共享服务（指标、截图线程）在后台线程进行，GUI线程只加载QML
+ * 2. 并行打开：第一个媒体的打开（输入源、解封装探测、解码器上下文）与QML加载同时进行
+ * 3. 汇合启动：媒体就绪且VideoItem就位后接上视频回调开始播放，同时在后台预分配渲染暂存池
+ * 4. 计时：记录各后台任务耗时、QML加载、首次出窗口（time-to-window）和首帧上屏（time-to-first-frame）
+ * 5. 串行模式：parallel为false时所有任务在startBackground内同步执行，用于对比
+ * 6. 分配轨迹：指定alloc_trace_path时记录播放管道的包/帧缓冲分配轨迹，shutdown时写入文件
+ *
+ * 时间零点为协调器构造时刻，main中应紧跟QGuiApplication创建。
+ * 播放管道的视频回调引用VideoItem，应用退出前（aboutToQuit）必须调用shutdown，
+ * 保证管道先于QML引擎停止。
+ */
+class StartupCoordinator : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 启动配置
+     */
+    struct Config {
+        QString media_url;              // 启动时打开的媒体，为空则只启动界面
+        bool parallel;                  // 后台并行初始化
+        bool auto_play;                 // 媒体就绪后自动播放
+        QString alloc_trace_path;       // 非空时记录管道的分配轨迹，shutdown时写入该文件
+
+        Config()
+            : parallel(true)
+            , auto_play(true)
+        {}
+    };
+
+    /**
+     * @brief 单个启动任务的耗时
+     */
+    struct TaskTiming {
+        QString name;
+        double start_ms = 0.0;          // 相对时间零点
+        double end_ms = 0.0;
+        bool success = true;
+    };
+
+    /**
+     * @brief 启动时间线快照（毫秒，相对时间零点，未发生为-1）
+     */
+    struct Timeline {
+        double qml_loaded_ms = -1.0;
+        double window_shown_ms = -1.0;
+        double media_ready_ms = -1.0;
+        double first_frame_ms = -1.0;
+        QVector<TaskTiming> tasks;
+    };
+
+public:
+    explicit StartupCoordinator(const Config& config = Config{}, QObject* parent = nullptr);
+    ~StartupCoordinator() override;
+
+    StartupCoordinator(const StartupCoordinator&) = delete;
+    StartupCoordinator& operator=(const StartupCoordinator&) = delete;
+
+    /**
+     * @brief 启动后台初始化任务（GUI线程，在加载QML之前调用）
+     */
+    void startBackground();
+
+    /**
+     * @brief 标记QML加载完成（engine.load返回后调用）
+     */
+    void markQmlLoaded();
+
+    /**
+     * @brief 接入窗口和视频项，开始统计出窗口/首帧时间；媒体已就绪时立即开始播放
+     */
+    void attach(QQuickWindow* window, VideoItem* video_item);
+
+    /**
+     * @brief 停止播放并等待后台任务结束（应用退出前调用）
+     */
+    void shutdown();
+
+    Timeline timeline() const;
+
+    /**
+     * @brief 可读的启动报告
+     */
+    QString report() const;
+
+    /**
+     * @brief 播放管道（媒体就绪前为空）
+     */
+    std::shared_ptr<MediaPipeline> pipeline() const { return pipeline_; }
+
+    const Config& config() const { return config_; }
+
+signals:
+    void mediaReady();
+    void mediaFailed(const QString& error);
+    void windowShown();
+    void firstFrameShown();
+
+private:
+    double nowMs() const;
+    void runTask(const QString& name, const std::function<bool()>& task);
+    void launch(std::function<void()> job);
+
+    static bool initializeFFmpeg();
+    static bool initializeServices();
+    bool openMedia();
+
+    void onMediaOpened(std::shared_ptr<MediaPipeline> pipeline);
+    void startPlayback();
+    void warmupStaging();
+    void onFrameSwapped();
+    void saveAllocationTrace();
+
+private:
+    Config config_;
+    QElapsedTimer clock_;
+
+    mutable std::mutex mutex_;                  // 保护tasks_和时间点
+    QVector<TaskTiming> tasks_;
+    double qml_loaded_ms_ = -1.0;
+    double media_ready_ms_ = -1.0;
+    std::atomic<double> window_shown_ms_{-1.0};
+    std::atomic<double> first_frame_ms_{-1.0};
+
+    std::vector<std::thread> threads_;          // 只在GUI线程增删
+    std::shared_ptr<MediaPipeline> pipeline_;   // GUI线程
+    std::shared_ptr<MemoryTracker> memory_tracker_;     // 构造时创建，只读
+    QPointer<QQuickWindow> window_;
+    QPointer<VideoItem> video_item_;
+    std::atomic<VideoItem*> watched_item_{nullptr};     // 渲染线程读取首帧统计
+    bool playing_ = false;
+    bool shut_down_ = false;
+};
+
+} // namespace media
+
+#endif // STARTUP_COORDINATOR_H
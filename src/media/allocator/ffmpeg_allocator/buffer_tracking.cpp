@@ -0,0 +1,105 @@
+// buffer_tracking.cpp - FFmpeg缓冲区生命周期跟踪
+#include "buffer_tracking.h"
+
+#include "../../../memory/memory_tracker.h"
+
+#include <cstdint>
+#include <new>
+
+namespace media {
+
+namespace {
+
+constexpr size_t kMaxObservedAlignment = 64;
+
+/**
+ * @brief 包装缓冲区的opaque：释放时需要跟踪器和原引用
+ */
+struct TrackedBuffer {
+    std::shared_ptr<MemoryTracker> tracker;
+    AVBufferRef* original;
+};
+
+void releaseTrackedBuffer(void* opaque, uint8_t* data) {
+    auto* tracked = static_cast<TrackedBuffer*>(opaque);
+    tracked->tracker->recordDeallocation(data);
+    av_buffer_unref(&tracked->original);
+    delete tracked;
+}
+
+size_t observedAlignment(const void* ptr) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t lowest_bit = address & (~address + 1);
+    return lowest_bit == 0 || lowest_bit > kMaxObservedAlignment ? kMaxObservedAlignment
+                                                                 : static_cast<size_t>(lowest_bit);
+}
+
+int trackedGetBuffer2(AVCodecContext* codec_ctx, AVFrame* frame, int flags) {
+    const int ret = avcodec_default_get_buffer2(codec_ctx, frame, flags);
+    if (ret >= 0 && codec_ctx->opaque) {
+        const auto* tracker = static_cast<const std::shared_ptr<MemoryTracker>*>(codec_ctx->opaque);
+        trackFrameBuffers(*tracker, frame,
+                          codec_ctx->codec_type == AVMEDIA_TYPE_AUDIO ? "decoder/audio" : "decoder/video");
+    }
+    return ret;
+}
+
+} // namespace
+
+bool trackBuffer(const std::shared_ptr<MemoryTracker>& tracker, AVBufferRef** buf, const char* location) {
+    if (!tracker || !buf || !*buf || !(*buf)->data) {
+        return false;
+    }
+
+    AVBufferRef* original = *buf;
+    auto* tracked = new (std::nothrow) TrackedBuffer{tracker, original};
+    if (!tracked) {
+        return false;
+    }
+
+    const int flags = av_buffer_is_writable(original) ? 0 : AV_BUFFER_FLAG_READONLY;
+    AVBufferRef* wrapper = av_buffer_create(original->data, original->size,
+                                            releaseTrackedBuffer, tracked, flags);
+    if (!wrapper) {
+        delete tracked;
+        return false;
+    }
+
+    tracker->recordAllocation(original->data, static_cast<size_t>(original->size),
+                              location ? location : "", observedAlignment(original->data));
+    *buf = wrapper;
+    return true;
+}
+
+int trackFrameBuffers(const std::shared_ptr<MemoryTracker>& tracker, AVFrame* frame, const char* location) {
+    if (!tracker || !frame || frame->hw_frames_ctx) {
+        return 0;
+    }
+
+    int tracked = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+        if (frame->buf[i] && trackBuffer(tracker, &frame->buf[i], location)) {
+            ++tracked;
+        }
+    }
+    for (int i = 0; i < frame->nb_extended_buf; ++i) {
+        if (trackBuffer(tracker, &frame->extended_buf[i], location)) {
+            ++tracked;
+        }
+    }
+    return tracked;
+}
+
+bool trackPacketBuffer(const std::shared_ptr<MemoryTracker>& tracker, AVPacket* packet, const char* location) {
+    return packet && packet->buf && trackBuffer(tracker, &packet->buf, location);
+}
+
+void installDecoderTracking(AVCodecContext* codec_ctx, const std::shared_ptr<MemoryTracker>* tracker) {
+    if (!codec_ctx || !tracker || !*tracker) {
+        return;
+    }
+    codec_ctx->opaque = const_cast<std::shared_ptr<MemoryTracker>*>(tracker);
+    codec_ctx->get_buffer2 = trackedGetBuffer2;
+}
+
+} // namespace media
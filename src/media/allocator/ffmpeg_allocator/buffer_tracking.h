@@ -0,0 +1,51 @@
+// buffer_tracking.h - 把FFmpeg缓冲区的生命周期写入MemoryTracker（分配轨迹的真实数据来源）
+#ifndef BUFFER_TRACKING_H
+#define BUFFER_TRACKING_H
+
+#include <memory>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+class MemoryTracker;
+
+namespace media {
+
+/**
+ * @brief 用带跟踪的包装替换一个AVBufferRef
+ *
+ * 包装与原缓冲区共享数据指针，创建时记录一次分配（观察到的对齐取地址最低位，上限64），
+ * 最后一个引用释放时记录释放并释放原引用。只读的原缓冲区包装后仍是只读。
+ * @param tracker 跟踪器，由包装持有到释放
+ * @param buf 要替换的引用，失败时保持不变
+ * @param location 写入热点统计的位置标签
+ * @return 包装成功返回true
+ */
+bool trackBuffer(const std::shared_ptr<MemoryTracker>& tracker, AVBufferRef** buf, const char* location);
+
+/**
+ * @brief 包装帧的全部缓冲区（buf[]和extended_buf[]），硬件帧跳过
+ * @return 包装的缓冲区个数
+ */
+int trackFrameBuffers(const std::shared_ptr<MemoryTracker>& tracker, AVFrame* frame, const char* location);
+
+/**
+ * @brief 包装数据包的缓冲区（非引用计数的包跳过）
+ */
+bool trackPacketBuffer(const std::shared_ptr<MemoryTracker>& tracker, AVPacket* packet, const char* location);
+
+/**
+ * @brief 给解码器装上带跟踪的get_buffer2（avcodec_open2之前调用）
+ *
+ * 分配仍由avcodec_default_get_buffer2完成（含解码器自己的缓冲池），记录的是解码器对帧缓冲的真实需求：
+ * 从池里取出算一次分配，帧的最后一个引用释放算一次释放。
+ * @param tracker 必须在解码器上下文的整个生命周期内有效（通过opaque传给回调）
+ */
+void installDecoderTracking(AVCodecContext* codec_ctx, const std::shared_ptr<MemoryTracker>* tracker);
+
+} // namespace media
+
+#endif // BUFFER_TRACKING_H
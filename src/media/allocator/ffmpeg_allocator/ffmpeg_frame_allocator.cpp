@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <iterator>
 
 namespace media {
 
@@ -293,6 +294,97 @@ bool FFmpegFrameAllocator::deallocateNativeFrame(AVFrame*& frame) {
     return false;
 }
 
+std::shared_ptr<AVFrame> FFmpegFrameAllocator::allocateSharedFrame(const FrameSpec& spec) {
+    if (shutdown_.load() || !isValidFormat(specToPixelFormat(spec))) {
+        return nullptr;
+    }
+
+    // 帧常比分配器活得久（截图请求、场景图纹理），删除器不能持有裸this
+    std::weak_ptr<FFmpegFrameAllocator> self = weak_from_this();
+    if (self.expired()) {
+        return nullptr;
+    }
+
+    bool from_pool = false;
+    AVFrame* av_frame = nullptr;
+
+    if (config_.enable_pooling) {
+        auto pool = getOrCreatePool(spec);
+        if (pool) {
+            av_frame = pool->acquire();
+            if (av_frame) {
+                from_pool = true;
+                pool_hits_.fetch_add(1);
+            } else {
+                pool_misses_.fetch_add(1);
+            }
+        }
+    }
+
+    if (!av_frame) {
+        av_frame = allocateNativeFrame(spec);
+        if (!av_frame) {
+            return nullptr;
+        }
+    }
+
+    size_t frame_size = calculateFrameSize(spec);
+    updateStatistics(from_pool, frame_size, true);
+    checkMemoryPressure();
+
+    // 最后一个引用释放时归还到池中；分配器已销毁时直接释放
+    return std::shared_ptr<AVFrame>(av_frame, [self, spec, frame_size](AVFrame* frame) {
+        auto allocator = self.lock();
+        if (!allocator) {
+            freeNativeFrame(frame);
+            return;
+        }
+
+        bool returned_to_pool = false;
+        if (allocator->config_.enable_pooling && !allocator->shutdown_.load()) {
+            auto pool = allocator->getOrCreatePool(spec);
+            if (pool) {
+                // 下一个使用者不应看到上一帧的时间戳和附加数据
+                resetFrameProperties(frame);
+                returned_to_pool = pool->release(frame);
+            }
+        }
+
+        if (!returned_to_pool) {
+            freeNativeFrame(frame);
+        }
+        allocator->updateStatistics(returned_to_pool, frame_size, false);
+    });
+}
+
+void FFmpegFrameAllocator::freeNativeFrame(AVFrame* frame) {
+    if (frame->data[0]) {
+        av_freep(&frame->data[0]);
+    }
+    av_frame_free(&frame);
+}
+
+void FFmpegFrameAllocator::resetFrameProperties(AVFrame* frame) {
+    // 图像缓冲区由av_image_alloc分配，不在buf[]中，av_frame_unref会清空data[]而不释放，
+    // 先保存缓冲区和布局，清除其余属性后再恢复
+    uint8_t* data[AV_NUM_DATA_POINTERS];
+    int linesize[AV_NUM_DATA_POINTERS];
+    std::copy(std::begin(frame->data), std::end(frame->data), data);
+    std::copy(std::begin(frame->linesize), std::end(frame->linesize), linesize);
+    const int width = frame->width;
+    const int height = frame->height;
+    const int format = frame->format;
+
+    av_frame_unref(frame);
+
+    std::copy(std::begin(data), std::end(data), frame->data);
+    std::copy(std::begin(linesize), std::end(linesize), frame->linesize);
+    frame->extended_data = frame->data;
+    frame->width = width;
+    frame->height = height;
+    frame->format = format;
+}
+
 AVPixelFormat FFmpegFrameAllocator::specToPixelFormat(const FrameSpec& spec) {
     return static_cast<AVPixelFormat>(spec.pixel_format);
 }
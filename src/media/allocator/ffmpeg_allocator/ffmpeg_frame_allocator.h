@@ -8,6 +8,7 @@
 #include <shared_mutex>
 #include <atomic>
 #include <chrono>
+#include <memory>
 
 // FFmpeg头文件 - 只在FFmpeg实现中包含
 extern "C" {
@@ -40,7 +41,8 @@ struct FFmpegAllocatorConfig : public AllocatorConfig {
 /**
  * @brief FFmpeg帧分配器实现
  */
-class FFmpegFrameAllocator : public IFrameAllocator {
+class FFmpegFrameAllocator : public IFrameAllocator,
+                             public std::enable_shared_from_this<FFmpegFrameAllocator> {
 public:
     explicit FFmpegFrameAllocator(std::unique_ptr<AllocatorConfig> config = nullptr);
     ~FFmpegFrameAllocator() override;
@@ -77,6 +79,16 @@ public:
      */
     bool deallocateNativeFrame(AVFrame*& frame);
 
+    /**
+     * @brief 分配引用计数的池化帧（零拷贝共享）
+     *
+     * 最后一个引用释放时帧自动归还到池中，适合在解码、渲染线程之间传递。
+     * 帧只持有分配器的weak_ptr：分配器先销毁时，剩余的帧释放时直接free。
+     * @param spec 帧规格
+     * @return 共享帧，失败或分配器不由shared_ptr持有时返回nullptr
+     */
+    std::shared_ptr<AVFrame> allocateSharedFrame(const FrameSpec& spec);
+
     /**
      * @brief 将FrameSpec转换为FFmpeg像素格式
      * @param spec 帧规格
@@ -151,6 +163,16 @@ private:
     void updateStatistics(bool from_pool, size_t frame_size, bool is_allocation);
     void checkMemoryPressure();
     void performScheduledCleanup();
+
+    /**
+     * @brief 归还到池前清除帧属性（pts、side data、metadata等），保留图像缓冲区
+     */
+    static void resetFrameProperties(AVFrame* frame);
+
+    /**
+     * @brief 释放不归还池的帧（图像缓冲区和AVFrame）
+     */
+    static void freeNativeFrame(AVFrame* frame);
     
     // 格式支持检查
     bool isValidFormat(AVPixelFormat format) const;
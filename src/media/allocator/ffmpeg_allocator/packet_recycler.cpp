@@ -7,14 +7,17 @@
 // 条件包含FFmpeg头文件
 #ifdef FFMPEG_AVAILABLE
 extern "C" {
+#include <libavcodec/avcodec.h>     // AV_INPUT_BUFFER_PADDING_SIZE
 #include <libavcodec/packet.h>
+#include <libavutil/buffer.h>
 #include <libavutil/mem.h>
 }
 #endif
 
 // RefCountedPacket 实现
-PacketRecycler::RefCountedPacket::RefCountedPacket(AVPacket* packet, PacketRecycler* recycler)
-    : packet_(packet), recycler_(recycler), ref_count_(1) {
+PacketRecycler::RefCountedPacket::RefCountedPacket(AVPacket* packet, PacketRecycler* recycler,
+                                                   SizeCategory category)
+    : packet_(packet), recycler_(recycler), category_(category), ref_count_(1) {
 }
 
 PacketRecycler::RefCountedPacket::~RefCountedPacket() {
@@ -22,7 +25,8 @@ PacketRecycler::RefCountedPacket::~RefCountedPacket() {
 }
 
 PacketRecycler::RefCountedPacket::RefCountedPacket(RefCountedPacket&& other) noexcept
-    : packet_(other.packet_), recycler_(other.recycler_), ref_count_(other.ref_count_.load()) {
+    : packet_(other.packet_), recycler_(other.recycler_), category_(other.category_)
+    , ref_count_(other.ref_count_.load()) {
     other.packet_ = nullptr;
     other.recycler_ = nullptr;
     other.ref_count_.store(0);
@@ -33,6 +37,7 @@ PacketRecycler::RefCountedPacket& PacketRecycler::RefCountedPacket::operator=(Re
         release();
         packet_ = other.packet_;
         recycler_ = other.recycler_;
+        category_ = other.category_;
         ref_count_.store(other.ref_count_.load());
         other.packet_ = nullptr;
         other.recycler_ = nullptr;
@@ -58,10 +63,7 @@ void PacketRecycler::RefCountedPacket::release() {
     if (packet_ && ref_count_.fetch_sub(1) == 1) {
         // 最后一个引用，回收packet
         if (recycler_) {
-#ifdef FFMPEG_AVAILABLE
-            SizeCategory category = recycler_->categorizeSize(packet_->size);
-            recycler_->recyclePacket(packet_, category);
-#endif
+            recycler_->recyclePacket(packet_, category_);
         }
         packet_ = nullptr;
         recycler_ = nullptr;
@@ -100,11 +102,7 @@ bool PacketRecycler::PacketPool::release(AVPacket* packet) {
 
     std::lock_guard<std::mutex> lock(mutex_);
 
-    if (available_packets_.size() < capacity_) {
-#ifdef FFMPEG_AVAILABLE
-        // 重置packet但保留缓冲区
-        av_packet_unref(packet);
-#endif
+    if (available_packets_.size() < capacity_ && resetPacket(packet)) {
         available_packets_.push_back(packet);
         return true;
     }
@@ -148,10 +146,7 @@ size_t PacketRecycler::PacketPool::releaseBatch(const std::vector<AVPacket*>& pa
     for (AVPacket* packet : packets) {
         if (!packet) continue;
 
-        if (available_packets_.size() < capacity_) {
-#ifdef FFMPEG_AVAILABLE
-            av_packet_unref(packet);
-#endif
+        if (available_packets_.size() < capacity_ && resetPacket(packet)) {
             available_packets_.push_back(packet);
             ++released;
         } else {
@@ -206,6 +201,30 @@ bool PacketRecycler::PacketPool::allocateBuffer(AVPacket* packet, size_t size) {
 #endif
 }
 
+bool PacketRecycler::PacketPool::resetPacket(AVPacket* packet) {
+#ifdef FFMPEG_AVAILABLE
+    // av_packet_unref会释放缓冲区，先摘下来，清掉属性和side data后再挂回去
+    AVBufferRef* buf = packet->buf;
+    packet->buf = nullptr;
+    av_packet_unref(packet);
+
+    if (buf && av_buffer_is_writable(buf) &&
+        static_cast<size_t>(buf->size) >= target_size_ + AV_INPUT_BUFFER_PADDING_SIZE) {
+        packet->buf = buf;
+        packet->data = buf->data;
+        packet->size = static_cast<int>(target_size_);
+        return true;
+    }
+
+    // 缓冲区被别处引用或太小，换一块新的
+    av_buffer_unref(&buf);
+    return allocateBuffer(packet, target_size_);
+#else
+    (void)packet;
+    return false;
+#endif
+}
+
 size_t PacketRecycler::PacketPool::getMemoryUsage() const {
     return total_allocated_.load() * target_size_;
 }
@@ -252,11 +271,15 @@ PacketRecycler::PacketPtr PacketRecycler::allocatePacket(size_t size) {
         if (packet) {
             updateStatistics(category, size, true, true);
             stats_.pool_hits.fetch_add(1);
+#ifdef FFMPEG_AVAILABLE
+            // 池里的缓冲区不小于target_size，对外与av_new_packet一致只暴露请求的大小
+            packet->size = static_cast<int>(size);
+#endif
 
             if (config_.enable_reference_counting) {
-                return std::make_unique<RefCountedPacket>(packet, this);
+                return std::make_unique<RefCountedPacket>(packet, this, category);
             } else {
-                return std::make_unique<RefCountedPacket>(packet, nullptr);
+                return std::make_unique<RefCountedPacket>(packet, nullptr, category);
             }
         }
     }
@@ -270,9 +293,9 @@ PacketRecycler::PacketPtr PacketRecycler::allocatePacket(size_t size) {
         updateStatistics(category, size, true, false);
 
         if (config_.enable_reference_counting) {
-            return std::make_unique<RefCountedPacket>(packet, this);
+            return std::make_unique<RefCountedPacket>(packet, this, category);
         } else {
-            return std::make_unique<RefCountedPacket>(packet, nullptr);
+            return std::make_unique<RefCountedPacket>(packet, nullptr, category);
         }
     }
 
@@ -319,10 +342,13 @@ std::vector<PacketRecycler::PacketPtr> PacketRecycler::allocatePacketBatch(const
                 if (packets[i]) {
                     updateStatistics(category, group_sizes[i], true, true);
 
+#ifdef FFMPEG_AVAILABLE
+                    packets[i]->size = static_cast<int>(group_sizes[i]);
+#endif
                     if (config_.enable_reference_counting) {
-                        result.push_back(std::make_unique<RefCountedPacket>(packets[i], this));
+                        result.push_back(std::make_unique<RefCountedPacket>(packets[i], this, category));
                     } else {
-                        result.push_back(std::make_unique<RefCountedPacket>(packets[i], nullptr));
+                        result.push_back(std::make_unique<RefCountedPacket>(packets[i], nullptr, category));
                     }
                 }
             }
@@ -386,13 +412,23 @@ void PacketRecycler::recyclePacket(AVPacket* packet, SizeCategory category) {
         return;
     }
 
-    size_t target_size = getCategorySuggestedSize(category);
+    // 先记下大小：归还时会重置成池的目标大小，池满时packet会被直接销毁
+#ifdef FFMPEG_AVAILABLE
+    const size_t size = packet->size > 0 ? static_cast<size_t>(packet->size) : 0;
+#else
+    const size_t size = 0;
+#endif
+    // 与allocatePacket同样的规则找回原来的池
+    size_t target_size = std::max(size, getCategorySuggestedSize(category));
     auto pool = getOrCreatePool(category, target_size);
 
     if (pool && pool->release(packet)) {
-        updateStatistics(category, packet->size, false, true);
+        updateStatistics(category, size, false, true);
+    } else if (pool) {
+        // 池已满或缓冲区无法复用，release已经销毁了packet
+        updateStatistics(category, size, false, false);
     } else {
-        updateStatistics(category, packet->size, false, false);
+        updateStatistics(category, size, false, false);
 #ifdef FFMPEG_AVAILABLE
         av_packet_free(&packet);
 #endif
@@ -483,12 +519,12 @@ std::string PacketRecycler::getMemoryReport() const {
     std::ostringstream oss;
 
     oss << "=== Packet Recycler Report ===\n";
-    oss << "Total Allocated: " << stats.total_allocated.load() << "\n";
-    oss << "Total Recycled: " << stats.total_recycled.load() << "\n";
+    oss << "Total Allocated: " << stats.total_allocated << "\n";
+    oss << "Total Recycled: " << stats.total_recycled << "\n";
     oss << "Recycling Rate: " << (stats.getRecyclingRate() * 100) << "%\n";
     oss << "Pool Hit Rate: " << (stats.getPoolHitRate() * 100) << "%\n";
-    oss << "Current Memory: " << stats.current_memory_usage.load() << " bytes\n";
-    oss << "Peak Memory: " << stats.peak_memory_usage.load() << " bytes\n";
+    oss << "Current Memory: " << stats.current_memory_usage << " bytes\n";
+    oss << "Peak Memory: " << stats.peak_memory_usage << " bytes\n";
 
     return oss.str();
 }
@@ -69,16 +69,23 @@ public:
      * @brief 统计信息快照
      */
     struct StatisticsSnapshot {
-        size_t total_created;      // 总创建数量
-        size_t total_acquired;     // 总获取次数
-        size_t total_released;     // 总归还次数
-        size_t current_in_use;     // 当前使用中
-        size_t current_available;  // 当前可用数量
-        size_t peak_usage;         // 峰值使用量
-
-        // 计算命中率
-        double getHitRate() const {
-            return total_acquired > 0 ? static_cast<double>(total_acquired - total_created) / total_acquired : 0.0;
+        size_t total_allocated;         // 总分配次数
+        size_t total_recycled;          // 总回收次数
+        size_t current_memory_usage;    // 当前使用中的字节数
+        size_t peak_memory_usage;       // 峰值字节数
+        size_t pool_hits;               // 池命中次数
+        size_t pool_misses;             // 池未命中次数（直接向FFmpeg分配）
+        size_t category_counts[static_cast<int>(SizeCategory::CATEGORY_COUNT)];  // 各类别分配次数
+
+        // 计算回收率
+        double getRecyclingRate() const {
+            return total_allocated > 0 ? static_cast<double>(total_recycled) / total_allocated : 0.0;
+        }
+
+        // 计算池命中率
+        double getPoolHitRate() const {
+            const size_t total = pool_hits + pool_misses;
+            return total > 0 ? static_cast<double>(pool_hits) / total : 0.0;
         }
     };
 
@@ -86,23 +93,27 @@ public:
      * @brief 统计信息
      */
     struct Statistics {
-        std::atomic<size_t> total_created{0};      // 总创建数量
-        std::atomic<size_t> total_acquired{0};     // 总获取次数
-        std::atomic<size_t> total_released{0};     // 总归还次数
-        std::atomic<size_t> current_in_use{0};     // 当前使用中
-        std::atomic<size_t> current_available{0};  // 当前可用数量
-        std::atomic<size_t> peak_usage{0};         // 峰值使用量
+        std::atomic<size_t> total_allocated{0};
+        std::atomic<size_t> total_recycled{0};
+        std::atomic<size_t> current_memory_usage{0};
+        std::atomic<size_t> peak_memory_usage{0};
+        std::atomic<size_t> pool_hits{0};
+        std::atomic<size_t> pool_misses{0};
+        std::atomic<size_t> category_counts[static_cast<int>(SizeCategory::CATEGORY_COUNT)]{};
 
         // 转换为快照
         StatisticsSnapshot getSnapshot() const {
-            return StatisticsSnapshot{
-                total_created.load(),
-                total_acquired.load(),
-                total_released.load(),
-                current_in_use.load(),
-                current_available.load(),
-                peak_usage.load()
-            };
+            StatisticsSnapshot snapshot{};
+            snapshot.total_allocated = total_allocated.load();
+            snapshot.total_recycled = total_recycled.load();
+            snapshot.current_memory_usage = current_memory_usage.load();
+            snapshot.peak_memory_usage = peak_memory_usage.load();
+            snapshot.pool_hits = pool_hits.load();
+            snapshot.pool_misses = pool_misses.load();
+            for (int i = 0; i < static_cast<int>(SizeCategory::CATEGORY_COUNT); ++i) {
+                snapshot.category_counts[i] = category_counts[i].load();
+            }
+            return snapshot;
         }
     };
 
@@ -111,7 +122,11 @@ public:
      */
     class RefCountedPacket {
     public:
-        explicit RefCountedPacket(AVPacket* packet, PacketRecycler* recycler);
+        /**
+         * @param category 分配时的类别，回收时按它找回原来的池（缓冲区大小会跨越类别边界，不能按大小重新分类）
+         */
+        RefCountedPacket(AVPacket* packet, PacketRecycler* recycler,
+                         SizeCategory category = SizeCategory::TINY);
         ~RefCountedPacket();
 
         // 禁用拷贝，支持移动
@@ -135,6 +150,7 @@ public:
     private:
         AVPacket* packet_;
         PacketRecycler* recycler_;
+        SizeCategory category_;
         std::atomic<int> ref_count_;
 
         void addRef();
@@ -185,6 +201,7 @@ private:
         AVPacket* createPacket();
         void destroyPacket(AVPacket* packet);
         bool allocateBuffer(AVPacket* packet, size_t size);
+        bool resetPacket(AVPacket* packet);     // 清空属性、保留缓冲区，失败时由调用方销毁
     };
 
 public:
@@ -0,0 +1,407 @@
+#include "analytics_stage.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace media {
+
+namespace {
+
+constexpr int kStrideAlign = 32;
+
+int alignStride(int width) {
+    return (width + kStrideAlign - 1) / kStrideAlign * kStrideAlign;
+}
+
+} // namespace
+
+AnalyticsStage::AnalyticsStage(const Config& config)
+    : config_(config)
+    , analyze_metric_(MetricsRegistry::instance().latency("stage.analytics"))
+    , drop_metric_(MetricsRegistry::instance().counter("drop.analytics")) {
+    config_.analysis_width = std::max(config_.analysis_width, motion_kernels::kBlockSize * 2);
+    config_.analyze_interval = std::max(config_.analyze_interval, 1);
+    config_.queue_frames = std::max<size_t>(config_.queue_frames, 1);
+    reset();
+}
+
+AnalyticsStage::~AnalyticsStage() {
+    stop();
+}
+
+bool AnalyticsStage::start() {
+    if (running_.load()) {
+        return true;
+    }
+    reset();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        stopping_ = false;
+        busy_ = false;
+        submit_counter_ = 0;
+        last_error_.clear();
+    }
+    running_.store(true);
+    thread_ = std::thread(&AnalyticsStage::analyzeLoop, this);
+    return true;
+}
+
+void AnalyticsStage::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    not_empty_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_ = false;
+    }
+    idle_cv_.notify_all();
+}
+
+bool AnalyticsStage::admit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_submitted++;
+    if (!running_.load() || stopping_) {
+        return false;
+    }
+    if (submit_counter_++ % static_cast<uint64_t>(config_.analyze_interval) != 0) {
+        stats_.frames_skipped++;
+        return false;
+    }
+    // 分析跟不上时丢帧，不能让解码线程等待
+    if (queue_.size() >= config_.queue_frames) {
+        stats_.frames_dropped++;
+        drop_metric_.add();
+        return false;
+    }
+    return true;
+}
+
+bool AnalyticsStage::enqueue(Pending item) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        queue_.push_back(std::move(item));
+    }
+    not_empty_.notify_one();
+    return true;
+}
+
+bool AnalyticsStage::submit(const AVFrame* frame, AVRational time_base) {
+    if (!frame || !admit()) {
+        return false;
+    }
+    // 引用计数帧只增加引用；没有buf的帧会被av_frame_clone整帧拷贝
+    AVFrame* ref = av_frame_clone(frame);
+    if (!ref) {
+        return false;
+    }
+    return enqueue(Pending{ffmpeg::SharedPointerFactory::wrapFrame(ref), time_base});
+}
+
+bool AnalyticsStage::submit(ffmpeg::AVFrameSharedPtr frame, AVRational time_base) {
+    if (!frame || !admit()) {
+        return false;
+    }
+    return enqueue(Pending{std::move(frame), time_base});
+}
+
+bool AnalyticsStage::waitIdle(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [this]() { return queue_.empty() && !busy_; });
+}
+
+std::string AnalyticsStage::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void AnalyticsStage::reset() {
+    has_previous_ = false;
+    motion_frames_ = 0;
+    still_frames_ = 0;
+    in_motion_ = false;
+    frames_since_scene_ = config_.min_scene_frames;
+}
+
+bool AnalyticsStage::isSupportedFormat(const AVFrame* frame) {
+    if (!frame || frame->hw_frames_ctx || !frame->data[0] || frame->linesize[0] <= 0 ||
+        frame->width < motion_kernels::kBlockSize || frame->height < motion_kernels::kBlockSize) {
+        return false;
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_RGB |
+                                 AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        return false;
+    }
+    // 亮度在第0平面、8位、逐字节排列（排除YUYV这类打包格式）
+    return desc->comp[0].plane == 0 && desc->comp[0].depth == 8 && desc->comp[0].step == 1 &&
+           desc->comp[0].offset == 0;
+}
+
+void AnalyticsStage::analyzeLoop() {
+    for (;;) {
+        Pending item;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                break;
+            }
+            item = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+
+        FrameAnalysis result;
+        analyze(item.frame.get(), item.time_base, &result);
+        // 尽早归还解码器的帧池
+        item.frame.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        idle_cv_.notify_all();
+    }
+}
+
+bool AnalyticsStage::analyze(const AVFrame* frame, AVRational time_base, FrameAnalysis* result) {
+    if (!isSupportedFormat(frame)) {
+        stats_.frames_unsupported++;
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "不支持的帧格式（需要软件帧、8位平面亮度）";
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    FrameAnalysis analysis;
+    {
+        ScopedLatency timing(analyze_metric_);
+        int width = 0;
+        int height = 0;
+        if (!prepareLuma(frame, &width, &height)) {
+            return false;
+        }
+        const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp
+                                                                          : frame->pts;
+        if (pts != AV_NOPTS_VALUE && time_base.num > 0 && time_base.den > 0) {
+            analysis.timestamp_us = av_rescale_q(pts, time_base, AV_TIME_BASE_Q);
+        }
+        analysis.analysis_width = width;
+        analysis.analysis_height = height;
+        detect(analysis);
+    }
+    const int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    stats_.analyze_us_total += static_cast<uint64_t>(elapsed_us);
+    stats_.frames_analyzed++;
+
+    if (frame_callback_) {
+        frame_callback_(analysis);
+    }
+    if (result) {
+        *result = analysis;
+    }
+    return true;
+}
+
+bool AnalyticsStage::prepareLuma(const AVFrame* frame, int* width, int* height) {
+    int w = frame->width;
+    int h = frame->height;
+
+    // 逐级2x2缩小到analysis_width以内，并保证至少还有一行块
+    int shift = 0;
+    while ((w >> shift) > config_.analysis_width && (h >> (shift + 1)) >= motion_kernels::kBlockSize) {
+        ++shift;
+    }
+    scale_shift_ = shift;
+
+    const int out_w = w >> shift;
+    const int out_h = h >> shift;
+    const int out_stride = alignStride(out_w);
+    std::vector<uint8_t>& target = planes_[current_];
+    target.resize(static_cast<size_t>(out_stride) * out_h);
+
+    const uint8_t* in = frame->data[0];
+    int in_stride = frame->linesize[0];
+    if (shift == 0) {
+        for (int y = 0; y < out_h; ++y) {
+            COPY_MEMCPY("analytics.luma", target.data() + static_cast<size_t>(y) * out_stride,
+                        in + static_cast<size_t>(y) * in_stride, static_cast<size_t>(out_w));
+        }
+    } else {
+        // 中间级在scratch_的两半之间交替，最后一级直接写进目标平面
+        const size_t half = static_cast<size_t>(alignStride(w / 2)) * (h / 2);
+        if (shift > 1) {
+            scratch_.resize(half * 2);
+        }
+        for (int level = 1; level <= shift; ++level) {
+            const int level_stride = alignStride(w / 2);
+            uint8_t* out = level == shift ? target.data() : scratch_.data() + (level % 2) * half;
+            motion_kernels::downscale2x(in, in_stride, w, h, out, level_stride);
+            in = out;
+            in_stride = level_stride;
+            w /= 2;
+            h /= 2;
+        }
+    }
+
+    // 分辨率变化时上一帧不可比
+    const int previous = current_ ^ 1;
+    if (plane_width_[previous] != out_w || plane_height_[previous] != out_h) {
+        has_previous_ = false;
+    }
+    plane_width_[current_] = out_w;
+    plane_height_[current_] = out_h;
+    plane_stride_[current_] = out_stride;
+    *width = out_w;
+    *height = out_h;
+    return true;
+}
+
+void AnalyticsStage::detect(FrameAnalysis& result) {
+    const int cur = current_;
+    const int prev = current_ ^ 1;
+    const int width = plane_width_[cur];
+    const int height = plane_height_[cur];
+    const uint8_t* plane = planes_[cur].data();
+    const int stride = plane_stride_[cur];
+
+    // 亮度统计由直方图得出，不再单独遍历
+    uint32_t* hist = histograms_[cur];
+    motion_kernels::histogram(plane, stride, width, height, hist);
+    const double pixels = static_cast<double>(width) * height;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (int i = 0; i < motion_kernels::kHistogramBins; ++i) {
+        sum += static_cast<double>(i) * hist[i];
+        sum_sq += static_cast<double>(i) * i * hist[i];
+    }
+    result.mean_luma = sum / pixels;
+    result.luma_stddev = std::sqrt(std::max(0.0, sum_sq / pixels - result.mean_luma * result.mean_luma));
+
+    const int blocks_x = width / motion_kernels::kBlockSize;
+    const int blocks_y = height / motion_kernels::kBlockSize;
+    const int blocks = blocks_x * blocks_y;
+    const bool comparable = has_previous_ && blocks > 0;
+    int moving = 0;
+    if (comparable) {
+        sad_.resize(static_cast<size_t>(blocks));
+        motion_kernels::blockSad16(plane, stride, planes_[prev].data(), plane_stride_[prev],
+                                   width, height, sad_.data());
+        const double block_pixels = motion_kernels::kBlockSize * motion_kernels::kBlockSize;
+        const uint32_t threshold = static_cast<uint32_t>(config_.block_threshold * block_pixels);
+        uint64_t total = 0;
+        int left = blocks_x;
+        int top = blocks_y;
+        int right = -1;
+        int bottom = -1;
+        for (int by = 0; by < blocks_y; ++by) {
+            for (int bx = 0; bx < blocks_x; ++bx) {
+                const uint32_t sad = sad_[by * blocks_x + bx];
+                total += sad;
+                if (sad > threshold) {
+                    ++moving;
+                    left = std::min(left, bx);
+                    top = std::min(top, by);
+                    right = std::max(right, bx);
+                    bottom = std::max(bottom, by);
+                }
+            }
+        }
+        result.mean_sad = static_cast<double>(total) / (blocks * block_pixels);
+        result.motion_ratio = static_cast<double>(moving) / blocks;
+        if (moving > 0) {
+            motion_left_ = left;
+            motion_top_ = top;
+            motion_right_ = right;
+            motion_bottom_ = bottom;
+        }
+
+        // 归一化的直方图L1距离：0为分布相同，1为完全不重叠
+        const uint32_t* previous_hist = histograms_[prev];
+        uint64_t diff = 0;
+        for (int i = 0; i < motion_kernels::kHistogramBins; ++i) {
+            diff += hist[i] > previous_hist[i] ? hist[i] - previous_hist[i] : previous_hist[i] - hist[i];
+        }
+        result.scene_score = 0.5 * static_cast<double>(diff) / pixels;
+    }
+
+    // 场景切换
+    ++frames_since_scene_;
+    if (comparable && result.scene_score >= config_.scene_threshold &&
+        frames_since_scene_ >= config_.min_scene_frames) {
+        result.scene_change = true;
+        frames_since_scene_ = 0;
+        stats_.scene_changes++;
+        AnalyticsEvent event;
+        event.type = AnalyticsEvent::Type::SceneChange;
+        event.timestamp_us = result.timestamp_us;
+        event.score = result.scene_score;
+        emitEvent(event);
+    }
+
+    // 运动：切换帧整幅画面都在变，不计入
+    if (comparable && !result.scene_change) {
+        if (moving > 0 && result.motion_ratio >= config_.motion_area) {
+            ++motion_frames_;
+            still_frames_ = 0;
+            if (!in_motion_ && motion_frames_ >= config_.motion_trigger_frames) {
+                in_motion_ = true;
+                stats_.motion_events++;
+                const int block = motion_kernels::kBlockSize << scale_shift_;
+                AnalyticsEvent event;
+                event.type = AnalyticsEvent::Type::MotionStart;
+                event.timestamp_us = result.timestamp_us;
+                event.score = result.motion_ratio;
+                event.x = motion_left_ * block;
+                event.y = motion_top_ * block;
+                event.width = (motion_right_ - motion_left_ + 1) * block;
+                event.height = (motion_bottom_ - motion_top_ + 1) * block;
+                emitEvent(event);
+            }
+        } else {
+            ++still_frames_;
+            motion_frames_ = 0;
+            if (in_motion_ && still_frames_ >= config_.motion_hold_frames) {
+                in_motion_ = false;
+                AnalyticsEvent event;
+                event.type = AnalyticsEvent::Type::MotionEnd;
+                event.timestamp_us = result.timestamp_us;
+                event.score = result.motion_ratio;
+                emitEvent(event);
+            }
+        }
+    }
+    result.in_motion = in_motion_;
+
+    has_previous_ = true;
+    current_ = prev;
+}
+
+void AnalyticsStage::emitEvent(const AnalyticsEvent& event) {
+    if (event_callback_) {
+        event_callback_(event);
+    }
+}
+
+} // namespace media
@@ -0,0 +1,261 @@
+#ifndef ANALYTICS_STAGE_H
+#define ANALYTICS_STAGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "motion_kernels.h"
+#include "../../memory/smart_pointers.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/rational.h>
+}
+
+namespace media {
+
+/**
+ * @brief 单帧分析结果
+ */
+struct FrameAnalysis {
+    int64_t timestamp_us = AV_NOPTS_VALUE;  // 帧显示时间（微秒）
+    int analysis_width = 0;                 // 缩小后的分析尺寸
+    int analysis_height = 0;
+    double mean_luma = 0.0;
+    double luma_stddev = 0.0;
+    double mean_sad = 0.0;                  // 与上一分析帧的平均逐像素绝对差
+    double motion_ratio = 0.0;              // 超过阈值的块占比
+    double scene_score = 0.0;               // 直方图差异（0~1）
+    bool scene_change = false;
+    bool in_motion = false;                 // 处理本帧之后的运动状态
+};
+
+/**
+ * @brief 分析事件
+ */
+struct AnalyticsEvent {
+    enum class Type {
+        SceneChange,
+        MotionStart,
+        MotionEnd
+    };
+
+    Type type = Type::SceneChange;
+    int64_t timestamp_us = AV_NOPTS_VALUE;
+    double score = 0.0;                     // 场景切换为scene_score，运动为motion_ratio
+    int x = 0;                              // 运动区域（原始帧坐标，MotionStart有效）
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * @brief 管道内的画面分析阶段：场景切换与运动检测
+ *
+ * 设计特点：
+ * 1. 不拷贝帧：提交的是解码帧的引用，分析线程只读亮度平面
+ * 2. 先缩小再分析：亮度平面按2x2逐级缩小到analysis_width以内，
+ *    分块SAD、直方图和亮度统计都在小图上做，成本与原始分辨率基本无关
+ * 3. SIMD：缩小和块SAD使用AVX2内核（运行时检测，无AVX2时走标量实现）
+ * 4. 不拖慢播放：队列满时直接丢帧（计入统计），analyze_interval可以隔帧分析
+ * 5. 事件去抖：运动需要连续motion_trigger_frames帧超过阈值才开始，
+ *    连续motion_hold_frames帧低于阈值才结束；场景切换帧不计入运动
+ *
+ * submit可在任意一个线程（通常是视频解码线程）调用；回调在分析线程中调用。
+ */
+class AnalyticsStage {
+public:
+    /**
+     * @brief 分析配置
+     */
+    struct Config {
+        int analysis_width;                 // 缩小后的最大宽度
+        int analyze_interval;               // 每N个提交帧分析一帧
+        size_t queue_frames;                // 待分析帧队列长度，满时丢帧
+        double block_threshold;             // 块内平均逐像素差超过此值视为运动块
+        double motion_area;                 // 运动块占比超过此值视为有运动
+        int motion_trigger_frames;          // 连续多少帧有运动才发出MotionStart
+        int motion_hold_frames;             // 连续多少帧无运动才发出MotionEnd
+        double scene_threshold;             // 直方图差异超过此值视为场景切换
+        int min_scene_frames;               // 两次场景切换之间至少间隔的分析帧数
+
+        Config()
+            : analysis_width(320)
+            , analyze_interval(1)
+            , queue_frames(4)
+            , block_threshold(10.0)
+            , motion_area(0.01)
+            , motion_trigger_frames(2)
+            , motion_hold_frames(15)
+            , scene_threshold(0.4)
+            , min_scene_frames(10)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t frames_submitted;
+        uint64_t frames_analyzed;
+        uint64_t frames_skipped;        // 按analyze_interval跳过
+        uint64_t frames_dropped;        // 队列满丢弃
+        uint64_t frames_unsupported;    // 硬件帧或非8位平面亮度
+        uint64_t scene_changes;
+        uint64_t motion_events;         // MotionStart次数
+        double average_analyze_us;      // 每帧分析耗时
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> frames_submitted{0};
+        std::atomic<uint64_t> frames_analyzed{0};
+        std::atomic<uint64_t> frames_skipped{0};
+        std::atomic<uint64_t> frames_dropped{0};
+        std::atomic<uint64_t> frames_unsupported{0};
+        std::atomic<uint64_t> scene_changes{0};
+        std::atomic<uint64_t> motion_events{0};
+        std::atomic<uint64_t> analyze_us_total{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            const uint64_t analyzed = frames_analyzed.load();
+            return StatisticsSnapshot{
+                frames_submitted.load(),
+                analyzed,
+                frames_skipped.load(),
+                frames_dropped.load(),
+                frames_unsupported.load(),
+                scene_changes.load(),
+                motion_events.load(),
+                analyzed > 0 ? static_cast<double>(analyze_us_total.load()) / analyzed : 0.0
+            };
+        }
+    };
+
+    using EventCallback = std::function<void(const AnalyticsEvent&)>;
+    using FrameCallback = std::function<void(const FrameAnalysis&)>;
+
+public:
+    explicit AnalyticsStage(const Config& config = Config{});
+    ~AnalyticsStage();
+
+    AnalyticsStage(const AnalyticsStage&) = delete;
+    AnalyticsStage& operator=(const AnalyticsStage&) = delete;
+
+    /**
+     * @brief 启动分析线程（回调需在此之前设置）
+     */
+    bool start();
+
+    /**
+     * @brief 放弃队列中的帧并停止分析线程
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(); }
+
+    /**
+     * @brief 提交一帧（增加引用，不拷贝像素）
+     * @param time_base 帧pts的时间基
+     * @return 未运行、被跳过或队列满丢弃时返回false
+     */
+    bool submit(const AVFrame* frame, AVRational time_base);
+    bool submit(ffmpeg::AVFrameSharedPtr frame, AVRational time_base);
+
+    /**
+     * @brief 等待队列中的帧分析完
+     */
+    bool waitIdle(int timeout_ms);
+
+    /**
+     * @brief 同步分析一帧（不经过队列；不能与运行中的分析线程并用）
+     */
+    bool analyze(const AVFrame* frame, AVRational time_base, FrameAnalysis* result);
+
+    /**
+     * @brief 清除上一帧和运动状态（换源或seek之后调用）
+     */
+    void reset();
+
+    void setEventCallback(EventCallback callback) { event_callback_ = std::move(callback); }
+    void setFrameCallback(FrameCallback callback) { frame_callback_ = std::move(callback); }
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+    /**
+     * @brief 帧能否分析：软件帧且亮度是8位独立平面
+     */
+    static bool isSupportedFormat(const AVFrame* frame);
+
+private:
+    struct Pending {
+        ffmpeg::AVFrameSharedPtr frame;
+        AVRational time_base;
+    };
+
+    bool admit();
+    bool enqueue(Pending item);
+    void analyzeLoop();
+    bool prepareLuma(const AVFrame* frame, int* width, int* height);
+    void detect(FrameAnalysis& result);
+    void emitEvent(const AnalyticsEvent& event);
+
+private:
+    Config config_;
+
+    // 分析线程独占
+    std::vector<uint8_t> planes_[2];        // 当前/上一帧的缩小亮度，交替使用
+    std::vector<uint8_t> scratch_;          // 逐级缩小的中间结果
+    std::vector<uint32_t> sad_;
+    uint32_t histograms_[2][motion_kernels::kHistogramBins];
+    int current_ = 0;
+    int plane_width_[2] = {0, 0};
+    int plane_height_[2] = {0, 0};
+    int plane_stride_[2] = {0, 0};
+    bool has_previous_ = false;
+    int motion_frames_ = 0;                 // 连续有运动的帧数
+    int still_frames_ = 0;                  // 连续无运动的帧数
+    bool in_motion_ = false;
+    int frames_since_scene_ = 0;
+    int scale_shift_ = 0;                   // 缩小级数（坐标换算回原图）
+    int motion_left_ = 0;                   // 最近一帧运动块的包围盒（块坐标）
+    int motion_top_ = 0;
+    int motion_right_ = 0;
+    int motion_bottom_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable idle_cv_;
+    std::deque<Pending> queue_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    uint64_t submit_counter_ = 0;
+    std::string last_error_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    EventCallback event_callback_;
+    FrameCallback frame_callback_;
+
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& analyze_metric_;
+    Metric& drop_metric_;
+};
+
+} // namespace media
+
+#endif // ANALYTICS_STAGE_H
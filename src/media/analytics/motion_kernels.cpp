@@ -0,0 +1,213 @@
+#include "motion_kernels.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MEDIA_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace media {
+namespace motion_kernels {
+
+namespace {
+
+std::atomic<bool> g_force_scalar{false};
+
+// ==================== 标量实现 ====================
+
+void downscale2xScalar(const uint8_t* src, int src_stride, int width, int height,
+                       uint8_t* dst, int dst_stride, int first_x) {
+    const int out_w = width / 2;
+    const int out_h = height / 2;
+    for (int y = 0; y < out_h; ++y) {
+        const uint8_t* r0 = src + static_cast<size_t>(2 * y) * src_stride;
+        const uint8_t* r1 = r0 + src_stride;
+        uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+        for (int x = first_x; x < out_w; ++x) {
+            const int sum = r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1];
+            out[x] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+uint32_t sad16x16Scalar(const uint8_t* cur, int cur_stride, const uint8_t* prev, int prev_stride) {
+    uint32_t sad = 0;
+    for (int y = 0; y < kBlockSize; ++y) {
+        const uint8_t* a = cur + static_cast<size_t>(y) * cur_stride;
+        const uint8_t* b = prev + static_cast<size_t>(y) * prev_stride;
+        for (int x = 0; x < kBlockSize; ++x) {
+            sad += static_cast<uint32_t>(std::abs(a[x] - b[x]));
+        }
+    }
+    return sad;
+}
+
+void blockSad16Scalar(const uint8_t* cur, int cur_stride, const uint8_t* prev, int prev_stride,
+                      int width, int height, uint32_t* out) {
+    const int blocks_x = width / kBlockSize;
+    const int blocks_y = height / kBlockSize;
+    for (int by = 0; by < blocks_y; ++by) {
+        const uint8_t* a = cur + static_cast<size_t>(by * kBlockSize) * cur_stride;
+        const uint8_t* b = prev + static_cast<size_t>(by * kBlockSize) * prev_stride;
+        for (int bx = 0; bx < blocks_x; ++bx) {
+            out[by * blocks_x + bx] = sad16x16Scalar(a + bx * kBlockSize, cur_stride,
+                                                     b + bx * kBlockSize, prev_stride);
+        }
+    }
+}
+
+// ==================== AVX2实现 ====================
+
+#ifdef MEDIA_KERNELS_AVX2
+
+__attribute__((target("avx2")))
+void downscale2xAvx2(const uint8_t* src, int src_stride, int width, int height,
+                     uint8_t* dst, int dst_stride) {
+    const int out_w = width / 2;
+    const int out_h = height / 2;
+    const int vector_w = out_w / 32 * 32;
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i round = _mm256_set1_epi16(2);
+
+    for (int y = 0; y < out_h; ++y) {
+        const uint8_t* r0 = src + static_cast<size_t>(2 * y) * src_stride;
+        const uint8_t* r1 = r0 + src_stride;
+        uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+        for (int x = 0; x < vector_w; x += 32) {
+            // 每次64个输入像素 -> 32个输出：maddubs把相邻两个像素加成16位，再加上下一行
+            const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * x));
+            const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * x + 32));
+            const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * x));
+            const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * x + 32));
+            __m256i s0 = _mm256_add_epi16(_mm256_maddubs_epi16(a0, ones), _mm256_maddubs_epi16(b0, ones));
+            __m256i s1 = _mm256_add_epi16(_mm256_maddubs_epi16(a1, ones), _mm256_maddubs_epi16(b1, ones));
+            s0 = _mm256_srli_epi16(_mm256_add_epi16(s0, round), 2);
+            s1 = _mm256_srli_epi16(_mm256_add_epi16(s1, round), 2);
+            // packus按128位通道交错，permute恢复顺序
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(s0, s1), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), packed);
+        }
+    }
+    if (vector_w < out_w) {
+        downscale2xScalar(src, src_stride, width, height, dst, dst_stride, vector_w);
+    }
+}
+
+__attribute__((target("avx2")))
+void blockSad16Avx2(const uint8_t* cur, int cur_stride, const uint8_t* prev, int prev_stride,
+                    int width, int height, uint32_t* out) {
+    const int blocks_x = width / kBlockSize;
+    const int blocks_y = height / kBlockSize;
+    const int pairs = blocks_x / 2;
+
+    for (int by = 0; by < blocks_y; ++by) {
+        const uint8_t* a = cur + static_cast<size_t>(by * kBlockSize) * cur_stride;
+        const uint8_t* b = prev + static_cast<size_t>(by * kBlockSize) * prev_stride;
+        uint32_t* row_out = out + by * blocks_x;
+        // 一次处理横向相邻的两个块：sad_epu8每8字节得到一个64位和，低两个属于左块，高两个属于右块
+        for (int pair = 0; pair < pairs; ++pair) {
+            const int x = pair * 2 * kBlockSize;
+            __m256i acc = _mm256_setzero_si256();
+            for (int y = 0; y < kBlockSize; ++y) {
+                const __m256i va = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(a + static_cast<size_t>(y) * cur_stride + x));
+                const __m256i vb = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(b + static_cast<size_t>(y) * prev_stride + x));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+            }
+            alignas(32) uint64_t sums[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(sums), acc);
+            row_out[2 * pair] = static_cast<uint32_t>(sums[0] + sums[1]);
+            row_out[2 * pair + 1] = static_cast<uint32_t>(sums[2] + sums[3]);
+        }
+        if (blocks_x % 2 != 0) {
+            const int x = (blocks_x - 1) * kBlockSize;
+            row_out[blocks_x - 1] = sad16x16Scalar(a + x, cur_stride, b + x, prev_stride);
+        }
+    }
+}
+
+bool cpuHasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // MEDIA_KERNELS_AVX2
+
+bool avx2Available() {
+#ifdef MEDIA_KERNELS_AVX2
+    static const bool available = cpuHasAvx2();
+    return available;
+#else
+    return false;
+#endif
+}
+
+bool useAvx2() {
+    return avx2Available() && !g_force_scalar.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+Isa activeIsa() {
+    return useAvx2() ? Isa::Avx2 : Isa::Scalar;
+}
+
+void forceScalar(bool force) {
+    g_force_scalar.store(force, std::memory_order_relaxed);
+}
+
+const char* isaName(Isa isa) {
+    return isa == Isa::Avx2 ? "AVX2" : "scalar";
+}
+
+void downscale2x(const uint8_t* src, int src_stride, int width, int height,
+                 uint8_t* dst, int dst_stride) {
+#ifdef MEDIA_KERNELS_AVX2
+    if (useAvx2()) {
+        downscale2xAvx2(src, src_stride, width, height, dst, dst_stride);
+        return;
+    }
+#endif
+    downscale2xScalar(src, src_stride, width, height, dst, dst_stride, 0);
+}
+
+void blockSad16(const uint8_t* cur, int cur_stride, const uint8_t* prev, int prev_stride,
+                int width, int height, uint32_t* out) {
+#ifdef MEDIA_KERNELS_AVX2
+    if (useAvx2()) {
+        blockSad16Avx2(cur, cur_stride, prev, prev_stride, width, height, out);
+        return;
+    }
+#endif
+    blockSad16Scalar(cur, cur_stride, prev, prev_stride, width, height, out);
+}
+
+void histogram(const uint8_t* src, int stride, int width, int height, uint32_t hist[kHistogramBins]) {
+    // 4张子表：相邻像素落在同一级时不会串行等待同一个计数器
+    uint32_t partial[4][kHistogramBins];
+    std::memset(partial, 0, sizeof(partial));
+    const int unrolled = width / 4 * 4;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = src + static_cast<size_t>(y) * stride;
+        int x = 0;
+        for (; x < unrolled; x += 4) {
+            partial[0][row[x]]++;
+            partial[1][row[x + 1]]++;
+            partial[2][row[x + 2]]++;
+            partial[3][row[x + 3]]++;
+        }
+        for (; x < width; ++x) {
+            partial[0][row[x]]++;
+        }
+    }
+    for (int i = 0; i < kHistogramBins; ++i) {
+        hist[i] = partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+    }
+}
+
+} // namespace motion_kernels
+} // namespace media
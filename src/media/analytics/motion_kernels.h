@@ -0,0 +1,63 @@
+#ifndef MOTION_KERNELS_H
+#define MOTION_KERNELS_H
+
+#include <cstdint>
+
+namespace media {
+
+/**
+ * @brief 运动分析的像素内核（亮度平面）
+ *
+ * 设计特点：
+ * 1. 运行时分派：x86上检测到AVX2时使用AVX2实现（函数级target属性，不需要全局-mavx2），否则走标量实现
+ * 2. 结果逐位一致：AVX2和标量实现的取整方式相同，forceScalar用于对比测试和基准
+ * 3. 直方图不适合向量化，用4张子表打断相邻像素的写依赖
+ */
+namespace motion_kernels {
+
+/**
+ * @brief 指令集
+ */
+enum class Isa {
+    Scalar,
+    Avx2
+};
+
+constexpr int kBlockSize = 16;      // blockSad16的块边长
+constexpr int kHistogramBins = 256;
+
+/**
+ * @brief 当前使用的指令集（CPU支持且未强制标量时为Avx2）
+ */
+Isa activeIsa();
+
+/**
+ * @brief 强制使用标量实现（测试/基准对比用，影响所有线程）
+ */
+void forceScalar(bool force);
+
+const char* isaName(Isa isa);
+
+/**
+ * @brief 2x2均值缩小（四舍五入），输出width/2 x height/2（向下取整）
+ */
+void downscale2x(const uint8_t* src, int src_stride, int width, int height,
+                 uint8_t* dst, int dst_stride);
+
+/**
+ * @brief 16x16块的绝对差之和，只计算完整的块
+ * @param out 按行优先写入 (width/16) * (height/16) 个值
+ */
+void blockSad16(const uint8_t* cur, int cur_stride, const uint8_t* prev, int prev_stride,
+                int width, int height, uint32_t* out);
+
+/**
+ * @brief 256级亮度直方图（覆盖写入hist）
+ */
+void histogram(const uint8_t* src, int stride, int width, int height, uint32_t hist[kHistogramBins]);
+
+} // namespace motion_kernels
+
+} // namespace media
+
+#endif // MOTION_KERNELS_H
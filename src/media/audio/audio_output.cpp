@@ -0,0 +1,257 @@
+#include "audio_output.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+#include <libavutil/version.h>
+}
+
+namespace media {
+
+AudioOutput::AudioOutput()
+    : underrun_metric_(MetricsRegistry::instance().counter("drop.audio_underrun")) {
+}
+
+AudioOutput::~AudioOutput() {
+    close();
+}
+
+bool AudioOutput::initialize(const Config& config) {
+    close();
+
+    if (!config.format.isValid()) {
+        last_error_ = "不支持的音频输出格式";
+        return false;
+    }
+    config_ = config;
+    config_.period_frames = std::max<size_t>(config_.period_frames, 16);
+
+    // 缓冲至少容纳两个周期，否则回调之间生产者没有写入空间
+    const size_t buffer_frames = std::max(
+        static_cast<size_t>(config_.format.sample_rate) * config_.buffer_ms / 1000,
+        config_.period_frames * 2);
+    ring_ = std::make_unique<AudioRingBuffer>(buffer_frames, config_.format.bytesPerFrame());
+
+    sink_ = AudioSinkFactory::create(config_.sink_type, config_.target);
+    bool opened = sink_ && sink_->open(config_.format, config_.period_frames, this);
+    if (!opened && config_.sink_type == AudioSinkType::Auto) {
+        // 没有可用声卡时退回Null设备，播放时钟照常推进
+        sink_ = AudioSinkFactory::create(AudioSinkType::Null);
+        opened = sink_ && sink_->open(config_.format, config_.period_frames, this);
+    }
+    if (!opened) {
+        last_error_ = sink_ ? sink_->getLastError() : "音频设备不可用";
+        sink_.reset();
+        ring_.reset();
+        return false;
+    }
+
+    flush_pending_.store(false);
+    flush_position_.store(0);
+    clock_valid_.store(false);
+    clock_origin_us_.store(0);
+    clock_scale_.store(1.0);
+    pending_clock_scale_ = 1.0;
+    rebase_pending_ = true;
+    played_position_.store(0);
+    last_callback_us_.store(0);
+    last_callback_frames_.store(0);
+    primed_.store(false);
+
+    callbacks_.store(0);
+    frames_written_.store(0);
+    frames_dropped_.store(0);
+    frames_rendered_.store(0);
+    silence_frames_.store(0);
+    underruns_.store(0);
+    min_buffered_.store(SIZE_MAX);
+    max_callback_ns_.store(0);
+    last_error_.clear();
+    return true;
+}
+
+bool AudioOutput::start() {
+    if (!sink_) {
+        last_error_ = "音频输出未初始化";
+        return false;
+    }
+    if (!sink_->start()) {
+        last_error_ = sink_->getLastError();
+        return false;
+    }
+    return true;
+}
+
+void AudioOutput::stop() {
+    if (sink_) {
+        sink_->stop();
+    }
+}
+
+void AudioOutput::close() {
+    // 先关设备（结束回调线程），再释放环形缓冲
+    if (sink_) {
+        sink_->stop();
+        sink_->close();
+        sink_.reset();
+    }
+    ring_.reset();
+}
+
+size_t AudioOutput::write(const uint8_t* data, size_t frames, int64_t pts_us) {
+    if (!ring_ || !data || frames == 0) {
+        return 0;
+    }
+
+    // flush之后第一次带pts的写入建立时钟基准：写位置0对应的pts
+    if (rebase_pending_ && pts_us != AV_NOPTS_VALUE) {
+        const double position_us = ring_->writePosition() * 1000000.0 / config_.format.sample_rate;
+        clock_scale_.store(pending_clock_scale_, std::memory_order_relaxed);
+        clock_origin_us_.store(pts_us - static_cast<int64_t>(std::llround(position_us * pending_clock_scale_)),
+                               std::memory_order_relaxed);
+        clock_valid_.store(true, std::memory_order_release);
+        rebase_pending_ = false;
+    }
+
+    const size_t written = ring_->write(data, frames);
+    frames_written_.fetch_add(written, std::memory_order_relaxed);
+    if (written < frames) {
+        frames_dropped_.fetch_add(frames - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+size_t AudioOutput::writeFrame(const AVFrame* frame, int64_t pts_us) {
+    if (!frame || frame->format != config_.format.sample_fmt ||
+        frame->sample_rate != config_.format.sample_rate) {
+        return 0;
+    }
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+    const int channels = frame->ch_layout.nb_channels;
+#else
+    const int channels = frame->channels;
+#endif
+    if (channels != config_.format.channels) {
+        return 0;
+    }
+    return write(frame->data[0], static_cast<size_t>(frame->nb_samples), pts_us);
+}
+
+void AudioOutput::flush() {
+    if (!ring_) {
+        return;
+    }
+    clock_valid_.store(false, std::memory_order_release);
+    rebase_pending_ = true;
+    primed_.store(false, std::memory_order_relaxed);
+    flush_position_.store(ring_->writePosition(), std::memory_order_relaxed);
+    flush_pending_.store(true, std::memory_order_release);
+}
+
+void AudioOutput::setClockScale(double scale) {
+    if (scale > 0.0) {
+        pending_clock_scale_ = scale;
+    }
+}
+
+int64_t AudioOutput::getClockUs() const {
+    if (!sink_ || !clock_valid_.load(std::memory_order_acquire)) {
+        return AV_NOPTS_VALUE;
+    }
+
+    const int rate = config_.format.sample_rate;
+    const int64_t position = static_cast<int64_t>(played_position_.load(std::memory_order_acquire));
+    const int64_t audible = std::max<int64_t>(0, position - sink_->latencyFrames());
+    int64_t played_us = av_rescale(audible, 1000000, rate);
+
+    // 两次回调之间按墙钟插值，最多推进上一次回调交出的时长
+    const int64_t last_callback = last_callback_us_.load(std::memory_order_relaxed);
+    if (last_callback > 0) {
+        const int64_t span = av_rescale(static_cast<int64_t>(last_callback_frames_.load(std::memory_order_relaxed)),
+                                        1000000, rate);
+        played_us += std::max<int64_t>(0, std::min(nowUs() - last_callback, span));
+    }
+
+    // 变速播放：每播出1秒样本，媒体时间推进scale秒
+    const double scale = clock_scale_.load(std::memory_order_relaxed);
+    return clock_origin_us_.load(std::memory_order_relaxed) + static_cast<int64_t>(std::llround(played_us * scale));
+}
+
+AudioOutput::StatisticsSnapshot AudioOutput::getStatistics() const {
+    StatisticsSnapshot snapshot{};
+    snapshot.callbacks = callbacks_.load(std::memory_order_relaxed);
+    snapshot.frames_written = frames_written_.load(std::memory_order_relaxed);
+    snapshot.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    snapshot.frames_rendered = frames_rendered_.load(std::memory_order_relaxed);
+    snapshot.silence_frames = silence_frames_.load(std::memory_order_relaxed);
+    snapshot.underruns = underruns_.load(std::memory_order_relaxed) + (sink_ ? sink_->deviceUnderruns() : 0);
+    snapshot.buffered_frames = ring_ ? ring_->availableRead() : 0;
+    const size_t min_buffered = min_buffered_.load(std::memory_order_relaxed);
+    snapshot.min_buffered_frames = min_buffered == SIZE_MAX ? 0 : min_buffered;
+    snapshot.capacity_frames = ring_ ? ring_->capacityFrames() : 0;
+    snapshot.max_callback_us = max_callback_ns_.load(std::memory_order_relaxed) / 1000.0;
+    snapshot.sample_rate = config_.format.sample_rate;
+    return snapshot;
+}
+
+std::string AudioOutput::sinkName() const {
+    return sink_ ? sink_->name() : std::string();
+}
+
+void AudioOutput::render(uint8_t* out, size_t frames) {
+    // 设备回调：只允许原子操作和memcpy
+    const auto start = std::chrono::steady_clock::now();
+    COPY_ACCOUNT_STREAM("audio");
+
+    if (flush_pending_.exchange(false, std::memory_order_acq_rel)) {
+        ring_->discardUntil(flush_position_.load(std::memory_order_relaxed));
+    }
+
+    const size_t bytes_per_frame = ring_->bytesPerFrame();
+    const size_t got = ring_->read(out, frames);
+    if (got < frames) {
+        // S16/S32/FLT的静音都是全零
+        std::memset(out + got * bytes_per_frame, 0, (frames - got) * bytes_per_frame);
+        if (primed_.load(std::memory_order_relaxed)) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            silence_frames_.fetch_add(frames - got, std::memory_order_relaxed);
+            underrun_metric_.add();
+        }
+    }
+    if (got > 0) {
+        primed_.store(true, std::memory_order_relaxed);
+    }
+
+    played_position_.store(ring_->readPosition(), std::memory_order_release);
+    last_callback_frames_.store(got, std::memory_order_relaxed);
+    last_callback_us_.store(std::chrono::duration_cast<std::chrono::microseconds>(
+        start.time_since_epoch()).count(), std::memory_order_relaxed);
+
+    // 以下统计只有回调线程写入，load/store即可，无需CAS
+    if (primed_.load(std::memory_order_relaxed)) {
+        const size_t buffered = ring_->availableRead();
+        if (buffered < min_buffered_.load(std::memory_order_relaxed)) {
+            min_buffered_.store(buffered, std::memory_order_relaxed);
+        }
+    }
+    callbacks_.fetch_add(1, std::memory_order_relaxed);
+    frames_rendered_.fetch_add(got, std::memory_order_relaxed);
+
+    const int64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (elapsed_ns > max_callback_ns_.load(std::memory_order_relaxed)) {
+        max_callback_ns_.store(elapsed_ns, std::memory_order_relaxed);
+    }
+}
+
+int64_t AudioOutput::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace media
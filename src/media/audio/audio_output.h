@@ -0,0 +1,277 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "audio_ring_buffer.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/samplefmt.h>
+}
+
+namespace media {
+
+/**
+ * @brief 输出音频格式（交错排列）
+ */
+struct AudioFormat {
+    int sample_rate;
+    int channels;
+    AVSampleFormat sample_fmt;  // 只支持交错格式：S16/S32/FLT
+
+    AudioFormat()
+        : sample_rate(48000)
+        , channels(2)
+        , sample_fmt(AV_SAMPLE_FMT_S16)
+    {}
+
+    size_t bytesPerFrame() const {
+        return static_cast<size_t>(av_get_bytes_per_sample(sample_fmt)) * channels;
+    }
+
+    bool isValid() const {
+        return sample_rate > 0 && channels > 0 && !av_sample_fmt_is_planar(sample_fmt) &&
+               (sample_fmt == AV_SAMPLE_FMT_S16 || sample_fmt == AV_SAMPLE_FMT_S32 ||
+                sample_fmt == AV_SAMPLE_FMT_FLT);
+    }
+};
+
+/**
+ * @brief 音频渲染源：设备回调从这里拉取数据
+ *
+ * render必须无等待：不加锁、不分配内存、不做系统调用。
+ */
+class IAudioRenderSource {
+public:
+    virtual ~IAudioRenderSource() = default;
+
+    /**
+     * @brief 填满out（frames帧），数据不足的部分填静音
+     */
+    virtual void render(uint8_t* out, size_t frames) = 0;
+};
+
+/**
+ * @brief 音频输出设备类型
+ */
+enum class AudioSinkType {
+    Auto,       // 优先真实设备，不可用时退回Null
+    Null,       // 按实时节奏消费并丢弃（测试/无声卡环境）
+    File,       // 按实时节奏写入WAV文件（测试）
+    Alsa        // Linux ALSA（编译时检测到alsa才可用）
+};
+
+/**
+ * @brief 音频输出设备抽象
+ *
+ * 每个设备有自己的回调线程（或由系统驱动回调），周期性调用IAudioRenderSource::render。
+ */
+class IAudioSink {
+public:
+    virtual ~IAudioSink() = default;
+
+    /**
+     * @brief 打开设备
+     * @param format 输出格式
+     * @param period_frames 每次回调的帧数
+     * @param source 渲染源，生命周期必须长于设备
+     */
+    virtual bool open(const AudioFormat& format, size_t period_frames, IAudioRenderSource* source) = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual void close() = 0;
+
+    /**
+     * @brief 已交给设备但尚未播出的帧数（时钟补偿用，任意线程）
+     */
+    virtual int64_t latencyFrames() const = 0;
+
+    /**
+     * @brief 设备侧检测到的欠载次数（例如ALSA xrun）
+     */
+    virtual uint64_t deviceUnderruns() const { return 0; }
+
+    virtual std::string name() const = 0;
+    virtual std::string getLastError() const = 0;
+};
+
+/**
+ * @brief 音频输出设备工厂
+ */
+class AudioSinkFactory {
+public:
+    /**
+     * @brief 创建指定类型的设备
+     * @param type 设备类型，Auto时返回编译进来的第一个真实设备
+     * @param target 设备名（ALSA，如"default"）或文件路径（File）
+     */
+    static std::unique_ptr<IAudioSink> create(AudioSinkType type, const std::string& target = std::string());
+
+    /**
+     * @brief 是否编译了该类型的设备
+     */
+    static bool isAvailable(AudioSinkType type);
+};
+
+/**
+ * @brief 音频输出：无锁环形缓冲 + 低延迟回调 + 音频时钟
+ *
+ * 设计特点：
+ * 1. 单生产者/单消费者：解码转换线程write，设备回调render，中间只有AudioRingBuffer
+ * 2. 回调无等待：render只做环形缓冲读取、静音填充和原子计数，不加锁、不分配内存
+ * 3. 遥测：缓冲水位（当前/最低）、欠载次数与静音帧数、回调最大耗时
+ * 4. 音频时钟：已播放到的样本对应的pts，扣除设备延迟并在两次回调之间插值，供音视频同步使用
+ * 5. flush无锁：生产者记下写位置请求丢弃，消费者在下一次回调中执行
+ */
+class AudioOutput : public IAudioRenderSource {
+public:
+    /**
+     * @brief 输出配置
+     */
+    struct Config {
+        AudioSinkType sink_type;
+        std::string target;         // 设备名或文件路径
+        AudioFormat format;
+        size_t period_frames;       // 每次回调帧数（48kHz下256帧约5.3ms）
+        size_t buffer_ms;           // 环形缓冲时长
+
+        Config()
+            : sink_type(AudioSinkType::Auto)
+            , period_frames(256)
+            , buffer_ms(200)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t callbacks;             // 回调次数
+        uint64_t frames_written;        // 生产者写入帧数
+        uint64_t frames_dropped;        // 缓冲满时丢弃的帧数
+        uint64_t frames_rendered;       // 播出的真实数据帧数
+        uint64_t silence_frames;        // 因欠载填充的静音帧数
+        uint64_t underruns;             // 欠载回调次数（含设备侧xrun）
+        size_t buffered_frames;         // 当前缓冲帧数
+        size_t min_buffered_frames;     // 开始播放后缓冲最低水位
+        size_t capacity_frames;         // 缓冲容量
+        double max_callback_us;         // 回调最大耗时
+        int sample_rate;
+
+        double getBufferFillRatio() const {
+            return capacity_frames > 0 ? static_cast<double>(buffered_frames) / capacity_frames : 0.0;
+        }
+
+        double getBufferedMs() const {
+            return sample_rate > 0 ? buffered_frames * 1000.0 / sample_rate : 0.0;
+        }
+    };
+
+public:
+    AudioOutput();
+    ~AudioOutput() override;
+
+    AudioOutput(const AudioOutput&) = delete;
+    AudioOutput& operator=(const AudioOutput&) = delete;
+
+    /**
+     * @brief 创建环形缓冲并打开设备
+     */
+    bool initialize(const Config& config);
+
+    bool start();
+    void stop();
+    void close();
+
+    /**
+     * @brief 写入交错音频（仅生产者线程，不阻塞）
+     * @param data 交错采样数据，格式与配置一致
+     * @param frames 帧数
+     * @param pts_us 第一帧的显示时间（微秒），AV_NOPTS_VALUE表示与上次写入连续
+     * @return 实际写入的帧数，缓冲满时小于frames
+     */
+    size_t write(const uint8_t* data, size_t frames, int64_t pts_us = AV_NOPTS_VALUE);
+
+    /**
+     * @brief 写入一个已重采样到输出格式的AVFrame（仅生产者线程）
+     * @return 实际写入的帧数；格式不匹配返回0
+     */
+    size_t writeFrame(const AVFrame* frame, int64_t pts_us = AV_NOPTS_VALUE);
+
+    /**
+     * @brief 丢弃已缓冲的数据（seek时调用，仅生产者线程）
+     *
+     * 下一次写入必须带pts以重新建立时钟基准。
+     */
+    void flush();
+
+    /**
+     * @brief 设置时钟倍率（变速播放，仅生产者线程）
+     *
+     * 写入的样本已经过时间伸缩时，每播出1秒对应scale秒的媒体时间。
+     * 只在下一次重建基准时生效，因此应在flush之后、下一次带pts的写入之前调用。
+     */
+    void setClockScale(double scale);
+
+    /**
+     * @brief 可写帧数（生产者据此决定写多少，避免丢帧）
+     */
+    size_t availableWrite() const { return ring_ ? ring_->availableWrite() : 0; }
+
+    /**
+     * @brief 音频时钟（微秒）：当前正在播出的样本的pts，未建立基准时返回AV_NOPTS_VALUE
+     */
+    int64_t getClockUs() const;
+
+    StatisticsSnapshot getStatistics() const;
+    const AudioFormat& format() const { return config_.format; }
+    std::string sinkName() const;
+    std::string getLastError() const { return last_error_; }
+
+    // IAudioRenderSource（设备回调线程）
+    void render(uint8_t* out, size_t frames) override;
+
+private:
+    static int64_t nowUs();
+
+private:
+    Config config_;
+    std::unique_ptr<AudioRingBuffer> ring_;
+    std::unique_ptr<IAudioSink> sink_;
+    std::string last_error_;
+
+    // 生产者 -> 消费者
+    std::atomic<size_t> flush_position_{0};         // 丢弃此写位置之前的数据
+    std::atomic<bool> flush_pending_{false};
+    std::atomic<int64_t> clock_origin_us_{0};       // 写位置0对应的pts（微秒）
+    std::atomic<bool> clock_valid_{false};
+    std::atomic<double> clock_scale_{1.0};          // 每播出1秒对应的媒体时间
+    bool rebase_pending_ = true;                    // 生产者独占
+    double pending_clock_scale_ = 1.0;              // 生产者独占，重建基准时生效
+
+    // 消费者 -> 任意线程
+    std::atomic<size_t> played_position_{0};       // 已交给设备的写位置
+    std::atomic<int64_t> last_callback_us_{0};
+    std::atomic<size_t> last_callback_frames_{0};
+    std::atomic<bool> primed_{false};               // 已收到过数据，之后的空缓冲才算欠载
+
+    // 统计（每项只有一个线程写入）
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> frames_written_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint64_t> frames_rendered_{0};
+    std::atomic<uint64_t> silence_frames_{0};
+    std::atomic<uint64_t> underruns_{0};
+    std::atomic<size_t> min_buffered_{SIZE_MAX};
+    std::atomic<int64_t> max_callback_ns_{0};
+    Metric& underrun_metric_;                       // 性能浮层：欠载次数（回调中只做原子加）
+};
+
+} // namespace media
+
+#endif // AUDIO_OUTPUT_H
@@ -0,0 +1,92 @@
+#include "audio_ring_buffer.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace media {
+
+namespace {
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+AudioRingBuffer::AudioRingBuffer(size_t capacity_frames, size_t bytes_per_frame)
+    : capacity_(roundUpPowerOfTwo(std::max<size_t>(capacity_frames, 2)))
+    , mask_(capacity_ - 1)
+    , bytes_per_frame_(std::max<size_t>(bytes_per_frame, 1))
+    , buffer_(new uint8_t[capacity_ * bytes_per_frame_]) {
+}
+
+size_t AudioRingBuffer::write(const uint8_t* data, size_t frames) {
+    const size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    const size_t read_pos = read_pos_.load(std::memory_order_acquire);
+    const size_t count = std::min(frames, capacity_ - (write_pos - read_pos));
+    if (count == 0) {
+        return 0;
+    }
+
+    // 最多分两段拷贝（跨越缓冲区末尾时回绕）
+    const size_t offset = write_pos & mask_;
+    const size_t first = std::min(count, capacity_ - offset);
+    COPY_MEMCPY("audio.ring_write", buffer_.get() + offset * bytes_per_frame_, data, first * bytes_per_frame_);
+    if (count > first) {
+        COPY_MEMCPY("audio.ring_write", buffer_.get(), data + first * bytes_per_frame_, (count - first) * bytes_per_frame_);
+    }
+
+    write_pos_.store(write_pos + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::read(uint8_t* data, size_t frames) {
+    const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    const size_t count = std::min(frames, write_pos - read_pos);
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t offset = read_pos & mask_;
+    const size_t first = std::min(count, capacity_ - offset);
+    COPY_MEMCPY("audio.ring_read", data, buffer_.get() + offset * bytes_per_frame_, first * bytes_per_frame_);
+    if (count > first) {
+        COPY_MEMCPY("audio.ring_read", data + first * bytes_per_frame_, buffer_.get(), (count - first) * bytes_per_frame_);
+    }
+
+    read_pos_.store(read_pos + count, std::memory_order_release);
+    return count;
+}
+
+void AudioRingBuffer::clear() {
+    discardUntil(write_pos_.load(std::memory_order_acquire));
+}
+
+void AudioRingBuffer::discardUntil(size_t position) {
+    // 消费者把读位置推进到目标位置，等价于读走这些数据；不会越过写位置，也不会后退
+    const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    const size_t target = std::min(position, write_pos);
+    if (target > read_pos) {
+        read_pos_.store(target, std::memory_order_release);
+    }
+}
+
+size_t AudioRingBuffer::availableRead() const {
+    // 先读读位置：写位置只增不减，差值不会下溢
+    const size_t read_pos = read_pos_.load(std::memory_order_acquire);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    return std::min(write_pos - read_pos, capacity_);
+}
+
+size_t AudioRingBuffer::availableWrite() const {
+    return capacity_ - availableRead();
+}
+
+} // namespace media
@@ -0,0 +1,91 @@
+#ifndef AUDIO_RING_BUFFER_H
+#define AUDIO_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace media {
+
+/**
+ * @brief 无锁单生产者/单消费者音频环形缓冲区
+ *
+ * 设计特点：
+ * 1. 单生产者/单消费者：解码转换线程写入，音频设备回调读取
+ * 2. 无等待：读写各自只做一次原子加载和一次原子存储，不加锁、不分配内存
+ * 3. 容量取2的幂：下标用掩码回绕，读写位置单调递增，满/空无需额外标记
+ * 4. 按帧对齐：读写长度都是整数个音频帧（所有声道的一个采样点）
+ */
+class AudioRingBuffer {
+public:
+    /**
+     * @param capacity_frames 期望容量（帧），向上取整到2的幂
+     * @param bytes_per_frame 每帧字节数（采样字节数 * 声道数）
+     */
+    AudioRingBuffer(size_t capacity_frames, size_t bytes_per_frame);
+
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    /**
+     * @brief 写入音频帧（仅生产者线程）
+     * @return 实际写入的帧数，空间不足时只写入一部分
+     */
+    size_t write(const uint8_t* data, size_t frames);
+
+    /**
+     * @brief 读出音频帧（仅消费者线程）
+     * @return 实际读出的帧数
+     */
+    size_t read(uint8_t* data, size_t frames);
+
+    /**
+     * @brief 丢弃所有已缓冲的数据（仅消费者线程，或双方都空闲时）
+     */
+    void clear();
+
+    /**
+     * @brief 丢弃写位置position之前的数据（仅消费者线程）
+     *
+     * 生产者记下writePosition()后请求消费者丢弃，之后写入的新数据不受影响。
+     */
+    void discardUntil(size_t position);
+
+    /**
+     * @brief 累计写入帧数（生产者线程精确，其他线程近似）
+     */
+    size_t writePosition() const { return write_pos_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 累计读出帧数（消费者线程精确，其他线程近似）
+     */
+    size_t readPosition() const { return read_pos_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 可读帧数（任意线程，结果为近似值）
+     */
+    size_t availableRead() const;
+
+    /**
+     * @brief 可写帧数（任意线程，结果为近似值）
+     */
+    size_t availableWrite() const;
+
+    size_t capacityFrames() const { return capacity_; }
+    size_t bytesPerFrame() const { return bytes_per_frame_; }
+
+private:
+    const size_t capacity_;             // 帧数，2的幂
+    const size_t mask_;
+    const size_t bytes_per_frame_;
+    std::unique_ptr<uint8_t[]> buffer_;
+
+    // 读写位置分属不同缓存行，避免生产者和消费者互相抖动
+    alignas(64) std::atomic<size_t> write_pos_{0};
+    alignas(64) std::atomic<size_t> read_pos_{0};
+};
+
+} // namespace media
+
+#endif // AUDIO_RING_BUFFER_H
@@ -0,0 +1,299 @@
+#include "audio_sinks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#ifdef MEDIA_AUDIO_ALSA_AVAILABLE
+#include <alsa/asoundlib.h>
+#endif
+
+namespace media {
+
+// ============ ClockedAudioSink ============
+
+ClockedAudioSink::~ClockedAudioSink() {
+    // 派生类析构时后端已销毁，这里只负责停线程；派生类应自行close
+    stop();
+}
+
+bool ClockedAudioSink::open(const AudioFormat& format, size_t period_frames, IAudioRenderSource* source) {
+    close();
+    if (!source || period_frames == 0 || !format.isValid()) {
+        last_error_ = "音频设备参数无效";
+        return false;
+    }
+    format_ = format;
+    period_frames_ = period_frames;
+    source_ = source;
+    period_buffer_.assign(period_frames * format.bytesPerFrame(), 0);
+    return openBackend();
+}
+
+bool ClockedAudioSink::start() {
+    if (!source_) {
+        last_error_ = "音频设备未打开";
+        return false;
+    }
+    if (running_.exchange(true)) {
+        return true;
+    }
+    thread_ = std::thread(&ClockedAudioSink::clockLoop, this);
+    return true;
+}
+
+void ClockedAudioSink::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ClockedAudioSink::close() {
+    stop();
+    if (source_) {
+        closeBackend();
+    }
+    source_ = nullptr;
+    period_buffer_.clear();
+}
+
+void ClockedAudioSink::clockLoop() {
+    const auto period = std::chrono::nanoseconds(
+        static_cast<int64_t>(period_frames_ * 1000000000ull / format_.sample_rate));
+    auto next = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_relaxed)) {
+        source_->render(period_buffer_.data(), period_frames_);
+        consume(period_buffer_.data(), period_frames_);
+
+        next += period;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now - period * 4) {
+            next = now;     // 线程被长时间挂起时不追赶，避免连续爆发回调
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// ============ FileAudioSink ============
+
+FileAudioSink::FileAudioSink(const std::string& path)
+    : path_(path) {
+}
+
+FileAudioSink::~FileAudioSink() {
+    close();    // 回填WAV头需要在派生类析构内完成
+}
+
+bool FileAudioSink::openBackend() {
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_) {
+        last_error_ = "无法创建音频文件 " + path_;
+        return false;
+    }
+    frames_written_.store(0);
+    writeHeader(0);     // 关闭时回填长度
+    return true;
+}
+
+void FileAudioSink::consume(const uint8_t* data, size_t frames) {
+    if (file_) {
+        std::fwrite(data, format_.bytesPerFrame(), frames, file_);
+        frames_written_.fetch_add(frames, std::memory_order_relaxed);
+    }
+}
+
+void FileAudioSink::closeBackend() {
+    if (!file_) {
+        return;
+    }
+    const uint64_t data_bytes = frames_written_.load() * format_.bytesPerFrame();
+    std::fseek(file_, 0, SEEK_SET);
+    writeHeader(static_cast<uint32_t>(std::min<uint64_t>(data_bytes, 0xFFFFFFFFu - 36)));
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void FileAudioSink::writeHeader(uint32_t data_bytes) {
+    auto put16 = [this](uint16_t value) {
+        uint8_t bytes[2] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+        std::fwrite(bytes, 1, 2, file_);
+    };
+    auto put32 = [this](uint32_t value) {
+        uint8_t bytes[4] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+                            static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+        std::fwrite(bytes, 1, 4, file_);
+    };
+
+    const uint16_t bytes_per_sample = static_cast<uint16_t>(av_get_bytes_per_sample(format_.sample_fmt));
+    const uint16_t block_align = static_cast<uint16_t>(format_.bytesPerFrame());
+    const uint16_t format_tag = format_.sample_fmt == AV_SAMPLE_FMT_FLT ? 3 : 1;  // IEEE float / PCM
+
+    std::fwrite("RIFF", 1, 4, file_);
+    put32(36 + data_bytes);
+    std::fwrite("WAVEfmt ", 1, 8, file_);
+    put32(16);
+    put16(format_tag);
+    put16(static_cast<uint16_t>(format_.channels));
+    put32(static_cast<uint32_t>(format_.sample_rate));
+    put32(static_cast<uint32_t>(format_.sample_rate) * block_align);
+    put16(block_align);
+    put16(bytes_per_sample * 8);
+    std::fwrite("data", 1, 4, file_);
+    put32(data_bytes);
+}
+
+// ============ AlsaAudioSink ============
+
+#ifdef MEDIA_AUDIO_ALSA_AVAILABLE
+
+AlsaAudioSink::AlsaAudioSink(const std::string& device)
+    : device_(device.empty() ? "default" : device) {
+}
+
+AlsaAudioSink::~AlsaAudioSink() {
+    close();
+}
+
+bool AlsaAudioSink::open(const AudioFormat& format, size_t period_frames, IAudioRenderSource* source) {
+    close();
+    if (!source || period_frames == 0 || !format.isValid()) {
+        last_error_ = "音频设备参数无效";
+        return false;
+    }
+
+    snd_pcm_format_t pcm_format = SND_PCM_FORMAT_S16;
+    if (format.sample_fmt == AV_SAMPLE_FMT_S32) {
+        pcm_format = SND_PCM_FORMAT_S32;
+    } else if (format.sample_fmt == AV_SAMPLE_FMT_FLT) {
+        pcm_format = SND_PCM_FORMAT_FLOAT;
+    }
+
+    snd_pcm_t* pcm = nullptr;
+    int err = snd_pcm_open(&pcm, device_.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        last_error_ = std::string("打开ALSA设备失败: ") + snd_strerror(err);
+        return false;
+    }
+
+    // 设备缓冲取4个周期：足够吸收调度抖动，又不引入明显延迟
+    const unsigned int latency_us = static_cast<unsigned int>(
+        period_frames * 4 * 1000000ull / format.sample_rate);
+    err = snd_pcm_set_params(pcm, pcm_format, SND_PCM_ACCESS_RW_INTERLEAVED,
+                             static_cast<unsigned int>(format.channels),
+                             static_cast<unsigned int>(format.sample_rate), 1, latency_us);
+    if (err < 0) {
+        last_error_ = std::string("配置ALSA设备失败: ") + snd_strerror(err);
+        snd_pcm_close(pcm);
+        return false;
+    }
+
+    pcm_ = pcm;
+    format_ = format;
+    period_frames_ = period_frames;
+    source_ = source;
+    period_buffer_.assign(period_frames * format.bytesPerFrame(), 0);
+    delay_frames_.store(0);
+    xruns_.store(0);
+    return true;
+}
+
+bool AlsaAudioSink::start() {
+    if (!pcm_) {
+        last_error_ = "音频设备未打开";
+        return false;
+    }
+    if (running_.exchange(true)) {
+        return true;
+    }
+    thread_ = std::thread(&AlsaAudioSink::playbackLoop, this);
+    return true;
+}
+
+void AlsaAudioSink::stop() {
+    running_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (pcm_) {
+        snd_pcm_drop(static_cast<snd_pcm_t*>(pcm_));
+        snd_pcm_prepare(static_cast<snd_pcm_t*>(pcm_));
+    }
+}
+
+void AlsaAudioSink::close() {
+    stop();
+    if (pcm_) {
+        snd_pcm_close(static_cast<snd_pcm_t*>(pcm_));
+        pcm_ = nullptr;
+    }
+    source_ = nullptr;
+}
+
+void AlsaAudioSink::playbackLoop() {
+    snd_pcm_t* pcm = static_cast<snd_pcm_t*>(pcm_);
+    const size_t bytes_per_frame = format_.bytesPerFrame();
+
+    while (running_.load(std::memory_order_relaxed)) {
+        source_->render(period_buffer_.data(), period_frames_);
+
+        // writei在设备缓冲满时阻塞，由设备节拍驱动下一次render
+        size_t offset = 0;
+        while (offset < period_frames_ && running_.load(std::memory_order_relaxed)) {
+            snd_pcm_sframes_t written = snd_pcm_writei(
+                pcm, period_buffer_.data() + offset * bytes_per_frame, period_frames_ - offset);
+            if (written < 0) {
+                if (written == -EPIPE) {
+                    xruns_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (snd_pcm_recover(pcm, static_cast<int>(written), 1) < 0) {
+                    running_.store(false);
+                    break;
+                }
+                continue;
+            }
+            offset += static_cast<size_t>(written);
+        }
+
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(pcm, &delay) == 0) {
+            delay_frames_.store(delay, std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif // MEDIA_AUDIO_ALSA_AVAILABLE
+
+// ============ AudioSinkFactory ============
+
+std::unique_ptr<IAudioSink> AudioSinkFactory::create(AudioSinkType type, const std::string& target) {
+    switch (type) {
+    case AudioSinkType::Null:
+        return std::make_unique<NullAudioSink>();
+    case AudioSinkType::File:
+        return std::make_unique<FileAudioSink>(target);
+#ifdef MEDIA_AUDIO_ALSA_AVAILABLE
+    case AudioSinkType::Auto:
+    case AudioSinkType::Alsa:
+        return std::make_unique<AlsaAudioSink>(target);
+#else
+    case AudioSinkType::Auto:
+        return std::make_unique<NullAudioSink>();
+    case AudioSinkType::Alsa:
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+bool AudioSinkFactory::isAvailable(AudioSinkType type) {
+#ifdef MEDIA_AUDIO_ALSA_AVAILABLE
+    (void)type;
+    return true;
+#else
+    return type != AudioSinkType::Alsa;
+#endif
+}
+
+} // namespace media
@@ -0,0 +1,143 @@
+#ifndef AUDIO_SINKS_H
+#define AUDIO_SINKS_H
+
+#include "audio_output.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace media {
+
+/**
+ * @brief 自带定时线程的设备基类
+ *
+ * 线程按周期时长（sleep_until，不累积漂移）调用render，再把数据交给consume。
+ * 周期缓冲在open时分配，回调路径上没有内存分配。
+ */
+class ClockedAudioSink : public IAudioSink {
+public:
+    ~ClockedAudioSink() override;
+
+    bool open(const AudioFormat& format, size_t period_frames, IAudioRenderSource* source) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+
+    // 一个周期的数据在下一个周期内“播出”
+    int64_t latencyFrames() const override { return static_cast<int64_t>(period_frames_); }
+    std::string getLastError() const override { return last_error_; }
+
+protected:
+    /**
+     * @brief 打开后端资源（open内调用）
+     */
+    virtual bool openBackend() { return true; }
+
+    /**
+     * @brief 消费一个周期的数据（定时线程调用）
+     */
+    virtual void consume(const uint8_t* data, size_t frames) = 0;
+
+    /**
+     * @brief 释放后端资源（close内调用，定时线程已停止）
+     */
+    virtual void closeBackend() {}
+
+    AudioFormat format_;
+    size_t period_frames_ = 0;
+    std::string last_error_;
+
+private:
+    void clockLoop();
+
+    IAudioRenderSource* source_ = nullptr;
+    std::vector<uint8_t> period_buffer_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+/**
+ * @brief 空设备：按实时节奏拉取并丢弃数据
+ *
+ * 没有声卡时音频时钟仍然正常推进，音视频同步逻辑不需要区分。
+ */
+class NullAudioSink : public ClockedAudioSink {
+public:
+    std::string name() const override { return "null"; }
+
+protected:
+    void consume(const uint8_t*, size_t) override {}
+};
+
+/**
+ * @brief WAV文件设备：按实时节奏写入文件，用于测试和离线检查输出
+ */
+class FileAudioSink : public ClockedAudioSink {
+public:
+    explicit FileAudioSink(const std::string& path);
+    ~FileAudioSink() override;
+
+    std::string name() const override { return "file:" + path_; }
+
+    /**
+     * @brief 已写入的音频帧数
+     */
+    uint64_t framesWritten() const { return frames_written_.load(); }
+
+protected:
+    bool openBackend() override;
+    void consume(const uint8_t* data, size_t frames) override;
+    void closeBackend() override;
+
+private:
+    void writeHeader(uint32_t data_bytes);
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    std::atomic<uint64_t> frames_written_{0};
+};
+
+#ifdef MEDIA_AUDIO_ALSA_AVAILABLE
+/**
+ * @brief ALSA设备
+ *
+ * 专用线程阻塞在snd_pcm_writei上（设备节拍驱动），render本身仍然无等待。
+ * xrun（设备欠载）时重新prepare并计数。
+ */
+class AlsaAudioSink : public IAudioSink {
+public:
+    explicit AlsaAudioSink(const std::string& device);
+    ~AlsaAudioSink() override;
+
+    bool open(const AudioFormat& format, size_t period_frames, IAudioRenderSource* source) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+
+    int64_t latencyFrames() const override { return delay_frames_.load(std::memory_order_relaxed); }
+    uint64_t deviceUnderruns() const override { return xruns_.load(std::memory_order_relaxed); }
+    std::string name() const override { return "alsa:" + device_; }
+    std::string getLastError() const override { return last_error_; }
+
+private:
+    void playbackLoop();
+
+    std::string device_;
+    void* pcm_ = nullptr;               // snd_pcm_t*，头文件不暴露alsa
+    AudioFormat format_;
+    size_t period_frames_ = 0;
+    IAudioRenderSource* source_ = nullptr;
+    std::vector<uint8_t> period_buffer_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int64_t> delay_frames_{0};
+    std::atomic<uint64_t> xruns_{0};
+    std::string last_error_;
+};
+#endif
+
+} // namespace media
+
+#endif // AUDIO_SINKS_H
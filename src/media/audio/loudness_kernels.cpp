@@ -0,0 +1,365 @@
+#include "loudness_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MEDIA_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#define MEDIA_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace media {
+namespace loudness_kernels {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 低于此值的滤波状态清零：静音时IIR状态按指数衰减，不清零会掉进非规格化数，运算变慢上百倍
+constexpr double kDenormalFloor = 1e-30;
+
+// ITU-R BS.1770-4 附件2：4倍过采样插值滤波器，按相位排列
+alignas(32) const float kTruePeakCoefficients[kTruePeakPhases][kTruePeakTaps] = {
+    { 0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+     -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+      0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f},
+    {-0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+     -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+      0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f},
+    {-0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+     -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+      0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f},
+    {-0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+     -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+      0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f},
+};
+
+std::atomic<bool> g_force_scalar{false};
+
+// ==================== 标量实现 ====================
+
+void kWeightScalar(const float* in, int channels, int channel, int frames, const KWeighting& f,
+                   KWeightState& s, double* sum_squares) {
+    double z1 = s.shelf_z1[channel];
+    double z2 = s.shelf_z2[channel];
+    double h1 = s.highpass_z1[channel];
+    double h2 = s.highpass_z2[channel];
+    double acc = sum_squares[channel];
+    for (int i = 0; i < frames; ++i) {
+        const double x = in[static_cast<size_t>(i) * channels + channel];
+        const double y = f.shelf.b0 * x + z1;
+        z1 = (f.shelf.b1 * x - f.shelf.a1 * y) + z2;
+        z2 = f.shelf.b2 * x - f.shelf.a2 * y;
+        const double w = f.highpass.b0 * y + h1;
+        h1 = (f.highpass.b1 * y - f.highpass.a1 * w) + h2;
+        h2 = f.highpass.b2 * y - f.highpass.a2 * w;
+        acc += w * w;
+    }
+    s.shelf_z1[channel] = z1;
+    s.shelf_z2[channel] = z2;
+    s.highpass_z1[channel] = h1;
+    s.highpass_z2[channel] = h2;
+    sum_squares[channel] = acc;
+}
+
+float truePeakScalar(const float* x, int begin, int count) {
+    float peak = 0.0f;
+    for (int i = begin; i < count; ++i) {
+        for (int p = 0; p < kTruePeakPhases; ++p) {
+            const float* h = kTruePeakCoefficients[p];
+            float acc = h[0] * x[i];
+            for (int k = 1; k < kTruePeakTaps; ++k) {
+                acc = acc + h[k] * x[i - k];
+            }
+            peak = std::max(peak, std::fabs(acc));
+        }
+    }
+    return peak;
+}
+
+// ==================== SSE2实现 ====================
+
+#ifdef MEDIA_KERNELS_SSE2
+
+// 一对相邻声道放在一个__m128d里
+void kWeightPairSse2(const float* in, int channels, int channel, int frames, const KWeighting& f,
+                     KWeightState& s, double* sum_squares) {
+    const __m128d sb0 = _mm_set1_pd(f.shelf.b0);
+    const __m128d sb1 = _mm_set1_pd(f.shelf.b1);
+    const __m128d sb2 = _mm_set1_pd(f.shelf.b2);
+    const __m128d sa1 = _mm_set1_pd(f.shelf.a1);
+    const __m128d sa2 = _mm_set1_pd(f.shelf.a2);
+    const __m128d hb0 = _mm_set1_pd(f.highpass.b0);
+    const __m128d hb1 = _mm_set1_pd(f.highpass.b1);
+    const __m128d hb2 = _mm_set1_pd(f.highpass.b2);
+    const __m128d ha1 = _mm_set1_pd(f.highpass.a1);
+    const __m128d ha2 = _mm_set1_pd(f.highpass.a2);
+
+    __m128d z1 = _mm_loadu_pd(s.shelf_z1 + channel);
+    __m128d z2 = _mm_loadu_pd(s.shelf_z2 + channel);
+    __m128d h1 = _mm_loadu_pd(s.highpass_z1 + channel);
+    __m128d h2 = _mm_loadu_pd(s.highpass_z2 + channel);
+    __m128d acc = _mm_loadu_pd(sum_squares + channel);
+    for (int i = 0; i < frames; ++i) {
+        const float* p = in + static_cast<size_t>(i) * channels + channel;
+        const __m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+        const __m128d y = _mm_add_pd(_mm_mul_pd(sb0, x), z1);
+        z1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(sb1, x), _mm_mul_pd(sa1, y)), z2);
+        z2 = _mm_sub_pd(_mm_mul_pd(sb2, x), _mm_mul_pd(sa2, y));
+        const __m128d w = _mm_add_pd(_mm_mul_pd(hb0, y), h1);
+        h1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(hb1, y), _mm_mul_pd(ha1, w)), h2);
+        h2 = _mm_sub_pd(_mm_mul_pd(hb2, y), _mm_mul_pd(ha2, w));
+        acc = _mm_add_pd(acc, _mm_mul_pd(w, w));
+    }
+    _mm_storeu_pd(s.shelf_z1 + channel, z1);
+    _mm_storeu_pd(s.shelf_z2 + channel, z2);
+    _mm_storeu_pd(s.highpass_z1 + channel, h1);
+    _mm_storeu_pd(s.highpass_z2 + channel, h2);
+    _mm_storeu_pd(sum_squares + channel, acc);
+}
+
+void kWeightSse2(const float* in, int channels, int first_channel, int frames, const KWeighting& f,
+                 KWeightState& s, double* sum_squares) {
+    int c = first_channel;
+    for (; c + 2 <= channels; c += 2) {
+        kWeightPairSse2(in, channels, c, frames, f, s, sum_squares);
+    }
+    for (; c < channels; ++c) {
+        kWeightScalar(in, channels, c, frames, f, s, sum_squares);
+    }
+}
+
+float truePeakSse2(const float* x, int count) {
+    const int vector_count = count / 4 * 4;
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peak = _mm_setzero_ps();
+    for (int i = 0; i < vector_count; i += 4) {
+        for (int p = 0; p < kTruePeakPhases; ++p) {
+            const float* h = kTruePeakCoefficients[p];
+            __m128 acc = _mm_mul_ps(_mm_set1_ps(h[0]), _mm_loadu_ps(x + i));
+            for (int k = 1; k < kTruePeakTaps; ++k) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(h[k]), _mm_loadu_ps(x + i - k)));
+            }
+            peak = _mm_max_ps(peak, _mm_and_ps(acc, abs_mask));
+        }
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, peak);
+    const float vector_peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    return std::max(vector_peak, truePeakScalar(x, vector_count, count));
+}
+
+#endif // MEDIA_KERNELS_SSE2
+
+// ==================== AVX2实现 ====================
+
+#ifdef MEDIA_KERNELS_AVX2
+
+// 四个相邻声道放在一个__m256d里
+__attribute__((target("avx2")))
+void kWeightQuadAvx2(const float* in, int channels, int channel, int frames, const KWeighting& f,
+                     KWeightState& s, double* sum_squares) {
+    const __m256d sb0 = _mm256_set1_pd(f.shelf.b0);
+    const __m256d sb1 = _mm256_set1_pd(f.shelf.b1);
+    const __m256d sb2 = _mm256_set1_pd(f.shelf.b2);
+    const __m256d sa1 = _mm256_set1_pd(f.shelf.a1);
+    const __m256d sa2 = _mm256_set1_pd(f.shelf.a2);
+    const __m256d hb0 = _mm256_set1_pd(f.highpass.b0);
+    const __m256d hb1 = _mm256_set1_pd(f.highpass.b1);
+    const __m256d hb2 = _mm256_set1_pd(f.highpass.b2);
+    const __m256d ha1 = _mm256_set1_pd(f.highpass.a1);
+    const __m256d ha2 = _mm256_set1_pd(f.highpass.a2);
+
+    __m256d z1 = _mm256_loadu_pd(s.shelf_z1 + channel);
+    __m256d z2 = _mm256_loadu_pd(s.shelf_z2 + channel);
+    __m256d h1 = _mm256_loadu_pd(s.highpass_z1 + channel);
+    __m256d h2 = _mm256_loadu_pd(s.highpass_z2 + channel);
+    __m256d acc = _mm256_loadu_pd(sum_squares + channel);
+    for (int i = 0; i < frames; ++i) {
+        const __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(in + static_cast<size_t>(i) * channels + channel));
+        const __m256d y = _mm256_add_pd(_mm256_mul_pd(sb0, x), z1);
+        z1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(sb1, x), _mm256_mul_pd(sa1, y)), z2);
+        z2 = _mm256_sub_pd(_mm256_mul_pd(sb2, x), _mm256_mul_pd(sa2, y));
+        const __m256d w = _mm256_add_pd(_mm256_mul_pd(hb0, y), h1);
+        h1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(hb1, y), _mm256_mul_pd(ha1, w)), h2);
+        h2 = _mm256_sub_pd(_mm256_mul_pd(hb2, y), _mm256_mul_pd(ha2, w));
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(w, w));
+    }
+    _mm256_storeu_pd(s.shelf_z1 + channel, z1);
+    _mm256_storeu_pd(s.shelf_z2 + channel, z2);
+    _mm256_storeu_pd(s.highpass_z1 + channel, h1);
+    _mm256_storeu_pd(s.highpass_z2 + channel, h2);
+    _mm256_storeu_pd(sum_squares + channel, acc);
+}
+
+__attribute__((target("avx2")))
+float truePeakAvx2(const float* x, int count) {
+    const int vector_count = count / 8 * 8;
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak = _mm256_setzero_ps();
+    for (int i = 0; i < vector_count; i += 8) {
+        for (int p = 0; p < kTruePeakPhases; ++p) {
+            const float* h = kTruePeakCoefficients[p];
+            __m256 acc = _mm256_mul_ps(_mm256_set1_ps(h[0]), _mm256_loadu_ps(x + i));
+            for (int k = 1; k < kTruePeakTaps; ++k) {
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(h[k]), _mm256_loadu_ps(x + i - k)));
+            }
+            peak = _mm256_max_ps(peak, _mm256_and_ps(acc, abs_mask));
+        }
+    }
+    const __m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, half);
+    const float vector_peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    return std::max(vector_peak, truePeakScalar(x, vector_count, count));
+}
+
+bool cpuHasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // MEDIA_KERNELS_AVX2
+
+bool avx2Available() {
+#ifdef MEDIA_KERNELS_AVX2
+    static const bool available = cpuHasAvx2();
+    return available;
+#else
+    return false;
+#endif
+}
+
+void flushDenormals(double* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (std::fabs(values[i]) < kDenormalFloor) {
+            values[i] = 0.0;
+        }
+    }
+}
+
+} // namespace
+
+KWeighting KWeighting::forSampleRate(int sample_rate) {
+    // 双线性变换设计，参数取自BS.1770在48kHz下的系数反推（与libebur128相同）
+    KWeighting filter;
+    const double rate = static_cast<double>(sample_rate);
+    {
+        const double f0 = 1681.974450955533;
+        const double gain_db = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(kPi * f0 / rate);
+        const double vh = std::pow(10.0, gain_db / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        filter.shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        filter.shelf.b1 = 2.0 * (k * k - vh) / a0;
+        filter.shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        filter.shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(kPi * f0 / rate);
+        const double a0 = 1.0 + k / q + k * k;
+        filter.highpass.b0 = 1.0;
+        filter.highpass.b1 = -2.0;
+        filter.highpass.b2 = 1.0;
+        filter.highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.highpass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    return filter;
+}
+
+void KWeightState::reset() {
+    std::fill(shelf_z1, shelf_z1 + kMaxChannels, 0.0);
+    std::fill(shelf_z2, shelf_z2 + kMaxChannels, 0.0);
+    std::fill(highpass_z1, highpass_z1 + kMaxChannels, 0.0);
+    std::fill(highpass_z2, highpass_z2 + kMaxChannels, 0.0);
+}
+
+Isa activeIsa() {
+    if (g_force_scalar.load(std::memory_order_relaxed)) {
+        return Isa::Scalar;
+    }
+    if (avx2Available()) {
+        return Isa::Avx2;
+    }
+#ifdef MEDIA_KERNELS_SSE2
+    return Isa::Sse2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+void forceScalar(bool force) {
+    g_force_scalar.store(force, std::memory_order_relaxed);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Avx2: return "AVX2";
+    case Isa::Sse2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+void kWeight(const float* interleaved, int channels, int frames, const KWeighting& filter,
+             KWeightState& state, double* sum_squares) {
+    // 不能截断声道数：channels同时是交错步长，截断后第二帧起读错采样
+    if (channels <= 0 || channels > kMaxChannels || frames <= 0) {
+        return;
+    }
+
+    const Isa isa = activeIsa();
+    int c = 0;
+#ifdef MEDIA_KERNELS_AVX2
+    if (isa == Isa::Avx2) {
+        for (; c + 4 <= channels; c += 4) {
+            kWeightQuadAvx2(interleaved, channels, c, frames, filter, state, sum_squares);
+        }
+    }
+#endif
+#ifdef MEDIA_KERNELS_SSE2
+    if (isa != Isa::Scalar) {
+        kWeightSse2(interleaved, channels, c, frames, filter, state, sum_squares);
+        c = channels;
+    }
+#endif
+    for (; c < channels; ++c) {
+        kWeightScalar(interleaved, channels, c, frames, filter, state, sum_squares);
+    }
+
+    flushDenormals(state.shelf_z1, channels);
+    flushDenormals(state.shelf_z2, channels);
+    flushDenormals(state.highpass_z1, channels);
+    flushDenormals(state.highpass_z2, channels);
+}
+
+float truePeak4x(const float* samples, int count) {
+    if (count <= 0) {
+        return 0.0f;
+    }
+    switch (activeIsa()) {
+#ifdef MEDIA_KERNELS_AVX2
+    case Isa::Avx2:
+        return truePeakAvx2(samples, count);
+#endif
+#ifdef MEDIA_KERNELS_SSE2
+    case Isa::Sse2:
+        return truePeakSse2(samples, count);
+#endif
+    default:
+        return truePeakScalar(samples, 0, count);
+    }
+}
+
+} // namespace loudness_kernels
+} // namespace media
@@ -0,0 +1,99 @@
+#ifndef LOUDNESS_KERNELS_H
+#define LOUDNESS_KERNELS_H
+
+namespace media {
+
+/**
+ * @brief 响度测量的采样内核（ITU-R BS.1770）
+ *
+ * 设计特点：
+ * 1. K加权按声道分组向量化：IIR在时间上是递归的，但各声道互不相关，
+ *    交错输入的相邻声道直接装进double向量的各个通道（AVX2每组4声道，SSE2每组2声道）
+ * 2. 真峰值按输出位置向量化：4倍过采样的每个相位是12抽头FIR，一次算8个（AVX2）或4个（SSE2）相邻输出
+ * 3. 运行时分派：AVX2用函数级target属性并检测CPU；SSE2是x86-64基线，直接使用
+ * 4. 结果逐位一致：各实现的运算顺序相同且不使用FMA，forceScalar用于对比测试和基准
+ */
+namespace loudness_kernels {
+
+/**
+ * @brief 指令集
+ */
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+constexpr int kMaxChannels = 8;
+constexpr int kTruePeakTaps = 12;               // 每个相位的抽头数
+constexpr int kTruePeakPhases = 4;              // 过采样倍数
+constexpr int kTruePeakHistory = kTruePeakTaps - 1;
+
+/**
+ * @brief 二阶节系数（a0已归一化为1）
+ */
+struct Biquad {
+    double b0;
+    double b1;
+    double b2;
+    double a1;
+    double a2;
+};
+
+/**
+ * @brief K加权滤波器：高频搁架 + RLB高通
+ */
+struct KWeighting {
+    Biquad shelf;
+    Biquad highpass;
+
+    /**
+     * @brief 按采样率计算系数（48kHz时与BS.1770给出的系数一致）
+     */
+    static KWeighting forSampleRate(int sample_rate);
+};
+
+/**
+ * @brief K加权滤波状态（转置直接II型，每声道每级两个状态）
+ */
+struct KWeightState {
+    double shelf_z1[kMaxChannels];
+    double shelf_z2[kMaxChannels];
+    double highpass_z1[kMaxChannels];
+    double highpass_z2[kMaxChannels];
+
+    KWeightState() { reset(); }
+    void reset();
+};
+
+/**
+ * @brief 当前使用的指令集
+ */
+Isa activeIsa();
+
+/**
+ * @brief 强制使用标量实现（测试/基准对比用，影响所有线程）
+ */
+void forceScalar(bool force);
+
+const char* isaName(Isa isa);
+
+/**
+ * @brief K加权并累加各声道输出的平方和
+ * @param interleaved 交错采样；channels超过kMaxChannels时不处理
+ * @param sum_squares 每声道一个累加值，结果加到原值上
+ */
+void kWeight(const float* interleaved, int channels, int frames, const KWeighting& filter,
+             KWeightState& state, double* sum_squares);
+
+/**
+ * @brief 4倍过采样后的最大绝对值
+ * @param samples 单声道连续采样，samples[-kTruePeakHistory .. -1]必须是之前的采样（开头可补0）
+ */
+float truePeak4x(const float* samples, int count);
+
+} // namespace loudness_kernels
+
+} // namespace media
+
+#endif // LOUDNESS_KERNELS_H
@@ -0,0 +1,326 @@
+#include "loudness_meter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+namespace media {
+
+namespace {
+
+constexpr int kChunkFrames = 1024;
+constexpr size_t kMomentaryBlocks = 4;          // 400ms
+constexpr size_t kShortTermBlocks = 30;         // 3s
+constexpr double kAbsoluteGateLufs = -70.0;
+constexpr double kIntegratedRelativeGate = -10.0;
+constexpr double kRangeRelativeGate = -20.0;
+constexpr double kRangeLowPercentile = 0.10;
+constexpr double kRangeHighPercentile = 0.95;
+constexpr double kHistogramStep = 0.1;
+constexpr int kHistogramBins = 1000;            // -70 ~ +30 LUFS
+constexpr double kSurroundWeight = 1.41;
+
+const double kNegativeInfinity = -std::numeric_limits<double>::infinity();
+
+double binCenter(int index) {
+    return kAbsoluteGateLufs + (index + 0.5) * kHistogramStep;
+}
+
+double amplitudeToDb(float amplitude) {
+    return amplitude > 0.0f ? 20.0 * std::log10(static_cast<double>(amplitude)) : kNegativeInfinity;
+}
+
+LoudnessMeter::Reading emptyReading() {
+    return LoudnessMeter::Reading{kNegativeInfinity, kNegativeInfinity, kNegativeInfinity, 0.0,
+                                  kNegativeInfinity, kNegativeInfinity, kNegativeInfinity, 0.0};
+}
+
+} // namespace
+
+void LoudnessMeter::Histogram::clear() {
+    energy.assign(kHistogramBins, 0.0);
+    count.assign(kHistogramBins, 0);
+    total_energy = 0.0;
+    total_count = 0;
+}
+
+void LoudnessMeter::Histogram::add(double block_energy, double lufs) {
+    const int index = std::min(static_cast<int>((lufs - kAbsoluteGateLufs) / kHistogramStep), kHistogramBins - 1);
+    energy[std::max(index, 0)] += block_energy;
+    count[std::max(index, 0)]++;
+    total_energy += block_energy;
+    total_count++;
+}
+
+LoudnessMeter::LoudnessMeter(const Config& config)
+    : config_(config)
+    , process_metric_(MetricsRegistry::instance().latency("stage.loudness")) {
+    config_.sample_rate = std::max(config_.sample_rate, 8000);
+    config_.channels = std::min(std::max(config_.channels, 1), loudness_kernels::kMaxChannels);
+    channels_ = config_.channels;
+    weights_ = config_.channel_weights.size() == static_cast<size_t>(channels_)
+                   ? config_.channel_weights
+                   : defaultChannelWeights(channels_);
+    block_frames_ = config_.sample_rate / 10;
+    filter_ = loudness_kernels::KWeighting::forSampleRate(config_.sample_rate);
+    planar_stride_ = loudness_kernels::kTruePeakHistory + kChunkFrames;
+    planar_.resize(static_cast<size_t>(planar_stride_) * channels_);
+
+    if (!config_.metric_name.empty()) {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        const std::string prefix = "loudness." + config_.metric_name + ".";
+        momentary_metric_ = &registry.gauge(prefix + "momentary");
+        short_term_metric_ = &registry.gauge(prefix + "short_term");
+        integrated_metric_ = &registry.gauge(prefix + "integrated");
+        range_metric_ = &registry.gauge(prefix + "range");
+        true_peak_metric_ = &registry.gauge(prefix + "true_peak");
+    }
+    reset();
+}
+
+std::vector<double> LoudnessMeter::defaultChannelWeights(int channels) {
+    std::vector<double> weights(static_cast<size_t>(std::max(channels, 0)), 1.0);
+    // FFmpeg默认布局：5.1为FL FR FC LFE BL BR，7.1为FL FR FC LFE BL BR SL SR
+    if (channels == 6 || channels == 8) {
+        weights[3] = 0.0;
+        for (int c = 4; c < channels; ++c) {
+            weights[c] = kSurroundWeight;
+        }
+    }
+    return weights;
+}
+
+double LoudnessMeter::energyToLufs(double energy) {
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : kNegativeInfinity;
+}
+
+void LoudnessMeter::reset() {
+    filter_state_.reset();
+    std::fill(channel_sum_, channel_sum_ + loudness_kernels::kMaxChannels, 0.0);
+    block_position_ = 0;
+    block_energy_.assign(kShortTermBlocks, 0.0);
+    block_count_ = 0;
+    integrated_histogram_.clear();
+    range_histogram_.clear();
+    std::fill(planar_.begin(), planar_.end(), 0.0f);
+    sample_peak_ = 0.0f;
+    true_peak_ = 0.0f;
+    max_momentary_energy_ = 0.0;
+    measured_frames_ = 0;
+
+    const Reading empty = emptyReading();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reading_ = empty;
+    }
+    publish(empty);
+}
+
+LoudnessMeter::Reading LoudnessMeter::reading() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reading_;
+}
+
+std::string LoudnessMeter::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+bool LoudnessMeter::process(const AVFrame* frame) {
+    if (!frame || frame->nb_samples <= 0) {
+        return false;
+    }
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+    const int channels = frame->ch_layout.nb_channels;
+#else
+    const int channels = frame->channels;
+#endif
+    const AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    if ((format != AV_SAMPLE_FMT_FLT && format != AV_SAMPLE_FMT_FLTP) ||
+        frame->sample_rate != config_.sample_rate || channels != channels_) {
+        stats_.frames_rejected++;
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "音频格式与响度表配置不符（需要FLT/FLTP，采样率和声道数一致）";
+        return false;
+    }
+
+    if (format == AV_SAMPLE_FMT_FLT) {
+        process(reinterpret_cast<const float*>(frame->data[0]), frame->nb_samples);
+        return true;
+    }
+
+    interleave_buffer_.resize(static_cast<size_t>(frame->nb_samples) * channels_);
+    for (int c = 0; c < channels_; ++c) {
+        const float* plane = reinterpret_cast<const float*>(frame->extended_data[c]);
+        for (int i = 0; i < frame->nb_samples; ++i) {
+            interleave_buffer_[static_cast<size_t>(i) * channels_ + c] = plane[i];
+        }
+    }
+    process(interleave_buffer_.data(), frame->nb_samples);
+    return true;
+}
+
+void LoudnessMeter::process(const float* interleaved, int frames) {
+    if (!interleaved || frames <= 0) {
+        return;
+    }
+    ScopedLatency timing(process_metric_);
+    for (int offset = 0; offset < frames; offset += kChunkFrames) {
+        processChunk(interleaved + static_cast<size_t>(offset) * channels_, std::min(kChunkFrames, frames - offset));
+    }
+}
+
+void LoudnessMeter::processChunk(const float* interleaved, int frames) {
+    // 峰值：拆成每声道连续采样，真峰值内核需要前kTruePeakHistory个历史采样
+    constexpr int history = loudness_kernels::kTruePeakHistory;
+    float sample_peak = sample_peak_;
+    for (int c = 0; c < channels_; ++c) {
+        float* plane = planar_.data() + static_cast<size_t>(c) * planar_stride_;
+        float* samples = plane + history;
+        for (int i = 0; i < frames; ++i) {
+            const float value = interleaved[static_cast<size_t>(i) * channels_ + c];
+            samples[i] = value;
+            sample_peak = std::max(sample_peak, std::fabs(value));
+        }
+        if (config_.true_peak) {
+            true_peak_ = std::max(true_peak_, loudness_kernels::truePeak4x(samples, frames));
+        }
+        std::memmove(plane, plane + frames, sizeof(float) * history);
+    }
+    sample_peak_ = sample_peak;
+
+    // K加权能量，按100ms子块切分
+    int offset = 0;
+    while (offset < frames) {
+        const int count = std::min(frames - offset, block_frames_ - block_position_);
+        loudness_kernels::kWeight(interleaved + static_cast<size_t>(offset) * channels_, channels_, count,
+                                  filter_, filter_state_, channel_sum_);
+        offset += count;
+        block_position_ += count;
+        measured_frames_ += static_cast<uint64_t>(count);
+        stats_.frames_processed += static_cast<uint64_t>(count);
+        if (block_position_ == block_frames_) {
+            finishBlock();
+        }
+    }
+}
+
+void LoudnessMeter::finishBlock() {
+    double energy = 0.0;
+    for (int c = 0; c < channels_; ++c) {
+        energy += weights_[c] * channel_sum_[c] / block_frames_;
+        channel_sum_[c] = 0.0;
+    }
+    block_position_ = 0;
+    block_energy_[block_count_ % kShortTermBlocks] = energy;
+    block_count_++;
+    stats_.blocks_measured++;
+
+    auto windowEnergy = [this](size_t blocks) {
+        double sum = 0.0;
+        for (size_t i = 0; i < blocks; ++i) {
+            sum += block_energy_[(block_count_ - 1 - i) % kShortTermBlocks];
+        }
+        return sum / blocks;
+    };
+
+    Reading reading = emptyReading();
+
+    // 400ms块每100ms一个（重叠75%），既是瞬时响度也是积分响度的门控块
+    if (block_count_ >= kMomentaryBlocks) {
+        const double momentary = windowEnergy(kMomentaryBlocks);
+        reading.momentary_lufs = energyToLufs(momentary);
+        max_momentary_energy_ = std::max(max_momentary_energy_, momentary);
+        if (reading.momentary_lufs >= kAbsoluteGateLufs) {
+            integrated_histogram_.add(momentary, reading.momentary_lufs);
+        }
+    }
+    if (block_count_ >= kShortTermBlocks) {
+        const double short_term = windowEnergy(kShortTermBlocks);
+        reading.short_term_lufs = energyToLufs(short_term);
+        if (reading.short_term_lufs >= kAbsoluteGateLufs) {
+            range_histogram_.add(short_term, reading.short_term_lufs);
+        }
+    }
+    reading.integrated_lufs = integratedLufs();
+    reading.loudness_range_lu = loudnessRange();
+    reading.max_momentary_lufs = energyToLufs(max_momentary_energy_);
+    reading.sample_peak_dbfs = amplitudeToDb(sample_peak_);
+    reading.true_peak_dbtp = config_.true_peak ? amplitudeToDb(std::max(true_peak_, sample_peak_))
+                                               : kNegativeInfinity;
+    reading.measured_seconds = static_cast<double>(measured_frames_) / config_.sample_rate;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reading_ = reading;
+    }
+    publish(reading);
+}
+
+double LoudnessMeter::integratedLufs() const {
+    const Histogram& histogram = integrated_histogram_;
+    if (histogram.total_count == 0) {
+        return kNegativeInfinity;
+    }
+    const double gate = energyToLufs(histogram.total_energy / histogram.total_count) + kIntegratedRelativeGate;
+    double energy = 0.0;
+    uint64_t count = 0;
+    for (int i = 0; i < kHistogramBins; ++i) {
+        if (histogram.count[i] > 0 && binCenter(i) >= gate) {
+            energy += histogram.energy[i];
+            count += histogram.count[i];
+        }
+    }
+    return count > 0 ? energyToLufs(energy / count) : kNegativeInfinity;
+}
+
+double LoudnessMeter::loudnessRange() const {
+    const Histogram& histogram = range_histogram_;
+    if (histogram.total_count == 0) {
+        return 0.0;
+    }
+    const double gate = energyToLufs(histogram.total_energy / histogram.total_count) + kRangeRelativeGate;
+    int first = 0;
+    while (first < kHistogramBins && binCenter(first) < gate) {
+        ++first;
+    }
+    uint64_t gated = 0;
+    for (int i = first; i < kHistogramBins; ++i) {
+        gated += histogram.count[i];
+    }
+    if (gated == 0) {
+        return 0.0;
+    }
+
+    // 第k个值（从0计）所在的分箱中心
+    auto percentile = [&](double p) {
+        const uint64_t rank = static_cast<uint64_t>(p * (gated - 1) + 0.5);
+        uint64_t seen = 0;
+        for (int i = first; i < kHistogramBins; ++i) {
+            seen += histogram.count[i];
+            if (seen > rank) {
+                return binCenter(i);
+            }
+        }
+        return binCenter(kHistogramBins - 1);
+    };
+    return percentile(kRangeHighPercentile) - percentile(kRangeLowPercentile);
+}
+
+void LoudnessMeter::publish(const Reading& reading) {
+    if (!momentary_metric_) {
+        return;
+    }
+    momentary_metric_->set(reading.momentary_lufs);
+    short_term_metric_->set(reading.short_term_lufs);
+    integrated_metric_->set(reading.integrated_lufs);
+    range_metric_->set(reading.loudness_range_lu);
+    true_peak_metric_->set(reading.true_peak_dbtp);
+}
+
+} // namespace media
@@ -0,0 +1,197 @@
+#ifndef LOUDNESS_METER_H
+#define LOUDNESS_METER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "loudness_kernels.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace media {
+
+/**
+ * @brief EBU R128 响度表（单路音频）
+ *
+ * 设计特点：
+ * 1. 标准测量：K加权、100ms子块、400ms瞬时响度（M）、3s短期响度（S）、
+ *    绝对门限-70 LUFS加相对门限-10 LU的积分响度（I）、EBU Tech 3342响度范围（LRA）
+ * 2. 真峰值：BS.1770附件2的4倍过采样插值，另外给出采样峰值
+ * 3. 内存固定：门控块按0.1 LU分箱累计能量和块数，测量时长不影响内存和计算量
+ * 4. 低成本：K加权与真峰值走SIMD内核，稳态下不分配内存，单核可同时测量上百路立体声
+ * 5. 发布：metric_name非空时每100ms把结果写入 loudness.<名称>.* 指标，性能浮层据此显示
+ *
+ * process只在一个线程调用（通常是音频解码线程）；reading可在任意线程调用。
+ */
+class LoudnessMeter {
+public:
+    /**
+     * @brief 测量配置
+     */
+    struct Config {
+        int sample_rate;
+        int channels;                           // 不超过loudness_kernels::kMaxChannels
+        bool true_peak;                         // 是否测量真峰值（关闭时只有采样峰值）
+        std::vector<double> channel_weights;    // 声道加权，为空时按声道数取BS.1770默认值
+        std::string metric_name;                // 非空时发布到 loudness.<metric_name>.*
+
+        Config()
+            : sample_rate(48000)
+            , channels(2)
+            , true_peak(true)
+        {}
+    };
+
+    /**
+     * @brief 测量结果（无有效值时为负无穷）
+     */
+    struct Reading {
+        double momentary_lufs;
+        double short_term_lufs;
+        double integrated_lufs;
+        double loudness_range_lu;
+        double max_momentary_lufs;
+        double sample_peak_dbfs;
+        double true_peak_dbtp;
+        double measured_seconds;                // 已测量的音频时长
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t frames_processed;      // 采样帧数
+        uint64_t blocks_measured;       // 100ms子块数
+        uint64_t frames_rejected;       // 格式不符被拒绝的音频帧（AVFrame）
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> frames_processed{0};
+        std::atomic<uint64_t> blocks_measured{0};
+        std::atomic<uint64_t> frames_rejected{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                frames_processed.load(),
+                blocks_measured.load(),
+                frames_rejected.load()
+            };
+        }
+    };
+
+public:
+    explicit LoudnessMeter(const Config& config = Config{});
+
+    LoudnessMeter(const LoudnessMeter&) = delete;
+    LoudnessMeter& operator=(const LoudnessMeter&) = delete;
+
+    /**
+     * @brief 送入交错float采样
+     */
+    void process(const float* interleaved, int frames);
+
+    /**
+     * @brief 送入一帧音频（FLT或FLTP，采样率和声道数须与配置一致）
+     * @return 格式不符时返回false
+     */
+    bool process(const AVFrame* frame);
+
+    /**
+     * @brief 清除全部测量结果和滤波状态（换源时调用）
+     */
+    void reset();
+
+    /**
+     * @brief 当前测量结果（每100ms更新一次）
+     */
+    Reading reading() const;
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+    /**
+     * @brief BS.1770声道加权：LFE为0，5.1/7.1的环绕声道为1.41，其余为1
+     */
+    static std::vector<double> defaultChannelWeights(int channels);
+
+    /**
+     * @brief 均方能量换算为LUFS（能量为0时为负无穷）
+     */
+    static double energyToLufs(double energy);
+
+private:
+    /**
+     * @brief 0.1 LU分箱的门控块直方图
+     */
+    struct Histogram {
+        std::vector<double> energy;     // 每箱的能量和
+        std::vector<uint32_t> count;    // 每箱的块数
+        double total_energy = 0.0;
+        uint64_t total_count = 0;
+
+        void clear();
+        void add(double block_energy, double lufs);
+    };
+
+    void processChunk(const float* interleaved, int frames);
+    void finishBlock();
+    double integratedLufs() const;
+    double loudnessRange() const;
+    void publish(const Reading& reading);
+
+private:
+    Config config_;
+    int channels_;
+    std::vector<double> weights_;
+    int block_frames_;                                  // 100ms子块的帧数
+    loudness_kernels::KWeighting filter_;
+    loudness_kernels::KWeightState filter_state_;
+    double channel_sum_[loudness_kernels::kMaxChannels];
+    int block_position_ = 0;
+
+    // 最近30个子块的加权均方能量（环形）
+    std::vector<double> block_energy_;
+    size_t block_count_ = 0;
+
+    Histogram integrated_histogram_;    // 400ms门控块
+    Histogram range_histogram_;         // 3s短期块
+
+    // 真峰值：每声道一段连续缓冲，开头保留上一段的kTruePeakHistory个采样
+    std::vector<float> planar_;
+    int planar_stride_ = 0;
+    float sample_peak_ = 0.0f;
+    float true_peak_ = 0.0f;
+    double max_momentary_energy_ = 0.0;
+    uint64_t measured_frames_ = 0;
+
+    // FLTP输入转交错
+    std::vector<float> interleave_buffer_;
+
+    mutable std::mutex mutex_;          // 保护reading_和last_error_
+    Reading reading_;
+    std::string last_error_;
+
+    Statistics stats_;
+
+    // 性能浮层
+    Metric& process_metric_;
+    Metric* momentary_metric_ = nullptr;
+    Metric* short_term_metric_ = nullptr;
+    Metric* integrated_metric_ = nullptr;
+    Metric* range_metric_ = nullptr;
+    Metric* true_peak_metric_ = nullptr;
+};
+
+} // namespace media
+
+#endif // LOUDNESS_METER_H
@@ -0,0 +1,190 @@
+#include "wsola_time_stretcher.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace media {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kCoarseStep = 4;
+
+} // namespace
+
+WsolaTimeStretcher::WsolaTimeStretcher(int sample_rate, int channels, const Config& config)
+    : sample_rate_(std::max(sample_rate, 1))
+    , channels_(std::max(channels, 1))
+    , window_(std::max(16, sample_rate_ * config.window_ms / 1000) & ~1)
+    , hop_(window_ / 2)
+    , search_(std::max(1, sample_rate_ * config.search_ms / 1000)) {
+    // 周期Hann窗：50%重叠时两窗之和恒为1
+    hann_.resize(window_);
+    for (int i = 0; i < window_; ++i) {
+        hann_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * i / window_));
+    }
+    overlap_.assign(static_cast<size_t>(hop_) * channels_, 0.0f);
+    mono_template_.resize(hop_);
+}
+
+void WsolaTimeStretcher::setSpeed(double speed) {
+    speed_ = std::max(kMinSpeed, std::min(kMaxSpeed, speed));
+}
+
+void WsolaTimeStretcher::push(const float* samples, size_t frames) {
+    if (!samples || frames == 0) {
+        return;
+    }
+
+    // 1倍速直通
+    if (speed_ == 1.0) {
+        compactInput();
+        output_.insert(output_.end(), samples, samples + frames * channels_);
+        return;
+    }
+
+    input_.insert(input_.end(), samples, samples + frames * channels_);
+    input_end_ += static_cast<int64_t>(frames);
+    while (processOneHop()) {
+    }
+    compactInput();
+}
+
+size_t WsolaTimeStretcher::pull(float* out, size_t max_frames) {
+    const size_t frames = std::min(max_frames, availableFrames());
+    if (frames == 0 || !out) {
+        return 0;
+    }
+    COPY_MEMCPY("audio.wsola_pull", out, output_.data() + output_read_ * channels_, frames * channels_ * sizeof(float));
+    output_read_ += frames;
+    return frames;
+}
+
+size_t WsolaTimeStretcher::availableFrames() const {
+    return output_.size() / channels_ - output_read_;
+}
+
+void WsolaTimeStretcher::reset() {
+    input_.clear();
+    input_start_ = 0;
+    input_end_ = 0;
+    next_position_ = 0.0;
+    previous_position_ = -1;
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    output_.clear();
+    output_read_ = 0;
+}
+
+bool WsolaTimeStretcher::processOneHop() {
+    const int64_t nominal = static_cast<int64_t>(std::llround(next_position_));
+
+    // 需要名义位置+搜索半径+整窗的输入，以及上一段的自然延续
+    if (nominal + search_ + window_ > input_end_) {
+        return false;
+    }
+    if (previous_position_ >= 0 && previous_position_ + hop_ + hop_ > input_end_) {
+        return false;
+    }
+
+    const int64_t position = previous_position_ < 0 ? nominal : findBestOffset(nominal);
+
+    const size_t base = output_.size();
+    output_.resize(base + static_cast<size_t>(hop_) * channels_);
+    float* out = output_.data() + base;
+
+    for (int i = 0; i < hop_; ++i) {
+        for (int c = 0; c < channels_; ++c) {
+            const float x = sample(position + i, c);
+            // 第一段不加窗，避免开头淡入
+            const float front = previous_position_ < 0 ? x : hann_[i] * x;
+            out[i * channels_ + c] = overlap_[i * channels_ + c] + front;
+            overlap_[i * channels_ + c] = hann_[hop_ + i] * sample(position + hop_ + i, c);
+        }
+    }
+
+    previous_position_ = position;
+    next_position_ += hop_ * speed_;
+    return true;
+}
+
+int64_t WsolaTimeStretcher::findBestOffset(int64_t nominal) const {
+    // 模板：上一段的自然延续（前半窗长度）
+    const int64_t template_start = previous_position_ + hop_;
+    for (int i = 0; i < hop_; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels_; ++c) {
+            sum += sample(template_start + i, c);
+        }
+        mono_template_[i] = sum;
+    }
+
+    // 候选区域的单声道混合
+    const int64_t lowest = std::max(nominal - search_, input_start_);
+    const int64_t highest = nominal + search_;
+    const size_t region_frames = static_cast<size_t>(highest - lowest + hop_);
+    mono_region_.resize(region_frames);
+    for (size_t i = 0; i < region_frames; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels_; ++c) {
+            sum += sample(lowest + static_cast<int64_t>(i), c);
+        }
+        mono_region_[i] = sum;
+    }
+
+    // 归一化互相关：corr / sqrt(候选段能量)
+    auto score = [this](size_t offset) {
+        double corr = 0.0;
+        double energy = 1e-9;
+        const float* candidate = mono_region_.data() + offset;
+        for (int i = 0; i < hop_; ++i) {
+            corr += static_cast<double>(candidate[i]) * mono_template_[i];
+            energy += static_cast<double>(candidate[i]) * candidate[i];
+        }
+        return corr / std::sqrt(energy);
+    };
+
+    const size_t range = static_cast<size_t>(highest - lowest);
+    size_t best = static_cast<size_t>(nominal - lowest);
+    double best_score = score(best);
+    for (size_t offset = 0; offset <= range; offset += kCoarseStep) {
+        const double s = score(offset);
+        if (s > best_score) {
+            best_score = s;
+            best = offset;
+        }
+    }
+
+    const size_t fine_begin = best > kCoarseStep ? best - kCoarseStep : 0;
+    const size_t fine_end = std::min(range, best + kCoarseStep);
+    for (size_t offset = fine_begin; offset <= fine_end; ++offset) {
+        const double s = score(offset);
+        if (s > best_score) {
+            best_score = s;
+            best = offset;
+        }
+    }
+    return lowest + static_cast<int64_t>(best);
+}
+
+void WsolaTimeStretcher::compactInput() {
+    // 已取走的输出超过一半时再整体前移，避免每次erase
+    if (output_read_ > 0 && output_read_ * 2 >= output_.size() / channels_) {
+        output_.erase(output_.begin(), output_.begin() + output_read_ * channels_);
+        output_read_ = 0;
+    }
+
+    // 不再需要的输入：早于下一次搜索下界和上一段自然延续
+    int64_t keep_from = static_cast<int64_t>(std::llround(next_position_)) - search_;
+    if (previous_position_ >= 0) {
+        keep_from = std::min(keep_from, previous_position_ + hop_);
+    }
+    const int64_t drop = keep_from - input_start_;
+    if (drop >= window_ * 4) {
+        input_.erase(input_.begin(), input_.begin() + drop * channels_);
+        input_start_ += drop;
+    }
+}
+
+} // namespace media
@@ -0,0 +1,110 @@
+#ifndef WSOLA_TIME_STRETCHER_H
+#define WSOLA_TIME_STRETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace media {
+
+/**
+ * @brief WSOLA音频时间伸缩（变速不变调）
+ *
+ * 设计特点：
+ * 1. 波形相似叠加：每个输出跳距在名义位置附近搜索与上一段自然延续最相似的输入段，再用Hann窗50%重叠相加
+ * 2. 粗细两级搜索：先按4个采样步长粗搜，再在最优点附近逐点细搜，相关计算只在单声道混合信号上进行
+ * 3. 1倍速直通：不做任何处理，切换速度时调用reset即可
+ * 4. 缓冲复用：输入/输出缓冲只增不减，稳态下不分配内存
+ *
+ * 输入输出均为交错float采样，仅在生产者线程使用（非线程安全）。
+ */
+class WsolaTimeStretcher {
+public:
+    static constexpr double kMinSpeed = 0.5;
+    static constexpr double kMaxSpeed = 2.0;
+
+    /**
+     * @brief 伸缩参数
+     */
+    struct Config {
+        int window_ms;      // 分析窗长度
+        int search_ms;      // 相似度搜索半径
+
+        Config()
+            : window_ms(30)
+            , search_ms(12)
+        {}
+    };
+
+public:
+    WsolaTimeStretcher(int sample_rate, int channels, const Config& config = Config{});
+
+    /**
+     * @brief 设置速度（夹到[kMinSpeed, kMaxSpeed]），建议在reset之后调用
+     */
+    void setSpeed(double speed);
+    double speed() const { return speed_; }
+
+    /**
+     * @brief 送入交错采样
+     */
+    void push(const float* samples, size_t frames);
+
+    /**
+     * @brief 取出伸缩后的采样
+     * @return 实际取出的帧数
+     */
+    size_t pull(float* out, size_t max_frames);
+
+    /**
+     * @brief 可取出的帧数
+     */
+    size_t availableFrames() const;
+
+    /**
+     * @brief 丢弃所有内部状态（seek或变速时调用）
+     */
+    void reset();
+
+    int channels() const { return channels_; }
+
+private:
+    bool processOneHop();
+    int64_t findBestOffset(int64_t nominal) const;
+    void compactInput();
+
+    float sample(int64_t frame, int channel) const {
+        return input_[static_cast<size_t>((frame - input_start_) * channels_ + channel)];
+    }
+
+private:
+    const int sample_rate_;
+    const int channels_;
+    const int window_;              // 窗长（帧），偶数
+    const int hop_;                 // 输出跳距 = 窗长/2
+    const int search_;              // 搜索半径（帧）
+    double speed_ = 1.0;
+
+    std::vector<float> hann_;
+
+    // 输入：input_[0]对应绝对帧号input_start_
+    std::vector<float> input_;
+    int64_t input_start_ = 0;
+    int64_t input_end_ = 0;
+
+    double next_position_ = 0.0;    // 下一个分析段的名义位置
+    int64_t previous_position_ = -1; // 上一个选中段的位置
+    std::vector<float> overlap_;    // 上一段后半窗，等待与下一段相加
+
+    // 输出：output_read_之前的已被取走
+    std::vector<float> output_;
+    size_t output_read_ = 0;
+
+    // 相关搜索用的单声道临时缓冲
+    mutable std::vector<float> mono_template_;
+    mutable std::vector<float> mono_region_;
+};
+
+} // namespace media
+
+#endif // WSOLA_TIME_STRETCHER_H
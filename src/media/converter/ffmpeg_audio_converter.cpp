@@ -0,0 +1,123 @@
+#include "ffmpeg_audio_converter.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/error.h>
+#include <libswresample/swresample.h>
+}
+
+namespace media {
+
+FFmpegAudioConverter::FFmpegAudioConverter() = default;
+
+FFmpegAudioConverter::~FFmpegAudioConverter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    swr_free(&swr_ctx_);
+}
+
+bool FFmpegAudioConverter::initialize(const AudioConvertParams& params) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 源参数以实际输入帧为准，这里只要求目标参数有效
+    if (params.dst_sample_rate <= 0 || params.dst_channels <= 0 ||
+        params.dst_format == AV_SAMPLE_FMT_NONE) {
+        last_error_ = "无效的音频转换参数";
+        return false;
+    }
+
+    params_ = params;
+    swr_free(&swr_ctx_);
+    swr_ctx_ = swr_alloc();
+    if (!swr_ctx_) {
+        last_error_ = "无法分配重采样上下文";
+        return false;
+    }
+    return true;
+}
+
+bool FFmpegAudioConverter::convert(const AVFrame* src_frame, AVFrame* dst_frame) {
+    if (!src_frame || !dst_frame) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!swr_ctx_) {
+        last_error_ = "转换器未初始化";
+        return false;
+    }
+
+    prepareOutputFrame(dst_frame);
+
+    // 未初始化的上下文由swr_convert_frame按两端帧参数自动配置
+    int ret = swr_convert_frame(swr_ctx_, dst_frame, src_frame);
+    if (ret == AVERROR_INPUT_CHANGED) {
+        swr_close(swr_ctx_);
+        ret = swr_convert_frame(swr_ctx_, dst_frame, src_frame);
+    }
+    if (ret < 0) {
+        setError("音频重采样失败: ", ret);
+        return false;
+    }
+
+    dst_frame->pts = src_frame->pts;
+    return true;
+}
+
+bool FFmpegAudioConverter::drain(AVFrame* dst_frame) {
+    if (!dst_frame) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 还没转换过任何帧时上下文未配置，没有可取的样本
+    if (!swr_ctx_ || !swr_is_initialized(swr_ctx_)) {
+        return false;
+    }
+
+    prepareOutputFrame(dst_frame);
+    const int ret = swr_convert_frame(swr_ctx_, dst_frame, nullptr);
+    if (ret < 0) {
+        setError("音频重采样排空失败: ", ret);
+        return false;
+    }
+    dst_frame->pts = AV_NOPTS_VALUE;
+    return dst_frame->nb_samples > 0;
+}
+
+size_t FFmpegAudioConverter::getOutputFrameSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (params_.dst_format == AV_SAMPLE_FMT_NONE) {
+        return 0;
+    }
+    return static_cast<size_t>(av_get_bytes_per_sample(params_.dst_format)) * params_.dst_channels;
+}
+
+bool FFmpegAudioConverter::reconfigure(const AudioConvertParams& params) {
+    return initialize(params);
+}
+
+std::string FFmpegAudioConverter::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FFmpegAudioConverter::prepareOutputFrame(AVFrame* dst_frame) const {
+    dst_frame->format = params_.dst_format;
+    dst_frame->sample_rate = params_.dst_sample_rate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+    if (dst_frame->ch_layout.nb_channels != params_.dst_channels) {
+        av_channel_layout_uninit(&dst_frame->ch_layout);
+        av_channel_layout_default(&dst_frame->ch_layout, params_.dst_channels);
+    }
+#else
+    dst_frame->channels = params_.dst_channels;
+    dst_frame->channel_layout = av_get_default_channel_layout(params_.dst_channels);
+#endif
+}
+
+void FFmpegAudioConverter::setError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    last_error_ = prefix + error_buf;
+}
+
+} // namespace media
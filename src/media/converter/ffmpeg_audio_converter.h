@@ -0,0 +1,68 @@
+#ifndef FFMPEG_AUDIO_CONVERTER_H
+#define FFMPEG_AUDIO_CONVERTER_H
+
+#include "video_convert.h"
+#include <mutex>
+#include <string>
+
+struct SwrContext;
+
+namespace media {
+
+/**
+ * @brief 基于libswresample的音频格式转换器
+ *
+ * 设计特点：
+ * 1. 以帧参数为准：源格式/采样率/声道布局从输入帧读取，码流中途变化时自动重建上下文
+ * 2. 输出交错格式：音频输出和时间伸缩都按交错采样处理
+ * 3. 目标帧未分配缓冲区时由swresample按需分配，调用方只需填好目标规格
+ */
+class FFmpegAudioConverter : public IAudioConverter {
+public:
+    FFmpegAudioConverter();
+    ~FFmpegAudioConverter() override;
+
+    FFmpegAudioConverter(const FFmpegAudioConverter&) = delete;
+    FFmpegAudioConverter& operator=(const FFmpegAudioConverter&) = delete;
+
+    // 实现IAudioConverter接口
+    bool initialize(const AudioConvertParams& params) override;
+
+    /**
+     * @brief 转换一帧
+     * @param src_frame 解码输出帧
+     * @param dst_frame 目标帧：未分配缓冲区时自动分配并设置好规格
+     */
+    bool convert(const AVFrame* src_frame, AVFrame* dst_frame) override;
+
+    /**
+     * @brief 取出重采样器内部缓存的尾部样本（流结束时调用）
+     * @return 没有剩余样本时返回false
+     */
+    bool drain(AVFrame* dst_frame);
+
+    /**
+     * @brief 每个输出采样帧（所有声道）的字节数
+     */
+    size_t getOutputFrameSize() const override;
+    bool reconfigure(const AudioConvertParams& params) override;
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    void prepareOutputFrame(AVFrame* dst_frame) const;
+    void setError(const std::string& prefix, int errnum);
+
+private:
+    mutable std::mutex mutex_;
+    AudioConvertParams params_;
+    SwrContext* swr_ctx_ = nullptr;
+    std::string last_error_;
+};
+
+} // namespace media
+
+#endif // FFMPEG_AUDIO_CONVERTER_H
@@ -0,0 +1,129 @@
+#include "ffmpeg_video_converter.h"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace media {
+
+FFmpegVideoConverter::FFmpegVideoConverter() = default;
+
+FFmpegVideoConverter::~FFmpegVideoConverter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sws_ctx_) {
+        sws_freeContext(sws_ctx_);
+        sws_ctx_ = nullptr;
+    }
+}
+
+bool FFmpegVideoConverter::initialize(const VideoConvertParams& params) {
+    if (!params.isValid()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "无效的转换参数";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    params_ = params;
+    return ensureContext(params.src_width, params.src_height, params.src_format);
+}
+
+bool FFmpegVideoConverter::convert(const AVFrame* src_frame, AVFrame* dst_frame) {
+    if (!src_frame || !dst_frame) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return convertLocked(src_frame, dst_frame);
+}
+
+size_t FFmpegVideoConverter::convertBatch(const AVFrame* const* src_frames, AVFrame* const* dst_frames,
+                                          size_t count) {
+    if (!src_frames || !dst_frames) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t converted = 0;
+    for (; converted < count; ++converted) {
+        if (!src_frames[converted] || !dst_frames[converted] ||
+            !convertLocked(src_frames[converted], dst_frames[converted])) {
+            break;
+        }
+    }
+    return converted;
+}
+
+bool FFmpegVideoConverter::convertLocked(const AVFrame* src_frame, AVFrame* dst_frame) {
+    // 源帧尺寸或格式变化时（如码流中途切换分辨率）自动重建上下文
+    AVPixelFormat src_format = static_cast<AVPixelFormat>(src_frame->format);
+    if (!ensureContext(src_frame->width, src_frame->height, src_format)) {
+        return false;
+    }
+
+    if (dst_frame->width != params_.dst_width ||
+        dst_frame->height != params_.dst_height ||
+        dst_frame->format != params_.dst_format) {
+        last_error_ = "目标帧规格与转换参数不匹配";
+        return false;
+    }
+
+    int ret = sws_scale(sws_ctx_,
+                        src_frame->data, src_frame->linesize,
+                        0, src_frame->height,
+                        dst_frame->data, dst_frame->linesize);
+    if (ret <= 0) {
+        last_error_ = "sws_scale 转换失败";
+        return false;
+    }
+
+    // 保留时间戳和颜色信息，便于下游同步
+    dst_frame->pts = src_frame->pts;
+    dst_frame->best_effort_timestamp = src_frame->best_effort_timestamp;
+    dst_frame->sample_aspect_ratio = src_frame->sample_aspect_ratio;
+    return true;
+}
+
+size_t FFmpegVideoConverter::getOutputFrameSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int size = av_image_get_buffer_size(params_.dst_format, params_.dst_width, params_.dst_height, 32);
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+bool FFmpegVideoConverter::reconfigure(const VideoConvertParams& params) {
+    return initialize(params);
+}
+
+VideoConvertParams FFmpegVideoConverter::getParams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return params_;
+}
+
+std::string FFmpegVideoConverter::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+bool FFmpegVideoConverter::ensureContext(int src_width, int src_height, AVPixelFormat src_format) {
+    if (sws_ctx_ && src_width == params_.src_width &&
+        src_height == params_.src_height && src_format == params_.src_format) {
+        return true;
+    }
+
+    params_.src_width = src_width;
+    params_.src_height = src_height;
+    params_.src_format = src_format;
+
+    // sws_getCachedContext 在参数不变时复用已有上下文
+    sws_ctx_ = sws_getCachedContext(sws_ctx_,
+                                    params_.src_width, params_.src_height, params_.src_format,
+                                    params_.dst_width, params_.dst_height, params_.dst_format,
+                                    params_.sws_flags, nullptr, nullptr, nullptr);
+    if (!sws_ctx_) {
+        last_error_ = "无法创建 SwsContext";
+        return false;
+    }
+    return true;
+}
+
+} // namespace media
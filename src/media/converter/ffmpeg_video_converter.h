@@ -0,0 +1,66 @@
+#ifndef FFMPEG_VIDEO_CONVERTER_H
+#define FFMPEG_VIDEO_CONVERTER_H
+
+#include "video_convert.h"
+#include <mutex>
+#include <string>
+
+namespace media {
+
+/**
+ * @brief 基于libswscale的视频格式转换器
+ *
+ * 设计特点：
+ * 1. SIMD加速：swscale运行时检测CPU特性（SSE/AVX2/NEON），目标缓冲区保持32字节对齐以走快速路径
+ * 2. 上下文缓存：使用sws_getCachedContext，分辨率变化时才重建上下文
+ * 3. 零分配：目标帧由调用方提供（通常来自FFmpegFrameAllocator池），转换过程不分配内存
+ */
+class FFmpegVideoConverter : public IVideoConverter {
+public:
+    FFmpegVideoConverter();
+    ~FFmpegVideoConverter() override;
+
+    FFmpegVideoConverter(const FFmpegVideoConverter&) = delete;
+    FFmpegVideoConverter& operator=(const FFmpegVideoConverter&) = delete;
+
+    // 实现IVideoConverter接口
+    bool initialize(const VideoConvertParams& params) override;
+    bool convert(const AVFrame* src_frame, AVFrame* dst_frame) override;
+    size_t getOutputFrameSize() const override;
+    bool reconfigure(const VideoConvertParams& params) override;
+
+    /**
+     * @brief 批量转换
+     *
+     * 整批只加一次锁，同规格的源帧复用同一个SwsContext，适合缩略图等批处理场景。
+     * @param src_frames 源帧数组
+     * @param dst_frames 目标帧数组（规格必须与转换参数一致）
+     * @param count 帧数
+     * @return 成功转换的帧数，遇到第一个失败即停止
+     */
+    size_t convertBatch(const AVFrame* const* src_frames, AVFrame* const* dst_frames, size_t count);
+
+    /**
+     * @brief 获取当前转换参数
+     */
+    VideoConvertParams getParams() const;
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    bool convertLocked(const AVFrame* src_frame, AVFrame* dst_frame);
+    bool ensureContext(int src_width, int src_height, AVPixelFormat src_format);
+
+private:
+    mutable std::mutex mutex_;
+    VideoConvertParams params_;
+    SwsContext* sws_ctx_ = nullptr;
+    std::string last_error_;
+};
+
+} // namespace media
+
+#endif // FFMPEG_VIDEO_CONVERTER_H
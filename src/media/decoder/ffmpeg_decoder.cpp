@@ -0,0 +1,435 @@
+#include "ffmpeg_decoder.h"
+
+#include "../allocator/ffmpeg_allocator/buffer_tracking.h"
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+namespace media {
+
+FFmpegVideoDecoder::FFmpegVideoDecoder(const Config& config)
+    : config_(config) {
+}
+
+FFmpegVideoDecoder::~FFmpegVideoDecoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+}
+
+bool FFmpegVideoDecoder::initialize(const AVCodecParameters* codecpar) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+
+    if (!codecpar || codecpar->codec_type != AVMEDIA_TYPE_VIDEO) {
+        last_error_ = "无效的视频编码参数";
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec) {
+        last_error_ = std::string("找不到解码器: ") + avcodec_get_name(codecpar->codec_id);
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_) {
+        last_error_ = "无法分配解码器上下文";
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    int ret = avcodec_parameters_to_context(codec_ctx_, codecpar);
+    if (ret < 0) {
+        reportError("复制编码参数失败: ", ret);
+        close();
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    codec_ctx_->thread_count = config_.thread_count;
+    if (config_.low_delay) {
+        codec_ctx_->thread_type = FF_THREAD_SLICE;
+        codec_ctx_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    } else {
+        codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+
+    if (config_.keyframe_only) {
+        // 关键帧模式：跳过非关键帧和环路滤波，允许不符合规范的加速
+        codec_ctx_->skip_frame = AVDISCARD_NONKEY;
+        codec_ctx_->skip_loop_filter = AVDISCARD_ALL;
+        codec_ctx_->flags2 |= AV_CODEC_FLAG2_FAST;
+    }
+
+    installDecoderTracking(codec_ctx_, &config_.memory_tracker);
+
+    ret = avcodec_open2(codec_ctx_, codec, nullptr);
+    if (ret < 0) {
+        reportError("打开解码器失败: ", ret);
+        close();
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    stats_ = DecoderStats{};
+    total_decode_ms_ = 0.0;
+    fps_window_start_ = std::chrono::steady_clock::now();
+    fps_window_frames_ = 0;
+    state_ = DecoderState::Ready;
+    return true;
+}
+
+bool FFmpegVideoDecoder::sendPacket(AVPacket* packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!codec_ctx_) {
+        last_error_ = "解码器未初始化";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // packet为nullptr表示进入刷新（排空）阶段
+    int ret = avcodec_send_packet(codec_ctx_, packet);
+    if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        stats_.decode_errors++;
+        reportError("发送数据包失败: ", ret);
+        return false;
+    }
+    state_ = packet ? DecoderState::Decoding : DecoderState::Flushing;
+
+    total_decode_ms_ += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // 异步模式：直接把解码出的帧交给回调
+    if (frame_callback_) {
+        FrameCallback callback = frame_callback_;
+        AVFrame* frame = av_frame_alloc();
+        while (frame && receiveFrameLocked(frame)) {
+            lock.unlock();
+            callback(frame);
+            lock.lock();
+            av_frame_unref(frame);
+        }
+        av_frame_free(&frame);
+    }
+    return ret != AVERROR(EAGAIN);
+}
+
+bool FFmpegVideoDecoder::receiveFrame(AVFrame* frame) {
+    if (!frame) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return receiveFrameLocked(frame);
+}
+
+bool FFmpegVideoDecoder::receiveFrameLocked(AVFrame* frame) {
+    if (!codec_ctx_) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int ret = avcodec_receive_frame(codec_ctx_, frame);
+    auto now = std::chrono::steady_clock::now();
+    total_decode_ms_ += std::chrono::duration<double, std::milli>(now - start).count();
+
+    if (ret == AVERROR(EAGAIN)) {
+        return false;
+    }
+    if (ret == AVERROR_EOF) {
+        state_ = DecoderState::Ready;
+        return false;
+    }
+    if (ret < 0) {
+        stats_.decode_errors++;
+        reportError("接收帧失败: ", ret);
+        return false;
+    }
+
+    stats_.frames_decoded++;
+    stats_.avg_decode_time = total_decode_ms_ / stats_.frames_decoded;
+
+    // 每秒刷新一次实时帧率
+    fps_window_frames_++;
+    double window_s = std::chrono::duration<double>(now - fps_window_start_).count();
+    if (window_s >= 1.0) {
+        stats_.fps = fps_window_frames_ / window_s;
+        fps_window_frames_ = 0;
+        fps_window_start_ = now;
+    }
+    return true;
+}
+
+void FFmpegVideoDecoder::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (codec_ctx_) {
+        avcodec_flush_buffers(codec_ctx_);
+        state_ = DecoderState::Ready;
+    }
+}
+
+DecoderState FFmpegVideoDecoder::getState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+DecoderStats FFmpegVideoDecoder::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FFmpegVideoDecoder::setFrameCallback(FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_callback_ = std::move(callback);
+}
+
+void FFmpegVideoDecoder::setErrorCallback(ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_callback_ = std::move(callback);
+}
+
+bool FFmpegVideoDecoder::supportsHardwareAcceleration() const {
+    return false;
+}
+
+bool FFmpegVideoDecoder::enableHardwareAcceleration(AVHWDeviceType device_type) {
+    (void)device_type;
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = "暂不支持硬件加速";
+    return false;
+}
+
+void FFmpegVideoDecoder::setSkipFrame(AVDiscard discard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (codec_ctx_) {
+        codec_ctx_->skip_frame = discard;
+        codec_ctx_->skip_loop_filter = discard;
+    }
+}
+
+std::string FFmpegVideoDecoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FFmpegVideoDecoder::close() {
+    if (codec_ctx_) {
+        avcodec_free_context(&codec_ctx_);
+    }
+    state_ = DecoderState::Uninitialized;
+}
+
+void FFmpegVideoDecoder::reportError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    last_error_ = prefix + error_buf;
+    if (error_callback_) {
+        error_callback_(last_error_);
+    }
+}
+
+// ============ FFmpegAudioDecoder ============
+
+FFmpegAudioDecoder::FFmpegAudioDecoder() = default;
+
+FFmpegAudioDecoder::~FFmpegAudioDecoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+}
+
+bool FFmpegAudioDecoder::initialize(const AVCodecParameters* codecpar) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+
+    if (!codecpar || codecpar->codec_type != AVMEDIA_TYPE_AUDIO) {
+        last_error_ = "无效的音频编码参数";
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec) {
+        last_error_ = std::string("找不到解码器: ") + avcodec_get_name(codecpar->codec_id);
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_) {
+        last_error_ = "无法分配解码器上下文";
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    int ret = avcodec_parameters_to_context(codec_ctx_, codecpar);
+    if (ret < 0) {
+        reportError("复制编码参数失败: ", ret);
+        close();
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    installDecoderTracking(codec_ctx_, &memory_tracker_);
+
+    ret = avcodec_open2(codec_ctx_, codec, nullptr);
+    if (ret < 0) {
+        reportError("打开解码器失败: ", ret);
+        close();
+        state_ = DecoderState::Error;
+        return false;
+    }
+
+    stats_ = DecoderStats{};
+    total_decode_ms_ = 0.0;
+    state_ = DecoderState::Ready;
+    return true;
+}
+
+bool FFmpegAudioDecoder::sendPacket(AVPacket* packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!codec_ctx_) {
+        last_error_ = "解码器未初始化";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int ret = avcodec_send_packet(codec_ctx_, packet);
+    if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        stats_.decode_errors++;
+        reportError("发送数据包失败: ", ret);
+        return false;
+    }
+    state_ = packet ? DecoderState::Decoding : DecoderState::Flushing;
+    total_decode_ms_ += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (frame_callback_) {
+        FrameCallback callback = frame_callback_;
+        AVFrame* frame = av_frame_alloc();
+        while (frame && receiveFrameLocked(frame)) {
+            lock.unlock();
+            callback(frame);
+            lock.lock();
+            av_frame_unref(frame);
+        }
+        av_frame_free(&frame);
+    }
+    return ret != AVERROR(EAGAIN);
+}
+
+bool FFmpegAudioDecoder::receiveFrame(AVFrame* frame) {
+    if (!frame) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return receiveFrameLocked(frame);
+}
+
+bool FFmpegAudioDecoder::receiveFrameLocked(AVFrame* frame) {
+    if (!codec_ctx_) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int ret = avcodec_receive_frame(codec_ctx_, frame);
+    total_decode_ms_ += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (ret == AVERROR(EAGAIN)) {
+        return false;
+    }
+    if (ret == AVERROR_EOF) {
+        state_ = DecoderState::Ready;
+        return false;
+    }
+    if (ret < 0) {
+        stats_.decode_errors++;
+        reportError("接收帧失败: ", ret);
+        return false;
+    }
+
+    stats_.frames_decoded++;
+    stats_.avg_decode_time = total_decode_ms_ / stats_.frames_decoded;
+    return true;
+}
+
+void FFmpegAudioDecoder::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (codec_ctx_) {
+        avcodec_flush_buffers(codec_ctx_);
+        state_ = DecoderState::Ready;
+    }
+}
+
+DecoderState FFmpegAudioDecoder::getState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+DecoderStats FFmpegAudioDecoder::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FFmpegAudioDecoder::setFrameCallback(FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_callback_ = std::move(callback);
+}
+
+void FFmpegAudioDecoder::setErrorCallback(ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_callback_ = std::move(callback);
+}
+
+void FFmpegAudioDecoder::setMemoryTracker(std::shared_ptr<MemoryTracker> tracker) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_tracker_ = std::move(tracker);
+}
+
+std::string FFmpegAudioDecoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FFmpegAudioDecoder::close() {
+    if (codec_ctx_) {
+        avcodec_free_context(&codec_ctx_);
+    }
+    state_ = DecoderState::Uninitialized;
+}
+
+void FFmpegAudioDecoder::reportError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    last_error_ = prefix + error_buf;
+    if (error_callback_) {
+        error_callback_(last_error_);
+    }
+}
+
+// ============ DecoderFactory ============
+
+std::unique_ptr<IVideoDecoder> DecoderFactory::createVideoDecoder(const AVCodecParameters* codecpar) {
+    auto decoder = std::make_unique<FFmpegVideoDecoder>();
+    if (!decoder->initialize(codecpar)) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+std::unique_ptr<IAudioDecoder> DecoderFactory::createAudioDecoder(const AVCodecParameters* codecpar) {
+    auto decoder = std::make_unique<FFmpegAudioDecoder>();
+    if (!decoder->initialize(codecpar)) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+bool DecoderFactory::isCodecSupported(AVCodecID codec_id) {
+    return avcodec_find_decoder(codec_id) != nullptr;
+}
+
+} // namespace media
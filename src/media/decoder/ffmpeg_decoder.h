@@ -0,0 +1,153 @@
+#ifndef FFMPEG_DECODER_H
+#define FFMPEG_DECODER_H
+
+#include "video_decoder.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class MemoryTracker;
+
+namespace media {
+
+/**
+ * @brief 基于libavcodec的视频解码器
+ *
+ * 设计特点：
+ * 1. 标准send/receive模型：EAGAIN/EOF不视为错误
+ * 2. 关键帧模式：skip_frame=AVDISCARD_NONKEY，只解码关键帧（缩略图、快进预览）
+ * 3. 多线程：帧级+片级多线程解码，线程数可配置
+ * 4. 统计：解码帧数、错误数、平均解码耗时
+ */
+class FFmpegVideoDecoder : public IVideoDecoder {
+public:
+    /**
+     * @brief 解码器配置
+     */
+    struct Config {
+        int thread_count;           // 解码线程数，0表示自动
+        bool keyframe_only;         // 只解码关键帧
+        bool low_delay;             // 低延迟模式（关闭帧级多线程带来的输出延迟）
+        std::shared_ptr<MemoryTracker> memory_tracker;  // 非空时帧缓冲的分配/释放写入跟踪器
+
+        Config()
+            : thread_count(0)
+            , keyframe_only(false)
+            , low_delay(false)
+        {}
+    };
+
+public:
+    explicit FFmpegVideoDecoder(const Config& config = Config{});
+    ~FFmpegVideoDecoder() override;
+
+    FFmpegVideoDecoder(const FFmpegVideoDecoder&) = delete;
+    FFmpegVideoDecoder& operator=(const FFmpegVideoDecoder&) = delete;
+
+    // 实现IVideoDecoder接口
+    bool initialize(const AVCodecParameters* codecpar) override;
+    bool sendPacket(AVPacket* packet) override;
+    bool receiveFrame(AVFrame* frame) override;
+    void flush() override;
+    DecoderState getState() const override;
+    DecoderStats getStats() const override;
+    void setFrameCallback(FrameCallback callback) override;
+    void setErrorCallback(ErrorCallback callback) override;
+    bool supportsHardwareAcceleration() const override;
+    bool enableHardwareAcceleration(AVHWDeviceType device_type) override;
+
+    /**
+     * @brief 运行时切换丢帧级别（下一个数据包生效）
+     *
+     * 环路滤波使用同一级别：被保留下来的非参考帧也跳过去块滤波，倍速播放时进一步省CPU。
+     * @param discard 丢弃级别：AVDISCARD_DEFAULT/AVDISCARD_NONREF/AVDISCARD_NONKEY
+     */
+    void setSkipFrame(AVDiscard discard);
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    void close();
+    void reportError(const std::string& prefix, int errnum);
+    bool receiveFrameLocked(AVFrame* frame);
+
+private:
+    Config config_;
+    AVCodecContext* codec_ctx_ = nullptr;
+
+    mutable std::mutex mutex_;
+    DecoderState state_ = DecoderState::Uninitialized;
+    std::string last_error_;
+
+    FrameCallback frame_callback_;
+    ErrorCallback error_callback_;
+
+    // 统计
+    DecoderStats stats_;
+    double total_decode_ms_ = 0.0;
+    std::chrono::steady_clock::time_point fps_window_start_;
+    uint64_t fps_window_frames_ = 0;
+};
+
+/**
+ * @brief 基于libavcodec的音频解码器
+ *
+ * 与FFmpegVideoDecoder相同的send/receive模型和统计口径；输出保持解码器原生格式，
+ * 由音频转换器负责重采样到输出格式。
+ */
+class FFmpegAudioDecoder : public IAudioDecoder {
+public:
+    FFmpegAudioDecoder();
+    ~FFmpegAudioDecoder() override;
+
+    FFmpegAudioDecoder(const FFmpegAudioDecoder&) = delete;
+    FFmpegAudioDecoder& operator=(const FFmpegAudioDecoder&) = delete;
+
+    // 实现IAudioDecoder接口
+    bool initialize(const AVCodecParameters* codecpar) override;
+    bool sendPacket(AVPacket* packet) override;
+    bool receiveFrame(AVFrame* frame) override;
+    void flush() override;
+    DecoderState getState() const override;
+    DecoderStats getStats() const override;
+    void setFrameCallback(FrameCallback callback) override;
+    void setErrorCallback(ErrorCallback callback) override;
+
+    /**
+     * @brief 帧缓冲的分配/释放写入跟踪器（initialize之前设置）
+     */
+    void setMemoryTracker(std::shared_ptr<MemoryTracker> tracker);
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    void close();
+    void reportError(const std::string& prefix, int errnum);
+    bool receiveFrameLocked(AVFrame* frame);
+
+private:
+    AVCodecContext* codec_ctx_ = nullptr;
+    std::shared_ptr<MemoryTracker> memory_tracker_;
+
+    mutable std::mutex mutex_;
+    DecoderState state_ = DecoderState::Uninitialized;
+    std::string last_error_;
+
+    FrameCallback frame_callback_;
+    ErrorCallback error_callback_;
+
+    DecoderStats stats_;
+    double total_decode_ms_ = 0.0;
+};
+
+} // namespace media
+
+#endif // FFMPEG_DECODER_H
@@ -35,8 +35,14 @@ struct StreamInfo {
     int channels = 0;
     AVSampleFormat sample_fmt = AV_SAMPLE_FMT_NONE;
     
+    // 字幕/数据流特有信息
+    std::string language;              // 元数据language（ISO 639-2），没有时为空
+    uint32_t codec_tag = 0;            // 数据流常靠codec_tag区分（如KLVA）
+    
     bool isVideo() const { return type == AVMEDIA_TYPE_VIDEO; }
     bool isAudio() const { return type == AVMEDIA_TYPE_AUDIO; }
+    bool isSubtitle() const { return type == AVMEDIA_TYPE_SUBTITLE; }
+    bool isData() const { return type == AVMEDIA_TYPE_DATA; }
     bool isValid() const { return index >= 0 && type != AVMEDIA_TYPE_UNKNOWN; }
 };
 
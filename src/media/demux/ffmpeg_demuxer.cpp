@@ -0,0 +1,264 @@
+#include "ffmpeg_demuxer.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+namespace media {
+
+FFmpegDemuxer::FFmpegDemuxer() = default;
+
+FFmpegDemuxer::~FFmpegDemuxer() {
+    stopAsyncRead();
+}
+
+bool FFmpegDemuxer::initialize(std::shared_ptr<IInputSource> input_source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!input_source) {
+        last_error_ = "输入源为空";
+        return false;
+    }
+
+    AVFormatContext* format_ctx = input_source->getFormatContext();
+    if (!format_ctx) {
+        last_error_ = "输入源未打开";
+        return false;
+    }
+
+    input_source_ = std::move(input_source);
+    format_ctx_ = format_ctx;
+    eof_.store(false);
+    last_error_.clear();
+    return true;
+}
+
+std::vector<StreamInfo> FFmpegDemuxer::getStreamInfos() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<StreamInfo> infos;
+    if (!format_ctx_) {
+        return infos;
+    }
+
+    infos.reserve(format_ctx_->nb_streams);
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; ++i) {
+        const AVStream* stream = format_ctx_->streams[i];
+        const AVCodecParameters* par = stream->codecpar;
+
+        StreamInfo info;
+        info.index = static_cast<int>(i);
+        info.type = par->codec_type;
+        info.codec_id = par->codec_id;
+        info.codec_name = avcodec_get_name(par->codec_id);
+        info.time_base = stream->time_base;
+        info.duration = stream->duration;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            info.width = par->width;
+            info.height = par->height;
+            info.pix_fmt = static_cast<AVPixelFormat>(par->format);
+            info.frame_rate = stream->avg_frame_rate;
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            info.sample_rate = par->sample_rate;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100)
+            info.channels = par->ch_layout.nb_channels;
+#else
+            info.channels = par->channels;
+#endif
+            info.sample_fmt = static_cast<AVSampleFormat>(par->format);
+        } else if (par->codec_type == AVMEDIA_TYPE_SUBTITLE || par->codec_type == AVMEDIA_TYPE_DATA) {
+            const AVDictionaryEntry* language = av_dict_get(stream->metadata, "language", nullptr, 0);
+            if (language) {
+                info.language = language->value;
+            }
+            info.codec_tag = par->codec_tag;
+        }
+
+        infos.push_back(info);
+    }
+    return infos;
+}
+
+int FFmpegDemuxer::findStream(AVMediaType type) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_) {
+        return -1;
+    }
+    int index = av_find_best_stream(format_ctx_, type, -1, -1, nullptr, 0);
+    return index >= 0 ? index : -1;
+}
+
+bool FFmpegDemuxer::readPacket(AVPacket* packet) {
+    if (!packet) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_) {
+        last_error_ = "解封装器未初始化";
+        return false;
+    }
+
+    int ret = av_read_frame(format_ctx_, packet);
+    if (ret == AVERROR_EOF) {
+        eof_.store(true);
+        return false;
+    }
+    if (ret < 0) {
+        setError("读取数据包失败: ", ret);
+        return false;
+    }
+    return true;
+}
+
+bool FFmpegDemuxer::seek(int stream_index, int64_t timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_) {
+        last_error_ = "解封装器未初始化";
+        return false;
+    }
+
+    // 向后对齐到关键帧，保证seek后第一个包可以独立解码
+    int ret = av_seek_frame(format_ctx_, stream_index, timestamp, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+        setError("seek失败: ", ret);
+        return false;
+    }
+    eof_.store(false);
+    return true;
+}
+
+bool FFmpegDemuxer::seekToTime(int64_t timestamp_us) {
+    int64_t start_time = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (format_ctx_ && format_ctx_->start_time != AV_NOPTS_VALUE) {
+            start_time = format_ctx_->start_time;
+        }
+    }
+    // stream_index为-1时时间戳以AV_TIME_BASE（微秒）为单位
+    return seek(-1, start_time + timestamp_us);
+}
+
+std::vector<int64_t> FFmpegDemuxer::buildKeyframeIndex(int stream_index) {
+    std::vector<int64_t> keyframes;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_ || stream_index < 0 ||
+        stream_index >= static_cast<int>(format_ctx_->nb_streams)) {
+        last_error_ = "无效的流索引";
+        return keyframes;
+    }
+    AVStream* stream = format_ctx_->streams[stream_index];
+
+    // 1. 容器索引
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+    const int entry_count = avformat_index_get_entries_count(stream);
+    for (int i = 0; i < entry_count; ++i) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME)) {
+            keyframes.push_back(entry->timestamp);
+        }
+    }
+#else
+    for (int i = 0; i < stream->nb_index_entries; ++i) {
+        const AVIndexEntry& entry = stream->index_entries[i];
+        if (entry.flags & AVINDEX_KEYFRAME) {
+            keyframes.push_back(entry.timestamp);
+        }
+    }
+#endif
+
+    // 2. 没有索引时扫描数据包
+    if (keyframes.empty()) {
+        AVPacket* packet = av_packet_alloc();
+        if (av_seek_frame(format_ctx_, stream_index, INT64_MIN, AVSEEK_FLAG_BACKWARD) < 0) {
+            avformat_seek_file(format_ctx_, -1, INT64_MIN, 0, INT64_MAX, 0);
+        }
+        while (packet && av_read_frame(format_ctx_, packet) >= 0) {
+            if (packet->stream_index == stream_index && (packet->flags & AV_PKT_FLAG_KEY)) {
+                int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+                if (ts != AV_NOPTS_VALUE) {
+                    keyframes.push_back(ts);
+                }
+            }
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+
+        avformat_seek_file(format_ctx_, -1, INT64_MIN, 0, INT64_MAX, 0);
+        eof_.store(false);
+    }
+
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+    return keyframes;
+}
+
+int64_t FFmpegDemuxer::getDuration() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_ || format_ctx_->duration == AV_NOPTS_VALUE) {
+        return -1;
+    }
+    return format_ctx_->duration;
+}
+
+const AVCodecParameters* FFmpegDemuxer::getCodecParameters(int stream_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_ || stream_index < 0 ||
+        stream_index >= static_cast<int>(format_ctx_->nb_streams)) {
+        return nullptr;
+    }
+    return format_ctx_->streams[stream_index]->codecpar;
+}
+
+void FFmpegDemuxer::startAsyncRead(PacketCallback callback) {
+    stopAsyncRead();
+
+    packet_callback_ = std::move(callback);
+    async_running_.store(true);
+    read_thread_ = std::thread(&FFmpegDemuxer::asyncReadLoop, this);
+}
+
+void FFmpegDemuxer::stopAsyncRead() {
+    async_running_.store(false);
+    if (read_thread_.joinable()) {
+        read_thread_.join();
+    }
+}
+
+std::string FFmpegDemuxer::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FFmpegDemuxer::asyncReadLoop() {
+    AVPacket* packet = av_packet_alloc();
+    if (!packet) {
+        async_running_.store(false);
+        return;
+    }
+
+    while (async_running_.load()) {
+        if (!readPacket(packet)) {
+            break;
+        }
+        if (packet_callback_) {
+            packet_callback_(packet, packet->stream_index);
+        }
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+    async_running_.store(false);
+}
+
+void FFmpegDemuxer::setError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    last_error_ = prefix + error_buf;
+}
+
+} // namespace media
@@ -0,0 +1,89 @@
+#ifndef FFMPEG_DEMUXER_H
+#define FFMPEG_DEMUXER_H
+
+#include "demuxer.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace media {
+
+/**
+ * @brief 基于libavformat的解封装器
+ *
+ * 设计特点：
+ * 1. 复用输入源：直接使用IInputSource打开的AVFormatContext，不重复探测
+ * 2. 线程安全：读包与seek互斥，异步读取线程可随时停止
+ * 3. 时间戳统一：seek接口接受流时间基下的时间戳，另提供按微秒seek的便捷方法
+ */
+class FFmpegDemuxer : public IDemuxer {
+public:
+    FFmpegDemuxer();
+    ~FFmpegDemuxer() override;
+
+    FFmpegDemuxer(const FFmpegDemuxer&) = delete;
+    FFmpegDemuxer& operator=(const FFmpegDemuxer&) = delete;
+
+    // 实现IDemuxer接口
+    bool initialize(std::shared_ptr<IInputSource> input_source) override;
+    std::vector<StreamInfo> getStreamInfos() const override;
+    int findStream(AVMediaType type) const override;
+    bool readPacket(AVPacket* packet) override;
+    bool seek(int stream_index, int64_t timestamp) override;
+    const AVCodecParameters* getCodecParameters(int stream_index) const override;
+    void startAsyncRead(PacketCallback callback) override;
+    void stopAsyncRead() override;
+
+    /**
+     * @brief 按微秒seek到目标位置之前最近的关键帧
+     * @param timestamp_us 目标时间（微秒，相对文件起点）
+     */
+    bool seekToTime(int64_t timestamp_us);
+
+    /**
+     * @brief 构建关键帧索引（seek用时间戳，流时间基）
+     *
+     * 优先使用容器自带索引（MP4/MKV打开后即完整）；没有索引时顺序扫描一遍数据包，
+     * 扫描只读包不解码，完成后回到文件开头。
+     * @param stream_index 流索引
+     * @return 升序排列的关键帧时间戳
+     */
+    std::vector<int64_t> buildKeyframeIndex(int stream_index);
+
+    /**
+     * @brief 媒体总时长（微秒），未知返回-1
+     */
+    int64_t getDuration() const;
+
+    /**
+     * @brief 是否已读到文件末尾
+     */
+    bool isEndOfStream() const { return eof_.load(); }
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    void asyncReadLoop();
+    void setError(const std::string& prefix, int errnum);
+
+private:
+    std::shared_ptr<IInputSource> input_source_;
+    AVFormatContext* format_ctx_ = nullptr;     // 由输入源持有
+
+    mutable std::mutex mutex_;                  // 保护format_ctx_读包/seek
+    std::string last_error_;
+    std::atomic<bool> eof_{false};
+
+    // 异步读取
+    std::thread read_thread_;
+    std::atomic<bool> async_running_{false};
+    PacketCallback packet_callback_;
+};
+
+} // namespace media
+
+#endif // FFMPEG_DEMUXER_H
@@ -0,0 +1,311 @@
+#include "encoder_stage.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+/**
+ * @brief 暂存帧持有者
+ * 成员按声明逆序析构：先归还帧，再释放分配器（编码器可能比本阶段的分配器活得久）
+ */
+struct StagingFrame {
+    std::shared_ptr<FFmpegFrameAllocator> allocator;
+    ffmpeg::AVFrameSharedPtr frame;
+};
+
+void releaseStagingFrame(void* opaque, uint8_t* data) {
+    (void)data;
+    delete static_cast<StagingFrame*>(opaque);
+}
+
+/**
+ * @brief 池化帧包装成引用计数帧
+ *
+ * 分配器的帧没有AVBufferRef，直接交给libavcodec会被整帧拷贝一次；
+ * 包一层buf（释放时归还池）后编码器内部的av_frame_ref只增加引用。
+ */
+ffmpeg::AVFrameSharedPtr wrapPooledFrame(const std::shared_ptr<FFmpegFrameAllocator>& allocator,
+                                         const ffmpeg::AVFrameSharedPtr& pooled) {
+    // buf要覆盖整块图像缓冲区：av_frame_make_writable、拷贝等路径按buf->size判断
+    uint8_t* planes[4] = {};
+    const int buffer_size = av_image_fill_pointers(planes, static_cast<AVPixelFormat>(pooled->format),
+                                                   pooled->height, pooled->data[0], pooled->linesize);
+    if (buffer_size <= 0) {
+        return nullptr;
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        return nullptr;
+    }
+    auto* holder = new StagingFrame{allocator, pooled};
+    frame->buf[0] = av_buffer_create(pooled->data[0], buffer_size, &releaseStagingFrame, holder, 0);
+    if (!frame->buf[0]) {
+        delete holder;
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+        frame->data[i] = pooled->data[i];
+        frame->linesize[i] = pooled->linesize[i];
+    }
+    frame->width = pooled->width;
+    frame->height = pooled->height;
+    frame->format = pooled->format;
+    frame->pts = pooled->pts;
+    frame->sample_aspect_ratio = pooled->sample_aspect_ratio;
+    return ffmpeg::SharedPointerFactory::wrapFrame(frame);
+}
+
+} // namespace
+
+EncoderStage::EncoderStage(const Config& config)
+    : config_(config)
+    , encoder_(config.encoder)
+    , encode_metric_(MetricsRegistry::instance().latency("stage.encode"))
+    , queue_metric_(MetricsRegistry::instance().gauge("queue.encode"))
+    , drop_metric_(MetricsRegistry::instance().counter("drop.encode")) {
+    config_.queue_frames = std::max<size_t>(config_.queue_frames, 1);
+}
+
+EncoderStage::~EncoderStage() {
+    stop();
+}
+
+bool EncoderStage::start(const VideoEncodeFormat& input) {
+    stop();
+
+    if (!input.isValid()) {
+        setError("无效的编码输入格式");
+        return false;
+    }
+
+    format_ = input;
+    format_.pix_fmt = config_.output_format;
+    format_.width = config_.output_width > 0 ? config_.output_width : input.width;
+    format_.height = config_.output_height > 0 ? config_.output_height : input.height;
+    if (!encoder_.initialize(format_)) {
+        setError(encoder_.getLastError());
+        return false;
+    }
+
+    // 缺pts时按帧率推算
+    frame_step_ = input.frame_rate.num > 0 && input.frame_rate.den > 0
+        ? std::max<int64_t>(1, av_rescale_q(1, av_inv_q(input.frame_rate), input.time_base))
+        : 1;
+    next_pts_ = 0;
+    last_pts_ = AV_NOPTS_VALUE;
+
+    // 暂存池：队列中的帧 + 编码器内部持有的帧（前瞻/帧级线程），不够时分配器临时分配
+    auto allocator_config = std::make_unique<FFmpegAllocatorConfig>();
+    allocator_config->frames_per_pool = config_.queue_frames + 4;
+    allocator_config->max_pools = 2;
+    staging_allocator_ = std::make_shared<FFmpegFrameAllocator>(std::move(allocator_config));
+    converter_ = std::make_unique<FFmpegVideoConverter>();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        finishing_ = false;
+        stopping_ = false;
+        failed_ = false;
+        last_error_.clear();
+    }
+    running_.store(true);
+    thread_ = std::thread(&EncoderStage::encodeLoop, this);
+    return true;
+}
+
+bool EncoderStage::submit(ffmpeg::AVFrameSharedPtr frame) {
+    if (!frame) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_.load() || stopping_ || finishing_ || failed_) {
+        return false;
+    }
+    if (queue_.size() >= config_.queue_frames) {
+        if (config_.drop_when_full) {
+            lock.unlock();
+            encoder_.addDroppedFrames(1);
+            drop_metric_.add();
+            return false;
+        }
+        // 编码跟不上：让解码端等待，而不是无限堆积解码帧
+        stats_.submit_waits++;
+        not_full_.wait(lock, [this]() { return stopping_ || queue_.size() < config_.queue_frames; });
+        if (stopping_) {
+            return false;
+        }
+    }
+
+    queue_.push_back(std::move(frame));
+    stats_.frames_submitted++;
+    const size_t depth = queue_.size();
+    if (depth > stats_.max_queue_depth.load()) {
+        stats_.max_queue_depth.store(depth);
+    }
+    queue_metric_.set(static_cast<double>(depth));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+bool EncoderStage::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finishing_ = true;
+    }
+    not_empty_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !failed_;
+}
+
+void EncoderStage::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+    queue_metric_.set(0.0);
+}
+
+std::string EncoderStage::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void EncoderStage::encodeLoop() {
+    AVPacket* packet = av_packet_alloc();
+    while (packet) {
+        ffmpeg::AVFrameSharedPtr frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]() { return stopping_ || finishing_ || !queue_.empty(); });
+            if (stopping_) {
+                break;
+            }
+            if (!queue_.empty()) {
+                frame = std::move(queue_.front());
+                queue_.pop_front();
+                queue_metric_.set(static_cast<double>(queue_.size()));
+            }
+        }
+        not_full_.notify_one();
+
+        if (!frame) {
+            // 队列已空且要求结束：排空编码器（前瞻和B帧还压着若干帧）
+            if (!encoder_.sendFrame(nullptr)) {
+                setError(encoder_.getLastError());
+            }
+            drainPackets(packet);
+            break;
+        }
+
+        ScopedLatency timing(encode_metric_);
+        ffmpeg::AVFrameSharedPtr prepared = prepareFrame(frame);
+        // 释放解码帧引用，尽早归还解码器的帧池
+        frame.reset();
+        if (!prepared) {
+            encoder_.addDroppedFrames(1);
+            continue;
+        }
+        // 每次发送后都取空数据包，发送不会遇到EAGAIN，失败即为编码错误
+        if (!encoder_.sendFrame(prepared.get())) {
+            setError(encoder_.getLastError());
+        }
+        prepared.reset();
+        drainPackets(packet);
+    }
+    av_packet_free(&packet);
+}
+
+ffmpeg::AVFrameSharedPtr EncoderStage::prepareFrame(const ffmpeg::AVFrameSharedPtr& frame) {
+    int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = next_pts_;
+    }
+    if (last_pts_ != AV_NOPTS_VALUE && pts <= last_pts_) {
+        stats_.timestamp_drops++;
+        return nullptr;
+    }
+    last_pts_ = pts;
+    next_pts_ = pts + frame_step_;
+
+    const bool needs_convert = frame->format != format_.pix_fmt || frame->width != format_.width ||
+                               frame->height != format_.height;
+    if (!needs_convert) {
+        if (frame->pts == pts) {
+            return frame;
+        }
+        // 只补时间戳：浅拷贝一份引用，不改调用方的帧
+        AVFrame* clone = av_frame_clone(frame.get());
+        if (!clone) {
+            return nullptr;
+        }
+        clone->pts = pts;
+        return ffmpeg::SharedPointerFactory::wrapFrame(clone);
+    }
+
+    VideoConvertParams params = converter_->getParams();
+    if (params.src_width != frame->width || params.src_height != frame->height ||
+        params.src_format != frame->format || params.dst_width != format_.width ||
+        params.dst_height != format_.height || params.dst_format != format_.pix_fmt) {
+        params.src_width = frame->width;
+        params.src_height = frame->height;
+        params.src_format = static_cast<AVPixelFormat>(frame->format);
+        params.dst_width = format_.width;
+        params.dst_height = format_.height;
+        params.dst_format = format_.pix_fmt;
+        if (!converter_->reconfigure(params)) {
+            setError(converter_->getLastError());
+            return nullptr;
+        }
+    }
+
+    ffmpeg::AVFrameSharedPtr staging =
+        staging_allocator_->allocateSharedFrame(FrameSpec(format_.width, format_.height, format_.pix_fmt));
+    if (!staging || !converter_->convert(frame.get(), staging.get())) {
+        return nullptr;
+    }
+    staging->pts = pts;
+    stats_.frames_converted++;
+    return wrapPooledFrame(staging_allocator_, staging);
+}
+
+void EncoderStage::drainPackets(AVPacket* packet) {
+    while (encoder_.receivePacket(packet)) {
+        if (packet_callback_) {
+            packet_callback_(packet);
+        }
+        av_packet_unref(packet);
+    }
+}
+
+void EncoderStage::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ = true;
+    last_error_ = error;
+}
+
+} // namespace media
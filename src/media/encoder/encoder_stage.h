@@ -0,0 +1,178 @@
+#ifndef ENCODER_STAGE_H
+#define ENCODER_STAGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ffmpeg_encoder.h"
+#include "../converter/ffmpeg_video_converter.h"
+#include "../allocator/ffmpeg_allocator/ffmpeg_frame_allocator.h"
+#include "../../memory/smart_pointers.h"
+#include "../../utils/metrics_registry.h"
+
+namespace media {
+
+/**
+ * @brief 转码管道的编码阶段：独立编码线程 + 有界帧队列
+ *
+ * 设计特点：
+ * 1. 不拷贝帧：提交的是解码帧的共享引用（解码器帧池里的缓冲），队列只持有引用
+ * 2. 格式转换走帧池：输入像素格式或尺寸与编码器不同时，转换到暂存分配器的池化帧，稳定后不再分配
+ * 3. 背压：队列满时提交方等待（归档任务不能丢帧），也可配置为丢帧并计入EncoderStats
+ * 4. 时间戳：输入缺pts时按帧率补齐，不单调的帧丢弃（x264/x265会直接报错）
+ *
+ * submit/finish/stop在一个线程（通常是解码线程）调用；数据包回调在编码线程中调用。
+ */
+class EncoderStage {
+public:
+    /**
+     * @brief 编码阶段配置
+     */
+    struct Config {
+        FFmpegVideoEncoder::Config encoder;
+        AVPixelFormat output_format;        // 编码器输入像素格式
+        int output_width;                   // 输出尺寸，<=0与输入相同
+        int output_height;
+        size_t queue_frames;                // 待编码帧队列长度
+        bool drop_when_full;                // 队列满时丢帧而不是等待
+
+        Config()
+            : output_format(AV_PIX_FMT_YUV420P)
+            , output_width(0)
+            , output_height(0)
+            , queue_frames(8)
+            , drop_when_full(false)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t frames_submitted;
+        uint64_t frames_converted;      // 经过像素格式/尺寸转换的帧
+        uint64_t submit_waits;          // 队列满、提交方等待的次数
+        uint64_t timestamp_drops;       // 时间戳不单调而丢弃的帧
+        size_t max_queue_depth;
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> frames_submitted{0};
+        std::atomic<uint64_t> frames_converted{0};
+        std::atomic<uint64_t> submit_waits{0};
+        std::atomic<uint64_t> timestamp_drops{0};
+        std::atomic<size_t> max_queue_depth{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                frames_submitted.load(),
+                frames_converted.load(),
+                submit_waits.load(),
+                timestamp_drops.load(),
+                max_queue_depth.load()
+            };
+        }
+    };
+
+    using PacketCallback = std::function<void(AVPacket*)>;
+
+public:
+    explicit EncoderStage(const Config& config = Config{});
+    ~EncoderStage();
+
+    EncoderStage(const EncoderStage&) = delete;
+    EncoderStage& operator=(const EncoderStage&) = delete;
+
+    /**
+     * @brief 打开编码器并启动编码线程
+     * @param input 输入帧的尺寸、时间基和帧率（像素格式只用于判断是否需要转换）
+     */
+    bool start(const VideoEncodeFormat& input);
+
+    /**
+     * @brief 提交一帧（只增加引用）
+     * @return 已停止、出错或按配置丢帧时返回false
+     */
+    bool submit(ffmpeg::AVFrameSharedPtr frame);
+
+    /**
+     * @brief 编完队列中的帧并排空编码器，等待编码线程结束
+     * @return 整个过程没有编码错误
+     */
+    bool finish();
+
+    /**
+     * @brief 放弃队列中的帧并停止编码线程
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(); }
+
+    /**
+     * @brief 数据包回调（start之前设置，编码线程中调用）
+     */
+    void setPacketCallback(PacketCallback callback) { packet_callback_ = std::move(callback); }
+
+    /**
+     * @brief 输出流参数与时间基（start之后有效，供封装使用）
+     */
+    bool copyParameters(AVCodecParameters* codecpar) const { return encoder_.copyParameters(codecpar); }
+    AVRational getTimeBase() const { return encoder_.getTimeBase(); }
+
+    EncoderStats getEncoderStats() const { return encoder_.getStats(); }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    const Config& config() const { return config_; }
+    std::string getLastError() const;
+
+private:
+    void encodeLoop();
+    ffmpeg::AVFrameSharedPtr prepareFrame(const ffmpeg::AVFrameSharedPtr& frame);
+    void drainPackets(AVPacket* packet);
+    void setError(const std::string& error);
+
+private:
+    Config config_;
+    FFmpegVideoEncoder encoder_;
+    VideoEncodeFormat format_;              // 编码器的输入格式
+    int64_t frame_step_ = 1;                // 一帧在时间基下的长度
+    int64_t next_pts_ = 0;
+    int64_t last_pts_ = AV_NOPTS_VALUE;
+
+    // 转换只在编码线程使用
+    std::unique_ptr<FFmpegVideoConverter> converter_;
+    std::shared_ptr<FFmpegFrameAllocator> staging_allocator_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<ffmpeg::AVFrameSharedPtr> queue_;
+    bool finishing_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+    std::string last_error_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    PacketCallback packet_callback_;
+
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& encode_metric_;
+    Metric& queue_metric_;
+    Metric& drop_metric_;
+};
+
+} // namespace media
+
+#endif // ENCODER_STAGE_H
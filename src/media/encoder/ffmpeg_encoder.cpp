@@ -0,0 +1,345 @@
+#include "ffmpeg_encoder.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/opt.h>
+}
+
+namespace media {
+
+namespace {
+
+void appendParam(std::string& params, const std::string& param) {
+    if (param.empty()) {
+        return;
+    }
+    if (!params.empty()) {
+        params += ':';
+    }
+    params += param;
+}
+
+} // namespace
+
+FFmpegVideoEncoder::FFmpegVideoEncoder(const Config& config)
+    : config_(config) {
+}
+
+FFmpegVideoEncoder::~FFmpegVideoEncoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+}
+
+const char* FFmpegVideoEncoder::encoderName(EncoderCodec codec) {
+    switch (codec) {
+    case EncoderCodec::H265:
+        return "libx265";
+    case EncoderCodec::AV1:
+        return "libsvtav1";
+    case EncoderCodec::Mpeg4:
+        return "mpeg4";
+    case EncoderCodec::H264:
+    default:
+        return "libx264";
+    }
+}
+
+bool FFmpegVideoEncoder::isAvailable(EncoderCodec codec) {
+    return avcodec_find_encoder_by_name(encoderName(codec)) != nullptr;
+}
+
+bool FFmpegVideoEncoder::initialize(const VideoEncodeFormat& format) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    close();
+
+    if (!format.isValid()) {
+        last_error_ = "无效的编码输入格式";
+        state_ = EncoderState::Error;
+        return false;
+    }
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(encoderName(config_.codec));
+    if (!codec) {
+        last_error_ = std::string("找不到编码器: ") + encoderName(config_.codec);
+        state_ = EncoderState::Error;
+        return false;
+    }
+
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    send_frame_ = av_frame_alloc();
+    if (!codec_ctx_ || !send_frame_) {
+        last_error_ = "无法分配编码器上下文";
+        close();
+        state_ = EncoderState::Error;
+        return false;
+    }
+
+    codec_ctx_->width = format.width;
+    codec_ctx_->height = format.height;
+    codec_ctx_->pix_fmt = format.pix_fmt;
+    codec_ctx_->time_base = format.time_base;
+    codec_ctx_->framerate = format.frame_rate;
+    codec_ctx_->sample_aspect_ratio = format.sample_aspect_ratio;
+    // 输出给封装器用：SPS/PPS放在extradata里
+    codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if (config_.gop_size > 0) {
+        codec_ctx_->gop_size = config_.gop_size;
+    }
+    if (config_.max_b_frames >= 0) {
+        codec_ctx_->max_b_frames = config_.max_b_frames;
+    }
+    if (config_.crf < 0 && config_.bit_rate > 0) {
+        codec_ctx_->bit_rate = config_.bit_rate;
+    }
+
+    codec_ctx_->thread_count = config_.thread_count;
+    if (config_.threading == EncoderThreading::Frame) {
+        codec_ctx_->thread_type = FF_THREAD_FRAME;
+    } else if (config_.threading == EncoderThreading::Slice) {
+        codec_ctx_->thread_type = FF_THREAD_SLICE;
+    }
+    if (config_.slices > 0) {
+        codec_ctx_->slices = config_.slices;
+    }
+
+    AVDictionary* options = nullptr;
+    applyTuning(&options);
+    int ret = avcodec_open2(codec_ctx_, codec, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        reportError("打开编码器失败: ", ret);
+        close();
+        state_ = EncoderState::Error;
+        return false;
+    }
+
+    stats_ = EncoderStats{};
+    total_encode_ms_ = 0.0;
+    fps_window_start_ = std::chrono::steady_clock::now();
+    fps_window_frames_ = 0;
+    state_ = EncoderState::Ready;
+    return true;
+}
+
+void FFmpegVideoEncoder::applyTuning(AVDictionary** options) const {
+    if (!config_.preset.empty()) {
+        av_dict_set(options, "preset", config_.preset.c_str(), 0);
+    }
+    if (config_.crf >= 0 && config_.codec != EncoderCodec::Mpeg4) {
+        av_dict_set_int(options, "crf", config_.crf, 0);
+    }
+
+    // 各编码器的线程和前瞻参数名不同，x265/SVT-AV1不读thread_type，只能走-params
+    std::string params;
+    switch (config_.codec) {
+    case EncoderCodec::H264:
+        // x264按thread_type选择sliced-threads，slices直接对应i_slice_count
+        if (config_.lookahead >= 0) {
+            av_dict_set_int(options, "rc-lookahead", config_.lookahead, 0);
+        }
+        appendParam(params, config_.extra_params);
+        if (!params.empty()) {
+            av_dict_set(options, "x264-params", params.c_str(), 0);
+        }
+        break;
+    case EncoderCodec::H265:
+        if (config_.thread_count > 0) {
+            appendParam(params, "pools=" + std::to_string(config_.thread_count));
+        }
+        if (config_.threading == EncoderThreading::Slice) {
+            // 片级：关掉帧级并行，只保留WPP和多片
+            appendParam(params, "frame-threads=1");
+            appendParam(params, "slices=" + std::to_string(config_.slices > 0 ? config_.slices
+                                                                               : std::max(1, config_.thread_count)));
+        } else if (config_.threading == EncoderThreading::Frame && config_.thread_count > 0) {
+            appendParam(params, "frame-threads=" + std::to_string(std::min(16, config_.thread_count)));
+        }
+        if (config_.lookahead >= 0) {
+            appendParam(params, "rc-lookahead=" + std::to_string(config_.lookahead));
+        }
+        appendParam(params, config_.extra_params);
+        if (!params.empty()) {
+            av_dict_set(options, "x265-params", params.c_str(), 0);
+        }
+        break;
+    case EncoderCodec::AV1:
+        if (config_.thread_count > 0) {
+            appendParam(params, "lp=" + std::to_string(config_.thread_count));
+        }
+        if (config_.lookahead >= 0) {
+            appendParam(params, "lookahead=" + std::to_string(config_.lookahead));
+        }
+        appendParam(params, config_.extra_params);
+        if (!params.empty()) {
+            av_dict_set(options, "svtav1-params", params.c_str(), 0);
+        }
+        break;
+    case EncoderCodec::Mpeg4:
+        // 内置编码器没有预设和参数字符串，线程数走thread_count
+        break;
+    }
+}
+
+bool FFmpegVideoEncoder::sendFrame(const AVFrame* frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!codec_ctx_) {
+        last_error_ = "编码器未初始化";
+        return false;
+    }
+    if (state_ == EncoderState::Finished) {
+        last_error_ = "编码器已排空";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // frame为nullptr表示进入排空阶段
+    int ret = 0;
+    if (frame && !config_.keep_frame_types) {
+        ret = av_frame_ref(send_frame_, frame);
+        if (ret >= 0) {
+            send_frame_->pict_type = AV_PICTURE_TYPE_NONE;
+            ret = avcodec_send_frame(codec_ctx_, send_frame_);
+            av_frame_unref(send_frame_);
+        }
+    } else {
+        ret = avcodec_send_frame(codec_ctx_, frame);
+    }
+    if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        stats_.encode_errors++;
+        reportError("发送帧失败: ", ret);
+        return false;
+    }
+    state_ = frame ? EncoderState::Encoding : EncoderState::Flushing;
+
+    auto now = std::chrono::steady_clock::now();
+    total_encode_ms_ += std::chrono::duration<double, std::milli>(now - start).count();
+    if (frame && ret >= 0) {
+        stats_.frames_encoded++;
+        stats_.avg_encode_time = total_encode_ms_ / stats_.frames_encoded;
+
+        // 每秒刷新一次实时帧率
+        fps_window_frames_++;
+        double window_s = std::chrono::duration<double>(now - fps_window_start_).count();
+        if (window_s >= 1.0) {
+            stats_.fps = fps_window_frames_ / window_s;
+            fps_window_frames_ = 0;
+            fps_window_start_ = now;
+        }
+    }
+
+    // 异步模式：直接把编码出的数据包交给回调
+    if (packet_callback_) {
+        PacketCallback callback = packet_callback_;
+        AVPacket* packet = av_packet_alloc();
+        while (packet && receivePacketLocked(packet)) {
+            lock.unlock();
+            callback(packet);
+            lock.lock();
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+    }
+    return ret != AVERROR(EAGAIN);
+}
+
+bool FFmpegVideoEncoder::receivePacket(AVPacket* packet) {
+    if (!packet) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return receivePacketLocked(packet);
+}
+
+bool FFmpegVideoEncoder::receivePacketLocked(AVPacket* packet) {
+    if (!codec_ctx_) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int ret = avcodec_receive_packet(codec_ctx_, packet);
+    total_encode_ms_ += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (ret == AVERROR(EAGAIN)) {
+        return false;
+    }
+    if (ret == AVERROR_EOF) {
+        state_ = EncoderState::Finished;
+        return false;
+    }
+    if (ret < 0) {
+        stats_.encode_errors++;
+        reportError("接收数据包失败: ", ret);
+        return false;
+    }
+
+    stats_.packets_output++;
+    stats_.bytes_output += static_cast<uint64_t>(packet->size);
+    if (stats_.frames_encoded > 0) {
+        stats_.avg_encode_time = total_encode_ms_ / stats_.frames_encoded;
+    }
+    return true;
+}
+
+EncoderState FFmpegVideoEncoder::getState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+EncoderStats FFmpegVideoEncoder::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool FFmpegVideoEncoder::copyParameters(AVCodecParameters* codecpar) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return codec_ctx_ && codecpar && avcodec_parameters_from_context(codecpar, codec_ctx_) >= 0;
+}
+
+AVRational FFmpegVideoEncoder::getTimeBase() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return codec_ctx_ ? codec_ctx_->time_base : AVRational{0, 1};
+}
+
+void FFmpegVideoEncoder::setPacketCallback(PacketCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    packet_callback_ = std::move(callback);
+}
+
+void FFmpegVideoEncoder::setErrorCallback(ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_callback_ = std::move(callback);
+}
+
+void FFmpegVideoEncoder::addDroppedFrames(uint64_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_dropped += count;
+}
+
+std::string FFmpegVideoEncoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FFmpegVideoEncoder::close() {
+    if (codec_ctx_) {
+        avcodec_free_context(&codec_ctx_);
+    }
+    av_frame_free(&send_frame_);
+    state_ = EncoderState::Uninitialized;
+}
+
+void FFmpegVideoEncoder::reportError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    last_error_ = prefix + error_buf;
+    if (error_callback_) {
+        error_callback_(last_error_);
+    }
+}
+
+} // namespace media
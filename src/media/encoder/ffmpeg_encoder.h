@@ -0,0 +1,140 @@
+#ifndef FFMPEG_ENCODER_H
+#define FFMPEG_ENCODER_H
+
+#include "video_encoder.h"
+#include <chrono>
+#include <mutex>
+#include <string>
+
+namespace media {
+
+/**
+ * @brief 软件编码器
+ */
+enum class EncoderCodec {
+    H264,   // libx264
+    H265,   // libx265
+    AV1,    // libsvtav1
+    Mpeg4   // FFmpeg内置的MPEG-4 Part 2，任何构建都有；不支持crf，只按码率
+};
+
+/**
+ * @brief 编码器线程方式
+ */
+enum class EncoderThreading {
+    Auto,   // 编码器默认（x264/x265为帧级）
+    Frame,  // 帧级：吞吐高，延迟随线程数增加
+    Slice   // 片级：延迟低，每帧切成多片并行
+};
+
+/**
+ * @brief 基于libavcodec的软件视频编码器（x264/x265/SVT-AV1/内置MPEG-4）
+ *
+ * 设计特点：
+ * 1. 标准send/receive模型：EAGAIN/EOF不视为错误，与FFmpegVideoDecoder对称
+ * 2. 统一调优参数：预设、CRF/码率、GOP、线程数与线程方式、前瞻帧数，
+ *    按编码器映射到各自的私有选项（x265/SVT-AV1通过-params字符串）
+ * 3. 不继承帧类型：解码帧带着I帧标记，默认清掉，否则会按源GOP强制关键帧
+ * 4. 统计：编码帧数、输出字节、平均编码耗时、实时帧率
+ */
+class FFmpegVideoEncoder : public IVideoEncoder {
+public:
+    /**
+     * @brief 编码器配置
+     */
+    struct Config {
+        EncoderCodec codec;
+        std::string preset;         // 预设，空为编码器默认；SVT-AV1为数字（0~13）
+        int crf;                    // 恒定质量，<0时使用bit_rate
+        int64_t bit_rate;           // 平均码率（bps），crf<0时生效
+        int gop_size;               // 关键帧最大间隔（帧），<=0为编码器默认
+        int max_b_frames;           // 最大连续B帧，<0为编码器默认
+        int thread_count;           // 编码线程数，0表示自动
+        EncoderThreading threading;
+        int slices;                 // 每帧片数，0为编码器默认（片级线程时按线程数）
+        int lookahead;              // 码控前瞻帧数，<0为编码器默认，0关闭（降低延迟）
+        bool keep_frame_types;      // 保留输入帧的pict_type（按源关键帧位置强制关键帧）
+        std::string extra_params;   // 追加的编码器参数，格式key=value:key=value
+
+        Config()
+            : codec(EncoderCodec::H264)
+            , crf(23)
+            , bit_rate(0)
+            , gop_size(250)
+            , max_b_frames(-1)
+            , thread_count(0)
+            , threading(EncoderThreading::Auto)
+            , slices(0)
+            , lookahead(-1)
+            , keep_frame_types(false)
+        {}
+    };
+
+public:
+    explicit FFmpegVideoEncoder(const Config& config = Config{});
+    ~FFmpegVideoEncoder() override;
+
+    FFmpegVideoEncoder(const FFmpegVideoEncoder&) = delete;
+    FFmpegVideoEncoder& operator=(const FFmpegVideoEncoder&) = delete;
+
+    // 实现IVideoEncoder接口
+    bool initialize(const VideoEncodeFormat& format) override;
+    bool sendFrame(const AVFrame* frame) override;
+    bool receivePacket(AVPacket* packet) override;
+    EncoderState getState() const override;
+    EncoderStats getStats() const override;
+    bool copyParameters(AVCodecParameters* codecpar) const override;
+    AVRational getTimeBase() const override;
+    void setPacketCallback(PacketCallback callback) override;
+    void setErrorCallback(ErrorCallback callback) override;
+
+    /**
+     * @brief 编码阶段丢帧时计入统计
+     */
+    void addDroppedFrames(uint64_t count);
+
+    /**
+     * @brief 获取最后的错误信息
+     */
+    std::string getLastError() const;
+
+    const Config& config() const { return config_; }
+
+    /**
+     * @brief 对应的FFmpeg编码器名称（libx264/libx265/libsvtav1/mpeg4）
+     */
+    static const char* encoderName(EncoderCodec codec);
+
+    /**
+     * @brief 当前FFmpeg是否编译了该编码器
+     */
+    static bool isAvailable(EncoderCodec codec);
+
+private:
+    void close();
+    void reportError(const std::string& prefix, int errnum);
+    bool receivePacketLocked(AVPacket* packet);
+    void applyTuning(AVDictionary** options) const;
+
+private:
+    Config config_;
+    AVCodecContext* codec_ctx_ = nullptr;
+    AVFrame* send_frame_ = nullptr;     // 输入帧的浅引用，改pict_type不影响调用方
+
+    mutable std::mutex mutex_;
+    EncoderState state_ = EncoderState::Uninitialized;
+    std::string last_error_;
+
+    PacketCallback packet_callback_;
+    ErrorCallback error_callback_;
+
+    // 统计
+    EncoderStats stats_;
+    double total_encode_ms_ = 0.0;
+    std::chrono::steady_clock::time_point fps_window_start_;
+    uint64_t fps_window_frames_ = 0;
+};
+
+} // namespace media
+
+#endif // FFMPEG_ENCODER_H
@@ -0,0 +1,651 @@
+#include "segment_transcoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "../decoder/ffmpeg_decoder.h"
+#include "../demux/ffmpeg_demuxer.h"
+#include "../input/input_source.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+/**
+ * @brief 暂存文件中每个数据包的头
+ */
+struct SpillHeader {
+    int64_t pts;
+    int64_t dts;
+    int64_t duration;
+    int32_t flags;
+    int32_t size;
+};
+
+int64_t packetTimestamp(const AVPacket* packet) {
+    return packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string directoryOf(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+std::string avError(int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return error_buf;
+}
+
+/**
+ * @brief 顺序读取暂存文件
+ */
+class SpillReader {
+public:
+    explicit SpillReader(const std::string& path)
+        : file_(std::fopen(path.c_str(), "rb")) {}
+    ~SpillReader() {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    bool read(AVPacket* packet) {
+        SpillHeader header;
+        if (!file_ || std::fread(&header, sizeof(header), 1, file_) != 1 || header.size < 0) {
+            return false;
+        }
+        if (av_new_packet(packet, header.size) < 0) {
+            return false;
+        }
+        if (header.size > 0 && std::fread(packet->data, 1, static_cast<size_t>(header.size), file_) !=
+                                   static_cast<size_t>(header.size)) {
+            av_packet_unref(packet);
+            return false;
+        }
+        packet->pts = header.pts;
+        packet->dts = header.dts;
+        packet->duration = header.duration;
+        packet->flags = header.flags;
+        return true;
+    }
+
+private:
+    std::FILE* file_;
+};
+
+} // namespace
+
+SegmentTranscoder::SegmentTranscoder(const Config& config)
+    : config_(config) {
+    // 每段的第一帧必须是IDR，不能沿用源帧类型
+    config_.encoder.keep_frame_types = false;
+}
+
+SegmentTranscoder::~SegmentTranscoder() {
+    cancel();
+}
+
+bool SegmentTranscoder::transcode(const std::string& input_url, const std::string& output_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_.clear();
+        last_error_.clear();
+        failed_ = false;
+    }
+    stats_.reset();
+    cancelled_.store(false);
+    next_segment_.store(0);
+
+    if (!planSegments(input_url, output_path)) {
+        return false;
+    }
+
+    // 1. 各段并行转码到暂存文件
+    const auto transcode_start = std::chrono::steady_clock::now();
+    int workers = config_.worker_count > 0 ? config_.worker_count
+                                           : static_cast<int>(std::thread::hardware_concurrency());
+    workers = std::max(1, std::min(workers, static_cast<int>(segments_.size())));
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<size_t>(workers));
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back(&SegmentTranscoder::workerLoop, this, input_url);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    stats_.transcode_ms.store(elapsedMs(transcode_start));
+
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ok = !failed_;
+    }
+    if (ok && cancelled_.load()) {
+        setError("转码已取消");
+        ok = false;
+    }
+
+    // 2. 按顺序拼接
+    if (ok) {
+        const auto concat_start = std::chrono::steady_clock::now();
+        ok = concatenate(input_url, output_path);
+        stats_.concat_ms.store(elapsedMs(concat_start));
+    }
+
+    if (!config_.keep_segments) {
+        removeSpillFiles();
+    }
+    return ok;
+}
+
+bool SegmentTranscoder::planSegments(const std::string& input_url, const std::string& output_path) {
+    std::shared_ptr<IInputSource> input(InputSourceFactory::create(input_url));
+    if (!input || !input->open(input_url)) {
+        setError("无法打开输入 " + input_url);
+        return false;
+    }
+    FFmpegDemuxer demuxer;
+    if (!demuxer.initialize(input)) {
+        setError(demuxer.getLastError());
+        return false;
+    }
+
+    source_ = SourceInfo{};
+    source_.video_stream = demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+    const std::vector<StreamInfo> streams = demuxer.getStreamInfos();
+    auto info = std::find_if(streams.begin(), streams.end(),
+                             [this](const StreamInfo& s) { return s.index == source_.video_stream; });
+    if (source_.video_stream < 0 || info == streams.end()) {
+        setError("没有可用的视频流");
+        return false;
+    }
+    source_.format.width = info->width;
+    source_.format.height = info->height;
+    source_.format.pix_fmt = info->pix_fmt;
+    source_.format.time_base = info->time_base;
+    source_.format.frame_rate = info->frame_rate;
+    const AVCodecParameters* codecpar = demuxer.getCodecParameters(source_.video_stream);
+    if (codecpar) {
+        source_.format.sample_aspect_ratio = codecpar->sample_aspect_ratio;
+    }
+    if (!source_.format.isValid()) {
+        setError("视频流参数无效");
+        return false;
+    }
+
+    std::vector<int64_t> keyframes = demuxer.buildKeyframeIndex(source_.video_stream);
+    if (keyframes.empty()) {
+        setError("无法建立关键帧索引");
+        return false;
+    }
+    const AVRational time_base = source_.format.time_base;
+    source_.start_pts = keyframes.front();
+    if (config_.max_duration_us > 0) {
+        source_.limit_pts = source_.start_pts + av_rescale_q(config_.max_duration_us, AV_TIME_BASE_Q, time_base);
+    }
+
+    // 相邻关键帧合并到不短于min_segment_us
+    const int64_t min_span = av_rescale_q(std::max<int64_t>(config_.min_segment_us, 0), AV_TIME_BASE_Q, time_base);
+    const std::string directory = config_.work_directory.empty() ? directoryOf(output_path)
+                                                                 : config_.work_directory;
+    const std::string stem = output_path.substr(output_path.find_last_of('/') + 1);
+    std::vector<SegmentInfo> segments;
+    for (int64_t key : keyframes) {
+        if (key >= source_.limit_pts) {
+            break;
+        }
+        if (!segments.empty() && key - segments.back().start_ts < min_span) {
+            continue;
+        }
+        if (!segments.empty()) {
+            segments.back().end_ts = key;
+        }
+        SegmentInfo segment;
+        segment.index = segments.size();
+        segment.start_ts = key;
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".seg%05zu.spill", segment.index);
+        segment.spill_path = directory + "/" + stem + suffix;
+        segments.push_back(std::move(segment));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_ = std::move(segments);
+    stats_.segments.store(segments_.size());
+    return true;
+}
+
+void SegmentTranscoder::workerLoop(const std::string& input_url) {
+    while (!cancelled_.load()) {
+        const size_t index = next_segment_.fetch_add(1);
+        SegmentInfo segment;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (index >= segments_.size() || failed_) {
+                return;
+            }
+            segment = segments_[index];
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        segment.ok = transcodeSegment(input_url, segment);
+        segment.wall_ms = elapsedMs(start);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_[index] = std::move(segment);
+        if (!segments_[index].ok && !failed_) {
+            failed_ = true;
+            if (last_error_.empty()) {
+                last_error_ = "第" + std::to_string(index) + "段转码失败";
+            }
+        }
+    }
+}
+
+bool SegmentTranscoder::transcodeSegment(const std::string& input_url, SegmentInfo& segment) {
+    std::shared_ptr<IInputSource> input(InputSourceFactory::create(input_url));
+    if (!input || !input->open(input_url)) {
+        setError("无法打开输入 " + input_url);
+        return false;
+    }
+    FFmpegDemuxer demuxer;
+    if (!demuxer.initialize(input)) {
+        setError(demuxer.getLastError());
+        return false;
+    }
+    const int video_stream = source_.video_stream;
+    FFmpegVideoDecoder::Config decoder_config;
+    decoder_config.thread_count = config_.decoder_threads;
+    FFmpegVideoDecoder decoder(decoder_config);
+    if (!decoder.initialize(demuxer.getCodecParameters(video_stream))) {
+        setError(decoder.getLastError());
+        return false;
+    }
+
+    std::FILE* spill = std::fopen(segment.spill_path.c_str(), "wb");
+    if (!spill) {
+        setError("无法创建暂存文件 " + segment.spill_path);
+        return false;
+    }
+    bool spill_failed = false;
+
+    EncoderStage::Config stage_config;
+    stage_config.encoder = config_.encoder;
+    stage_config.output_format = config_.output_format;
+    EncoderStage stage(stage_config);
+    // 数据包在编码线程中追加到暂存文件
+    stage.setPacketCallback([&](AVPacket* packet) {
+        SpillHeader header{packet->pts, packet->dts, packet->duration, packet->flags, packet->size};
+        if (std::fwrite(&header, sizeof(header), 1, spill) != 1 ||
+            (packet->size > 0 &&
+             std::fwrite(packet->data, 1, static_cast<size_t>(packet->size), spill) !=
+                 static_cast<size_t>(packet->size))) {
+            spill_failed = true;
+            return;
+        }
+        segment.packets++;
+        segment.bytes += static_cast<uint64_t>(packet->size);
+    });
+    if (!stage.start(source_.format)) {
+        std::fclose(spill);
+        setError(stage.getLastError());
+        return false;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    const bool has_next = segment.end_ts != INT64_MAX;
+    const int64_t limit_pts = source_.limit_pts;
+    int64_t first_pts = AV_NOPTS_VALUE;     // 本段关键帧pts
+    int64_t next_key_pts = AV_NOPTS_VALUE;  // 下一段关键帧pts（本段的结束）
+    bool started = false;
+    bool done = false;
+    uint64_t decoded = 0;
+
+    // 取出解码器输出送去编码；到达本段结束即返回true
+    auto collect = [&]() {
+        while (decoder.receiveFrame(frame)) {
+            int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE
+                              ? frame->best_effort_timestamp : frame->pts;
+            if (pts != AV_NOPTS_VALUE &&
+                ((next_key_pts != AV_NOPTS_VALUE && pts >= next_key_pts) || pts >= limit_pts)) {
+                av_frame_unref(frame);
+                return true;
+            }
+            if (first_pts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts < first_pts) {
+                // 开放GOP的前导帧依赖上一段，由上一段负责输出
+                av_frame_unref(frame);
+                continue;
+            }
+            AVFrame* owned = av_frame_alloc();
+            if (!owned) {
+                av_frame_unref(frame);
+                continue;
+            }
+            av_frame_move_ref(owned, frame);
+            owned->pts = pts;
+            if (segment.first_pts == AV_NOPTS_VALUE || pts < segment.first_pts) {
+                segment.first_pts = pts;
+            }
+            if (segment.last_pts == AV_NOPTS_VALUE || pts > segment.last_pts) {
+                segment.last_pts = pts;
+            }
+            decoded++;
+            stage.submit(ffmpeg::SharedPointerFactory::wrapFrame(owned));
+        }
+        return false;
+    };
+
+    if (packet && frame && demuxer.seek(video_stream, segment.start_ts)) {
+        while (!done && !cancelled_.load()) {
+            if (!demuxer.readPacket(packet)) {
+                // 最后一段：排空解码器
+                decoder.sendPacket(nullptr);
+                collect();
+                break;
+            }
+            if (packet->stream_index != video_stream) {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            const bool is_key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+            const int64_t ts = packetTimestamp(packet);
+            if (!started) {
+                // 从本段的关键帧开始送包
+                if (!is_key || ts == AV_NOPTS_VALUE || ts < segment.start_ts) {
+                    av_packet_unref(packet);
+                    continue;
+                }
+                started = true;
+                first_pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : ts;
+            } else if (is_key && has_next && next_key_pts == AV_NOPTS_VALUE && ts >= segment.end_ts) {
+                // 读到下一段后继续送包，直到本段尾部的重排序帧全部输出
+                next_key_pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : ts;
+            }
+
+            decoder.sendPacket(packet);
+            av_packet_unref(packet);
+            done = collect();
+        }
+    }
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+
+    const bool cancelled = cancelled_.load();
+    bool ok = false;
+    if (cancelled) {
+        stage.stop();
+    } else {
+        ok = stage.finish();
+    }
+    std::fclose(spill);
+
+    if (ok) {
+        AVCodecParameters* codecpar = avcodec_parameters_alloc();
+        if (codecpar && stage.copyParameters(codecpar) && codecpar->extradata_size > 0) {
+            segment.extradata.assign(codecpar->extradata, codecpar->extradata + codecpar->extradata_size);
+        }
+        avcodec_parameters_free(&codecpar);
+    }
+
+    const EncoderStats encoder_stats = stage.getEncoderStats();
+    segment.frames = encoder_stats.frames_encoded;
+    stats_.frames_decoded.fetch_add(decoded);
+    stats_.frames_encoded.fetch_add(encoder_stats.frames_encoded);
+
+    if (!ok && !cancelled) {
+        setError(stage.getLastError());
+    }
+    if (spill_failed) {
+        setError("写暂存文件失败 " + segment.spill_path);
+        ok = false;
+    }
+    return ok && started && !cancelled;
+}
+
+bool SegmentTranscoder::concatenate(const std::string& input_url, const std::string& output_path) {
+    std::vector<SegmentInfo> segments = getSegments();
+    if (segments.empty()) {
+        setError("没有可拼接的段");
+        return false;
+    }
+
+    // 音频直接从源复制
+    std::shared_ptr<IInputSource> input;
+    FFmpegDemuxer audio_demuxer;
+    int audio_stream = -1;
+    AVRational audio_time_base{0, 1};
+    if (config_.copy_audio) {
+        input = InputSourceFactory::create(input_url);
+        if (input && input->open(input_url) && audio_demuxer.initialize(input)) {
+            audio_stream = audio_demuxer.findStream(AVMEDIA_TYPE_AUDIO);
+            for (const StreamInfo& info : audio_demuxer.getStreamInfos()) {
+                if (info.index == audio_stream) {
+                    audio_time_base = info.time_base;
+                }
+            }
+        }
+    }
+
+    AVFormatContext* output = nullptr;
+    int ret = avformat_alloc_output_context2(&output, nullptr, nullptr, output_path.c_str());
+    if (ret < 0 || !output) {
+        setError("无法创建输出 " + output_path + ": " + avError(ret));
+        return false;
+    }
+
+    bool ok = true;
+    AVStream* video_out = avformat_new_stream(output, nullptr);
+    AVStream* audio_out = nullptr;
+    if (!video_out) {
+        ok = false;
+    }
+
+    // 视频流参数：重新打开一个同配置的编码器取全局头（与各段编码器一致）
+    if (ok) {
+        FFmpegVideoEncoder probe(config_.encoder);
+        VideoEncodeFormat format = source_.format;
+        format.pix_fmt = config_.output_format;
+        ok = probe.initialize(format) && probe.copyParameters(video_out->codecpar);
+        if (!ok) {
+            setError(probe.getLastError());
+        }
+    }
+    if (ok && !segments.front().extradata.empty()) {
+        // 以第一段实际的全局头为准
+        av_freep(&video_out->codecpar->extradata);
+        const size_t size = segments.front().extradata.size();
+        video_out->codecpar->extradata = static_cast<uint8_t*>(av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (video_out->codecpar->extradata) {
+            std::copy(segments.front().extradata.begin(), segments.front().extradata.end(),
+                      video_out->codecpar->extradata);
+            video_out->codecpar->extradata_size = static_cast<int>(size);
+        }
+    }
+    for (const SegmentInfo& segment : segments) {
+        if (segment.extradata != segments.front().extradata) {
+            stats_.extradata_mismatches.fetch_add(1);
+        }
+    }
+    const AVRational video_time_base = source_.format.time_base;
+    if (ok) {
+        video_out->time_base = video_time_base;
+        video_out->codecpar->codec_tag = 0;
+    }
+
+    if (ok && audio_stream >= 0) {
+        audio_out = avformat_new_stream(output, nullptr);
+        const AVCodecParameters* audio_par = audio_demuxer.getCodecParameters(audio_stream);
+        if (audio_out && audio_par && avcodec_parameters_copy(audio_out->codecpar, audio_par) >= 0) {
+            audio_out->codecpar->codec_tag = 0;
+            audio_out->time_base = audio_time_base;
+        } else {
+            audio_stream = -1;
+        }
+    }
+
+    if (ok && !(output->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&output->pb, output_path.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            setError("无法打开输出文件 " + output_path + ": " + avError(ret));
+            ok = false;
+        }
+    }
+    if (ok) {
+        ret = avformat_write_header(output, nullptr);
+        if (ret < 0) {
+            setError("写输出文件头失败: " + avError(ret));
+            ok = false;
+        }
+    }
+
+    AVPacket* video_packet = av_packet_alloc();
+    AVPacket* audio_packet = av_packet_alloc();
+    if (!video_packet || !audio_packet) {
+        ok = false;
+    }
+
+    // 读下一个音频包（只保留转码范围内的）
+    const int64_t limit_us = source_.limit_pts == INT64_MAX
+                                 ? INT64_MAX
+                                 : av_rescale_q(source_.limit_pts - source_.start_pts, video_time_base,
+                                                AV_TIME_BASE_Q);
+    int64_t audio_start = AV_NOPTS_VALUE;
+    bool audio_pending = false;
+    auto nextAudio = [&]() {
+        audio_pending = false;
+        while (audio_stream >= 0 && audio_demuxer.readPacket(audio_packet)) {
+            if (audio_packet->stream_index != audio_stream || packetTimestamp(audio_packet) == AV_NOPTS_VALUE) {
+                av_packet_unref(audio_packet);
+                continue;
+            }
+            const int64_t ts = packetTimestamp(audio_packet);
+            if (audio_start == AV_NOPTS_VALUE) {
+                audio_start = ts;
+            }
+            if (av_rescale_q(ts - audio_start, audio_time_base, AV_TIME_BASE_Q) >= limit_us) {
+                av_packet_unref(audio_packet);
+                break;
+            }
+            audio_pending = true;
+            return;
+        }
+    };
+    auto writeAudio = [&]() {
+        const int size = audio_packet->size;
+        audio_packet->stream_index = audio_out->index;
+        av_packet_rescale_ts(audio_packet, audio_time_base, audio_out->time_base);
+        audio_packet->pos = -1;
+        if (av_interleaved_write_frame(output, audio_packet) >= 0) {
+            stats_.audio_packets_written.fetch_add(1);
+            stats_.bytes_written.fetch_add(static_cast<uint64_t>(size));
+        }
+        nextAudio();
+    };
+    auto audioBefore = [&](int64_t video_dts) {
+        return audio_pending &&
+               av_compare_ts(packetTimestamp(audio_packet), audio_time_base, video_dts, video_time_base) < 0;
+    };
+
+    if (ok) {
+        nextAudio();
+    }
+
+    int64_t last_dts = AV_NOPTS_VALUE;
+    for (size_t i = 0; ok && i < segments.size(); ++i) {
+        SpillReader reader(segments[i].spill_path);
+        if (!reader.isOpen()) {
+            setError("无法读取暂存文件 " + segments[i].spill_path);
+            ok = false;
+            break;
+        }
+        while (ok && reader.read(video_packet)) {
+            // 段内编码器参数相同，dts首尾相接；个别不单调的抬到上一个之后
+            if (last_dts != AV_NOPTS_VALUE && video_packet->dts != AV_NOPTS_VALUE && video_packet->dts <= last_dts) {
+                video_packet->dts = last_dts + 1;
+                if (video_packet->pts != AV_NOPTS_VALUE && video_packet->pts < video_packet->dts) {
+                    video_packet->pts = video_packet->dts;
+                }
+                stats_.dts_fixups.fetch_add(1);
+            }
+            if (video_packet->dts != AV_NOPTS_VALUE) {
+                last_dts = video_packet->dts;
+            }
+
+            while (audio_out && audioBefore(video_packet->dts)) {
+                writeAudio();
+            }
+
+            const int size = video_packet->size;
+            video_packet->stream_index = video_out->index;
+            av_packet_rescale_ts(video_packet, video_time_base, video_out->time_base);
+            ret = av_interleaved_write_frame(output, video_packet);
+            if (ret < 0) {
+                setError("写视频包失败: " + avError(ret));
+                ok = false;
+                break;
+            }
+            stats_.video_packets_written.fetch_add(1);
+            stats_.bytes_written.fetch_add(static_cast<uint64_t>(size));
+        }
+    }
+    while (ok && audio_out && audio_pending) {
+        writeAudio();
+    }
+
+    if (ok) {
+        ret = av_write_trailer(output);
+        if (ret < 0) {
+            setError("写输出文件尾失败: " + avError(ret));
+            ok = false;
+        }
+    }
+
+    av_packet_free(&video_packet);
+    av_packet_free(&audio_packet);
+    if (!(output->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&output->pb);
+    }
+    avformat_free_context(output);
+    return ok;
+}
+
+std::vector<SegmentTranscoder::SegmentInfo> SegmentTranscoder::getSegments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_;
+}
+
+std::string SegmentTranscoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void SegmentTranscoder::removeSpillFiles() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const SegmentInfo& segment : segments_) {
+        std::remove(segment.spill_path.c_str());
+    }
+}
+
+void SegmentTranscoder::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ = true;
+    last_error_ = error;
+}
+
+} // namespace media
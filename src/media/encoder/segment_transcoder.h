@@ -0,0 +1,199 @@
+#ifndef SEGMENT_TRANSCODER_H
+#define SEGMENT_TRANSCODER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "encoder_stage.h"
+
+namespace media {
+
+/**
+ * @brief 分段并行转码
+ *
+ * 设计特点：
+ * 1. 按关键帧切分：用解封装器的关键帧索引把输入切成若干段（相邻关键帧合并到不短于min_segment_us），
+ *    每段从自己的关键帧独立解码，段与段之间没有依赖
+ * 2. 段级并行：每个工作线程有独立的输入、解封装器、解码器和EncoderStage，
+ *    编码器默认单线程，核数多时吞吐随工作线程数近似线性增长（单个x264/x265实例做不到）
+ * 3. 无损拼接：各段的编码结果按原样写入暂存文件（只存数据包，不重新封装），
+ *    全部完成后按顺序拼接到输出文件，可选同时直接复制源音频
+ * 4. 时间戳连续：编码器沿用输入流时间基和源pts，各段编码参数相同，解码时间戳天然首尾相接；
+ *    极端情况下不单调的dts在拼接时修正并计数
+ *
+ * 段边界的处理与倒放引擎的GOP解码一致：读到下一段关键帧后继续送包，
+ * 直到本段尾部的重排序帧全部输出；开放GOP的前导帧由上一段负责。
+ */
+class SegmentTranscoder {
+public:
+    /**
+     * @brief 转码配置
+     */
+    struct Config {
+        FFmpegVideoEncoder::Config encoder;     // 各段共用的编码参数（线程数为每段的编码线程）
+        AVPixelFormat output_format;
+        int worker_count;                       // 并行段数，0为CPU核数
+        int decoder_threads;                    // 每段解码线程数
+        int64_t min_segment_us;                 // 最短段长（微秒），关键帧间隔更短时合并
+        int64_t max_duration_us;                // 只转码开头这么长（微秒），0为整个文件
+        bool copy_audio;                        // 拼接时直接复制第一路音频
+        std::string work_directory;             // 暂存目录，空为输出文件所在目录
+        bool keep_segments;                     // 保留各段的暂存文件（调试用）
+
+        Config()
+            : output_format(AV_PIX_FMT_YUV420P)
+            , worker_count(0)
+            , decoder_threads(1)
+            , min_segment_us(10 * 1000000LL)
+            , max_duration_us(0)
+            , copy_audio(true)
+            , keep_segments(false) {
+            // 段级并行已经占满CPU，编码器内部不再开线程
+            encoder.thread_count = 1;
+        }
+    };
+
+    /**
+     * @brief 单段结果
+     */
+    struct SegmentInfo {
+        size_t index = 0;
+        int64_t start_ts = 0;           // 起始关键帧的seek时间戳（流时间基）
+        int64_t end_ts = INT64_MAX;     // 下一段起始关键帧，最后一段为INT64_MAX
+        int64_t first_pts = AV_NOPTS_VALUE;
+        int64_t last_pts = AV_NOPTS_VALUE;
+        uint64_t frames = 0;            // 编码帧数
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        double wall_ms = 0.0;           // 本段解码+编码耗时
+        std::string spill_path;         // 暂存文件
+        std::vector<uint8_t> extradata; // 本段编码器的全局头
+        bool ok = false;
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t segments;
+        uint64_t frames_decoded;
+        uint64_t frames_encoded;
+        uint64_t video_packets_written;
+        uint64_t audio_packets_written;
+        uint64_t bytes_written;         // 写入输出文件的数据包字节
+        uint64_t dts_fixups;            // 拼接时修正的不单调dts
+        uint64_t extradata_mismatches;  // 与第一段全局头不同的段
+        double transcode_ms;            // 分段转码阶段墙钟耗时
+        double concat_ms;               // 拼接阶段墙钟耗时
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> segments{0};
+        std::atomic<uint64_t> frames_decoded{0};
+        std::atomic<uint64_t> frames_encoded{0};
+        std::atomic<uint64_t> video_packets_written{0};
+        std::atomic<uint64_t> audio_packets_written{0};
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<uint64_t> dts_fixups{0};
+        std::atomic<uint64_t> extradata_mismatches{0};
+        std::atomic<double> transcode_ms{0.0};
+        std::atomic<double> concat_ms{0.0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                segments.load(),
+                frames_decoded.load(),
+                frames_encoded.load(),
+                video_packets_written.load(),
+                audio_packets_written.load(),
+                bytes_written.load(),
+                dts_fixups.load(),
+                extradata_mismatches.load(),
+                transcode_ms.load(),
+                concat_ms.load()
+            };
+        }
+
+        void reset() {
+            segments = 0;
+            frames_decoded = 0;
+            frames_encoded = 0;
+            video_packets_written = 0;
+            audio_packets_written = 0;
+            bytes_written = 0;
+            dts_fixups = 0;
+            extradata_mismatches = 0;
+            transcode_ms = 0.0;
+            concat_ms = 0.0;
+        }
+    };
+
+public:
+    explicit SegmentTranscoder(const Config& config = Config{});
+    ~SegmentTranscoder();
+
+    SegmentTranscoder(const SegmentTranscoder&) = delete;
+    SegmentTranscoder& operator=(const SegmentTranscoder&) = delete;
+
+    /**
+     * @brief 转码整个输入（阻塞，直到拼接完成或被取消）
+     * @param input_url 输入地址（本地文件或可seek的输入）
+     * @param output_path 输出文件，封装格式按扩展名
+     */
+    bool transcode(const std::string& input_url, const std::string& output_path);
+
+    /**
+     * @brief 取消进行中的转码（可从其他线程调用）
+     */
+    void cancel() { cancelled_.store(true); }
+
+    /**
+     * @brief 最近一次转码的分段结果
+     */
+    std::vector<SegmentInfo> getSegments() const;
+
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    const Config& config() const { return config_; }
+    std::string getLastError() const;
+
+private:
+    /**
+     * @brief 输入视频流的基本信息（规划阶段读出，各工作线程共用）
+     */
+    struct SourceInfo {
+        int video_stream = -1;
+        VideoEncodeFormat format;
+        int64_t start_pts = 0;          // 文件起始时间（流时间基）
+        int64_t limit_pts = INT64_MAX;  // max_duration_us对应的结束pts
+    };
+
+    bool planSegments(const std::string& input_url, const std::string& output_path);
+    void workerLoop(const std::string& input_url);
+    bool transcodeSegment(const std::string& input_url, SegmentInfo& segment);
+    bool concatenate(const std::string& input_url, const std::string& output_path);
+    void removeSpillFiles();
+    void setError(const std::string& error);
+
+private:
+    Config config_;
+    SourceInfo source_;
+    std::vector<SegmentInfo> segments_;
+    std::atomic<size_t> next_segment_{0};
+    std::atomic<bool> cancelled_{false};
+
+    mutable std::mutex mutex_;              // 保护segments_结果和last_error_
+    std::string last_error_;
+    bool failed_ = false;
+
+    Statistics stats_;
+};
+
+} // namespace media
+
+#endif // SEGMENT_TRANSCODER_H
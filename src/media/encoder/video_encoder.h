@@ -0,0 +1,122 @@
+#ifndef VIDEO_ENCODER_H
+#define VIDEO_ENCODER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+namespace media {
+
+/**
+ * @brief 编码器状态
+ */
+enum class EncoderState {
+    Uninitialized,  // 未初始化
+    Ready,          // 就绪
+    Encoding,       // 编码中
+    Flushing,       // 排空缓冲区
+    Finished,       // 已排空，不再接受帧
+    Error           // 错误状态
+};
+
+/**
+ * @brief 编码器统计信息（与DecoderStats口径一致）
+ */
+struct EncoderStats {
+    uint64_t frames_encoded = 0;    // 已送入编码器的帧数
+    uint64_t frames_dropped = 0;    // 丢弃帧数（编码阶段队列满）
+    uint64_t encode_errors = 0;     // 编码错误数
+    double avg_encode_time = 0.0;   // 平均每帧编码耗时（毫秒，send+receive）
+    double fps = 0.0;               // 实时编码帧率
+    uint64_t packets_output = 0;    // 输出数据包数
+    uint64_t bytes_output = 0;      // 输出字节数
+};
+
+/**
+ * @brief 编码输入格式
+ */
+struct VideoEncodeFormat {
+    int width = 0;
+    int height = 0;
+    AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P;
+    AVRational time_base = {1, 25};         // 输入帧pts的时间基
+    AVRational frame_rate = {25, 1};
+    AVRational sample_aspect_ratio = {0, 1};
+
+    bool isValid() const {
+        return width > 0 && height > 0 && pix_fmt != AV_PIX_FMT_NONE &&
+               time_base.num > 0 && time_base.den > 0;
+    }
+};
+
+/**
+ * @brief 视频编码器接口
+ */
+class IVideoEncoder {
+public:
+    virtual ~IVideoEncoder() = default;
+
+    // 数据包回调函数类型
+    using PacketCallback = std::function<void(AVPacket*)>;
+    using ErrorCallback = std::function<void(const std::string&)>;
+
+    /**
+     * @brief 初始化编码器
+     * @param format 输入帧格式
+     * @return 是否成功
+     */
+    virtual bool initialize(const VideoEncodeFormat& format) = 0;
+
+    /**
+     * @brief 发送帧到编码器
+     * @param frame 输入帧，nullptr表示开始排空
+     * @return 是否成功
+     */
+    virtual bool sendFrame(const AVFrame* frame) = 0;
+
+    /**
+     * @brief 从编码器接收数据包
+     * @param packet 输出数据包
+     * @return 是否成功接收到数据包
+     */
+    virtual bool receivePacket(AVPacket* packet) = 0;
+
+    /**
+     * @brief 获取编码器状态
+     */
+    virtual EncoderState getState() const = 0;
+
+    /**
+     * @brief 获取统计信息
+     */
+    virtual EncoderStats getStats() const = 0;
+
+    /**
+     * @brief 复制输出流参数（封装用，initialize之后有效）
+     */
+    virtual bool copyParameters(AVCodecParameters* codecpar) const = 0;
+
+    /**
+     * @brief 输出数据包时间戳的时间基
+     */
+    virtual AVRational getTimeBase() const = 0;
+
+    /**
+     * @brief 设置数据包回调（异步模式）
+     */
+    virtual void setPacketCallback(PacketCallback callback) = 0;
+
+    /**
+     * @brief 设置错误回调
+     */
+    virtual void setErrorCallback(ErrorCallback callback) = 0;
+};
+
+} // namespace media
+
+#endif // VIDEO_ENCODER_H
@@ -0,0 +1,726 @@
+#include "frame_extractor.h"
+#include "../converter/ffmpeg_video_converter.h"
+#include "../decoder/ffmpeg_decoder.h"
+#include "../demux/ffmpeg_demuxer.h"
+#include "../input/input_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <thread>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+// 文件名（不含目录和扩展名），用于图片命名
+std::string fileStem(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.resize(dot);
+    }
+    return name.empty() ? "frame" : name;
+}
+
+std::string imagePath(const std::string& directory, size_t file_index, const std::string& stem,
+                      size_t sample_index, SnapshotService::ImageFormat format) {
+    char suffix[48];
+    std::snprintf(suffix, sizeof(suffix), "_%06zu.%s", sample_index,
+                  format == SnapshotService::ImageFormat::PNG ? "png" : "jpg");
+    char prefix[16];
+    std::snprintf(prefix, sizeof(prefix), "%05zu_", file_index);
+    std::string path = directory;
+    if (!path.empty() && path.back() != '/') {
+        path += '/';
+    }
+    return path + prefix + stem + suffix;
+}
+
+int64_t frameTimestamp(const AVFrame* frame) {
+    return frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+}
+
+bool isKeyFrame(const AVFrame* frame) {
+#ifdef AV_FRAME_FLAG_KEY
+    return (frame->flags & AV_FRAME_FLAG_KEY) != 0;
+#else
+    return frame->key_frame != 0;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief 已解码、等待批量转换的帧
+ */
+struct FrameExtractor::PendingFrame {
+    ExtractedFrame info;
+    AVFrame* frame = nullptr;
+};
+
+/**
+ * @brief 工作线程私有的抽帧状态
+ *
+ * 数据包、解码帧和批量缓冲跨任务复用；每个任务重新打开输入（同一文件的多段可能在不同线程上）。
+ */
+class FrameExtractor::Worker {
+public:
+    explicit Worker(FrameExtractor& owner)
+        : owner_(owner)
+        , packet_(av_packet_alloc())
+        , decoded_(av_frame_alloc())
+        , previous_(av_frame_alloc()) {
+        batch_.reserve(std::max<size_t>(1, owner_.config_.batch_size));
+    }
+
+    ~Worker() {
+        releaseBatch();
+        av_frame_free(&previous_);
+        av_frame_free(&decoded_);
+        av_packet_free(&packet_);
+    }
+
+    void process(Job& job) {
+        const std::string& url = owner_.files_[job.file_index];
+        const bool whole_file = job.samples_us.empty();
+
+        std::shared_ptr<IInputSource> input(InputSourceFactory::create(url));
+        FFmpegDemuxer demuxer;
+        if (!input || !input->open(url) || !demuxer.initialize(input)) {
+            failFile(job, "无法打开 " + url + (input ? ": " + input->getLastError() : ""));
+            return;
+        }
+        const int video_index = demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+        const AVCodecParameters* codecpar = demuxer.getCodecParameters(video_index);
+        if (!codecpar || codecpar->width <= 0 || codecpar->height <= 0) {
+            failFile(job, "没有视频流: " + url);
+            return;
+        }
+
+        AVFormatContext* format_ctx = input->getFormatContext();
+        const AVStream* stream = format_ctx->streams[video_index];
+        time_base_ = stream->time_base;
+        start_us_ = format_ctx->start_time != AV_NOPTS_VALUE ? format_ctx->start_time : 0;
+        const AVRational frame_rate = av_guess_frame_rate(format_ctx, const_cast<AVStream*>(stream), nullptr);
+        half_frame_ = frame_rate.num > 0 && frame_rate.den > 0
+                          ? av_rescale_q(1, av_inv_q(frame_rate), time_base_) / 2 : 0;
+
+        // 第一次处理这个文件：规划时间点，过长时切成多段交给其他线程
+        if (whole_file) {
+            std::vector<int64_t> samples = planSamples(owner_.spec_, demuxer.getDuration());
+            if (samples.empty()) {
+                failFile(job, "没有落在文件范围内的时间点: " + url);
+                return;
+            }
+            owner_.stats_.files_done++;
+            const size_t per_job = std::max<size_t>(1, owner_.config_.samples_per_job);
+            std::vector<Job> split;
+            for (size_t first = per_job; first < samples.size(); first += per_job) {
+                Job part;
+                part.file_index = job.file_index;
+                part.first_sample = first;
+                part.samples_us.assign(samples.begin() + first,
+                                       samples.begin() + std::min(samples.size(), first + per_job));
+                split.push_back(std::move(part));
+            }
+            samples.resize(std::min(samples.size(), per_job));
+            job.samples_us = std::move(samples);
+            owner_.pushJobs(std::move(split));
+        }
+
+        keyframes_ = demuxer.buildKeyframeIndex(video_index);
+
+        // 并行度来自多个工作线程，单个解码器用单线程、无帧级延迟
+        FFmpegVideoDecoder::Config decoder_config;
+        decoder_config.thread_count = 1;
+        decoder_config.low_delay = true;
+        FFmpegVideoDecoder decoder(decoder_config);
+        if (!decoder.initialize(codecpar)) {
+            failSamples(job, url + ": " + decoder.getLastError());
+            return;
+        }
+
+        VideoConvertParams params;
+        params.src_width = codecpar->width;
+        params.src_height = codecpar->height;
+        params.src_format = static_cast<AVPixelFormat>(codecpar->format) != AV_PIX_FMT_NONE
+                                ? static_cast<AVPixelFormat>(codecpar->format) : AV_PIX_FMT_YUV420P;
+        outputSize(codecpar->width, codecpar->height, codecpar->sample_aspect_ratio,
+                   owner_.config_.output_width, owner_.config_.output_height,
+                   &params.dst_width, &params.dst_height);
+        params.dst_format = outputFormat();
+        FFmpegVideoConverter converter;
+        if (!converter.initialize(params)) {
+            failSamples(job, url + ": " + converter.getLastError());
+            return;
+        }
+
+        positioned_ = false;
+        current_gop_ = -1;
+        eof_sent_ = false;
+        discard_ = AVDISCARD_DEFAULT;
+        av_frame_unref(previous_);
+        const std::string stem = fileStem(url);
+        int64_t last_keyframe_target = AV_NOPTS_VALUE;
+
+        for (size_t i = 0; i < job.samples_us.size() && !owner_.stop_requested_.load(); ++i) {
+            ExtractedFrame info;
+            info.file_index = job.file_index;
+            info.sample_index = job.first_sample + i;
+            info.requested_us = job.samples_us[i];
+            info.pixel_format = params.dst_format;
+            if (owner_.config_.target == OutputTarget::Files) {
+                info.path = imagePath(owner_.config_.output_directory, job.file_index, stem,
+                                      info.sample_index, owner_.config_.image_format);
+            }
+
+            const int64_t target = av_rescale_q(info.requested_us + start_us_, AV_TIME_BASE_Q, time_base_);
+            const int gop = gopOf(target);
+            if (owner_.spec_.keyframes_only) {
+                // 多个时间点落在同一个关键帧上时只输出一次
+                const int64_t keyframe_target = gop >= 0 ? keyframes_[gop] : target;
+                if (keyframe_target == last_keyframe_target) {
+                    continue;
+                }
+                last_keyframe_target = keyframe_target;
+            }
+
+            AVFrame* frame = nullptr;
+            {
+                ScopedLatency timing(owner_.decode_metric_);
+                frame = owner_.spec_.keyframes_only ? decodeKeyframe(demuxer, decoder, video_index, target, gop)
+                                                    : decodeAt(demuxer, decoder, video_index, target, gop);
+            }
+            if (!frame) {
+                owner_.stats_.frames_failed++;
+                continue;
+            }
+            info.keyframe = isKeyFrame(frame);
+            const int64_t ts = frameTimestamp(frame);
+            info.timestamp_us = ts != AV_NOPTS_VALUE ? av_rescale_q(ts, time_base_, AV_TIME_BASE_Q) - start_us_
+                                                     : info.requested_us;
+            batch_.push_back(PendingFrame{info, frame});
+            if (batch_.size() >= std::max<size_t>(1, owner_.config_.batch_size)) {
+                flushBatch(converter);
+            }
+        }
+        flushBatch(converter);
+    }
+
+private:
+    AVPixelFormat outputFormat() const {
+        if (owner_.config_.target == OutputTarget::Buffer) {
+            return owner_.config_.buffer_format;
+        }
+        // 直接转成编码器的原生格式，SnapshotService不再转换
+        return owner_.config_.image_format == SnapshotService::ImageFormat::PNG ? AV_PIX_FMT_RGB24
+                                                                                : AV_PIX_FMT_YUVJ420P;
+    }
+
+    // 目标所在GOP（关键帧索引中不大于target的最后一项），没有索引时返回-1
+    int gopOf(int64_t target) const {
+        auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), target);
+        return it == keyframes_.begin() ? (keyframes_.empty() ? -1 : 0)
+                                        : static_cast<int>(it - keyframes_.begin()) - 1;
+    }
+
+    void seekTo(FFmpegDemuxer& demuxer, FFmpegVideoDecoder& decoder, int video_index, int64_t target, int gop) {
+        decoder.flush();
+        av_frame_unref(previous_);
+        const bool ok = gop >= 0 ? demuxer.seek(video_index, keyframes_[gop])
+                                 : demuxer.seekToTime(av_rescale_q(target, time_base_, AV_TIME_BASE_Q) - start_us_);
+        positioned_ = ok;
+        current_gop_ = gop;
+        eof_sent_ = false;
+        owner_.stats_.seeks++;
+    }
+
+    void setDiscard(FFmpegVideoDecoder& decoder, AVDiscard discard) {
+        if (discard_ != discard) {
+            decoder.setSkipFrame(discard);
+            discard_ = discard;
+        }
+    }
+
+    /**
+     * @brief 精确模式：解码到第一帧显示时间不早于target的帧
+     *
+     * 同一GOP内的后续时间点接着往后解，不重新seek；target之前的非参考帧不解码。
+     */
+    AVFrame* decodeAt(FFmpegDemuxer& demuxer, FFmpegVideoDecoder& decoder, int video_index, int64_t target, int gop) {
+        const int64_t threshold = target - half_frame_;
+        const int64_t last = frameTimestamp(previous_);
+        if (!positioned_ || gop != current_gop_ || gop < 0 ||
+            (previous_->buf[0] && last != AV_NOPTS_VALUE && last >= threshold)) {
+            seekTo(demuxer, decoder, video_index, target, gop);
+        }
+
+        size_t packets = 0;
+        while (!owner_.stop_requested_.load()) {
+            if (decoder.receiveFrame(decoded_)) {
+                owner_.stats_.frames_decoded++;
+                const int64_t ts = frameTimestamp(decoded_);
+                av_frame_unref(previous_);
+                av_frame_move_ref(previous_, decoded_);
+                if (ts == AV_NOPTS_VALUE || ts >= threshold) {
+                    return cloneOf(previous_);
+                }
+                continue;
+            }
+            if (eof_sent_) {
+                // 文件末尾：目标超出最后一帧时取最后一帧
+                return previous_->buf[0] ? cloneOf(previous_) : nullptr;
+            }
+            if (packets++ >= owner_.config_.max_packets_per_sample) {
+                return nullptr;
+            }
+            if (!demuxer.readPacket(packet_)) {
+                decoder.sendPacket(nullptr);
+                eof_sent_ = true;
+                continue;
+            }
+            owner_.stats_.packets_read++;
+            if (packet_->stream_index == video_index) {
+                // 显示时间早于目标的帧不会被输出，是非参考帧时直接丢弃
+                const bool before = packet_->pts != AV_NOPTS_VALUE && packet_->pts < threshold;
+                setDiscard(decoder, before ? AVDISCARD_NONREF : AVDISCARD_DEFAULT);
+                decoder.sendPacket(packet_);
+            }
+            av_packet_unref(packet_);
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief 关键帧模式：seek到目标之前的关键帧，只解码这一个关键帧
+     */
+    AVFrame* decodeKeyframe(FFmpegDemuxer& demuxer, FFmpegVideoDecoder& decoder, int video_index,
+                            int64_t target, int gop) {
+        seekTo(demuxer, decoder, video_index, target, gop);
+        size_t packets = 0;
+        while (!owner_.stop_requested_.load() && packets++ < owner_.config_.max_packets_per_sample) {
+            if (!demuxer.readPacket(packet_)) {
+                break;
+            }
+            owner_.stats_.packets_read++;
+            const bool is_key = packet_->stream_index == video_index && (packet_->flags & AV_PKT_FLAG_KEY);
+            if (!is_key) {
+                av_packet_unref(packet_);
+                continue;
+            }
+            decoder.sendPacket(packet_);
+            av_packet_unref(packet_);
+            // 有重排序延迟的码流不会立即输出，排空拿到这一帧（下一个时间点会重新seek并flush）
+            bool got_frame = decoder.receiveFrame(decoded_);
+            if (!got_frame) {
+                decoder.sendPacket(nullptr);
+                eof_sent_ = true;
+                got_frame = decoder.receiveFrame(decoded_);
+            }
+            if (!got_frame) {
+                return nullptr;
+            }
+            owner_.stats_.frames_decoded++;
+            AVFrame* frame = av_frame_alloc();
+            av_frame_move_ref(frame, decoded_);
+            return frame;
+        }
+        return nullptr;
+    }
+
+    static AVFrame* cloneOf(const AVFrame* frame) {
+        // 只增加引用，不拷贝像素
+        return av_frame_clone(frame);
+    }
+
+    void flushBatch(FFmpegVideoConverter& converter) {
+        if (batch_.empty()) {
+            return;
+        }
+        const bool to_buffer = owner_.config_.target == OutputTarget::Buffer;
+        const AVPixelFormat format = outputFormat();
+        const VideoConvertParams params = converter.getParams();
+
+        std::vector<const AVFrame*> src_frames(batch_.size());
+        std::vector<AVFrame*> dst_frames(batch_.size(), nullptr);
+        std::vector<bool> usable(batch_.size(), true);
+        for (size_t i = 0; i < batch_.size(); ++i) {
+            ExtractedFrame& info = batch_[i].info;
+            info.width = params.dst_width;
+            info.height = params.dst_height;
+            src_frames[i] = batch_[i].frame;
+
+            AVFrame* dst = av_frame_alloc();
+            dst->format = format;
+            dst->width = params.dst_width;
+            dst->height = params.dst_height;
+            if (to_buffer) {
+                // 转换结果直接写进调用方的缓冲区
+                const int size = av_image_get_buffer_size(format, dst->width, dst->height, 1);
+                const size_t offset = size > 0 ? owner_.buffer_used_.fetch_add(static_cast<size_t>(size)) : 0;
+                if (size <= 0 || offset + static_cast<size_t>(size) > owner_.buffer_capacity_) {
+                    usable[i] = false;
+                } else {
+                    info.buffer_offset = offset;
+                    info.buffer_bytes = static_cast<size_t>(size);
+                    av_image_fill_arrays(dst->data, dst->linesize, owner_.buffer_ + offset,
+                                         format, dst->width, dst->height, 1);
+                }
+            } else if (av_frame_get_buffer(dst, 0) < 0) {
+                usable[i] = false;
+            }
+            dst_frames[i] = dst;
+        }
+
+        // 缓冲已满的帧不参与转换（convertBatch遇到失败就停止，放到最后）
+        size_t ready = 0;
+        for (size_t i = 0; i < batch_.size(); ++i) {
+            if (usable[i]) {
+                std::swap(batch_[ready], batch_[i]);
+                std::swap(src_frames[ready], src_frames[i]);
+                std::swap(dst_frames[ready], dst_frames[i]);
+                ready++;
+            }
+        }
+        size_t converted = 0;
+        {
+            ScopedLatency timing(owner_.convert_metric_);
+            converted = converter.convertBatch(src_frames.data(), dst_frames.data(), ready);
+        }
+
+        for (size_t i = 0; i < batch_.size(); ++i) {
+            ExtractedFrame& info = batch_[i].info;
+            if (i >= converted) {
+                owner_.stats_.frames_failed++;
+                av_frame_free(&dst_frames[i]);
+            } else if (to_buffer) {
+                owner_.stats_.frames_extracted++;
+                owner_.stats_.bytes_written += info.buffer_bytes;
+                owner_.addResult(info);
+                av_frame_free(&dst_frames[i]);
+            } else {
+                // 图片所有权交给编码服务
+                owner_.submitImage(info, dst_frames[i]);
+            }
+        }
+        releaseBatch();
+    }
+
+    void releaseBatch() {
+        for (PendingFrame& pending : batch_) {
+            av_frame_free(&pending.frame);
+        }
+        batch_.clear();
+    }
+
+    void failFile(const Job& job, const std::string& error) {
+        if (job.samples_us.empty()) {
+            owner_.stats_.files_failed++;
+        } else {
+            owner_.stats_.frames_failed += job.samples_us.size();
+        }
+        owner_.addError(error);
+    }
+
+    void failSamples(const Job& job, const std::string& error) {
+        owner_.stats_.frames_failed += job.samples_us.size();
+        owner_.addError(error);
+    }
+
+private:
+    FrameExtractor& owner_;
+    AVPacket* packet_ = nullptr;
+    AVFrame* decoded_ = nullptr;
+    AVFrame* previous_ = nullptr;       // 最近解码出的帧（精确模式判断是否已越过目标、文件末尾兜底）
+    std::vector<PendingFrame> batch_;
+
+    // 当前任务
+    std::vector<int64_t> keyframes_;    // 流时间基
+    AVRational time_base_ = {1, AV_TIME_BASE};
+    int64_t start_us_ = 0;
+    int64_t half_frame_ = 0;            // 半帧时长（流时间基），用于时间戳取整误差
+    bool positioned_ = false;
+    int current_gop_ = -1;
+    bool eof_sent_ = false;
+    AVDiscard discard_ = AVDISCARD_DEFAULT;
+};
+
+FrameExtractor::FrameExtractor(const Config& config)
+    : config_(config)
+    , decode_metric_(MetricsRegistry::instance().latency("stage.extract_decode"))
+    , convert_metric_(MetricsRegistry::instance().latency("stage.extract_convert")) {
+}
+
+FrameExtractor::~FrameExtractor() {
+    stop();
+}
+
+void FrameExtractor::setOutputBuffer(uint8_t* buffer, size_t capacity) {
+    buffer_ = buffer;
+    buffer_capacity_ = buffer ? capacity : 0;
+}
+
+void FrameExtractor::setFrameCallback(FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    frame_callback_ = std::move(callback);
+}
+
+bool FrameExtractor::run(const std::vector<std::string>& files, const SamplingSpec& spec) {
+    if (files.empty()) {
+        setError("没有输入文件");
+        return false;
+    }
+    if ((spec.mode == SamplingSpec::Mode::Interval && spec.interval_us <= 0) ||
+        (spec.mode == SamplingSpec::Mode::Timestamps && spec.timestamps_us.empty())) {
+        setError("无效的采样规则");
+        return false;
+    }
+    if (config_.target == OutputTarget::Buffer && (!buffer_ || buffer_capacity_ == 0)) {
+        setError("缓冲输出需要先调用setOutputBuffer");
+        return false;
+    }
+    if (config_.target == OutputTarget::Files && config_.output_directory.empty()) {
+        setError("文件输出需要output_directory");
+        return false;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    files_ = files;
+    spec_ = spec;
+    stats_.reset();
+    buffer_used_.store(0);
+    stop_requested_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        results_.clear();
+        errors_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        jobs_.clear();
+        jobs_in_flight_ = 0;
+        for (size_t i = 0; i < files_.size(); ++i) {
+            Job job;
+            job.file_index = i;
+            jobs_.push_back(std::move(job));
+        }
+    }
+
+    int worker_count = config_.worker_count > 0 ? config_.worker_count
+                                                : static_cast<int>(std::thread::hardware_concurrency());
+    worker_count = std::max(1, worker_count);
+    stats_.workers.store(worker_count);
+
+    if (config_.target == OutputTarget::Files) {
+        // 编码队列按抽帧线程的批量留足余量，队列满时抽帧线程等待
+        SnapshotService::Config encoder_config;
+        encoder_config.worker_count = worker_count;
+        encoder_config.max_pending = static_cast<size_t>(worker_count) * std::max<size_t>(1, config_.batch_size) * 2;
+        encoder_config.max_pending_per_stream = encoder_config.max_pending;
+        encoder_config.jpeg_quality = config_.jpeg_quality;
+        encoder_ = std::make_unique<SnapshotService>(encoder_config);
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&FrameExtractor::workerLoop, this);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (encoder_) {
+        if (!stop_requested_.load()) {
+            encoder_->waitIdle(INT_MAX);
+        }
+        encoder_->stop();
+        encoder_.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        std::sort(results_.begin(), results_.end(), [](const ExtractedFrame& a, const ExtractedFrame& b) {
+            return a.file_index != b.file_index ? a.file_index < b.file_index : a.sample_index < b.sample_index;
+        });
+    }
+    stats_.elapsed_ms.store(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time).count());
+
+    if (results_.empty()) {
+        setError(stop_requested_.load() ? "抽帧已停止" : "没有抽出任何帧");
+        return false;
+    }
+    return true;
+}
+
+void FrameExtractor::stop() {
+    stop_requested_.store(true);
+    job_cv_.notify_all();
+}
+
+std::vector<std::string> FrameExtractor::getErrors() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    return errors_;
+}
+
+std::string FrameExtractor::getLastError() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    return last_error_;
+}
+
+std::vector<int64_t> FrameExtractor::planSamples(const SamplingSpec& spec, int64_t duration_us) {
+    std::vector<int64_t> samples;
+    if (spec.mode == SamplingSpec::Mode::Interval) {
+        int64_t end = spec.end_us;
+        if (duration_us > 0) {
+            end = end >= 0 ? std::min(end, duration_us) : duration_us;
+        }
+        if (spec.interval_us <= 0 || end < 0) {
+            return samples;
+        }
+        for (int64_t t = std::max<int64_t>(0, spec.start_us); t < end; t += spec.interval_us) {
+            samples.push_back(t);
+        }
+    } else {
+        for (int64_t t : spec.timestamps_us) {
+            if (t >= 0 && (duration_us <= 0 || t < duration_us)) {
+                samples.push_back(t);
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+        samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+    }
+    if (spec.max_frames_per_file > 0 && samples.size() > spec.max_frames_per_file) {
+        samples.resize(spec.max_frames_per_file);
+    }
+    return samples;
+}
+
+void FrameExtractor::outputSize(int src_width, int src_height, AVRational sample_aspect_ratio,
+                                int requested_width, int requested_height, int* width, int* height) {
+    double display_width = src_width;
+    if (sample_aspect_ratio.num > 0 && sample_aspect_ratio.den > 0) {
+        display_width = display_width * sample_aspect_ratio.num / sample_aspect_ratio.den;
+    }
+    if (requested_width > 0 && requested_height > 0) {
+        *width = requested_width;
+        *height = requested_height;
+    } else if (requested_width > 0) {
+        *width = requested_width;
+        *height = std::max(2, static_cast<int>(requested_width * src_height / display_width + 0.5) & ~1);
+    } else if (requested_height > 0) {
+        *width = std::max(2, static_cast<int>(requested_height * display_width / src_height + 0.5) & ~1);
+        *height = requested_height;
+    } else {
+        *width = src_width;
+        *height = src_height;
+    }
+}
+
+void FrameExtractor::workerLoop() {
+    Worker worker(*this);
+    Job job;
+    while (takeJob(job)) {
+        stats_.jobs++;
+        worker.process(job);
+        finishJob();
+    }
+}
+
+bool FrameExtractor::takeJob(Job& job) {
+    std::unique_lock<std::mutex> lock(job_mutex_);
+    // 队列空但还有任务在处理时等待：它们可能切出新的任务
+    job_cv_.wait(lock, [this]() {
+        return stop_requested_.load() || !jobs_.empty() || jobs_in_flight_ == 0;
+    });
+    if (stop_requested_.load() || jobs_.empty()) {
+        return false;
+    }
+    job = std::move(jobs_.front());
+    jobs_.pop_front();
+    jobs_in_flight_++;
+    return true;
+}
+
+void FrameExtractor::pushJobs(std::vector<Job> jobs) {
+    if (jobs.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        // 放到队首：同一文件的各段尽快完成，结果可以按文件交付
+        for (auto it = jobs.rbegin(); it != jobs.rend(); ++it) {
+            jobs_.push_front(std::move(*it));
+        }
+    }
+    job_cv_.notify_all();
+}
+
+void FrameExtractor::finishJob() {
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        jobs_in_flight_--;
+    }
+    job_cv_.notify_all();
+}
+
+bool FrameExtractor::submitImage(ExtractedFrame info, AVFrame* image) {
+    SnapshotService::Request request;
+    request.frame = ffmpeg::SharedPointerFactory::wrapFrame(image);
+    request.path = info.path;
+    request.format = config_.image_format;
+    request.callback = [this, info](const SnapshotService::Result& result) {
+        if (!result.success) {
+            stats_.frames_failed++;
+            addError(info.path + ": " + result.error);
+            return;
+        }
+        stats_.frames_extracted++;
+        stats_.bytes_written += result.data ? result.data->size() : 0;
+        addResult(info);
+    };
+
+    // 编码队列满时等待，批量抽帧不丢帧
+    while (!stop_requested_.load()) {
+        if (encoder_->submit(request) != 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    stats_.frames_failed++;
+    return false;
+}
+
+void FrameExtractor::addResult(const ExtractedFrame& frame) {
+    FrameCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        results_.push_back(frame);
+        callback = frame_callback_;
+    }
+    if (callback) {
+        callback(frame);
+    }
+}
+
+void FrameExtractor::addError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    errors_.push_back(error);
+    last_error_ = error;
+}
+
+void FrameExtractor::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    last_error_ = error;
+}
+
+} // namespace media
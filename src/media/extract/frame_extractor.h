@@ -0,0 +1,291 @@
+#ifndef FRAME_EXTRACTOR_H
+#define FRAME_EXTRACTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../snapshot/snapshot_service.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+namespace media {
+
+/**
+ * @brief 抽帧采样方式
+ */
+struct SamplingSpec {
+    enum class Mode {
+        Interval,       // 从start_us起每隔interval_us一帧
+        Timestamps      // 指定时间点列表
+    };
+
+    Mode mode;
+    int64_t interval_us;
+    int64_t start_us;
+    int64_t end_us;                         // <0为到文件末尾
+    std::vector<int64_t> timestamps_us;     // Timestamps模式的时间点（相对文件开头，微秒）
+    bool keyframes_only;                    // 取目标之前最近的关键帧，只解码关键帧（最快，时间不精确）
+    size_t max_frames_per_file;             // 每个文件最多抽取的帧数，0为不限
+
+    SamplingSpec()
+        : mode(Mode::Interval)
+        , interval_us(1000000)
+        , start_us(0)
+        , end_us(-1)
+        , keyframes_only(false)
+        , max_frames_per_file(0)
+    {}
+};
+
+/**
+ * @brief 抽出的一帧
+ */
+struct ExtractedFrame {
+    size_t file_index = 0;          // 在输入文件列表中的位置
+    size_t sample_index = 0;        // 在该文件采样时间点中的位置
+    int64_t requested_us = 0;       // 请求的时间点
+    int64_t timestamp_us = 0;       // 实际帧的显示时间
+    bool keyframe = false;
+    int width = 0;
+    int height = 0;
+    AVPixelFormat pixel_format = AV_PIX_FMT_NONE;
+    std::string path;               // 写入的图片（文件输出）
+    size_t buffer_offset = 0;       // 在输出缓冲中的偏移（缓冲输出）
+    size_t buffer_bytes = 0;
+};
+
+/**
+ * @brief 批量抽帧：按采样规则从大量文件中抽帧，写成图片或写进调用方提供的（共享）内存
+ *
+ * 设计特点：
+ * 1. 按需解码：用关键帧索引定位目标所在的GOP，只有目标跨GOP时才seek；GOP内目标之前的非参考帧
+ *    直接丢弃（AVDISCARD_NONREF），关键帧模式下只把关键帧数据包送进解码器
+ * 2. 多核并行：任务队列按文件分发，长文件的时间点再切成多段放回队列，空闲线程接着处理同一文件，
+ *    单个长文件也能用满所有核；每个线程独立打开输入、单线程解码，线程之间没有共享状态
+ * 3. 批量转换：解码帧攒批后一次FFmpegVideoConverter::convertBatch完成缩放和格式转换
+ * 4. 两种输出：图片由独立的SnapshotService实例编码（队列满时抽帧线程等待，不丢帧）；
+ *    缓冲输出时转换结果直接写进调用方的缓冲区（可以是shm/memfd映射），不再拷贝
+ *
+ * run阻塞到全部完成；stop可在其他线程调用。
+ */
+class FrameExtractor {
+public:
+    /**
+     * @brief 输出目标
+     */
+    enum class OutputTarget {
+        Files,          // 每帧一张图片，写到output_directory
+        Buffer          // 原始像素写进setOutputBuffer提供的缓冲区
+    };
+
+    /**
+     * @brief 抽帧配置
+     */
+    struct Config {
+        int worker_count;               // 工作线程数，0为CPU核数
+        size_t samples_per_job;         // 一个任务最多处理的时间点数，超出的切成新任务
+        size_t batch_size;              // 批量转换帧数
+        int output_width;               // 输出宽度，0为原始宽度
+        int output_height;              // 输出高度，0为按宽高比计算
+        OutputTarget target;
+        std::string output_directory;   // 图片输出目录（需已存在）
+        SnapshotService::ImageFormat image_format;
+        int jpeg_quality;
+        AVPixelFormat buffer_format;    // 缓冲输出的像素格式
+        size_t max_packets_per_sample;  // 单个时间点最多读取的数据包数（防止坏文件卡住）
+
+        Config()
+            : worker_count(0)
+            , samples_per_job(32)
+            , batch_size(8)
+            , output_width(0)
+            , output_height(0)
+            , target(OutputTarget::Files)
+            , image_format(SnapshotService::ImageFormat::JPEG)
+            , jpeg_quality(90)
+            , buffer_format(AV_PIX_FMT_RGB24)
+            , max_packets_per_sample(5000)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t files_done;
+        uint64_t files_failed;
+        uint64_t jobs;
+        uint64_t frames_extracted;
+        uint64_t frames_failed;         // 解码、转换、编码失败或缓冲已满
+        uint64_t seeks;
+        uint64_t packets_read;
+        uint64_t frames_decoded;        // 解码器输出的帧（含目标之前被丢弃的帧）
+        uint64_t bytes_written;         // 图片或缓冲的总字节
+        double elapsed_ms;              // 上一次run的耗时
+        int workers;                    // 上一次run的线程数
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> files_done{0};
+        std::atomic<uint64_t> files_failed{0};
+        std::atomic<uint64_t> jobs{0};
+        std::atomic<uint64_t> frames_extracted{0};
+        std::atomic<uint64_t> frames_failed{0};
+        std::atomic<uint64_t> seeks{0};
+        std::atomic<uint64_t> packets_read{0};
+        std::atomic<uint64_t> frames_decoded{0};
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<double> elapsed_ms{0.0};
+        std::atomic<int> workers{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                files_done.load(),
+                files_failed.load(),
+                jobs.load(),
+                frames_extracted.load(),
+                frames_failed.load(),
+                seeks.load(),
+                packets_read.load(),
+                frames_decoded.load(),
+                bytes_written.load(),
+                elapsed_ms.load(),
+                workers.load()
+            };
+        }
+
+        void reset() {
+            files_done.store(0);
+            files_failed.store(0);
+            jobs.store(0);
+            frames_extracted.store(0);
+            frames_failed.store(0);
+            seeks.store(0);
+            packets_read.store(0);
+            frames_decoded.store(0);
+            bytes_written.store(0);
+            elapsed_ms.store(0.0);
+            workers.store(0);
+        }
+    };
+
+    using FrameCallback = std::function<void(const ExtractedFrame&)>;
+
+public:
+    explicit FrameExtractor(const Config& config = Config{});
+    ~FrameExtractor();
+
+    FrameExtractor(const FrameExtractor&) = delete;
+    FrameExtractor& operator=(const FrameExtractor&) = delete;
+
+    /**
+     * @brief 设置缓冲输出的目标内存（run之前调用，调用方负责其生命周期）
+     */
+    void setOutputBuffer(uint8_t* buffer, size_t capacity);
+
+    /**
+     * @brief 每抽出一帧调用一次（缓冲输出在抽帧线程中、像素写入后调用；文件输出在编码线程中、图片落盘后调用）
+     */
+    void setFrameCallback(FrameCallback callback);
+
+    /**
+     * @brief 抽帧，阻塞到所有文件处理完成或被stop
+     * @return 参数无效或一帧都没有抽出时返回false；单个文件的错误记在getErrors()里
+     */
+    bool run(const std::vector<std::string>& files, const SamplingSpec& spec);
+
+    /**
+     * @brief 请求停止（任意线程），run尽快返回
+     */
+    void stop();
+
+    /**
+     * @brief 上一次run的结果，按文件和时间点排序
+     */
+    const std::vector<ExtractedFrame>& results() const { return results_; }
+
+    /**
+     * @brief 上一次run中各文件的错误
+     */
+    std::vector<std::string> getErrors() const;
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+    /**
+     * @brief 按采样规则计算一个文件的时间点（升序、去重）
+     * @param duration_us 文件时长，未知时传-1（此时Interval模式需要end_us）
+     */
+    static std::vector<int64_t> planSamples(const SamplingSpec& spec, int64_t duration_us);
+
+    /**
+     * @brief 输出尺寸：宽高都为0时保持原尺寸，只给一边时按显示宽高比计算另一边（取偶数）
+     */
+    static void outputSize(int src_width, int src_height, AVRational sample_aspect_ratio,
+                           int requested_width, int requested_height, int* width, int* height);
+
+private:
+    struct Job {
+        size_t file_index = 0;
+        size_t first_sample = 0;            // 在文件采样点中的起始位置
+        std::vector<int64_t> samples_us;    // 为空表示尚未规划（整个文件）
+    };
+    struct PendingFrame;
+    class Worker;
+
+    void workerLoop();
+    bool takeJob(Job& job);
+    void pushJobs(std::vector<Job> jobs);
+    void finishJob();
+    bool submitImage(ExtractedFrame info, AVFrame* image);
+    void addResult(const ExtractedFrame& frame);
+    void addError(const std::string& error);
+    void setError(const std::string& error);
+
+private:
+    Config config_;
+    SamplingSpec spec_;
+    std::vector<std::string> files_;
+
+    uint8_t* buffer_ = nullptr;
+    size_t buffer_capacity_ = 0;
+    std::atomic<size_t> buffer_used_{0};
+    std::unique_ptr<SnapshotService> encoder_;   // 文件输出时的图片编码线程
+
+    std::mutex job_mutex_;
+    std::condition_variable job_cv_;
+    std::deque<Job> jobs_;
+    size_t jobs_in_flight_ = 0;                 // 已领取未完成的任务（可能再切出新任务）
+    std::atomic<bool> stop_requested_{false};
+
+    mutable std::mutex result_mutex_;
+    std::vector<ExtractedFrame> results_;
+    std::vector<std::string> errors_;
+    FrameCallback frame_callback_;
+    std::string last_error_;
+
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& decode_metric_;
+    Metric& convert_metric_;
+};
+
+} // namespace media
+
+#endif // FRAME_EXTRACTOR_H
@@ -0,0 +1,491 @@
+#include "frame_bus.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace media {
+
+namespace {
+
+bool isKeyFrame(const AVFrame* frame) {
+#ifdef AV_FRAME_FLAG_KEY
+    return (frame->flags & AV_FRAME_FLAG_KEY) != 0;
+#else
+    return frame->key_frame != 0;
+#endif
+}
+
+// 跨进程futex（不带FUTEX_PRIVATE_FLAG），字的地址在各进程的映射里不同，内核按共享页定位
+void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// 返回false表示futex不可用（如只读映射在老内核上返回EFAULT），调用方改为短暂休眠
+bool futexWait(const std::atomic<uint32_t>* word, uint32_t expected, int64_t timeout_us) {
+    struct timespec timeout;
+    timeout.tv_sec = static_cast<time_t>(timeout_us / 1000000);
+    timeout.tv_nsec = static_cast<long>((timeout_us % 1000000) * 1000);
+    const long ret = syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), FUTEX_WAIT,
+                             expected, &timeout, nullptr, 0);
+    return ret == 0 || errno == EAGAIN || errno == ETIMEDOUT || errno == EINTR;
+}
+
+std::string errnoText(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+int64_t FrameBusLayout::monotonicNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+// ==================== FrameBusProducer ====================
+
+FrameBusProducer::FrameBusProducer(const Config& config)
+    : config_(config)
+    , publish_metric_(MetricsRegistry::instance().latency("stage.framebus_publish")) {
+}
+
+FrameBusProducer::~FrameBusProducer() {
+    close();
+}
+
+bool FrameBusProducer::open() {
+    close();
+
+    if (config_.slot_count < 2 || config_.max_width <= 0 || config_.max_height <= 0) {
+        last_error_ = "帧总线至少需要2个槽和有效的最大尺寸";
+        return false;
+    }
+    const int frame_bytes = av_image_get_buffer_size(config_.max_format, config_.max_width,
+                                                     config_.max_height, FrameBusLayout::kPlaneAlign);
+    if (frame_bytes <= 0) {
+        last_error_ = "无效的最大像素格式";
+        return false;
+    }
+    slot_bytes_ = FrameBusLayout::alignUp(static_cast<size_t>(frame_bytes), FrameBusLayout::kPageSize);
+    total_bytes_ = FrameBusLayout::totalBytes(config_.slot_count, slot_bytes_);
+
+    posix_shm_ = !config_.name.empty() && config_.name[0] == '/';
+    if (posix_shm_) {
+        fd_ = shm_open(config_.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd_ < 0 && errno == EEXIST) {
+            // 上次生产者崩溃留下的名称，已映射它的消费者不受影响
+            shm_unlink(config_.name.c_str());
+            fd_ = shm_open(config_.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+    } else {
+        fd_ = memfd_create(config_.name.empty() ? "media-frame-bus" : config_.name.c_str(),
+                           MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    }
+    if (fd_ < 0) {
+        last_error_ = errnoText(posix_shm_ ? "shm_open失败" : "memfd_create失败");
+        return false;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(total_bytes_)) != 0) {
+        last_error_ = errnoText("设置共享内存大小失败");
+        close();
+        return false;
+    }
+    if (!posix_shm_) {
+        // 封住尺寸，消费者不用担心映射之后文件被截短（SIGBUS）
+        fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    }
+
+    // MAP_POPULATE：第一圈发布时不再触发缺页
+    void* mapped = mmap(nullptr, total_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        last_error_ = errnoText("映射共享内存失败");
+        close();
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(mapped);
+
+    header_ = new (base_) FrameBusLayout::Header{};
+    header_->version = FrameBusLayout::kVersion;
+    header_->slot_count = config_.slot_count;
+    header_->slot_bytes = slot_bytes_;
+    header_->slots_offset = FrameBusLayout::slotsOffset();
+    header_->data_offset = FrameBusLayout::dataOffset(config_.slot_count);
+    header_->total_bytes = total_bytes_;
+    header_->producer_pid = static_cast<int32_t>(getpid());
+    for (uint32_t i = 0; i < config_.slot_count; ++i) {
+        new (slotAt(i)) FrameBusLayout::Slot{};
+    }
+    header_->producer_alive.store(1, std::memory_order_relaxed);
+    // magic最后写：按名称打开的消费者看到magic时其余字段都已就绪
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = FrameBusLayout::kMagic;
+
+    next_seq_ = 0;
+    writing_ = false;
+    return true;
+}
+
+void FrameBusProducer::close() {
+    if (base_) {
+        header_->producer_alive.store(0, std::memory_order_release);
+        header_->notify.fetch_add(1, std::memory_order_release);
+        futexWake(&header_->notify);
+        munmap(base_, total_bytes_);
+        base_ = nullptr;
+        header_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        if (posix_shm_ && config_.unlink_on_close) {
+            shm_unlink(config_.name.c_str());
+        }
+    }
+    writing_ = false;
+}
+
+std::string FrameBusProducer::path() const {
+    if (fd_ < 0) {
+        return std::string();
+    }
+    if (posix_shm_) {
+        return config_.name;
+    }
+    return "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd_);
+}
+
+FrameBusLayout::Slot* FrameBusProducer::slotAt(uint64_t seq) const {
+    return reinterpret_cast<FrameBusLayout::Slot*>(base_ + header_->slots_offset) + seq % header_->slot_count;
+}
+
+uint8_t* FrameBusProducer::dataAt(uint64_t seq) const {
+    return base_ + header_->data_offset + (seq % header_->slot_count) * slot_bytes_;
+}
+
+bool FrameBusProducer::publish(const AVFrame* frame, AVRational time_base) {
+    if (!frame || frame->width <= 0 || frame->height <= 0) {
+        stats_.frames_rejected.fetch_add(1);
+        last_error_ = "无效的帧";
+        return false;
+    }
+    if (frame->hw_frames_ctx) {
+        stats_.frames_rejected.fetch_add(1);
+        last_error_ = "硬件帧需要先用av_hwframe_transfer_data下载";
+        return false;
+    }
+
+    ScopedLatency timing(publish_metric_);
+    const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    uint8_t* data[FrameBusLayout::kMaxPlanes];
+    int linesize[FrameBusLayout::kMaxPlanes];
+    if (!beginSlot(frame->width, frame->height, format, data, linesize)) {
+        return false;
+    }
+    av_image_copy(data, linesize, const_cast<const uint8_t**>(frame->data), frame->linesize,
+                  format, frame->width, frame->height);
+    COPY_ACCOUNT("framebus.publish", av_image_get_buffer_size(format, frame->width, frame->height, 1));
+
+    const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp
+                                                                      : frame->pts;
+    endSlot(pts, time_base, isKeyFrame(frame));
+    return true;
+}
+
+bool FrameBusProducer::beginFrame(int width, int height, AVPixelFormat format, AVFrame* dst) {
+    if (!dst) {
+        return false;
+    }
+    uint8_t* data[FrameBusLayout::kMaxPlanes];
+    int linesize[FrameBusLayout::kMaxPlanes];
+    if (!beginSlot(width, height, format, data, linesize)) {
+        return false;
+    }
+    dst->format = format;
+    dst->width = width;
+    dst->height = height;
+    for (int i = 0; i < FrameBusLayout::kMaxPlanes; ++i) {
+        dst->data[i] = data[i];
+        dst->linesize[i] = linesize[i];
+    }
+    return true;
+}
+
+void FrameBusProducer::commitFrame(int64_t pts, AVRational time_base, bool keyframe) {
+    if (writing_) {
+        endSlot(pts, time_base, keyframe);
+    }
+}
+
+bool FrameBusProducer::beginSlot(int width, int height, AVPixelFormat format,
+                                 uint8_t* data[FrameBusLayout::kMaxPlanes],
+                                 int linesize[FrameBusLayout::kMaxPlanes]) {
+    if (!base_) {
+        last_error_ = "帧总线未打开";
+        return false;
+    }
+    if (writing_) {
+        last_error_ = "上一帧还没有commitFrame";
+        return false;
+    }
+    const int bytes = av_image_get_buffer_size(format, width, height, FrameBusLayout::kPlaneAlign);
+    if (bytes <= 0 || static_cast<size_t>(bytes) > slot_bytes_) {
+        stats_.frames_rejected.fetch_add(1);
+        last_error_ = "帧超出槽大小或像素格式无效";
+        return false;
+    }
+
+    // seqlock写端：先标记为奇数，之后的数据写入对看到旧偶数的读者可见时，读者的二次检查必然失败
+    FrameBusLayout::Slot* slot = slotAt(next_seq_);
+    slot->sequence.store(2 * next_seq_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* base = dataAt(next_seq_);
+    av_image_fill_arrays(data, linesize, base, format, width, height, FrameBusLayout::kPlaneAlign);
+    slot->format = format;
+    slot->width = width;
+    slot->height = height;
+    for (int i = 0; i < FrameBusLayout::kMaxPlanes; ++i) {
+        slot->linesize[i] = data[i] ? linesize[i] : 0;
+        slot->plane_offset[i] = data[i] ? static_cast<uint64_t>(data[i] - base) : 0;
+    }
+    slot->data_bytes = static_cast<uint64_t>(bytes);
+    writing_ = true;
+    return true;
+}
+
+void FrameBusProducer::endSlot(int64_t pts, AVRational time_base, bool keyframe) {
+    FrameBusLayout::Slot* slot = slotAt(next_seq_);
+    slot->pts = pts;
+    slot->time_base_num = time_base.num;
+    slot->time_base_den = time_base.den;
+    slot->flags = keyframe ? FrameBusLayout::kFlagKeyframe : 0;
+    slot->publish_time_ns = FrameBusLayout::monotonicNs();
+    slot->sequence.store(2 * next_seq_ + 2, std::memory_order_release);
+
+    ++next_seq_;
+    header_->write_seq.store(next_seq_, std::memory_order_release);
+    header_->notify.fetch_add(1, std::memory_order_release);
+    futexWake(&header_->notify);
+
+    writing_ = false;
+    stats_.frames_published.fetch_add(1);
+    stats_.bytes_published.fetch_add(slot->data_bytes);
+}
+
+// ==================== FrameBusConsumer ====================
+
+FrameBusConsumer::FrameBusConsumer(const Config& config)
+    : config_(config) {
+}
+
+FrameBusConsumer::~FrameBusConsumer() {
+    close();
+}
+
+bool FrameBusConsumer::open(const std::string& name) {
+    close();
+
+    // "/name"是POSIX shm名称，其他带'/'的按文件路径打开（/proc/<pid>/fd/<fd>、/dev/shm/xxx）
+    const bool shm_name = name.size() > 1 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+    const int fd = shm_name ? shm_open(name.c_str(), O_RDONLY, 0)
+                            : ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        last_error_ = errnoText(("打开帧总线失败 " + name).c_str());
+        return false;
+    }
+    const bool ok = mapFd(fd);
+    ::close(fd);    // 映射不依赖描述符
+    return ok;
+}
+
+bool FrameBusConsumer::openFd(int fd) {
+    close();
+    return mapFd(fd);
+}
+
+bool FrameBusConsumer::mapFd(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        last_error_ = errnoText("fstat失败");
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (size < FrameBusLayout::slotsOffset()) {
+        last_error_ = "帧总线尚未初始化";
+        return false;
+    }
+    // 只读映射：消费者无法破坏其他消费者看到的帧
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        last_error_ = errnoText("映射帧总线失败");
+        return false;
+    }
+    const auto* header = static_cast<const FrameBusLayout::Header*>(mapped);
+    const uint32_t magic = header->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (magic != FrameBusLayout::kMagic || header->version != FrameBusLayout::kVersion ||
+        header->slot_count < 2 || header->total_bytes > size ||
+        header->data_offset + header->slot_bytes * header->slot_count > size) {
+        munmap(mapped, size);
+        last_error_ = "不是帧总线或版本不兼容";
+        return false;
+    }
+
+    base_ = static_cast<const uint8_t*>(mapped);
+    total_bytes_ = size;
+    header_ = header;
+
+    // 从环中最旧的有效帧开始
+    const uint64_t written = header_->write_seq.load(std::memory_order_acquire);
+    read_seq_ = written >= header_->slot_count ? written - header_->slot_count + 1 : 0;
+    return true;
+}
+
+void FrameBusConsumer::close() {
+    if (base_) {
+        munmap(const_cast<uint8_t*>(base_), total_bytes_);
+        base_ = nullptr;
+        header_ = nullptr;
+        total_bytes_ = 0;
+    }
+    read_seq_ = 0;
+}
+
+void FrameBusConsumer::seekToLatest() {
+    if (header_) {
+        const uint64_t written = header_->write_seq.load(std::memory_order_acquire);
+        read_seq_ = written > 0 ? written - 1 : 0;
+    }
+}
+
+const FrameBusLayout::Slot* FrameBusConsumer::slotAt(uint64_t seq) const {
+    return reinterpret_cast<const FrameBusLayout::Slot*>(base_ + header_->slots_offset) +
+           seq % header_->slot_count;
+}
+
+bool FrameBusConsumer::producerClosed() const {
+    if (!header_) {
+        return true;
+    }
+    if (header_->producer_alive.load(std::memory_order_acquire) == 0) {
+        return true;
+    }
+    // 生产者崩溃时alive来不及清零
+    return kill(header_->producer_pid, 0) != 0 && errno == ESRCH;
+}
+
+bool FrameBusConsumer::next(FrameView& view, int timeout_ms) {
+    if (!header_) {
+        last_error_ = "帧总线未打开";
+        return false;
+    }
+    const uint64_t slot_count = header_->slot_count;
+    const int64_t deadline_ns = FrameBusLayout::monotonicNs() + static_cast<int64_t>(timeout_ms) * 1000000LL;
+
+    for (;;) {
+        // 先取futex字再看write_seq，两者之间发布的帧会让FUTEX_WAIT立即返回，不会丢唤醒
+        const uint32_t notify = header_->notify.load(std::memory_order_acquire);
+        const uint64_t written = header_->write_seq.load(std::memory_order_acquire);
+
+        if (read_seq_ < written) {
+            if (config_.latest_only && read_seq_ + 1 < written) {
+                stats_.frames_missed.fetch_add(written - 1 - read_seq_);
+                read_seq_ = written - 1;
+            } else if (written - read_seq_ >= slot_count) {
+                // 落后一圈：read_seq_所在的槽就是生产者下一个要写的槽
+                const uint64_t oldest = written - slot_count + 1;
+                stats_.frames_missed.fetch_add(oldest - read_seq_);
+                read_seq_ = oldest;
+            }
+
+            const uint64_t seq = read_seq_++;
+            const FrameBusLayout::Slot* slot = slotAt(seq);
+            const uint64_t expected = 2 * seq + 2;
+            if (slot->sequence.load(std::memory_order_acquire) != expected) {
+                stats_.frames_missed.fetch_add(1);
+                continue;
+            }
+
+            view.sequence = seq;
+            view.pts = slot->pts;
+            view.time_base = AVRational{slot->time_base_num, slot->time_base_den};
+            view.format = static_cast<AVPixelFormat>(slot->format);
+            view.width = slot->width;
+            view.height = slot->height;
+            view.keyframe = (slot->flags & FrameBusLayout::kFlagKeyframe) != 0;
+            view.data_bytes = static_cast<size_t>(slot->data_bytes);
+            view.publish_time_ns = slot->publish_time_ns;
+            const uint8_t* data = base_ + header_->data_offset + (seq % slot_count) * header_->slot_bytes;
+            for (int i = 0; i < FrameBusLayout::kMaxPlanes; ++i) {
+                view.linesize[i] = slot->linesize[i];
+                view.data[i] = slot->linesize[i] != 0 ? data + slot->plane_offset[i] : nullptr;
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != expected ||
+                view.data_bytes > header_->slot_bytes) {
+                stats_.frames_torn.fetch_add(1);
+                continue;
+            }
+            stats_.frames_read.fetch_add(1);
+            return true;
+        }
+
+        if (producerClosed()) {
+            return false;
+        }
+        const int64_t remaining_ns = deadline_ns - FrameBusLayout::monotonicNs();
+        if (timeout_ms <= 0 || remaining_ns <= 0) {
+            return false;
+        }
+        stats_.waits.fetch_add(1);
+        if (!futexWait(&header_->notify, notify, remaining_ns / 1000)) {
+            usleep(static_cast<useconds_t>(std::min<int64_t>(remaining_ns / 1000, 1000)));
+        }
+    }
+}
+
+bool FrameBusConsumer::finish(const FrameView& view) {
+    if (!header_) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slotAt(view.sequence)->sequence.load(std::memory_order_relaxed) != 2 * view.sequence + 2) {
+        stats_.frames_torn.fetch_add(1);
+        return false;
+    }
+    return true;
+}
+
+void FrameBusConsumer::fillFrame(const FrameView& view, AVFrame* frame) {
+    if (!frame) {
+        return;
+    }
+    frame->format = view.format;
+    frame->width = view.width;
+    frame->height = view.height;
+    frame->pts = view.pts;
+    for (int i = 0; i < FrameBusLayout::kMaxPlanes; ++i) {
+        frame->data[i] = const_cast<uint8_t*>(view.data[i]);
+        frame->linesize[i] = view.linesize[i];
+    }
+}
+
+} // namespace media
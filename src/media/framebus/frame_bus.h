@@ -0,0 +1,358 @@
+#ifndef FRAME_BUS_H
+#define FRAME_BUS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+namespace media {
+
+/**
+ * @brief 帧总线共享内存布局（生产者和所有消费者进程共用，只能放POD和免锁原子量）
+ *
+ * [FrameBusHeader，4096对齐] [FrameBusSlot × slot_count，4096对齐] [槽数据区 × slot_count，每个4096对齐]
+ */
+struct FrameBusLayout {
+    static constexpr uint32_t kMagic = 0x46425553;      // "FBUS"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kPageSize = 4096;
+    static constexpr int kPlaneAlign = 64;               // 行对齐，消费者可以直接用SIMD读
+    static constexpr int kMaxPlanes = 4;
+
+    /**
+     * @brief 总线头
+     */
+    struct alignas(64) Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t reserved;
+        uint64_t slot_bytes;                    // 每个槽的数据区大小
+        uint64_t slots_offset;                  // 槽元数据数组的偏移
+        uint64_t data_offset;                   // 第一个槽数据区的偏移
+        uint64_t total_bytes;
+        int32_t producer_pid;
+        std::atomic<uint32_t> producer_alive;   // 生产者关闭时清零，消费者据此结束
+        std::atomic<uint64_t> write_seq;        // 已发布的帧数（下一帧的序号）
+        std::atomic<uint32_t> notify;           // futex字，每发布一帧加一
+    };
+
+    /**
+     * @brief 一个槽的元数据（seqlock：sequence为2*seq+1表示正在写，2*seq+2表示第seq帧可读）
+     */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        int64_t pts;
+        int32_t time_base_num;
+        int32_t time_base_den;
+        int32_t format;                         // AVPixelFormat
+        int32_t width;
+        int32_t height;
+        int32_t flags;                          // kFlagKeyframe
+        int32_t linesize[kMaxPlanes];
+        uint64_t plane_offset[kMaxPlanes];      // 相对槽数据区开头
+        uint64_t data_bytes;
+        int64_t publish_time_ns;                // CLOCK_MONOTONIC，跨进程可比
+    };
+
+    static constexpr int32_t kFlagKeyframe = 1;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "帧总线需要免锁的64位原子量");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "帧总线需要免锁的32位原子量");
+
+    static size_t alignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+    static size_t slotsOffset() { return alignUp(sizeof(Header), kPageSize); }
+    static size_t dataOffset(uint32_t slot_count) {
+        return slotsOffset() + alignUp(sizeof(Slot) * slot_count, kPageSize);
+    }
+    static size_t totalBytes(uint32_t slot_count, size_t slot_bytes) {
+        return dataOffset(slot_count) + slot_bytes * slot_count;
+    }
+
+    /**
+     * @brief CLOCK_MONOTONIC纳秒，与Slot::publish_time_ns比较得到跨进程延迟
+     */
+    static int64_t monotonicNs();
+};
+
+/**
+ * @brief 帧总线生产者：把解码帧发布到共享内存环，同机其他进程映射后零拷贝读取
+ *
+ * 设计特点：
+ * 1. 共享内存：名称以'/'开头时用POSIX shm（消费者按名称打开），否则用memfd（通过fd()继承或SCM_RIGHTS传递，
+ *    也可以打开path()返回的/proc路径）；memfd加了尺寸封印，消费者可以信任映射大小
+ * 2. 无锁协议：单生产者、任意多消费者，每个槽一个seqlock序号；生产者从不等待消费者，
+ *    消费者落后超过一圈时跳到最旧的有效帧并计入丢帧
+ * 3. 每帧元数据：PTS、时间基、像素格式、宽高、每个平面的行宽和偏移，平面按64字节对齐
+ * 4. 唤醒：发布后对futex字FUTEX_WAKE，消费者不用轮询
+ *
+ * 典型用法是挂在MediaPipeline::setVideoFrameCallback上：publish只做一次平面拷贝（解码器帧池 -> 共享内存）。
+ * 只支持单生产者线程。
+ */
+class FrameBusProducer {
+public:
+    /**
+     * @brief 总线配置
+     */
+    struct Config {
+        std::string name;               // "/xxx"为POSIX shm名称，其他为memfd标签
+        uint32_t slot_count;            // 环中的槽数
+        int max_width;                  // 槽按最大尺寸和格式分配
+        int max_height;
+        AVPixelFormat max_format;
+        bool unlink_on_close;           // 关闭时删除POSIX shm名称
+
+        Config()
+            : name("media-frame-bus")
+            , slot_count(8)
+            , max_width(1920)
+            , max_height(1080)
+            , max_format(AV_PIX_FMT_YUV420P)
+            , unlink_on_close(true)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t frames_published;
+        uint64_t frames_rejected;       // 超出槽大小、硬件帧或格式无效
+        uint64_t bytes_published;
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> frames_published{0};
+        std::atomic<uint64_t> frames_rejected{0};
+        std::atomic<uint64_t> bytes_published{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                frames_published.load(),
+                frames_rejected.load(),
+                bytes_published.load()
+            };
+        }
+    };
+
+public:
+    explicit FrameBusProducer(const Config& config = Config{});
+    ~FrameBusProducer();
+
+    FrameBusProducer(const FrameBusProducer&) = delete;
+    FrameBusProducer& operator=(const FrameBusProducer&) = delete;
+
+    /**
+     * @brief 创建并映射共享内存（slot_count至少为2；同名POSIX shm已存在时视为上次崩溃残留，先删除）
+     */
+    bool open();
+
+    /**
+     * @brief 通知消费者结束，解除映射
+     */
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    /**
+     * @brief 发布一帧（拷贝平面到下一个槽）
+     * @param time_base 帧pts的时间基
+     * @return 帧超出槽大小或是硬件帧时返回false
+     */
+    bool publish(const AVFrame* frame, AVRational time_base);
+
+    /**
+     * @brief 直接在下一个槽里写一帧（如swscale输出），省掉publish的拷贝
+     *
+     * 成功时dst的data/linesize指向槽内平面（没有buf，不能传给需要引用计数的接口），写完调用commitFrame。
+     * 两次调用之间不能再调用publish。
+     */
+    bool beginFrame(int width, int height, AVPixelFormat format, AVFrame* dst);
+    void commitFrame(int64_t pts, AVRational time_base, bool keyframe);
+
+    /**
+     * @brief memfd的文件描述符（POSIX shm时也有效）
+     */
+    int fd() const { return fd_; }
+
+    /**
+     * @brief 其他进程可以打开的路径：POSIX shm返回名称，memfd返回/proc/<pid>/fd/<fd>
+     */
+    std::string path() const;
+
+    size_t slotBytes() const { return slot_bytes_; }
+    size_t totalBytes() const { return total_bytes_; }
+    uint64_t nextSequence() const { return next_seq_; }
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const { return last_error_; }
+
+private:
+    FrameBusLayout::Slot* slotAt(uint64_t seq) const;
+    uint8_t* dataAt(uint64_t seq) const;
+    bool beginSlot(int width, int height, AVPixelFormat format,
+                   uint8_t* data[FrameBusLayout::kMaxPlanes], int linesize[FrameBusLayout::kMaxPlanes]);
+    void endSlot(int64_t pts, AVRational time_base, bool keyframe);
+
+private:
+    Config config_;
+    int fd_ = -1;
+    bool posix_shm_ = false;
+    uint8_t* base_ = nullptr;
+    size_t total_bytes_ = 0;
+    size_t slot_bytes_ = 0;
+    FrameBusLayout::Header* header_ = nullptr;
+    uint64_t next_seq_ = 0;
+    bool writing_ = false;              // beginFrame之后、commitFrame之前
+    std::string last_error_;
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& publish_metric_;
+};
+
+/**
+ * @brief 帧总线消费者：映射生产者的共享内存（只读），按序号读取帧
+ *
+ * next返回的视图直接指向共享内存，处理完后调用finish确认这段时间内槽没有被生产者覆盖；
+ * 覆盖时（消费者太慢）finish返回false，这一帧的结果应丢弃。
+ */
+class FrameBusConsumer {
+public:
+    /**
+     * @brief 消费者配置
+     */
+    struct Config {
+        bool latest_only;               // 每次直接跳到最新一帧（实时分析），否则按顺序读
+
+        Config()
+            : latest_only(false)
+        {}
+    };
+
+    /**
+     * @brief 一帧的只读视图
+     */
+    struct FrameView {
+        uint64_t sequence = 0;
+        int64_t pts = AV_NOPTS_VALUE;
+        AVRational time_base = {0, 1};
+        AVPixelFormat format = AV_PIX_FMT_NONE;
+        int width = 0;
+        int height = 0;
+        bool keyframe = false;
+        const uint8_t* data[FrameBusLayout::kMaxPlanes] = {nullptr, nullptr, nullptr, nullptr};
+        int linesize[FrameBusLayout::kMaxPlanes] = {0, 0, 0, 0};
+        size_t data_bytes = 0;
+        int64_t publish_time_ns = 0;
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t frames_read;
+        uint64_t frames_missed;         // 落后超过一圈被覆盖、没读到的帧
+        uint64_t frames_torn;           // 读取期间被覆盖的帧
+        uint64_t waits;                 // futex等待次数
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> frames_read{0};
+        std::atomic<uint64_t> frames_missed{0};
+        std::atomic<uint64_t> frames_torn{0};
+        std::atomic<uint64_t> waits{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                frames_read.load(),
+                frames_missed.load(),
+                frames_torn.load(),
+                waits.load()
+            };
+        }
+    };
+
+public:
+    explicit FrameBusConsumer(const Config& config = Config{});
+    ~FrameBusConsumer();
+
+    FrameBusConsumer(const FrameBusConsumer&) = delete;
+    FrameBusConsumer& operator=(const FrameBusConsumer&) = delete;
+
+    /**
+     * @brief 按名称或路径打开（"/name"为POSIX shm，含多级路径时按文件打开，如/proc/<pid>/fd/<fd>）
+     */
+    bool open(const std::string& name);
+
+    /**
+     * @brief 用继承或收到的描述符打开（不接管fd）
+     */
+    bool openFd(int fd);
+
+    void close();
+
+    /**
+     * @brief 从当前最新的帧开始读（丢弃打开前积压在环里的帧）
+     */
+    void seekToLatest();
+
+    /**
+     * @brief 读取下一帧
+     * @param timeout_ms 没有新帧时最多等待的时间，0为不等待
+     * @return 超时或生产者已关闭时返回false
+     */
+    bool next(FrameView& view, int timeout_ms);
+
+    /**
+     * @brief 处理完一帧后确认其数据仍然有效
+     */
+    bool finish(const FrameView& view);
+
+    /**
+     * @brief 生产者是否已关闭（或进程已退出）
+     */
+    bool producerClosed() const;
+
+    /**
+     * @brief 把视图填进AVFrame（不拷贝、没有buf），便于直接交给swscale等接口
+     */
+    static void fillFrame(const FrameView& view, AVFrame* frame);
+
+    uint32_t slotCount() const { return header_ ? header_->slot_count : 0; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const { return last_error_; }
+
+private:
+    bool mapFd(int fd);
+    const FrameBusLayout::Slot* slotAt(uint64_t seq) const;
+
+private:
+    Config config_;
+    const uint8_t* base_ = nullptr;
+    size_t total_bytes_ = 0;
+    const FrameBusLayout::Header* header_ = nullptr;
+    uint64_t read_seq_ = 0;
+    std::string last_error_;
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // FRAME_BUS_H
@@ -12,6 +12,9 @@ namespace media {
         case InputSourceType::RTSP:
             return std::make_unique<RTSPInput>();
         case InputSourceType::LocalFile:
+        case InputSourceType::HTTP:
+        case InputSourceType::UDP:
+            // HTTP/UDP由avformat的协议层处理，FileInput对带"://"的地址不检查本地文件
             return std::make_unique<FileInput>();
         
         default:
@@ -0,0 +1,1535 @@
+#include "media_pipeline.h"
+
+#include "demux/ffmpeg_demuxer.h"
+#include "decoder/ffmpeg_decoder.h"
+#include "converter/ffmpeg_audio_converter.h"
+#include "audio/wsola_time_stretcher.h"
+#include "audio/loudness_meter.h"
+#include "analytics/analytics_stage.h"
+#include "metadata/timed_metadata_extractor.h"
+#include "allocator/ffmpeg_allocator/buffer_tracking.h"
+#include "../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+// 队列为空或已满时的轮询上限，保证停止/变速能及时被感知
+constexpr auto kQueueWait = std::chrono::milliseconds(10);
+// 视频帧等待显示时每次最多睡眠的时长
+constexpr int64_t kMaxWaitUs = 10000;
+// 音频输出缓冲满时的重试间隔
+constexpr auto kAudioRetry = std::chrono::milliseconds(5);
+// 变速后音频与时钟对齐时最多补的静音
+constexpr int64_t kMaxAlignGapUs = 1000000;
+// 预备下一条目时预解码的视频帧数，以及为此最多读取的包数
+constexpr size_t kPrerollVideoFrames = 2;
+constexpr int kMaxPrerollPackets = 256;
+
+void atomicMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 有界数据包队列（单生产者/单消费者）
+ *
+ * 每个包附带serial，重新定位后的包serial递增，消费者据此刷新解码器。
+ * 条目边界以不带包的标记表示，消费者取到后排空旧解码器并切换到下一条目。
+ */
+class MediaPipeline::PacketQueue {
+public:
+    PacketQueue(size_t capacity, std::shared_ptr<MemoryTracker> tracker, const char* location)
+        : capacity_(std::max<size_t>(capacity, 1))
+        , tracker_(std::move(tracker))
+        , location_(location) {}
+
+    ~PacketQueue() { clear(); }
+
+    /**
+     * @brief 放入数据包（转移引用），队列满时阻塞
+     * @return 被终止或打断时返回false，packet保持原样由调用方释放
+     */
+    bool push(AVPacket* packet, uint64_t serial) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (entries_.size() >= capacity_ && !aborted_ && !interrupted_) {
+            not_full_.wait_for(lock, kQueueWait);
+        }
+        if (aborted_ || interrupted_) {
+            interrupted_ = false;
+            return false;
+        }
+        AVPacket* owned = av_packet_alloc();
+        if (!owned) {
+            return false;
+        }
+        av_packet_move_ref(owned, packet);
+        if (tracker_) {
+            trackPacketBuffer(tracker_, owned, location_);
+        }
+        entries_.push_back({owned, serial});
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 放入条目边界标记（不受容量限制，不会被打断）
+     */
+    bool pushBoundary(uint64_t serial) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (aborted_) {
+            return false;
+        }
+        entries_.push_back({nullptr, serial});
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 取出数据包，队列为空时阻塞
+     * @param boundary 取到的是条目边界标记时为true，此时packet不变
+     * @return 已结束（finish后取空）或被终止时返回false
+     */
+    bool pop(AVPacket* packet, uint64_t& serial, bool& boundary) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (entries_.empty() && !aborted_ && !finished_) {
+            not_empty_.wait_for(lock, kQueueWait);
+        }
+        if (aborted_ || entries_.empty()) {
+            return false;
+        }
+        Entry entry = entries_.front();
+        entries_.pop_front();
+        boundary = entry.packet == nullptr;
+        if (!boundary) {
+            av_packet_move_ref(packet, entry.packet);
+            av_packet_free(&entry.packet);
+        }
+        serial = entry.serial;
+        not_full_.notify_one();
+        return true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    /**
+     * @brief 队列中是否还有关键帧（决定落后的关键帧能否跳过）
+     */
+    bool containsKeyframe() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry& entry : entries_) {
+            if (entry.packet && (entry.packet->flags & AV_PKT_FLAG_KEY)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 不会再有新包
+     */
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        not_empty_.notify_all();
+    }
+
+    /**
+     * @brief 终止：生产者和消费者都立即返回
+     */
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    /**
+     * @brief 打断一次阻塞中的push（重新定位时使用）
+     */
+    void interrupt() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+        not_full_.notify_all();
+    }
+
+    /**
+     * @brief 丢弃所有包
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Entry& entry : entries_) {
+            av_packet_free(&entry.packet);
+        }
+        entries_.clear();
+        interrupted_ = false;
+        not_full_.notify_all();
+    }
+
+    /**
+     * @brief 清空并恢复到可用状态
+     */
+    void reset() {
+        clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = false;
+        finished_ = false;
+        interrupted_ = false;
+    }
+
+private:
+    struct Entry {
+        AVPacket* packet;       // nullptr为条目边界标记
+        uint64_t serial;
+    };
+
+    const size_t capacity_;
+    const std::shared_ptr<MemoryTracker> tracker_;      // 非空时入队的包记录分配轨迹
+    const char* const location_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<Entry> entries_;
+    bool aborted_ = false;
+    bool finished_ = false;
+    bool interrupted_ = false;
+};
+
+/**
+ * @brief 一个播放条目的输入、解封装和解码器
+ *
+ * 当前条目的组件由管道成员持有；下一条目在预备阶段全部装在这里，
+ * 切换时各线程把自己用到的组件与管道成员交换，切换完成后这里装的就是上一条目的组件。
+ */
+struct MediaPipeline::Item {
+    std::shared_ptr<IInputSource> input_source;
+    std::unique_ptr<FFmpegDemuxer> demuxer;
+    std::unique_ptr<FFmpegVideoDecoder> video_decoder;
+    std::unique_ptr<FFmpegAudioDecoder> audio_decoder;
+    std::unique_ptr<FFmpegAudioConverter> audio_converter;
+    StreamInfo video_info;
+    StreamInfo audio_info;
+    int64_t start_time_us = 0;              // 文件起始时间
+
+    // 预解码的开头几帧（解码器已经消费了对应的包）
+    std::deque<AVFrame*> preroll_video;
+    std::deque<AVFrame*> preroll_audio;
+    int64_t first_video_us = AV_NOPTS_VALUE;    // 第一帧相对文件起始时间的位置
+    int64_t first_audio_us = AV_NOPTS_VALUE;
+
+    // 切换进度（item_mutex_保护）
+    bool video_switched = false;
+    bool audio_switched = false;
+    int64_t offset_us = AV_NOPTS_VALUE;     // 条目时间0在管道时间轴上的位置
+    uint64_t metadata_item = 0;             // 元数据轨道中的条目编号，0表示没有
+
+    Item() = default;
+    Item(const Item&) = delete;
+    Item& operator=(const Item&) = delete;
+
+    ~Item() {
+        for (AVFrame* frame : preroll_video) {
+            av_frame_free(&frame);
+        }
+        for (AVFrame* frame : preroll_audio) {
+            av_frame_free(&frame);
+        }
+        audio_converter.reset();
+        audio_decoder.reset();
+        video_decoder.reset();
+        demuxer.reset();
+        if (input_source) {
+            input_source->close();
+        }
+    }
+};
+
+MediaPipeline::MediaPipeline()
+    : metrics_{MetricsRegistry::instance().latency("stage.demux"),
+               MetricsRegistry::instance().latency("stage.video_decode"),
+               MetricsRegistry::instance().latency("stage.video_present"),
+               MetricsRegistry::instance().latency("stage.audio_decode"),
+               MetricsRegistry::instance().gauge("queue.video_packets"),
+               MetricsRegistry::instance().gauge("queue.audio_packets"),
+               MetricsRegistry::instance().gauge("queue.audio_buffer_ms"),
+               MetricsRegistry::instance().counter("drop.video_late"),
+               MetricsRegistry::instance().counter("drop.video_skipped"),
+               MetricsRegistry::instance().counter("drop.audio_packets")} {
+}
+
+MediaPipeline::~MediaPipeline() {
+    close();
+}
+
+bool MediaPipeline::open(const std::string& url) {
+    return open(url, Config{});
+}
+
+bool MediaPipeline::open(const std::string& url, const Config& config) {
+    close();
+    config_ = config;
+
+    Item item;
+    if (!openItem(url, item)) {
+        return false;
+    }
+    if (item.audio_decoder && !setupAudioOutput()) {
+        item.audio_decoder.reset();
+        item.audio_converter.reset();
+        item.audio_info = StreamInfo{};
+        if (!item.video_decoder) {
+            handleError("没有可播放的音视频流");
+            return false;
+        }
+    }
+
+    adoptItem(item);
+    if (video_decoder_) {
+        video_queue_ = std::make_unique<PacketQueue>(config_.video_queue_packets, memory_tracker_,
+                                                     "demux/video");
+    }
+    if (audio_decoder_) {
+        stretcher_ = std::make_unique<WsolaTimeStretcher>(audio_output_->format().sample_rate,
+                                                          audio_output_->format().channels);
+        audio_queue_ = std::make_unique<PacketQueue>(config_.audio_queue_packets, memory_tracker_,
+                                                     "demux/audio");
+    }
+    return true;
+}
+
+bool MediaPipeline::openItem(const std::string& url, Item& item) {
+    item.input_source = InputSourceFactory::create(url);
+    if (!item.input_source || !item.input_source->open(url)) {
+        handleError("无法打开输入 " + url +
+                    (item.input_source ? ": " + item.input_source->getLastError() : std::string()));
+        item.input_source.reset();
+        return false;
+    }
+
+    item.demuxer = std::make_unique<FFmpegDemuxer>();
+    if (!item.demuxer->initialize(item.input_source)) {
+        handleError(item.demuxer->getLastError());
+        return false;
+    }
+
+    AVFormatContext* format_ctx = item.input_source->getFormatContext();
+    item.start_time_us = (format_ctx && format_ctx->start_time != AV_NOPTS_VALUE) ? format_ctx->start_time : 0;
+
+    const bool has_video = setupVideo(item);
+    const bool has_audio = config_.enable_audio && setupAudio(item);
+    if (!has_video && !has_audio) {
+        handleError("没有可播放的音视频流");
+        return false;
+    }
+    return true;
+}
+
+bool MediaPipeline::setupVideo(Item& item) {
+    const int index = item.demuxer->findStream(AVMEDIA_TYPE_VIDEO);
+    const AVCodecParameters* codecpar = item.demuxer->getCodecParameters(index);
+    if (!codecpar) {
+        return false;
+    }
+
+    FFmpegVideoDecoder::Config decoder_config;
+    decoder_config.thread_count = config_.video_decoder_threads;
+    decoder_config.memory_tracker = memory_tracker_;
+    auto decoder = std::make_unique<FFmpegVideoDecoder>(decoder_config);
+    if (!decoder->initialize(codecpar)) {
+        handleError(decoder->getLastError());
+        return false;
+    }
+
+    for (const StreamInfo& info : item.demuxer->getStreamInfos()) {
+        if (info.index == index) {
+            item.video_info = info;
+        }
+    }
+    item.video_decoder = std::move(decoder);
+    return true;
+}
+
+bool MediaPipeline::setupAudio(Item& item) {
+    const int index = item.demuxer->findStream(AVMEDIA_TYPE_AUDIO);
+    const AVCodecParameters* codecpar = item.demuxer->getCodecParameters(index);
+    if (!codecpar) {
+        return false;
+    }
+
+    auto decoder = std::make_unique<FFmpegAudioDecoder>();
+    decoder->setMemoryTracker(memory_tracker_);
+    if (!decoder->initialize(codecpar)) {
+        handleError(decoder->getLastError());
+        return false;
+    }
+
+    // 时间伸缩按float处理，输出格式固定为交错FLT；各条目都转换到同一输出格式
+    AudioConvertParams params;
+    params.src_sample_rate = codecpar->sample_rate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+    params.src_channels = codecpar->ch_layout.nb_channels;
+#else
+    params.src_channels = codecpar->channels;
+#endif
+    params.src_format = static_cast<AVSampleFormat>(codecpar->format);
+    params.dst_sample_rate = config_.audio.format.sample_rate;
+    params.dst_channels = config_.audio.format.channels;
+    params.dst_format = AV_SAMPLE_FMT_FLT;
+    auto converter = std::make_unique<FFmpegAudioConverter>();
+    if (!converter->initialize(params)) {
+        handleError(converter->getLastError());
+        return false;
+    }
+
+    for (const StreamInfo& info : item.demuxer->getStreamInfos()) {
+        if (info.index == index) {
+            item.audio_info = info;
+        }
+    }
+    item.audio_decoder = std::move(decoder);
+    item.audio_converter = std::move(converter);
+    return true;
+}
+
+bool MediaPipeline::setupAudioOutput() {
+    AudioOutput::Config output_config = config_.audio;
+    output_config.format.sample_fmt = AV_SAMPLE_FMT_FLT;
+    auto output = std::make_unique<AudioOutput>();
+    if (!output->initialize(output_config)) {
+        handleError("音频输出初始化失败: " + output->getLastError());
+        return false;
+    }
+    audio_output_ = std::move(output);
+    return true;
+}
+
+void MediaPipeline::adoptItem(Item& item) {
+    input_source_ = std::move(item.input_source);
+    demuxer_ = std::move(item.demuxer);
+    video_decoder_ = std::move(item.video_decoder);
+    audio_decoder_ = std::move(item.audio_decoder);
+    audio_converter_ = std::move(item.audio_converter);
+    {
+        std::lock_guard<std::mutex> lock(info_mutex_);
+        video_info_ = item.video_info;
+        audio_info_ = item.audio_info;
+    }
+    video_base_us_ = -item.start_time_us;
+    audio_base_us_.store(-item.start_time_us);
+    item_offset_us_.store(0);
+}
+
+bool MediaPipeline::prepareNext(const std::string& url) {
+    std::unique_ptr<Item> released;
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        if (!demuxer_) {
+            handleError("管道未打开");
+            return false;
+        }
+        if (preparing_) {
+            handleError("正在预备下一条目");
+            return false;
+        }
+        preparing_ = true;
+        // 上一条目的资源在这里（而不是解码线程里）释放
+        released = std::move(retired_);
+        next_.reset();
+    }
+    released.reset();
+
+    auto item = std::make_unique<Item>();
+    bool ok = openItem(url, *item);
+    if (ok && (static_cast<bool>(item->video_decoder) != static_cast<bool>(video_queue_) ||
+               static_cast<bool>(item->audio_decoder) != static_cast<bool>(audio_queue_))) {
+        handleError("下一条目的音视频流组成与当前不同，无法无缝衔接: " + url);
+        ok = false;
+    }
+    if (ok) {
+        ok = prerollItem(*item);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        preparing_ = false;
+        if (ok) {
+            next_ = std::move(item);
+        }
+    }
+    item_cv_.notify_all();
+    return ok;
+}
+
+bool MediaPipeline::prerollItem(Item& item) {
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    if (!packet || !frame) {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        handleError("内存分配失败");
+        return false;
+    }
+
+    // 读到的包都送进解码器，解出的帧全部保留，切换后解码线程从下一个包接着解码
+    auto collect = [&item, frame](auto& decoder, const StreamInfo& info,
+                                  std::deque<AVFrame*>& frames, int64_t& first_us) {
+        while (decoder->receiveFrame(frame)) {
+            const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp
+                                                                               : frame->pts;
+            if (first_us == AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE) {
+                first_us = toMicroseconds(pts, info.time_base, -item.start_time_us);
+            }
+            AVFrame* kept = av_frame_clone(frame);
+            if (kept) {
+                frames.push_back(kept);
+            }
+            av_frame_unref(frame);
+        }
+    };
+
+    // 送包：EAGAIN说明解码器输出满了，先取走帧再重发同一个包；
+    // 个别包解码出错只计数，不影响后面的包
+    int decode_errors = 0;
+    auto feed = [&](auto& decoder, const StreamInfo& info, std::deque<AVFrame*>& frames, int64_t& first_us) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            const uint64_t errors_before = decoder->getStats().decode_errors;
+            const bool sent = decoder->sendPacket(packet);
+            collect(decoder, info, frames, first_us);
+            if (sent) {
+                return;
+            }
+            if (decoder->getStats().decode_errors != errors_before) {
+                ++decode_errors;
+                return;
+            }
+        }
+    };
+
+    bool need_video = static_cast<bool>(item.video_decoder);
+    bool need_audio = static_cast<bool>(item.audio_decoder);
+    for (int i = 0; (need_video || need_audio) && i < kMaxPrerollPackets; ++i) {
+        if (!item.demuxer->readPacket(packet)) {
+            break;
+        }
+        if (item.video_decoder && packet->stream_index == item.video_info.index) {
+            feed(item.video_decoder, item.video_info, item.preroll_video, item.first_video_us);
+            need_video = item.preroll_video.size() < kPrerollVideoFrames;
+        } else if (item.audio_decoder && packet->stream_index == item.audio_info.index) {
+            feed(item.audio_decoder, item.audio_info, item.preroll_audio, item.first_audio_us);
+            need_audio = item.preroll_audio.empty();
+        }
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+
+    // 某一路一帧都没解出来：新条目的解码器没有准备好，不能拿它无缝衔接
+    const bool video_missing = item.video_decoder && item.preroll_video.empty();
+    const bool audio_missing = item.audio_decoder && item.preroll_audio.empty();
+    if (video_missing || audio_missing) {
+        handleError(std::string("下一条目预解码没有得到") + (video_missing ? "视频" : "音频") + "帧（解码错误" +
+                    std::to_string(decode_errors) + "个包）");
+        return false;
+    }
+    return true;
+}
+
+void MediaPipeline::setWaitForNext(bool wait) {
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        wait_for_next_ = wait;
+    }
+    item_cv_.notify_all();
+}
+
+bool MediaPipeline::start() {
+    if (is_running_.load()) {
+        return true;
+    }
+    if (!demuxer_) {
+        handleError("管道未打开");
+        return false;
+    }
+
+    if (video_queue_) {
+        video_queue_->reset();
+    }
+    if (audio_queue_) {
+        audio_queue_->reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex_);
+        anchor_media_us_ = AV_NOPTS_VALUE;
+    }
+    if (audio_output_) {
+        audio_output_->flush();
+        if (!audio_output_->start()) {
+            handleError("音频输出启动失败: " + audio_output_->getLastError());
+            return false;
+        }
+    }
+
+    is_running_.store(true);
+    video_finished_.store(!video_decoder_);
+    audio_finished_.store(!audio_decoder_);
+    end_notified_.store(false);
+
+    demux_thread_ = std::thread(&MediaPipeline::processPackets, this);
+    if (video_decoder_) {
+        video_thread_ = std::thread(&MediaPipeline::videoLoop, this);
+    }
+    if (audio_decoder_) {
+        audio_thread_ = std::thread(&MediaPipeline::audioLoop, this);
+    }
+    return true;
+}
+
+void MediaPipeline::stop() {
+    if (!is_running_.exchange(false)) {
+        return;
+    }
+
+    if (video_queue_) {
+        video_queue_->abort();
+    }
+    if (audio_queue_) {
+        audio_queue_->abort();
+    }
+    wait_cv_.notify_all();
+    item_cv_.notify_all();
+
+    for (std::thread* thread : {&demux_thread_, &video_thread_, &audio_thread_}) {
+        if (thread->joinable()) {
+            thread->join();
+        }
+    }
+    if (audio_output_) {
+        audio_output_->stop();
+    }
+    abandonSwitch();
+}
+
+void MediaPipeline::abandonSwitch() {
+    // 停止时切换只进行了一半（解封装已换到新条目）：补完剩下的交换，成员重新对应同一条目
+    std::lock_guard<std::mutex> lock(item_mutex_);
+    if (!switching_) {
+        return;
+    }
+    Item& item = *switching_;
+    if (item.offset_us == AV_NOPTS_VALUE) {
+        item.offset_us = fallbackOffsetUs(AV_NOPTS_VALUE);
+    }
+    if (!item.video_switched) {
+        std::swap(video_decoder_, item.video_decoder);
+        std::lock_guard<std::mutex> info_lock(info_mutex_);
+        std::swap(video_info_, item.video_info);
+    }
+    if (!item.audio_switched) {
+        std::swap(audio_decoder_, item.audio_decoder);
+        std::swap(audio_converter_, item.audio_converter);
+        std::lock_guard<std::mutex> info_lock(info_mutex_);
+        std::swap(audio_info_, item.audio_info);
+    }
+    video_base_us_ = item.offset_us - item.start_time_us;
+    audio_base_us_.store(item.offset_us - item.start_time_us);
+    item_offset_us_.store(item.offset_us);
+    activateMetadataItem(item);
+    retired_ = std::move(switching_);
+}
+
+void MediaPipeline::close() {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        next_.reset();
+        retired_.reset();
+        wait_for_next_ = false;
+        items_switched_ = 0;
+    }
+    video_queue_.reset();
+    audio_queue_.reset();
+    stretcher_.reset();
+    audio_converter_.reset();
+    if (audio_output_) {
+        audio_output_->close();
+        audio_output_.reset();
+    }
+    audio_decoder_.reset();
+    video_decoder_.reset();
+    demuxer_.reset();
+    if (input_source_) {
+        input_source_->close();
+        input_source_.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(info_mutex_);
+        video_info_ = StreamInfo{};
+        audio_info_ = StreamInfo{};
+    }
+    video_base_us_ = 0;
+    audio_base_us_.store(0);
+    item_offset_us_.store(0);
+    video_finished_.store(true);
+    audio_finished_.store(true);
+    resync_requested_.store(false);
+    packet_serial_ = 0;
+
+    video_packets_read_.store(0);
+    video_packets_skipped_.store(0);
+    video_frames_decoded_.store(0);
+    video_frames_presented_.store(0);
+    video_frames_dropped_late_.store(0);
+    audio_packets_dropped_.store(0);
+    audio_frames_written_.store(0);
+    sync_error_total_us_.store(0);
+    sync_error_max_us_.store(0);
+}
+
+double MediaPipeline::setPlaybackSpeed(double speed) {
+    speed = std::max(kMinSpeed, std::min(kMaxSpeed, speed));
+    const double previous = speed_.load();
+    if (speed == previous) {
+        return speed;
+    }
+
+    // 以切换前的主时钟重新锚定系统时钟，切换瞬间时间连续
+    const int64_t current = getMasterClockUs();
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex_);
+        if (current != AV_NOPTS_VALUE) {
+            anchor_media_us_ = current;
+            anchor_wall_us_ = nowUs();
+        }
+        speed_.store(speed);
+    }
+
+    // 解码线程切换条目时会在item_mutex_下交换解码器
+    bool has_video = false;
+    bool has_audio = false;
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        has_video = video_decoder_ != nullptr;
+        has_audio = audio_decoder_ != nullptr;
+    }
+
+    // 解码策略变密或音频恢复时，之前被丢弃的包需要重新读取
+    const bool denser_video = has_video && decodeModeFor(speed) < decodeModeFor(previous);
+    const bool audio_resumed = has_audio && audioActiveFor(speed) && !audioActiveFor(previous);
+    if (is_running_.load() && current != AV_NOPTS_VALUE && (denser_video || audio_resumed)) {
+        // 先打断可能阻塞的push，解封装线程清空队列时会一并清除打断标记
+        if (video_queue_) {
+            video_queue_->interrupt();
+        }
+        if (audio_queue_) {
+            audio_queue_->interrupt();
+        }
+        resync_target_us_.store(current);
+        resync_requested_.store(true);
+    }
+
+    speed_generation_.fetch_add(1);
+    wait_cv_.notify_all();
+    return speed;
+}
+
+int64_t MediaPipeline::getMasterClockUs() const {
+    if (audio_output_ && audioActiveFor(speed_.load())) {
+        const int64_t audio_clock = audio_output_->getClockUs();
+        if (audio_clock != AV_NOPTS_VALUE) {
+            audio_clock_master_.store(true, std::memory_order_relaxed);
+            return audio_clock;
+        }
+    }
+    audio_clock_master_.store(false, std::memory_order_relaxed);
+    return systemClockUs();
+}
+
+bool MediaPipeline::isFinished() const {
+    return video_finished_.load() && audio_finished_.load();
+}
+
+void MediaPipeline::processPackets() {
+    AVPacket* packet = av_packet_alloc();
+    if (!packet) {
+        handleError("内存分配失败");
+        return;
+    }
+
+    // 当前解封装条目的流索引（切换条目后与video_info_/audio_info_暂时不同）
+    int video_index = -1;
+    int audio_index = -1;
+    {
+        std::lock_guard<std::mutex> lock(info_mutex_);
+        video_index = video_info_.index;
+        audio_index = audio_info_.index;
+    }
+    if (metadata_) {
+        metadata_->configure(*demuxer_, video_index);
+    }
+
+    auto switchPending = [this]() {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        return switching_ != nullptr;
+    };
+
+    while (is_running_.load()) {
+        // 切换进行中时推迟：队列里有边界标记，条目偏移也还没确定
+        if (resync_requested_.load() && !switchPending() && resync_requested_.exchange(false)) {
+            // 在当前时刻重新定位；新serial让解码线程刷新解码器
+            packet_serial_++;
+            if (video_queue_) {
+                video_queue_->clear();
+            }
+            if (audio_queue_) {
+                audio_queue_->clear();
+            }
+            const int64_t target_us = resync_target_us_.load() - item_offset_us_.load();
+            if (!demuxer_->seekToTime(std::max<int64_t>(0, target_us))) {
+                handleError(demuxer_->getLastError());
+            }
+        }
+
+        bool read = false;
+        {
+            ScopedLatency timing(metrics_.demux);
+            ScopedPerfCounters counters(demux_counters_);
+            read = demuxer_->readPacket(packet);
+        }
+        if (!read) {
+            if (!demuxer_->isEndOfStream()) {
+                handleError(demuxer_->getLastError());
+            }
+            // 有预备好的下一条目则接着读，否则结束
+            if (!switchDemuxer(video_index, audio_index)) {
+                break;
+            }
+            // 轨道不清空：上一条目还在队列里的帧显示时仍要查到它的元数据
+            if (metadata_) {
+                metadata_->configure(*demuxer_, video_index);
+            }
+            continue;
+        }
+
+        // 只读扫描，包照常入队
+        if (metadata_) {
+            metadata_->processPacket(packet);
+        }
+
+        const double speed = speed_.load();
+        PacketQueue* queue = nullptr;
+        if (video_queue_ && packet->stream_index == video_index) {
+            video_packets_read_.fetch_add(1, std::memory_order_relaxed);
+            // 关键帧模式：非关键帧不进入队列
+            if (decodeModeFor(speed) == VideoDecodeMode::KeyframeOnly && !(packet->flags & AV_PKT_FLAG_KEY)) {
+                video_packets_skipped_.fetch_add(1, std::memory_order_relaxed);
+                metrics_.video_skipped.add();
+            } else {
+                queue = video_queue_.get();
+            }
+        } else if (audio_queue_ && packet->stream_index == audio_index) {
+            // 超过音频变速上限：不解码
+            if (!audioActiveFor(speed)) {
+                audio_packets_dropped_.fetch_add(1, std::memory_order_relaxed);
+                metrics_.audio_dropped.add();
+            } else {
+                queue = audio_queue_.get();
+            }
+        }
+
+        if (queue) {
+            queue->push(packet, packet_serial_);
+            (queue == video_queue_.get() ? metrics_.video_queue : metrics_.audio_queue)
+                .set(static_cast<double>(queue->size()));
+        }
+        av_packet_unref(packet);
+    }
+
+    if (video_queue_) {
+        video_queue_->finish();
+    }
+    if (audio_queue_) {
+        audio_queue_->finish();
+    }
+    av_packet_free(&packet);
+}
+
+bool MediaPipeline::switchDemuxer(int& video_index, int& audio_index) {
+    std::unique_lock<std::mutex> lock(item_mutex_);
+    // 上一次切换还没被解码线程消化（条目极短）、下一条目正在预备，或播放列表要求等待时，先等
+    while (is_running_.load() && (switching_ || preparing_ || (!next_ && wait_for_next_))) {
+        item_cv_.wait_for(lock, kQueueWait);
+    }
+    if (!is_running_.load() || !next_) {
+        return false;
+    }
+
+    switching_ = std::move(next_);
+    Item& item = *switching_;
+    std::swap(input_source_, item.input_source);
+    std::swap(demuxer_, item.demuxer);
+    video_index = item.video_info.index;
+    audio_index = item.audio_info.index;
+    item.video_switched = !video_queue_;
+    item.audio_switched = !audio_queue_;
+    if (metadata_) {
+        item.metadata_item = metadata_->track()->beginItem();
+    }
+    lock.unlock();
+
+    // 音频先放：视频线程切换时要等音频给出衔接位置
+    if (audio_queue_) {
+        audio_queue_->pushBoundary(packet_serial_);
+    }
+    if (video_queue_) {
+        video_queue_->pushBoundary(packet_serial_);
+    }
+    return true;
+}
+
+bool MediaPipeline::switchVideoItem(int64_t end_us, std::deque<AVFrame*>& preroll) {
+    bool completed = false;
+    uint64_t switched = 0;
+    {
+        std::unique_lock<std::mutex> lock(item_mutex_);
+        while (is_running_.load() && switching_ && !switching_->audio_switched) {
+            item_cv_.wait_for(lock, kQueueWait);
+        }
+        if (!is_running_.load() || !switching_) {
+            return false;
+        }
+
+        Item& item = *switching_;
+        if (item.offset_us == AV_NOPTS_VALUE) {
+            // 没有音频或音频没给出结束位置：新条目第一帧接在上一条目最后一帧之后
+            item.offset_us = (end_us != AV_NOPTS_VALUE && item.first_video_us != AV_NOPTS_VALUE)
+                ? end_us - item.first_video_us
+                : fallbackOffsetUs(item.first_video_us);
+            audio_base_us_.store(item.offset_us - item.start_time_us);
+        }
+        std::swap(video_decoder_, item.video_decoder);
+        {
+            std::lock_guard<std::mutex> info_lock(info_mutex_);
+            std::swap(video_info_, item.video_info);
+        }
+        video_base_us_ = item.offset_us - item.start_time_us;
+        preroll.swap(item.preroll_video);
+        item.video_switched = true;
+        // 此后显示的都是新条目的帧
+        activateMetadataItem(item);
+        completed = completeSwitchLocked(switched);
+    }
+    item_cv_.notify_all();
+    if (completed && item_callback_) {
+        item_callback_(switched);
+    }
+    return true;
+}
+
+bool MediaPipeline::switchAudioItem(int64_t end_us, std::deque<AVFrame*>& preroll) {
+    bool completed = false;
+    uint64_t switched = 0;
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        if (!switching_) {
+            return false;
+        }
+
+        Item& item = *switching_;
+        // 新条目的第一个样本紧接上一条目最后一个样本写入，时间轴也从那里接上
+        if (end_us != AV_NOPTS_VALUE && item.first_audio_us != AV_NOPTS_VALUE) {
+            item.offset_us = end_us - item.first_audio_us;
+        } else if (item.video_switched) {
+            item.offset_us = fallbackOffsetUs(item.first_audio_us);
+        }
+        std::swap(audio_decoder_, item.audio_decoder);
+        std::swap(audio_converter_, item.audio_converter);
+        {
+            std::lock_guard<std::mutex> info_lock(info_mutex_);
+            std::swap(audio_info_, item.audio_info);
+        }
+        // 偏移未定时先按0处理，视频线程切换时补设
+        audio_base_us_.store((item.offset_us != AV_NOPTS_VALUE ? item.offset_us : 0) - item.start_time_us);
+        preroll.swap(item.preroll_audio);
+        item.audio_switched = true;
+        completed = completeSwitchLocked(switched);
+    }
+    item_cv_.notify_all();
+    if (completed && item_callback_) {
+        item_callback_(switched);
+    }
+    return true;
+}
+
+bool MediaPipeline::completeSwitchLocked(uint64_t& switched) {
+    if (!switching_ || !switching_->video_switched || !switching_->audio_switched) {
+        return false;
+    }
+    item_offset_us_.store(switching_->offset_us);
+    activateMetadataItem(*switching_);
+    retired_ = std::move(switching_);
+    switched = ++items_switched_;
+    return true;
+}
+
+void MediaPipeline::activateMetadataItem(const Item& item) {
+    if (metadata_ && item.metadata_item != 0) {
+        metadata_->track()->activateItem(item.metadata_item);
+    }
+}
+
+int64_t MediaPipeline::fallbackOffsetUs(int64_t first_us) const {
+    // 拿不到上一条目的结束位置时，以当前时钟作为新条目第一帧的位置
+    const int64_t clock = systemClockUs();
+    return (clock != AV_NOPTS_VALUE ? clock : 0) - (first_us != AV_NOPTS_VALUE ? first_us : 0);
+}
+
+void MediaPipeline::notifyIfFinished() {
+    if (is_running_.load() && isFinished() && !end_notified_.exchange(true) && end_callback_) {
+        end_callback_();
+    }
+}
+
+void MediaPipeline::videoLoop() {
+    COPY_ACCOUNT_STREAM("video");
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    if (!packet || !frame) {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        handleError("内存分配失败");
+        video_finished_.store(true);
+        return;
+    }
+
+    uint64_t generation = UINT64_MAX;
+    uint64_t serial = 0;
+    uint64_t packet_serial = 0;
+    bool boundary = false;
+    VideoDecodeMode mode = VideoDecodeMode::All;
+    int64_t end_us = AV_NOPTS_VALUE;    // 当前条目已解码视频的结束位置（管道时间）
+
+    auto present = [this, &end_us](AVFrame* decoded) {
+        video_frames_decoded_.fetch_add(1, std::memory_order_relaxed);
+        COPY_ACCOUNT_FRAME("video");
+        const int64_t pts = decoded->best_effort_timestamp != AV_NOPTS_VALUE ? decoded->best_effort_timestamp
+                                                                             : decoded->pts;
+        if (pts != AV_NOPTS_VALUE) {
+            end_us = frameEndUs(decoded, toMicroseconds(pts, video_info_.time_base, video_base_us_));
+        }
+        if (analytics_) {
+            analytics_->submit(decoded, video_info_.time_base);
+        }
+        presentVideoFrame(decoded);
+    };
+    auto drain = [this, frame, &present]() {
+        while (video_decoder_->receiveFrame(frame)) {
+            present(frame);
+            av_frame_unref(frame);
+        }
+    };
+
+    while (video_queue_->pop(packet, packet_serial, boundary)) {
+        if (boundary) {
+            // 条目结束：排空旧解码器，换用预备好的解码器，先显示预解码的帧
+            video_decoder_->sendPacket(nullptr);
+            drain();
+            video_decoder_->flush();
+
+            std::deque<AVFrame*> preroll;
+            if (!switchVideoItem(end_us, preroll)) {
+                break;
+            }
+            generation = UINT64_MAX;    // 新解码器按当前速度重新设置丢帧策略
+            end_us = AV_NOPTS_VALUE;
+            for (AVFrame* decoded : preroll) {
+                if (is_running_.load()) {
+                    present(decoded);
+                }
+                av_frame_free(&decoded);
+            }
+            continue;
+        }
+
+        if (packet_serial != serial) {
+            serial = packet_serial;
+            video_decoder_->flush();
+        }
+
+        const uint64_t current_generation = speed_generation_.load();
+        if (current_generation != generation) {
+            generation = current_generation;
+            mode = decodeModeFor(speed_.load());
+            video_decoder_->setSkipFrame(mode == VideoDecodeMode::All        ? AVDISCARD_DEFAULT
+                                         : mode == VideoDecodeMode::SkipNonRef ? AVDISCARD_NONREF
+                                                                                : AVDISCARD_NONKEY);
+        }
+
+        if (mode == VideoDecodeMode::KeyframeOnly) {
+            // 切换前已入队的非关键帧，以及已经落后且后面还有关键帧可用的关键帧，都不送解码器
+            const bool keyframe = packet->flags & AV_PKT_FLAG_KEY;
+            if (!keyframe || (isKeyframeLate(packet) && video_queue_->containsKeyframe())) {
+                video_packets_skipped_.fetch_add(1, std::memory_order_relaxed);
+                metrics_.video_skipped.add();
+                av_packet_unref(packet);
+                continue;
+            }
+        }
+
+        {
+            ScopedLatency timing(metrics_.video_decode);
+            ScopedPerfCounters counters(video_decode_counters_);
+            video_decoder_->sendPacket(packet);
+        }
+        av_packet_unref(packet);
+        metrics_.video_queue.set(static_cast<double>(video_queue_->size()));
+        drain();
+    }
+
+    // 文件结束：排空解码器
+    if (is_running_.load()) {
+        video_decoder_->sendPacket(nullptr);
+        drain();
+        video_decoder_->flush();
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    video_finished_.store(true);
+    notifyIfFinished();
+}
+
+void MediaPipeline::presentVideoFrame(AVFrame* frame) {
+    const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    if (pts == AV_NOPTS_VALUE) {
+        if (video_callback_) {
+            video_callback_(frame);
+        }
+        video_frames_presented_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const int64_t pts_us = toMicroseconds(pts, video_info_.time_base, video_base_us_);
+
+    // 没有音频时钟时，第一帧确定系统时钟起点
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex_);
+        if (anchor_media_us_ == AV_NOPTS_VALUE) {
+            anchor_media_us_ = pts_us;
+            anchor_wall_us_ = nowUs();
+        }
+    }
+
+    // 早到：按墙钟等待（停止或变速时提前唤醒重新计算）
+    int64_t wall_diff_us = 0;
+    while (is_running_.load()) {
+        const int64_t clock = getMasterClockUs();
+        wall_diff_us = static_cast<int64_t>((pts_us - clock) / speed_.load());
+        if (wall_diff_us <= 1000) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        wait_cv_.wait_for(lock, std::chrono::microseconds(std::min(wall_diff_us, kMaxWaitUs)));
+    }
+    if (!is_running_.load()) {
+        return;
+    }
+
+    // 晚到：超过阈值直接丢弃
+    if (-wall_diff_us > config_.late_drop_us) {
+        video_frames_dropped_late_.fetch_add(1, std::memory_order_relaxed);
+        metrics_.video_late.add();
+        return;
+    }
+
+    // 音频为主时钟时让系统时钟跟随，切换到系统时钟时不跳变
+    if (audio_clock_master_.load(std::memory_order_relaxed)) {
+        anchorSystemClock(pts_us - static_cast<int64_t>(wall_diff_us * speed_.load()));
+    }
+
+    const int64_t error_us = std::abs(wall_diff_us);
+    sync_error_total_us_.fetch_add(error_us, std::memory_order_relaxed);
+    atomicMax(sync_error_max_us_, error_us);
+    metrics_.video_present.record(error_us);
+
+    if (video_callback_) {
+        video_callback_(frame);
+    }
+    video_frames_presented_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool MediaPipeline::isKeyframeLate(const AVPacket* packet) const {
+    const int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    const int64_t clock = getMasterClockUs();
+    if (pts == AV_NOPTS_VALUE || clock == AV_NOPTS_VALUE) {
+        return false;
+    }
+    const double late_wall_us = (clock - toMicroseconds(pts, video_info_.time_base, video_base_us_)) / speed_.load();
+    return late_wall_us > config_.late_drop_us;
+}
+
+void MediaPipeline::audioLoop() {
+    COPY_ACCOUNT_STREAM("audio");
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    AVFrame* converted = av_frame_alloc();
+    if (!packet || !frame || !converted) {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        av_frame_free(&converted);
+        handleError("内存分配失败");
+        audio_finished_.store(true);
+        return;
+    }
+
+    const int channels = audio_output_->format().channels;
+    std::vector<float> stretched;
+    uint64_t generation = speed_generation_.load();
+    uint64_t serial = 0;
+    uint64_t packet_serial = 0;
+    bool boundary = false;
+    double speed = speed_.load();
+    bool align_pending = false;             // 变速/重新定位后，第一段数据需要与主时钟对齐
+    int64_t segment_pts_us = AV_NOPTS_VALUE; // 伸缩器本次reset后第一帧的pts
+    int64_t end_us = AV_NOPTS_VALUE;        // 当前条目已写出音频的结束位置（管道时间）
+
+    stretcher_->setSpeed(speed);
+    audio_output_->setClockScale(speed);
+
+    // 已转换的一帧：变速 -> 写入输出；pts_us为AV_NOPTS_VALUE表示与上一帧连续
+    auto output = [&](int64_t pts_us) {
+        if (align_pending) {
+            // 整帧都早于时钟：丢弃
+            const int64_t frame_end_us = pts_us + av_rescale(converted->nb_samples, 1000000, converted->sample_rate);
+            const int64_t clock = systemClockUs();
+            if (pts_us != AV_NOPTS_VALUE && clock != AV_NOPTS_VALUE && frame_end_us <= clock) {
+                return;
+            }
+            if (!alignAudio(pts_us, generation)) {
+                return;
+            }
+            align_pending = false;
+        }
+
+        if (loudness_) {
+            loudness_->process(converted);
+        }
+        if (audio_callback_) {
+            audio_callback_(converted);
+        }
+
+        const int64_t duration_us = av_rescale(converted->nb_samples, 1000000, converted->sample_rate);
+        if (pts_us != AV_NOPTS_VALUE) {
+            end_us = pts_us + duration_us;
+        } else if (end_us != AV_NOPTS_VALUE) {
+            end_us += duration_us;
+        }
+
+        const float* samples = reinterpret_cast<const float*>(converted->data[0]);
+        const size_t frames = static_cast<size_t>(converted->nb_samples);
+        if (speed == 1.0) {
+            writeAudio(samples, frames, pts_us, generation);
+            return;
+        }
+
+        if (segment_pts_us == AV_NOPTS_VALUE) {
+            segment_pts_us = pts_us;
+        }
+        stretcher_->push(samples, frames);
+        const size_t available = stretcher_->availableFrames();
+        stretched.resize(available * channels);
+        const size_t pulled = stretcher_->pull(stretched.data(), available);
+        writeAudio(stretched.data(), pulled, segment_pts_us, generation);
+    };
+
+    // 已解码的一帧：转换后输出
+    auto consume = [&](AVFrame* decoded) {
+        COPY_ACCOUNT_FRAME("audio");
+        av_frame_unref(converted);
+        if (!audio_converter_->convert(decoded, converted)) {
+            return;
+        }
+        const int64_t pts = decoded->best_effort_timestamp != AV_NOPTS_VALUE ? decoded->best_effort_timestamp
+                                                                             : decoded->pts;
+        output(pts != AV_NOPTS_VALUE ? toMicroseconds(pts, audio_info_.time_base, audio_base_us_.load())
+                                     : AV_NOPTS_VALUE);
+    };
+
+    // 条目/文件结束：排空解码器和重采样器中剩余的样本
+    auto drain = [&]() {
+        audio_decoder_->sendPacket(nullptr);
+        while (audio_decoder_->receiveFrame(frame)) {
+            consume(frame);
+            av_frame_unref(frame);
+        }
+        audio_decoder_->flush();
+        av_frame_unref(converted);
+        if (audio_converter_->drain(converted)) {
+            output(AV_NOPTS_VALUE);
+        }
+    };
+
+    while (audio_queue_->pop(packet, packet_serial, boundary)) {
+        if (boundary) {
+            if (audioActiveFor(speed)) {
+                drain();
+            } else {
+                audio_decoder_->flush();
+                end_us = AV_NOPTS_VALUE;
+            }
+
+            std::deque<AVFrame*> preroll;
+            if (!switchAudioItem(end_us, preroll)) {
+                break;
+            }
+            end_us = AV_NOPTS_VALUE;
+            for (AVFrame* decoded : preroll) {
+                if (is_running_.load() && audioActiveFor(speed)) {
+                    consume(decoded);
+                }
+                av_frame_free(&decoded);
+            }
+            continue;
+        }
+
+        const uint64_t current_generation = speed_generation_.load();
+        if (current_generation != generation || packet_serial != serial) {
+            // 变速或重新定位：丢弃已缓冲音频，时钟按新速度重建
+            if (packet_serial != serial) {
+                serial = packet_serial;
+                audio_decoder_->flush();
+            }
+            generation = current_generation;
+            speed = speed_.load();
+            audio_output_->flush();
+            audio_output_->setClockScale(speed);
+            stretcher_->reset();
+            stretcher_->setSpeed(speed);
+            segment_pts_us = AV_NOPTS_VALUE;
+            align_pending = true;
+        }
+
+        if (!audioActiveFor(speed)) {
+            audio_packets_dropped_.fetch_add(1, std::memory_order_relaxed);
+            metrics_.audio_dropped.add();
+            av_packet_unref(packet);
+            continue;
+        }
+
+        {
+            ScopedLatency timing(metrics_.audio_decode);
+            ScopedPerfCounters counters(audio_decode_counters_);
+            audio_decoder_->sendPacket(packet);
+        }
+        av_packet_unref(packet);
+        metrics_.audio_queue.set(static_cast<double>(audio_queue_->size()));
+        while (audio_decoder_->receiveFrame(frame)) {
+            consume(frame);
+            av_frame_unref(frame);
+        }
+        metrics_.audio_buffer_ms.set(audio_output_->getStatistics().getBufferedMs());
+    }
+
+    if (is_running_.load() && audioActiveFor(speed)) {
+        drain();
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    av_frame_free(&converted);
+    audio_finished_.store(true);
+    notifyIfFinished();
+}
+
+bool MediaPipeline::writeAudio(const float* samples, size_t frames, int64_t pts_us, uint64_t generation) {
+    const int channels = audio_output_->format().channels;
+    size_t offset = 0;
+    while (offset < frames) {
+        // 变速后剩余数据作废；停止时直接返回
+        if (!is_running_.load() || speed_generation_.load() != generation) {
+            return false;
+        }
+        const size_t writable = std::min(frames - offset, audio_output_->availableWrite());
+        if (writable == 0) {
+            std::this_thread::sleep_for(kAudioRetry);
+            continue;
+        }
+        const size_t written = audio_output_->write(reinterpret_cast<const uint8_t*>(samples + offset * channels),
+                                                    writable, offset == 0 ? pts_us : AV_NOPTS_VALUE);
+        offset += written;
+        audio_frames_written_.fetch_add(written, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool MediaPipeline::alignAudio(int64_t pts_us, uint64_t generation) {
+    // 解码出的音频比时钟超前（输出缓冲刚被丢弃）：先补静音，并以当前时钟建立音频时钟基准
+    const int64_t clock = systemClockUs();
+    if (pts_us == AV_NOPTS_VALUE || clock == AV_NOPTS_VALUE) {
+        return true;
+    }
+    const int64_t gap_us = pts_us - clock;
+    if (gap_us <= 0 || gap_us > kMaxAlignGapUs) {
+        return true;
+    }
+
+    const AudioFormat& format = audio_output_->format();
+    const size_t silence_frames = static_cast<size_t>(
+        gap_us / speed_.load() * format.sample_rate / 1000000.0);
+    const std::vector<float> silence(silence_frames * format.channels, 0.0f);
+    return writeAudio(silence.data(), silence_frames, clock, generation);
+}
+
+MediaPipeline::VideoDecodeMode MediaPipeline::decodeModeFor(double speed) const {
+    if (speed > config_.keyframe_only_speed) {
+        return VideoDecodeMode::KeyframeOnly;
+    }
+    if (speed > config_.nonref_skip_speed) {
+        return VideoDecodeMode::SkipNonRef;
+    }
+    return VideoDecodeMode::All;
+}
+
+bool MediaPipeline::audioActiveFor(double speed) const {
+    return speed <= WsolaTimeStretcher::kMaxSpeed;
+}
+
+int64_t MediaPipeline::toMicroseconds(int64_t pts, AVRational time_base, int64_t base_us) {
+    return av_rescale_q(pts, time_base, AV_TIME_BASE_Q) + base_us;
+}
+
+int64_t MediaPipeline::frameEndUs(const AVFrame* frame, int64_t pts_us) const {
+    // 帧时长优先取帧自带的，没有时按帧率估算
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+    if (frame->duration > 0) {
+        return pts_us + av_rescale_q(frame->duration, video_info_.time_base, AV_TIME_BASE_Q);
+    }
+#else
+    (void)frame;
+#endif
+    const AVRational rate = video_info_.frame_rate;
+    return rate.num > 0 && rate.den > 0 ? pts_us + av_rescale(1000000, rate.den, rate.num) : pts_us;
+}
+
+int64_t MediaPipeline::systemClockUs() const {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    if (anchor_media_us_ == AV_NOPTS_VALUE) {
+        return AV_NOPTS_VALUE;
+    }
+    return anchor_media_us_ + static_cast<int64_t>((nowUs() - anchor_wall_us_) * speed_.load());
+}
+
+void MediaPipeline::anchorSystemClock(int64_t media_us) {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    anchor_media_us_ = media_us;
+    anchor_wall_us_ = nowUs();
+}
+
+int64_t MediaPipeline::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MediaPipeline::setVideoFrameCallback(VideoFrameCallback callback) {
+    video_callback_ = std::move(callback);
+}
+
+void MediaPipeline::setAnalyticsStage(std::shared_ptr<AnalyticsStage> stage) {
+    analytics_ = std::move(stage);
+}
+
+void MediaPipeline::setLoudnessMeter(std::shared_ptr<LoudnessMeter> meter) {
+    loudness_ = std::move(meter);
+}
+
+void MediaPipeline::setMetadataExtractor(std::shared_ptr<TimedMetadataExtractor> extractor) {
+    metadata_ = std::move(extractor);
+}
+
+void MediaPipeline::setMemoryTracker(std::shared_ptr<MemoryTracker> tracker) {
+    memory_tracker_ = std::move(tracker);
+}
+
+void MediaPipeline::setAudioFrameCallback(AudioFrameCallback callback) {
+    audio_callback_ = std::move(callback);
+}
+
+void MediaPipeline::setErrorCallback(ErrorCallback callback) {
+    error_callback_ = std::move(callback);
+}
+
+void MediaPipeline::setItemChangedCallback(ItemChangedCallback callback) {
+    item_callback_ = std::move(callback);
+}
+
+void MediaPipeline::setEndCallback(EndCallback callback) {
+    end_callback_ = std::move(callback);
+}
+
+StreamInfo MediaPipeline::getVideoStreamInfo() const {
+    std::lock_guard<std::mutex> lock(info_mutex_);
+    return video_info_;
+}
+
+StreamInfo MediaPipeline::getAudioStreamInfo() const {
+    std::lock_guard<std::mutex> lock(info_mutex_);
+    return audio_info_;
+}
+
+MediaPipeline::StatisticsSnapshot MediaPipeline::getStatistics() const {
+    StatisticsSnapshot snapshot{};
+    snapshot.video_packets_read = video_packets_read_.load();
+    snapshot.video_packets_skipped = video_packets_skipped_.load();
+    snapshot.video_frames_decoded = video_frames_decoded_.load();
+    snapshot.video_frames_presented = video_frames_presented_.load();
+    snapshot.video_frames_dropped_late = video_frames_dropped_late_.load();
+    snapshot.audio_packets_dropped = audio_packets_dropped_.load();
+    snapshot.audio_frames_written = audio_frames_written_.load();
+    snapshot.average_sync_error_ms = snapshot.video_frames_presented > 0
+        ? sync_error_total_us_.load() / 1000.0 / snapshot.video_frames_presented : 0.0;
+    snapshot.max_sync_error_ms = sync_error_max_us_.load() / 1000.0;
+    snapshot.playback_speed = speed_.load();
+    snapshot.audio_clock_master = audio_clock_master_.load();
+    {
+        std::lock_guard<std::mutex> lock(item_mutex_);
+        snapshot.items_switched = items_switched_;
+    }
+    snapshot.demux_counters = demux_counters_.getStatistics();
+    snapshot.video_decode_counters = video_decode_counters_.getStatistics();
+    snapshot.audio_decode_counters = audio_decode_counters_.getStatistics();
+    return snapshot;
+}
+
+std::string MediaPipeline::getLastError() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+void MediaPipeline::handleError(const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        last_error_ = error;
+    }
+    if (error_callback_) {
+        error_callback_(error);
+    }
+}
+
+} // namespace media
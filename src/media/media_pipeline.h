@@ -2,107 +2,425 @@
 #define MEDIA_PIPELINE_H
 
 #include "input/input_source.h"
-#include "demux/demuxer.h" 
-#include "decoder/video_decoder.h"
-#include "decoder/audio_decoder.h"
-#include "converter/video_converter.h"
-#include "converter/audio_converter.h"
+#include "demux/demuxer.h"
+#include "audio/audio_output.h"
+#include "../utils/metrics_registry.h"
+#include "../utils/perf_counters.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class MemoryTracker;
 
 namespace media {
 
+class FFmpegDemuxer;
+class FFmpegVideoDecoder;
+class FFmpegAudioDecoder;
+class FFmpegAudioConverter;
+class WsolaTimeStretcher;
+class AnalyticsStage;
+class LoudnessMeter;
+class TimedMetadataExtractor;
+
 /**
  * @brief 媒体处理管道
- * 
+ *
  * 协调各个模块的工作，提供统一的接口
+ *
+ * 设计特点：
+ * 1. 三线程：解封装线程按流分发到有界包队列，视频/音频线程各自解码
+ * 2. 变速播放（0.5x~16x）：
+ *    - 音频：2x以内经WSOLA变速不变调后送音频输出，超过2x静音并直接丢包不解码
+ *    - 视频：按速度逐级降低解码量——全解码 -> 跳过非参考帧 -> 只解码关键帧，
+ *      关键帧模式下非关键帧在解封装线程就被丢弃，已经落后于时钟的关键帧不送解码器
+ * 3. 主时钟：音频输出有效时以音频时钟为准，否则使用按速度推进的系统时钟；
+ *    视频帧早到则等待，晚到超过阈值则丢弃，保证高倍速下CPU不随速度线性增长
+ * 4. 无缝衔接：播放中可在后台预备下一条目（打开、探测、建解码器并预解码开头几帧），
+ *    解封装到达末尾后直接换用新条目，向包队列插入边界标记；解码线程排空旧解码器后切换，
+ *    新条目的第一个音频样本紧接在上一条目最后一个样本之后写入同一音频输出，
+ *    视频按同一时间偏移上屏，切换不经过停止/重开
  */
 class MediaPipeline {
 public:
-    MediaPipeline();
-    ~MediaPipeline();
-    
+    /**
+     * @brief 管道配置
+     */
+    struct Config {
+        bool enable_audio;                  // 是否播放音频
+        AudioOutput::Config audio;          // 音频输出配置（格式中的sample_fmt固定为FLT）
+        int video_decoder_threads;          // 视频解码线程数，0表示自动
+        double nonref_skip_speed;           // 超过此速度跳过非参考帧
+        double keyframe_only_speed;         // 超过此速度只解码关键帧
+        int64_t late_drop_us;               // 视频帧落后主时钟超过此值（墙钟）即丢弃
+        size_t video_queue_packets;         // 视频包队列容量
+        size_t audio_queue_packets;         // 音频包队列容量
+
+        Config()
+            : enable_audio(true)
+            , video_decoder_threads(0)
+            , nonref_skip_speed(2.0)
+            , keyframe_only_speed(4.0)
+            , late_drop_us(40000)
+            , video_queue_packets(96)
+            , audio_queue_packets(192)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t video_packets_read;        // 读到的视频包
+        uint64_t video_packets_skipped;     // 未解码就丢弃的视频包（非参考/非关键帧、落后的关键帧）
+        uint64_t video_frames_decoded;
+        uint64_t video_frames_presented;
+        uint64_t video_frames_dropped_late; // 解码后因落后被丢弃的帧
+        uint64_t audio_packets_dropped;     // 超过音频变速上限时丢弃的音频包
+        uint64_t audio_frames_written;      // 写入音频输出的采样帧（变速后）
+        double average_sync_error_ms;       // 视频帧显示时刻与主时钟的平均偏差（墙钟）
+        double max_sync_error_ms;
+        double playback_speed;
+        bool audio_clock_master;            // 当前是否以音频时钟为主时钟
+        uint64_t items_switched;            // 无缝切换到下一条目的次数
+        // 硬件计数器（PerfCounters启用且可用时），只含管道自己的线程，不含FFmpeg解码工作线程
+        PerfStage::StatisticsSnapshot demux_counters;
+        PerfStage::StatisticsSnapshot video_decode_counters;
+        PerfStage::StatisticsSnapshot audio_decode_counters;
+    };
+
     // 回调函数类型
     using VideoFrameCallback = std::function<void(AVFrame*)>;
     using AudioFrameCallback = std::function<void(AVFrame*)>;
     using ErrorCallback = std::function<void(const std::string&)>;
-    
+    using ItemChangedCallback = std::function<void(uint64_t)>;
+    using EndCallback = std::function<void()>;
+
+    static constexpr double kMinSpeed = 0.5;
+    static constexpr double kMaxSpeed = 16.0;
+
+public:
+    MediaPipeline();
+    ~MediaPipeline();
+
+    MediaPipeline(const MediaPipeline&) = delete;
+    MediaPipeline& operator=(const MediaPipeline&) = delete;
+
     /**
      * @brief 打开媒体源
      * @param url 媒体地址
      * @return 是否成功
      */
     bool open(const std::string& url);
-    
+
+    /**
+     * @brief 按指定配置打开媒体源
+     */
+    bool open(const std::string& url, const Config& config);
+
     /**
      * @brief 开始处理
      * @return 是否成功
      */
     bool start();
-    
+
     /**
      * @brief 停止处理
      */
     void stop();
-    
+
     /**
      * @brief 关闭管道
      */
     void close();
-    
+
+    /**
+     * @brief 设置播放速度（任意线程，运行中可调）
+     *
+     * 速度夹到[kMinSpeed, kMaxSpeed]。切换时丢弃已缓冲的音频并以当前主时钟重新锚定，
+     * 画面不会跳变。
+     * @return 实际生效的速度
+     */
+    double setPlaybackSpeed(double speed);
+    double getPlaybackSpeed() const { return speed_.load(); }
+
+    /**
+     * @brief 主时钟（微秒，媒体时间），尚未开始播放时返回AV_NOPTS_VALUE
+     */
+    int64_t getMasterClockUs() const;
+
+    /**
+     * @brief 音视频是否都已播放到末尾
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief 预备下一条目（阻塞，在后台线程调用，可与播放同时进行）
+     *
+     * 打开输入、探测、创建解码器并预解码开头的帧，完成后挂起等待当前条目结束。
+     * 下一条目的音视频流组成必须与当前相同（都有/都没有视频、音频），否则返回false，
+     * 调用方应在当前条目结束后重新open。不能与open/close并发调用。
+     * @return 是否预备成功；已预备但尚未切换的条目会被替换
+     */
+    bool prepareNext(const std::string& url);
+
+    /**
+     * @brief 解封装到达末尾而下一条目尚未预备好时是否等待（默认不等待）
+     *
+     * 播放列表在还有后续条目时打开，避免预备稍慢时当前条目先行结束；
+     * 没有后续条目或预备失败时关闭，让管道正常结束。
+     */
+    void setWaitForNext(bool wait);
+
+    /**
+     * @brief 设置条目切换回调
+     *
+     * 音视频解码线程都切换到新条目后，在最后完成切换的解码线程中调用，参数为累计切换次数。
+     * 回调中可以调用prepareNext以外的非阻塞接口（如setWaitForNext）。
+     */
+    void setItemChangedCallback(ItemChangedCallback callback);
+
+    /**
+     * @brief 设置播放结束回调
+     *
+     * 音视频都自然播放到末尾（没有可切换的下一条目）时在解码线程中调用一次；stop不会触发。
+     */
+    void setEndCallback(EndCallback callback);
+
     /**
      * @brief 设置视频帧回调
+     *
+     * 在视频线程中、帧的显示时刻调用；回调返回后帧即被复用。
      * @param callback 回调函数
      */
     void setVideoFrameCallback(VideoFrameCallback callback);
-    
+
+    /**
+     * @brief 挂接画面分析阶段（start之前设置，分析阶段由调用方启动和停止）
+     *
+     * 每个解码出的视频帧（包括之后因落后被丢弃的帧）都以引用方式提交，分析跟不上时由分析阶段自行丢帧。
+     */
+    void setAnalyticsStage(std::shared_ptr<AnalyticsStage> stage);
+
+    /**
+     * @brief 挂接响度表（start之前设置）
+     *
+     * 在音频线程中测量转换后、变速之前的音频，响度表的采样率和声道数须与config.audio.format一致。
+     */
+    void setLoudnessMeter(std::shared_ptr<LoudnessMeter> meter);
+
+    /**
+     * @brief 挂接定时元数据提取（start之前设置）
+     *
+     * 在解封装线程中、视频包入队之前只读扫描SEI，字幕/数据流的包不再直接丢弃而是写入提取器的轨道。
+     * 每次开始读取和切换条目时按当前解封装器重新选择流；切换条目时清空轨道，
+     * 上一条目还在队列里的最后几帧查不到元数据。
+     */
+    void setMetadataExtractor(std::shared_ptr<TimedMetadataExtractor> extractor);
+
+    /**
+     * @brief 记录分配轨迹（open之前设置）
+     *
+     * 包队列里的数据包和解码器的帧缓冲都包装成带跟踪的引用，分配/释放连同线程和顺序写入跟踪器，
+     * 调用方在跟踪器上startTrace/stopTrace并保存轨迹，供alloc_replay离线回放比较分配器。
+     */
+    void setMemoryTracker(std::shared_ptr<MemoryTracker> tracker);
+
     /**
      * @brief 设置音频帧回调
+     *
+     * 在音频线程中调用，帧已转换为输出格式（变速之前）。
      * @param callback 回调函数
      */
     void setAudioFrameCallback(AudioFrameCallback callback);
-    
+
     /**
      * @brief 设置错误回调
      * @param callback 回调函数
      */
     void setErrorCallback(ErrorCallback callback);
-    
+
     /**
      * @brief 获取视频流信息
      * @return 流信息
      */
     StreamInfo getVideoStreamInfo() const;
-    
+
     /**
      * @brief 获取音频流信息
      * @return 流信息
      */
     StreamInfo getAudioStreamInfo() const;
 
+    StatisticsSnapshot getStatistics() const;
+    std::string getLastError() const;
+
+private:
+    class PacketQueue;
+    struct Item;
+
+    /**
+     * @brief 视频解码策略，由播放速度决定
+     */
+    enum class VideoDecodeMode {
+        All,            // 全部解码
+        SkipNonRef,     // 跳过非参考帧
+        KeyframeOnly    // 只解码关键帧
+    };
+
+    // 内部方法
+    bool openItem(const std::string& url, Item& item);
+    bool setupVideo(Item& item);
+    bool setupAudio(Item& item);
+    bool setupAudioOutput();
+    bool prerollItem(Item& item);
+    void adoptItem(Item& item);
+    bool switchDemuxer(int& video_index, int& audio_index);
+    bool switchVideoItem(int64_t end_us, std::deque<AVFrame*>& preroll);
+    bool switchAudioItem(int64_t end_us, std::deque<AVFrame*>& preroll);
+    bool completeSwitchLocked(uint64_t& switched);
+    void abandonSwitch();
+    void activateMetadataItem(const Item& item);
+    int64_t fallbackOffsetUs(int64_t first_us) const;
+    void notifyIfFinished();
+    void processPackets();
+    void videoLoop();
+    void audioLoop();
+    void handleError(const std::string& error);
+
+    VideoDecodeMode decodeModeFor(double speed) const;
+    bool audioActiveFor(double speed) const;
+    void presentVideoFrame(AVFrame* frame);
+    bool isKeyframeLate(const AVPacket* packet) const;
+    bool writeAudio(const float* samples, size_t frames, int64_t pts_us, uint64_t generation);
+    bool alignAudio(int64_t pts_us, uint64_t generation);
+    int64_t frameEndUs(const AVFrame* frame, int64_t pts_us) const;
+    static int64_t toMicroseconds(int64_t pts, AVRational time_base, int64_t base_us);
+    int64_t systemClockUs() const;
+    void anchorSystemClock(int64_t media_us);
+    static int64_t nowUs();
+
 private:
+    Config config_;
+
     // 各个模块的实例
     std::shared_ptr<IInputSource> input_source_;
-    std::unique_ptr<IDemuxer> demuxer_;
-    std::unique_ptr<IVideoDecoder> video_decoder_;
-    std::unique_ptr<IAudioDecoder> audio_decoder_;
-    std::unique_ptr<IVideoConverter> video_converter_;
-    std::unique_ptr<IAudioConverter> audio_converter_;
-    
+    std::unique_ptr<FFmpegDemuxer> demuxer_;
+    std::unique_ptr<FFmpegVideoDecoder> video_decoder_;
+    std::unique_ptr<FFmpegAudioDecoder> audio_decoder_;
+    std::unique_ptr<FFmpegAudioConverter> audio_converter_;
+    std::unique_ptr<WsolaTimeStretcher> stretcher_;
+    std::unique_ptr<AudioOutput> audio_output_;
+
+    // 流信息在解码线程切换条目时改写，其他线程读取需加锁
+    mutable std::mutex info_mutex_;
+    StreamInfo video_info_;
+    StreamInfo audio_info_;
+
+    // 管道时间 = 条目内时间戳换算的微秒 + base；首个条目的base为负的文件起始时间，
+    // 之后每个条目的base由其在管道时间轴上的偏移决定
+    int64_t video_base_us_ = 0;                 // 视频线程独占
+    std::atomic<int64_t> audio_base_us_{0};     // 音频线程使用，无音频结束位置时由视频线程补设
+    std::atomic<int64_t> item_offset_us_{0};    // 当前条目时间0在管道时间轴上的位置（重新定位用）
+
+    std::unique_ptr<PacketQueue> video_queue_;
+    std::unique_ptr<PacketQueue> audio_queue_;
+
     // 内部状态
-    bool is_running_ = false;
+    std::thread demux_thread_;
+    std::thread video_thread_;
+    std::thread audio_thread_;
+    std::atomic<bool> is_running_{false};
+    std::atomic<bool> video_finished_{true};
+    std::atomic<bool> audio_finished_{true};
+    mutable std::mutex error_mutex_;
     std::string last_error_;
-    
+
+    // 速度：每次修改递增generation，工作线程据此感知切换
+    std::atomic<double> speed_{1.0};
+    std::atomic<uint64_t> speed_generation_{0};
+
+    // 切换到更密集的解码策略时，队列里缺少被丢弃的包，需要在当前时刻重新定位；
+    // 重新定位后的包带新的serial，解码线程遇到新serial即刷新解码器
+    std::atomic<bool> resync_requested_{false};
+    std::atomic<int64_t> resync_target_us_{0};
+    uint64_t packet_serial_ = 0;        // 解封装线程独占
+
+    // 条目衔接：next_由prepareNext填入；解封装线程换用后移到switching_，
+    // 音视频解码线程都切换后移到retired_（此时装着上一条目的资源），下次预备或关闭时释放
+    mutable std::mutex item_mutex_;
+    std::condition_variable item_cv_;
+    std::unique_ptr<Item> next_;
+    std::unique_ptr<Item> switching_;
+    std::unique_ptr<Item> retired_;
+    bool preparing_ = false;
+    bool wait_for_next_ = false;
+    uint64_t items_switched_ = 0;
+    std::atomic<bool> end_notified_{false};
+
+    // 系统时钟锚点：media = anchor_media + (now - anchor_wall) * speed
+    mutable std::mutex clock_mutex_;
+    int64_t anchor_media_us_ = AV_NOPTS_VALUE;
+    int64_t anchor_wall_us_ = 0;
+    mutable std::atomic<bool> audio_clock_master_{false};
+
+    // 视频线程等待：停止或变速时唤醒
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+
+    // 画面分析、响度测量与定时元数据（可选）
+    std::shared_ptr<AnalyticsStage> analytics_;
+    std::shared_ptr<LoudnessMeter> loudness_;
+    std::shared_ptr<TimedMetadataExtractor> metadata_;
+
+    // 分配轨迹（可选）
+    std::shared_ptr<MemoryTracker> memory_tracker_;
+
     // 回调函数
     VideoFrameCallback video_callback_;
     AudioFrameCallback audio_callback_;
     ErrorCallback error_callback_;
-    
-    // 内部方法
-    bool setupVideo();
-    bool setupAudio();
-    void processPackets();
-    void handleError(const std::string& error);
+    ItemChangedCallback item_callback_;
+    EndCallback end_callback_;
+
+    // 统计
+    std::atomic<uint64_t> video_packets_read_{0};
+    std::atomic<uint64_t> video_packets_skipped_{0};
+    std::atomic<uint64_t> video_frames_decoded_{0};
+    std::atomic<uint64_t> video_frames_presented_{0};
+    std::atomic<uint64_t> video_frames_dropped_late_{0};
+    std::atomic<uint64_t> audio_packets_dropped_{0};
+    std::atomic<uint64_t> audio_frames_written_{0};
+    std::atomic<int64_t> sync_error_total_us_{0};
+    std::atomic<int64_t> sync_error_max_us_{0};
+
+    // 性能浮层指标（MetricsRegistry，多个管道实例累加）
+    struct Metrics {
+        Metric& demux;
+        Metric& video_decode;
+        Metric& video_present;      // 耗时记为显示时刻相对主时钟的偏差
+        Metric& audio_decode;
+        Metric& video_queue;
+        Metric& audio_queue;
+        Metric& audio_buffer_ms;
+        Metric& video_late;
+        Metric& video_skipped;
+        Metric& audio_dropped;
+    };
+    Metrics metrics_;
+
+    // 各阶段硬件计数器（perf.<阶段>.*）
+    PerfStage demux_counters_{"demux"};
+    PerfStage video_decode_counters_{"video_decode"};
+    PerfStage audio_decode_counters_{"audio_decode"};
 };
 
 } // namespace media
 
-#endif // MEDIA_PIPELINE_H
\ No newline at end of file
+#endif // MEDIA_PIPELINE_H
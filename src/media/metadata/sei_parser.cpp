@@ -0,0 +1,505 @@
+#include "sei_parser.h"
+
+#include <cstring>
+
+namespace media {
+
+namespace {
+
+/**
+ * @brief 大端比特读取，越界后返回0并置overrun
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size)
+        : data_(data), size_bits_(size * 8) {}
+
+    uint32_t bits(int count) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value = (value << 1) | bit();
+        }
+        return value;
+    }
+
+    uint32_t bit() {
+        if (position_ >= size_bits_) {
+            overrun_ = true;
+            return 0;
+        }
+        const uint32_t value = (data_[position_ >> 3] >> (7 - (position_ & 7))) & 1;
+        ++position_;
+        return value;
+    }
+
+    void skip(size_t count) {
+        position_ += count;
+        if (position_ > size_bits_) {
+            overrun_ = true;
+        }
+    }
+
+    uint32_t ue() {
+        int leading_zeros = 0;
+        while (bit() == 0) {
+            if (overrun_ || ++leading_zeros > 31) {
+                overrun_ = true;
+                return 0;
+            }
+        }
+        return ((1u << leading_zeros) - 1) + bits(leading_zeros);
+    }
+
+    int32_t se() {
+        const uint32_t value = ue();
+        return (value & 1) ? static_cast<int32_t>((value + 1) / 2) : -static_cast<int32_t>(value / 2);
+    }
+
+    void fail() { overrun_ = true; }
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_bits_;
+    size_t position_ = 0;
+    bool overrun_ = false;
+};
+
+void skipScalingList(BitReader& reader, int size) {
+    int last_scale = 8;
+    int next_scale = 8;
+    for (int j = 0; j < size && !reader.overrun(); ++j) {
+        if (next_scale != 0) {
+            next_scale = (last_scale + reader.se() + 256) % 256;
+        }
+        last_scale = next_scale == 0 ? last_scale : next_scale;
+    }
+}
+
+/**
+ * @brief H.264 hrd_parameters()
+ */
+void readHrd(BitReader& reader, int* cpb_removal_delay_length, int* dpb_output_delay_length,
+             int* time_offset_length) {
+    const uint32_t cpb_count = reader.ue() + 1;
+    if (cpb_count > 32) {
+        reader.fail();
+        return;
+    }
+    reader.skip(4 + 4);                 // bit_rate_scale, cpb_size_scale
+    for (uint32_t i = 0; i < cpb_count; ++i) {
+        reader.ue();                    // bit_rate_value_minus1
+        reader.ue();                    // cpb_size_value_minus1
+        reader.bit();                   // cbr_flag
+    }
+    reader.skip(5);                     // initial_cpb_removal_delay_length_minus1
+    *cpb_removal_delay_length = static_cast<int>(reader.bits(5)) + 1;
+    *dpb_output_delay_length = static_cast<int>(reader.bits(5)) + 1;
+    *time_offset_length = static_cast<int>(reader.bits(5));
+}
+
+/**
+ * @brief clock_timestamp中full_timestamp_flag及之后的时间字段（H.264与HEVC相同，只有帧号位数不同）
+ */
+bool readTimestampFields(BitReader& reader, int frame_bits, Timecode* timecode) {
+    const bool full = reader.bit();
+    reader.bit();                       // discontinuity_flag
+    timecode->drop_frame = reader.bit();
+    timecode->frames = static_cast<int>(reader.bits(frame_bits));
+    if (full) {
+        timecode->seconds = static_cast<int>(reader.bits(6));
+        timecode->minutes = static_cast<int>(reader.bits(6));
+        timecode->hours = static_cast<int>(reader.bits(5));
+    } else if (reader.bit()) {          // seconds_flag
+        timecode->seconds = static_cast<int>(reader.bits(6));
+        if (reader.bit()) {             // minutes_flag
+            timecode->minutes = static_cast<int>(reader.bits(6));
+            if (reader.bit()) {         // hours_flag
+                timecode->hours = static_cast<int>(reader.bits(5));
+            }
+        }
+    }
+    return !reader.overrun() && timecode->seconds < 60 && timecode->minutes < 60 && timecode->hours < 24;
+}
+
+const uint8_t* findStartCode(const uint8_t* begin, const uint8_t* end) {
+    const uint8_t* p = begin + 2;
+    while (p < end) {
+        p = static_cast<const uint8_t*>(std::memchr(p, 1, static_cast<size_t>(end - p)));
+        if (!p) {
+            return end;
+        }
+        if (p[-1] == 0 && p[-2] == 0) {
+            return p - 2;
+        }
+        p += 1;
+    }
+    return end;
+}
+
+} // namespace
+
+SeiParser::SeiParser(Codec codec, int nal_length_size)
+    : codec_(codec)
+    , nal_length_size_(nal_length_size >= 1 && nal_length_size <= 4 ? nal_length_size : 0)
+{
+}
+
+void SeiParser::parseExtradata(const uint8_t* data, size_t size) {
+    if (!data || size == 0) {
+        return;
+    }
+    const Callback ignore = [](const Message&) {};
+
+    if (data[0] != 1) {
+        // Annex B参数集
+        nal_length_size_ = 0;
+        parse(data, size, ignore);
+        return;
+    }
+
+    if (codec_ == Codec::H264) {
+        // avcC：version, profile, compat, level, lengthSizeMinusOne, numSPS, {size, sps}...
+        if (size < 7) {
+            return;
+        }
+        nal_length_size_ = (data[4] & 3) + 1;
+        const int sps_count = data[5] & 0x1F;
+        size_t pos = 6;
+        for (int i = 0; i < sps_count && pos + 2 <= size; ++i) {
+            const size_t length = (static_cast<size_t>(data[pos]) << 8) | data[pos + 1];
+            pos += 2;
+            if (length > size - pos) {
+                return;
+            }
+            parseNal(data + pos, length, ignore);
+            pos += length;
+        }
+    } else {
+        // hvcC：第21字节低2位为lengthSizeMinusOne；HEVC时间码不依赖SPS
+        if (size < 23) {
+            return;
+        }
+        nal_length_size_ = (data[21] & 3) + 1;
+    }
+}
+
+int SeiParser::parse(const uint8_t* data, size_t size, const Callback& callback) {
+    if (!data || size == 0) {
+        return 0;
+    }
+
+    int messages = 0;
+    bool malformed = false;
+
+    if (nal_length_size_ > 0) {
+        size_t pos = 0;
+        while (pos + nal_length_size_ <= size) {
+            size_t length = 0;
+            for (int i = 0; i < nal_length_size_; ++i) {
+                length = (length << 8) | data[pos++];
+            }
+            if (length > size - pos) {
+                malformed = true;
+                break;
+            }
+            const int result = parseNal(data + pos, length, callback);
+            if (result < 0) {
+                malformed = true;
+            } else {
+                messages += result;
+            }
+            pos += length;
+        }
+    } else {
+        const uint8_t* end = data + size;
+        const uint8_t* start = findStartCode(data, end);
+        while (start < end) {
+            const uint8_t* nal = start + 3;
+            const uint8_t* next = findStartCode(nal, end);
+            const uint8_t* nal_end = next;
+            while (nal_end > nal && nal_end[-1] == 0) {
+                --nal_end;
+            }
+            const int result = parseNal(nal, static_cast<size_t>(nal_end - nal), callback);
+            if (result < 0) {
+                malformed = true;
+            } else {
+                messages += result;
+            }
+            start = next;
+        }
+    }
+
+    return malformed ? -1 : messages;
+}
+
+int SeiParser::parseNal(const uint8_t* nal, size_t size, const Callback& callback) {
+    if (size == 0) {
+        return 0;
+    }
+
+    size_t rbsp_size = 0;
+    if (codec_ == Codec::H264) {
+        const int type = nal[0] & 0x1F;
+        if (type == 7) {
+            const uint8_t* rbsp = unescape(nal + 1, size - 1, &rbsp_size);
+            return parseSps(rbsp, rbsp_size) ? 0 : -1;
+        }
+        if (type != 6) {
+            return 0;
+        }
+        const uint8_t* rbsp = unescape(nal + 1, size - 1, &rbsp_size);
+        return parseSeiRbsp(rbsp, rbsp_size, callback);
+    }
+
+    const int type = (nal[0] >> 1) & 0x3F;
+    if ((type != 39 && type != 40) || size < 2) {   // PREFIX_SEI / SUFFIX_SEI
+        return 0;
+    }
+    const uint8_t* rbsp = unescape(nal + 2, size - 2, &rbsp_size);
+    return parseSeiRbsp(rbsp, rbsp_size, callback);
+}
+
+const uint8_t* SeiParser::unescape(const uint8_t* data, size_t size, size_t* out_size) {
+    if (scratch_.size() < size) {
+        scratch_.resize(size);
+    }
+    uint8_t* out = scratch_.data();
+    size_t written = 0;
+    int zeros = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t byte = data[i];
+        if (zeros >= 2 && byte == 3) {
+            zeros = 0;
+            continue;
+        }
+        out[written++] = byte;
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    *out_size = written;
+    return out;
+}
+
+bool SeiParser::parseSps(const uint8_t* rbsp, size_t size) {
+    BitReader reader(rbsp, size);
+    SpsTiming sps;
+
+    const uint32_t profile_idc = reader.bits(8);
+    reader.skip(8 + 8);                 // constraint_set flags, level_idc
+    reader.ue();                        // seq_parameter_set_id
+
+    switch (profile_idc) {
+    case 100: case 110: case 122: case 244: case 44:
+    case 83: case 86: case 118: case 128: case 138:
+    case 139: case 134: case 135: {
+        const uint32_t chroma_format_idc = reader.ue();
+        if (chroma_format_idc == 3) {
+            reader.bit();               // separate_colour_plane_flag
+        }
+        reader.ue();                    // bit_depth_luma_minus8
+        reader.ue();                    // bit_depth_chroma_minus8
+        reader.bit();                   // qpprime_y_zero_transform_bypass_flag
+        if (reader.bit()) {             // seq_scaling_matrix_present_flag
+            const int lists = chroma_format_idc == 3 ? 12 : 8;
+            for (int i = 0; i < lists; ++i) {
+                if (reader.bit()) {
+                    skipScalingList(reader, i < 6 ? 16 : 64);
+                }
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    reader.ue();                        // log2_max_frame_num_minus4
+    const uint32_t poc_type = reader.ue();
+    if (poc_type == 0) {
+        reader.ue();                    // log2_max_pic_order_cnt_lsb_minus4
+    } else if (poc_type == 1) {
+        reader.bit();                   // delta_pic_order_always_zero_flag
+        reader.se();                    // offset_for_non_ref_pic
+        reader.se();                    // offset_for_top_to_bottom_field
+        const uint32_t cycle = reader.ue();
+        if (cycle > 255) {
+            return false;
+        }
+        for (uint32_t i = 0; i < cycle; ++i) {
+            reader.se();
+        }
+    }
+    reader.ue();                        // max_num_ref_frames
+    reader.bit();                       // gaps_in_frame_num_value_allowed_flag
+    reader.ue();                        // pic_width_in_mbs_minus1
+    reader.ue();                        // pic_height_in_map_units_minus1
+    if (!reader.bit()) {                // frame_mbs_only_flag
+        reader.bit();                   // mb_adaptive_frame_field_flag
+    }
+    reader.bit();                       // direct_8x8_inference_flag
+    if (reader.bit()) {                 // frame_cropping_flag
+        reader.ue();
+        reader.ue();
+        reader.ue();
+        reader.ue();
+    }
+
+    if (reader.bit()) {                 // vui_parameters_present_flag
+        if (reader.bit()) {             // aspect_ratio_info_present_flag
+            if (reader.bits(8) == 255) {
+                reader.skip(16 + 16);   // sar_width, sar_height
+            }
+        }
+        if (reader.bit()) {             // overscan_info_present_flag
+            reader.bit();
+        }
+        if (reader.bit()) {             // video_signal_type_present_flag
+            reader.skip(3 + 1);
+            if (reader.bit()) {         // colour_description_present_flag
+                reader.skip(8 + 8 + 8);
+            }
+        }
+        if (reader.bit()) {             // chroma_loc_info_present_flag
+            reader.ue();
+            reader.ue();
+        }
+        if (reader.bit()) {             // timing_info_present_flag
+            reader.skip(32 + 32 + 1);
+        }
+        const bool nal_hrd = reader.bit();
+        if (nal_hrd) {
+            readHrd(reader, &sps.cpb_removal_delay_length, &sps.dpb_output_delay_length,
+                    &sps.time_offset_length);
+        }
+        const bool vcl_hrd = reader.bit();
+        if (vcl_hrd) {
+            readHrd(reader, &sps.cpb_removal_delay_length, &sps.dpb_output_delay_length,
+                    &sps.time_offset_length);
+        }
+        if (nal_hrd || vcl_hrd) {
+            reader.bit();               // low_delay_hrd_flag
+        }
+        sps.cpb_dpb_delays_present = nal_hrd || vcl_hrd;
+        sps.pic_struct_present = reader.bit();
+    }
+
+    if (reader.overrun()) {
+        return false;
+    }
+    sps.valid = true;
+    sps_ = sps;
+    return true;
+}
+
+int SeiParser::parseSeiRbsp(const uint8_t* rbsp, size_t size, const Callback& callback) {
+    int messages = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        if (rbsp[pos] == 0x80 && pos + 1 == size) {
+            break;                      // rbsp_trailing_bits
+        }
+
+        uint32_t payload_type = 0;
+        while (pos < size && rbsp[pos] == 0xFF) {
+            payload_type += 255;
+            ++pos;
+        }
+        if (pos >= size) {
+            return -1;
+        }
+        payload_type += rbsp[pos++];
+
+        size_t payload_size = 0;
+        while (pos < size && rbsp[pos] == 0xFF) {
+            payload_size += 255;
+            ++pos;
+        }
+        if (pos >= size) {
+            return -1;
+        }
+        payload_size += rbsp[pos++];
+        if (payload_size > size - pos) {
+            return -1;
+        }
+
+        Message message;
+        message.payload_type = static_cast<int>(payload_type);
+        message.payload = rbsp + pos;
+        message.size = payload_size;
+        if (codec_ == Codec::H264 && payload_type == kH264PicTiming) {
+            message.has_timecode = parseH264PicTiming(message.payload, payload_size, &message.timecode);
+        } else if (codec_ == Codec::Hevc && payload_type == kHevcTimeCode) {
+            message.has_timecode = parseHevcTimeCode(message.payload, payload_size, &message.timecode);
+        }
+        callback(message);
+        ++messages;
+        pos += payload_size;
+    }
+    return messages;
+}
+
+bool SeiParser::parseH264PicTiming(const uint8_t* payload, size_t size, Timecode* timecode) {
+    if (!sps_.valid || !sps_.pic_struct_present) {
+        return false;
+    }
+
+    static const int kNumClockTs[9] = {1, 1, 1, 2, 2, 3, 3, 2, 3};
+
+    BitReader reader(payload, size);
+    if (sps_.cpb_dpb_delays_present) {
+        reader.skip(sps_.cpb_removal_delay_length + sps_.dpb_output_delay_length);
+    }
+    const uint32_t pic_struct = reader.bits(4);
+    if (pic_struct > 8) {
+        return false;
+    }
+
+    bool found = false;
+    for (int i = 0; i < kNumClockTs[pic_struct]; ++i) {
+        if (!reader.bit()) {            // clock_timestamp_flag
+            continue;
+        }
+        reader.skip(2 + 1 + 5);         // ct_type, nuit_field_based_flag, counting_type
+        Timecode current = last_timecode_;
+        if (!readTimestampFields(reader, 8, &current)) {
+            return false;
+        }
+        if (sps_.time_offset_length > 0) {
+            reader.skip(sps_.time_offset_length);
+        }
+        last_timecode_ = current;
+        if (!found) {
+            *timecode = current;        // 场编码时取第一个时间戳
+            found = true;
+        }
+    }
+    return found && !reader.overrun();
+}
+
+bool SeiParser::parseHevcTimeCode(const uint8_t* payload, size_t size, Timecode* timecode) {
+    BitReader reader(payload, size);
+    const uint32_t num_clock_ts = reader.bits(2);
+
+    bool found = false;
+    for (uint32_t i = 0; i < num_clock_ts; ++i) {
+        if (!reader.bit()) {            // clock_timestamp_flag
+            continue;
+        }
+        reader.skip(1 + 5);             // units_field_based_flag, counting_type
+        Timecode current = last_timecode_;
+        if (!readTimestampFields(reader, 9, &current)) {
+            return false;
+        }
+        const uint32_t time_offset_length = reader.bits(5);
+        reader.skip(time_offset_length);
+        last_timecode_ = current;
+        if (!found) {
+            *timecode = current;
+            found = true;
+        }
+    }
+    return found && !reader.overrun();
+}
+
+} // namespace media
@@ -0,0 +1,96 @@
+#ifndef SEI_PARSER_H
+#define SEI_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "timed_metadata.h"
+
+namespace media {
+
+/**
+ * @brief H.264/HEVC SEI只读解析器
+ *
+ * 设计特点：
+ * 1. 只解析不解码：按NAL头跳过非SEI单元，只对SEI单元去除防竞争字节
+ * 2. 不改动输入：直接读取压缩包的内存，去防竞争字节写入复用的内部缓冲，稳态下不分配内存
+ * 3. 两种封装：AVCC/HVCC长度前缀（nal_length_size为1~4）和Annex B起始码（nal_length_size为0）
+ * 4. 时间码：H.264 pic_timing（需要SPS的VUI/HRD参数，取最近解析到的SPS）和HEVC time_code；
+ *    非完整时间戳（full_timestamp_flag为0）缺少的字段沿用上一个时间码
+ *
+ * 每个视频流一个实例，只在解封装线程使用。
+ */
+class SeiParser {
+public:
+    enum class Codec {
+        H264,
+        Hevc
+    };
+
+    static constexpr int kUserDataUnregistered = 5;
+    static constexpr int kH264PicTiming = 1;
+    static constexpr int kHevcTimeCode = 136;
+
+    /**
+     * @brief 一条SEI消息（payload指向内部缓冲，只在回调期间有效）
+     */
+    struct Message {
+        int payload_type = 0;
+        const uint8_t* payload = nullptr;
+        size_t size = 0;
+        bool has_timecode = false;
+        Timecode timecode;
+    };
+
+    using Callback = std::function<void(const Message&)>;
+
+public:
+    SeiParser(Codec codec, int nal_length_size);
+
+    /**
+     * @brief 按avcC/hvcC或Annex B格式的extradata初始化（读取NAL长度字段大小和SPS）
+     */
+    void parseExtradata(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 解析一个压缩包里的全部SEI消息
+     * @return 消息条数；包结构损坏时返回-1（已解析出的消息仍会回调）
+     */
+    int parse(const uint8_t* data, size_t size, const Callback& callback);
+
+    int nalLengthSize() const { return nal_length_size_; }
+    bool hasSps() const { return sps_.valid; }
+
+private:
+    /**
+     * @brief pic_timing依赖的H.264 SPS字段
+     */
+    struct SpsTiming {
+        bool valid = false;
+        bool cpb_dpb_delays_present = false;
+        int cpb_removal_delay_length = 24;
+        int dpb_output_delay_length = 24;
+        int time_offset_length = 24;
+        bool pic_struct_present = false;
+    };
+
+    int parseNal(const uint8_t* nal, size_t size, const Callback& callback);
+    const uint8_t* unescape(const uint8_t* data, size_t size, size_t* out_size);
+    bool parseSps(const uint8_t* rbsp, size_t size);
+    int parseSeiRbsp(const uint8_t* rbsp, size_t size, const Callback& callback);
+    bool parseH264PicTiming(const uint8_t* payload, size_t size, Timecode* timecode);
+    bool parseHevcTimeCode(const uint8_t* payload, size_t size, Timecode* timecode);
+
+private:
+    Codec codec_;
+    int nal_length_size_;
+    SpsTiming sps_;
+    Timecode last_timecode_;
+    std::vector<uint8_t> scratch_;          // 去防竞争字节后的RBSP
+};
+
+} // namespace media
+
+#endif // SEI_PARSER_H
@@ -0,0 +1,188 @@
+#include "timed_metadata.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace media {
+
+std::string Timecode::toString() const {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d%c%02d",
+                  hours, minutes, seconds, drop_frame ? ';' : ':', frames);
+    return buffer;
+}
+
+TimedMetadataTrack::TimedMetadataTrack(const Config& config)
+    : config_(config)
+{
+    config_.max_entries = std::max<size_t>(config_.max_entries, 1);
+    config_.max_payload_bytes = std::max<size_t>(config_.max_payload_bytes, 64);
+}
+
+bool TimedMetadataTrack::add(const TimedMetadata& entry) {
+    if (entry.size > config_.max_payload_bytes / 4) {
+        stats_.entries_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_.empty()) {
+        slots_.resize(config_.max_entries);
+        arena_.resize(config_.max_payload_bytes);
+    }
+
+    // 负载连续写入字节区，尾部放不下时从头开始
+    uint64_t seq = arena_seq_;
+    if (entry.size > 0) {
+        const size_t capacity = arena_.size();
+        size_t pos = static_cast<size_t>(seq % capacity);
+        if (pos + entry.size > capacity) {
+            seq += capacity - pos;
+            pos = 0;
+        }
+        COPY_MEMCPY("metadata.arena", arena_.data() + pos, entry.data, entry.size);
+        arena_seq_ = seq + entry.size;
+    }
+
+    if (count_ == slots_.size()) {
+        popFront();
+    }
+    while (count_ > 0 && !payloadValid(slotAt(0))) {
+        popFront();
+    }
+
+    Slot slot;
+    slot.item = write_item_;
+    slot.kind = entry.kind;
+    slot.stream_index = entry.stream_index;
+    slot.pts_us = entry.pts_us;
+    slot.duration_us = std::max<int64_t>(entry.duration_us, 0);
+    slot.timecode = entry.timecode;
+    slot.payload_seq = seq;
+    slot.payload_size = static_cast<uint32_t>(entry.size);
+
+    // 插入排序：通常就在末尾，解码顺序与显示顺序不同时向前移动几格；不越过上一条目
+    size_t i = count_++;
+    while (i > 0 && slotAt(i - 1).item == slot.item && slotAt(i - 1).pts_us > slot.pts_us) {
+        slotAt(i) = slotAt(i - 1);
+        --i;
+    }
+    slotAt(i) = slot;
+
+    max_duration_us_ = std::max(max_duration_us_, slot.duration_us);
+    stats_.entries_added.fetch_add(1, std::memory_order_relaxed);
+    stats_.payload_bytes.fetch_add(entry.size, std::memory_order_relaxed);
+    return true;
+}
+
+size_t TimedMetadataTrack::visit(int64_t from_us, int64_t to_us, const Visitor& visitor) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t visited = 0;
+    // 持续型条目可能在from_us之前开始，向前多看max_duration_us_
+    for (size_t i = lowerBound(active_item_, from_us - max_duration_us_); i < count_; ++i) {
+        const Slot& slot = slotAt(i);
+        if (slot.item != active_item_ || slot.pts_us >= to_us) {
+            break;
+        }
+        if (slot.pts_us < from_us && slot.pts_us + slot.duration_us <= from_us) {
+            continue;
+        }
+        if (!payloadValid(slot)) {
+            continue;
+        }
+        visitor(view(slot));
+        ++visited;
+    }
+    return visited;
+}
+
+bool TimedMetadataTrack::latestTimecode(int64_t at_us, Timecode* timecode, int64_t* pts_us) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t i = lowerBound(active_item_, at_us);
+    while (i < count_ && slotAt(i).item == active_item_ && slotAt(i).pts_us <= at_us) {
+        ++i;
+    }
+    while (i > 0) {
+        const Slot& slot = slotAt(--i);
+        if (slot.item != active_item_) {
+            break;
+        }
+        if (slot.kind == TimedMetadata::Kind::Timecode) {
+            if (timecode) *timecode = slot.timecode;
+            if (pts_us) *pts_us = slot.pts_us;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t TimedMetadataTrack::beginItem() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ++write_item_;
+}
+
+void TimedMetadataTrack::activateItem(uint64_t item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_item_ = item;
+    // 按条目排序，更早条目的都在前面
+    while (count_ > 0 && slotAt(0).item < item) {
+        popFront();
+    }
+}
+
+void TimedMetadataTrack::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    head_ = 0;
+    count_ = 0;
+    max_duration_us_ = 0;
+    active_item_ = write_item_;
+}
+
+size_t TimedMetadataTrack::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+bool TimedMetadataTrack::payloadValid(const Slot& slot) const {
+    // 字节区每写满一圈覆盖一次，起始位置还没被追上就完整
+    return slot.payload_size == 0 || slot.payload_seq + arena_.size() >= arena_seq_;
+}
+
+void TimedMetadataTrack::popFront() {
+    head_ = (head_ + 1) % slots_.size();
+    --count_;
+    stats_.entries_evicted.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t TimedMetadataTrack::lowerBound(uint64_t item, int64_t pts_us) const {
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const Slot& slot = slotAt(mid);
+        if (slot.item < item || (slot.item == item && slot.pts_us < pts_us)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+TimedMetadata TimedMetadataTrack::view(const Slot& slot) const {
+    TimedMetadata entry;
+    entry.kind = slot.kind;
+    entry.stream_index = slot.stream_index;
+    entry.pts_us = slot.pts_us;
+    entry.duration_us = slot.duration_us;
+    entry.timecode = slot.timecode;
+    entry.size = slot.payload_size;
+    entry.data = slot.payload_size > 0
+        ? arena_.data() + static_cast<size_t>(slot.payload_seq % arena_.size())
+        : nullptr;
+    return entry;
+}
+
+} // namespace media
@@ -0,0 +1,201 @@
+#ifndef TIMED_METADATA_H
+#define TIMED_METADATA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace media {
+
+/**
+ * @brief SMPTE时间码（来自H.264 pic_timing或HEVC time_code SEI）
+ */
+struct Timecode {
+    int hours = 0;
+    int minutes = 0;
+    int seconds = 0;
+    int frames = 0;
+    bool drop_frame = false;            // cnt_dropped_flag
+
+    /**
+     * @brief HH:MM:SS:FF，丢帧时码最后一个分隔符为';'
+     */
+    std::string toString() const;
+};
+
+/**
+ * @brief 一条带时间戳的元数据
+ *
+ * data指向轨道内部存储，只在TimedMetadataTrack::visit的回调期间有效。
+ */
+struct TimedMetadata {
+    enum class Kind : uint8_t {
+        Timecode,           // 视频SEI时间码
+        SeiUserData,        // 视频SEI user_data_unregistered：16字节UUID + 数据
+        Klv,                // KLV数据流的一个完整三元组：16字节键 + BER长度 + 值
+        Subtitle,           // 字幕包（文本字幕为UTF-8文本，图形字幕为原始包）
+        Data                // 其他数据流的原始包
+    };
+
+    Kind kind = Kind::Data;
+    int stream_index = -1;
+    int64_t pts_us = 0;                 // 流时间戳换算成微秒（未减去起始时间，与帧pts同一基准）
+    int64_t duration_us = 0;            // 0表示瞬时
+    Timecode timecode;                  // 仅Kind::Timecode有效
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    std::string text() const { return std::string(reinterpret_cast<const char*>(data), size); }
+};
+
+/**
+ * @brief 按时间戳索引的元数据旁路通道
+ *
+ * 设计特点：
+ * 1. 紧凑存储：条目头在定长环形数组里，负载写进一块环形字节区，稳态下不分配内存
+ * 2. 按时间排序：SEI按解码顺序到达、时间戳是显示顺序，插入时向前移动到正确位置（B帧重排距离很小）
+ * 3. 自动淘汰：条目数或负载字节超过容量时丢弃最旧的；被覆盖的负载在查询时一并视为淘汰
+ * 4. 与帧对齐：visit按时间区间查询，持续型条目（字幕）只要与区间重叠就返回
+ * 5. 条目衔接：每条记录所属的播放条目，按(条目, 时间)排序；查询只看当前显示的条目，
+ *    下一条目的元数据可以提前写入，上一条目最后几帧显示时也还查得到
+ *
+ * 写入（解封装线程）和查询（显示/界面线程）之间用互斥锁保护，临界区只有拷贝和二分查找。
+ */
+class TimedMetadataTrack {
+public:
+    /**
+     * @brief 轨道容量
+     */
+    struct Config {
+        size_t max_entries;
+        size_t max_payload_bytes;           // 负载字节区大小，单条负载不超过其1/4
+
+        Config()
+            : max_entries(4096)
+            , max_payload_bytes(1 << 20)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t entries_added;
+        uint64_t entries_evicted;
+        uint64_t entries_rejected;      // 负载过大
+        uint64_t payload_bytes;         // 累计写入的负载字节
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> entries_added{0};
+        std::atomic<uint64_t> entries_evicted{0};
+        std::atomic<uint64_t> entries_rejected{0};
+        std::atomic<uint64_t> payload_bytes{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                entries_added.load(),
+                entries_evicted.load(),
+                entries_rejected.load(),
+                payload_bytes.load()
+            };
+        }
+    };
+
+    using Visitor = std::function<void(const TimedMetadata&)>;
+
+public:
+    explicit TimedMetadataTrack(const Config& config = Config{});
+
+    TimedMetadataTrack(const TimedMetadataTrack&) = delete;
+    TimedMetadataTrack& operator=(const TimedMetadataTrack&) = delete;
+
+    /**
+     * @brief 添加一条（负载被拷贝进轨道，entry.data/size指定来源）
+     * @return 负载过大时返回false
+     */
+    bool add(const TimedMetadata& entry);
+
+    /**
+     * @brief 按时间顺序访问与[from_us, to_us)重叠的条目
+     *
+     * 回调在锁内执行，回调里不能再访问本轨道。
+     * @return 访问的条数
+     */
+    size_t visit(int64_t from_us, int64_t to_us, const Visitor& visitor) const;
+
+    /**
+     * @brief 一帧的元数据：[frame_pts_us, frame_pts_us + frame_duration_us)，时长不足1微秒按1微秒
+     */
+    size_t visitFrame(int64_t frame_pts_us, int64_t frame_duration_us, const Visitor& visitor) const {
+        return visit(frame_pts_us, frame_pts_us + (frame_duration_us > 0 ? frame_duration_us : 1), visitor);
+    }
+
+    /**
+     * @brief at_us时刻及之前最近的时间码
+     * @return 没有时返回false
+     */
+    bool latestTimecode(int64_t at_us, Timecode* timecode, int64_t* pts_us = nullptr) const;
+
+    /**
+     * @brief 开始写入下一个播放条目（写入线程，解封装切换到新条目时调用）
+     * @return 新条目编号，显示切换到该条目时传给activateItem
+     */
+    uint64_t beginItem();
+
+    /**
+     * @brief 查询切换到指定条目（显示切换到新条目时调用），丢弃更早条目的元数据
+     */
+    void activateItem(uint64_t item);
+
+    /**
+     * @brief 清空（换源时调用）
+     */
+    void clear();
+
+    size_t size() const;
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+private:
+    struct Slot {
+        uint64_t item;                  // 所属播放条目
+        TimedMetadata::Kind kind;
+        int stream_index;
+        int64_t pts_us;
+        int64_t duration_us;
+        Timecode timecode;
+        uint64_t payload_seq;           // 负载在字节区中的单调位置
+        uint32_t payload_size;
+    };
+
+    const Slot& slotAt(size_t i) const { return slots_[(head_ + i) % slots_.size()]; }
+    Slot& slotAt(size_t i) { return slots_[(head_ + i) % slots_.size()]; }
+    bool payloadValid(const Slot& slot) const;
+    void popFront();
+    size_t lowerBound(uint64_t item, int64_t pts_us) const;
+    TimedMetadata view(const Slot& slot) const;
+
+private:
+    Config config_;
+    mutable std::mutex mutex_;
+    std::vector<Slot> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    std::vector<uint8_t> arena_;        // 首次写入时分配
+    uint64_t arena_seq_ = 0;            // 下一次写入的单调位置
+    int64_t max_duration_us_ = 0;       // 已有条目的最大时长（查询时向前多看这么多）
+    uint64_t write_item_ = 0;           // 新写入的条目
+    uint64_t active_item_ = 0;          // 查询的条目
+    Statistics stats_;
+};
+
+} // namespace media
+
+#endif // TIMED_METADATA_H
@@ -0,0 +1,236 @@
+#include "timed_metadata_extractor.h"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+constexpr size_t kKlvKeySize = 16;
+
+bool isKlvStream(const StreamInfo& info) {
+    return info.codec_id == AV_CODEC_ID_SMPTE_KLV ||
+           info.codec_tag == MKTAG('K', 'L', 'V', 'A');
+}
+
+} // namespace
+
+TimedMetadataExtractor::TimedMetadataExtractor(std::shared_ptr<TimedMetadataTrack> track,
+                                               const Config& config)
+    : track_(std::move(track))
+    , config_(config)
+    , scan_metric_(MetricsRegistry::instance().latency("stage.metadata")) {
+    if (!track_) {
+        track_ = std::make_shared<TimedMetadataTrack>();
+    }
+    sei_callback_ = [this](const SeiParser::Message& message) { onSeiMessage(message); };
+}
+
+int TimedMetadataExtractor::configure(const IDemuxer& demuxer, int video_index) {
+    clearStreams();
+    for (const StreamInfo& info : demuxer.getStreamInfos()) {
+        if (info.isVideo() && info.index != video_index) {
+            continue;
+        }
+        const AVCodecParameters* par = demuxer.getCodecParameters(info.index);
+        addStream(info,
+                  par ? par->extradata : nullptr,
+                  par && par->extradata_size > 0 ? static_cast<size_t>(par->extradata_size) : 0);
+    }
+    return static_cast<int>(streams_.size());
+}
+
+bool TimedMetadataExtractor::addStream(const StreamInfo& info, const uint8_t* extradata,
+                                       size_t extradata_size) {
+    Stream stream;
+    stream.index = info.index;
+    stream.codec_id = info.codec_id;
+    stream.time_base = info.time_base;
+
+    if (info.isVideo()) {
+        if (!config_.video_timecodes && !config_.video_user_data) {
+            return false;
+        }
+        if (info.codec_id != AV_CODEC_ID_H264 && info.codec_id != AV_CODEC_ID_HEVC) {
+            return false;
+        }
+        stream.kind = StreamKind::VideoSei;
+        stream.sei = std::make_unique<SeiParser>(
+            info.codec_id == AV_CODEC_ID_H264 ? SeiParser::Codec::H264 : SeiParser::Codec::Hevc, 0);
+        stream.sei->parseExtradata(extradata, extradata_size);
+    } else if (info.isSubtitle()) {
+        if (!config_.subtitles) {
+            return false;
+        }
+        stream.kind = StreamKind::Subtitle;
+    } else if (info.isData()) {
+        if (!config_.data_streams) {
+            return false;
+        }
+        stream.kind = isKlvStream(info) ? StreamKind::Klv : StreamKind::Data;
+    } else {
+        return false;
+    }
+
+    streams_.push_back(std::move(stream));
+    return true;
+}
+
+void TimedMetadataExtractor::clearStreams() {
+    streams_.clear();
+}
+
+bool TimedMetadataExtractor::processPacket(const AVPacket* packet) {
+    if (!packet || streams_.empty()) {
+        return false;
+    }
+
+    Stream* stream = nullptr;
+    for (Stream& candidate : streams_) {
+        if (candidate.index == packet->stream_index) {
+            stream = &candidate;
+            break;
+        }
+    }
+    if (!stream) {
+        return false;
+    }
+
+    const int64_t timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    if (timestamp == AV_NOPTS_VALUE || !packet->data || packet->size <= 0) {
+        stats_.untimed_packets.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    ScopedLatency timing(scan_metric_);
+    stats_.packets_scanned.fetch_add(1, std::memory_order_relaxed);
+
+    current_ = TimedMetadata{};
+    current_.stream_index = stream->index;
+    current_.pts_us = av_rescale_q(timestamp, stream->time_base, AV_TIME_BASE_Q);
+    current_.duration_us = packet->duration > 0
+        ? av_rescale_q(packet->duration, stream->time_base, AV_TIME_BASE_Q)
+        : 0;
+
+    switch (stream->kind) {
+    case StreamKind::VideoSei:
+        // 视频帧的时间码是瞬时的，不带包时长
+        current_.duration_us = 0;
+        if (stream->sei->parse(packet->data, static_cast<size_t>(packet->size), sei_callback_) < 0) {
+            stats_.parse_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+    case StreamKind::Subtitle:
+        addSubtitle(*stream, packet);
+        break;
+    case StreamKind::Klv:
+        addKlv(packet);
+        break;
+    case StreamKind::Data:
+        current_.kind = TimedMetadata::Kind::Data;
+        current_.data = packet->data;
+        current_.size = static_cast<size_t>(packet->size);
+        track_->add(current_);
+        stats_.data_packets.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    return true;
+}
+
+bool TimedMetadataExtractor::parseKlv(const uint8_t* data, size_t size, size_t* header_size,
+                                      size_t* value_size) {
+    if (!data || size < kKlvKeySize + 1) {
+        return false;
+    }
+
+    // BER长度：短格式一个字节；长格式首字节低7位是后续长度字节数
+    size_t pos = kKlvKeySize;
+    size_t length = data[pos++];
+    if (length & 0x80) {
+        const size_t bytes = length & 0x7F;
+        if (bytes == 0 || bytes > 8 || bytes > size - pos) {
+            return false;
+        }
+        length = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            length = (length << 8) | data[pos++];
+        }
+    }
+    if (length > size - pos) {
+        return false;
+    }
+
+    *header_size = pos;
+    *value_size = length;
+    return true;
+}
+
+void TimedMetadataExtractor::onSeiMessage(const SeiParser::Message& message) {
+    stats_.sei_messages.fetch_add(1, std::memory_order_relaxed);
+
+    if (message.has_timecode) {
+        if (!config_.video_timecodes) {
+            return;
+        }
+        TimedMetadata entry = current_;
+        entry.kind = TimedMetadata::Kind::Timecode;
+        entry.timecode = message.timecode;
+        track_->add(entry);
+        stats_.timecodes.fetch_add(1, std::memory_order_relaxed);
+    } else if (message.payload_type == SeiParser::kUserDataUnregistered && config_.video_user_data) {
+        TimedMetadata entry = current_;
+        entry.kind = TimedMetadata::Kind::SeiUserData;
+        entry.data = message.payload;
+        entry.size = message.size;
+        track_->add(entry);
+    }
+}
+
+void TimedMetadataExtractor::addSubtitle(const Stream& stream, const AVPacket* packet) {
+    current_.kind = TimedMetadata::Kind::Subtitle;
+    current_.data = packet->data;
+    current_.size = static_cast<size_t>(packet->size);
+
+    if (stream.codec_id == AV_CODEC_ID_MOV_TEXT) {
+        // tx3g：16位文本长度 + UTF-8文本 + 样式盒，只保留文本
+        if (packet->size < 2) {
+            stats_.parse_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const size_t length = (static_cast<size_t>(packet->data[0]) << 8) | packet->data[1];
+        if (length > static_cast<size_t>(packet->size) - 2) {
+            stats_.parse_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        current_.data = packet->data + 2;
+        current_.size = length;
+    }
+
+    track_->add(current_);
+    stats_.subtitles.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TimedMetadataExtractor::addKlv(const AVPacket* packet) {
+    // 一个包可能带多个三元组（本地集合之外还有其他键），每个单独成条
+    current_.kind = TimedMetadata::Kind::Klv;
+    const uint8_t* data = packet->data;
+    size_t remaining = static_cast<size_t>(packet->size);
+    while (remaining > 0) {
+        size_t header_size = 0;
+        size_t value_size = 0;
+        if (!parseKlv(data, remaining, &header_size, &value_size)) {
+            stats_.parse_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        current_.data = data;
+        current_.size = header_size + value_size;
+        track_->add(current_);
+        stats_.klv_items.fetch_add(1, std::memory_order_relaxed);
+        data += current_.size;
+        remaining -= current_.size;
+    }
+}
+
+} // namespace media
@@ -0,0 +1,170 @@
+#ifndef TIMED_METADATA_EXTRACTOR_H
+#define TIMED_METADATA_EXTRACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sei_parser.h"
+#include "timed_metadata.h"
+#include "../demux/demuxer.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace media {
+
+/**
+ * @brief 定时元数据提取（只解析，不解码）
+ *
+ * 设计特点：
+ * 1. 旁路：解封装线程在入队前调用processPacket，只读包内存，不拷贝、不改动、不持有引用，
+ *    视频包照常原样入队，解码路径看不到任何差别
+ * 2. 视频SEI：主视频流（H.264/HEVC）的时间码和user_data_unregistered，非SEI的NAL单元直接跳过
+ * 3. 字幕/数据流：不创建解码器，字幕包（mov_text去掉长度前缀）、KLV三元组和其他数据包按时间戳写入轨道
+ * 4. 不分配：每流的SEI解析器和回调在configure时建好，稳态下只有写入轨道的一次负载拷贝
+ *
+ * 只在解封装线程使用；轨道可在任意线程查询。
+ */
+class TimedMetadataExtractor {
+public:
+    /**
+     * @brief 提取哪些元数据
+     */
+    struct Config {
+        bool video_timecodes;       // 视频SEI时间码
+        bool video_user_data;       // 视频SEI user_data_unregistered
+        bool subtitles;             // 字幕流
+        bool data_streams;          // 数据流（KLV等）
+
+        Config()
+            : video_timecodes(true)
+            , video_user_data(true)
+            , subtitles(true)
+            , data_streams(true)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t packets_scanned;
+        uint64_t sei_messages;
+        uint64_t timecodes;
+        uint64_t klv_items;
+        uint64_t subtitles;
+        uint64_t data_packets;
+        uint64_t parse_errors;      // 包结构损坏或KLV长度越界
+        uint64_t untimed_packets;   // 没有时间戳而被忽略
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> packets_scanned{0};
+        std::atomic<uint64_t> sei_messages{0};
+        std::atomic<uint64_t> timecodes{0};
+        std::atomic<uint64_t> klv_items{0};
+        std::atomic<uint64_t> subtitles{0};
+        std::atomic<uint64_t> data_packets{0};
+        std::atomic<uint64_t> parse_errors{0};
+        std::atomic<uint64_t> untimed_packets{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                packets_scanned.load(),
+                sei_messages.load(),
+                timecodes.load(),
+                klv_items.load(),
+                subtitles.load(),
+                data_packets.load(),
+                parse_errors.load(),
+                untimed_packets.load()
+            };
+        }
+    };
+
+public:
+    explicit TimedMetadataExtractor(std::shared_ptr<TimedMetadataTrack> track,
+                                    const Config& config = Config{});
+
+    TimedMetadataExtractor(const TimedMetadataExtractor&) = delete;
+    TimedMetadataExtractor& operator=(const TimedMetadataExtractor&) = delete;
+
+    /**
+     * @brief 按解封装器的流列表选择要处理的流（打开和切换条目后调用）
+     * @param demuxer 解封装器
+     * @param video_index 扫描SEI的视频流，-1表示不扫描
+     * @return 处理的流数
+     */
+    int configure(const IDemuxer& demuxer, int video_index);
+
+    /**
+     * @brief 添加一个流（configure的底层实现，测试和自定义来源用）
+     * @param extradata 视频流的avcC/hvcC或Annex B参数集，可为空
+     * @return 流类型或编码不支持时返回false
+     */
+    bool addStream(const StreamInfo& info, const uint8_t* extradata, size_t extradata_size);
+
+    /**
+     * @brief 清除全部流
+     */
+    void clearStreams();
+
+    /**
+     * @brief 处理一个包（不处理的流立即返回false）
+     */
+    bool processPacket(const AVPacket* packet);
+
+    /**
+     * @brief 拆分一个KLV三元组
+     * @param header_size 输出键和BER长度的总字节数（值从这里开始）
+     * @param value_size 输出值的字节数
+     * @return 数据不足或长度编码非法时返回false
+     */
+    static bool parseKlv(const uint8_t* data, size_t size, size_t* header_size, size_t* value_size);
+
+    std::shared_ptr<TimedMetadataTrack> track() const { return track_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+private:
+    enum class StreamKind {
+        VideoSei,
+        Subtitle,
+        Klv,
+        Data
+    };
+
+    struct Stream {
+        int index;
+        StreamKind kind;
+        AVCodecID codec_id;
+        AVRational time_base;
+        std::unique_ptr<SeiParser> sei;
+    };
+
+    void onSeiMessage(const SeiParser::Message& message);
+    void addSubtitle(const Stream& stream, const AVPacket* packet);
+    void addKlv(const AVPacket* packet);
+
+private:
+    std::shared_ptr<TimedMetadataTrack> track_;
+    Config config_;
+    std::vector<Stream> streams_;
+
+    // 当前包的时间戳，SEI回调里使用（回调在构造时建好，避免每包构造std::function）
+    TimedMetadata current_;
+    SeiParser::Callback sei_callback_;
+
+    Statistics stats_;
+    Metric& scan_metric_;
+};
+
+} // namespace media
+
+#endif // TIMED_METADATA_EXTRACTOR_H
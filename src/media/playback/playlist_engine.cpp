@@ -0,0 +1,262 @@
+#include "playlist_engine.h"
+
+#include <chrono>
+
+namespace media {
+
+PlaylistEngine::PlaylistEngine(const Config& config)
+    : config_(config) {
+    pipeline_.setItemChangedCallback([this](uint64_t) { onItemChanged(); });
+    pipeline_.setEndCallback([this]() { post(Event::Ended); });
+}
+
+PlaylistEngine::~PlaylistEngine() {
+    stop();
+}
+
+void PlaylistEngine::setItems(std::vector<std::string> urls) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items_ = std::move(urls);
+}
+
+std::vector<std::string> PlaylistEngine::items() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_;
+}
+
+bool PlaylistEngine::play(size_t index) {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index >= items_.size()) {
+            last_error_ = "条目下标越界";
+            return false;
+        }
+    }
+
+    if (!openAt(index)) {
+        return false;
+    }
+    playing_.store(true);
+    control_thread_ = std::thread(&PlaylistEngine::controlLoop, this);
+    post(Event::Prepare);
+    return true;
+}
+
+void PlaylistEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        events_.clear();
+    }
+    cv_.notify_all();
+    if (control_thread_.joinable()) {
+        control_thread_.join();
+    }
+
+    // 解码线程在这里结束，之后不会再有回调
+    pipeline_.close();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+        events_.clear();
+    }
+    playing_.store(false);
+}
+
+size_t PlaylistEngine::currentIndex() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_index_;
+}
+
+void PlaylistEngine::setVideoFrameCallback(MediaPipeline::VideoFrameCallback callback) {
+    pipeline_.setVideoFrameCallback(std::move(callback));
+}
+
+void PlaylistEngine::setAudioFrameCallback(MediaPipeline::AudioFrameCallback callback) {
+    pipeline_.setAudioFrameCallback(std::move(callback));
+}
+
+void PlaylistEngine::setItemChangedCallback(ItemChangedCallback callback) {
+    item_callback_ = std::move(callback);
+}
+
+void PlaylistEngine::setFinishedCallback(FinishedCallback callback) {
+    finished_callback_ = std::move(callback);
+}
+
+std::string PlaylistEngine::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void PlaylistEngine::controlLoop() {
+    while (true) {
+        Event event;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !events_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            event = events_.front();
+            events_.pop_front();
+        }
+
+        if (event == Event::Prepare) {
+            prepareFollowing();
+        } else {
+            handleEnded();
+        }
+    }
+}
+
+void PlaylistEngine::post(Event event) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        events_.push_back(event);
+    }
+    cv_.notify_one();
+}
+
+void PlaylistEngine::prepareFollowing() {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t following = 0;
+        if (!followingIndex(current_index_, following)) {
+            return;
+        }
+        url = items_[following];
+        // 先记下：预备完成后切换可能在prepareNext返回之前就发生
+        prepared_index_ = following;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!pipeline_.prepareNext(url)) {
+        stats_.prepare_failures++;
+        setError(pipeline_.getLastError());
+        // 当前条目播完后正常结束，由handleEnded重新打开
+        pipeline_.setWaitForNext(false);
+        return;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_.prepared++;
+    double total = stats_.total_prepare_ms.load();
+    while (!stats_.total_prepare_ms.compare_exchange_weak(total, total + ms)) {
+    }
+    double max_ms = stats_.max_prepare_ms.load();
+    while (ms > max_ms && !stats_.max_prepare_ms.compare_exchange_weak(max_ms, ms)) {
+    }
+}
+
+void PlaylistEngine::handleEnded() {
+    size_t following = 0;
+    bool has_following = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        has_following = followingIndex(current_index_, following);
+    }
+
+    if (has_following && openAt(following)) {
+        stats_.reopen_switches++;
+        post(Event::Prepare);
+        return;
+    }
+
+    playing_.store(false);
+    if (finished_callback_) {
+        finished_callback_();
+    }
+}
+
+bool PlaylistEngine::openAt(size_t index) {
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = items_.size();
+    }
+
+    // 依次尝试，跳过打不开的条目
+    for (size_t attempt = 0; attempt < count; ++attempt) {
+        std::string url;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            url = items_[index];
+        }
+
+        if (pipeline_.open(url, config_.pipeline)) {
+            size_t following = 0;
+            bool has_following = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                current_index_ = index;
+                has_following = followingIndex(index, following);
+            }
+            // 还有后续条目时让管道在末尾等预备结果，避免预备稍慢时提前结束
+            pipeline_.setWaitForNext(has_following);
+            if (pipeline_.start()) {
+                if (item_callback_) {
+                    item_callback_(index);
+                }
+                return true;
+            }
+        }
+
+        setError(pipeline_.getLastError());
+        stats_.skipped_items++;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!followingIndex(index, index)) {
+            break;
+        }
+    }
+    pipeline_.close();
+    return false;
+}
+
+void PlaylistEngine::onItemChanged() {
+    // 管道解码线程：所有解码线程都已切换到预备好的条目
+    size_t index = 0;
+    bool has_following = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_index_ = prepared_index_;
+        index = current_index_;
+        size_t following = 0;
+        has_following = followingIndex(index, following);
+    }
+    stats_.gapless_switches++;
+    pipeline_.setWaitForNext(has_following);
+    post(Event::Prepare);
+
+    if (item_callback_) {
+        item_callback_(index);
+    }
+}
+
+bool PlaylistEngine::followingIndex(size_t index, size_t& following) const {
+    // 调用方持有mutex_
+    if (items_.empty()) {
+        return false;
+    }
+    if (index + 1 < items_.size()) {
+        following = index + 1;
+        return true;
+    }
+    if (config_.loop) {
+        following = 0;
+        return true;
+    }
+    return false;
+}
+
+void PlaylistEngine::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = error;
+}
+
+} // namespace media
@@ -0,0 +1,175 @@
+#ifndef PLAYLIST_ENGINE_H
+#define PLAYLIST_ENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../media_pipeline.h"
+
+namespace media {
+
+/**
+ * @brief 播放列表引擎：条目之间无缝衔接
+ *
+ * 设计特点：
+ * 1. 后台预备：当前条目一开始播放，控制线程就调用MediaPipeline::prepareNext预备下一条目
+ *    （打开输入、探测、建解码器并预解码开头几帧），与播放同时进行
+ * 2. 无缝切换：切换由管道在解码线程中完成，不停止、不重开音频输出；
+ *    音频样本连续写入，视频按同一时间偏移上屏
+ * 3. 回退：下一条目打不开或音视频流组成不同时，让当前条目正常结束，再重新open（有间隙），
+ *    打不开的条目被跳过
+ * 4. 统计：无缝切换/重开切换次数、预备失败数、预备耗时
+ *
+ * 回调都在内部线程中调用（无缝切换时为管道的解码线程），不能在回调里调用play/stop。
+ */
+class PlaylistEngine {
+public:
+    /**
+     * @brief 引擎配置
+     */
+    struct Config {
+        MediaPipeline::Config pipeline;     // 每个条目使用的管道配置
+        bool loop;                          // 播放到末尾后从第一个条目继续
+
+        Config()
+            : loop(false)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t gapless_switches;      // 无缝切换次数
+        uint64_t reopen_switches;       // 回退为重新打开的切换次数
+        uint64_t prepare_failures;      // 预备下一条目失败次数
+        uint64_t skipped_items;         // 打不开被跳过的条目数
+        double avg_prepare_ms;          // 平均预备耗时（成功的）
+        double max_prepare_ms;
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> gapless_switches{0};
+        std::atomic<uint64_t> reopen_switches{0};
+        std::atomic<uint64_t> prepare_failures{0};
+        std::atomic<uint64_t> skipped_items{0};
+        std::atomic<uint64_t> prepared{0};
+        std::atomic<double> total_prepare_ms{0.0};
+        std::atomic<double> max_prepare_ms{0.0};
+
+        StatisticsSnapshot getSnapshot() const {
+            const uint64_t count = prepared.load();
+            return StatisticsSnapshot{
+                gapless_switches.load(),
+                reopen_switches.load(),
+                prepare_failures.load(),
+                skipped_items.load(),
+                count > 0 ? total_prepare_ms.load() / count : 0.0,
+                max_prepare_ms.load()
+            };
+        }
+    };
+
+    // 开始播放某个条目时调用，参数为条目下标
+    using ItemChangedCallback = std::function<void(size_t)>;
+    // 播放列表全部播完时调用
+    using FinishedCallback = std::function<void()>;
+
+public:
+    explicit PlaylistEngine(const Config& config = Config{});
+    ~PlaylistEngine();
+
+    PlaylistEngine(const PlaylistEngine&) = delete;
+    PlaylistEngine& operator=(const PlaylistEngine&) = delete;
+
+    /**
+     * @brief 设置条目列表（停止状态下调用）
+     */
+    void setItems(std::vector<std::string> urls);
+    std::vector<std::string> items() const;
+
+    /**
+     * @brief 从指定条目开始播放（会先停止当前播放）
+     *
+     * 指定条目打不开时依次尝试后面的条目。
+     * @return 有条目开始播放返回true
+     */
+    bool play(size_t index = 0);
+
+    /**
+     * @brief 停止播放并等待后台预备结束
+     */
+    void stop();
+
+    bool isPlaying() const { return playing_.load(); }
+
+    /**
+     * @brief 正在播放的条目下标
+     */
+    size_t currentIndex() const;
+
+    // 以下回调需在play之前设置
+    void setVideoFrameCallback(MediaPipeline::VideoFrameCallback callback);
+    void setAudioFrameCallback(MediaPipeline::AudioFrameCallback callback);
+    void setItemChangedCallback(ItemChangedCallback callback);
+    void setFinishedCallback(FinishedCallback callback);
+
+    /**
+     * @brief 底层播放管道（变速、时钟、统计等）
+     */
+    MediaPipeline& pipeline() { return pipeline_; }
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+private:
+    enum class Event {
+        Prepare,    // 预备当前条目的下一条目
+        Ended       // 管道自然结束（没有无缝切换）
+    };
+
+    void controlLoop();
+    void post(Event event);
+    void prepareFollowing();
+    void handleEnded();
+    bool openAt(size_t index);
+    void onItemChanged();
+    bool followingIndex(size_t index, size_t& following) const;
+    void setError(const std::string& error);
+
+private:
+    Config config_;
+    MediaPipeline pipeline_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::string> items_;
+    std::deque<Event> events_;
+    size_t current_index_ = 0;
+    size_t prepared_index_ = 0;         // 交给管道预备的条目，无缝切换后成为当前条目
+    bool stopping_ = false;
+    std::string last_error_;
+
+    std::thread control_thread_;
+    std::atomic<bool> playing_{false};
+
+    ItemChangedCallback item_callback_;
+    FinishedCallback finished_callback_;
+
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // PLAYLIST_ENGINE_H
@@ -0,0 +1,596 @@
+#include "reverse_playback_engine.h"
+#include "../decoder/ffmpeg_decoder.h"
+#include "../demux/ffmpeg_demuxer.h"
+#include "../input/input_source.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+namespace {
+
+// 当前线程CPU时间（毫秒），平台不支持时退化为墙钟时间
+double threadCpuMs() {
+#if defined(__linux__) || defined(__APPLE__)
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    }
+#endif
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void addDouble(std::atomic<double>& target, double value) {
+    double current = target.load();
+    while (!target.compare_exchange_weak(current, current + value)) {
+    }
+}
+
+// 帧实际占用的缓冲区大小
+size_t frameBytes(const AVFrame* frame) {
+    size_t bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; ++i) {
+        bytes += frame->buf[i]->size;
+    }
+    return bytes;
+}
+
+// 数据包时间戳取pts/dts中较大者，容器索引无论记录dts还是pts都能比较
+int64_t packetTimestamp(const AVPacket* packet) {
+    if (packet->pts == AV_NOPTS_VALUE) {
+        return packet->dts;
+    }
+    if (packet->dts == AV_NOPTS_VALUE) {
+        return packet->pts;
+    }
+    return std::max(packet->pts, packet->dts);
+}
+
+} // namespace
+
+/**
+ * @brief 工作线程独占的解码链路
+ */
+struct ReversePlaybackEngine::WorkerContext {
+    std::shared_ptr<IInputSource> input;
+    FFmpegDemuxer demuxer;
+    std::unique_ptr<FFmpegVideoDecoder> decoder;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+
+    ~WorkerContext() {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+    }
+};
+
+ReversePlaybackEngine::ReversePlaybackEngine(const Config& config)
+    : config_(config) {
+}
+
+ReversePlaybackEngine::~ReversePlaybackEngine() {
+    close();
+}
+
+bool ReversePlaybackEngine::open(const std::string& url) {
+    close();
+
+    std::shared_ptr<IInputSource> input(InputSourceFactory::create(url));
+    if (!input || !input->open(url)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "无法打开输入 " + url + (input ? ": " + input->getLastError() : "");
+        return false;
+    }
+
+    // 第一个工作线程复用探测用的输入
+    std::unique_ptr<WorkerContext> first = createWorker(input);
+    if (!first) {
+        return false;
+    }
+
+    AVStream* stream = input->getFormatContext()->streams[video_stream_];
+    time_base_ = stream->time_base;
+    frame_rate_ = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+    start_pts_ = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    duration_us_ = std::max<int64_t>(0, first->demuxer.getDuration());
+
+    keyframes_ = first->demuxer.buildKeyframeIndex(video_stream_);
+    if (keyframes_.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "没有找到关键帧";
+        return false;
+    }
+
+    url_ = url;
+    stats_.gops_decoded.store(0);
+    stats_.frames_decoded.store(0);
+    stats_.cache_hits.store(0);
+    stats_.cache_misses.store(0);
+    stats_.evictions.store(0);
+    stats_.cache_bytes.store(0);
+    stats_.peak_cache_bytes.store(0);
+    stats_.stall_ms.store(0.0);
+    stats_.decode_wall_ms.store(0.0);
+    stats_.decode_cpu_ms.store(0.0);
+
+    workers_.push_back(std::move(first));
+    const int worker_count = std::max(1, config_.worker_count);
+    for (int i = 1; i < worker_count; ++i) {
+        std::unique_ptr<WorkerContext> worker = createWorker(nullptr);
+        if (!worker) {
+            break;  // 已有的工作线程足以继续
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    stopping_ = false;
+    for (auto& worker : workers_) {
+        threads_.emplace_back(&ReversePlaybackEngine::workerLoop, this, worker.get());
+    }
+    return true;
+}
+
+void ReversePlaybackEngine::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    job_cv_.notify_all();
+    done_cv_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.clear();
+    in_flight_.clear();
+    gops_.clear();
+    cache_bytes_ = 0;
+    stats_.cache_bytes.store(0);
+    current_.reset();
+    has_cursor_ = false;
+    cursor_gop_ = 0;
+    cursor_frame_ = 0;
+    direction_ = -1;
+    waiting_gop_ = SIZE_MAX;
+    keyframes_.clear();
+    video_stream_ = -1;
+}
+
+std::unique_ptr<ReversePlaybackEngine::WorkerContext>
+ReversePlaybackEngine::createWorker(std::shared_ptr<IInputSource> input) {
+    auto fail = [this](const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = message;
+        return nullptr;
+    };
+
+    if (!input) {
+        input = InputSourceFactory::create(url_);
+        if (!input || !input->open(url_)) {
+            return fail("无法打开输入 " + url_);
+        }
+    }
+
+    auto worker = std::make_unique<WorkerContext>();
+    worker->input = input;
+    if (!worker->demuxer.initialize(input)) {
+        return fail(worker->demuxer.getLastError());
+    }
+
+    const int video_stream = worker->demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+    const AVCodecParameters* codecpar = worker->demuxer.getCodecParameters(video_stream);
+    if (!codecpar) {
+        return fail("没有可用的视频流");
+    }
+    video_stream_ = video_stream;
+
+    FFmpegVideoDecoder::Config decoder_config;
+    decoder_config.thread_count = config_.decoder_threads;
+    worker->decoder = std::make_unique<FFmpegVideoDecoder>(decoder_config);
+    if (!worker->decoder->initialize(codecpar)) {
+        return fail(worker->decoder->getLastError());
+    }
+
+    worker->packet = av_packet_alloc();
+    worker->frame = av_frame_alloc();
+    if (!worker->packet || !worker->frame) {
+        return fail("内存分配失败");
+    }
+    return worker;
+}
+
+bool ReversePlaybackEngine::seek(int64_t timestamp_us) {
+    if (keyframes_.empty()) {
+        return false;
+    }
+
+    const int64_t target = start_pts_ + av_rescale_q(timestamp_us, AV_TIME_BASE_Q, time_base_);
+    size_t gop_index = gopIndexFor(target);
+    std::shared_ptr<DecodedGop> gop = fetchGop(gop_index);
+
+    // GOP内pts不大于目标的最后一帧
+    auto find = [target](const std::shared_ptr<DecodedGop>& candidate) -> int {
+        int found = -1;
+        for (size_t i = 0; candidate && i < candidate->frames.size(); ++i) {
+            if (candidate->frames[i]->pts > target) {
+                break;
+            }
+            found = static_cast<int>(i);
+        }
+        return found;
+    };
+
+    int frame_index = find(gop);
+    if (frame_index < 0 && gop_index > 0) {
+        // 目标落在本GOP首帧之前（开放GOP的前导帧归属上一个GOP）
+        gop_index--;
+        gop = fetchGop(gop_index);
+        frame_index = gop ? static_cast<int>(gop->frames.size()) - 1 : -1;
+    }
+    if (frame_index < 0 && gop && !gop->frames.empty()) {
+        frame_index = 0;    // 目标早于第一帧
+    }
+    if (frame_index < 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = "GOP解码失败";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ = gop;
+    cursor_gop_ = gop_index;
+    cursor_frame_ = static_cast<size_t>(frame_index);
+    has_cursor_ = true;
+    schedulePrefetchLocked();
+    return true;
+}
+
+ffmpeg::AVFrameSharedPtr ReversePlaybackEngine::currentFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_cursor_ || !current_) {
+        return nullptr;
+    }
+    return current_->frames[cursor_frame_];
+}
+
+ffmpeg::AVFrameSharedPtr ReversePlaybackEngine::stepBackward() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_cursor_) {
+            return nullptr;
+        }
+        if (direction_ != -1) {
+            direction_ = -1;
+            schedulePrefetchLocked();
+        }
+        if (cursor_frame_ > 0) {
+            cursor_frame_--;
+            return current_->frames[cursor_frame_];
+        }
+        if (cursor_gop_ == 0) {
+            return nullptr;
+        }
+    }
+
+    if (!moveToGop(cursor_gop_ - 1, true)) {
+        return nullptr;
+    }
+    return currentFrame();
+}
+
+ffmpeg::AVFrameSharedPtr ReversePlaybackEngine::stepForward() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_cursor_) {
+            return nullptr;
+        }
+        if (direction_ != 1) {
+            direction_ = 1;
+            schedulePrefetchLocked();
+        }
+        if (cursor_frame_ + 1 < current_->frames.size()) {
+            cursor_frame_++;
+            return current_->frames[cursor_frame_];
+        }
+        if (cursor_gop_ + 1 >= keyframes_.size()) {
+            return nullptr;
+        }
+    }
+
+    if (!moveToGop(cursor_gop_ + 1, false)) {
+        return nullptr;
+    }
+    return currentFrame();
+}
+
+bool ReversePlaybackEngine::moveToGop(size_t gop_index, bool at_end) {
+    // at_end为true时向前（更早）跳过失败的GOP，否则向后
+    while (gop_index < keyframes_.size()) {
+        std::shared_ptr<DecodedGop> gop = fetchGop(gop_index);
+        if (!gop) {
+            return false;   // 正在关闭
+        }
+        if (!gop->frames.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_ = gop;
+            cursor_gop_ = gop_index;
+            cursor_frame_ = at_end ? gop->frames.size() - 1 : 0;
+            schedulePrefetchLocked();
+            return true;
+        }
+        if (at_end) {
+            if (gop_index == 0) {
+                break;
+            }
+            gop_index--;
+        } else {
+            gop_index++;
+        }
+    }
+    return false;
+}
+
+int64_t ReversePlaybackEngine::currentTimestampUs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_cursor_ || !current_) {
+        return -1;
+    }
+    return toMicroseconds(current_->frames[cursor_frame_]->pts);
+}
+
+int64_t ReversePlaybackEngine::toMicroseconds(int64_t pts) const {
+    return av_rescale_q(pts - start_pts_, time_base_, AV_TIME_BASE_Q);
+}
+
+std::string ReversePlaybackEngine::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+size_t ReversePlaybackEngine::gopIndexFor(int64_t pts) const {
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), pts);
+    return it == keyframes_.begin() ? 0 : static_cast<size_t>(it - keyframes_.begin()) - 1;
+}
+
+std::shared_ptr<ReversePlaybackEngine::DecodedGop> ReversePlaybackEngine::fetchGop(size_t gop_index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = gops_.find(gop_index);
+    if (it != gops_.end()) {
+        stats_.cache_hits.fetch_add(1);
+        return it->second;
+    }
+
+    // 未命中：插到队首，由空闲的工作线程立即解码
+    stats_.cache_misses.fetch_add(1);
+    auto start = std::chrono::steady_clock::now();
+    waiting_gop_ = gop_index;
+    if (!in_flight_.count(gop_index)) {
+        jobs_.erase(std::remove(jobs_.begin(), jobs_.end(), gop_index), jobs_.end());
+        jobs_.push_front(gop_index);
+        job_cv_.notify_one();
+    }
+
+    done_cv_.wait(lock, [this, gop_index]() {
+        return stopping_ || gops_.count(gop_index) > 0;
+    });
+    waiting_gop_ = SIZE_MAX;
+    addDouble(stats_.stall_ms, std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count());
+
+    it = gops_.find(gop_index);
+    return it != gops_.end() ? it->second : nullptr;
+}
+
+void ReversePlaybackEngine::schedulePrefetchLocked() {
+    // 丢弃已经不在窗口内的预取任务（例如seek到别处之后）
+    jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(), [this](size_t index) {
+        return !isProtectedLocked(index);
+    }), jobs_.end());
+
+    bool added = false;
+    for (int k = 1; k <= config_.prefetch_gops; ++k) {
+        const int64_t index = static_cast<int64_t>(cursor_gop_) + direction_ * k;
+        if (index < 0 || index >= static_cast<int64_t>(keyframes_.size())) {
+            break;
+        }
+        const size_t gop_index = static_cast<size_t>(index);
+        if (gops_.count(gop_index) || in_flight_.count(gop_index) ||
+            std::find(jobs_.begin(), jobs_.end(), gop_index) != jobs_.end()) {
+            continue;
+        }
+        jobs_.push_back(gop_index);
+        added = true;
+    }
+    if (added) {
+        job_cv_.notify_all();
+    }
+}
+
+bool ReversePlaybackEngine::isProtectedLocked(size_t gop_index) const {
+    if (gop_index == waiting_gop_) {
+        return true;
+    }
+    if (!has_cursor_) {
+        return false;
+    }
+    const int64_t distance = (static_cast<int64_t>(gop_index) - static_cast<int64_t>(cursor_gop_)) * direction_;
+    return distance >= 0 && distance <= config_.prefetch_gops;
+}
+
+void ReversePlaybackEngine::evictLocked() {
+    while (cache_bytes_ > config_.cache_byte_budget) {
+        // 淘汰离当前位置最远、且不在保护窗口内的GOP
+        auto victim = gops_.end();
+        size_t victim_distance = 0;
+        for (auto it = gops_.begin(); it != gops_.end(); ++it) {
+            if (it->second->bytes == 0 || isProtectedLocked(it->first)) {
+                continue;
+            }
+            const size_t distance = it->first > cursor_gop_ ? it->first - cursor_gop_ : cursor_gop_ - it->first;
+            if (victim == gops_.end() || distance > victim_distance) {
+                victim = it;
+                victim_distance = distance;
+            }
+        }
+        if (victim == gops_.end()) {
+            break;
+        }
+        cache_bytes_ -= victim->second->bytes;
+        gops_.erase(victim);
+        stats_.evictions.fetch_add(1);
+    }
+    stats_.cache_bytes.store(cache_bytes_);
+}
+
+void ReversePlaybackEngine::workerLoop(WorkerContext* context) {
+    while (true) {
+        size_t gop_index = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            gop_index = jobs_.front();
+            jobs_.pop_front();
+            if (gops_.count(gop_index) || in_flight_.count(gop_index)) {
+                continue;
+            }
+            in_flight_.insert(gop_index);
+        }
+
+        std::shared_ptr<DecodedGop> gop = decodeGop(context, gop_index);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_flight_.erase(gop_index);
+            if (stopping_) {
+                return;
+            }
+            gops_[gop_index] = gop;
+            cache_bytes_ += gop->bytes;
+            if (cache_bytes_ > stats_.peak_cache_bytes.load()) {
+                stats_.peak_cache_bytes.store(cache_bytes_);
+            }
+            evictLocked();
+        }
+        done_cv_.notify_all();
+    }
+}
+
+std::shared_ptr<ReversePlaybackEngine::DecodedGop>
+ReversePlaybackEngine::decodeGop(WorkerContext* context, size_t gop_index) {
+    auto gop = std::make_shared<DecodedGop>();
+    const auto wall_start = std::chrono::steady_clock::now();
+    const double cpu_start = threadCpuMs();
+
+    const int64_t seek_ts = keyframes_[gop_index];
+    const bool has_next = gop_index + 1 < keyframes_.size();
+    const int64_t next_ts = has_next ? keyframes_[gop_index + 1] : INT64_MAX;
+
+    FFmpegDemuxer& demuxer = context->demuxer;
+    FFmpegVideoDecoder& decoder = *context->decoder;
+    AVPacket* packet = context->packet;
+    AVFrame* frame = context->frame;
+
+    int64_t first_pts = AV_NOPTS_VALUE;     // 本GOP关键帧pts
+    int64_t next_key_pts = AV_NOPTS_VALUE;  // 下一个GOP关键帧pts
+    bool started = false;
+    bool done = false;
+
+    // 取出解码器输出；遇到下一个GOP关键帧的显示时间即结束
+    auto collect = [&]() {
+        while (decoder.receiveFrame(frame)) {
+            int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE
+                              ? frame->best_effort_timestamp : frame->pts;
+            if (next_key_pts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts >= next_key_pts) {
+                av_frame_unref(frame);
+                return true;
+            }
+            if (first_pts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts < first_pts) {
+                // 开放GOP的前导帧依赖上一个GOP，由上一个GOP负责输出
+                av_frame_unref(frame);
+                continue;
+            }
+            AVFrame* owned = av_frame_alloc();
+            if (!owned) {
+                av_frame_unref(frame);
+                continue;
+            }
+            av_frame_move_ref(owned, frame);
+            owned->pts = pts;
+            gop->bytes += frameBytes(owned);
+            gop->frames.push_back(ffmpeg::SharedPointerFactory::wrapFrame(owned));
+        }
+        return false;
+    };
+
+    decoder.flush();
+    if (demuxer.seek(video_stream_, seek_ts)) {
+        while (!done) {
+            if (stopping_.load()) {
+                break;
+            }
+            if (!demuxer.readPacket(packet)) {
+                // 最后一个GOP：排空解码器
+                decoder.sendPacket(nullptr);
+                collect();
+                break;
+            }
+            if (packet->stream_index != video_stream_) {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            const bool is_key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+            const int64_t ts = packetTimestamp(packet);
+            if (!started) {
+                // 从本GOP的关键帧开始送包
+                if (!is_key || ts == AV_NOPTS_VALUE || ts < seek_ts) {
+                    av_packet_unref(packet);
+                    continue;
+                }
+                started = true;
+                first_pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : ts;
+            } else if (is_key && has_next && next_key_pts == AV_NOPTS_VALUE && ts >= next_ts) {
+                // 读到下一个GOP后继续送包，直到本GOP尾部的重排序帧全部输出
+                next_key_pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : ts;
+            }
+
+            decoder.sendPacket(packet);
+            av_packet_unref(packet);
+            done = collect();
+        }
+    }
+
+    std::sort(gop->frames.begin(), gop->frames.end(),
+              [](const ffmpeg::AVFrameSharedPtr& a, const ffmpeg::AVFrameSharedPtr& b) {
+                  return a->pts < b->pts;
+              });
+    gop->failed = gop->frames.empty();
+
+    stats_.gops_decoded.fetch_add(1);
+    stats_.frames_decoded.fetch_add(gop->frames.size());
+    addDouble(stats_.decode_wall_ms, std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - wall_start).count());
+    addDouble(stats_.decode_cpu_ms, threadCpuMs() - cpu_start);
+    return gop;
+}
+
+} // namespace media
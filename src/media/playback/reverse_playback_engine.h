@@ -0,0 +1,253 @@
+#ifndef REVERSE_PLAYBACK_ENGINE_H
+#define REVERSE_PLAYBACK_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../memory/smart_pointers.h"
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+namespace media {
+
+class FFmpegDemuxer;
+class FFmpegVideoDecoder;
+class IInputSource;
+
+/**
+ * @brief 逐帧步进与倒放引擎
+ *
+ * 解码只能从关键帧向前进行，倒放时以GOP为单位反向推进：
+ * 1. 关键帧索引：打开时从容器索引（或扫描数据包）得到所有GOP的起点
+ * 2. 整GOP解码：每次解码一个完整GOP，帧按pts排序后缓存，倒序取用
+ * 3. 字节预算：已解码GOP按与当前位置的距离淘汰，总字节数不超过预算
+ * 4. 并行预取：显示当前GOP时，工作线程（各自独立的解封装器/解码器）提前解码前面的GOP
+ *
+ * 所有帧接口在调用线程返回引用计数帧，不拷贝像素；需要等待解码时才阻塞。
+ * seek/step等定位接口需在同一线程调用。预算是软上限：当前GOP和预取窗口内的GOP不会被淘汰。
+ */
+class ReversePlaybackEngine {
+public:
+    /**
+     * @brief 引擎配置
+     */
+    struct Config {
+        size_t cache_byte_budget;   // 已解码帧缓存预算（字节）
+        int worker_count;           // 解码工作线程数（每个线程独立打开输入）
+        int prefetch_gops;          // 沿播放方向预取的GOP数
+        int decoder_threads;        // 每个解码器的线程数，0表示自动
+
+        Config()
+            : cache_byte_budget(512ull * 1024 * 1024)
+            , worker_count(2)
+            , prefetch_gops(2)
+            , decoder_threads(1)    // 并行度来自GOP级工作线程，CPU统计也只在单线程解码时准确
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t gops_decoded;          // 解码的GOP数
+        uint64_t frames_decoded;        // 解码输出的帧数
+        uint64_t cache_hits;            // 需要的GOP已在缓存中
+        uint64_t cache_misses;          // 需要同步等待解码
+        uint64_t evictions;             // 被淘汰的GOP数
+        size_t cache_bytes;             // 当前缓存字节数
+        size_t peak_cache_bytes;        // 缓存峰值字节数
+        double stall_ms;                // 调用线程等待解码的总时长
+        double decode_wall_ms;          // 解码总墙钟时间
+        double decode_cpu_ms;           // 解码线程CPU时间
+
+        // 平均每个GOP的解码耗时
+        double getAvgGopDecodeMs() const {
+            return gops_decoded > 0 ? decode_wall_ms / gops_decoded : 0.0;
+        }
+
+        // 每帧CPU开销
+        double getCpuMsPerFrame() const {
+            return frames_decoded > 0 ? decode_cpu_ms / frames_decoded : 0.0;
+        }
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> gops_decoded{0};
+        std::atomic<uint64_t> frames_decoded{0};
+        std::atomic<uint64_t> cache_hits{0};
+        std::atomic<uint64_t> cache_misses{0};
+        std::atomic<uint64_t> evictions{0};
+        std::atomic<size_t> cache_bytes{0};
+        std::atomic<size_t> peak_cache_bytes{0};
+        std::atomic<double> stall_ms{0.0};
+        std::atomic<double> decode_wall_ms{0.0};
+        std::atomic<double> decode_cpu_ms{0.0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                gops_decoded.load(),
+                frames_decoded.load(),
+                cache_hits.load(),
+                cache_misses.load(),
+                evictions.load(),
+                cache_bytes.load(),
+                peak_cache_bytes.load(),
+                stall_ms.load(),
+                decode_wall_ms.load(),
+                decode_cpu_ms.load()
+            };
+        }
+    };
+
+public:
+    explicit ReversePlaybackEngine(const Config& config = Config{});
+    ~ReversePlaybackEngine();
+
+    ReversePlaybackEngine(const ReversePlaybackEngine&) = delete;
+    ReversePlaybackEngine& operator=(const ReversePlaybackEngine&) = delete;
+
+    /**
+     * @brief 打开文件并建立关键帧索引
+     */
+    bool open(const std::string& url);
+
+    /**
+     * @brief 停止工作线程并释放所有缓存帧
+     */
+    void close();
+
+    /**
+     * @brief 精确定位到时间点：当前帧为pts不大于目标的最后一帧
+     * @param timestamp_us 目标时间（微秒，相对流起点）
+     */
+    bool seek(int64_t timestamp_us);
+
+    /**
+     * @brief 当前帧
+     */
+    ffmpeg::AVFrameSharedPtr currentFrame();
+
+    /**
+     * @brief 后退一帧并返回它；已在第一帧时返回nullptr
+     */
+    ffmpeg::AVFrameSharedPtr stepBackward();
+
+    /**
+     * @brief 前进一帧并返回它；已在最后一帧时返回nullptr
+     */
+    ffmpeg::AVFrameSharedPtr stepForward();
+
+    /**
+     * @brief 当前帧时间（微秒，相对流起点），未定位时返回-1
+     */
+    int64_t currentTimestampUs() const;
+
+    /**
+     * @brief 帧时间戳换算为微秒（相对流起点）
+     */
+    int64_t toMicroseconds(int64_t pts) const;
+
+    size_t gopCount() const { return keyframes_.size(); }
+    int64_t durationUs() const { return duration_us_; }
+    AVRational frameRate() const { return frame_rate_; }
+
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+private:
+    /**
+     * @brief 解码完成的GOP
+     */
+    struct DecodedGop {
+        std::vector<ffmpeg::AVFrameSharedPtr> frames;   // 按pts升序
+        size_t bytes = 0;
+        bool failed = false;
+    };
+
+    /**
+     * @brief 工作线程上下文（独立输入/解封装/解码）
+     */
+    struct WorkerContext;
+
+    void workerLoop(WorkerContext* context);
+    std::shared_ptr<DecodedGop> decodeGop(WorkerContext* context, size_t gop_index);
+
+    /**
+     * @brief 获取GOP，不在缓存中时插队解码并等待
+     */
+    std::shared_ptr<DecodedGop> fetchGop(size_t gop_index);
+
+    /**
+     * @brief 沿播放方向安排预取（需持有mutex_）
+     */
+    void schedulePrefetchLocked();
+
+    /**
+     * @brief 超出预算时淘汰离当前位置最远的GOP（需持有mutex_）
+     */
+    void evictLocked();
+
+    bool isProtectedLocked(size_t gop_index) const;
+    /**
+     * @brief 取出GOP并把位置移到其首帧或末帧，解码失败的GOP沿移动方向跳过
+     */
+    bool moveToGop(size_t gop_index, bool at_end);
+
+    std::unique_ptr<WorkerContext> createWorker(std::shared_ptr<IInputSource> input);
+    size_t gopIndexFor(int64_t pts) const;
+
+private:
+    Config config_;
+
+    // 打开后只读
+    std::vector<int64_t> keyframes_;        // GOP起点（seek时间戳，流时间基）
+    int video_stream_ = -1;
+    AVRational time_base_{0, 1};
+    AVRational frame_rate_{0, 1};
+    int64_t start_pts_ = 0;
+    int64_t duration_us_ = 0;
+    std::string url_;
+
+    // 工作线程
+    std::vector<std::unique_ptr<WorkerContext>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stopping_{false};
+
+    // 以下受mutex_保护
+    mutable std::mutex mutex_;
+    std::condition_variable job_cv_;        // 有新任务
+    std::condition_variable done_cv_;       // 有GOP解码完成
+    std::deque<size_t> jobs_;
+    std::set<size_t> in_flight_;
+    std::map<size_t, std::shared_ptr<DecodedGop>> gops_;
+    size_t cache_bytes_ = 0;
+
+    // 播放位置
+    bool has_cursor_ = false;
+    std::shared_ptr<DecodedGop> current_;   // 当前GOP（淘汰不影响正在显示的帧）
+    size_t cursor_gop_ = 0;
+    size_t cursor_frame_ = 0;
+    int direction_ = -1;                    // -1倒放，+1正放
+    size_t waiting_gop_ = SIZE_MAX;         // 调用线程正在等待的GOP
+
+    std::string last_error_;
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // REVERSE_PLAYBACK_ENGINE_H
@@ -0,0 +1,448 @@
+#include "disk_writer.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace media {
+
+namespace {
+
+std::string systemError(const std::string& prefix, int errnum) {
+    return prefix + std::strerror(errnum);
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int syncData(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd);
+#else
+    return ::fsync(fd);
+#endif
+}
+
+// 已落盘的数据不会再读，丢掉页缓存给其他流和解码用
+void dropCache(int fd) {
+#if defined(__linux__)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief 文件在I/O线程侧的状态
+ *
+ * fd、direct和bytes_since_sync只由所属I/O线程访问；failed由提交方读取。
+ */
+struct DiskWriter::FileState {
+    int fd = -1;
+    bool direct = false;            // fd当前是否带O_DIRECT
+    FileOptions options;
+    size_t worker = 0;
+    uint64_t bytes_since_sync = 0;
+    std::atomic<bool> failed{false};
+};
+
+/**
+ * @brief 提交给I/O线程的一次写入或关闭请求
+ */
+struct DiskWriter::Block {
+    std::shared_ptr<FileState> file;
+    uint8_t* data = nullptr;        // 为空表示关闭请求
+    size_t size = 0;
+    int64_t offset = 0;
+    bool direct = false;            // 地址、长度、偏移都对齐，可以O_DIRECT写
+};
+
+struct DiskWriter::Worker {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Block> queue;
+    bool stopping = false;
+};
+
+DiskWriter& DiskWriter::instance() {
+    static DiskWriter writer;
+    return writer;
+}
+
+DiskWriter::DiskWriter(const Config& config)
+    : config_(config)
+    , write_metric_(MetricsRegistry::instance().latency("stage.disk_write"))
+    , pending_metric_(MetricsRegistry::instance().gauge("queue.disk_pending"))
+    , error_metric_(MetricsRegistry::instance().counter("drop.disk_write_error")) {
+    config_.block_bytes = alignUp(std::max<size_t>(config_.block_bytes, kAlignment), kAlignment);
+    config_.max_buffers = std::max<size_t>(config_.max_buffers, 2);
+
+    const int worker_count = std::max(1, config_.worker_count);
+    for (int i = 0; i < worker_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&DiskWriter::workerLoop, this, worker.get());
+    }
+}
+
+DiskWriter::~DiskWriter() {
+    // 已提交的块和关闭请求都处理完再退出
+    for (auto& worker : workers_) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stopping = true;
+        }
+        worker->cv.notify_all();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    for (uint8_t* buffer : free_buffers_) {
+        std::free(buffer);
+    }
+    free_buffers_.clear();
+}
+
+std::unique_ptr<DiskWriter::File> DiskWriter::open(const std::string& path, const FileOptions& options) {
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (config_.direct_io) {
+        // tmpfs等不支持O_DIRECT的文件系统返回EINVAL，退回普通写
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        direct = fd >= 0;
+    }
+#endif
+    if (fd < 0) {
+        fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        const int err = errno;
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        last_error_ = systemError("无法创建文件 " + path + ": ", err);
+        return nullptr;
+    }
+
+    auto state = std::make_shared<FileState>();
+    state->fd = fd;
+    state->direct = direct;
+    state->options = options;
+    state->worker = static_cast<size_t>(next_file_id_.fetch_add(1) % workers_.size());
+    stats_.files_opened++;
+
+    std::unique_ptr<File> file(new File(this, std::move(state), path));
+    file->direct_ = direct;
+    return file;
+}
+
+bool DiskWriter::waitIdle(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    return idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [this]() { return pending_blocks_.load() == 0; });
+}
+
+DiskWriter::StatisticsSnapshot DiskWriter::getStatistics() const {
+    size_t in_use = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        in_use = allocated_buffers_ - free_buffers_.size();
+    }
+    return StatisticsSnapshot{
+        stats_.files_opened.load(),
+        stats_.files_closed.load(),
+        stats_.bytes_written.load(),
+        stats_.write_calls.load(),
+        stats_.direct_writes.load(),
+        stats_.syncs.load(),
+        stats_.buffer_stalls.load(),
+        stats_.write_errors.load(),
+        in_use,
+        pending_blocks_.load()
+    };
+}
+
+std::string DiskWriter::getLastError() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+uint8_t* DiskWriter::acquireBuffer() {
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    bool stalled = false;
+    while (free_buffers_.empty()) {
+        // 没有在途的块时不会有缓冲归还（都在各文件手里填充），只能超出上限分配
+        if (allocated_buffers_ < config_.max_buffers || pending_blocks_.load() == 0) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, kAlignment, config_.block_bytes) == 0) {
+                allocated_buffers_++;
+                return static_cast<uint8_t*>(memory);
+            }
+        }
+        // 磁盘跟不上：等I/O线程归还缓冲
+        if (!stalled) {
+            stalled = true;
+            stats_.buffer_stalls++;
+        }
+        pool_cv_.wait_for(lock, std::chrono::milliseconds(20));
+    }
+    uint8_t* buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer;
+}
+
+void DiskWriter::releaseBuffer(uint8_t* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        free_buffers_.push_back(buffer);
+    }
+    pool_cv_.notify_one();
+}
+
+void DiskWriter::submit(Block block) {
+    Worker& worker = *workers_[block.file->worker];
+    pending_metric_.set(static_cast<double>(pending_blocks_.fetch_add(1) + 1));
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(std::move(block));
+    }
+    worker.cv.notify_one();
+}
+
+void DiskWriter::workerLoop(Worker* worker) {
+    while (true) {
+        Block block;
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->cv.wait(lock, [worker]() { return worker->stopping || !worker->queue.empty(); });
+            if (worker->queue.empty()) {
+                return;
+            }
+            block = std::move(worker->queue.front());
+            worker->queue.pop_front();
+        }
+
+        if (block.data) {
+            writeBlock(block);
+            releaseBuffer(block.data);
+        } else {
+            closeFile(*block.file);
+        }
+
+        const size_t pending = pending_blocks_.fetch_sub(1) - 1;
+        pending_metric_.set(static_cast<double>(pending));
+        if (pending == 0) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+void DiskWriter::writeBlock(Block& block) {
+    FileState& state = *block.file;
+    if (state.failed.load()) {
+        return;
+    }
+
+    ScopedLatency timing(write_metric_);
+#ifdef O_DIRECT
+    if (state.direct && !block.direct) {
+        // 出现不对齐的写入后这个文件不再用O_DIRECT
+        const int flags = ::fcntl(state.fd, F_GETFL);
+        if (flags >= 0 && ::fcntl(state.fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+            state.direct = false;
+        }
+    }
+#endif
+
+    size_t written = 0;
+    while (written < block.size) {
+        const ssize_t result = ::pwrite(state.fd, block.data + written, block.size - written,
+                                        block.offset + static_cast<int64_t>(written));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+#ifdef O_DIRECT
+        if (result < 0 && errno == EINVAL && state.direct) {
+            // 设备的对齐要求比预期的大，改为普通写重试
+            const int flags = ::fcntl(state.fd, F_GETFL);
+            if (flags >= 0 && ::fcntl(state.fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+                state.direct = false;
+                continue;
+            }
+        }
+#endif
+        if (result <= 0) {
+            const int err = result < 0 ? errno : EIO;
+            state.failed.store(true);
+            stats_.write_errors++;
+            error_metric_.add();
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            last_error_ = systemError("写入失败: ", err);
+            return;
+        }
+        written += static_cast<size_t>(result);
+        stats_.write_calls++;
+        if (state.direct) {
+            stats_.direct_writes++;
+        }
+    }
+    stats_.bytes_written += block.size;
+
+    state.bytes_since_sync += block.size;
+    if (state.options.sync == SyncPolicy::Interval && state.bytes_since_sync >= state.options.sync_interval_bytes) {
+        if (syncData(state.fd) == 0) {
+            stats_.syncs++;
+            dropCache(state.fd);
+        }
+        state.bytes_since_sync = 0;
+    }
+}
+
+void DiskWriter::closeFile(FileState& state) {
+    if (state.fd < 0) {
+        return;
+    }
+    if (state.options.sync != SyncPolicy::None && !state.failed.load() && state.bytes_since_sync > 0) {
+        if (syncData(state.fd) == 0) {
+            stats_.syncs++;
+            dropCache(state.fd);
+        }
+    }
+    ::close(state.fd);
+    state.fd = -1;
+    stats_.files_closed++;
+}
+
+DiskWriter::File::File(DiskWriter* writer, std::shared_ptr<FileState> state, std::string path)
+    : writer_(writer)
+    , state_(std::move(state))
+    , path_(std::move(path)) {
+}
+
+DiskWriter::File::~File() {
+    close();
+}
+
+bool DiskWriter::File::write(const uint8_t* data, size_t size) {
+    if (closed_ || state_->failed.load()) {
+        return false;
+    }
+
+    const size_t block_bytes = writer_->config_.block_bytes;
+    while (size > 0) {
+        // 只有接着当前块（或覆盖块内已有数据）的写入能并进去，否则先提交
+        if (buffer_ && (position_ < buffer_offset_ ||
+                        position_ > buffer_offset_ + static_cast<int64_t>(buffer_used_) ||
+                        position_ >= buffer_offset_ + static_cast<int64_t>(block_bytes))) {
+            flushBuffer();
+        }
+        if (!buffer_) {
+            buffer_ = writer_->acquireBuffer();
+            buffer_offset_ = position_;
+            buffer_used_ = 0;
+        }
+
+        const size_t at = static_cast<size_t>(position_ - buffer_offset_);
+        const size_t count = std::min(size, block_bytes - at);
+        COPY_MEMCPY("recording.buffer", buffer_ + at, data, count);
+        buffer_used_ = std::max(buffer_used_, at + count);
+        position_ += static_cast<int64_t>(count);
+        size_ = std::max(size_, position_);
+        data += count;
+        size -= count;
+
+        if (buffer_used_ == block_bytes) {
+            flushBuffer();
+        }
+    }
+    return true;
+}
+
+int64_t DiskWriter::File::seek(int64_t offset, int whence) {
+    if (closed_) {
+        return -1;
+    }
+    int64_t target = -1;
+    switch (whence) {
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = position_ + offset;
+        break;
+    case SEEK_END:
+        target = size_ + offset;
+        break;
+    default:
+        return -1;
+    }
+    if (target < 0) {
+        return -1;
+    }
+    // 写位置跳到文件末尾之后会留下空洞，这里不支持
+    if (target > size_) {
+        return -1;
+    }
+    position_ = target;
+    return position_;
+}
+
+bool DiskWriter::File::close() {
+    if (closed_) {
+        return !state_->failed.load();
+    }
+    flushBuffer();
+    closed_ = true;
+
+    Block block;
+    block.file = state_;
+    writer_->submit(std::move(block));
+    return !state_->failed.load();
+}
+
+bool DiskWriter::File::failed() const {
+    return state_->failed.load();
+}
+
+void DiskWriter::File::flushBuffer() {
+    if (!buffer_) {
+        return;
+    }
+    if (buffer_used_ == 0) {
+        writer_->releaseBuffer(buffer_);
+        buffer_ = nullptr;
+        return;
+    }
+
+    Block block;
+    block.file = state_;
+    block.data = buffer_;
+    block.size = buffer_used_;
+    block.offset = buffer_offset_;
+    block.direct = direct_ && buffer_used_ == writer_->config_.block_bytes &&
+                   buffer_offset_ % static_cast<int64_t>(kAlignment) == 0;
+    if (!block.direct) {
+        direct_ = false;
+    }
+    writer_->submit(std::move(block));
+    buffer_ = nullptr;
+    buffer_used_ = 0;
+}
+
+} // namespace media
@@ -0,0 +1,234 @@
+#ifndef DISK_WRITER_H
+#define DISK_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../utils/metrics_registry.h"
+
+namespace media {
+
+/**
+ * @brief 录制用的批量磁盘写入器
+ *
+ * 设计特点：
+ * 1. 大块对齐写：调用方的小块写入先拷进按页对齐的大缓冲（默认1MiB），写满才提交，
+ *    文件以O_DIRECT打开时整块绕过页缓存；出现回写（seek）或写尾部不足一块时该文件改为普通写
+ * 2. 不阻塞调用方：提交的块由共享的I/O线程pwrite，分段关闭（含fdatasync）也在I/O线程完成；
+ *    同一文件固定由一个I/O线程处理，写入顺序与提交顺序一致
+ * 3. 同步策略：不同步 / 关闭时fdatasync / 每写满一定字节fdatasync，同步后告知内核丢弃页缓存，
+ *    几百路同时录制时页缓存不会被录像挤满
+ * 4. 背压：缓冲总数有上限，磁盘跟不上时提交方等待空闲缓冲并计入stall
+ *
+ * 几百路录制共用一个实例（instance()），I/O线程数按磁盘而不是按流配置。
+ */
+class DiskWriter {
+public:
+    /**
+     * @brief 同步策略
+     */
+    enum class SyncPolicy {
+        None,           // 不主动同步，交给内核回写
+        OnClose,        // 关闭文件前fdatasync
+        Interval        // 每写入sync_interval_bytes字节fdatasync一次，关闭前也同步
+    };
+
+    /**
+     * @brief 写入器配置
+     */
+    struct Config {
+        int worker_count;           // I/O线程数
+        size_t block_bytes;         // 每次提交的块大小（向上取整到对齐粒度）
+        size_t max_buffers;         // 缓冲总数上限（含正在写的）
+        bool direct_io;             // 尝试以O_DIRECT打开文件
+
+        Config()
+            : worker_count(2)
+            , block_bytes(1024 * 1024)
+            , max_buffers(512)
+            , direct_io(true)
+        {}
+    };
+
+    /**
+     * @brief 单个文件的选项
+     */
+    struct FileOptions {
+        SyncPolicy sync;
+        size_t sync_interval_bytes;
+
+        FileOptions()
+            : sync(SyncPolicy::OnClose)
+            , sync_interval_bytes(64 * 1024 * 1024)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t files_opened;
+        uint64_t files_closed;
+        uint64_t bytes_written;     // 实际写到磁盘的字节数
+        uint64_t write_calls;       // pwrite次数
+        uint64_t direct_writes;     // 以O_DIRECT完成的写入次数
+        uint64_t syncs;             // fdatasync次数
+        uint64_t buffer_stalls;     // 提交方等待空闲缓冲的次数
+        uint64_t write_errors;
+        size_t buffers_in_use;
+        size_t pending_blocks;      // 已提交未写完的块
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> files_opened{0};
+        std::atomic<uint64_t> files_closed{0};
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<uint64_t> write_calls{0};
+        std::atomic<uint64_t> direct_writes{0};
+        std::atomic<uint64_t> syncs{0};
+        std::atomic<uint64_t> buffer_stalls{0};
+        std::atomic<uint64_t> write_errors{0};
+    };
+
+    class File;
+
+    static constexpr size_t kAlignment = 4096;
+
+public:
+    /**
+     * @brief 进程内共享的写入器
+     */
+    static DiskWriter& instance();
+
+    explicit DiskWriter(const Config& config = Config{});
+    ~DiskWriter();
+
+    DiskWriter(const DiskWriter&) = delete;
+    DiskWriter& operator=(const DiskWriter&) = delete;
+
+    /**
+     * @brief 创建（截断）文件
+     * @return 失败返回nullptr，原因见getLastError
+     */
+    std::unique_ptr<File> open(const std::string& path, const FileOptions& options = FileOptions{});
+
+    /**
+     * @brief 等待所有已提交的块写完、已关闭的文件真正关闭
+     * @return 超时返回false
+     */
+    bool waitIdle(int timeout_ms);
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const;
+    std::string getLastError() const;
+
+private:
+    struct FileState;
+    struct Block;
+    struct Worker;
+
+    uint8_t* acquireBuffer();
+    void releaseBuffer(uint8_t* buffer);
+    void submit(Block block);
+    void workerLoop(Worker* worker);
+    void writeBlock(Block& block);
+    void closeFile(FileState& state);
+
+private:
+    Config config_;
+
+    // 空闲缓冲池
+    mutable std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::vector<uint8_t*> free_buffers_;
+    size_t allocated_buffers_ = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint64_t> next_file_id_{0};
+    std::atomic<size_t> pending_blocks_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    mutable std::mutex error_mutex_;
+    std::string last_error_;
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& write_metric_;
+    Metric& pending_metric_;
+    Metric& error_metric_;
+};
+
+/**
+ * @brief 写入器中的一个文件（只在一个线程中使用）
+ *
+ * write/seek只做内存拷贝和提交；close提交剩余数据和关闭请求后立即返回，
+ * 真正的写入、同步和关闭由I/O线程完成。
+ */
+class DiskWriter::File {
+public:
+    ~File();
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    /**
+     * @brief 追加写入（在当前位置）
+     * @return 之前的写入已经失败时返回false
+     */
+    bool write(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 移动写位置（SEEK_SET/SEEK_CUR/SEEK_END）
+     * @return 新位置，失败返回-1
+     */
+    int64_t seek(int64_t offset, int whence);
+
+    /**
+     * @brief 提交剩余数据并异步关闭，之后不能再写
+     * @return 到目前为止是否没有出错
+     */
+    bool close();
+
+    int64_t position() const { return position_; }
+    int64_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief I/O线程是否报告过写入错误
+     */
+    bool failed() const;
+
+private:
+    friend class DiskWriter;
+    File(DiskWriter* writer, std::shared_ptr<FileState> state, std::string path);
+
+    void flushBuffer();
+
+private:
+    DiskWriter* writer_;
+    std::shared_ptr<FileState> state_;
+    std::string path_;
+
+    uint8_t* buffer_ = nullptr;     // 当前填充中的块
+    size_t buffer_used_ = 0;
+    int64_t buffer_offset_ = 0;     // 块在文件中的起始位置
+    int64_t position_ = 0;
+    int64_t size_ = 0;
+    bool direct_ = false;           // 后续块是否还能以O_DIRECT写
+    bool closed_ = false;
+};
+
+} // namespace media
+
+#endif // DISK_WRITER_H
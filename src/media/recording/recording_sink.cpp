@@ -0,0 +1,501 @@
+#include "recording_sink.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+namespace media {
+
+namespace {
+
+// 复用器与DiskWriter之间的AVIO缓冲，攒成大块的工作由DiskWriter完成
+constexpr int kAvioBufferSize = 64 * 1024;
+
+std::string ffmpegError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return prefix + error_buf;
+}
+
+const char* formatName(RecordingContainer container) {
+    return container == RecordingContainer::MPEGTS ? "mpegts" : "mp4";
+}
+
+const char* extension(RecordingContainer container) {
+    return container == RecordingContainer::MPEGTS ? "ts" : "mp4";
+}
+
+} // namespace
+
+RecordingSink::RecordingSink(const Config& config)
+    : config_(config)
+    , writer_(config.writer ? config.writer : &DiskWriter::instance())
+    , mux_packet_(av_packet_alloc()) {
+    if (config_.mode == RecordingMode::Triggered) {
+        // 槽位一次分配好，之后只做引用/解引用
+        ring_.resize(std::max<size_t>(config_.pre_event_max_packets, 16));
+        for (auto& entry : ring_) {
+            entry.packet = av_packet_alloc();
+        }
+    } else {
+        recording_.store(true);
+    }
+}
+
+RecordingSink::~RecordingSink() {
+    close();
+    for (auto& entry : ring_) {
+        av_packet_free(&entry.packet);
+    }
+    for (auto& stream : streams_) {
+        avcodec_parameters_free(&stream.codecpar);
+    }
+    av_packet_free(&mux_packet_);
+}
+
+bool RecordingSink::initialize(const IDemuxer& demuxer) {
+    bool has_video = false;
+    bool has_audio = false;
+    for (const auto& info : demuxer.getStreamInfos()) {
+        if ((info.isVideo() && has_video) || (info.isAudio() && has_audio) ||
+            (!info.isVideo() && !info.isAudio())) {
+            continue;
+        }
+        if (!addStream(info.index, demuxer.getCodecParameters(info.index), info.time_base)) {
+            return false;
+        }
+        has_video = has_video || info.isVideo();
+        has_audio = has_audio || info.isAudio();
+    }
+    if (streams_.empty()) {
+        last_error_ = "没有可录制的音视频流";
+        return false;
+    }
+    return true;
+}
+
+bool RecordingSink::addStream(int input_index, const AVCodecParameters* codecpar, AVRational time_base) {
+    if (input_index < 0 || !codecpar || time_base.num <= 0 || time_base.den <= 0) {
+        last_error_ = "无效的输出流参数";
+        return false;
+    }
+    if (input_index < static_cast<int>(slot_of_input_.size()) && slot_of_input_[input_index] >= 0) {
+        last_error_ = "输入流已添加";
+        return false;
+    }
+
+    OutputStream stream;
+    stream.input_index = input_index;
+    stream.codecpar = avcodec_parameters_alloc();
+    if (!stream.codecpar || avcodec_parameters_copy(stream.codecpar, codecpar) < 0) {
+        avcodec_parameters_free(&stream.codecpar);
+        last_error_ = "复制编码参数失败";
+        return false;
+    }
+    stream.time_base = time_base;
+    stream.video = codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+
+    if (input_index >= static_cast<int>(slot_of_input_.size())) {
+        slot_of_input_.resize(input_index + 1, -1);
+    }
+    slot_of_input_[input_index] = static_cast<int>(streams_.size());
+    if (stream.video && video_slot_ < 0) {
+        video_slot_ = static_cast<int>(streams_.size());
+    }
+    streams_.push_back(stream);
+    return true;
+}
+
+bool RecordingSink::writePacket(const AVPacket* packet) {
+    if (!packet || packet->stream_index < 0 || packet->stream_index >= static_cast<int>(slot_of_input_.size())) {
+        return true;
+    }
+    const int slot = slot_of_input_[packet->stream_index];
+    if (slot < 0) {
+        return true;
+    }
+    stats_.packets_in++;
+
+    const OutputStream& stream = streams_[slot];
+    const int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (ts == AV_NOPTS_VALUE) {
+        stats_.packets_dropped++;
+        return true;
+    }
+    const int64_t ts_us = av_rescale_q(ts, stream.time_base, AV_TIME_BASE_Q);
+    const bool keyframe = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+
+    if (config_.mode == RecordingMode::Continuous) {
+        return writeRecorded(slot, packet, ts_us, keyframe);
+    }
+
+    const int64_t request = trigger_request_.exchange(-1);
+    if (request >= 0) {
+        startEvent(ts_us, request);
+    }
+
+    if (recording_.load() && ts_us >= record_until_us_) {
+        // 事件录完，回到只保留预录环
+        closeSegment();
+        recording_.store(false);
+    }
+    if (!recording_.load()) {
+        pushRing(slot, packet, ts_us, keyframe);
+        return true;
+    }
+    return writeRecorded(slot, packet, ts_us, keyframe);
+}
+
+void RecordingSink::trigger(int64_t post_event_us) {
+    if (config_.mode != RecordingMode::Triggered) {
+        return;
+    }
+    stats_.triggers++;
+    const int64_t value = post_event_us >= 0 ? post_event_us : config_.post_event_us;
+    // 多次触发取最长的录制时长，由writePacket在解封装线程处理
+    int64_t current = trigger_request_.load();
+    while (value > current && !trigger_request_.compare_exchange_weak(current, value)) {
+    }
+}
+
+void RecordingSink::close() {
+    closeSegment();
+    clearRing();
+    trigger_request_.store(-1);
+    if (config_.mode == RecordingMode::Triggered) {
+        recording_.store(false);
+    }
+}
+
+void RecordingSink::startEvent(int64_t now_us, int64_t post_event_us) {
+    record_until_us_ = std::max(recording_.load() ? record_until_us_ : 0, now_us + post_event_us);
+    if (recording_.load()) {
+        return;
+    }
+    recording_.store(true);
+
+    // 预录环整体写出，环的开头已经是关键帧
+    while (ring_count_ > 0) {
+        RingEntry& entry = ring_[ring_head_];
+        writeRecorded(entry.slot, entry.packet, entry.ts_us, entry.keyframe);
+        dropRingFront();
+    }
+}
+
+bool RecordingSink::writeRecorded(int slot, const AVPacket* packet, int64_t ts_us, bool keyframe) {
+    // 没有视频时每个包都可以作为分段起点
+    const bool boundary = video_slot_ < 0 || (slot == video_slot_ && keyframe);
+
+    if (format_ctx_ && boundary && shouldRotate(ts_us)) {
+        closeSegment();
+    }
+    if (!format_ctx_) {
+        if (!boundary) {
+            stats_.packets_dropped++;
+            return true;
+        }
+        if (!openSegment(ts_us)) {
+            stats_.packets_dropped++;
+            return false;
+        }
+    }
+    return muxPacket(slot, packet, ts_us);
+}
+
+bool RecordingSink::muxPacket(int slot, const AVPacket* packet, int64_t ts_us) {
+    OutputStream& stream = streams_[slot];
+    const int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+
+    // 分段起点之前的包（交织在关键帧前的音频）和不单调的包都会让复用器报错
+    if (ts_us < segment_start_us_ || (stream.last_dts != AV_NOPTS_VALUE && dts <= stream.last_dts)) {
+        stats_.packets_dropped++;
+        return true;
+    }
+    stream.last_dts = dts;
+
+    if (av_packet_ref(mux_packet_, packet) < 0) {
+        stats_.packets_dropped++;
+        return true;
+    }
+    // 时间戳平移到分段起点，再换算到输出流的时间基
+    const int64_t offset = av_rescale_q_rnd(segment_start_us_, AV_TIME_BASE_Q, stream.time_base, AV_ROUND_DOWN);
+    if (mux_packet_->pts != AV_NOPTS_VALUE) {
+        mux_packet_->pts = std::max<int64_t>(0, mux_packet_->pts - offset);
+    }
+    if (mux_packet_->dts != AV_NOPTS_VALUE) {
+        mux_packet_->dts -= offset;
+    }
+    av_packet_rescale_ts(mux_packet_, stream.time_base, format_ctx_->streams[slot]->time_base);
+    mux_packet_->stream_index = slot;
+    mux_packet_->pos = -1;
+
+    const int64_t end_us = ts_us + (packet->duration > 0 ? av_rescale_q(packet->duration, stream.time_base, AV_TIME_BASE_Q) : 0);
+    // av_interleaved_write_frame会接管并重置mux_packet_
+    const int ret = av_interleaved_write_frame(format_ctx_, mux_packet_);
+    av_packet_unref(mux_packet_);
+    if (ret < 0 || file_->failed()) {
+        stats_.mux_errors++;
+        last_error_ = ret < 0 ? ffmpegError("写入数据包失败: ", ret) : writer_->getLastError();
+        segment_failed_ = true;
+        closeSegment();
+        return false;
+    }
+
+    segment_end_us_ = std::max(segment_end_us_, end_us);
+    segment_packets_++;
+    stats_.packets_written++;
+    return true;
+}
+
+bool RecordingSink::shouldRotate(int64_t ts_us) const {
+    if (config_.segment_duration_us > 0 && ts_us - segment_start_us_ >= config_.segment_duration_us) {
+        return true;
+    }
+    return config_.segment_max_bytes > 0 && file_ && file_->size() >= config_.segment_max_bytes;
+}
+
+bool RecordingSink::openSegment(int64_t start_us) {
+    if (streams_.empty()) {
+        last_error_ = "录制输出未初始化";
+        return false;
+    }
+
+    const std::string path = nextSegmentPath();
+    file_ = writer_->open(path, config_.file_options);
+    if (!file_) {
+        last_error_ = writer_->getLastError();
+        return false;
+    }
+
+    int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, formatName(config_.container), path.c_str());
+    if (ret < 0 || !format_ctx_) {
+        last_error_ = ffmpegError("创建复用器失败: ", ret);
+        file_->close();
+        file_.reset();
+        return false;
+    }
+
+    // 复用器直接写进DiskWriter，普通MP4结束时要回写mdat大小，需要可seek
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+    AVIOContext* pb = buffer ? avio_alloc_context(buffer, kAvioBufferSize, 1, this, nullptr,
+                                                  &RecordingSink::writeCallback,
+                                                  &RecordingSink::seekCallback) : nullptr;
+    if (!pb) {
+        av_free(buffer);
+        avformat_free_context(format_ctx_);
+        format_ctx_ = nullptr;
+        file_->close();
+        file_.reset();
+        last_error_ = "分配AVIO上下文失败";
+        return false;
+    }
+    pb->seekable = config_.container == RecordingContainer::MP4 ? AVIO_SEEKABLE_NORMAL : 0;
+    format_ctx_->pb = pb;
+    format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    segment_path_ = path;
+    segment_start_us_ = start_us;
+    segment_end_us_ = start_us;
+    segment_packets_ = 0;
+    segment_failed_ = false;
+
+    bool ok = true;
+    for (auto& stream : streams_) {
+        AVStream* out = avformat_new_stream(format_ctx_, nullptr);
+        ok = out && avcodec_parameters_copy(out->codecpar, stream.codecpar) >= 0;
+        if (!ok) {
+            break;
+        }
+        out->codecpar->codec_tag = 0;
+        out->time_base = stream.time_base;
+        stream.last_dts = AV_NOPTS_VALUE;
+    }
+
+    AVDictionary* options = nullptr;
+    if (config_.container == RecordingContainer::FragmentedMP4) {
+        av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    }
+    ret = ok ? avformat_write_header(format_ctx_, &options) : AVERROR(ENOMEM);
+    av_dict_free(&options);
+    if (ret < 0) {
+        last_error_ = ffmpegError("写入文件头失败: ", ret);
+        stats_.mux_errors++;
+        segment_failed_ = true;
+        closeSegment();
+        return false;
+    }
+    return true;
+}
+
+void RecordingSink::closeSegment() {
+    if (!format_ctx_) {
+        return;
+    }
+
+    if (!segment_failed_) {
+        const int ret = av_write_trailer(format_ctx_);
+        if (ret < 0) {
+            last_error_ = ffmpegError("写入文件尾失败: ", ret);
+            stats_.mux_errors++;
+            segment_failed_ = true;
+        }
+    }
+    AVIOContext* pb = format_ctx_->pb;
+    if (pb) {
+        avio_flush(pb);
+        av_freep(&pb->buffer);
+        avio_context_free(&pb);
+    }
+    avformat_free_context(format_ctx_);
+    format_ctx_ = nullptr;
+
+    const int64_t bytes = file_->size();
+    // 关闭（含同步）在I/O线程完成，这里不等待
+    const bool written = file_->close();
+    file_.reset();
+
+    SegmentInfo info;
+    info.path = segment_path_;
+    info.start_us = segment_start_us_;
+    info.duration_us = segment_end_us_ - segment_start_us_;
+    info.bytes = bytes;
+    info.packets = segment_packets_;
+    info.ok = written && !segment_failed_;
+
+    stats_.segments_completed++;
+    stats_.bytes_written += static_cast<uint64_t>(bytes);
+    if (segment_callback_) {
+        segment_callback_(info);
+    }
+}
+
+std::string RecordingSink::nextSegmentPath() {
+    const std::time_t now = std::time(nullptr);
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &utc);
+
+    char seq[16];
+    std::snprintf(seq, sizeof(seq), "%05llu", static_cast<unsigned long long>(segment_seq_++));
+
+    std::string path = config_.directory;
+    if (!path.empty() && path.back() != '/') {
+        path += '/';
+    }
+    return path + config_.name_prefix + "_" + stamp + "_" + seq + "." + extension(config_.container);
+}
+
+void RecordingSink::pushRing(int slot, const AVPacket* packet, int64_t ts_us, bool keyframe) {
+    const bool video_key = slot == video_slot_ && keyframe;
+    if (ring_count_ == 0 && video_slot_ >= 0 && !video_key) {
+        // 环总是从关键帧开始，之前的包写出去也无法解码
+        return;
+    }
+
+    const size_t bytes = static_cast<size_t>(std::max(0, packet->size));
+    while (ring_count_ > 0 && (ring_count_ == ring_.size() || ring_bytes_ + bytes > config_.pre_event_max_bytes)) {
+        stats_.pre_event_overflows++;
+        dropRingFront();
+        evictRing(ts_us);
+    }
+    if (ring_count_ == 0 && video_slot_ >= 0 && !video_key) {
+        return;
+    }
+
+    RingEntry& entry = ring_[(ring_head_ + ring_count_) % ring_.size()];
+    if (av_packet_ref(entry.packet, packet) < 0) {
+        return;
+    }
+    entry.ts_us = ts_us;
+    entry.slot = slot;
+    entry.keyframe = video_key;
+    entry.bytes = bytes;
+    ring_count_++;
+    ring_bytes_ += bytes;
+    if (video_key) {
+        ring_keyframes_++;
+    }
+    evictRing(ts_us);
+}
+
+void RecordingSink::evictRing(int64_t newest_us) {
+    const int64_t cutoff = newest_us - config_.pre_event_us;
+    while (ring_count_ > 0) {
+        const RingEntry& front = ring_[ring_head_];
+        if (video_slot_ < 0) {
+            if (front.ts_us >= cutoff) {
+                break;
+            }
+            dropRingFront();
+            continue;
+        }
+        // 环头不是关键帧（前一个GOP被整体丢掉后的残余）
+        if (!front.keyframe) {
+            dropRingFront();
+            continue;
+        }
+        // 下一个关键帧也早于截止点时，整个开头的GOP都不再需要
+        if (ring_keyframes_ < 2) {
+            break;
+        }
+        size_t next = 1;
+        while (next < ring_count_ && !ring_[(ring_head_ + next) % ring_.size()].keyframe) {
+            next++;
+        }
+        if (next >= ring_count_ || ring_[(ring_head_ + next) % ring_.size()].ts_us > cutoff) {
+            break;
+        }
+        dropRingFront();
+    }
+}
+
+void RecordingSink::dropRingFront() {
+    RingEntry& entry = ring_[ring_head_];
+    av_packet_unref(entry.packet);
+    ring_bytes_ -= entry.bytes;
+    if (entry.keyframe) {
+        ring_keyframes_--;
+    }
+    entry.keyframe = false;
+    ring_head_ = (ring_head_ + 1) % ring_.size();
+    ring_count_--;
+}
+
+void RecordingSink::clearRing() {
+    while (ring_count_ > 0) {
+        dropRingFront();
+    }
+    ring_head_ = 0;
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int RecordingSink::writeCallback(void* opaque, const uint8_t* buf, int size)
+#else
+int RecordingSink::writeCallback(void* opaque, uint8_t* buf, int size)
+#endif
+{
+    auto* sink = static_cast<RecordingSink*>(opaque);
+    if (!sink->file_ || !sink->file_->write(buf, static_cast<size_t>(size))) {
+        return AVERROR(EIO);
+    }
+    return size;
+}
+
+int64_t RecordingSink::seekCallback(void* opaque, int64_t offset, int whence) {
+    auto* sink = static_cast<RecordingSink*>(opaque);
+    if (!sink->file_) {
+        return AVERROR(EIO);
+    }
+    if (whence & AVSEEK_SIZE) {
+        return sink->file_->size();
+    }
+    const int64_t position = sink->file_->seek(offset, whence & ~AVSEEK_FORCE);
+    return position >= 0 ? position : AVERROR(EINVAL);
+}
+
+} // namespace media
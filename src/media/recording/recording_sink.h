@@ -0,0 +1,257 @@
+#ifndef RECORDING_SINK_H
+#define RECORDING_SINK_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "disk_writer.h"
+#include "../demux/demuxer.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace media {
+
+/**
+ * @brief 录制文件的封装格式
+ */
+enum class RecordingContainer {
+    MP4,            // 普通MP4，分段结束时写moov（中途断电该分段不可播）
+    FragmentedMP4,  // 分片MP4，每个关键帧一个分片，断电最多丢最后一个分片
+    MPEGTS          // TS，逐包可恢复
+};
+
+/**
+ * @brief 录制模式
+ */
+enum class RecordingMode {
+    Continuous,     // 一直录制，按时长/大小切分段
+    Triggered       // 平时只保留预录环，trigger()后从事件前pre_event_us开始录
+};
+
+/**
+ * @brief 连续录制输出：不解码，直接把解封装出的数据包重新封装写盘
+ *
+ * 设计特点：
+ * 1. 只做封装：数据包引用计数转交给复用器，没有解码和像素拷贝，单核可承载几百路
+ * 2. 分段轮换：达到时长或大小后在下一个视频关键帧处切新文件，每个分段都从关键帧开始、时间戳从0开始
+ * 3. 预录环：触发模式下最近一段数据包保存在预分配的环形槽位中（av_packet_ref，不拷贝数据），
+ *    始终保留从事件前至少pre_event_us处的关键帧开始的数据，触发后整体写出
+ * 4. 写盘：复用器的AVIO写到DiskWriter，攒成对齐的大块由共享I/O线程写，同步策略按文件配置
+ *
+ * writePacket/close只能在一个线程（通常是解封装线程）调用；trigger可以在任意线程调用。
+ */
+class RecordingSink {
+public:
+    /**
+     * @brief 录制配置
+     */
+    struct Config {
+        std::string directory;              // 输出目录（需已存在）
+        std::string name_prefix;            // 文件名前缀（同一目录下每路流不同）：<前缀>_<UTC时间>_<序号>.<扩展名>
+        RecordingContainer container;
+        RecordingMode mode;
+        int64_t segment_duration_us;        // 分段时长，<=0不按时长切分
+        int64_t segment_max_bytes;          // 分段大小上限，<=0不按大小切分
+        int64_t pre_event_us;               // 触发模式：事件前保留的时长
+        int64_t post_event_us;              // 触发模式：事件后继续录制的时长
+        size_t pre_event_max_packets;       // 预录环槽位数
+        size_t pre_event_max_bytes;         // 预录环数据量上限
+        DiskWriter::FileOptions file_options;
+        DiskWriter* writer;                 // 为空时使用DiskWriter::instance()
+
+        Config()
+            : name_prefix("record")
+            , container(RecordingContainer::FragmentedMP4)
+            , mode(RecordingMode::Continuous)
+            , segment_duration_us(60 * 1000000LL)
+            , segment_max_bytes(0)
+            , pre_event_us(5 * 1000000LL)
+            , post_event_us(10 * 1000000LL)
+            , pre_event_max_packets(4096)
+            , pre_event_max_bytes(32 * 1024 * 1024)
+            , writer(nullptr)
+        {}
+    };
+
+    /**
+     * @brief 一个写完的分段
+     */
+    struct SegmentInfo {
+        std::string path;
+        int64_t start_us;           // 第一个数据包在源时间轴上的时间
+        int64_t duration_us;
+        int64_t bytes;
+        uint64_t packets;
+        bool ok;                    // 复用和写盘都没有出错
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t packets_in;
+        uint64_t packets_written;
+        uint64_t packets_dropped;       // 等关键帧、时间戳不单调或没有时间戳而丢弃
+        uint64_t segments_completed;
+        uint64_t bytes_written;         // 已完成分段的总大小
+        uint64_t triggers;
+        uint64_t pre_event_overflows;   // 预录环槽位或数据量不够而提前丢弃的包
+        uint64_t mux_errors;
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> packets_in{0};
+        std::atomic<uint64_t> packets_written{0};
+        std::atomic<uint64_t> packets_dropped{0};
+        std::atomic<uint64_t> segments_completed{0};
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<uint64_t> triggers{0};
+        std::atomic<uint64_t> pre_event_overflows{0};
+        std::atomic<uint64_t> mux_errors{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                packets_in.load(),
+                packets_written.load(),
+                packets_dropped.load(),
+                segments_completed.load(),
+                bytes_written.load(),
+                triggers.load(),
+                pre_event_overflows.load(),
+                mux_errors.load()
+            };
+        }
+    };
+
+    // 分段写完（已提交关闭）时调用，在writePacket/close的调用线程中
+    using SegmentCallback = std::function<void(const SegmentInfo&)>;
+
+public:
+    explicit RecordingSink(const Config& config = Config{});
+    ~RecordingSink();
+
+    RecordingSink(const RecordingSink&) = delete;
+    RecordingSink& operator=(const RecordingSink&) = delete;
+
+    /**
+     * @brief 按解封装器的音视频流建立输出流（各取第一个视频流和音频流）
+     */
+    bool initialize(const IDemuxer& demuxer);
+
+    /**
+     * @brief 添加一路输出流（initialize的底层接口，第一个数据包之前调用）
+     * @param input_index 输入数据包的stream_index
+     * @param time_base 输入数据包时间戳的时间基
+     */
+    bool addStream(int input_index, const AVCodecParameters* codecpar, AVRational time_base);
+
+    /**
+     * @brief 写入一个数据包（不修改、不接管packet）
+     * @return 复用或写盘出错时返回false，下一个关键帧处会开新分段重试
+     */
+    bool writePacket(const AVPacket* packet);
+
+    /**
+     * @brief 触发事件录制（触发模式），录到事件后post_event_us；录制中再次触发会延长
+     * @param post_event_us 小于0时使用配置值
+     */
+    void trigger(int64_t post_event_us = -1);
+
+    /**
+     * @brief 结束当前分段并释放预录环
+     */
+    void close();
+
+    bool isRecording() const { return recording_.load(); }
+
+    void setSegmentCallback(SegmentCallback callback) { segment_callback_ = std::move(callback); }
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const { return last_error_; }
+
+private:
+    struct OutputStream {
+        int input_index = -1;
+        AVCodecParameters* codecpar = nullptr;
+        AVRational time_base = {0, 1};
+        bool video = false;
+        int64_t last_dts = AV_NOPTS_VALUE;      // 当前分段内，输入时间基
+    };
+
+    struct RingEntry {
+        AVPacket* packet = nullptr;
+        int64_t ts_us = 0;
+        int slot = -1;
+        bool keyframe = false;
+        size_t bytes = 0;
+    };
+
+    bool writeRecorded(int slot, const AVPacket* packet, int64_t ts_us, bool keyframe);
+    bool muxPacket(int slot, const AVPacket* packet, int64_t ts_us);
+    bool openSegment(int64_t start_us);
+    void closeSegment();
+    bool shouldRotate(int64_t ts_us) const;
+    std::string nextSegmentPath();
+
+    void startEvent(int64_t now_us, int64_t post_event_us);
+    void pushRing(int slot, const AVPacket* packet, int64_t ts_us, bool keyframe);
+    void evictRing(int64_t newest_us);
+    void dropRingFront();
+    void clearRing();
+
+    static int writeCallback(void* opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                             const uint8_t* buf,
+#else
+                             uint8_t* buf,
+#endif
+                             int size);
+    static int64_t seekCallback(void* opaque, int64_t offset, int whence);
+
+private:
+    Config config_;
+    DiskWriter* writer_;
+    std::vector<OutputStream> streams_;
+    std::vector<int> slot_of_input_;            // 输入流索引 -> streams_下标
+    int video_slot_ = -1;
+    AVPacket* mux_packet_ = nullptr;
+
+    // 当前分段
+    AVFormatContext* format_ctx_ = nullptr;
+    std::unique_ptr<DiskWriter::File> file_;
+    std::string segment_path_;
+    int64_t segment_start_us_ = 0;
+    int64_t segment_end_us_ = 0;
+    uint64_t segment_packets_ = 0;
+    bool segment_failed_ = false;
+    uint64_t segment_seq_ = 0;
+
+    // 触发模式
+    std::atomic<bool> recording_{false};
+    std::atomic<int64_t> trigger_request_{-1};  // 待处理的post_event_us，-1表示没有
+    int64_t record_until_us_ = 0;
+    std::vector<RingEntry> ring_;
+    size_t ring_head_ = 0;
+    size_t ring_count_ = 0;
+    size_t ring_bytes_ = 0;
+    size_t ring_keyframes_ = 0;                 // 环中的视频关键帧数
+
+    std::string last_error_;
+    SegmentCallback segment_callback_;
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // RECORDING_SINK_H
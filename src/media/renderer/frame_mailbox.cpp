@@ -0,0 +1,58 @@
+#include "frame_mailbox.h"
+
+namespace media {
+
+FrameMailbox::FrameMailbox()
+    : state_(1) {  // 初始：back=0, middle=1, front=2
+}
+
+bool FrameMailbox::publish(ffmpeg::AVFrameSharedPtr frame, int64_t publish_time_us) {
+    Entry& slot = slots_[back_];
+    // 覆盖槽位中的旧帧（消费者已经不再引用它）
+    slot.frame = std::move(frame);
+    slot.sequence = next_sequence_++;
+    slot.publish_time_us = publish_time_us;
+    // 先于交换发布序号：消费者能看到的帧，其序号一定已经可以从lastSequence读到
+    last_sequence_.store(slot.sequence, std::memory_order_release);
+
+    // 把写好的槽换到中间位置并标记为新帧
+    uint32_t old_state = state_.exchange(static_cast<uint32_t>(back_) | kFreshBit,
+                                         std::memory_order_acq_rel);
+    back_ = static_cast<int>(old_state & kIndexMask);
+
+    published_.fetch_add(1, std::memory_order_relaxed);
+    last_publish_us_.store(publish_time_us, std::memory_order_relaxed);
+
+    // 换回来的槽仍带新帧标记，说明消费者没来得及取走
+    return (old_state & kFreshBit) != 0;
+}
+
+const FrameMailbox::Entry& FrameMailbox::acquire(bool* is_new) {
+    bool fresh = (state_.load(std::memory_order_acquire) & kFreshBit) != 0;
+    if (fresh) {
+        uint32_t old_state = state_.exchange(static_cast<uint32_t>(front_), std::memory_order_acq_rel);
+        front_ = static_cast<int>(old_state & kIndexMask);
+    }
+
+    if (is_new) {
+        *is_new = fresh;
+    }
+    return slots_[front_];
+}
+
+bool FrameMailbox::hasNewFrame() const {
+    return (state_.load(std::memory_order_acquire) & kFreshBit) != 0;
+}
+
+void FrameMailbox::reset() {
+    for (auto& slot : slots_) {
+        slot.frame.reset();
+        slot.sequence = 0;
+        slot.publish_time_us = 0;
+    }
+    state_.store(1, std::memory_order_release);
+    back_ = 0;
+    front_ = 2;
+}
+
+} // namespace media
@@ -0,0 +1,97 @@
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "../../memory/smart_pointers.h"
+
+namespace media {
+
+/**
+ * @brief 无锁三缓冲帧邮箱（最新帧优先）
+ *
+ * 设计特点：
+ * 1. 单生产者/单消费者：解码同步线程发布，场景图渲染线程取帧
+ * 2. 无锁：三个槽位通过一个原子状态字交换，双方都不会阻塞
+ * 3. 最新帧优先：消费者来不及取走的帧被新帧覆盖并计为丢帧
+ * 4. 零拷贝：槽位只保存引用计数帧指针
+ *
+ * 状态字布局：bit0-1 = 中间槽索引，bit2 = 中间槽含未读新帧
+ */
+class FrameMailbox {
+public:
+    /**
+     * @brief 邮箱中的一帧
+     */
+    struct Entry {
+        ffmpeg::AVFrameSharedPtr frame;     // 帧引用
+        uint64_t sequence = 0;              // 发布序号（从1开始）
+        int64_t publish_time_us = 0;        // 发布时间（steady_clock，微秒）
+    };
+
+    FrameMailbox();
+
+    FrameMailbox(const FrameMailbox&) = delete;
+    FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+    /**
+     * @brief 发布新帧（仅生产者线程调用）
+     * @param frame 帧引用，nullptr表示清空画面
+     * @param publish_time_us 发布时间（微秒），用于帧节奏统计
+     * @return true表示覆盖了一个尚未被消费的帧（丢帧）
+     */
+    bool publish(ffmpeg::AVFrameSharedPtr frame, int64_t publish_time_us);
+
+    /**
+     * @brief 取最新帧（仅消费者线程调用）
+     * @param is_new 输出：返回的是否为上次调用之后发布的新帧
+     * @return 当前前台槽位；在下一次acquire之前保持有效
+     */
+    const Entry& acquire(bool* is_new = nullptr);
+
+    /**
+     * @brief 是否有尚未被消费的新帧（任意线程）
+     */
+    bool hasNewFrame() const;
+
+    /**
+     * @brief 已发布的帧总数（任意线程）
+     */
+    uint64_t publishedCount() const { return published_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 最后发布（或正在发布）的帧序号（任意线程）
+     *
+     * 在槽位换出之前写入：消费者acquire到的帧序号不会大于之后读到的值
+     */
+    uint64_t lastSequence() const { return last_sequence_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 最后一次发布的时间（任意线程）
+     */
+    int64_t lastPublishTime() const { return last_publish_us_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 释放所有帧引用（调用时双方都必须空闲）
+     */
+    void reset();
+
+private:
+    static constexpr uint32_t kIndexMask = 0x3;
+    static constexpr uint32_t kFreshBit = 0x4;
+
+    Entry slots_[3];
+    std::atomic<uint32_t> state_;       // 中间槽索引 + 新帧标记
+    int back_ = 0;                      // 生产者独占
+    int front_ = 2;                     // 消费者独占
+
+    uint64_t next_sequence_ = 1;        // 生产者独占
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> last_sequence_{0};
+    std::atomic<int64_t> last_publish_us_{0};
+};
+
+} // namespace media
+
+#endif // FRAME_MAILBOX_H
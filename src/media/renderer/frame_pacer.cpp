@@ -0,0 +1,104 @@
+#include "frame_pacer.h"
+#include <cmath>
+
+namespace media {
+
+FramePacer::FramePacer(const Config& config)
+    : config_(config) {
+    stats_.refresh_rate.store(config_.refresh_rate > 0.0 ? config_.refresh_rate : 60.0);
+    judder_errors_.reserve(config_.judder_window);
+}
+
+void FramePacer::setRefreshRate(double refresh_rate) {
+    if (refresh_rate > 1.0) {
+        stats_.refresh_rate.store(refresh_rate);
+    }
+}
+
+int64_t FramePacer::refreshIntervalUs() const {
+    return static_cast<int64_t>(1000000.0 / stats_.refresh_rate.load());
+}
+
+void FramePacer::onFrameSynced(bool is_new, int64_t publish_time_us) {
+    pending_synced_ = true;
+    pending_new_ = is_new;
+    pending_publish_us_ = publish_time_us;
+}
+
+void FramePacer::onVsync(int64_t timestamp_us) {
+    stats_.vsync_count.fetch_add(1, std::memory_order_relaxed);
+
+    // 错过的vsync：交换间隔明显超过一个刷新周期
+    const int64_t interval_us = refreshIntervalUs();
+    if (last_vsync_us_ > 0 && interval_us > 0) {
+        int64_t delta = timestamp_us - last_vsync_us_;
+        if (delta > static_cast<int64_t>(interval_us * config_.missed_vsync_factor)) {
+            int64_t periods = (delta + interval_us / 2) / interval_us;
+            stats_.missed_vsyncs.fetch_add(static_cast<uint64_t>(periods - 1), std::memory_order_relaxed);
+        }
+    }
+    last_vsync_us_ = timestamp_us;
+
+    if (!pending_synced_) {
+        return;
+    }
+    pending_synced_ = false;
+
+    if (!pending_new_) {
+        stats_.repeated_frames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    stats_.presented_frames.fetch_add(1, std::memory_order_relaxed);
+
+    // 抖动：上一帧实际显示时长 vs 生产者发布间隔
+    if (last_present_vsync_us_ > 0) {
+        double shown_ms = (timestamp_us - last_present_vsync_us_) / 1000.0;
+        double expected_ms = (pending_publish_us_ - last_present_publish_us_) / 1000.0;
+        updateJudder(shown_ms - expected_ms);
+    }
+    last_present_vsync_us_ = timestamp_us;
+    last_present_publish_us_ = pending_publish_us_;
+}
+
+void FramePacer::reset() {
+    stats_.vsync_count.store(0);
+    stats_.presented_frames.store(0);
+    stats_.repeated_frames.store(0);
+    stats_.dropped_frames.store(0);
+    stats_.missed_vsyncs.store(0);
+    stats_.judder_ms.store(0.0);
+
+    last_vsync_us_ = 0;
+    pending_synced_ = false;
+    pending_new_ = false;
+    last_present_vsync_us_ = 0;
+    last_present_publish_us_ = 0;
+    judder_errors_.clear();
+    judder_pos_ = 0;
+    judder_sum_sq_ = 0.0;
+}
+
+void FramePacer::updateJudder(double error_ms) {
+    if (config_.judder_window == 0) {
+        return;
+    }
+
+    // 滑动窗口均方根
+    double sq = error_ms * error_ms;
+    if (judder_errors_.size() < config_.judder_window) {
+        judder_errors_.push_back(sq);
+    } else {
+        judder_sum_sq_ -= judder_errors_[judder_pos_];
+        judder_errors_[judder_pos_] = sq;
+        judder_pos_ = (judder_pos_ + 1) % config_.judder_window;
+    }
+    judder_sum_sq_ += sq;
+    if (judder_sum_sq_ < 0.0) {
+        judder_sum_sq_ = 0.0;
+    }
+
+    stats_.judder_ms.store(std::sqrt(judder_sum_sq_ / judder_errors_.size()), std::memory_order_relaxed);
+}
+
+} // namespace media
@@ -0,0 +1,147 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace media {
+
+/**
+ * @brief 按显示刷新率统计帧节奏
+ *
+ * 渲染线程在每次同步阶段报告显示的帧（新帧/重复帧），在每次交换缓冲（vsync）后报告时间戳，
+ * 由此得到：
+ * 1. 错过的vsync：相邻两次交换间隔超过刷新周期的1.5倍
+ * 2. 重复帧：播放中某个vsync没有新帧可显示
+ * 3. 抖动（judder）：帧实际显示时长与发布节奏之差的均方根（毫秒）
+ * 4. 丢帧：生产者覆盖了尚未显示的帧
+ *
+ * onFrameSynced/onVsync 只在渲染线程调用；统计读取可在任意线程进行。
+ */
+class FramePacer {
+public:
+    /**
+     * @brief 节奏统计配置
+     */
+    struct Config {
+        double refresh_rate;            // 显示刷新率(Hz)
+        double missed_vsync_factor;     // 超过多少个刷新周期视为错过vsync
+        size_t judder_window;           // 抖动统计窗口（帧数）
+
+        Config()
+            : refresh_rate(60.0)
+            , missed_vsync_factor(1.5)
+            , judder_window(120)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t vsync_count;           // vsync（缓冲交换）次数
+        uint64_t presented_frames;      // 显示的新帧数
+        uint64_t repeated_frames;       // 重复显示的帧数
+        uint64_t dropped_frames;        // 未显示即被覆盖的帧数
+        uint64_t missed_vsyncs;         // 错过的vsync数
+        double judder_ms;               // 抖动（均方根，毫秒）
+        double refresh_rate;            // 当前刷新率(Hz)
+
+        // 计算显示帧率
+        double getPresentRatio() const {
+            return vsync_count > 0 ? static_cast<double>(presented_frames) / vsync_count : 0.0;
+        }
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> vsync_count{0};
+        std::atomic<uint64_t> presented_frames{0};
+        std::atomic<uint64_t> repeated_frames{0};
+        std::atomic<uint64_t> dropped_frames{0};
+        std::atomic<uint64_t> missed_vsyncs{0};
+        std::atomic<double> judder_ms{0.0};
+        std::atomic<double> refresh_rate{60.0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                vsync_count.load(),
+                presented_frames.load(),
+                repeated_frames.load(),
+                dropped_frames.load(),
+                missed_vsyncs.load(),
+                judder_ms.load(),
+                refresh_rate.load()
+            };
+        }
+    };
+
+public:
+    explicit FramePacer(const Config& config = Config{});
+
+    /**
+     * @brief 设置显示刷新率（来自QScreen::refreshRate）
+     */
+    void setRefreshRate(double refresh_rate);
+
+    /**
+     * @brief 刷新周期（微秒）
+     */
+    int64_t refreshIntervalUs() const;
+
+    /**
+     * @brief 同步阶段报告本次要显示的帧（渲染线程）
+     * @param is_new 是否为新帧
+     * @param publish_time_us 该帧的发布时间
+     */
+    void onFrameSynced(bool is_new, int64_t publish_time_us);
+
+    /**
+     * @brief 交换缓冲后报告vsync时间（渲染线程）
+     * @param timestamp_us 交换完成时间（steady_clock，微秒）
+     */
+    void onVsync(int64_t timestamp_us);
+
+    /**
+     * @brief 生产者报告丢帧（任意线程）
+     */
+    void recordDroppedFrame() { stats_.dropped_frames.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief 获取统计快照
+     */
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+    /**
+     * @brief 重置统计（渲染线程空闲时调用）
+     */
+    void reset();
+
+private:
+    void updateJudder(double error_ms);
+
+private:
+    Config config_;
+    mutable Statistics stats_;
+
+    // 以下仅渲染线程访问
+    int64_t last_vsync_us_ = 0;
+    bool pending_synced_ = false;
+    bool pending_new_ = false;
+    int64_t pending_publish_us_ = 0;
+
+    int64_t last_present_vsync_us_ = 0;
+    int64_t last_present_publish_us_ = 0;
+
+    std::vector<double> judder_errors_;
+    size_t judder_pos_ = 0;
+    double judder_sum_sq_ = 0.0;
+};
+
+} // namespace media
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,420 @@
+#include "video_item.h"
+#include "yuv_video_node.h"
+
+#include <QQuickWindow>
+#include <QScreen>
+#include <QSGImageNode>
+#include <QSGRendererInterface>
+#include <QImage>
+#include <QUrl>
+#include <algorithm>
+#include <chrono>
+
+namespace media {
+
+namespace {
+
+/**
+ * @brief 暂存帧持有者
+ * 成员按声明逆序析构：先归还帧，再释放分配器
+ */
+struct StagingFrame {
+    std::shared_ptr<FFmpegFrameAllocator> allocator;
+    ffmpeg::AVFrameSharedPtr frame;
+};
+
+void releaseImageFrame(void* info) {
+    delete static_cast<ffmpeg::AVFrameSharedPtr*>(info);
+}
+
+int64_t steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 超过该时长未收到新帧视为暂停，停止按vsync重绘
+constexpr int64_t kProducerIdleUs = 250000;
+
+} // namespace
+
+VideoItem::VideoItem(QQuickItem* parent)
+    : QQuickItem(parent)
+    , converter_(std::make_unique<FFmpegVideoConverter>())
+    , render_metric_(MetricsRegistry::instance().latency("stage.render"))
+    , overwrite_metric_(MetricsRegistry::instance().counter("drop.render_overwrite"))
+    , snapshot_stream_id_(SnapshotService::allocateStreamId()) {
+    setFlag(ItemHasContents, true);
+
+    // 暂存池只需少量帧：当前显示 + 正在转换
+    auto config = std::make_unique<FFmpegAllocatorConfig>();
+    config->frames_per_pool = kStagingFrames;
+    config->max_pools = 4;
+    staging_allocator_ = std::make_shared<FFmpegFrameAllocator>(std::move(config));
+
+    // 探针持有weak_ptr：只在采样线程读取原子统计，不触碰渲染路径
+    std::weak_ptr<FFmpegFrameAllocator> allocator = staging_allocator_;
+    staging_probe_id_ = MetricsRegistry::instance().addProbe("pool.video_staging", [allocator]() {
+        auto locked = allocator.lock();
+        return locked ? locked->getStatistics().getHitRate() : 0.0;
+    });
+}
+
+VideoItem::~VideoItem() {
+    // 等待本项的截图回调结束，回调里引用了this
+    SnapshotService::instance().cancel(snapshot_stream_id_);
+    MetricsRegistry::instance().removeProbe(staging_probe_id_);
+}
+
+void VideoItem::presentFrame(ffmpeg::AVFrameSharedPtr frame) {
+    const bool size_changed = updateFrameSize(frame ? frame->width : 0, frame ? frame->height : 0);
+
+    // 只是多一个引用，截图时不需要打扰渲染线程
+    std::atomic_store(&snapshot_frame_, frame);
+
+    // 覆盖尚未显示的旧帧：最新帧优先
+    if (mailbox_.publish(std::move(frame), steadyNowUs())) {
+        pacer_.recordDroppedFrame();
+        overwrite_metric_.add();
+    }
+
+    if (size_changed) {
+        notifyFrameSizeChanged();
+    }
+    requestUpdate();
+}
+
+void VideoItem::clear() {
+    // 邮箱只允许流水线线程发布，这里不能发布空帧：记下已发布的序号，
+    // 由渲染线程丢弃此前发布的帧，之后发布的帧照常显示。
+    // 用lastSequence而不是publishedCount：后者在槽位换出之后才递增，会漏掉正在发布的帧
+    clear_sequence_.store(mailbox_.lastSequence());
+    std::atomic_store(&snapshot_frame_, ffmpeg::AVFrameSharedPtr());
+    if (updateFrameSize(0, 0)) {
+        notifyFrameSizeChanged();
+    }
+    requestUpdate();
+}
+
+bool VideoItem::updateFrameSize(int width, int height) {
+    bool size_changed = frame_width_.exchange(width) != width;
+    size_changed = (frame_height_.exchange(height) != height) || size_changed;
+    return size_changed;
+}
+
+void VideoItem::notifyFrameSizeChanged() {
+    QMetaObject::invokeMethod(this, [this]() {
+        emit frameSizeChanged();
+    }, Qt::QueuedConnection);
+}
+
+qulonglong VideoItem::saveSnapshot(const QString& path) {
+    SnapshotService::Request request;
+    request.frame = std::atomic_load(&snapshot_frame_);
+    if (!request.frame || path.isEmpty()) {
+        return 0;
+    }
+
+    // 支持file:// URL和本地路径
+    const QUrl url(path);
+    const QString local_path = url.isLocalFile() ? url.toLocalFile() : path;
+    request.path = local_path.toStdString();
+    request.format = SnapshotService::formatForPath(request.path);
+    request.stream_id = snapshot_stream_id_;
+    request.callback = [this](const SnapshotService::Result& result) {
+        const qulonglong id = result.id;
+        const QString saved_path = QString::fromStdString(result.path);
+        const bool success = result.success;
+        const QString error = QString::fromStdString(result.error);
+        QMetaObject::invokeMethod(this, [this, id, saved_path, success, error]() {
+            emit snapshotSaved(id, saved_path, success, error);
+        }, Qt::QueuedConnection);
+    };
+    return SnapshotService::instance().submit(std::move(request));
+}
+
+QSize VideoItem::frameSize() const {
+    const int width = frame_width_.load();
+    const int height = frame_height_.load();
+    return (width > 0 && height > 0) ? QSize(width, height) : QSize();
+}
+
+QVariantMap VideoItem::pacingStatistics() const {
+    const FramePacer::StatisticsSnapshot stats = pacer_.getStatistics();
+    QVariantMap map;
+    map.insert(QStringLiteral("vsyncCount"), static_cast<qulonglong>(stats.vsync_count));
+    map.insert(QStringLiteral("presentedFrames"), static_cast<qulonglong>(stats.presented_frames));
+    map.insert(QStringLiteral("repeatedFrames"), static_cast<qulonglong>(stats.repeated_frames));
+    map.insert(QStringLiteral("droppedFrames"), static_cast<qulonglong>(stats.dropped_frames));
+    map.insert(QStringLiteral("missedVsyncs"), static_cast<qulonglong>(stats.missed_vsyncs));
+    map.insert(QStringLiteral("judderMs"), stats.judder_ms);
+    map.insert(QStringLiteral("refreshRate"), stats.refresh_rate);
+    return map;
+}
+
+QVariantMap VideoItem::counterStatistics() const {
+    auto toMap = [](const PerfStage::StatisticsSnapshot& stats) {
+        QVariantMap map;
+        map.insert(QStringLiteral("samples"), static_cast<qulonglong>(stats.samples));
+        map.insert(QStringLiteral("cycles"), static_cast<qulonglong>(stats.cycles));
+        map.insert(QStringLiteral("instructions"), static_cast<qulonglong>(stats.instructions));
+        map.insert(QStringLiteral("llcMisses"), static_cast<qulonglong>(stats.llc_misses));
+        map.insert(QStringLiteral("branchMisses"), static_cast<qulonglong>(stats.branch_misses));
+        map.insert(QStringLiteral("ipc"), stats.instructionsPerCycle());
+        return map;
+    };
+    QVariantMap map;
+    map.insert(QStringLiteral("convert"), toMap(convert_counters_.getStatistics()));
+    map.insert(QStringLiteral("render"), toMap(render_counters_.getStatistics()));
+    return map;
+}
+
+void VideoItem::setKeepAspectRatio(bool keep) {
+    if (keep_aspect_ratio_ == keep) {
+        return;
+    }
+    keep_aspect_ratio_ = keep;
+    emit keepAspectRatioChanged();
+    update();
+}
+
+QSGNode* VideoItem::updatePaintNode(QSGNode* old_node, UpdatePaintNodeData* data) {
+    Q_UNUSED(data);
+    ScopedPerfCounters counters(render_counters_);
+    COPY_ACCOUNT_STREAM("video");
+
+    // 同步阶段：渲染线程无锁取走最新帧，本次vsync显示它
+    bool frame_changed = false;
+    const FrameMailbox::Entry& entry = mailbox_.acquire(&frame_changed);
+    if (frame_changed) {
+        current_frame_ = entry.frame;
+        if (entry.frame) {
+            render_metric_.record(steadyNowUs() - entry.publish_time_us);
+        }
+    }
+    // clear()之前发布的帧不再显示
+    if (current_frame_ && entry.sequence <= clear_sequence_.load()) {
+        current_frame_.reset();
+    }
+    if (current_frame_ && (frame_changed || isProducerActive(steadyNowUs()))) {
+        pacer_.onFrameSynced(frame_changed, entry.publish_time_us);
+    }
+
+    if (!current_frame_ || width() <= 0 || height() <= 0) {
+        delete old_node;
+        return nullptr;
+    }
+
+    if (useShaderPath()) {
+        return updateShaderNode(old_node, current_frame_, frame_changed);
+    }
+    return updateSoftwareNode(old_node, current_frame_, frame_changed);
+}
+
+void VideoItem::itemChange(ItemChange change, const ItemChangeData& value) {
+    if (change == ItemSceneChange) {
+        attachWindow(value.window);
+    }
+    QQuickItem::itemChange(change, value);
+}
+
+void VideoItem::attachWindow(QQuickWindow* window) {
+    if (window_) {
+        disconnect(window_, nullptr, this, nullptr);
+    }
+    window_ = window;
+    if (!window) {
+        return;
+    }
+
+    // frameSwapped在渲染线程发出，直接连接才能拿到真实的交换时间
+    connect(window, &QQuickWindow::frameSwapped, this, &VideoItem::onFrameSwapped,
+            Qt::DirectConnection);
+
+    auto update_refresh_rate = [this, window]() {
+        if (window->screen()) {
+            pacer_.setRefreshRate(window->screen()->refreshRate());
+        }
+    };
+    connect(window, &QQuickWindow::screenChanged, this, update_refresh_rate);
+    update_refresh_rate();
+}
+
+void VideoItem::onFrameSwapped() {
+    const int64_t now_us = steadyNowUs();
+    pacer_.onVsync(now_us);
+
+    // 播放中每个vsync都重新同步一次，由邮箱决定显示新帧还是重复上一帧
+    if (isProducerActive(now_us)) {
+        requestUpdate();
+    }
+}
+
+void VideoItem::requestUpdate() {
+    if (update_requested_.exchange(true)) {
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this]() {
+        update_requested_.store(false);
+        update();
+    }, Qt::QueuedConnection);
+}
+
+bool VideoItem::isProducerActive(int64_t now_us) const {
+    const int64_t last_publish_us = mailbox_.lastPublishTime();
+    if (last_publish_us == 0) {
+        return false;
+    }
+    const int64_t idle_us = std::max<int64_t>(kProducerIdleUs, pacer_.refreshIntervalUs() * 3);
+    return now_us - last_publish_us < idle_us;
+}
+
+bool VideoItem::useShaderPath() const {
+#ifdef MEDIA_RENDERER_HAS_RHI
+    if (!window()) {
+        return false;
+    }
+    return QSGRendererInterface::isApiRhiBased(window()->rendererInterface()->graphicsApi());
+#else
+    return false;
+#endif
+}
+
+AVPixelFormat VideoItem::stagingFormatFor(int pixel_format) const {
+#ifdef MEDIA_RENDERER_HAS_RHI
+    if (useShaderPath()) {
+        return YuvVideoNode::isFormatSupported(pixel_format) ? AV_PIX_FMT_NONE : AV_PIX_FMT_YUV420P;
+    }
+#endif
+    return pixel_format == AV_PIX_FMT_RGB32 ? AV_PIX_FMT_NONE : AV_PIX_FMT_RGB32;
+}
+
+ffmpeg::AVFrameSharedPtr VideoItem::convertFrame(const ffmpeg::AVFrameSharedPtr& frame,
+                                                 AVPixelFormat dst_format) {
+    VideoConvertParams params = converter_->getParams();
+    if (params.dst_width != frame->width || params.dst_height != frame->height ||
+        params.dst_format != dst_format) {
+        params.src_width = frame->width;
+        params.src_height = frame->height;
+        params.src_format = static_cast<AVPixelFormat>(frame->format);
+        params.dst_width = frame->width;
+        params.dst_height = frame->height;
+        params.dst_format = dst_format;
+        if (!converter_->reconfigure(params)) {
+            return nullptr;
+        }
+    }
+
+    FrameSpec spec(frame->width, frame->height, dst_format);
+    auto holder = std::make_shared<StagingFrame>();
+    holder->allocator = staging_allocator_;
+    holder->frame = staging_allocator_->allocateSharedFrame(spec);
+    if (!holder->frame) {
+        return nullptr;
+    }
+    {
+        ScopedPerfCounters counters(convert_counters_);
+        if (!converter_->convert(frame.get(), holder->frame.get())) {
+            return nullptr;
+        }
+    }
+    COPY_ACCOUNT("render.convert_staging", av_image_get_buffer_size(dst_format, frame->width, frame->height, 1));
+
+    // 别名构造：帧引用同时保持分配器存活
+    return ffmpeg::AVFrameSharedPtr(holder, holder->frame.get());
+}
+
+QSGNode* VideoItem::updateShaderNode(QSGNode* old_node, const ffmpeg::AVFrameSharedPtr& frame,
+                                     bool frame_changed) {
+#ifdef MEDIA_RENDERER_HAS_RHI
+    auto* node = dynamic_cast<YuvVideoNode*>(old_node);
+    if (node && !frame_changed) {
+        // 仅几何变化（如窗口缩放），无需重新上传纹理
+        node->setRect(displayRect(frame.get()));
+        return node;
+    }
+    if (!node) {
+        delete old_node;
+        node = new YuvVideoNode;
+    }
+
+    ffmpeg::AVFrameSharedPtr display_frame = frame;
+    if (!YuvVideoNode::isFormatSupported(frame->format)) {
+        display_frame = convertFrame(frame, AV_PIX_FMT_YUV420P);
+        if (!display_frame) {
+            delete node;
+            return nullptr;
+        }
+    }
+
+    node->setFrame(display_frame);
+    node->setRect(displayRect(display_frame.get()));
+    return node;
+#else
+    Q_UNUSED(frame);
+    Q_UNUSED(frame_changed);
+    delete old_node;
+    return nullptr;
+#endif
+}
+
+QSGNode* VideoItem::updateSoftwareNode(QSGNode* old_node, const ffmpeg::AVFrameSharedPtr& frame,
+                                       bool frame_changed) {
+    auto* node = dynamic_cast<QSGImageNode*>(old_node);
+    if (node && !frame_changed) {
+        node->setRect(displayRect(frame.get()));
+        return node;
+    }
+    if (!node) {
+        delete old_node;
+        node = window()->createImageNode();
+        node->setOwnsTexture(true);
+        node->setFiltering(QSGTexture::Linear);
+    }
+
+    // AV_PIX_FMT_RGB32 与 QImage::Format_RGB32 内存布局一致（本机字节序ARGB）
+    ffmpeg::AVFrameSharedPtr rgb_frame = frame;
+    if (frame->format != AV_PIX_FMT_RGB32) {
+        rgb_frame = convertFrame(frame, AV_PIX_FMT_RGB32);
+        if (!rgb_frame) {
+            delete node;
+            return nullptr;
+        }
+    }
+
+    // QImage直接引用帧内存，纹理释放时通过清理函数释放帧引用
+    QImage image(rgb_frame->data[0], rgb_frame->width, rgb_frame->height,
+                 rgb_frame->linesize[0], QImage::Format_RGB32,
+                 releaseImageFrame, new ffmpeg::AVFrameSharedPtr(rgb_frame));
+
+    QSGTexture* texture = window()->createTextureFromImage(image);
+    node->setTexture(texture);
+    node->setSourceRect(QRectF(QPointF(0, 0), texture->textureSize()));
+    node->setRect(displayRect(rgb_frame.get()));
+    return node;
+}
+
+QRectF VideoItem::displayRect(const AVFrame* frame) const {
+    const QRectF bounds = boundingRect();
+    if (!keep_aspect_ratio_ || frame->width <= 0 || frame->height <= 0) {
+        return bounds;
+    }
+
+    double display_width = frame->width;
+    if (frame->sample_aspect_ratio.num > 0 && frame->sample_aspect_ratio.den > 0) {
+        display_width = display_width * frame->sample_aspect_ratio.num / frame->sample_aspect_ratio.den;
+    }
+    const double aspect = display_width / frame->height;
+
+    QSizeF size = bounds.size();
+    if (size.width() / size.height() > aspect) {
+        size.setWidth(size.height() * aspect);
+    } else {
+        size.setHeight(size.width() / aspect);
+    }
+
+    return QRectF(bounds.x() + (bounds.width() - size.width()) / 2.0,
+                  bounds.y() + (bounds.height() - size.height()) / 2.0,
+                  size.width(), size.height());
+}
+
+} // namespace media
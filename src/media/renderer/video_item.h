@@ -0,0 +1,201 @@
+#ifndef VIDEO_ITEM_H
+#define VIDEO_ITEM_H
+
+#include <QQuickItem>
+#include <QSize>
+#include <QVariantMap>
+#include <QPointer>
+#include <atomic>
+#include <memory>
+
+#include "../../memory/smart_pointers.h"
+#include "../allocator/ffmpeg_allocator/ffmpeg_frame_allocator.h"
+#include "../converter/ffmpeg_video_converter.h"
+#include "../../utils/metrics_registry.h"
+#include "../../utils/perf_counters.h"
+#include "../snapshot/snapshot_service.h"
+#include "frame_mailbox.h"
+#include "frame_pacer.h"
+
+class QQuickWindow;
+
+namespace media {
+
+/**
+ * @brief QML视频显示项
+ *
+ * 设计特点：
+ * 1. 零拷贝：直接持有管道送来的引用计数帧，不经过中间QImage
+ * 2. GPU转换：平面YUV分别上传为单通道纹理，着色器完成颜色空间转换
+ * 3. 软件回退：software后端或不支持的格式使用FFmpegVideoConverter（swscale SIMD）转换
+ * 4. 生命周期：场景图释放节点/纹理时才释放帧引用，池化帧随之归还FFmpegFrameAllocator
+ * 5. 帧交接：FrameMailbox三缓冲无锁交接，渲染线程每个vsync取最新帧，FramePacer统计节奏
+ * 6. 截图：saveSnapshot只把最新帧的引用交给SnapshotService，编码在后台线程完成
+ * 7. 硬件计数：启用PerfCounters时，渲染线程上的格式转换和整个同步阶段分别计入convert/render
+ *
+ * QML用法：
+ *   import FFplay.Media 1.0
+ *   VideoItem {
+ *       anchors.fill: parent
+ *       onSnapshotSaved: (id, path, success, error) => console.log(path, success)
+ *   }
+ *   videoItem.saveSnapshot("/tmp/shot.jpg")
+ */
+class VideoItem : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(QSize frameSize READ frameSize NOTIFY frameSizeChanged)
+    Q_PROPERTY(bool keepAspectRatio READ keepAspectRatio WRITE setKeepAspectRatio NOTIFY keepAspectRatioChanged)
+
+public:
+    explicit VideoItem(QQuickItem* parent = nullptr);
+    ~VideoItem() override;
+
+    /**
+     * @brief 提交待显示的帧（单一生产者线程调用，通常为同步线程）
+     * @param frame 引用计数帧，传入nullptr清空画面
+     *
+     * 不阻塞：若上一帧尚未显示则被覆盖并计为丢帧。
+     */
+    void presentFrame(ffmpeg::AVFrameSharedPtr frame);
+
+    /**
+     * @brief 帧节奏统计（任意线程）
+     */
+    FramePacer::StatisticsSnapshot pacingSnapshot() const { return pacer_.getStatistics(); }
+
+    /**
+     * @brief 显示该像素格式的帧时需要转换到的格式（GUI线程，取决于场景图后端）
+     * @return 无需转换时返回AV_PIX_FMT_NONE
+     */
+    AVPixelFormat stagingFormatFor(int pixel_format) const;
+
+    /**
+     * @brief 转换输出的暂存池，启动时可在后台线程预分配
+     */
+    std::shared_ptr<FFmpegFrameAllocator> stagingAllocator() const { return staging_allocator_; }
+
+    /**
+     * @brief 暂存池每种规格的帧数
+     */
+    static constexpr size_t kStagingFrames = 3;
+
+    /**
+     * @brief 帧节奏统计，供QML调试面板读取
+     */
+    Q_INVOKABLE QVariantMap pacingStatistics() const;
+
+    /**
+     * @brief 渲染线程硬件计数器：{convert: {...}, render: {...}}，
+     *        每项含samples/cycles/instructions/llcMisses/branchMisses/ipc，render包含convert
+     */
+    Q_INVOKABLE QVariantMap counterStatistics() const;
+
+    /**
+     * @brief 清空画面
+     */
+    Q_INVOKABLE void clear();
+
+    /**
+     * @brief 把最新一帧保存为图片（不阻塞，编码完成后发出snapshotSaved）
+     * @param path 本地路径或file:// URL，扩展名.png为PNG，其余为JPEG
+     * @return 请求id；没有画面或截图队列已满时返回0
+     */
+    Q_INVOKABLE qulonglong saveSnapshot(const QString& path);
+
+    QSize frameSize() const;
+
+    bool keepAspectRatio() const { return keep_aspect_ratio_; }
+    void setKeepAspectRatio(bool keep);
+
+signals:
+    void frameSizeChanged();
+    void keepAspectRatioChanged();
+    void snapshotSaved(qulonglong id, const QString& path, bool success, const QString& error);
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* old_node, UpdatePaintNodeData* data) override;
+    void itemChange(ItemChange change, const ItemChangeData& value) override;
+
+private:
+    /**
+     * @brief 交换缓冲完成（渲染线程，DirectConnection）
+     */
+    void onFrameSwapped();
+
+    /**
+     * @brief 请求一次重绘；已有未处理的请求时合并
+     */
+    void requestUpdate();
+
+    /**
+     * @brief 生产者是否仍在持续送帧（决定是否按vsync持续重绘）
+     */
+    bool isProducerActive(int64_t now_us) const;
+
+    /**
+     * @brief 记录新的画面尺寸
+     * @return 尺寸是否变化
+     */
+    bool updateFrameSize(int width, int height);
+
+    /**
+     * @brief 在GUI线程发出frameSizeChanged
+     */
+    void notifyFrameSizeChanged();
+
+    void attachWindow(QQuickWindow* window);
+
+    /**
+     * @brief 当前场景图后端是否可以走着色器路径
+     */
+    bool useShaderPath() const;
+
+    /**
+     * @brief 转换为目标格式，输出帧来自暂存池
+     */
+    ffmpeg::AVFrameSharedPtr convertFrame(const ffmpeg::AVFrameSharedPtr& frame, AVPixelFormat dst_format);
+
+    QSGNode* updateShaderNode(QSGNode* old_node, const ffmpeg::AVFrameSharedPtr& frame, bool frame_changed);
+    QSGNode* updateSoftwareNode(QSGNode* old_node, const ffmpeg::AVFrameSharedPtr& frame, bool frame_changed);
+
+    /**
+     * @brief 计算保持宽高比的显示区域
+     */
+    QRectF displayRect(const AVFrame* frame) const;
+
+private:
+    // 跨线程交接（presentFrame -> updatePaintNode）
+    FrameMailbox mailbox_;
+    FramePacer pacer_;
+    std::atomic<int> frame_width_{0};
+    std::atomic<int> frame_height_{0};
+    std::atomic<bool> update_requested_{false};
+    std::atomic<uint64_t> clear_sequence_{0};   // clear()时已发布的帧数，序号不超过它的帧不再显示
+    QPointer<QQuickWindow> window_;
+
+    // 仅在渲染线程访问
+    ffmpeg::AVFrameSharedPtr current_frame_;
+    std::unique_ptr<FFmpegVideoConverter> converter_;
+
+    // 转换输出的暂存池；纹理可能比VideoItem活得更久，使用shared_ptr共享所有权
+    std::shared_ptr<FFmpegFrameAllocator> staging_allocator_;
+
+    bool keep_aspect_ratio_ = true;
+
+    // 性能浮层：发布到显示的延迟、被覆盖的帧、暂存池命中率
+    Metric& render_metric_;
+    Metric& overwrite_metric_;
+    int staging_probe_id_ = 0;
+
+    // 渲染线程硬件计数器（perf.convert.*、perf.render.*）
+    PerfStage convert_counters_{"convert"};
+    PerfStage render_counters_{"render"};
+
+    // 截图：最新发布的帧（atomic_load/atomic_store访问），本项在截图服务中的流id
+    ffmpeg::AVFrameSharedPtr snapshot_frame_;
+    const int snapshot_stream_id_;
+};
+
+} // namespace media
+
+#endif // VIDEO_ITEM_H
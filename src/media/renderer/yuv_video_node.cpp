@@ -0,0 +1,259 @@
+#include "yuv_video_node.h"
+#include <cstring>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace media {
+
+QMatrix4x4 yuvColorMatrix(int colorspace, int color_range) {
+    // 亮度系数 Kr/Kb
+    float kr = 0.299f;
+    float kb = 0.114f;
+    switch (colorspace) {
+    case AVCOL_SPC_BT709:
+        kr = 0.2126f;
+        kb = 0.0722f;
+        break;
+    case AVCOL_SPC_BT2020_NCL:
+    case AVCOL_SPC_BT2020_CL:
+        kr = 0.2627f;
+        kb = 0.0593f;
+        break;
+    default:
+        break;  // 未指定时按BT.601处理
+    }
+    const float kg = 1.0f - kr - kb;
+
+    const float rv = 2.0f * (1.0f - kr);
+    const float bu = 2.0f * (1.0f - kb);
+    const float gu = -2.0f * kb * (1.0f - kb) / kg;
+    const float gv = -2.0f * kr * (1.0f - kr) / kg;
+
+    // limited range: Y∈[16,235]，UV∈[16,240]
+    const bool full_range = (color_range == AVCOL_RANGE_JPEG);
+    const float y_scale = full_range ? 1.0f : 255.0f / 219.0f;
+    const float c_scale = full_range ? 1.0f : 255.0f / 224.0f;
+    const float y_offset = full_range ? 0.0f : 16.0f / 255.0f;
+
+    const float y_bias = -y_scale * y_offset;
+    return QMatrix4x4(
+        y_scale, 0.0f,          rv * c_scale,  y_bias - rv * c_scale * 0.5f,
+        y_scale, gu * c_scale,  gv * c_scale,  y_bias - (gu + gv) * c_scale * 0.5f,
+        y_scale, bu * c_scale,  0.0f,          y_bias - bu * c_scale * 0.5f,
+        0.0f,    0.0f,          0.0f,          1.0f);
+}
+
+#ifdef MEDIA_RENDERER_HAS_RHI
+
+// VideoPlaneTexture 实现
+void VideoPlaneTexture::setPlane(ffmpeg::AVFrameSharedPtr frame, int plane,
+                                 const QSize& size, QRhiTexture::Format format) {
+    frame_ = std::move(frame);
+    plane_ = plane;
+    size_ = size;
+    format_ = format;
+    dirty_ = true;
+}
+
+void VideoPlaneTexture::reset() {
+    frame_.reset();
+    texture_.reset();
+    dirty_ = false;
+}
+
+qint64 VideoPlaneTexture::comparisonKey() const {
+    if (texture_) {
+        return qint64(qintptr(texture_.get()));
+    }
+    return qint64(qintptr(this));
+}
+
+QRhiTexture* VideoPlaneTexture::rhiTexture() const {
+    return texture_.get();
+}
+
+void VideoPlaneTexture::commitTextureOperations(QRhi* rhi, QRhiResourceUpdateBatch* resourceUpdates) {
+    if (!dirty_ || !frame_ || size_.isEmpty()) {
+        return;
+    }
+
+    if (!texture_ || texture_->pixelSize() != size_ || texture_->format() != format_) {
+        texture_.reset(rhi->newTexture(format_, size_, 1, {}));
+        if (!texture_->create()) {
+            texture_.reset();
+            return;
+        }
+    }
+
+    // 以帧平面内存为数据源，跳过linesize填充；帧引用一直保留到下一帧替换
+    const int stride = frame_->linesize[plane_];
+    const int bytes = stride * size_.height();
+    QRhiTextureSubresourceUploadDescription desc;
+    desc.setData(QByteArray::fromRawData(reinterpret_cast<const char*>(frame_->data[plane_]), bytes));
+    desc.setDataStride(quint32(stride));
+    desc.setSourceSize(size_);
+    resourceUpdates->uploadTexture(texture_.get(), QRhiTextureUploadEntry(0, 0, desc));
+
+    dirty_ = false;
+}
+
+// YuvVideoMaterialShader 实现
+namespace {
+
+class YuvVideoMaterialShader : public QSGMaterialShader {
+public:
+    YuvVideoMaterialShader() {
+        setShaderFileName(VertexStage, QStringLiteral(":/resources/shaders/yuv_video.vert.qsb"));
+        setShaderFileName(FragmentStage, QStringLiteral(":/resources/shaders/yuv_video.frag.qsb"));
+    }
+
+    bool updateUniformData(RenderState& state, QSGMaterial* new_material, QSGMaterial* old_material) override {
+        Q_UNUSED(old_material);
+        auto* material = static_cast<YuvVideoMaterial*>(new_material);
+        QByteArray* buf = state.uniformData();
+
+        // std140布局: mat4 qt_Matrix | mat4 colorMatrix | float qt_Opacity | int planeLayout
+        if (state.isMatrixDirty()) {
+            const QMatrix4x4 m = state.combinedMatrix();
+            std::memcpy(buf->data(), m.constData(), 64);
+        }
+        std::memcpy(buf->data() + 64, material->colorMatrix().constData(), 64);
+        if (state.isOpacityDirty()) {
+            const float opacity = state.opacity();
+            std::memcpy(buf->data() + 128, &opacity, 4);
+        }
+        const qint32 layout = static_cast<qint32>(material->planeLayout());
+        std::memcpy(buf->data() + 132, &layout, 4);
+        return true;
+    }
+
+    void updateSampledImage(RenderState& state, int binding, QSGTexture** texture,
+                            QSGMaterial* new_material, QSGMaterial* old_material) override {
+        Q_UNUSED(old_material);
+        auto* material = static_cast<YuvVideoMaterial*>(new_material);
+
+        // binding 1/2/3 -> Y/U/V；NV12只有两个平面，V绑定复用UV纹理
+        int plane = binding - 1;
+        if (plane == 2 && material->planeLayout() == YuvVideoMaterial::PlaneLayout::SemiPlanar) {
+            plane = 1;
+        }
+        if (plane < 0 || plane > 2) {
+            return;
+        }
+
+        VideoPlaneTexture* plane_texture = material->planeTexture(plane);
+        plane_texture->commitTextureOperations(state.rhi(), state.resourceUpdateBatch());
+        *texture = plane_texture;
+    }
+};
+
+} // namespace
+
+// YuvVideoMaterial 实现
+YuvVideoMaterial::YuvVideoMaterial() {
+    color_matrix_ = yuvColorMatrix(AVCOL_SPC_UNSPECIFIED, AVCOL_RANGE_MPEG);
+}
+
+QSGMaterialType* YuvVideoMaterial::type() const {
+    static QSGMaterialType material_type;
+    return &material_type;
+}
+
+QSGMaterialShader* YuvVideoMaterial::createShader(QSGRendererInterface::RenderMode render_mode) const {
+    Q_UNUSED(render_mode);
+    return new YuvVideoMaterialShader;
+}
+
+int YuvVideoMaterial::compare(const QSGMaterial* other) const {
+    // 每个视频节点使用独立纹理，按地址区分即可
+    const auto* rhs = static_cast<const YuvVideoMaterial*>(other);
+    if (this == rhs) {
+        return 0;
+    }
+    return this < rhs ? -1 : 1;
+}
+
+void YuvVideoMaterial::setFrame(const ffmpeg::AVFrameSharedPtr& frame) {
+    if (!frame) {
+        releaseFrame();
+        return;
+    }
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (!desc) {
+        return;
+    }
+
+    const QSize luma_size(frame->width, frame->height);
+    const QSize chroma_size(AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w),
+                            AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h));
+
+    planes_[0].setPlane(frame, 0, luma_size, QRhiTexture::R8);
+    if (frame->format == AV_PIX_FMT_NV12) {
+        plane_layout_ = PlaneLayout::SemiPlanar;
+        planes_[1].setPlane(frame, 1, chroma_size, QRhiTexture::RG8);
+        planes_[2].reset();
+    } else {
+        plane_layout_ = PlaneLayout::Planar;
+        planes_[1].setPlane(frame, 1, chroma_size, QRhiTexture::R8);
+        planes_[2].setPlane(frame, 2, chroma_size, QRhiTexture::R8);
+    }
+
+    // YUVJ格式隐含full range
+    int color_range = frame->color_range;
+    if (frame->format == AV_PIX_FMT_YUVJ420P || frame->format == AV_PIX_FMT_YUVJ422P ||
+        frame->format == AV_PIX_FMT_YUVJ444P) {
+        color_range = AVCOL_RANGE_JPEG;
+    }
+    color_matrix_ = yuvColorMatrix(frame->colorspace, color_range);
+}
+
+void YuvVideoMaterial::releaseFrame() {
+    for (auto& plane : planes_) {
+        plane.reset();
+    }
+}
+
+// YuvVideoNode 实现
+YuvVideoNode::YuvVideoNode()
+    : geometry_(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4) {
+    geometry_.setDrawingMode(QSGGeometry::DrawTriangleStrip);
+    setGeometry(&geometry_);
+    setMaterial(&material_);
+}
+
+YuvVideoNode::~YuvVideoNode() {
+    // 节点由场景图在渲染线程销毁，此时释放帧引用，池化帧归还分配器
+    material_.releaseFrame();
+}
+
+void YuvVideoNode::setFrame(const ffmpeg::AVFrameSharedPtr& frame) {
+    material_.setFrame(frame);
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+void YuvVideoNode::setRect(const QRectF& rect) {
+    QSGGeometry::updateTexturedRectGeometry(&geometry_, rect, QRectF(0, 0, 1, 1));
+    markDirty(QSGNode::DirtyGeometry);
+}
+
+bool YuvVideoNode::isFormatSupported(int format) {
+    switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_NV12:
+        return true;
+    default:
+        return false;
+    }
+}
+
+#endif // MEDIA_RENDERER_HAS_RHI
+
+} // namespace media
@@ -0,0 +1,144 @@
+#ifndef YUV_VIDEO_NODE_H
+#define YUV_VIDEO_NODE_H
+
+#include <QtGlobal>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+#include <QSGTexture>
+#include <QMatrix4x4>
+#include <memory>
+
+#include "../../memory/smart_pointers.h"
+
+// GPU路径依赖公开的QRhi接口（Qt 6.6+）和编译好的.qsb着色器
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0) && defined(MEDIA_RENDERER_SHADERS_AVAILABLE)
+#define MEDIA_RENDERER_HAS_RHI 1
+#include <rhi/qrhi.h>
+#endif
+
+namespace media {
+
+#ifdef MEDIA_RENDERER_HAS_RHI
+
+/**
+ * @brief 单个视频平面的纹理
+ *
+ * 直接持有帧的引用，上传时以平面内存为数据源（fromRawData，不做CPU侧拷贝），
+ * 纹理被替换或销毁时释放引用，池化帧随之归还到FFmpegFrameAllocator。
+ */
+class VideoPlaneTexture : public QSGTexture {
+public:
+    VideoPlaneTexture() = default;
+    ~VideoPlaneTexture() override = default;
+
+    /**
+     * @brief 绑定帧的某个平面
+     * @param frame 引用计数帧
+     * @param plane 平面索引
+     * @param size 平面像素尺寸（不含linesize填充）
+     * @param format 纹理格式（R8或RG8）
+     */
+    void setPlane(ffmpeg::AVFrameSharedPtr frame, int plane, const QSize& size, QRhiTexture::Format format);
+
+    /**
+     * @brief 释放帧引用和GPU纹理
+     */
+    void reset();
+
+    // 实现QSGTexture接口
+    qint64 comparisonKey() const override;
+    QRhiTexture* rhiTexture() const override;
+    QSize textureSize() const override { return size_; }
+    bool hasAlphaChannel() const override { return false; }
+    bool hasMipmaps() const override { return false; }
+    void commitTextureOperations(QRhi* rhi, QRhiResourceUpdateBatch* resourceUpdates) override;
+
+private:
+    ffmpeg::AVFrameSharedPtr frame_;
+    int plane_ = 0;
+    QSize size_;
+    QRhiTexture::Format format_ = QRhiTexture::R8;
+    std::unique_ptr<QRhiTexture> texture_;
+    bool dirty_ = false;
+};
+
+/**
+ * @brief 平面YUV材质：每个平面一张纹理，颜色转换在片元着色器中完成
+ */
+class YuvVideoMaterial : public QSGMaterial {
+public:
+    /**
+     * @brief 平面布局
+     */
+    enum class PlaneLayout {
+        Planar = 0,     // Y/U/V 三平面（YUV420P/422P/444P）
+        SemiPlanar = 1  // Y + UV交错（NV12）
+    };
+
+    YuvVideoMaterial();
+
+    QSGMaterialType* type() const override;
+    QSGMaterialShader* createShader(QSGRendererInterface::RenderMode render_mode) const override;
+    int compare(const QSGMaterial* other) const override;
+
+    /**
+     * @brief 更新材质使用的帧
+     */
+    void setFrame(const ffmpeg::AVFrameSharedPtr& frame);
+
+    /**
+     * @brief 释放所有帧引用
+     */
+    void releaseFrame();
+
+    VideoPlaneTexture* planeTexture(int index) { return &planes_[index]; }
+    const QMatrix4x4& colorMatrix() const { return color_matrix_; }
+    PlaneLayout planeLayout() const { return plane_layout_; }
+
+private:
+    VideoPlaneTexture planes_[3];
+    QMatrix4x4 color_matrix_;
+    PlaneLayout plane_layout_ = PlaneLayout::Planar;
+};
+
+/**
+ * @brief 显示YUV帧的场景图节点
+ */
+class YuvVideoNode : public QSGGeometryNode {
+public:
+    YuvVideoNode();
+    ~YuvVideoNode() override;
+
+    /**
+     * @brief 设置要显示的帧（渲染线程调用）
+     */
+    void setFrame(const ffmpeg::AVFrameSharedPtr& frame);
+
+    /**
+     * @brief 设置显示区域
+     */
+    void setRect(const QRectF& rect);
+
+    /**
+     * @brief GPU路径是否支持该像素格式
+     */
+    static bool isFormatSupported(int format);
+
+private:
+    QSGGeometry geometry_;
+    YuvVideoMaterial material_;
+};
+
+#endif // MEDIA_RENDERER_HAS_RHI
+
+/**
+ * @brief 计算YUV->RGB颜色矩阵（作用于 vec4(y, u, v, 1)）
+ * @param colorspace AVColorSpace
+ * @param color_range AVColorRange
+ * @return 列主序可直接上传到着色器的矩阵
+ */
+QMatrix4x4 yuvColorMatrix(int colorspace, int color_range);
+
+} // namespace media
+
+#endif // YUV_VIDEO_NODE_H
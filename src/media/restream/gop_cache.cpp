@@ -0,0 +1,177 @@
+#include "gop_cache.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+namespace media {
+
+/**
+ * @brief 包壳回收池：数据包释放时解引用数据，AVPacket结构回到池中
+ */
+class GopCache::PacketPool : public std::enable_shared_from_this<PacketPool> {
+public:
+    PacketPool(size_t capacity, Statistics& stats)
+        : capacity_(capacity), stats_(stats) {}
+
+    ~PacketPool() {
+        for (AVPacket*& packet : free_) {
+            av_packet_free(&packet);
+        }
+    }
+
+    ffmpeg::AVPacketSharedPtr acquire() {
+        AVPacket* packet = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                packet = free_.back();
+                free_.pop_back();
+            }
+        }
+        if (packet) {
+            stats_.pool_hits++;
+        } else {
+            packet = av_packet_alloc();
+            if (!packet) {
+                return nullptr;
+            }
+        }
+        // 删除器持有池的引用：缓存先销毁时，消费者手里的包仍能安全归还
+        std::shared_ptr<PacketPool> self = shared_from_this();
+        return ffmpeg::AVPacketSharedPtr(packet, [self](AVPacket* released) { self->release(released); });
+    }
+
+private:
+    void release(AVPacket* packet) {
+        av_packet_unref(packet);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.size() < capacity_) {
+                free_.push_back(packet);
+                return;
+            }
+        }
+        av_packet_free(&packet);
+    }
+
+    size_t capacity_;
+    Statistics& stats_;
+    std::mutex mutex_;
+    std::vector<AVPacket*> free_;
+};
+
+GopCache::GopCache(const Config& config)
+    : config_(config) {
+    pool_ = std::make_shared<PacketPool>(config_.pool_packets, stats_);
+}
+
+GopCache::~GopCache() {
+    clear();
+}
+
+bool GopCache::initialize(const IDemuxer& demuxer) {
+    bool has_video = false;
+    bool has_audio = false;
+    for (const auto& info : demuxer.getStreamInfos()) {
+        if (info.isVideo() && !has_video) {
+            has_video = addStream(info.index, info.time_base, true);
+        } else if (info.isAudio() && !has_audio && config_.include_audio) {
+            has_audio = addStream(info.index, info.time_base, false);
+        }
+    }
+    return has_video;
+}
+
+bool GopCache::addStream(int input_index, AVRational time_base, bool video) {
+    if (input_index < 0 || time_base.num <= 0 || time_base.den <= 0 || (video && video_index_ >= 0)) {
+        return false;
+    }
+    if (input_index >= static_cast<int>(streams_.size())) {
+        streams_.resize(input_index + 1);
+    }
+    StreamEntry& entry = streams_[input_index];
+    if (entry.registered) {
+        return false;
+    }
+    entry.time_base = time_base;
+    entry.video = video;
+    entry.registered = true;
+    if (video) {
+        video_index_ = input_index;
+    }
+    return true;
+}
+
+void GopCache::push(const AVPacket* packet) {
+    if (!packet || packet->stream_index < 0 || packet->stream_index >= static_cast<int>(streams_.size())) {
+        return;
+    }
+    const StreamEntry& entry = streams_[packet->stream_index];
+    if (!entry.registered || (!entry.video && !config_.include_audio)) {
+        return;
+    }
+    stats_.packets_in++;
+
+    const int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    const int64_t ts_us = ts != AV_NOPTS_VALUE ? av_rescale_q(ts, entry.time_base, AV_TIME_BASE_Q)
+                                               : AV_NOPTS_VALUE;
+    const bool keyframe = entry.video && (packet->flags & AV_PKT_FLAG_KEY) != 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keyframe) {
+        // 新GOP：整体替换，旧包的引用由仍持有快照的消费者负责释放
+        resetLocked();
+        overflowed_ = false;
+        current_.keyframe_us = ts_us;
+        stats_.gops_started++;
+    } else if (current_.packets.empty() || overflowed_) {
+        // 还没有关键帧，或本GOP已作废
+        return;
+    }
+
+    if (current_.packets.size() + 1 > config_.max_packets ||
+        current_.bytes + static_cast<size_t>(packet->size) > config_.max_bytes) {
+        resetLocked();
+        overflowed_ = true;
+        stats_.overflows++;
+        return;
+    }
+
+    ffmpeg::AVPacketSharedPtr cached = pool_->acquire();
+    if (!cached || av_packet_ref(cached.get(), packet) < 0) {
+        return;
+    }
+    current_.packets.push_back(std::move(cached));
+    current_.bytes += static_cast<size_t>(packet->size);
+    if (entry.video) {
+        current_.video_packets++;
+    }
+    if (ts_us != AV_NOPTS_VALUE) {
+        current_.newest_us = current_.newest_us == AV_NOPTS_VALUE ? ts_us : std::max(current_.newest_us, ts_us);
+    }
+    stats_.cached_packets.store(current_.packets.size());
+    stats_.cached_bytes.store(current_.bytes);
+}
+
+GopCache::Snapshot GopCache::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.snapshots++;
+    return current_;
+}
+
+void GopCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resetLocked();
+    overflowed_ = false;
+}
+
+void GopCache::resetLocked() {
+    current_ = Snapshot{};
+    stats_.cached_packets.store(0);
+    stats_.cached_bytes.store(0);
+}
+
+} // namespace media
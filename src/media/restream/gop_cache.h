@@ -0,0 +1,166 @@
+#ifndef GOP_CACHE_H
+#define GOP_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../demux/demuxer.h"
+#include "../../memory/smart_pointers.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace media {
+
+/**
+ * @brief 直播流的GOP缓存：保存最近一个视频关键帧以来的数据包，新加入的消费者立即拿到可解码的起点
+ *
+ * 设计特点：
+ * 1. 关键帧对齐：缓存总是从视频关键帧开始，下一个关键帧到来时整体替换，消费者拿到的第一个包一定能独立解码
+ * 2. 共享引用：缓存项就是引用计数的数据包（av_packet_ref，不拷贝数据），快照只复制shared_ptr，
+ *    消费者持有的包不受之后淘汰的影响；包壳来自回收池，稳定后不再分配
+ * 3. 有界：超过字节或包数上限时本GOP作废（不能只留后半段，那样没有关键帧），直到下一个关键帧恢复
+ * 4. 追直播：快照带着关键帧和最新包的时间，消费者可以连续解码整个GOP、只显示最后几帧追到直播点，
+ *    首帧等待从"等下一个关键帧"（最长一个GOP时长）变成"解码一个GOP"
+ *
+ * push在接入线程调用；snapshot可在任意线程调用。快照中的包只读。
+ */
+class GopCache {
+public:
+    /**
+     * @brief 缓存配置
+     */
+    struct Config {
+        size_t max_bytes;           // 单个GOP的数据量上限
+        size_t max_packets;         // 单个GOP的包数上限
+        bool include_audio;         // 同时缓存关键帧之后的音频包
+        size_t pool_packets;        // 回收池保留的包壳数
+
+        Config()
+            : max_bytes(16 * 1024 * 1024)
+            , max_packets(4096)
+            , include_audio(true)
+            , pool_packets(512)
+        {}
+    };
+
+    /**
+     * @brief 一次快照：从关键帧开始的数据包（按到达顺序）
+     */
+    struct Snapshot {
+        std::vector<ffmpeg::AVPacketSharedPtr> packets;
+        int64_t keyframe_us = AV_NOPTS_VALUE;   // 关键帧时间（微秒）
+        int64_t newest_us = AV_NOPTS_VALUE;     // 最新一个包的时间（微秒），即直播点
+        size_t video_packets = 0;
+        size_t bytes = 0;
+
+        bool isValid() const { return !packets.empty(); }
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t packets_in;
+        uint64_t gops_started;
+        uint64_t overflows;         // 超出上限而作废的GOP
+        uint64_t snapshots;
+        uint64_t pool_hits;         // 复用回收池中的包壳
+        size_t cached_packets;
+        size_t cached_bytes;
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> packets_in{0};
+        std::atomic<uint64_t> gops_started{0};
+        std::atomic<uint64_t> overflows{0};
+        std::atomic<uint64_t> snapshots{0};
+        std::atomic<uint64_t> pool_hits{0};
+        std::atomic<size_t> cached_packets{0};
+        std::atomic<size_t> cached_bytes{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                packets_in.load(),
+                gops_started.load(),
+                overflows.load(),
+                snapshots.load(),
+                pool_hits.load(),
+                cached_packets.load(),
+                cached_bytes.load()
+            };
+        }
+    };
+
+public:
+    explicit GopCache(const Config& config = Config{});
+    ~GopCache();
+
+    GopCache(const GopCache&) = delete;
+    GopCache& operator=(const GopCache&) = delete;
+
+    /**
+     * @brief 按解封装器的流登记（第一个视频流和第一个音频流）
+     */
+    bool initialize(const IDemuxer& demuxer);
+
+    /**
+     * @brief 登记一路流（第一个数据包之前调用）
+     * @param input_index 输入数据包的stream_index
+     * @param time_base 输入数据包时间戳的时间基
+     * @param video 是否为决定GOP边界的视频流（只能有一路）
+     */
+    bool addStream(int input_index, AVRational time_base, bool video);
+
+    /**
+     * @brief 接入一个数据包（只增加引用，不修改packet）
+     */
+    void push(const AVPacket* packet);
+
+    /**
+     * @brief 取当前GOP；还没有关键帧或本GOP已作废时返回空快照
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief 清空缓存（流中断、切换源时调用）
+     */
+    void clear();
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+private:
+    class PacketPool;
+
+    struct StreamEntry {
+        AVRational time_base = {0, 1};
+        bool video = false;
+        bool registered = false;
+    };
+
+    void resetLocked();
+
+private:
+    Config config_;
+    std::vector<StreamEntry> streams_;          // 按输入流索引
+    int video_index_ = -1;
+    std::shared_ptr<PacketPool> pool_;
+
+    mutable std::mutex mutex_;
+    Snapshot current_;
+    bool overflowed_ = false;                   // 本GOP超出上限，等下一个关键帧
+
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // GOP_CACHE_H
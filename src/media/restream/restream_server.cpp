@@ -0,0 +1,791 @@
+#include "restream_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/opt.h>
+}
+
+namespace media {
+
+namespace {
+
+// 复用器的AVIO缓冲；每个数据包之后都会flush，只需容纳一个包的TS字节的一部分
+constexpr int kAvioBufferSize = 64 * 1024;
+// 一次sendmsg最多提交的块数
+constexpr int kMaxIovecs = 64;
+constexpr size_t kMaxRequestBytes = 8192;
+constexpr int kMaxEvents = 256;
+
+std::string ffmpegError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return prefix + error_buf;
+}
+
+std::string systemError(const std::string& prefix) {
+    return prefix + std::strerror(errno);
+}
+
+} // namespace
+
+/**
+ * @brief 块回收池：块释放时数据缓冲（连同容量）回到池中
+ */
+class RestreamServer::ChunkPool : public std::enable_shared_from_this<ChunkPool> {
+public:
+    ChunkPool(size_t capacity, Statistics& stats)
+        : capacity_(capacity), stats_(stats) {}
+
+    std::shared_ptr<Chunk> acquire() {
+        Chunk* chunk = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                chunk = free_.back().release();
+                free_.pop_back();
+            }
+        }
+        if (chunk) {
+            stats_.chunk_pool_hits++;
+            chunk->data.clear();
+            chunk->keyframe = false;
+        } else {
+            chunk = new Chunk();
+        }
+        // 删除器持有池的引用：服务先销毁时，客户端手里的块仍能安全归还
+        std::shared_ptr<ChunkPool> self = shared_from_this();
+        return std::shared_ptr<Chunk>(chunk, [self](Chunk* released) { self->release(released); });
+    }
+
+private:
+    void release(Chunk* chunk) {
+        std::unique_ptr<Chunk> owned(chunk);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < capacity_) {
+            free_.push_back(std::move(owned));
+        }
+    }
+
+    size_t capacity_;
+    Statistics& stats_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Chunk>> free_;
+};
+
+RestreamServer::RestreamServer(const Config& config)
+    : config_(config)
+    , mux_packet_(av_packet_alloc())
+    , mux_metric_(MetricsRegistry::instance().latency("stage.restream_mux"))
+    , clients_metric_(MetricsRegistry::instance().gauge("queue.restream_clients"))
+    , resync_metric_(MetricsRegistry::instance().counter("drop.restream_resync")) {
+    chunk_pool_ = std::make_shared<ChunkPool>(config_.chunk_pool_size, stats_);
+}
+
+RestreamServer::~RestreamServer() {
+    stop();
+    for (auto& stream : streams_) {
+        avcodec_parameters_free(&stream.codecpar);
+    }
+    av_packet_free(&mux_packet_);
+}
+
+bool RestreamServer::initialize(const IDemuxer& demuxer) {
+    bool has_video = false;
+    bool has_audio = false;
+    for (const auto& info : demuxer.getStreamInfos()) {
+        if ((info.isVideo() && has_video) || (info.isAudio() && has_audio) ||
+            (!info.isVideo() && !info.isAudio())) {
+            continue;
+        }
+        if (!addStream(info.index, demuxer.getCodecParameters(info.index), info.time_base)) {
+            return false;
+        }
+        has_video = has_video || info.isVideo();
+        has_audio = has_audio || info.isAudio();
+    }
+    if (streams_.empty()) {
+        setError("没有可转发的音视频流");
+        return false;
+    }
+    return true;
+}
+
+bool RestreamServer::addStream(int input_index, const AVCodecParameters* codecpar, AVRational time_base) {
+    if (running_.load()) {
+        setError("服务已启动，不能再添加流");
+        return false;
+    }
+    if (input_index < 0 || !codecpar || time_base.num <= 0 || time_base.den <= 0) {
+        setError("无效的输出流参数");
+        return false;
+    }
+    if (input_index < static_cast<int>(slot_of_input_.size()) && slot_of_input_[input_index] >= 0) {
+        setError("输入流已添加");
+        return false;
+    }
+
+    OutputStream stream;
+    stream.input_index = input_index;
+    stream.codecpar = avcodec_parameters_alloc();
+    if (!stream.codecpar || avcodec_parameters_copy(stream.codecpar, codecpar) < 0) {
+        avcodec_parameters_free(&stream.codecpar);
+        setError("复制编码参数失败");
+        return false;
+    }
+    stream.time_base = time_base;
+    stream.video = codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+    has_video_ = has_video_ || stream.video;
+
+    if (input_index >= static_cast<int>(slot_of_input_.size())) {
+        slot_of_input_.resize(input_index + 1, -1);
+    }
+    slot_of_input_[input_index] = static_cast<int>(streams_.size());
+    streams_.push_back(stream);
+    return true;
+}
+
+bool RestreamServer::start() {
+    if (running_.load()) {
+        return true;
+    }
+    if (streams_.empty()) {
+        setError("没有输出流");
+        return false;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        setError(systemError("创建监听套接字失败: "));
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.bind_address.c_str(), &address.sin_addr) != 1) {
+        setError("无效的监听地址 " + config_.bind_address);
+        stop();
+        return false;
+    }
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, SOMAXCONN) < 0) {
+        setError(systemError("监听失败: "));
+        stop();
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        setError(systemError("创建epoll失败: "));
+        stop();
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    if (!openMuxer()) {
+        stop();
+        return false;
+    }
+
+    running_.store(true);
+    loop_thread_ = std::thread(&RestreamServer::eventLoop, this);
+    return true;
+}
+
+void RestreamServer::stop() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+    closeAllClients();
+    closeMuxer();
+    gop_chunks_.clear();
+    gop_bytes_ = 0;
+    stats_.gop_cached_bytes.store(0);
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.clear();
+    }
+    queued_bytes_.store(0);
+
+    for (int* fd : {&listen_fd_, &epoll_fd_, &wake_fd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool RestreamServer::writePacket(const AVPacket* packet) {
+    if (!running_.load() || !format_ctx_) {
+        return false;
+    }
+    if (!packet || packet->stream_index < 0 || packet->stream_index >= static_cast<int>(slot_of_input_.size())) {
+        return true;
+    }
+    const int slot = slot_of_input_[packet->stream_index];
+    if (slot < 0) {
+        return true;
+    }
+    stats_.packets_in++;
+
+    OutputStream& stream = streams_[slot];
+    const int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (dts == AV_NOPTS_VALUE || (stream.last_dts != AV_NOPTS_VALUE && dts <= stream.last_dts)) {
+        // TS复用器要求每路dts严格递增
+        stats_.packets_dropped++;
+        return true;
+    }
+    stream.last_dts = dts;
+
+    ScopedLatency timing(mux_metric_);
+    const bool keyframe = stream.video ? (packet->flags & AV_PKT_FLAG_KEY) != 0 : !has_video_;
+    if (keyframe && stream.video) {
+        // 关键帧前重发PAT/PMT，新客户端从这里开始就能解析
+        av_opt_set(format_ctx_->priv_data, "mpegts_flags", "+resend_headers", 0);
+    }
+
+    if (av_packet_ref(mux_packet_, packet) < 0) {
+        stats_.packets_dropped++;
+        return true;
+    }
+    mux_packet_->stream_index = stream.stream->index;
+    mux_packet_->dts = dts;
+    if (mux_packet_->pts == AV_NOPTS_VALUE) {
+        mux_packet_->pts = dts;
+    }
+    av_packet_rescale_ts(mux_packet_, stream.time_base, stream.stream->time_base);
+    mux_packet_->pos = -1;
+
+    current_chunk_ = chunk_pool_->acquire();
+    current_chunk_->keyframe = keyframe;
+    int ret = av_write_frame(format_ctx_, mux_packet_);
+    av_packet_unref(mux_packet_);
+    if (ret >= 0) {
+        avio_flush(format_ctx_->pb);
+    }
+    std::shared_ptr<Chunk> chunk = std::move(current_chunk_);
+    if (ret < 0) {
+        setError(ffmpegError("复用失败: ", ret));
+        return false;
+    }
+
+    // 音频可能攒在复用器里，这次没有输出
+    if (!chunk->data.empty()) {
+        stats_.chunks_muxed++;
+        stats_.bytes_muxed += chunk->data.size();
+        publish(std::move(chunk));
+    }
+    return true;
+}
+
+bool RestreamServer::waitIdle(int timeout_ms) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (queued_bytes_.load() > 0) {
+        if (!running_.load() || std::chrono::steady_clock::now() >= deadline) {
+            return queued_bytes_.load() == 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+std::string RestreamServer::getLastError() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+bool RestreamServer::openMuxer() {
+    int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, "mpegts", nullptr);
+    if (ret < 0 || !format_ctx_) {
+        setError(ffmpegError("创建复用器失败: ", ret));
+        return false;
+    }
+
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+    AVIOContext* pb = buffer ? avio_alloc_context(buffer, kAvioBufferSize, 1, this, nullptr,
+                                                  &RestreamServer::writeCallback, nullptr) : nullptr;
+    if (!pb) {
+        av_free(buffer);
+        closeMuxer();
+        setError("分配AVIO上下文失败");
+        return false;
+    }
+    pb->seekable = 0;
+    format_ctx_->pb = pb;
+    format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    for (auto& stream : streams_) {
+        stream.stream = avformat_new_stream(format_ctx_, nullptr);
+        if (!stream.stream || avcodec_parameters_copy(stream.stream->codecpar, stream.codecpar) < 0) {
+            closeMuxer();
+            setError("创建输出流失败");
+            return false;
+        }
+        stream.stream->codecpar->codec_tag = 0;
+        stream.stream->time_base = stream.time_base;
+        stream.last_dts = AV_NOPTS_VALUE;
+    }
+
+    // 低延迟：音频PES不攒包，复用器不额外缓冲
+    AVDictionary* options = nullptr;
+    av_dict_set(&options, "pes_payload_size", "0", 0);
+    format_ctx_->max_delay = 0;
+    // 文件头（如果有）写进一个丢弃的块：客户端靠关键帧前的PAT/PMT起步
+    current_chunk_ = chunk_pool_->acquire();
+    ret = avformat_write_header(format_ctx_, &options);
+    av_dict_free(&options);
+    if (ret >= 0) {
+        avio_flush(format_ctx_->pb);
+    }
+    current_chunk_.reset();
+    if (ret < 0) {
+        closeMuxer();
+        setError(ffmpegError("写入TS头失败: ", ret));
+        return false;
+    }
+    return true;
+}
+
+void RestreamServer::closeMuxer() {
+    if (!format_ctx_) {
+        return;
+    }
+    if (format_ctx_->pb) {
+        av_freep(&format_ctx_->pb->buffer);
+        avio_context_free(&format_ctx_->pb);
+    }
+    avformat_free_context(format_ctx_);
+    format_ctx_ = nullptr;
+    for (auto& stream : streams_) {
+        stream.stream = nullptr;
+    }
+}
+
+int RestreamServer::writeCallback(void* opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                                  const uint8_t* buf,
+#else
+                                  uint8_t* buf,
+#endif
+                                  int size) {
+    auto* self = static_cast<RestreamServer*>(opaque);
+    if (self->current_chunk_ && size > 0) {
+        self->current_chunk_->data.insert(self->current_chunk_->data.end(), buf, buf + size);
+    }
+    return size;
+}
+
+void RestreamServer::publish(ChunkPtr chunk) {
+    queued_bytes_ += chunk->data.size();
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.push_back(std::move(chunk));
+    }
+    uint64_t one = 1;
+    (void)!write(wake_fd_, &one, sizeof(one));
+}
+
+void RestreamServer::eventLoop() {
+    epoll_event events[kMaxEvents];
+    std::vector<ChunkPtr> batch;
+
+    while (running_.load()) {
+        const int count = epoll_wait(epoll_fd_, events, kMaxEvents, 100);
+        if (count < 0 && errno != EINTR) {
+            setError(systemError("epoll_wait失败: "));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                acceptClients();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                uint64_t value = 0;
+                (void)!read(wake_fd_, &value, sizeof(value));
+                continue;
+            }
+
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) {
+                continue;
+            }
+            Client& client = it->second;
+            const uint32_t flags = events[i].events;
+            if (flags & (EPOLLERR | EPOLLHUP)) {
+                closeClient(fd);
+                continue;
+            }
+            if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                handleReadable(client);
+                if (clients_.find(fd) == clients_.end()) {
+                    continue;
+                }
+            }
+            if ((flags & EPOLLOUT) && !flushClient(client)) {
+                closeClient(fd);
+            }
+        }
+
+        // 分发接入线程复用好的块
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            batch.swap(pending_);
+        }
+        if (!batch.empty()) {
+            for (const ChunkPtr& chunk : batch) {
+                updateGopCache(chunk);
+                distribute(chunk);
+                queued_bytes_ -= chunk->data.size();
+            }
+            batch.clear();
+
+            // 没有挂起写事件的客户端立即尝试发送，被内核缓冲区挡住的等EPOLLOUT
+            std::vector<int> failed;
+            for (auto& entry : clients_) {
+                Client& client = entry.second;
+                if (client.state == ClientState::Streaming && !client.want_write && !client.queue.empty() &&
+                    !flushClient(client)) {
+                    failed.push_back(entry.first);
+                }
+            }
+            for (int fd : failed) {
+                closeClient(fd);
+            }
+        }
+    }
+}
+
+void RestreamServer::acceptClients() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                setError(systemError("accept失败: "));
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (clients_.size() >= config_.max_clients) {
+            stats_.clients_rejected++;
+            ::close(fd);
+            continue;
+        }
+
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        if (config_.send_buffer_bytes > 0) {
+            setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &config_.send_buffer_bytes, sizeof(config_.send_buffer_bytes));
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        Client& client = clients_[fd];
+        client.fd = fd;
+        stats_.clients_accepted++;
+    }
+}
+
+void RestreamServer::handleReadable(Client& client) {
+    char buffer[2048];
+    while (true) {
+        const ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            if (client.state == ClientState::ReadingRequest) {
+                client.request.append(buffer, static_cast<size_t>(received));
+            }
+            // 推流过程中客户端发来的数据直接丢弃
+            continue;
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeClient(client.fd);
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+
+    if (client.state == ClientState::ReadingRequest) {
+        if (client.request.find("\r\n\r\n") != std::string::npos) {
+            handleRequest(client);
+        } else if (client.request.size() > kMaxRequestBytes) {
+            stats_.clients_rejected++;
+            closeClient(client.fd);
+        }
+    }
+}
+
+void RestreamServer::handleRequest(Client& client) {
+    // 只认GET <路径> HTTP/1.x，路径忽略查询参数
+    std::string path;
+    const size_t line_end = client.request.find("\r\n");
+    const std::string line = client.request.substr(0, line_end);
+    if (line.compare(0, 4, "GET ") == 0) {
+        const size_t path_end = line.find(' ', 4);
+        path = line.substr(4, path_end == std::string::npos ? std::string::npos : path_end - 4);
+        const size_t query = path.find('?');
+        if (query != std::string::npos) {
+            path.resize(query);
+        }
+    }
+    client.request.clear();
+    client.request.shrink_to_fit();
+
+    if (path == config_.path || path == "/") {
+        client.response =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: video/mp2t\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+        client.state = ClientState::Streaming;
+        client.waiting_keyframe = true;
+        primeClient(client);
+        stats_.clients_streaming++;
+        clients_metric_.set(static_cast<double>(stats_.clients_streaming.load()));
+    } else {
+        client.response =
+            "HTTP/1.1 404 Not Found\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+        client.state = ClientState::Closing;
+        stats_.clients_rejected++;
+    }
+    if (!flushClient(client)) {
+        closeClient(client.fd);
+    }
+}
+
+void RestreamServer::distribute(const ChunkPtr& chunk) {
+    for (auto& entry : clients_) {
+        if (entry.second.state == ClientState::Streaming) {
+            enqueue(entry.second, chunk);
+        }
+    }
+}
+
+void RestreamServer::updateGopCache(const ChunkPtr& chunk) {
+    if (config_.gop_cache_bytes == 0) {
+        return;
+    }
+    if (chunk->keyframe) {
+        // 新GOP整体替换旧GOP；已经排进客户端队列的块不受影响
+        gop_chunks_.clear();
+        gop_bytes_ = 0;
+    } else if (gop_chunks_.empty()) {
+        // 还没有关键帧，或本GOP超出上限，等下一个关键帧
+        return;
+    }
+    if (gop_bytes_ + chunk->data.size() > config_.gop_cache_bytes) {
+        // 只留后半段无法解码，整个GOP作废
+        gop_chunks_.clear();
+        gop_bytes_ = 0;
+    } else {
+        gop_chunks_.push_back(chunk);
+        gop_bytes_ += chunk->data.size();
+    }
+    stats_.gop_cached_bytes.store(gop_bytes_);
+}
+
+void RestreamServer::primeClient(Client& client) {
+    if (gop_chunks_.empty()) {
+        return;
+    }
+    // 首块是关键帧块（带PAT/PMT），客户端直接从上一个关键帧开始，随后的块照常分发
+    for (const ChunkPtr& chunk : gop_chunks_) {
+        enqueue(client, chunk);
+    }
+    stats_.clients_primed++;
+}
+
+void RestreamServer::enqueue(Client& client, const ChunkPtr& chunk) {
+    const size_t size = chunk->data.size();
+    if (client.waiting_keyframe) {
+        if (!chunk->keyframe) {
+            return;
+        }
+        client.waiting_keyframe = false;
+    }
+
+    if (!client.queue.empty() &&
+        (client.queued_bytes + size > config_.client_queue_bytes ||
+         client.queue.size() >= config_.client_queue_chunks)) {
+        // 慢客户端：丢掉队列（发了一半的块要发完，否则TS包错位），从下一个关键帧重新开始
+        const bool partial = client.front_offset > 0;
+        size_t dropped_bytes = 0;
+        size_t dropped_chunks = 0;
+        for (size_t i = partial ? 1 : 0; i < client.queue.size(); ++i) {
+            dropped_bytes += client.queue[i]->data.size();
+            dropped_chunks++;
+        }
+        client.queue.erase(client.queue.begin() + (partial ? 1 : 0), client.queue.end());
+        client.queued_bytes -= dropped_bytes;
+        queued_bytes_ -= dropped_bytes;
+        stats_.chunks_dropped += dropped_chunks + (chunk->keyframe ? 0 : 1);
+        stats_.keyframe_resyncs++;
+        resync_metric_.add();
+        if (!chunk->keyframe) {
+            client.waiting_keyframe = true;
+            return;
+        }
+    }
+
+    client.queue.push_back(chunk);
+    client.queued_bytes += size;
+    queued_bytes_ += size;
+}
+
+bool RestreamServer::flushClient(Client& client) {
+    while (true) {
+        iovec iov[kMaxIovecs];
+        int iov_count = 0;
+        const size_t response_left = client.response.size() - client.response_sent;
+        if (response_left > 0) {
+            iov[iov_count].iov_base = const_cast<char*>(client.response.data() + client.response_sent);
+            iov[iov_count].iov_len = response_left;
+            iov_count++;
+        }
+        if (client.state == ClientState::Streaming) {
+            for (size_t i = 0; i < client.queue.size() && iov_count < kMaxIovecs; ++i) {
+                const std::vector<uint8_t>& data = client.queue[i]->data;
+                const size_t offset = i == 0 ? client.front_offset : 0;
+                iov[iov_count].iov_base = const_cast<uint8_t*>(data.data() + offset);
+                iov[iov_count].iov_len = data.size() - offset;
+                iov_count++;
+            }
+        }
+
+        if (iov_count == 0) {
+            if (client.state == ClientState::Closing) {
+                return false;
+            }
+            updateInterest(client, false);
+            return true;
+        }
+
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = static_cast<size_t>(iov_count);
+        const ssize_t sent = sendmsg(client.fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+        stats_.send_calls++;
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                updateInterest(client, true);
+                return true;
+            }
+            return false;
+        }
+
+        // 按发送字节推进：先响应头，再逐块
+        size_t remaining = static_cast<size_t>(sent);
+        const size_t response_part = std::min(remaining, response_left);
+        client.response_sent += response_part;
+        remaining -= response_part;
+        stats_.bytes_sent += remaining;
+        client.queued_bytes -= remaining;
+        queued_bytes_ -= remaining;
+        while (remaining > 0 && !client.queue.empty()) {
+            const size_t left = client.queue.front()->data.size() - client.front_offset;
+            if (remaining < left) {
+                client.front_offset += remaining;
+                remaining = 0;
+            } else {
+                remaining -= left;
+                client.queue.pop_front();
+                client.front_offset = 0;
+            }
+        }
+        if (client.response_sent == client.response.size() && !client.response.empty()) {
+            client.response.clear();
+            client.response_sent = 0;
+        }
+    }
+}
+
+void RestreamServer::updateInterest(Client& client, bool want_write) {
+    if (client.want_write == want_write) {
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0u);
+    event.data.fd = client.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &event);
+    client.want_write = want_write;
+}
+
+void RestreamServer::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    Client& client = it->second;
+    queued_bytes_ -= client.queued_bytes;
+    if (client.state == ClientState::Streaming) {
+        stats_.clients_streaming--;
+        clients_metric_.set(static_cast<double>(stats_.clients_streaming.load()));
+    }
+    if (epoll_fd_ >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    ::close(fd);
+    clients_.erase(it);
+    stats_.clients_closed++;
+}
+
+void RestreamServer::closeAllClients() {
+    while (!clients_.empty()) {
+        closeClient(clients_.begin()->first);
+    }
+}
+
+void RestreamServer::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    last_error_ = error;
+}
+
+} // namespace media
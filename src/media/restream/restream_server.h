@@ -0,0 +1,287 @@
+#ifndef RESTREAM_SERVER_H
+#define RESTREAM_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../demux/demuxer.h"
+#include "../../utils/metrics_registry.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace media {
+
+/**
+ * @brief 本地转发服务：把一路接入流（通常是RTSPInput）以HTTP-TS扇出给多个观看端
+ *
+ * 设计特点：
+ * 1. 只封装一次：接入的数据包引用计数后复用成TS，每个数据包的TS字节是一个块，所有客户端共享同一个块，
+ *    块的内存来自回收池，稳定后不再分配
+ * 2. 单线程事件循环：非阻塞套接字 + epoll，接收请求、分发块和发送都在一个线程，客户端之间没有锁
+ * 3. 零拷贝发送：客户端队列里只有块的引用，sendmsg一次把多个块的iovec交给内核
+ * 4. 慢客户端隔离：每个客户端的队列有字节数和块数上限，超出时丢掉队列、等下一个关键帧重新同步，
+ *    不影响其他客户端，也不阻塞接入线程
+ * 5. 随时加入：视频关键帧前复用器重发PAT/PMT；事件循环保留最近一个关键帧以来的块（GOP缓存），
+ *    新客户端先收到这些块，立即从上一个关键帧开始解码，不用等下一个关键帧
+ *
+ * addStream/start/writePacket/stop在接入线程调用；统计可在任意线程读取。
+ */
+class RestreamServer {
+public:
+    /**
+     * @brief 服务配置
+     */
+    struct Config {
+        std::string bind_address;       // 监听地址
+        uint16_t port;                  // 监听端口，0为系统分配（start后用port()读取）
+        std::string path;               // 流地址路径，"/"也可以访问
+        size_t max_clients;
+        size_t client_queue_bytes;      // 每个客户端排队字节上限
+        size_t client_queue_chunks;     // 每个客户端排队块数上限
+        int send_buffer_bytes;          // 客户端套接字发送缓冲，0为系统默认
+        size_t chunk_pool_size;         // 块回收池保留的块数
+        size_t gop_cache_bytes;         // GOP缓存上限（应小于client_queue_bytes），超出时本GOP不再用于新客户端；0为关闭
+
+        Config()
+            : bind_address("127.0.0.1")
+            , port(0)
+            , path("/stream.ts")
+            , max_clients(512)
+            , client_queue_bytes(4 * 1024 * 1024)
+            , client_queue_chunks(2048)
+            , send_buffer_bytes(0)
+            , chunk_pool_size(256)
+            , gop_cache_bytes(2 * 1024 * 1024)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t clients_accepted;
+        uint64_t clients_rejected;      // 超过max_clients或请求无效
+        uint64_t clients_closed;
+        size_t clients_streaming;       // 当前正在接收流的客户端
+        uint64_t packets_in;
+        uint64_t packets_dropped;       // 没有时间戳或时间戳不单调
+        uint64_t chunks_muxed;
+        uint64_t bytes_muxed;
+        uint64_t chunk_pool_hits;       // 复用回收池中的块
+        uint64_t bytes_sent;            // 所有客户端合计
+        uint64_t send_calls;
+        uint64_t keyframe_resyncs;      // 慢客户端丢队列、等关键帧的次数
+        uint64_t chunks_dropped;        // 因慢客户端丢掉的块
+        uint64_t clients_primed;        // 加入时由GOP缓存起步的客户端
+        size_t gop_cached_bytes;        // 当前GOP缓存的字节
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> clients_accepted{0};
+        std::atomic<uint64_t> clients_rejected{0};
+        std::atomic<uint64_t> clients_closed{0};
+        std::atomic<size_t> clients_streaming{0};
+        std::atomic<uint64_t> packets_in{0};
+        std::atomic<uint64_t> packets_dropped{0};
+        std::atomic<uint64_t> chunks_muxed{0};
+        std::atomic<uint64_t> bytes_muxed{0};
+        std::atomic<uint64_t> chunk_pool_hits{0};
+        std::atomic<uint64_t> bytes_sent{0};
+        std::atomic<uint64_t> send_calls{0};
+        std::atomic<uint64_t> keyframe_resyncs{0};
+        std::atomic<uint64_t> chunks_dropped{0};
+        std::atomic<uint64_t> clients_primed{0};
+        std::atomic<size_t> gop_cached_bytes{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                clients_accepted.load(),
+                clients_rejected.load(),
+                clients_closed.load(),
+                clients_streaming.load(),
+                packets_in.load(),
+                packets_dropped.load(),
+                chunks_muxed.load(),
+                bytes_muxed.load(),
+                chunk_pool_hits.load(),
+                bytes_sent.load(),
+                send_calls.load(),
+                keyframe_resyncs.load(),
+                chunks_dropped.load(),
+                clients_primed.load(),
+                gop_cached_bytes.load()
+            };
+        }
+    };
+
+public:
+    explicit RestreamServer(const Config& config = Config{});
+    ~RestreamServer();
+
+    RestreamServer(const RestreamServer&) = delete;
+    RestreamServer& operator=(const RestreamServer&) = delete;
+
+    /**
+     * @brief 按解封装器的音视频流建立输出流（各取第一个视频流和音频流）
+     */
+    bool initialize(const IDemuxer& demuxer);
+
+    /**
+     * @brief 添加一路输出流（start之前调用）
+     * @param input_index 输入数据包的stream_index
+     * @param time_base 输入数据包时间戳的时间基
+     */
+    bool addStream(int input_index, const AVCodecParameters* codecpar, AVRational time_base);
+
+    /**
+     * @brief 打开复用器，开始监听
+     */
+    bool start();
+
+    /**
+     * @brief 断开所有客户端并停止监听
+     */
+    void stop();
+
+    /**
+     * @brief 转发一个数据包（不修改、不接管packet）
+     * @return 未启动或复用出错时返回false
+     */
+    bool writePacket(const AVPacket* packet);
+
+    /**
+     * @brief 等待所有已转发的数据发送给客户端（客户端断开也算完成）
+     * @return 超时返回false
+     */
+    bool waitIdle(int timeout_ms);
+
+    bool isRunning() const { return running_.load(); }
+
+    /**
+     * @brief 实际监听端口（start之后有效）
+     */
+    uint16_t port() const { return port_; }
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+private:
+    /**
+     * @brief 一个数据包复用出的TS字节，所有客户端共享
+     */
+    struct Chunk {
+        std::vector<uint8_t> data;
+        bool keyframe = false;          // 以视频关键帧开头（前面带PAT/PMT），可作为客户端的起点
+    };
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+    class ChunkPool;
+
+    enum class ClientState {
+        ReadingRequest,
+        Streaming,
+        Closing         // 发完错误响应后关闭
+    };
+
+    struct Client {
+        int fd = -1;
+        ClientState state = ClientState::ReadingRequest;
+        std::string request;
+        std::string response;           // 待发送的HTTP响应头
+        size_t response_sent = 0;
+        std::deque<ChunkPtr> queue;
+        size_t queued_bytes = 0;
+        size_t front_offset = 0;        // 队首块已发送的字节
+        bool waiting_keyframe = true;
+        bool want_write = false;        // 已注册EPOLLOUT
+    };
+
+    struct OutputStream {
+        int input_index = -1;
+        AVCodecParameters* codecpar = nullptr;
+        AVRational time_base = {0, 1};
+        bool video = false;
+        int64_t last_dts = AV_NOPTS_VALUE;
+        AVStream* stream = nullptr;
+    };
+
+    bool openMuxer();
+    void closeMuxer();
+    void publish(ChunkPtr chunk);
+
+    void eventLoop();
+    void acceptClients();
+    void handleReadable(Client& client);
+    void handleRequest(Client& client);
+    void distribute(const ChunkPtr& chunk);
+    void updateGopCache(const ChunkPtr& chunk);
+    void primeClient(Client& client);
+    void enqueue(Client& client, const ChunkPtr& chunk);
+    bool flushClient(Client& client);
+    void updateInterest(Client& client, bool want_write);
+    void closeClient(int fd);
+    void closeAllClients();
+    void setError(const std::string& error);
+
+    static int writeCallback(void* opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                             const uint8_t* buf,
+#else
+                             uint8_t* buf,
+#endif
+                             int size);
+
+private:
+    Config config_;
+
+    // 复用（接入线程）
+    std::vector<OutputStream> streams_;
+    std::vector<int> slot_of_input_;
+    bool has_video_ = false;
+    AVFormatContext* format_ctx_ = nullptr;
+    AVPacket* mux_packet_ = nullptr;
+    std::shared_ptr<ChunkPool> chunk_pool_;
+    std::shared_ptr<Chunk> current_chunk_;      // 复用器正在写入的块
+
+    // 接入线程 -> 事件循环
+    std::mutex pending_mutex_;
+    std::vector<ChunkPtr> pending_;
+    std::atomic<size_t> queued_bytes_{0};       // 待分发 + 所有客户端队列中的字节
+
+    // 事件循环
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    uint16_t port_ = 0;
+    std::unordered_map<int, Client> clients_;
+    std::vector<ChunkPtr> gop_chunks_;          // 最近一个关键帧块以来的块，为空表示没有可用的GOP
+    size_t gop_bytes_ = 0;
+    std::thread loop_thread_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex error_mutex_;
+    std::string last_error_;
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& mux_metric_;
+    Metric& clients_metric_;
+    Metric& resync_metric_;
+};
+
+} // namespace media
+
+#endif // RESTREAM_SERVER_H
@@ -0,0 +1,453 @@
+#include "snapshot_service.h"
+#include "../converter/ffmpeg_video_converter.h"
+#include "../../memory/copy_accounting.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+}
+
+namespace media {
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+std::string ffmpegError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return prefix + error_buf;
+}
+
+// mjpeg编码器可以直接接收的全范围YUV格式
+bool isJpegNative(AVPixelFormat format) {
+    return format == AV_PIX_FMT_YUVJ420P || format == AV_PIX_FMT_YUVJ422P || format == AV_PIX_FMT_YUVJ444P;
+}
+
+bool isPngNative(AVPixelFormat format) {
+    return format == AV_PIX_FMT_RGB24 || format == AV_PIX_FMT_RGBA || format == AV_PIX_FMT_GRAY8;
+}
+
+// JPEG质量1~100映射到mjpeg的qscale（2最好，31最差）
+int jpegQscale(int quality) {
+    quality = std::max(1, std::min(100, quality));
+    return 2 + (100 - quality) * 29 / 99;
+}
+
+// 先写临时文件再改名，监视目录的程序不会读到半张图片
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data, std::string& error) {
+    const std::string temp_path = path + ".part";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        error = "无法创建文件: " + temp_path;
+        return false;
+    }
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed) {
+        std::remove(temp_path.c_str());
+        error = "写入文件失败: " + temp_path;
+        return false;
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        error = "重命名文件失败: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 工作线程私有的编码状态
+ *
+ * 编码器上下文、转换器和转换缓冲只在所属线程使用，规格不变时跨请求复用。
+ */
+class SnapshotService::Worker {
+public:
+    explicit Worker(const Config& config)
+        : config_(config)
+        , packet_(ffmpeg::SmartPointerFactory::createPacket()) {
+    }
+
+    ~Worker() {
+        closeEncoder();
+    }
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    bool encode(const AVFrame* frame, ImageFormat format, std::vector<uint8_t>& output, std::string& error) {
+        const AVFrame* source = frame;
+
+        // 硬件帧先下载到内存
+        if (frame->hw_frames_ctx) {
+            if (!download_) {
+                download_ = ffmpeg::SmartPointerFactory::createFrame();
+            } else {
+                av_frame_unref(download_.get());
+            }
+            int ret = av_hwframe_transfer_data(download_.get(), frame, 0);
+            if (ret < 0) {
+                error = ffmpegError("下载硬件帧失败: ", ret);
+                return false;
+            }
+            source = download_.get();
+        }
+
+        const AVPixelFormat src_format = static_cast<AVPixelFormat>(source->format);
+        AVPixelFormat target_format;
+        if (format == ImageFormat::JPEG) {
+            target_format = isJpegNative(src_format) ? src_format : AV_PIX_FMT_YUVJ420P;
+        } else {
+            target_format = isPngNative(src_format) ? src_format : AV_PIX_FMT_RGB24;
+        }
+
+        if (target_format != src_format) {
+            source = convert(source, target_format, error);
+            if (!source) {
+                return false;
+            }
+        }
+
+        if (!ensureEncoder(format, source->width, source->height, target_format, error)) {
+            return false;
+        }
+
+        // mjpeg/png都是帧内编码且单线程打开，送一帧立即出一个包
+        int ret = avcodec_send_frame(encoder_, source);
+        if (ret >= 0) {
+            ret = avcodec_receive_packet(encoder_, packet_.get());
+        }
+        if (ret < 0) {
+            error = ffmpegError("图片编码失败: ", ret);
+            closeEncoder();
+            return false;
+        }
+
+        output.assign(packet_->data, packet_->data + packet_->size);
+        av_packet_unref(packet_.get());
+        return true;
+    }
+
+private:
+    const AVFrame* convert(const AVFrame* source, AVPixelFormat target_format, std::string& error) {
+        if (!converted_ || converted_->width != source->width || converted_->height != source->height ||
+            converted_->format != target_format) {
+            converted_ = ffmpeg::SmartPointerFactory::createFrame();
+            if (!converted_ || !ffmpeg::SmartPointerFactory::allocateImageBuffer(
+                    converted_.get(), target_format, source->width, source->height)) {
+                converted_.reset();
+                error = "分配转换缓冲失败";
+                return nullptr;
+            }
+
+            VideoConvertParams params;
+            params.src_width = source->width;
+            params.src_height = source->height;
+            params.src_format = static_cast<AVPixelFormat>(source->format);
+            params.dst_width = source->width;
+            params.dst_height = source->height;
+            params.dst_format = target_format;
+            if (!converter_.initialize(params)) {
+                error = converter_.getLastError();
+                return nullptr;
+            }
+        } else {
+            // 编码器可能仍引用上一次的缓冲，此时make_writable复制整帧
+            COPY_ACCOUNT_IF(!av_frame_is_writable(converted_.get()), "snapshot.make_writable",
+                            copyAccountingFrameBytes(converted_.get()));
+            if (av_frame_make_writable(converted_.get()) < 0) {
+                error = "转换缓冲不可写";
+                return nullptr;
+            }
+        }
+
+        if (!converter_.convert(source, converted_.get())) {
+            error = converter_.getLastError();
+            return nullptr;
+        }
+        return converted_.get();
+    }
+
+    bool ensureEncoder(ImageFormat format, int width, int height, AVPixelFormat pix_fmt, std::string& error) {
+        if (encoder_ && encoder_format_ == format && encoder_width_ == width &&
+            encoder_height_ == height && encoder_pix_fmt_ == pix_fmt) {
+            return true;
+        }
+        closeEncoder();
+
+        const AVCodec* codec = avcodec_find_encoder(format == ImageFormat::JPEG ? AV_CODEC_ID_MJPEG : AV_CODEC_ID_PNG);
+        if (!codec) {
+            error = format == ImageFormat::JPEG ? "找不到mjpeg编码器" : "找不到png编码器";
+            return false;
+        }
+
+        encoder_ = avcodec_alloc_context3(codec);
+        if (!encoder_) {
+            error = "无法分配编码器上下文";
+            return false;
+        }
+        encoder_->width = width;
+        encoder_->height = height;
+        encoder_->pix_fmt = pix_fmt;
+        encoder_->time_base = AVRational{1, 25};
+        encoder_->thread_count = 1;     // 并行度由工作线程数决定，避免帧级多线程的输出延迟
+
+        if (format == ImageFormat::JPEG) {
+            encoder_->flags |= AV_CODEC_FLAG_QSCALE;
+            encoder_->global_quality = FF_QP2LAMBDA * jpegQscale(config_.jpeg_quality);
+            encoder_->color_range = AVCOL_RANGE_JPEG;
+        } else {
+            encoder_->compression_level = std::max(0, std::min(9, config_.png_compression));
+        }
+
+        int ret = avcodec_open2(encoder_, codec, nullptr);
+        if (ret < 0) {
+            error = ffmpegError("打开图片编码器失败: ", ret);
+            closeEncoder();
+            return false;
+        }
+
+        encoder_format_ = format;
+        encoder_width_ = width;
+        encoder_height_ = height;
+        encoder_pix_fmt_ = pix_fmt;
+        return true;
+    }
+
+    void closeEncoder() {
+        if (encoder_) {
+            avcodec_free_context(&encoder_);
+        }
+        encoder_pix_fmt_ = AV_PIX_FMT_NONE;
+    }
+
+private:
+    const Config& config_;
+
+    AVCodecContext* encoder_ = nullptr;
+    ImageFormat encoder_format_ = ImageFormat::JPEG;
+    int encoder_width_ = 0;
+    int encoder_height_ = 0;
+    AVPixelFormat encoder_pix_fmt_ = AV_PIX_FMT_NONE;
+
+    FFmpegVideoConverter converter_;
+    ffmpeg::AVFramePtr download_;       // 硬件帧下载缓冲
+    ffmpeg::AVFramePtr converted_;      // 格式转换输出
+    ffmpeg::AVPacketPtr packet_;
+};
+
+SnapshotService& SnapshotService::instance() {
+    static SnapshotService service;
+    return service;
+}
+
+SnapshotService::SnapshotService(const Config& config)
+    : config_(config)
+    , encode_metric_(MetricsRegistry::instance().latency("stage.snapshot_encode"))
+    , pending_metric_(MetricsRegistry::instance().gauge("queue.snapshot_pending"))
+    , rejected_metric_(MetricsRegistry::instance().counter("drop.snapshot_rejected")) {
+    const int worker_count = std::max(1, config_.worker_count);
+    for (int i = 0; i < worker_count; ++i) {
+        workers_.emplace_back(&SnapshotService::workerLoop, this);
+    }
+}
+
+SnapshotService::~SnapshotService() {
+    stop();
+}
+
+uint64_t SnapshotService::submit(Request request) {
+    if (!request.frame || request.frame->width <= 0 || request.frame->height <= 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stream = pending_per_stream_.find(request.stream_id);
+    const size_t stream_pending = stream != pending_per_stream_.end() ? stream->second : 0;
+    if (stopping_ || queue_.size() + active_streams_.size() >= config_.max_pending ||
+        stream_pending >= config_.max_pending_per_stream) {
+        stats_.rejected++;
+        rejected_metric_.add();
+        return 0;
+    }
+
+    PendingRequest pending;
+    pending.id = next_id_.fetch_add(1);
+    pending.enqueue_time = std::chrono::steady_clock::now();
+    pending_per_stream_[request.stream_id] = stream_pending + 1;
+    pending.request = std::move(request);
+    const uint64_t id = pending.id;
+    queue_.push_back(std::move(pending));
+
+    stats_.submitted++;
+    pending_metric_.set(static_cast<double>(queue_.size() + active_streams_.size()));
+    work_cv_.notify_one();
+    return id;
+}
+
+void SnapshotService::cancel(int stream_id) {
+    std::vector<PendingRequest> removed;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto it = queue_.begin(); it != queue_.end();) {
+            if (it->request.stream_id == stream_id) {
+                removed.push_back(std::move(*it));
+                it = queue_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        auto stream = pending_per_stream_.find(stream_id);
+        if (stream != pending_per_stream_.end()) {
+            stream->second -= std::min(stream->second, removed.size());
+            if (stream->second == 0) {
+                pending_per_stream_.erase(stream);
+            }
+        }
+        stats_.cancelled += removed.size();
+        pending_metric_.set(static_cast<double>(queue_.size() + active_streams_.size()));
+
+        // 等待该路正在编码的请求（及其回调）结束
+        idle_cv_.wait(lock, [this, stream_id]() {
+            return std::find(active_streams_.begin(), active_streams_.end(), stream_id) == active_streams_.end();
+        });
+    }
+    // removed在锁外析构，释放帧引用
+}
+
+bool SnapshotService::waitIdle(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return queue_.empty() && active_streams_.empty();
+    });
+}
+
+void SnapshotService::stop() {
+    std::deque<PendingRequest> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ && workers_.empty()) {
+            return;
+        }
+        stopping_ = true;
+        removed.swap(queue_);
+        stats_.cancelled += removed.size();
+    }
+    work_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_per_stream_.clear();
+    pending_metric_.set(0.0);
+}
+
+size_t SnapshotService::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + active_streams_.size();
+}
+
+int SnapshotService::allocateStreamId() {
+    static std::atomic<int> next_stream_id{1};
+    return next_stream_id.fetch_add(1);
+}
+
+SnapshotService::ImageFormat SnapshotService::formatForPath(const std::string& path) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) {
+        return ImageFormat::JPEG;
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == "png" ? ImageFormat::PNG : ImageFormat::JPEG;
+}
+
+void SnapshotService::workerLoop() {
+    Worker worker(config_);
+
+    while (true) {
+        PendingRequest pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                break;
+            }
+            pending = std::move(queue_.front());
+            queue_.pop_front();
+            active_streams_.push_back(pending.request.stream_id);
+        }
+
+        Result result;
+        result.id = pending.id;
+        result.stream_id = pending.request.stream_id;
+        result.path = pending.request.path;
+        result.format = pending.request.format;
+        result.width = pending.request.frame->width;
+        result.height = pending.request.frame->height;
+        result.queue_ms = elapsedMs(pending.enqueue_time);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        result.success = worker.encode(pending.request.frame.get(), result.format, *data, result.error);
+
+        // 编码完立即释放帧引用，帧可能来自解码器的帧池
+        pending.request.frame.reset();
+
+        if (result.success && !result.path.empty()) {
+            result.success = writeFile(result.path, *data, result.error);
+        }
+        result.encode_ms = elapsedMs(start);
+        encode_metric_.record(static_cast<int64_t>(result.encode_ms * 1000.0));
+
+        if (result.success) {
+            result.data = std::move(data);
+            stats_.completed++;
+            stats_.bytes_encoded += result.data->size();
+            double total = stats_.total_encode_ms.load();
+            while (!stats_.total_encode_ms.compare_exchange_weak(total, total + result.encode_ms)) {
+            }
+        } else {
+            stats_.failed++;
+        }
+        double max_queue = stats_.max_queue_ms.load();
+        while (result.queue_ms > max_queue && !stats_.max_queue_ms.compare_exchange_weak(max_queue, result.queue_ms)) {
+        }
+
+        if (pending.request.callback) {
+            pending.request.callback(result);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto active = std::find(active_streams_.begin(), active_streams_.end(), result.stream_id);
+            if (active != active_streams_.end()) {
+                active_streams_.erase(active);
+            }
+            auto stream = pending_per_stream_.find(result.stream_id);
+            if (stream != pending_per_stream_.end() && --stream->second == 0) {
+                pending_per_stream_.erase(stream);
+            }
+            pending_metric_.set(static_cast<double>(queue_.size() + active_streams_.size()));
+        }
+        idle_cv_.notify_all();
+    }
+}
+
+} // namespace media
@@ -0,0 +1,234 @@
+#ifndef SNAPSHOT_SERVICE_H
+#define SNAPSHOT_SERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../memory/smart_pointers.h"
+#include "../../utils/metrics_registry.h"
+
+namespace media {
+
+/**
+ * @brief 截图服务：后台把引用计数帧编码为JPEG/PNG
+ *
+ * 设计特点：
+ * 1. 零拷贝入队：调用方只交出帧引用（AVFrameSharedPtr），渲染/解码线程上只有一次入队加锁
+ * 2. 后台编码：工作线程用FFmpeg的mjpeg/png编码器编码，格式不符时先用swscale转换
+ * 3. 编码器复用：每个工作线程按（格式、尺寸、像素格式）缓存编码器上下文和转换缓冲，连拍时不重复打开
+ * 4. 突发保护：全局队列和每路流的待处理数都有上限，超出直接拒绝，不会积压帧引用拖住解码器的帧池
+ * 5. 多路共享：所有流共用一组工作线程，按提交顺序处理；某一路可以单独取消
+ *
+ * 用法：
+ *   SnapshotService::Request request;
+ *   request.frame = frame;                 // 只增加引用计数
+ *   request.path = "/tmp/shot.jpg";
+ *   request.callback = [](const SnapshotService::Result& r) { ... };  // 工作线程中调用
+ *   uint64_t id = SnapshotService::instance().submit(std::move(request));
+ */
+class SnapshotService {
+public:
+    /**
+     * @brief 输出图片格式
+     */
+    enum class ImageFormat {
+        JPEG,
+        PNG
+    };
+
+    /**
+     * @brief 编码结果（回调参数）
+     */
+    struct Result {
+        uint64_t id = 0;
+        int stream_id = 0;
+        bool success = false;
+        std::string path;                               // 写入的文件，未写文件时为空
+        ImageFormat format = ImageFormat::JPEG;
+        int width = 0;
+        int height = 0;
+        std::shared_ptr<std::vector<uint8_t>> data;     // 编码后的图片数据
+        double queue_ms = 0.0;                          // 排队耗时
+        double encode_ms = 0.0;                         // 转换+编码+写文件耗时
+        std::string error;
+    };
+
+    using CompletionCallback = std::function<void(const Result&)>;
+
+    /**
+     * @brief 截图请求
+     */
+    struct Request {
+        ffmpeg::AVFrameSharedPtr frame;     // 待编码的帧（只持有引用）
+        std::string path;                   // 输出文件，为空时只在回调中返回编码数据
+        ImageFormat format;                 // 输出格式
+        int stream_id;                      // 所属流，用于限流和取消
+        CompletionCallback callback;        // 完成回调（工作线程中调用）
+
+        Request()
+            : format(ImageFormat::JPEG)
+            , stream_id(0)
+        {}
+    };
+
+    /**
+     * @brief 服务配置
+     */
+    struct Config {
+        int worker_count;                   // 编码线程数
+        size_t max_pending;                 // 全局最大待处理数
+        size_t max_pending_per_stream;      // 单路流最大待处理数
+        int jpeg_quality;                   // JPEG质量（1~100）
+        int png_compression;                // PNG压缩级别（0~9），截图优先速度
+
+        Config()
+            : worker_count(2)
+            , max_pending(64)
+            , max_pending_per_stream(8)
+            , jpeg_quality(90)
+            , png_compression(3)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t submitted;         // 接受的请求数
+        uint64_t completed;         // 成功完成数
+        uint64_t failed;            // 编码或写文件失败数
+        uint64_t rejected;          // 队列满被拒绝数
+        uint64_t cancelled;         // 被取消数
+        uint64_t bytes_encoded;     // 编码输出总字节数
+        double avg_encode_ms;       // 平均编码耗时
+        double max_queue_ms;        // 最大排队耗时
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> cancelled{0};
+        std::atomic<uint64_t> bytes_encoded{0};
+        std::atomic<double> total_encode_ms{0.0};
+        std::atomic<double> max_queue_ms{0.0};
+
+        StatisticsSnapshot getSnapshot() const {
+            const uint64_t done = completed.load();
+            return StatisticsSnapshot{
+                submitted.load(),
+                done,
+                failed.load(),
+                rejected.load(),
+                cancelled.load(),
+                bytes_encoded.load(),
+                done > 0 ? total_encode_ms.load() / done : 0.0,
+                max_queue_ms.load()
+            };
+        }
+    };
+
+public:
+    /**
+     * @brief 进程内共享的截图服务（多路播放共用一组编码线程）
+     */
+    static SnapshotService& instance();
+
+    explicit SnapshotService(const Config& config = Config{});
+    ~SnapshotService();
+
+    SnapshotService(const SnapshotService&) = delete;
+    SnapshotService& operator=(const SnapshotService&) = delete;
+
+    /**
+     * @brief 提交截图请求（任意线程，不阻塞）
+     * @return 请求id；帧无效、队列已满或服务已停止时返回0
+     */
+    uint64_t submit(Request request);
+
+    /**
+     * @brief 取消某一路的待处理请求，并等待其正在编码的请求完成
+     *
+     * 返回后不会再为该路调用回调，调用方可以安全销毁回调引用的对象。
+     * 被取消的请求不调用回调。
+     */
+    void cancel(int stream_id);
+
+    /**
+     * @brief 等待队列清空且没有正在编码的请求
+     * @return 超时返回false
+     */
+    bool waitIdle(int timeout_ms);
+
+    /**
+     * @brief 停止服务：丢弃待处理请求并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 当前待处理（含正在编码）的请求数
+     */
+    size_t pendingCount() const;
+
+    /**
+     * @brief 分配一个新的流id（用于限流和取消）
+     */
+    static int allocateStreamId();
+
+    /**
+     * @brief 按文件扩展名推断格式（.png为PNG，其余为JPEG）
+     */
+    static ImageFormat formatForPath(const std::string& path);
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+private:
+    struct PendingRequest {
+        uint64_t id = 0;
+        Request request;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    class Worker;
+
+    void workerLoop();
+
+private:
+    Config config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<PendingRequest> queue_;
+    std::unordered_map<int, size_t> pending_per_stream_;    // 含正在编码的请求
+    std::vector<int> active_streams_;                       // 正在编码的请求所属流（每个在编码的请求一项）
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> next_id_{1};
+    std::vector<std::thread> workers_;
+    mutable Statistics stats_;
+
+    // 性能浮层
+    Metric& encode_metric_;
+    Metric& pending_metric_;
+    Metric& rejected_metric_;
+};
+
+} // namespace media
+
+#endif // SNAPSHOT_SERVICE_H
@@ -0,0 +1,1035 @@
+#include "loopback_media_server.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../demux/ffmpeg_demuxer.h"
+#include "../input/input_source.h"
+#include "../restream/restream_server.h"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+#include <libavutil/mem.h>
+}
+
+namespace media {
+
+namespace {
+
+// RTP包上限（含12字节头），低于常见MTU，交织帧的长度字段是16位
+constexpr int kRtpPacketSize = 1400;
+// rtp封装器的AVIO缓冲；每个包之后都会flush，一次回调正好是一个RTP/RTCP包
+constexpr int kAvioBufferSize = 64 * 1024;
+constexpr int kFirstPayloadType = 96;           // 动态负载类型，各流依次递增
+constexpr size_t kMaxRequestBytes = 8192;
+constexpr size_t kMaxClientBacklog = 8 * 1024 * 1024;
+constexpr int kMaxWaitMs = 100;
+
+std::string ffmpegError(const std::string& prefix, int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return prefix + error_buf;
+}
+
+std::string systemError(const std::string& prefix) {
+    return prefix + std::strerror(errno);
+}
+
+int64_t packetTimestamp(const AVPacket* packet) {
+    return packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+}
+
+bool parseAddress(const std::string& address, uint16_t port, sockaddr_in* out) {
+    std::memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    out->sin_port = htons(port);
+    return inet_pton(AF_INET, address.c_str(), &out->sin_addr) == 1;
+}
+
+/**
+ * @brief 找一个空闲的UDP端口：绑定到0由系统分配，读出后释放
+ */
+uint16_t pickUdpPort(const std::string& address) {
+    sockaddr_in socket_address;
+    if (!parseAddress(address, 0, &socket_address)) {
+        return 0;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    uint16_t port = 0;
+    socklen_t length = sizeof(socket_address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) == 0 &&
+        getsockname(fd, reinterpret_cast<sockaddr*>(&socket_address), &length) == 0) {
+        port = ntohs(socket_address.sin_port);
+    }
+    ::close(fd);
+    return port;
+}
+
+/**
+ * @brief 等待唤醒描述符或超时，唤醒后清零计数
+ */
+void waitWake(int wake_fd, int timeout_ms) {
+    pollfd entry{wake_fd, POLLIN, 0};
+    if (poll(&entry, 1, timeout_ms) > 0 && (entry.revents & POLLIN)) {
+        uint64_t value = 0;
+        (void)!read(wake_fd, &value, sizeof(value));
+    }
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+/**
+ * @brief rtsp://host:port/path?query中的path
+ */
+std::string uriPath(const std::string& uri) {
+    const size_t scheme = uri.find("://");
+    const size_t start = scheme == std::string::npos ? 0 : uri.find('/', scheme + 3);
+    if (start == std::string::npos) {
+        return "/";
+    }
+    const size_t end = uri.find('?', start);
+    return uri.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+} // namespace
+
+/**
+ * @brief 各协议的输出，只在服务线程里使用
+ */
+class LoopbackMediaServer::Output {
+public:
+    virtual ~Output() = default;
+
+    /**
+     * @brief 建立输出并开始监听
+     */
+    virtual bool open(const FFmpegDemuxer& demuxer, const std::vector<SourceStream>& streams) = 0;
+
+    /**
+     * @brief 发送一个数据包（时间戳在输入流的时间基下，已加上循环偏移）
+     * @param slot 在所选流中的下标
+     */
+    virtual bool write(const AVPacket* packet, size_t slot) = 0;
+
+    /**
+     * @brief 等待timeout_ms或被唤醒，期间处理套接字事件
+     */
+    virtual void wait(int timeout_ms, int wake_fd) {
+        waitWake(wake_fd, timeout_ms);
+    }
+
+    virtual void close() = 0;
+
+    uint16_t port() const { return port_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    uint16_t port_ = 0;
+    std::string error_;
+};
+
+/**
+ * @brief HTTP-TS：直接交给RestreamServer
+ */
+class LoopbackMediaServer::HttpOutput : public LoopbackMediaServer::Output {
+public:
+    explicit HttpOutput(const Config& config) {
+        RestreamServer::Config server_config;
+        server_config.bind_address = config.bind_address;
+        server_config.port = config.port;
+        server_config.path = config.path;
+        server_ = std::make_unique<RestreamServer>(server_config);
+    }
+
+    bool open(const FFmpegDemuxer& demuxer, const std::vector<SourceStream>& streams) override {
+        for (const SourceStream& stream : streams) {
+            if (!server_->addStream(stream.input_index, demuxer.getCodecParameters(stream.input_index),
+                                    stream.time_base)) {
+                error_ = server_->getLastError();
+                return false;
+            }
+        }
+        if (!server_->start()) {
+            error_ = server_->getLastError();
+            return false;
+        }
+        port_ = server_->port();
+        return true;
+    }
+
+    bool write(const AVPacket* packet, size_t /*slot*/) override {
+        if (!server_->writePacket(packet)) {
+            error_ = server_->getLastError();
+            return false;
+        }
+        return true;
+    }
+
+    void close() override {
+        server_->stop();
+    }
+
+private:
+    std::unique_ptr<RestreamServer> server_;
+};
+
+/**
+ * @brief UDP-TS：mpegts封装直接写udp://，接收端先绑定端口再打开
+ */
+class LoopbackMediaServer::UdpOutput : public LoopbackMediaServer::Output {
+public:
+    explicit UdpOutput(const Config& config)
+        : config_(config) {}
+
+    ~UdpOutput() override {
+        close();
+    }
+
+    bool open(const FFmpegDemuxer& demuxer, const std::vector<SourceStream>& streams) override {
+        port_ = config_.port != 0 ? config_.port : pickUdpPort(config_.bind_address);
+        if (port_ == 0) {
+            error_ = "找不到空闲的UDP端口";
+            return false;
+        }
+        // 每个数据报7个TS包（1316字节），与常见的组播源一致
+        const std::string url = "udp://" + config_.bind_address + ":" + std::to_string(port_) + "?pkt_size=1316";
+        int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, "mpegts", url.c_str());
+        if (ret < 0 || !format_ctx_) {
+            error_ = ffmpegError("创建复用器失败: ", ret);
+            return false;
+        }
+        for (const SourceStream& source : streams) {
+            AVStream* stream = avformat_new_stream(format_ctx_, nullptr);
+            const AVCodecParameters* codecpar = demuxer.getCodecParameters(source.input_index);
+            if (!stream || !codecpar || avcodec_parameters_copy(stream->codecpar, codecpar) < 0) {
+                error_ = "创建输出流失败";
+                return false;
+            }
+            stream->codecpar->codec_tag = 0;
+            stream->time_base = source.time_base;
+            time_bases_.push_back(source.time_base);
+        }
+        ret = avio_open(&format_ctx_->pb, url.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            error_ = ffmpegError("打开UDP输出失败: ", ret);
+            return false;
+        }
+        ret = avformat_write_header(format_ctx_, nullptr);
+        if (ret < 0) {
+            error_ = ffmpegError("写入TS头失败: ", ret);
+            return false;
+        }
+        header_written_ = true;
+        packet_ = av_packet_alloc();
+        return packet_ != nullptr;
+    }
+
+    bool write(const AVPacket* packet, size_t slot) override {
+        if (av_packet_ref(packet_, packet) < 0) {
+            error_ = "复制数据包失败";
+            return false;
+        }
+        AVStream* stream = format_ctx_->streams[slot];
+        packet_->stream_index = stream->index;
+        av_packet_rescale_ts(packet_, time_bases_[slot], stream->time_base);
+        packet_->pos = -1;
+        const int ret = av_write_frame(format_ctx_, packet_);
+        av_packet_unref(packet_);
+        if (ret < 0) {
+            error_ = ffmpegError("复用失败: ", ret);
+            return false;
+        }
+        return true;
+    }
+
+    void close() override {
+        if (!format_ctx_) {
+            return;
+        }
+        if (header_written_) {
+            av_write_trailer(format_ctx_);
+            header_written_ = false;
+        }
+        if (format_ctx_->pb) {
+            avio_closep(&format_ctx_->pb);
+        }
+        avformat_free_context(format_ctx_);
+        format_ctx_ = nullptr;
+        av_packet_free(&packet_);
+    }
+
+private:
+    const Config& config_;
+    AVFormatContext* format_ctx_ = nullptr;
+    std::vector<AVRational> time_bases_;
+    AVPacket* packet_ = nullptr;
+    bool header_written_ = false;
+};
+
+/**
+ * @brief 最小RTSP服务端：OPTIONS/DESCRIBE/SETUP/PLAY/PAUSE/TEARDOWN，只支持RTP/AVP/TCP交织
+ *
+ * 每路流一个rtp封装器，打包出的RTP/RTCP包加上交织头追加到所有PLAY中的客户端的发送积压里；
+ * 客户端先请求UDP传输时回复461，FFmpeg等客户端会改用TCP重试。
+ */
+class LoopbackMediaServer::RtspOutput : public LoopbackMediaServer::Output {
+public:
+    RtspOutput(const Config& config, Statistics& stats)
+        : config_(config), stats_(stats) {}
+
+    ~RtspOutput() override {
+        close();
+    }
+
+    bool open(const FFmpegDemuxer& demuxer, const std::vector<SourceStream>& streams) override {
+        if (!listen()) {
+            return false;
+        }
+        url_ = "rtsp://" + config_.bind_address + ":" + std::to_string(port_) + config_.path;
+
+        for (size_t slot = 0; slot < streams.size(); ++slot) {
+            auto rtp = std::make_unique<RtpStream>();
+            rtp->owner = this;
+            rtp->slot = slot;
+            rtp->time_base = streams[slot].time_base;
+            const bool opened = openRtpMuxer(*rtp, demuxer.getCodecParameters(streams[slot].input_index));
+            rtp_streams_.push_back(std::move(rtp));
+            if (!opened) {
+                return false;
+            }
+        }
+
+        // SDP由各流的rtp封装器生成，负载类型与实际发送的一致
+        std::vector<AVFormatContext*> contexts;
+        for (const auto& rtp : rtp_streams_) {
+            contexts.push_back(rtp->format_ctx);
+        }
+        char sdp[16384];
+        const int ret = av_sdp_create(contexts.data(), static_cast<int>(contexts.size()), sdp, sizeof(sdp));
+        if (ret < 0) {
+            error_ = ffmpegError("生成SDP失败: ", ret);
+            return false;
+        }
+        sdp_ = sdp;
+
+        packet_ = av_packet_alloc();
+        return packet_ != nullptr;
+    }
+
+    bool write(const AVPacket* packet, size_t slot) override {
+        RtpStream& rtp = *rtp_streams_[slot];
+        if (av_packet_ref(packet_, packet) < 0) {
+            error_ = "复制数据包失败";
+            return false;
+        }
+        AVStream* stream = rtp.format_ctx->streams[0];
+        packet_->stream_index = 0;
+        av_packet_rescale_ts(packet_, rtp.time_base, stream->time_base);
+        packet_->pos = -1;
+        const int ret = av_write_frame(rtp.format_ctx, packet_);
+        av_packet_unref(packet_);
+        if (ret < 0) {
+            error_ = ffmpegError("RTP打包失败: ", ret);
+            return false;
+        }
+        flushClients();
+        return true;
+    }
+
+    void wait(int timeout_ms, int wake_fd) override {
+        std::vector<pollfd> fds;
+        fds.reserve(clients_.size() + 2);
+        fds.push_back({wake_fd, POLLIN, 0});
+        fds.push_back({listen_fd_, POLLIN, 0});
+        for (const auto& entry : clients_) {
+            const bool pending = entry.second.sent < entry.second.backlog.size();
+            fds.push_back({entry.first, static_cast<short>(POLLIN | (pending ? POLLOUT : 0)), 0});
+        }
+
+        if (poll(fds.data(), fds.size(), timeout_ms) > 0) {
+            if (fds[0].revents & POLLIN) {
+                uint64_t value = 0;
+                (void)!read(wake_fd, &value, sizeof(value));
+            }
+            if (fds[1].revents & POLLIN) {
+                acceptClients();
+            }
+            for (size_t i = 2; i < fds.size(); ++i) {
+                auto it = clients_.find(fds[i].fd);
+                if (it == clients_.end()) {
+                    continue;
+                }
+                if (fds[i].revents & POLLIN) {
+                    readRequests(it->first, it->second);
+                } else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    dropClient(it->second);
+                }
+            }
+        }
+        flushClients();
+    }
+
+    void close() override {
+        for (auto& entry : clients_) {
+            ::close(entry.first);
+        }
+        clients_.clear();
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+        }
+        for (auto& rtp : rtp_streams_) {
+            if (!rtp->format_ctx) {
+                continue;
+            }
+            if (rtp->header_written) {
+                av_write_trailer(rtp->format_ctx);
+            }
+            if (rtp->format_ctx->pb) {
+                av_freep(&rtp->format_ctx->pb->buffer);
+                avio_context_free(&rtp->format_ctx->pb);
+            }
+            avformat_free_context(rtp->format_ctx);
+            rtp->format_ctx = nullptr;
+        }
+        rtp_streams_.clear();
+        av_packet_free(&packet_);
+    }
+
+private:
+    struct RtpStream {
+        RtspOutput* owner = nullptr;
+        size_t slot = 0;
+        AVRational time_base = {0, 1};      // 输入时间基
+        AVFormatContext* format_ctx = nullptr;
+        bool header_written = false;
+    };
+
+    struct Client {
+        std::string request;                // 未处理完的请求字节
+        std::string backlog;                // 待发送：信令响应和交织的RTP包
+        size_t sent = 0;                    // backlog中已发送的字节
+        std::string session;
+        std::vector<int> channels;          // 每路流的RTP交织通道（RTCP为其后一个），-1为未SETUP
+        bool playing = false;
+        bool closing = false;               // 发完积压后关闭
+    };
+
+    bool listen() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            error_ = systemError("创建监听套接字失败: ");
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address;
+        if (!parseAddress(config_.bind_address, config_.port, &address)) {
+            error_ = "无效的监听地址 " + config_.bind_address;
+            return false;
+        }
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            ::listen(listen_fd_, SOMAXCONN) < 0) {
+            error_ = systemError("监听失败: ");
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        return true;
+    }
+
+    bool openRtpMuxer(RtpStream& rtp, const AVCodecParameters* codecpar) {
+        // 地址用rtsp://：av_sdp_create不会从中解析端口，每路流写a=control:streamid=N
+        int ret = avformat_alloc_output_context2(&rtp.format_ctx, nullptr, "rtp", url_.c_str());
+        if (ret < 0 || !rtp.format_ctx) {
+            error_ = ffmpegError("创建RTP封装器失败: ", ret);
+            return false;
+        }
+        AVStream* stream = avformat_new_stream(rtp.format_ctx, nullptr);
+        if (!stream || !codecpar || avcodec_parameters_copy(stream->codecpar, codecpar) < 0) {
+            error_ = "创建RTP流失败";
+            return false;
+        }
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = rtp.time_base;
+
+        auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+        AVIOContext* pb = buffer ? avio_alloc_context(buffer, kAvioBufferSize, 1, &rtp, nullptr,
+                                                      &RtspOutput::rtpCallback, nullptr) : nullptr;
+        if (!pb) {
+            av_free(buffer);
+            error_ = "分配AVIO上下文失败";
+            return false;
+        }
+        pb->seekable = 0;
+        pb->max_packet_size = kRtpPacketSize;
+        rtp.format_ctx->pb = pb;
+        rtp.format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+        AVDictionary* options = nullptr;
+        av_dict_set_int(&options, "payload_type", kFirstPayloadType + static_cast<int>(rtp.slot), 0);
+        ret = avformat_write_header(rtp.format_ctx, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            error_ = ffmpegError("RTP封装器不支持该编码: ", ret);
+            return false;
+        }
+        rtp.header_written = true;
+        return true;
+    }
+
+    static int rtpCallback(void* opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                           const uint8_t* buf,
+#else
+                           uint8_t* buf,
+#endif
+                           int size) {
+        auto* rtp = static_cast<RtpStream*>(opaque);
+        rtp->owner->broadcast(*rtp, buf, size);
+        return size;
+    }
+
+    void broadcast(const RtpStream& rtp, const uint8_t* data, int size) {
+        if (size <= 0 || size > 0xFFFF) {
+            return;
+        }
+        stats_.rtp_packets++;
+        // RTCP（SR/SDES/BYE，包类型200~204）走RTP通道的下一个通道
+        const bool rtcp = size >= 2 && data[1] >= 200 && data[1] <= 204;
+        for (auto& entry : clients_) {
+            Client& client = entry.second;
+            if (!client.playing || client.closing || client.channels[rtp.slot] < 0) {
+                continue;
+            }
+            if (client.backlog.size() - client.sent + static_cast<size_t>(size) + 4 > kMaxClientBacklog) {
+                // 客户端读得太慢：断开它，不拖慢其他客户端
+                stats_.clients_dropped++;
+                dropClient(client);
+                continue;
+            }
+            const char header[4] = {
+                '$',
+                static_cast<char>(client.channels[rtp.slot] + (rtcp ? 1 : 0)),
+                static_cast<char>((size >> 8) & 0xFF),
+                static_cast<char>(size & 0xFF)
+            };
+            client.backlog.append(header, sizeof(header));
+            client.backlog.append(reinterpret_cast<const char*>(data), static_cast<size_t>(size));
+        }
+    }
+
+    void acceptClients() {
+        for (;;) {
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            int nodelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+            Client client;
+            client.channels.assign(rtp_streams_.size(), -1);
+            clients_[fd] = std::move(client);
+        }
+    }
+
+    void dropClient(Client& client) {
+        client.closing = true;
+        client.backlog.clear();
+        client.sent = 0;
+    }
+
+    void readRequests(int fd, Client& client) {
+        char buffer[4096];
+        for (;;) {
+            const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                client.request.append(buffer, static_cast<size_t>(received));
+                continue;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                dropClient(client);
+                return;
+            }
+            break;
+        }
+
+        while (!client.closing && !client.request.empty()) {
+            // 客户端在TCP通道里发回的交织RTCP接收报告，直接丢弃
+            if (client.request[0] == '$') {
+                if (client.request.size() < 4) {
+                    break;
+                }
+                const size_t length = 4 + ((static_cast<uint8_t>(client.request[2]) << 8) |
+                                           static_cast<uint8_t>(client.request[3]));
+                if (client.request.size() < length) {
+                    break;
+                }
+                client.request.erase(0, length);
+                continue;
+            }
+
+            const size_t header_end = client.request.find("\r\n\r\n");
+            if (header_end == std::string::npos) {
+                if (client.request.size() > kMaxRequestBytes) {
+                    dropClient(client);
+                }
+                break;
+            }
+            const std::string head = client.request.substr(0, header_end + 4);
+            const std::map<std::string, std::string> headers = parseHeaders(head);
+            auto content_length = headers.find("content-length");
+            const size_t body = content_length == headers.end()
+                                    ? 0 : static_cast<size_t>(std::strtoul(content_length->second.c_str(), nullptr, 10));
+            if (client.request.size() < header_end + 4 + body) {
+                break;
+            }
+            client.request.erase(0, header_end + 4 + body);
+            handleRequest(client, head, headers);
+        }
+    }
+
+    static std::map<std::string, std::string> parseHeaders(const std::string& head) {
+        std::map<std::string, std::string> headers;
+        size_t line_start = head.find("\r\n");
+        while (line_start != std::string::npos && line_start + 2 < head.size()) {
+            line_start += 2;
+            const size_t line_end = head.find("\r\n", line_start);
+            if (line_end == std::string::npos || line_end == line_start) {
+                break;
+            }
+            const std::string line = head.substr(line_start, line_end - line_start);
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                const size_t value = line.find_first_not_of(' ', colon + 1);
+                headers[toLower(line.substr(0, colon))] = value == std::string::npos ? "" : line.substr(value);
+            }
+            line_start = line_end;
+        }
+        return headers;
+    }
+
+    void handleRequest(Client& client, const std::string& head, const std::map<std::string, std::string>& headers) {
+        const size_t method_end = head.find(' ');
+        const size_t uri_end = method_end == std::string::npos ? std::string::npos : head.find(' ', method_end + 1);
+        if (uri_end == std::string::npos) {
+            dropClient(client);
+            return;
+        }
+        const std::string method = head.substr(0, method_end);
+        const std::string uri = head.substr(method_end + 1, uri_end - method_end - 1);
+        auto cseq = headers.find("cseq");
+
+        auto reply = [&](const std::string& status, const std::string& extra_headers, const std::string& body) {
+            std::string response = "RTSP/1.0 " + status + "\r\n";
+            response += "CSeq: " + (cseq == headers.end() ? std::string("0") : cseq->second) + "\r\n";
+            response += "Server: LoopbackMediaServer\r\n";
+            if (!client.session.empty()) {
+                response += "Session: " + client.session + ";timeout=60\r\n";
+            }
+            response += extra_headers;
+            if (!body.empty()) {
+                response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+            }
+            client.backlog += response + "\r\n" + body;
+        };
+
+        const std::string path = uriPath(uri);
+        const bool stream_path = path.compare(0, config_.path.size(), config_.path) == 0;
+
+        if (method == "OPTIONS") {
+            reply("200 OK", "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n", "");
+        } else if (method == "DESCRIBE") {
+            if (!stream_path) {
+                reply("404 Not Found", "", "");
+                return;
+            }
+            reply("200 OK", "Content-Base: " + url_ + "/\r\nContent-Type: application/sdp\r\n", sdp_);
+        } else if (method == "SETUP") {
+            const size_t id = uri.find("streamid=");
+            const size_t slot = id == std::string::npos ? rtp_streams_.size()
+                                                        : std::strtoul(uri.c_str() + id + 9, nullptr, 10);
+            if (!stream_path || slot >= rtp_streams_.size()) {
+                reply("404 Not Found", "", "");
+                return;
+            }
+            auto transport = headers.find("transport");
+            if (transport == headers.end() || transport->second.find("RTP/AVP/TCP") == std::string::npos) {
+                reply("461 Unsupported Transport", "", "");
+                return;
+            }
+            int channel = static_cast<int>(slot) * 2;
+            const size_t interleaved = transport->second.find("interleaved=");
+            if (interleaved != std::string::npos) {
+                channel = std::atoi(transport->second.c_str() + interleaved + 12);
+            }
+            client.channels[slot] = channel;
+            if (client.session.empty()) {
+                client.session = std::to_string(++session_counter_ * 7919 + port_);
+            }
+            reply("200 OK", "Transport: RTP/AVP/TCP;unicast;interleaved=" + std::to_string(channel) + "-" +
+                            std::to_string(channel + 1) + "\r\n", "");
+        } else if (method == "PLAY") {
+            if (client.session.empty()) {
+                reply("455 Method Not Valid in This State", "", "");
+                return;
+            }
+            // 先排响应再置位，之后打包出的RTP包都排在响应后面
+            reply("200 OK", "Range: npt=now-\r\n", "");
+            if (!client.playing) {
+                client.playing = true;
+                stats_.rtsp_sessions++;
+            }
+        } else if (method == "PAUSE") {
+            client.playing = false;
+            reply("200 OK", "", "");
+        } else if (method == "GET_PARAMETER" || method == "SET_PARAMETER") {
+            reply("200 OK", "", "");
+        } else if (method == "TEARDOWN") {
+            reply("200 OK", "", "");
+            client.playing = false;
+            client.closing = true;
+        } else {
+            reply("501 Not Implemented", "", "");
+        }
+    }
+
+    void flushClients() {
+        for (auto it = clients_.begin(); it != clients_.end();) {
+            Client& client = it->second;
+            bool alive = true;
+            while (client.sent < client.backlog.size()) {
+                const ssize_t sent = send(it->first, client.backlog.data() + client.sent,
+                                          client.backlog.size() - client.sent, MSG_NOSIGNAL);
+                if (sent > 0) {
+                    client.sent += static_cast<size_t>(sent);
+                    continue;
+                }
+                if (sent < 0 && errno == EINTR) {
+                    continue;
+                }
+                alive = sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                break;
+            }
+            // 发完清空；积压较多时把已发送部分挪掉，避免缓冲无限增长
+            if (client.sent == client.backlog.size()) {
+                client.backlog.clear();
+                client.sent = 0;
+            } else if (client.sent > kAvioBufferSize) {
+                client.backlog.erase(0, client.sent);
+                client.sent = 0;
+            }
+
+            if (!alive || (client.closing && client.backlog.empty())) {
+                ::close(it->first);
+                it = clients_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    const Config& config_;
+    Statistics& stats_;
+    std::string url_;
+    std::string sdp_;
+    int listen_fd_ = -1;
+    std::map<int, Client> clients_;
+    std::vector<std::unique_ptr<RtpStream>> rtp_streams_;
+    AVPacket* packet_ = nullptr;
+    uint64_t session_counter_ = 0;
+};
+
+LoopbackMediaServer::LoopbackMediaServer(const Config& config)
+    : config_(config) {
+}
+
+LoopbackMediaServer::~LoopbackMediaServer() {
+    stop();
+}
+
+bool LoopbackMediaServer::start(const std::string& media_path) {
+    if (running_.load()) {
+        setError("服务已在运行");
+        return false;
+    }
+
+    input_ = InputSourceFactory::create(media_path);
+    if (!input_ || !input_->open(media_path)) {
+        setError("无法打开输入 " + media_path);
+        closeInput();
+        return false;
+    }
+    demuxer_ = std::make_unique<FFmpegDemuxer>();
+    if (!demuxer_->initialize(input_)) {
+        setError(demuxer_->getLastError());
+        closeInput();
+        return false;
+    }
+
+    // 与RestreamServer::initialize一致：各取第一个视频流和音频流
+    streams_.clear();
+    bool has_video = false;
+    bool has_audio = false;
+    for (const StreamInfo& info : demuxer_->getStreamInfos()) {
+        if ((info.isVideo() && !has_video) || (info.isAudio() && !has_audio)) {
+            streams_.push_back(SourceStream{info.index, info.time_base});
+            has_video = has_video || info.isVideo();
+            has_audio = has_audio || info.isAudio();
+        }
+    }
+    if (streams_.empty()) {
+        setError("没有可发送的音视频流");
+        closeInput();
+        return false;
+    }
+
+    switch (config_.protocol) {
+    case Protocol::Udp:
+        output_ = std::make_unique<UdpOutput>(config_);
+        break;
+    case Protocol::Rtsp:
+        output_ = std::make_unique<RtspOutput>(config_, stats_);
+        break;
+    case Protocol::Http:
+    default:
+        output_ = std::make_unique<HttpOutput>(config_);
+        break;
+    }
+    if (!output_->open(*demuxer_, streams_)) {
+        setError(output_->error());
+        output_->close();
+        output_.reset();
+        closeInput();
+        return false;
+    }
+    port_ = output_->port();
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        setError(systemError("创建eventfd失败: "));
+        output_->close();
+        output_.reset();
+        closeInput();
+        return false;
+    }
+
+    pass_has_packets_ = false;
+    loop_offset_us_ = 0;
+    running_.store(true);
+    thread_ = std::thread(&LoopbackMediaServer::serveLoop, this);
+    return true;
+}
+
+void LoopbackMediaServer::stop() {
+    if (running_.exchange(false) && wake_fd_ >= 0) {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (output_) {
+        output_->close();
+        output_.reset();
+    }
+    closeInput();
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+}
+
+std::string LoopbackMediaServer::url() const {
+    const std::string host = config_.bind_address + ":" + std::to_string(port_);
+    switch (config_.protocol) {
+    case Protocol::Udp:
+        return "udp://" + host;
+    case Protocol::Rtsp:
+        return "rtsp://" + host + config_.path;
+    case Protocol::Http:
+    default:
+        return "http://" + host + config_.path;
+    }
+}
+
+std::string LoopbackMediaServer::getLastError() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+const char* LoopbackMediaServer::protocolName(Protocol protocol) {
+    switch (protocol) {
+    case Protocol::Udp:
+        return "udp";
+    case Protocol::Rtsp:
+        return "rtsp";
+    case Protocol::Http:
+    default:
+        return "http";
+    }
+}
+
+bool LoopbackMediaServer::parseProtocol(const std::string& name, Protocol* protocol) {
+    if (!protocol) {
+        return false;
+    }
+    if (name == "http") {
+        *protocol = Protocol::Http;
+    } else if (name == "udp") {
+        *protocol = Protocol::Udp;
+    } else if (name == "rtsp") {
+        *protocol = Protocol::Rtsp;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void LoopbackMediaServer::serveLoop() {
+    AVPacket* packet = av_packet_alloc();
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsedUs = [&start]() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    bool pending = false;
+    bool finished = false;
+    size_t slot = 0;
+    int64_t first_us = AV_NOPTS_VALUE;
+    int64_t due_us = 0;             // 相对起点的发送时刻
+
+    while (packet && running_.load()) {
+        if (!pending && !finished) {
+            if (readNext(packet, &slot)) {
+                const int64_t ts_us = av_rescale_q(packetTimestamp(packet), streams_[slot].time_base, AV_TIME_BASE_Q);
+                if (first_us == AV_NOPTS_VALUE) {
+                    first_us = ts_us;
+                }
+                due_us = config_.rate > 0.0 ? static_cast<int64_t>((ts_us - first_us) / config_.rate) : 0;
+                pending = true;
+            } else {
+                // 不循环时读完就只保留连接，客户端自己断开
+                if (!demuxer_->isEndOfStream()) {
+                    setError(demuxer_->getLastError());
+                }
+                finished = true;
+            }
+        }
+
+        int wait_ms = kMaxWaitMs;
+        if (pending) {
+            wait_ms = static_cast<int>(std::min<int64_t>(kMaxWaitMs, std::max<int64_t>(0, (due_us - elapsedUs() + 999) / 1000)));
+        }
+        output_->wait(wait_ms, wake_fd_);
+        if (!pending || !running_.load() || elapsedUs() < due_us) {
+            continue;
+        }
+
+        const int size = packet->size;
+        const bool written = output_->write(packet, slot);
+        av_packet_unref(packet);
+        pending = false;
+        if (!written) {
+            setError(output_->error());
+            running_.store(false);
+            break;
+        }
+        stats_.packets_sent++;
+        stats_.bytes_sent += static_cast<uint64_t>(size);
+    }
+    av_packet_free(&packet);
+}
+
+bool LoopbackMediaServer::readNext(AVPacket* packet, size_t* slot) {
+    for (;;) {
+        if (!demuxer_->readPacket(packet)) {
+            if (!config_.loop || !demuxer_->isEndOfStream() || !pass_has_packets_) {
+                return false;
+            }
+            // 下一遍接在这一遍最晚结束的包之后，每路流的时间戳都保持单调
+            loop_offset_us_ += pass_end_us_ - pass_start_us_;
+            pass_has_packets_ = false;
+            if (!demuxer_->seekToTime(0)) {
+                return false;
+            }
+            stats_.loops++;
+            continue;
+        }
+
+        auto stream = std::find_if(streams_.begin(), streams_.end(), [packet](const SourceStream& s) {
+            return s.input_index == packet->stream_index;
+        });
+        const int64_t ts = packetTimestamp(packet);
+        if (stream == streams_.end() || ts == AV_NOPTS_VALUE) {
+            stats_.packets_skipped++;
+            av_packet_unref(packet);
+            continue;
+        }
+
+        // 没有时长的包按一个时间基单位算，保证下一遍的第一个包严格晚于这一遍的最后一个
+        const AVRational time_base = stream->time_base;
+        const int64_t ts_us = av_rescale_q(ts, time_base, AV_TIME_BASE_Q);
+        const int64_t duration_us = av_rescale_q_rnd(std::max<int64_t>(packet->duration, 1), time_base, AV_TIME_BASE_Q,
+                                                     AV_ROUND_UP);
+        if (!pass_has_packets_) {
+            pass_start_us_ = ts_us;
+            pass_end_us_ = ts_us + duration_us;
+            pass_has_packets_ = true;
+        } else {
+            pass_start_us_ = std::min(pass_start_us_, ts_us);
+            pass_end_us_ = std::max(pass_end_us_, ts_us + duration_us);
+        }
+
+        const int64_t offset = av_rescale_q_rnd(loop_offset_us_, AV_TIME_BASE_Q, time_base, AV_ROUND_UP);
+        if (packet->pts != AV_NOPTS_VALUE) {
+            packet->pts += offset;
+        }
+        if (packet->dts != AV_NOPTS_VALUE) {
+            packet->dts += offset;
+        }
+        *slot = static_cast<size_t>(stream - streams_.begin());
+        return true;
+    }
+}
+
+void LoopbackMediaServer::closeInput() {
+    demuxer_.reset();
+    if (input_) {
+        input_->close();
+        input_.reset();
+    }
+}
+
+void LoopbackMediaServer::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    last_error_ = error;
+}
+
+} // namespace media
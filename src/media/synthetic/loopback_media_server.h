@@ -0,0 +1,182 @@
+#ifndef LOOPBACK_MEDIA_SERVER_H
+#define LOOPBACK_MEDIA_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace media {
+
+class FFmpegDemuxer;
+class IInputSource;
+
+/**
+ * @brief 回环媒体服务：把本地文件当作直播流，以HTTP-TS、UDP-TS或RTSP发布在127.0.0.1上
+ *
+ * 设计特点：
+ * 1. 复用现有组件：HTTP直接用RestreamServer（与真实转发同一条路径），UDP用mpegts封装写udp://，
+ *    RTSP是只支持TCP交织传输的最小服务端，RTP打包用FFmpeg的rtp封装器，SDP由av_sdp_create生成
+ * 2. 单线程：读包、按时间戳控制节奏、RTSP信令和发送都在一个线程，poll等到下一个包的发送时刻或套接字事件
+ * 3. 循环播放：读到文件尾后seek回开头，时间戳按上一遍的时长累加，客户端看到一条无限长、时间戳单调的直播流
+ * 4. 可调节奏：rate为1按实时速度发送，大于1加速；0为尽快发送，只适合有背压的TCP协议（HTTP/RTSP）
+ *
+ * 与SyntheticMediaGenerator配合，输入、解封装和解码基准可以在没有外部服务的机器上复现网络输入。
+ * start/stop在同一个线程调用；统计可在任意线程读取。
+ */
+class LoopbackMediaServer {
+public:
+    enum class Protocol {
+        Http,   // HTTP上的MPEG-TS（RestreamServer）
+        Udp,    // UDP上的MPEG-TS，每个数据报7个TS包
+        Rtsp    // RTSP + RTP/AVP/TCP交织
+    };
+
+    /**
+     * @brief 服务配置
+     */
+    struct Config {
+        Protocol protocol;
+        std::string bind_address;
+        uint16_t port;              // 0为系统分配（start后用port()读取）
+        std::string path;           // HTTP/RTSP的流地址路径
+        double rate;                // 发送速度倍数，0为尽快发送
+        bool loop;                  // 读到文件尾后从头循环
+
+        Config()
+            : protocol(Protocol::Http)
+            , bind_address("127.0.0.1")
+            , port(0)
+            , path("/stream")
+            , rate(1.0)
+            , loop(true)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t packets_sent;          // 交给输出的数据包
+        uint64_t bytes_sent;            // 数据包负载字节
+        uint64_t packets_skipped;       // 没有时间戳或不是所选音视频流
+        uint64_t loops;                 // 从头重新播放的次数
+        uint64_t rtsp_sessions;         // RTSP：收到PLAY的会话
+        uint64_t rtp_packets;           // RTSP：打包出的RTP/RTCP包
+        uint64_t clients_dropped;       // RTSP：发送积压超限被断开的客户端
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> packets_sent{0};
+        std::atomic<uint64_t> bytes_sent{0};
+        std::atomic<uint64_t> packets_skipped{0};
+        std::atomic<uint64_t> loops{0};
+        std::atomic<uint64_t> rtsp_sessions{0};
+        std::atomic<uint64_t> rtp_packets{0};
+        std::atomic<uint64_t> clients_dropped{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                packets_sent.load(),
+                bytes_sent.load(),
+                packets_skipped.load(),
+                loops.load(),
+                rtsp_sessions.load(),
+                rtp_packets.load(),
+                clients_dropped.load()
+            };
+        }
+    };
+
+public:
+    explicit LoopbackMediaServer(const Config& config = Config{});
+    ~LoopbackMediaServer();
+
+    LoopbackMediaServer(const LoopbackMediaServer&) = delete;
+    LoopbackMediaServer& operator=(const LoopbackMediaServer&) = delete;
+
+    /**
+     * @brief 打开文件（取第一个视频流和第一个音频流），开始监听并发送
+     */
+    bool start(const std::string& media_path);
+
+    /**
+     * @brief 停止发送，断开所有客户端
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(); }
+
+    /**
+     * @brief 实际端口（start之后有效）
+     */
+    uint16_t port() const { return port_; }
+
+    /**
+     * @brief 客户端使用的地址，如rtsp://127.0.0.1:8554/stream
+     */
+    std::string url() const;
+
+    const Config& config() const { return config_; }
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+    std::string getLastError() const;
+
+    static const char* protocolName(Protocol protocol);
+    static bool parseProtocol(const std::string& name, Protocol* protocol);
+
+private:
+    class Output;
+    class HttpOutput;
+    class UdpOutput;
+    class RtspOutput;
+
+    /**
+     * @brief 输出流对应的输入流
+     */
+    struct SourceStream {
+        int input_index = -1;
+        AVRational time_base = {0, 1};
+    };
+
+    void serveLoop();
+    bool readNext(AVPacket* packet, size_t* slot);
+    void closeInput();
+    void setError(const std::string& error);
+
+private:
+    Config config_;
+    uint16_t port_ = 0;
+
+    std::shared_ptr<IInputSource> input_;
+    std::unique_ptr<FFmpegDemuxer> demuxer_;
+    std::vector<SourceStream> streams_;
+    std::unique_ptr<Output> output_;
+
+    // 循环播放：每一遍的时间戳范围和累计偏移（微秒）
+    int64_t pass_start_us_ = 0;
+    int64_t pass_end_us_ = 0;
+    bool pass_has_packets_ = false;
+    int64_t loop_offset_us_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int wake_fd_ = -1;
+
+    mutable std::mutex error_mutex_;
+    std::string last_error_;
+    Statistics stats_;
+};
+
+} // namespace media
+
+#endif // LOOPBACK_MEDIA_SERVER_H
@@ -0,0 +1,463 @@
+#include "synthetic_media.h"
+#include "synthetic_pattern.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+}
+
+namespace media {
+
+namespace {
+
+std::string avError(int errnum) {
+    char error_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, error_buf, sizeof(error_buf));
+    return error_buf;
+}
+
+// 各编码器最快但仍保留B帧和熵编码的预设，生成速度和解码负载之间取折中
+const char* defaultPreset(EncoderCodec codec) {
+    switch (codec) {
+    case EncoderCodec::H265:
+        return "ultrafast";
+    case EncoderCodec::AV1:
+        return "10";
+    case EncoderCodec::Mpeg4:
+        return "";
+    case EncoderCodec::H264:
+    default:
+        return "veryfast";
+    }
+}
+
+std::string formatNumber(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+bool fileExists(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file && file.tellg() > 0;
+}
+
+} // namespace
+
+int64_t SyntheticMediaGenerator::Spec::effectiveBitRate() const {
+    if (bit_rate > 0 || codec != EncoderCodec::Mpeg4) {
+        return bit_rate;
+    }
+    const double fps = frame_rate.den > 0 ? av_q2d(frame_rate) : 0.0;
+    return static_cast<int64_t>(0.1 * width * height * fps);
+}
+
+int64_t SyntheticMediaGenerator::Spec::frameCount() const {
+    if (frame_rate.num <= 0 || frame_rate.den <= 0 || duration_s <= 0.0) {
+        return 0;
+    }
+    return std::llround(duration_s * frame_rate.num / frame_rate.den);
+}
+
+std::string SyntheticMediaGenerator::Spec::name() const {
+    std::string name = std::string(codecName(codec)) + "_" + std::to_string(width) + "x" + std::to_string(height);
+    name += "_" + formatNumber(std::round(av_q2d(frame_rate) * 100.0) / 100.0) + "fps";
+    name += "_g" + std::to_string(gop_size) + "b" + std::to_string(gop_size <= 1 ? 0 : max_b_frames);
+    const int64_t rate = effectiveBitRate();
+    name += rate > 0 ? "_" + std::to_string(rate / 1000) + "k" : "_crf" + std::to_string(crf);
+    if (!preset.empty()) {
+        name += "_" + preset;
+    }
+    name += "_n" + std::to_string(noise) + "_" + formatNumber(duration_s) + "s";
+    if (audio) {
+        name += "_a" + std::to_string(sample_rate) + "x" + std::to_string(channels) + "_" +
+                formatNumber(tone_hz) + "hz_" + std::to_string(audio_bit_rate / 1000) + "k";
+    }
+    return name + "." + container;
+}
+
+std::vector<SyntheticMediaGenerator::Spec> SyntheticMediaGenerator::Matrix::expand() const {
+    // 某一维为空时沿用base里的值
+    const std::vector<EncoderCodec> codec_axis = codecs.empty() ? std::vector<EncoderCodec>{base.codec} : codecs;
+    const std::vector<std::pair<int, int>> resolution_axis =
+        resolutions.empty() ? std::vector<std::pair<int, int>>{{base.width, base.height}} : resolutions;
+    const std::vector<std::pair<int, int>> gop_axis =
+        gops.empty() ? std::vector<std::pair<int, int>>{{base.gop_size, base.max_b_frames}} : gops;
+    const std::vector<int64_t> rate_axis = bit_rates.empty() ? std::vector<int64_t>{base.bit_rate} : bit_rates;
+
+    std::vector<Spec> specs;
+    specs.reserve(codec_axis.size() * resolution_axis.size() * gop_axis.size() * rate_axis.size());
+    for (EncoderCodec codec : codec_axis) {
+        for (const auto& resolution : resolution_axis) {
+            for (const auto& gop : gop_axis) {
+                for (int64_t rate : rate_axis) {
+                    Spec spec = base;
+                    spec.codec = codec;
+                    spec.width = resolution.first;
+                    spec.height = resolution.second;
+                    spec.gop_size = gop.first;
+                    spec.max_b_frames = gop.second;
+                    spec.bit_rate = rate;
+                    specs.push_back(spec);
+                }
+            }
+        }
+    }
+    return specs;
+}
+
+SyntheticMediaGenerator::SyntheticMediaGenerator() = default;
+
+const char* SyntheticMediaGenerator::codecName(EncoderCodec codec) {
+    switch (codec) {
+    case EncoderCodec::H265:
+        return "h265";
+    case EncoderCodec::AV1:
+        return "av1";
+    case EncoderCodec::Mpeg4:
+        return "mpeg4";
+    case EncoderCodec::H264:
+    default:
+        return "h264";
+    }
+}
+
+bool SyntheticMediaGenerator::parseCodec(const std::string& name, EncoderCodec* codec) {
+    if (!codec) {
+        return false;
+    }
+    if (name == "h264" || name == "avc") {
+        *codec = EncoderCodec::H264;
+    } else if (name == "h265" || name == "hevc") {
+        *codec = EncoderCodec::H265;
+    } else if (name == "av1") {
+        *codec = EncoderCodec::AV1;
+    } else if (name == "mpeg4") {
+        *codec = EncoderCodec::Mpeg4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool SyntheticMediaGenerator::generate(const Spec& spec, const std::string& path, Result* result) {
+    const int64_t frame_count = spec.frameCount();
+    if (spec.width < 16 || spec.height < 16 || (spec.width & 1) || (spec.height & 1) ||
+        frame_count <= 0 || spec.gop_size < 1) {
+        setError("无效的媒体规格: " + spec.name());
+        return false;
+    }
+    if (spec.audio && (spec.sample_rate <= 0 || spec.channels <= 0)) {
+        setError("无效的音频参数: " + spec.name());
+        return false;
+    }
+
+    // 临时文件的扩展名是.part，封装格式先按最终文件名确定
+    const auto* guessed_format = av_guess_format(nullptr, path.c_str(), nullptr);
+    if (!guessed_format) {
+        setError("无法按扩展名确定封装格式: " + path);
+        return false;
+    }
+    const std::string format_name = guessed_format->name;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // 编码单线程：多线程下x264/x265的码控决策与调度有关，输出不可复现
+    FFmpegVideoEncoder::Config encoder_config;
+    encoder_config.codec = spec.codec;
+    encoder_config.preset = spec.preset.empty() ? defaultPreset(spec.codec) : spec.preset;
+    encoder_config.bit_rate = spec.effectiveBitRate();
+    encoder_config.crf = encoder_config.bit_rate > 0 ? -1 : spec.crf;
+    encoder_config.gop_size = spec.gop_size;
+    encoder_config.max_b_frames = spec.gop_size <= 1 ? 0 : spec.max_b_frames;
+    encoder_config.thread_count = 1;
+    FFmpegVideoEncoder video_encoder(encoder_config);
+
+    VideoEncodeFormat encode_format;
+    encode_format.width = spec.width;
+    encode_format.height = spec.height;
+    encode_format.pix_fmt = AV_PIX_FMT_YUV420P;
+    encode_format.time_base = av_inv_q(spec.frame_rate);
+    encode_format.frame_rate = spec.frame_rate;
+    encode_format.sample_aspect_ratio = {1, 1};
+    if (!video_encoder.initialize(encode_format)) {
+        setError(video_encoder.getLastError());
+        return false;
+    }
+
+    const std::string temp_path = path + ".part";
+    AVFormatContext* output = nullptr;
+    int ret = avformat_alloc_output_context2(&output, nullptr, format_name.c_str(), temp_path.c_str());
+    if (ret < 0 || !output) {
+        setError("无法创建输出 " + path + ": " + avError(ret));
+        return false;
+    }
+    // 不写封装器版本和创建时间，同样的数据包得到同样的文件
+    output->flags |= AVFMT_FLAG_BITEXACT;
+
+    AVCodecContext* audio_ctx = nullptr;
+    AVFrame* video_frame = av_frame_alloc();
+    AVFrame* audio_frame = nullptr;
+    AVPacket* packet = av_packet_alloc();
+    bool opened = false;
+    bool ok = video_frame && packet;
+
+    auto fail = [&](const std::string& error) {
+        setError(error);
+        ok = false;
+    };
+
+    AVStream* video_stream = ok ? avformat_new_stream(output, nullptr) : nullptr;
+    if (ok && (!video_stream || !video_encoder.copyParameters(video_stream->codecpar))) {
+        fail("无法创建视频流");
+    }
+    if (ok) {
+        video_stream->time_base = video_encoder.getTimeBase();
+        video_stream->avg_frame_rate = spec.frame_rate;
+        video_stream->codecpar->codec_tag = 0;
+    }
+
+    AVStream* audio_stream = nullptr;
+    if (ok && spec.audio) {
+        const AVCodec* aac = avcodec_find_encoder(AV_CODEC_ID_AAC);
+        audio_ctx = aac ? avcodec_alloc_context3(aac) : nullptr;
+        if (!audio_ctx) {
+            fail("找不到AAC编码器");
+        } else {
+            audio_ctx->sample_fmt = AV_SAMPLE_FMT_FLTP;
+            audio_ctx->sample_rate = spec.sample_rate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+            av_channel_layout_default(&audio_ctx->ch_layout, spec.channels);
+#else
+            audio_ctx->channels = spec.channels;
+            audio_ctx->channel_layout = av_get_default_channel_layout(spec.channels);
+#endif
+            audio_ctx->bit_rate = spec.audio_bit_rate;
+            audio_ctx->time_base = {1, spec.sample_rate};
+            audio_ctx->flags |= AV_CODEC_FLAG_BITEXACT;
+            if (output->oformat->flags & AVFMT_GLOBALHEADER) {
+                audio_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            }
+            ret = avcodec_open2(audio_ctx, aac, nullptr);
+            if (ret < 0) {
+                fail("打开AAC编码器失败: " + avError(ret));
+            }
+        }
+        if (ok) {
+            audio_stream = avformat_new_stream(output, nullptr);
+            if (!audio_stream || avcodec_parameters_from_context(audio_stream->codecpar, audio_ctx) < 0) {
+                fail("无法创建音频流");
+            } else {
+                audio_stream->time_base = audio_ctx->time_base;
+            }
+        }
+        if (ok) {
+            audio_frame = av_frame_alloc();
+            if (audio_frame) {
+                audio_frame->format = AV_SAMPLE_FMT_FLTP;
+                audio_frame->nb_samples = audio_ctx->frame_size > 0 ? audio_ctx->frame_size : 1024;
+                audio_frame->sample_rate = spec.sample_rate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+                av_channel_layout_copy(&audio_frame->ch_layout, &audio_ctx->ch_layout);
+#else
+                audio_frame->channels = audio_ctx->channels;
+                audio_frame->channel_layout = audio_ctx->channel_layout;
+#endif
+            }
+            if (!audio_frame || av_frame_get_buffer(audio_frame, 0) < 0) {
+                fail("无法分配音频帧");
+            }
+        }
+    }
+
+    if (ok) {
+        video_frame->format = AV_PIX_FMT_YUV420P;
+        video_frame->width = spec.width;
+        video_frame->height = spec.height;
+        if (av_frame_get_buffer(video_frame, 0) < 0) {
+            fail("无法分配视频帧");
+        }
+    }
+
+    if (ok && !(output->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&output->pb, temp_path.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            fail("无法打开输出文件 " + temp_path + ": " + avError(ret));
+        }
+    }
+    if (ok) {
+        ret = avformat_write_header(output, nullptr);
+        if (ret < 0) {
+            fail("写文件头失败: " + avError(ret));
+        } else {
+            opened = true;
+        }
+    }
+
+    Result stats;
+    stats.spec = spec;
+    stats.path = path;
+    stats.generated = true;
+
+    auto writePacket = [&](AVRational time_base, AVStream* stream) {
+        packet->stream_index = stream->index;
+        av_packet_rescale_ts(packet, time_base, stream->time_base);
+        ret = av_interleaved_write_frame(output, packet);
+        if (ret < 0) {
+            fail("写数据包失败: " + avError(ret));
+        }
+    };
+    auto drainVideo = [&]() {
+        while (ok && video_encoder.receivePacket(packet)) {
+            stats.video_bytes += static_cast<uint64_t>(packet->size);
+            writePacket(video_encoder.getTimeBase(), video_stream);
+        }
+        if (ok && video_encoder.getState() == EncoderState::Error) {
+            fail(video_encoder.getLastError());
+        }
+    };
+    auto drainAudio = [&]() {
+        while (ok && (ret = avcodec_receive_packet(audio_ctx, packet)) >= 0) {
+            writePacket(audio_ctx->time_base, audio_stream);
+        }
+        if (ok && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+            fail("AAC编码失败: " + avError(ret));
+        }
+    };
+
+    const int64_t total_samples = spec.audio ? std::llround(spec.duration_s * spec.sample_rate) : 0;
+    int64_t next_sample = 0;
+    // 音频编码到给定时刻（秒）为止，和视频交替送进封装器
+    auto encodeAudioUntil = [&](double seconds) {
+        while (ok && audio_ctx && next_sample < total_samples &&
+               static_cast<double>(next_sample) / spec.sample_rate < seconds) {
+            if (av_frame_make_writable(audio_frame) < 0) {
+                fail("无法写音频帧");
+                return;
+            }
+            const int frame_size = audio_ctx->frame_size > 0 ? audio_ctx->frame_size : 1024;
+            audio_frame->nb_samples = static_cast<int>(std::min<int64_t>(frame_size, total_samples - next_sample));
+            SyntheticPattern::fillAudioSamples(reinterpret_cast<float* const*>(audio_frame->extended_data),
+                                               spec.channels, audio_frame->nb_samples, next_sample,
+                                               spec.sample_rate, spec.tone_hz, 0.5f);
+            audio_frame->pts = next_sample;
+            next_sample += audio_frame->nb_samples;
+            ret = avcodec_send_frame(audio_ctx, audio_frame);
+            if (ret < 0) {
+                fail("AAC编码失败: " + avError(ret));
+                return;
+            }
+            stats.audio_frames++;
+            drainAudio();
+        }
+    };
+
+    const double frame_duration = av_q2d(encode_format.time_base);
+    for (int64_t index = 0; ok && index < frame_count; ++index) {
+        encodeAudioUntil((index + 1) * frame_duration);
+        // 编码器可能还引用着上一帧的缓冲
+        if (ok && av_frame_make_writable(video_frame) < 0) {
+            fail("无法写视频帧");
+        }
+        if (!ok) {
+            break;
+        }
+        SyntheticPattern::fillVideoFrame(video_frame->data, video_frame->linesize,
+                                         spec.width, spec.height, index, spec.noise);
+        video_frame->pts = index;
+        if (!video_encoder.sendFrame(video_frame) && video_encoder.getState() == EncoderState::Error) {
+            fail(video_encoder.getLastError());
+            break;
+        }
+        stats.video_frames++;
+        drainVideo();
+    }
+
+    // 排空两个编码器
+    if (ok) {
+        video_encoder.sendFrame(nullptr);
+        drainVideo();
+    }
+    encodeAudioUntil(spec.duration_s + 1.0);
+    if (ok && audio_ctx) {
+        avcodec_send_frame(audio_ctx, nullptr);
+        drainAudio();
+    }
+
+    if (opened) {
+        ret = av_write_trailer(output);
+        if (ok && ret < 0) {
+            fail("写文件尾失败: " + avError(ret));
+        }
+    }
+    if (output->pb && !(output->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&output->pb);
+    }
+    avformat_free_context(output);
+    avcodec_free_context(&audio_ctx);
+    av_frame_free(&audio_frame);
+    av_frame_free(&video_frame);
+    av_packet_free(&packet);
+
+    if (ok && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        fail("重命名文件失败: " + path);
+    }
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    stats.encode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (result) {
+        *result = stats;
+    }
+    return true;
+}
+
+bool SyntheticMediaGenerator::ensure(const Spec& spec, const std::string& directory, Result* result) {
+    const std::string dir = directory.empty() ? std::string(".") : directory;
+    ::mkdir(dir.c_str(), 0755);
+    const std::string path = dir + "/" + spec.name();
+    if (fileExists(path)) {
+        if (result) {
+            *result = Result{};
+            result->spec = spec;
+            result->path = path;
+        }
+        return true;
+    }
+    return generate(spec, path, result);
+}
+
+bool SyntheticMediaGenerator::ensureMatrix(const Matrix& matrix, const std::string& directory,
+                                           std::vector<Result>* results) {
+    for (const Spec& spec : matrix.expand()) {
+        if (!FFmpegVideoEncoder::isAvailable(spec.codec)) {
+            continue;
+        }
+        Result result;
+        if (!ensure(spec, directory, &result)) {
+            return false;
+        }
+        if (results) {
+            results->push_back(result);
+        }
+    }
+    return true;
+}
+
+void SyntheticMediaGenerator::setError(const std::string& error) {
+    last_error_ = error;
+}
+
+} // namespace media
@@ -0,0 +1,150 @@
+#ifndef SYNTHETIC_MEDIA_H
+#define SYNTHETIC_MEDIA_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../encoder/ffmpeg_encoder.h"
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+namespace media {
+
+/**
+ * @brief 合成测试媒体生成器：测试图案 + 测试音，用CPU编码器编码后封装成文件
+ *
+ * 设计特点：
+ * 1. 不依赖外部文件：画面和声音来自SyntheticPattern（对应lavfi的testsrc/sine，
+ *    但不需要链接libavfilter/libavdevice），视频用FFmpegVideoEncoder，音频用FFmpeg内置AAC
+ * 2. 参数矩阵：编解码器 × 分辨率 × GOP结构 × 码率展开成一组规格，每个规格对应一个确定的文件名，
+ *    ensure在目录里复用已生成的文件，基准和测试第一次运行时生成、之后直接读取
+ * 3. 可复现：编码单线程、封装器按位精确模式，同一FFmpeg和编码器版本下文件逐字节一致；
+ *    画面左上角带帧号戳，解码后可以校验seek落点和丢帧
+ * 4. 原子落盘：先写.part再改名，中途失败或被打断不会留下半个文件被当成缓存
+ */
+class SyntheticMediaGenerator {
+public:
+    /**
+     * @brief 单个媒体文件的规格
+     */
+    struct Spec {
+        EncoderCodec codec;
+        int width;
+        int height;
+        AVRational frame_rate;
+        double duration_s;
+        int gop_size;               // 关键帧间隔（帧），1为全I帧
+        int max_b_frames;           // 最大连续B帧，0为IPPP
+        int64_t bit_rate;           // 平均码率（bps），0为恒定质量（crf）
+        int crf;
+        std::string preset;         // 空为各编码器最快的预设
+        int noise;                  // 画面噪声幅度（0~64），越大码率越接近真实内容
+        bool audio;                 // 是否带AAC音轨
+        int sample_rate;
+        int channels;
+        double tone_hz;
+        int64_t audio_bit_rate;
+        std::string container;      // 扩展名：mp4、mkv、ts
+
+        Spec()
+            : codec(EncoderCodec::H264)
+            , width(1280)
+            , height(720)
+            , frame_rate{30, 1}
+            , duration_s(10.0)
+            , gop_size(60)
+            , max_b_frames(2)
+            , bit_rate(0)
+            , crf(23)
+            , noise(8)
+            , audio(true)
+            , sample_rate(48000)
+            , channels(2)
+            , tone_hz(440.0)
+            , audio_bit_rate(128000)
+            , container("mp4")
+        {}
+
+        /**
+         * @brief 实际使用的码率：内置MPEG-4不支持crf，为0时按0.1比特/像素估算
+         */
+        int64_t effectiveBitRate() const;
+
+        int64_t frameCount() const;
+
+        /**
+         * @brief 由全部参数决定的文件名，如h264_1280x720_30fps_g60b2_crf23_n8_10s_a48000x2_440hz_128k.mp4
+         */
+        std::string name() const;
+    };
+
+    /**
+     * @brief 参数矩阵，expand按编解码器 × 分辨率 × GOP × 码率的顺序展开
+     */
+    struct Matrix {
+        Spec base;                                      // 矩阵之外的参数
+        std::vector<EncoderCodec> codecs;
+        std::vector<std::pair<int, int>> resolutions;   // 宽 × 高
+        std::vector<std::pair<int, int>> gops;          // 关键帧间隔 × 最大B帧
+        std::vector<int64_t> bit_rates;                 // 0为恒定质量
+
+        std::vector<Spec> expand() const;
+    };
+
+    /**
+     * @brief 一个文件的生成结果
+     */
+    struct Result {
+        Spec spec;
+        std::string path;
+        bool generated = false;         // false表示复用了已有文件
+        uint64_t video_frames = 0;
+        uint64_t video_bytes = 0;       // 视频数据包字节
+        uint64_t audio_frames = 0;
+        double encode_ms = 0.0;
+    };
+
+public:
+    SyntheticMediaGenerator();
+
+    SyntheticMediaGenerator(const SyntheticMediaGenerator&) = delete;
+    SyntheticMediaGenerator& operator=(const SyntheticMediaGenerator&) = delete;
+
+    /**
+     * @brief 生成一个文件（阻塞），封装格式按path的扩展名
+     */
+    bool generate(const Spec& spec, const std::string& path, Result* result = nullptr);
+
+    /**
+     * @brief 目录里已有同名文件时直接复用，否则生成
+     */
+    bool ensure(const Spec& spec, const std::string& directory, Result* result = nullptr);
+
+    /**
+     * @brief 展开矩阵并逐个ensure，当前FFmpeg没有编译的编码器跳过
+     * @return 遇到第一个失败时返回false，results里是此前完成的文件
+     */
+    bool ensureMatrix(const Matrix& matrix, const std::string& directory, std::vector<Result>* results);
+
+    /**
+     * @brief 编解码器在文件名和命令行里的名称（h264/h265/av1/mpeg4）
+     */
+    static const char* codecName(EncoderCodec codec);
+    static bool parseCodec(const std::string& name, EncoderCodec* codec);
+
+    std::string getLastError() const { return last_error_; }
+
+private:
+    void setError(const std::string& error);
+
+private:
+    std::string last_error_;
+};
+
+} // namespace media
+
+#endif // SYNTHETIC_MEDIA_H
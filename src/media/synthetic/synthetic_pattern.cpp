@@ -0,0 +1,220 @@
+#include "synthetic_pattern.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+
+namespace media {
+
+namespace {
+
+struct Yuv {
+    uint8_t y;
+    uint8_t u;
+    uint8_t v;
+};
+
+// 75%彩条（BT.601有限范围）：白、黄、青、绿、品红、红、蓝
+const Yuv kBars[] = {
+    {180, 128, 128},
+    {162, 44, 142},
+    {131, 156, 44},
+    {112, 72, 58},
+    {84, 184, 198},
+    {65, 100, 212},
+    {35, 212, 114}
+};
+constexpr int kBarCount = sizeof(kBars) / sizeof(kBars[0]);
+
+constexpr uint8_t kStampQuiet = 128;
+constexpr uint8_t kStampOne = 235;
+constexpr uint8_t kStampZero = 16;
+constexpr int kStampMargin = 40;        // 块均值离灰色至少这么远才算可辨认
+
+/**
+ * @brief 一帧里各元素的位置（只由帧号和画面尺寸决定）
+ */
+struct Layout {
+    int width;
+    int height;
+    int shift;              // 彩条和渐变的平移量
+    int ramp_top;           // 下方四分之一是亮度渐变
+    int box_x;
+    int box_y;
+    int box_size;
+    int stamp_block;
+    int stamp_width;
+    int stamp_height;
+};
+
+int triangle(int64_t t, int range) {
+    if (range <= 0) {
+        return 0;
+    }
+    const int64_t phase = t % (2 * static_cast<int64_t>(range));
+    return static_cast<int>(phase < range ? phase : 2 * range - phase);
+}
+
+Layout makeLayout(int width, int height, int64_t frame_index) {
+    Layout layout;
+    layout.width = width;
+    layout.height = height;
+    const int step = std::max(2, width / 160) & ~1;
+    layout.shift = static_cast<int>((frame_index * step) % width);
+    layout.ramp_top = height * 3 / 4;
+    layout.box_size = std::max(8, height / 6) & ~1;
+    layout.box_x = triangle(frame_index * step * 3, width - layout.box_size) & ~1;
+    layout.box_y = triangle(frame_index * step * 2, height - layout.box_size) & ~1;
+    layout.stamp_block = SyntheticPattern::stampBlockSize(width, height);
+    layout.stamp_width = layout.stamp_block * (SyntheticPattern::kStampBits + 2);
+    layout.stamp_height = layout.stamp_block * 3;
+    return layout;
+}
+
+uint32_t stampValue(int64_t frame_index) {
+    const uint32_t index = static_cast<uint32_t>(frame_index) & ((1u << SyntheticPattern::kStampIndexBits) - 1);
+    const uint32_t check = ((index ^ (index >> 8) ^ (index >> 16)) & 0xFF) ^ 0xA5;
+    return (index << 8) | check;
+}
+
+bool inStamp(const Layout& layout, int x, int y) {
+    return layout.stamp_block > 0 && x < layout.stamp_width && y < layout.stamp_height;
+}
+
+/**
+ * @brief 帧号戳区域内的亮度：灰色静区里一行黑白块
+ */
+uint8_t stampLuma(const Layout& layout, uint32_t value, int x, int y) {
+    const int b = layout.stamp_block;
+    if (y < b || y >= 2 * b || x < b || x >= layout.stamp_width - b) {
+        return kStampQuiet;
+    }
+    const int bit = x / b - 1;
+    return ((value >> (SyntheticPattern::kStampBits - 1 - bit)) & 1) ? kStampOne : kStampZero;
+}
+
+Yuv colorAt(const Layout& layout, int x, int y) {
+    if (x >= layout.box_x && x < layout.box_x + layout.box_size &&
+        y >= layout.box_y && y < layout.box_y + layout.box_size) {
+        // 白框黑心的方块，边缘给运动估计一个清晰的目标
+        const int inset = layout.box_size / 4;
+        const bool inner = x >= layout.box_x + inset && x < layout.box_x + layout.box_size - inset &&
+                           y >= layout.box_y + inset && y < layout.box_y + layout.box_size - inset;
+        return inner ? Yuv{16, 128, 128} : Yuv{235, 128, 128};
+    }
+    const int moved = (x + layout.shift) % layout.width;
+    if (y >= layout.ramp_top) {
+        const int ramp = (x + 2 * layout.shift) % layout.width;
+        return Yuv{static_cast<uint8_t>(16 + ramp * 219 / layout.width), 128, 128};
+    }
+    return kBars[moved * kBarCount / layout.width];
+}
+
+int noiseAt(int x, int y, int64_t frame_index, int noise) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x9E3779B1u ^ static_cast<uint32_t>(y) * 0x85EBCA77u ^
+                 static_cast<uint32_t>(frame_index) * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return static_cast<int>(((h & 0xFF) * static_cast<uint32_t>(2 * noise + 1)) >> 8) - noise;
+}
+
+} // namespace
+
+int SyntheticPattern::stampBlockSize(int width, int height) {
+    const int block = std::min({width / (kStampBits + 2), height / 4, 32}) & ~1;
+    return block >= 2 ? block : 0;
+}
+
+void SyntheticPattern::fillVideoFrame(uint8_t* const planes[3], const int linesizes[3],
+                                      int width, int height, int64_t frame_index, int noise) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    const Layout layout = makeLayout(width, height, frame_index);
+    const uint32_t stamp = stampValue(frame_index);
+    noise = std::max(0, std::min(noise, 64));
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = planes[0] + static_cast<ptrdiff_t>(y) * linesizes[0];
+        for (int x = 0; x < width; ++x) {
+            if (inStamp(layout, x, y)) {
+                row[x] = stampLuma(layout, stamp, x, y);
+                continue;
+            }
+            int luma = colorAt(layout, x, y).y;
+            if (noise > 0) {
+                luma = std::max(16, std::min(235, luma + noiseAt(x, y, frame_index, noise)));
+            }
+            row[x] = static_cast<uint8_t>(luma);
+        }
+    }
+
+    // 色度按2x2块左上角的像素取色，帧号戳区域保持中性
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    for (int cy = 0; cy < chroma_height; ++cy) {
+        uint8_t* u_row = planes[1] + static_cast<ptrdiff_t>(cy) * linesizes[1];
+        uint8_t* v_row = planes[2] + static_cast<ptrdiff_t>(cy) * linesizes[2];
+        for (int cx = 0; cx < chroma_width; ++cx) {
+            if (inStamp(layout, 2 * cx, 2 * cy)) {
+                u_row[cx] = 128;
+                v_row[cx] = 128;
+                continue;
+            }
+            const Yuv color = colorAt(layout, 2 * cx, 2 * cy);
+            u_row[cx] = color.u;
+            v_row[cx] = color.v;
+        }
+    }
+}
+
+int64_t SyntheticPattern::readFrameStamp(const uint8_t* luma, int linesize, int width, int height) {
+    const int b = stampBlockSize(width, height);
+    if (!luma || b == 0) {
+        return -1;
+    }
+
+    // 每块取中心一半区域的均值，容忍有损编码的振铃和块效应
+    uint32_t value = 0;
+    const int inset = b / 4;
+    const int size = std::max(1, b / 2);
+    for (int bit = 0; bit < kStampBits; ++bit) {
+        const int x0 = (bit + 1) * b + inset;
+        const int y0 = b + inset;
+        int sum = 0;
+        for (int y = y0; y < y0 + size; ++y) {
+            const uint8_t* row = luma + static_cast<ptrdiff_t>(y) * linesize;
+            for (int x = x0; x < x0 + size; ++x) {
+                sum += row[x];
+            }
+        }
+        const int mean = sum / (size * size);
+        if (std::abs(mean - kStampQuiet) < kStampMargin) {
+            return -1;
+        }
+        value = (value << 1) | (mean > kStampQuiet ? 1u : 0u);
+    }
+
+    const uint32_t index = value >> 8;
+    return stampValue(index) == value ? static_cast<int64_t>(index) : -1;
+}
+
+void SyntheticPattern::fillAudioSamples(float* const* channels, int channel_count, int sample_count,
+                                        int64_t first_sample, int sample_rate, double tone_hz, float amplitude) {
+    if (sample_rate <= 0) {
+        return;
+    }
+    const double two_pi = 2.0 * 3.14159265358979323846;
+    for (int c = 0; c < channel_count; ++c) {
+        const double frequency = tone_hz * (c + 1);
+        for (int i = 0; i < sample_count; ++i) {
+            // 先按采样率取模再换算相位，长音轨上也不丢精度
+            const double cycles = std::fmod(frequency * static_cast<double>(first_sample + i), sample_rate);
+            channels[c][i] = amplitude * static_cast<float>(std::sin(two_pi * cycles / sample_rate));
+        }
+    }
+}
+
+} // namespace media
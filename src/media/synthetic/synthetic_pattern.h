@@ -0,0 +1,53 @@
+#ifndef SYNTHETIC_PATTERN_H
+#define SYNTHETIC_PATTERN_H
+
+#include <cstdint>
+
+namespace media {
+
+/**
+ * @brief 确定性的合成测试图案和测试音（对应lavfi的testsrc/sine），不依赖FFmpeg
+ *
+ * 设计特点：
+ * 1. 逐帧确定：像素只由帧号决定、采样只由采样序号决定，任何机器上生成的原始数据完全一致
+ * 2. 有运动也有细节：平移的彩条、移动的方块、滚动的亮度渐变和可调强度的噪声，
+ *    编码器的运动估计和码率控制都有真实负载，不会因为画面静止而退化成跳过块
+ * 3. 帧号戳：画面左上角用32个黑白块编码帧号（24位帧号 + 8位校验），
+ *    解码后readFrameStamp读回，可以直接校验seek落点、丢帧和重复帧
+ */
+class SyntheticPattern {
+public:
+    static constexpr int kStampBits = 32;
+    static constexpr int kStampIndexBits = 24;
+
+    /**
+     * @brief 画一帧YUV420P（BT.601有限范围）
+     * @param planes Y/U/V平面
+     * @param linesizes 各平面行跨度
+     * @param noise 亮度噪声幅度（0~64），0为无噪声
+     */
+    static void fillVideoFrame(uint8_t* const planes[3], const int linesizes[3],
+                               int width, int height, int64_t frame_index, int noise);
+
+    /**
+     * @brief 从亮度平面读回帧号戳
+     * @return 帧号，画面太小或校验不通过时返回-1
+     */
+    static int64_t readFrameStamp(const uint8_t* luma, int linesize, int width, int height);
+
+    /**
+     * @brief 帧号戳的块边长（像素），画面放不下时返回0
+     */
+    static int stampBlockSize(int width, int height);
+
+    /**
+     * @brief 生成平面浮点正弦，第c声道频率为tone_hz * (c + 1)，相位由采样序号决定
+     * @param first_sample 第一个采样在整条音轨中的序号
+     */
+    static void fillAudioSamples(float* const* channels, int channel_count, int sample_count,
+                                 int64_t first_sample, int sample_rate, double tone_hz, float amplitude);
+};
+
+} // namespace media
+
+#endif // SYNTHETIC_PATTERN_H
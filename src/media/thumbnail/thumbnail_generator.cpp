@@ -0,0 +1,383 @@
+#include "thumbnail_generator.h"
+#include "../converter/ffmpeg_video_converter.h"
+#include "../decoder/ffmpeg_decoder.h"
+#include "../demux/ffmpeg_demuxer.h"
+#include "../input/input_source.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace media {
+
+namespace {
+
+// 缩略图专用缓存：不压缩、不过期，容量按缩略图张数估算
+std::shared_ptr<ThumbnailGenerator::ThumbnailCache> createDefaultCache() {
+    ThumbnailGenerator::ThumbnailCache::Config config;
+    config.l1_capacity = 1024;
+    config.l2_capacity = 1024;
+    config.l3_capacity = 1024;
+    config.enable_compression = false;
+    config.enable_prefetch = false;
+    config.ttl_seconds = 0;
+    return std::make_shared<ThumbnailGenerator::ThumbnailCache>(config);
+}
+
+} // namespace
+
+/**
+ * @brief 已解码、等待批量缩放的关键帧
+ */
+struct ThumbnailGenerator::PendingThumbnail {
+    int index = -1;
+    AVFrame* frame = nullptr;
+};
+
+ThumbnailGenerator::ThumbnailGenerator(const Config& config, std::shared_ptr<ThumbnailCache> cache)
+    : config_(config)
+    , cache_(cache ? std::move(cache) : createDefaultCache()) {
+}
+
+ThumbnailGenerator::~ThumbnailGenerator() {
+    stop();
+}
+
+bool ThumbnailGenerator::start(const std::string& url) {
+    stop();
+
+    if (url.empty() || config_.count <= 0 || config_.thumb_width <= 0) {
+        return false;
+    }
+
+    url_ = url;
+    order_ = progressiveOrder(config_.count);
+    next_job_.store(0);
+    stop_requested_.store(false);
+    duration_us_.store(0);
+    thumb_width_.store(0);
+    thumb_height_.store(0);
+    ready_count_.store(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.assign(config_.count, false);
+    }
+
+    stats_.generated.store(0);
+    stats_.cache_hits.store(0);
+    stats_.failed.store(0);
+    stats_.first_thumbnail_ms.store(0.0);
+    stats_.total_ms.store(0.0);
+    stats_.keyframes_decoded.store(0);
+    stats_.first_thumbnail_keyframes.store(0);
+    start_time_ = std::chrono::steady_clock::now();
+
+    int worker_count = std::max(1, std::min(config_.worker_count, config_.count));
+    active_workers_.store(worker_count);
+    for (int i = 0; i < worker_count; ++i) {
+        workers_.emplace_back(&ThumbnailGenerator::workerLoop, this);
+    }
+    return true;
+}
+
+void ThumbnailGenerator::stop() {
+    stop_requested_.store(true);
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+ThumbnailImage ThumbnailGenerator::getThumbnail(int index) const {
+    ThumbnailImage image;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index < 0 || index >= static_cast<int>(ready_.size()) || !ready_[index]) {
+            return image;
+        }
+    }
+
+    auto pixels = cache_->get(cacheKey(index));
+    const int width = thumb_width_.load();
+    const int height = thumb_height_.load();
+    if (!pixels || pixels->size() < static_cast<size_t>(width) * height * 4) {
+        return image;
+    }
+
+    image.index = index;
+    image.width = width;
+    image.height = height;
+    image.stride = width * 4;
+    image.pixels = std::move(pixels);
+    return image;
+}
+
+int64_t ThumbnailGenerator::timestampOf(int index) const {
+    const int64_t duration = duration_us_.load();
+    if (duration <= 0 || config_.count <= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>((index + 0.5) * duration / config_.count);
+}
+
+void ThumbnailGenerator::setThumbnailCallback(ThumbnailCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thumbnail_callback_ = std::move(callback);
+}
+
+void ThumbnailGenerator::setErrorCallback(ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_callback_ = std::move(callback);
+}
+
+std::vector<int> ThumbnailGenerator::progressiveOrder(int count) {
+    std::vector<int> order;
+    if (count <= 0) {
+        return order;
+    }
+    order.reserve(count);
+
+    int step = 1;
+    while (step < count) {
+        step <<= 1;
+    }
+
+    // 第一层只有0；之后每层取上一层间隔的中点（step的奇数倍）
+    order.push_back(0);
+    for (; step > 1; step >>= 1) {
+        const int half = step >> 1;
+        for (int i = half; i < count; i += step) {
+            order.push_back(i);
+        }
+    }
+    return order;
+}
+
+void ThumbnailGenerator::workerLoop() {
+    auto finish = [this]() {
+        if (active_workers_.fetch_sub(1) == 1 && !stop_requested_.load()) {
+            stats_.total_ms.store(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time_).count());
+        }
+    };
+
+    // 每个工作线程独立打开输入源，与播放互不干扰
+    std::shared_ptr<IInputSource> input(InputSourceFactory::create(url_));
+    if (!input || !input->open(url_)) {
+        reportError("缩略图：无法打开输入 " + url_ + (input ? ": " + input->getLastError() : ""));
+        finish();
+        return;
+    }
+
+    FFmpegDemuxer demuxer;
+    int video_index = -1;
+    const AVCodecParameters* codecpar = nullptr;
+    if (demuxer.initialize(input)) {
+        video_index = demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+        codecpar = demuxer.getCodecParameters(video_index);
+    }
+    const int64_t duration = demuxer.getDuration();
+    if (!codecpar || duration <= 0 || codecpar->width <= 0 || codecpar->height <= 0) {
+        reportError("缩略图：没有可用的视频流或时长未知");
+        finish();
+        return;
+    }
+    duration_us_.store(duration);
+
+    FFmpegVideoDecoder::Config decoder_config;
+    decoder_config.keyframe_only = true;
+    decoder_config.low_delay = true;    // 只要一帧输出，避免帧级多线程的输出延迟
+    FFmpegVideoDecoder decoder(decoder_config);
+    if (!decoder.initialize(codecpar)) {
+        reportError("缩略图：" + decoder.getLastError());
+        finish();
+        return;
+    }
+
+    // 缩略图尺寸：固定宽度，高度按显示宽高比计算并取偶数
+    double display_width = codecpar->width;
+    if (codecpar->sample_aspect_ratio.num > 0 && codecpar->sample_aspect_ratio.den > 0) {
+        display_width = display_width * codecpar->sample_aspect_ratio.num / codecpar->sample_aspect_ratio.den;
+    }
+    const int thumb_width = config_.thumb_width & ~1;
+    const int thumb_height = std::max(2, static_cast<int>(thumb_width * codecpar->height / display_width + 0.5) & ~1);
+    thumb_width_.store(thumb_width);
+    thumb_height_.store(thumb_height);
+
+    FFmpegVideoConverter converter;
+    VideoConvertParams params;
+    params.src_width = codecpar->width;
+    params.src_height = codecpar->height;
+    params.src_format = static_cast<AVPixelFormat>(codecpar->format) != AV_PIX_FMT_NONE
+                            ? static_cast<AVPixelFormat>(codecpar->format) : AV_PIX_FMT_YUV420P;
+    params.dst_width = thumb_width;
+    params.dst_height = thumb_height;
+    params.dst_format = AV_PIX_FMT_RGB32;
+    params.sws_flags = SWS_FAST_BILINEAR;
+    if (!converter.initialize(params)) {
+        reportError("缩略图：" + converter.getLastError());
+        finish();
+        return;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    std::vector<PendingThumbnail> batch;
+    batch.reserve(config_.batch_size);
+
+    // 批量从1开始翻倍：第一张尽快出，之后逐步放大批量摊薄开销
+    size_t batch_limit = 1;
+
+    while (!stop_requested_.load()) {
+        const size_t job = next_job_.fetch_add(1);
+        if (job >= order_.size()) {
+            break;
+        }
+        const int index = order_[job];
+
+        if (cache_->contains(cacheKey(index))) {
+            stats_.cache_hits.fetch_add(1);
+            markReady(index);
+            continue;
+        }
+
+        // seek到目标之前的关键帧，只把关键帧数据包送进解码器
+        decoder.flush();
+        AVFrame* frame = nullptr;
+        if (demuxer.seekToTime(timestampOf(index))) {
+            AVFrame* decoded = av_frame_alloc();
+            size_t packets_read = 0;
+            while (!stop_requested_.load() && packets_read++ < config_.max_packets_per_seek) {
+                if (!demuxer.readPacket(packet)) {
+                    // 文件末尾：排空解码器
+                    decoder.sendPacket(nullptr);
+                    if (decoder.receiveFrame(decoded)) {
+                        frame = decoded;
+                    }
+                    break;
+                }
+                bool is_key = packet->stream_index == video_index && (packet->flags & AV_PKT_FLAG_KEY);
+                if (!is_key) {
+                    av_packet_unref(packet);
+                    continue;
+                }
+                decoder.sendPacket(packet);
+                av_packet_unref(packet);
+                stats_.keyframes_decoded.fetch_add(1);
+
+                // 有重排序延迟的码流不会立即输出，直接排空拿到这一帧
+                bool got_frame = decoder.receiveFrame(decoded);
+                if (!got_frame) {
+                    decoder.sendPacket(nullptr);
+                    got_frame = decoder.receiveFrame(decoded);
+                }
+                if (got_frame) {
+                    frame = decoded;
+                }
+                break;
+            }
+            if (!frame) {
+                av_frame_free(&decoded);
+            }
+        }
+
+        if (!frame) {
+            stats_.failed.fetch_add(1);
+            continue;
+        }
+
+        batch.push_back(PendingThumbnail{index, frame});
+        if (batch.size() >= batch_limit) {
+            flushBatch(batch, converter);
+            batch_limit = std::min(batch_limit * 2, std::max<size_t>(1, config_.batch_size));
+        }
+    }
+
+    flushBatch(batch, converter);
+    av_packet_free(&packet);
+    finish();
+}
+
+void ThumbnailGenerator::flushBatch(std::vector<PendingThumbnail>& batch, FFmpegVideoConverter& converter) {
+    if (batch.empty()) {
+        return;
+    }
+
+    const int width = thumb_width_.load();
+    const int height = thumb_height_.load();
+    const size_t frame_bytes = static_cast<size_t>(width) * height * 4;
+
+    // 目标帧直接指向缓存缓冲区，转换结果无需再拷贝
+    std::vector<std::vector<uint8_t>> buffers(batch.size());
+    std::vector<const AVFrame*> src_frames(batch.size());
+    std::vector<AVFrame*> dst_frames(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        buffers[i].resize(frame_bytes);
+        src_frames[i] = batch[i].frame;
+
+        AVFrame* dst = av_frame_alloc();
+        dst->format = AV_PIX_FMT_RGB32;
+        dst->width = width;
+        dst->height = height;
+        av_image_fill_arrays(dst->data, dst->linesize, buffers[i].data(),
+                             AV_PIX_FMT_RGB32, width, height, 1);
+        dst_frames[i] = dst;
+    }
+
+    const size_t converted = converter.convertBatch(src_frames.data(), dst_frames.data(), batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (i < converted) {
+            cache_->put(cacheKey(batch[i].index), std::move(buffers[i]), frame_bytes);
+            stats_.generated.fetch_add(1);
+            markReady(batch[i].index);
+        } else {
+            stats_.failed.fetch_add(1);
+        }
+        av_frame_free(&dst_frames[i]);
+        av_frame_free(&batch[i].frame);
+    }
+    batch.clear();
+}
+
+void ThumbnailGenerator::markReady(int index) {
+    ThumbnailCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index < 0 || index >= static_cast<int>(ready_.size()) || ready_[index]) {
+            return;
+        }
+        ready_[index] = true;
+        callback = thumbnail_callback_;
+    }
+
+    if (ready_count_.fetch_add(1) == 0) {
+        stats_.first_thumbnail_ms.store(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time_).count());
+        stats_.first_thumbnail_keyframes.store(stats_.keyframes_decoded.load());
+    }
+    if (callback) {
+        callback(index);
+    }
+}
+
+void ThumbnailGenerator::reportError(const std::string& message) {
+    ErrorCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = error_callback_;
+    }
+    if (callback) {
+        callback(message);
+    }
+}
+
+std::string ThumbnailGenerator::cacheKey(int index) const {
+    return url_ + "|" + std::to_string(config_.count) + "|" +
+           std::to_string(config_.thumb_width) + "|" + std::to_string(index);
+}
+
+} // namespace media
@@ -0,0 +1,206 @@
+#ifndef THUMBNAIL_GENERATOR_H
+#define THUMBNAIL_GENERATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../memory/cache_manager.h"
+
+namespace media {
+
+class FFmpegVideoConverter;
+
+/**
+ * @brief 一张缩略图（RGB32，与QImage::Format_RGB32内存布局一致）
+ */
+struct ThumbnailImage {
+    int index = -1;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::shared_ptr<std::vector<uint8_t>> pixels;
+
+    bool isValid() const { return pixels && width > 0 && height > 0; }
+};
+
+/**
+ * @brief 后台缩略图条生成器
+ *
+ * 设计特点：
+ * 1. 独立解码：每个工作线程自己打开输入源，不占用播放用的解封装器/解码器
+ * 2. 只解关键帧：seek到目标时间之前的关键帧，非关键帧数据包直接跳过不送解码器
+ * 3. 渐进生成：按二分顺序生成（0, N/2, N/4, 3N/4, ...），前几张就能均匀覆盖整条进度条
+ * 4. 批量缩放：关键帧攒批后一次调用FFmpegVideoConverter::convertBatch，直接写入缓存缓冲区
+ * 5. 缓存：结果存入CacheManager，同一文件再次打开时直接命中
+ */
+class ThumbnailGenerator {
+public:
+    using ThumbnailCache = CacheManager<std::string, std::vector<uint8_t>>;
+    using ThumbnailCallback = std::function<void(int /* index */)>;
+    using ErrorCallback = std::function<void(const std::string&)>;
+
+    /**
+     * @brief 生成配置
+     */
+    struct Config {
+        int count;                  // 缩略图数量
+        int thumb_width;            // 缩略图宽度，高度按画面宽高比计算
+        int worker_count;           // 工作线程数
+        size_t batch_size;          // 最大批量转换帧数
+        size_t max_packets_per_seek; // 单次seek后最多读取的数据包数
+
+        Config()
+            : count(100)
+            , thumb_width(160)
+            , worker_count(2)
+            , batch_size(4)
+            , max_packets_per_seek(2000)
+        {}
+    };
+
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t generated;             // 解码生成的缩略图数
+        uint64_t cache_hits;            // 直接命中缓存的数量
+        uint64_t failed;                // 生成失败的数量
+        double first_thumbnail_ms;      // 从start到第一张可用的耗时
+        double total_ms;                // 全部完成的耗时（未完成为0）
+        uint64_t keyframes_decoded;     // 送进解码器的关键帧数据包数
+        uint64_t first_thumbnail_keyframes; // 第一张可用时已解码的关键帧数
+    };
+
+    /**
+     * @brief 统计信息（内部使用，带原子操作）
+     */
+    struct Statistics {
+        std::atomic<uint64_t> generated{0};
+        std::atomic<uint64_t> cache_hits{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<double> first_thumbnail_ms{0.0};
+        std::atomic<double> total_ms{0.0};
+        std::atomic<uint64_t> keyframes_decoded{0};
+        std::atomic<uint64_t> first_thumbnail_keyframes{0};
+
+        StatisticsSnapshot getSnapshot() const {
+            return StatisticsSnapshot{
+                generated.load(),
+                cache_hits.load(),
+                failed.load(),
+                first_thumbnail_ms.load(),
+                total_ms.load(),
+                keyframes_decoded.load(),
+                first_thumbnail_keyframes.load()
+            };
+        }
+    };
+
+public:
+    /**
+     * @param config 生成配置
+     * @param cache 缩略图缓存，为空时使用内部缓存；多个生成器可共享同一个缓存
+     */
+    explicit ThumbnailGenerator(const Config& config = Config{},
+                                std::shared_ptr<ThumbnailCache> cache = nullptr);
+    ~ThumbnailGenerator();
+
+    ThumbnailGenerator(const ThumbnailGenerator&) = delete;
+    ThumbnailGenerator& operator=(const ThumbnailGenerator&) = delete;
+
+    /**
+     * @brief 开始为指定文件生成缩略图条（立即返回）
+     * @return 参数无效时返回false；打开文件等错误通过错误回调报告
+     */
+    bool start(const std::string& url);
+
+    /**
+     * @brief 停止生成并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 是否仍在生成
+     */
+    bool isRunning() const { return active_workers_.load() > 0; }
+
+    /**
+     * @brief 获取已生成的缩略图（任意线程）
+     * @return 尚未生成或已被缓存淘汰时返回无效图像
+     */
+    ThumbnailImage getThumbnail(int index) const;
+
+    /**
+     * @brief 已生成的缩略图数量
+     */
+    int readyCount() const { return ready_count_.load(); }
+
+    int count() const { return config_.count; }
+    int thumbnailWidth() const { return thumb_width_.load(); }
+    int thumbnailHeight() const { return thumb_height_.load(); }
+
+    /**
+     * @brief 第index张缩略图对应的时间点（微秒，取所在区间的中点）
+     */
+    int64_t timestampOf(int index) const;
+
+    /**
+     * @brief 设置单张缩略图完成回调（在工作线程中调用）
+     */
+    void setThumbnailCallback(ThumbnailCallback callback);
+
+    /**
+     * @brief 设置错误回调（在工作线程中调用）
+     */
+    void setErrorCallback(ErrorCallback callback);
+
+    StatisticsSnapshot getStatistics() const { return stats_.getSnapshot(); }
+
+    /**
+     * @brief 渐进生成顺序：先起点，再逐层二分，每个索引恰好出现一次
+     */
+    static std::vector<int> progressiveOrder(int count);
+
+private:
+    struct PendingThumbnail;
+
+    void workerLoop();
+    void flushBatch(std::vector<PendingThumbnail>& batch, FFmpegVideoConverter& converter);
+    void markReady(int index);
+    void reportError(const std::string& message);
+    std::string cacheKey(int index) const;
+
+private:
+    Config config_;
+    std::shared_ptr<ThumbnailCache> cache_;
+
+    std::string url_;
+    std::vector<int> order_;
+    std::atomic<size_t> next_job_{0};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<int> active_workers_{0};
+    std::vector<std::thread> workers_;
+
+    std::atomic<int64_t> duration_us_{0};
+    std::atomic<int> thumb_width_{0};
+    std::atomic<int> thumb_height_{0};
+    std::atomic<int> ready_count_{0};
+
+    mutable std::mutex mutex_;                  // 保护ready_和回调
+    std::vector<bool> ready_;
+    ThumbnailCallback thumbnail_callback_;
+    ErrorCallback error_callback_;
+
+    std::chrono::steady_clock::time_point start_time_;
+    mutable Statistics stats_;
+};
+
+} // namespace media
+
+#endif // THUMBNAIL_GENERATOR_H
@@ -0,0 +1,190 @@
+#include "thumbnail_service.h"
+
+#include <QUrl>
+#include <algorithm>
+
+namespace media {
+
+namespace {
+
+void releaseThumbnailPixels(void* info) {
+    delete static_cast<std::shared_ptr<std::vector<uint8_t>>*>(info);
+}
+
+} // namespace
+
+ThumbnailService::ThumbnailService(QObject* parent)
+    : QObject(parent) {
+    ThumbnailGenerator::ThumbnailCache::Config cache_config;
+    cache_config.l1_capacity = 1024;
+    cache_config.l2_capacity = 1024;
+    cache_config.l3_capacity = 1024;
+    cache_config.enable_compression = false;
+    cache_config.enable_prefetch = false;
+    cache_config.ttl_seconds = 0;
+    cache_ = std::make_shared<ThumbnailGenerator::ThumbnailCache>(cache_config);
+}
+
+ThumbnailService::~ThumbnailService() {
+    // 先停止工作线程，回调里引用了this
+    std::shared_ptr<ThumbnailGenerator> generator;
+    {
+        std::lock_guard<std::mutex> lock(generator_mutex_);
+        generator = std::move(generator_);
+    }
+    if (generator) {
+        generator->stop();
+    }
+}
+
+void ThumbnailService::setSource(const QString& source) {
+    if (source_ == source) {
+        return;
+    }
+    source_ = source;
+    emit sourceChanged();
+    restart();
+}
+
+void ThumbnailService::setCount(int count) {
+    if (count <= 0 || config_.count == count) {
+        return;
+    }
+    config_.count = count;
+    emit countChanged();
+    restart();
+}
+
+int ThumbnailService::readyCount() const {
+    std::lock_guard<std::mutex> lock(generator_mutex_);
+    return generator_ ? generator_->readyCount() : 0;
+}
+
+QSize ThumbnailService::thumbnailSize() const {
+    return thumbnail_size_;
+}
+
+QString ThumbnailService::thumbnailUrl(int index) const {
+    return QStringLiteral("image://thumbnails/%1/%2").arg(generation_).arg(index);
+}
+
+int ThumbnailService::indexAt(double ratio) const {
+    const int index = static_cast<int>(ratio * config_.count);
+    return std::max(0, std::min(config_.count - 1, index));
+}
+
+QImage ThumbnailService::image(int index) const {
+    std::shared_ptr<ThumbnailGenerator> generator;
+    {
+        std::lock_guard<std::mutex> lock(generator_mutex_);
+        generator = generator_;
+    }
+    if (!generator) {
+        return QImage();
+    }
+
+    ThumbnailImage thumbnail = generator->getThumbnail(index);
+    if (!thumbnail.isValid()) {
+        return QImage();
+    }
+
+    // QImage直接引用缓存取出的像素，最后一个引用释放时归还
+    auto* holder = new std::shared_ptr<std::vector<uint8_t>>(thumbnail.pixels);
+    return QImage(thumbnail.pixels->data(), thumbnail.width, thumbnail.height, thumbnail.stride,
+                  QImage::Format_RGB32, releaseThumbnailPixels, holder);
+}
+
+void ThumbnailService::restart() {
+    std::shared_ptr<ThumbnailGenerator> old_generator;
+    {
+        std::lock_guard<std::mutex> lock(generator_mutex_);
+        old_generator = std::move(generator_);
+    }
+    if (old_generator) {
+        old_generator->stop();
+    }
+    generation_++;
+    emit generationChanged();
+    emit readyCountChanged();
+
+    if (thumbnail_size_.isValid()) {
+        thumbnail_size_ = QSize();
+        emit thumbnailSizeChanged();
+    }
+
+    if (source_.isEmpty()) {
+        return;
+    }
+
+    // 支持file:// URL和本地路径
+    const QUrl url(source_);
+    const QString path = url.isLocalFile() ? url.toLocalFile() : source_;
+
+    auto new_generator = std::make_shared<ThumbnailGenerator>(config_, cache_);
+    ThumbnailGenerator* generator = new_generator.get();
+    const int generation = generation_;
+
+    generator->setThumbnailCallback([this, generator, generation](int index) {
+        QMetaObject::invokeMethod(this, [this, generator, generation, index]() {
+            if (generation != generation_) {
+                return;  // 已切换到新的文件
+            }
+            QSize size(generator->thumbnailWidth(), generator->thumbnailHeight());
+            if (size != thumbnail_size_) {
+                thumbnail_size_ = size;
+                emit thumbnailSizeChanged();
+            }
+            emit readyCountChanged();
+            emit thumbnailReady(index);
+        }, Qt::QueuedConnection);
+    });
+    generator->setErrorCallback([this, generation](const std::string& message) {
+        QString text = QString::fromStdString(message);
+        QMetaObject::invokeMethod(this, [this, generation, text]() {
+            if (generation == generation_) {
+                emit errorOccurred(text);
+            }
+        }, Qt::QueuedConnection);
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(generator_mutex_);
+        generator_ = new_generator;
+    }
+    generator->start(path.toStdString());
+}
+
+// ============ ThumbnailImageProvider ============
+
+ThumbnailImageProvider::ThumbnailImageProvider(ThumbnailService* service)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , service_(service) {
+}
+
+QImage ThumbnailImageProvider::requestImage(const QString& id, QSize* size, const QSize& requested_size) {
+    // id: <generation>/<index>
+    const int index = id.section(QLatin1Char('/'), 1, 1).toInt();
+
+    QImage image;
+    QSize placeholder_size(160, 90);
+    if (service_) {
+        image = service_->image(index);
+        placeholder_size = QSize(service_->thumbnailWidth(), service_->thumbnailWidth() * 9 / 16);
+    }
+
+    if (image.isNull()) {
+        image = QImage(requested_size.isValid() ? requested_size : placeholder_size,
+                       QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+    }
+
+    if (size) {
+        *size = image.size();
+    }
+    if (requested_size.isValid() && requested_size != image.size()) {
+        return image.scaled(requested_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image;
+}
+
+} // namespace media
@@ -0,0 +1,122 @@
+#ifndef THUMBNAIL_SERVICE_H
+#define THUMBNAIL_SERVICE_H
+
+#include <QObject>
+#include <QImage>
+#include <QPointer>
+#include <QQuickImageProvider>
+#include <QSize>
+#include <QString>
+#include <memory>
+#include <mutex>
+
+#include "thumbnail_generator.h"
+
+namespace media {
+
+/**
+ * @brief 进度条缩略图服务（QML端）
+ *
+ * 包装ThumbnailGenerator：后台线程生成，完成一张就发一次thumbnailReady，
+ * 图片通过ThumbnailImageProvider以 image://thumbnails/<generation>/<index> 提供。
+ *
+ * QML用法：
+ *   thumbnailService.source = "/path/to/movie.mp4"
+ *   Image {
+ *       source: thumbnailService.thumbnailUrl(thumbnailService.indexAt(hoverRatio))
+ *       asynchronous: true
+ *   }
+ */
+class ThumbnailService : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(int count READ count WRITE setCount NOTIFY countChanged)
+    Q_PROPERTY(int readyCount READ readyCount NOTIFY readyCountChanged)
+    Q_PROPERTY(QSize thumbnailSize READ thumbnailSize NOTIFY thumbnailSizeChanged)
+    Q_PROPERTY(int generation READ generation NOTIFY generationChanged)
+
+public:
+    explicit ThumbnailService(QObject* parent = nullptr);
+    ~ThumbnailService() override;
+
+    QString source() const { return source_; }
+    void setSource(const QString& source);
+
+    int count() const { return config_.count; }
+    void setCount(int count);
+
+    int readyCount() const;
+    QSize thumbnailSize() const;
+
+    /**
+     * @brief 每次重新生成递增，用于让QML放弃旧的图片缓存
+     */
+    int generation() const { return generation_; }
+
+    /**
+     * @brief 第index张缩略图的图片地址
+     */
+    Q_INVOKABLE QString thumbnailUrl(int index) const;
+
+    /**
+     * @brief 进度比例（0~1）对应的缩略图索引
+     */
+    Q_INVOKABLE int indexAt(double ratio) const;
+
+    /**
+     * @brief 获取缩略图（任意线程，供图片提供器调用）
+     * @return 尚未生成时返回空图像
+     */
+    QImage image(int index) const;
+
+    /**
+     * @brief 配置的缩略图宽度（任意线程）
+     */
+    int thumbnailWidth() const { return config_.thumb_width; }
+
+    /**
+     * @brief 共享缓存，可与其他模块共用同一个CacheManager
+     */
+    std::shared_ptr<ThumbnailGenerator::ThumbnailCache> cache() const { return cache_; }
+
+signals:
+    void sourceChanged();
+    void countChanged();
+    void readyCountChanged();
+    void thumbnailSizeChanged();
+    void generationChanged();
+    void thumbnailReady(int index);
+    void errorOccurred(const QString& message);
+
+private:
+    void restart();
+
+private:
+    QString source_;
+    ThumbnailGenerator::Config config_;
+    std::shared_ptr<ThumbnailGenerator::ThumbnailCache> cache_;
+    mutable std::mutex generator_mutex_;            // 图片提供器线程与GUI线程共享generator_
+    std::shared_ptr<ThumbnailGenerator> generator_;
+    int generation_ = 0;
+    QSize thumbnail_size_;
+};
+
+/**
+ * @brief 缩略图图片提供器
+ *
+ * 注册：engine.addImageProvider("thumbnails", new ThumbnailImageProvider(service))
+ * 请求id格式：<generation>/<index>；未生成的缩略图返回透明占位图。
+ */
+class ThumbnailImageProvider : public QQuickImageProvider {
+public:
+    explicit ThumbnailImageProvider(ThumbnailService* service);
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requested_size) override;
+
+private:
+    QPointer<ThumbnailService> service_;
+};
+
+} // namespace media
+
+#endif // THUMBNAIL_SERVICE_H
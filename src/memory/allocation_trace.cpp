@@ -0,0 +1,265 @@
+#include "allocation_trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'T', 'R', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+
+constexpr uint8_t kThreadEscape = 0x7F;     // 标记字节里线程号放不下时，后跟varint线程号
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+        const uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void putLittleEndian(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint64_t getLittleEndian(const uint8_t* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief 对齐编码为log2+1（0表示未知），非2的幂向下取整
+ */
+uint8_t encodeAlignment(size_t alignment) {
+    uint8_t code = 0;
+    while (alignment > 1 && code < 63) {
+        alignment >>= 1;
+        ++code;
+    }
+    return alignment ? static_cast<uint8_t>(code + 1) : 0;
+}
+
+} // namespace
+
+void AllocationTrace::appendTag(Event::Type type, uint32_t thread) {
+    const uint8_t type_bit = static_cast<uint8_t>(type);
+    if (thread < kThreadEscape) {
+        data_.push_back(static_cast<uint8_t>(type_bit | (thread << 1)));
+    } else {
+        data_.push_back(static_cast<uint8_t>(type_bit | (kThreadEscape << 1)));
+        putVarint(data_, thread);
+    }
+    if (thread >= threads_) {
+        threads_ = thread + 1;
+    }
+    ++events_;
+}
+
+uint64_t AllocationTrace::addAllocation(uint32_t thread, uint64_t size, size_t alignment) {
+    appendTag(Event::Type::Allocate, thread);
+    putVarint(data_, size);
+    data_.push_back(encodeAlignment(alignment));
+    return allocations_++;
+}
+
+void AllocationTrace::addFree(uint32_t thread, uint64_t id) {
+    if (id >= allocations_) {
+        return;
+    }
+    appendTag(Event::Type::Free, thread);
+    // 记录与最新分配的距离：大多数块短命，距离通常只占1-2字节
+    putVarint(data_, allocations_ - 1 - id);
+}
+
+bool AllocationTrace::forEach(const Visitor& visitor) const {
+    const uint8_t* cursor = data_.data();
+    const uint8_t* end = cursor + data_.size();
+    uint64_t next_id = 0;
+
+    while (cursor < end) {
+        const uint8_t tag = *cursor++;
+        Event event{};
+        event.type = static_cast<Event::Type>(tag & 0x01);
+        event.thread = tag >> 1;
+
+        uint64_t value = 0;
+        if (event.thread == kThreadEscape) {
+            if (!getVarint(cursor, end, value) || value > UINT32_MAX) {
+                last_error_ = "Corrupt trace: bad thread index";
+                return false;
+            }
+            event.thread = static_cast<uint32_t>(value);
+        }
+        // 回放按线程编号索引，越界的编号不能交给调用方
+        if (event.thread >= threads_) {
+            last_error_ = "Corrupt trace: thread index out of range";
+            return false;
+        }
+
+        if (event.type == Event::Type::Allocate) {
+            if (!getVarint(cursor, end, event.size) || cursor >= end) {
+                last_error_ = "Corrupt trace: truncated allocation";
+                return false;
+            }
+            const uint8_t alignment_code = *cursor++;
+            if (alignment_code > 64) {
+                last_error_ = "Corrupt trace: bad alignment";
+                return false;
+            }
+            event.alignment = alignment_code ? (1u << std::min<uint8_t>(alignment_code - 1, 31)) : 0;
+            event.id = next_id++;
+        } else {
+            if (!getVarint(cursor, end, value) || value >= next_id) {
+                last_error_ = "Corrupt trace: free references unknown allocation";
+                return false;
+            }
+            event.id = next_id - 1 - value;
+        }
+
+        if (!visitor(event)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AllocationTrace::Summary AllocationTrace::summarize() const {
+    Summary summary;
+    summary.threads = threads_;
+
+    std::vector<uint64_t> sizes;
+    std::vector<uint32_t> owners;
+    std::vector<bool> live;
+    sizes.reserve(allocations_);
+    owners.reserve(allocations_);
+    live.reserve(allocations_);
+
+    uint64_t live_bytes = 0;
+    uint64_t live_blocks = 0;
+
+    forEach([&](const Event& event) {
+        ++summary.events;
+        if (event.type == Event::Type::Allocate) {
+            sizes.push_back(event.size);
+            owners.push_back(event.thread);
+            live.push_back(true);
+            ++summary.allocations;
+            summary.total_bytes += event.size;
+            summary.max_size = std::max(summary.max_size, event.size);
+            live_bytes += event.size;
+            ++live_blocks;
+            summary.peak_live_bytes = std::max(summary.peak_live_bytes, live_bytes);
+            summary.peak_live_blocks = std::max(summary.peak_live_blocks, live_blocks);
+        } else if (live[event.id]) {
+            live[event.id] = false;
+            ++summary.frees;
+            live_bytes -= sizes[event.id];
+            --live_blocks;
+            if (owners[event.id] != event.thread) {
+                ++summary.cross_thread_frees;
+            }
+        }
+        return true;
+    });
+
+    summary.unfreed_blocks = live_blocks;
+    return summary;
+}
+
+bool AllocationTrace::save(const std::string& path) const {
+    std::vector<uint8_t> header;
+    header.reserve(kHeaderSize);
+    header.insert(header.end(), std::begin(kMagic), std::end(kMagic));
+    putLittleEndian(header, kVersion, 4);
+    putLittleEndian(header, events_, 8);
+    putLittleEndian(header, allocations_, 8);
+    putLittleEndian(header, threads_, 4);
+    putLittleEndian(header, 0, 4);                      // 保留
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        last_error_ = "Cannot open " + path + " for writing";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    file.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+    if (!file) {
+        last_error_ = "Failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+bool AllocationTrace::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        last_error_ = "Cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (bytes.size() < kHeaderSize || !std::equal(std::begin(kMagic), std::end(kMagic), bytes.begin())) {
+        last_error_ = path + " is not an allocation trace";
+        return false;
+    }
+    const uint64_t version = getLittleEndian(bytes.data() + 4, 4);
+    if (version != kVersion) {
+        last_error_ = "Unsupported trace version " + std::to_string(version);
+        return false;
+    }
+
+    AllocationTrace loaded;
+    loaded.data_.assign(bytes.begin() + kHeaderSize, bytes.end());
+    loaded.events_ = getLittleEndian(bytes.data() + 8, 8);
+    loaded.allocations_ = getLittleEndian(bytes.data() + 16, 8);
+    loaded.threads_ = static_cast<uint32_t>(getLittleEndian(bytes.data() + 24, 4));
+
+    // 完整解码一遍，确认头部计数与事件流一致
+    uint64_t events = 0;
+    uint64_t allocations = 0;
+    const bool decoded = loaded.forEach([&](const Event& event) {
+        ++events;
+        if (event.type == Event::Type::Allocate) {
+            ++allocations;
+        }
+        return true;
+    });
+    if (!decoded || events != loaded.events_ || allocations != loaded.allocations_) {
+        last_error_ = path + ": " + (decoded ? "header counts do not match event stream" : loaded.last_error_);
+        return false;
+    }
+
+    data_ = std::move(loaded.data_);
+    events_ = loaded.events_;
+    allocations_ = loaded.allocations_;
+    threads_ = loaded.threads_;
+    last_error_.clear();
+    return true;
+}
+
+void AllocationTrace::clear() {
+    data_.clear();
+    data_.shrink_to_fit();
+    events_ = 0;
+    allocations_ = 0;
+    threads_ = 0;
+}
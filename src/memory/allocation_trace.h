@@ -0,0 +1,123 @@
+#ifndef ALLOCATION_TRACE_H
+#define ALLOCATION_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 紧凑的分配轨迹（一次真实运行的分配/释放序列，用于离线回放比较分配器）
+ *
+ * 设计特点：
+ * 1. 紧凑编码：事件直接编码为varint字节流，分配事件约4-6字节，释放事件约2-4字节
+ * 2. 生命周期顺序：分配按出现顺序编号，释放引用分配编号而不是地址（地址会被复用）
+ * 3. 线程信息：记录线程的紧凑编号，回放时可按原线程并行，保持跨线程的分配→释放先后关系
+ * 4. 文件格式：32字节小端文件头（魔数ATRC、版本、事件数、分配数、线程数）+ 事件流
+ */
+class AllocationTrace
+{
+public:
+    /**
+     * @brief 解码后的单个事件
+     */
+    struct Event {
+        enum class Type : uint8_t {
+            Allocate = 0,
+            Free = 1
+        };
+
+        Type type;
+        uint32_t thread;        // 线程编号（按首次出现从0开始）
+        uint64_t id;            // 分配编号（Free引用对应的Allocate）
+        uint64_t size;          // 分配字节数（仅Allocate）
+        uint32_t alignment;     // 观察到的对齐，0表示未知（仅Allocate）
+    };
+
+    /**
+     * @brief 轨迹概况（按记录顺序计算，与回放的分配器无关）
+     */
+    struct Summary {
+        uint64_t events;
+        uint64_t allocations;
+        uint64_t frees;
+        uint32_t threads;
+        uint64_t total_bytes;           // 累计分配字节数
+        uint64_t peak_live_bytes;       // 同时存活的最大字节数
+        uint64_t peak_live_blocks;      // 同时存活的最大块数
+        uint64_t max_size;              // 最大单次分配
+        uint64_t cross_thread_frees;    // 在另一个线程释放的块数
+        uint64_t unfreed_blocks;        // 轨迹结束时仍存活的块数
+
+        Summary()
+            : events(0), allocations(0), frees(0), threads(0), total_bytes(0)
+            , peak_live_bytes(0), peak_live_blocks(0), max_size(0)
+            , cross_thread_frees(0), unfreed_blocks(0)
+        {}
+    };
+
+    /**
+     * @brief 事件访问器，返回false提前结束遍历
+     */
+    using Visitor = std::function<bool(const Event& event)>;
+
+public:
+    /**
+     * @brief 追加一次分配
+     * @param thread 线程编号
+     * @param size 字节数
+     * @param alignment 观察到的对齐（0表示未知）
+     * @return 分配编号，供addFree引用
+     */
+    uint64_t addAllocation(uint32_t thread, uint64_t size, size_t alignment = 0);
+
+    /**
+     * @brief 追加一次释放
+     * @param thread 线程编号
+     * @param id addAllocation返回的分配编号
+     */
+    void addFree(uint32_t thread, uint64_t id);
+
+    /**
+     * @brief 按记录顺序解码全部事件
+     * @return false表示数据损坏或访问器提前结束
+     */
+    bool forEach(const Visitor& visitor) const;
+
+    /**
+     * @brief 计算轨迹概况（一次完整遍历）
+     */
+    Summary summarize() const;
+
+    /**
+     * @brief 保存到文件/从文件加载（加载失败时原内容不变）
+     */
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    /**
+     * @brief 清空轨迹
+     */
+    void clear();
+
+    uint64_t eventCount() const { return events_; }
+    uint64_t allocationCount() const { return allocations_; }
+    uint32_t threadCount() const { return threads_; }
+    size_t encodedBytes() const { return data_.size(); }
+    bool empty() const { return events_ == 0; }
+
+    std::string getLastError() const { return last_error_; }
+
+private:
+    void appendTag(Event::Type type, uint32_t thread);
+
+private:
+    std::vector<uint8_t> data_;     // 编码后的事件流
+    uint64_t events_ = 0;
+    uint64_t allocations_ = 0;
+    uint32_t threads_ = 0;
+    mutable std::string last_error_;
+};
+
+#endif // ALLOCATION_TRACE_H
@@ -1,4 +1,5 @@
 #include "cache_manager.h"
+#include "copy_accounting.h"
 #include <algorithm>
 #include <random>
 #include <sstream>
@@ -217,68 +218,68 @@ CacheManager<Key, Value>::SingleLevelCache::evictOne() {
         return {Key{}, nullptr};
     }
 
-    Key evict_key{};
-
-    // switch (policy_) {
-    // case EvictionPolicy::LRU: {
-    //     if (!lru_list_.empty()) {
-    //         evict_key = lru_list_.back();
-    //         lru_list_.pop_back();
-    //         lru_map_.erase(evict_key);
-    //     }
-    //     break;
-    // }
-    // case EvictionPolicy::LFU: {
-    //     if (!frequency_lists_[min_frequency_].empty()) {
-    //         evict_key = frequency_lists_[min_frequency_].back();
-    //         frequency_lists_[min_frequency_].pop_back();
-    //         frequency_map_.erase(evict_key);
-    //     }
-    //     break;
-    // }
-    // case EvictionPolicy::FIFO: {
-    //     if (!lru_list_.empty()) {
-    //         evict_key = lru_list_.back();
-    //         lru_list_.pop_back();
-    //         lru_map_.erase(evict_key);
-    //     }
-    //     break;
-    // }
-    // case EvictionPolicy::RANDOM: {
-    //     if (!cache_map_.empty()) {
-    //         static std::random_device rd;
-    //         static std::mt19937 gen(rd());
-    //         std::uniform_int_distribution<> dis(0, cache_map_.size() - 1);
-
-    //         auto it = cache_map_.begin();
-    //         std::advance(it, dis(gen));
-    //         evict_key = it->first;
-    //     }
-    //     break;
-    // }
-    // case EvictionPolicy::TTL: {
-    //     // 基于时间的淘汰
-    //     auto now = std::chrono::steady_clock::now();
-    //     auto oldest_time = now;
-
-    //     for (const auto& pair : cache_map_) {
-    //         if (pair.second->created_time < oldest_time) {
-    //             oldest_time = pair.second->created_time;
-    //             evict_key = pair.first;
-    //         }
-    //     }
-    //     break;
-    // }
-    // default:
-    //     if (!cache_map_.empty()) {
-    //         evict_key = cache_map_.begin()->first;
-    //     }
-    //     break;
-    // }
-
-    auto entry = cache_map_[evict_key];
-    cache_map_.erase(evict_key);
+    auto victim = cache_map_.end();
 
+    switch (policy_) {
+    case EvictionPolicy::LRU:
+        if (!lru_list_.empty()) {
+            victim = cache_map_.find(lru_list_.back());
+        }
+        break;
+    case EvictionPolicy::LFU: {
+        // min_frequency_可能滞后（删除后只做了+1），找第一个非空的频率链表
+        auto list_it = frequency_lists_.find(min_frequency_);
+        if (list_it == frequency_lists_.end() || list_it->second.empty()) {
+            size_t best = 0;
+            for (const auto& pair : frequency_lists_) {
+                if (!pair.second.empty() && (best == 0 || pair.first < best)) {
+                    best = pair.first;
+                }
+            }
+            min_frequency_ = best > 0 ? best : 1;
+            list_it = frequency_lists_.find(min_frequency_);
+        }
+        if (list_it != frequency_lists_.end() && !list_it->second.empty()) {
+            victim = cache_map_.find(list_it->second.back());
+        }
+        break;
+    }
+    case EvictionPolicy::RANDOM: {
+        static thread_local std::mt19937 gen(std::random_device{}());
+        std::uniform_int_distribution<size_t> dis(0, cache_map_.size() - 1);
+        victim = cache_map_.begin();
+        std::advance(victim, dis(gen));
+        break;
+    }
+    default:
+        break;
+    }
+
+    // FIFO/TTL/ADAPTIVE，以及上面的数据结构缺失时：淘汰最早创建的条目
+    if (victim == cache_map_.end()) {
+        victim = cache_map_.begin();
+        for (auto it = cache_map_.begin(); it != cache_map_.end(); ++it) {
+            if (it->second->created_time < victim->second->created_time) {
+                victim = it;
+            }
+        }
+    }
+
+    Key evict_key = victim->first;
+    auto entry = victim->second;
+
+    auto lru_it = lru_map_.find(evict_key);
+    if (lru_it != lru_map_.end()) {
+        lru_list_.erase(lru_it->second);
+        lru_map_.erase(lru_it);
+    }
+    auto freq_it = frequency_map_.find(evict_key);
+    if (freq_it != frequency_map_.end()) {
+        frequency_lists_[freq_it->second.first].erase(freq_it->second.second);
+        frequency_map_.erase(freq_it);
+    }
+
+    cache_map_.erase(victim);
     return {evict_key, entry};
 }
 
@@ -313,7 +314,7 @@ std::shared_ptr<Value> CacheManager<Key, Value>::get(const Key& key) {
 
         // 检查是否需要提升
         if (config_.enable_prefetch) {
-            checkForPromotion(entry);
+            checkForPromotion(key, entry);
         }
 
         // 解压缩（如果需要）
@@ -321,6 +322,8 @@ std::shared_ptr<Value> CacheManager<Key, Value>::get(const Key& key) {
             decompressEntry(entry);
         }
 
+        // 命中时返回值的副本
+        COPY_ACCOUNT("cache.get", copyAccountingBytes(entry->value));
         return std::make_shared<Value>(entry->value);
     }
 
@@ -534,6 +537,142 @@ std::string CacheManager<Key, Value>::generateReport() const {
     return oss.str();
 }
 
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::setCompressionFunctions(
+    std::function<std::vector<uint8_t>(const Value&)> compressor,
+    std::function<Value(const std::vector<uint8_t>&)> decompressor) {
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    compressor_ = std::move(compressor);
+    decompressor_ = std::move(decompressor);
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::setCacheWarningCallback(std::function<void(CacheLevel, double)> callback) {
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    warning_callback_ = std::move(callback);
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::checkForPromotion(const Key& key, std::shared_ptr<CacheEntry> entry) {
+    if (entry->level == CacheLevel::L1) {
+        return;
+    }
+
+    // 命中次数占访问次数的比例达到阈值，且至少被访问过两次，提升到上一级
+    size_t access = entry->access_count.load();
+    size_t hits = entry->hit_count.load();
+    if (access >= 2 && static_cast<double>(hits) / access >= config_.promote_threshold) {
+        promoteEntry(key, entry);
+    }
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::promoteEntry(const Key& key, std::shared_ptr<CacheEntry> entry) {
+    SingleLevelCache* from = entry->level == CacheLevel::L3 ? l3_cache_.get() : l2_cache_.get();
+    SingleLevelCache* to = entry->level == CacheLevel::L3 ? l2_cache_.get() : l1_cache_.get();
+    CacheLevel target = entry->level == CacheLevel::L3 ? CacheLevel::L2 : CacheLevel::L1;
+
+    if (entry->is_compressed) {
+        decompressEntry(entry);
+    }
+    if (!from->remove(key)) {
+        return;  // 已被其他线程移走
+    }
+    entry->level = target;
+    to->put(key, entry);
+    stats_.promotions.fetch_add(1);
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::demoteEntry(const Key& key, std::shared_ptr<CacheEntry> entry) {
+    if (entry->level == CacheLevel::L3) {
+        return;
+    }
+    SingleLevelCache* from = entry->level == CacheLevel::L1 ? l1_cache_.get() : l2_cache_.get();
+    SingleLevelCache* to = entry->level == CacheLevel::L1 ? l2_cache_.get() : l3_cache_.get();
+    CacheLevel target = entry->level == CacheLevel::L1 ? CacheLevel::L2 : CacheLevel::L3;
+
+    from->remove(key);
+    entry->level = target;
+    to->put(key, entry);
+    if (target == CacheLevel::L3 && config_.enable_compression) {
+        compressEntry(entry);
+    }
+    stats_.demotions.fetch_add(1);
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::compressEntry(std::shared_ptr<CacheEntry> entry) {
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    // 未设置压缩函数时保持原样
+    if (!compressor_ || !decompressor_ || entry->is_compressed) {
+        return;
+    }
+    entry->compressed_data = compressor_(entry->value);
+    entry->value = Value{};
+    entry->is_compressed = true;
+    stats_.compressions.fetch_add(1);
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::decompressEntry(std::shared_ptr<CacheEntry> entry) {
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    if (!entry->is_compressed || !decompressor_) {
+        return;
+    }
+    entry->value = decompressor_(entry->compressed_data);
+    entry->compressed_data.clear();
+    entry->compressed_data.shrink_to_fit();
+    entry->is_compressed = false;
+}
+
+template<typename Key, typename Value>
+void CacheManager<Key, Value>::forceGarbageCollection() {
+    std::function<void(CacheLevel, double)> callback;
+    {
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        callback = warning_callback_;
+    }
+
+    const std::pair<SingleLevelCache*, CacheLevel> levels[] = {
+        {l1_cache_.get(), CacheLevel::L1},
+        {l2_cache_.get(), CacheLevel::L2},
+        {l3_cache_.get(), CacheLevel::L3}
+    };
+
+    for (const auto& level : levels) {
+        SingleLevelCache* cache = level.first;
+        if (cache->capacity() == 0) {
+            continue;
+        }
+        double usage = static_cast<double>(cache->size()) / cache->capacity();
+        if (usage < 0.9) {
+            continue;
+        }
+        if (callback) {
+            callback(level.second, usage);
+        }
+
+        // 使用率过高：淘汰到90%以下，L1/L2淘汰的条目降级而不是直接丢弃
+        size_t target = cache->capacity() * 9 / 10;
+        size_t size = cache->size();
+        if (size <= target) {
+            continue;
+        }
+        auto evicted = cache->evictLeastUsed(size - target);
+        stats_.evictions.fetch_add(evicted.size());
+        if (level.second == CacheLevel::L3) {
+            continue;
+        }
+        for (auto& pair : evicted) {
+            SingleLevelCache* lower = level.second == CacheLevel::L1 ? l2_cache_.get() : l3_cache_.get();
+            pair.second->level = level.second == CacheLevel::L1 ? CacheLevel::L2 : CacheLevel::L3;
+            lower->put(pair.first, pair.second);
+            stats_.demotions.fetch_add(1);
+        }
+    }
+}
+
 // 显式实例化常用类型
 template class CacheManager<std::string, std::string>;
 template class CacheManager<int, std::vector<uint8_t>>;
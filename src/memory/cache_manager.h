@@ -11,6 +11,8 @@
 #include <thread>
 #include <condition_variable>
 #include <string>
+#include <tuple>
+#include <vector>
 
 /**
  * @brief 智能多级缓存管理器
@@ -94,6 +96,7 @@ public:
         size_t size;                    // 数据大小
         bool is_compressed;             // 是否已压缩
         CacheLevel level;               // 当前缓存级别
+        std::vector<uint8_t> compressed_data;   // 压缩后的数据（is_compressed时有效）
 
         CacheEntry(Value&& val, size_t sz, CacheLevel lvl)
             : value(std::move(val))
@@ -350,7 +353,7 @@ private:
     /**
      * @brief 检查是否需要提升/降级
      */
-    void checkForPromotion(std::shared_ptr<CacheEntry> entry);
+    void checkForPromotion(const Key& key, std::shared_ptr<CacheEntry> entry);
 
     /**
      * @brief 清理过期项
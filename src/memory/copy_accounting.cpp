@@ -0,0 +1,194 @@
+#include "copy_accounting.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace {
+
+thread_local int current_stream = -1;
+
+std::string formatBytes(double bytes) {
+    static const char* const units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << bytes << " " << units[unit];
+    return out.str();
+}
+
+} // namespace
+
+void CopyAccounting::Site::record(size_t bytes) {
+    copies_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    const int stream = current_stream;
+    stream_bytes_[stream >= 0 && stream < kMaxStreams ? stream : kMaxStreams]
+        .fetch_add(bytes, std::memory_order_relaxed);
+}
+
+CopyAccounting& CopyAccounting::instance() {
+    static CopyAccounting accounting;
+    return accounting;
+}
+
+CopyAccounting::CopyAccounting()
+    : sites_(new Site[kMaxSites]) {
+}
+
+CopyAccounting::Site& CopyAccounting::site(const std::string& tag) {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+
+    const size_t count = site_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (sites_[i].tag_ == tag) {
+            return sites_[i];
+        }
+    }
+    if (count >= kMaxSites) {
+        return overflow_;
+    }
+
+    // 先写好标签再发布槽位，快照看到的槽位总是完整的
+    Site& slot = sites_[count];
+    slot.tag_ = tag;
+    site_count_.store(count + 1, std::memory_order_release);
+    return slot;
+}
+
+int CopyAccounting::stream(const std::string& name) {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+
+    const int count = stream_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (streams_[i].name == name) {
+            return i;
+        }
+    }
+    if (count >= kMaxStreams) {
+        return -1;
+    }
+    streams_[count].name = name;
+    stream_count_.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void CopyAccounting::addFrame(int stream_id, uint64_t frames) {
+    if (stream_id >= 0 && stream_id < stream_count_.load(std::memory_order_acquire)) {
+        streams_[stream_id].frames.fetch_add(frames, std::memory_order_relaxed);
+    }
+}
+
+CopyAccounting::Snapshot CopyAccounting::snapshot() const {
+    const size_t site_count = site_count_.load(std::memory_order_acquire);
+    const int stream_count = stream_count_.load(std::memory_order_acquire);
+
+    Snapshot snapshot;
+    snapshot.total_bytes = 0;
+    snapshot.unattributed_bytes = 0;
+    for (int i = 0; i < stream_count; ++i) {
+        snapshot.streams.push_back({streams_[i].name, streams_[i].frames.load(std::memory_order_relaxed), 0});
+    }
+
+    std::map<std::string, StageStatistics> stages;
+    for (size_t i = 0; i < site_count; ++i) {
+        const Site& site = sites_[i];
+        SiteStatistics stats;
+        stats.tag = site.tag_;
+        stats.stage = site.tag_.substr(0, site.tag_.find('.'));
+        stats.copies = site.copies_.load(std::memory_order_relaxed);
+        stats.bytes = site.bytes_.load(std::memory_order_relaxed);
+        stats.stream_bytes.resize(stream_count);
+        for (int s = 0; s < stream_count; ++s) {
+            stats.stream_bytes[s] = site.stream_bytes_[s].load(std::memory_order_relaxed);
+            snapshot.streams[s].bytes += stats.stream_bytes[s];
+        }
+        stats.unattributed_bytes = site.stream_bytes_[kMaxStreams].load(std::memory_order_relaxed);
+
+        StageStatistics& stage = stages[stats.stage];
+        stage.name = stats.stage;
+        stage.copies += stats.copies;
+        stage.bytes += stats.bytes;
+
+        snapshot.total_bytes += stats.bytes;
+        snapshot.unattributed_bytes += stats.unattributed_bytes;
+        snapshot.sites.push_back(std::move(stats));
+    }
+    for (auto& entry : stages) {
+        snapshot.stages.push_back(entry.second);
+    }
+
+    std::stable_sort(snapshot.sites.begin(), snapshot.sites.end(),
+                     [](const SiteStatistics& a, const SiteStatistics& b) { return a.bytes > b.bytes; });
+    std::stable_sort(snapshot.stages.begin(), snapshot.stages.end(),
+                     [](const StageStatistics& a, const StageStatistics& b) { return a.bytes > b.bytes; });
+    return snapshot;
+}
+
+std::string CopyAccounting::report() const {
+    const Snapshot snapshot = this->snapshot();
+    std::ostringstream out;
+
+    out << "=== Copy Accounting ===\n";
+    out << "Total copied: " << formatBytes(static_cast<double>(snapshot.total_bytes))
+        << " (unattributed " << formatBytes(static_cast<double>(snapshot.unattributed_bytes)) << ")\n";
+
+    out << "\nStreams:\n";
+    for (const StreamStatistics& stream : snapshot.streams) {
+        out << "  " << std::left << std::setw(12) << stream.name << std::right
+            << " frames " << std::setw(8) << stream.frames
+            << "  copied " << std::setw(10) << formatBytes(static_cast<double>(stream.bytes))
+            << "  per frame " << formatBytes(stream.bytesPerFrame()) << "\n";
+    }
+
+    out << "\nStages:\n";
+    for (const StageStatistics& stage : snapshot.stages) {
+        out << "  " << std::left << std::setw(12) << stage.name << std::right
+            << " copies " << std::setw(8) << stage.copies
+            << "  copied " << formatBytes(static_cast<double>(stage.bytes)) << "\n";
+    }
+
+    out << "\nSites:\n";
+    for (const SiteStatistics& site : snapshot.sites) {
+        out << "  " << std::left << std::setw(28) << site.tag << std::right
+            << " copies " << std::setw(8) << site.copies
+            << "  copied " << std::setw(10) << formatBytes(static_cast<double>(site.bytes));
+        // 每帧拷贝量按流分别换算
+        for (size_t s = 0; s < site.stream_bytes.size(); ++s) {
+            if (site.stream_bytes[s] > 0 && snapshot.streams[s].frames > 0) {
+                out << "  " << snapshot.streams[s].name << " "
+                    << formatBytes(static_cast<double>(site.stream_bytes[s]) / snapshot.streams[s].frames) << "/frame";
+            }
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+void CopyAccounting::reset() {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    const size_t site_count = site_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < site_count; ++i) {
+        sites_[i].copies_.store(0, std::memory_order_relaxed);
+        sites_[i].bytes_.store(0, std::memory_order_relaxed);
+        for (auto& bytes : sites_[i].stream_bytes_) {
+            bytes.store(0, std::memory_order_relaxed);
+        }
+    }
+    const int stream_count = stream_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < stream_count; ++i) {
+        streams_[i].frames.store(0, std::memory_order_relaxed);
+    }
+}
+
+int CopyAccounting::currentStream() {
+    return current_stream;
+}
+
+void CopyAccounting::setCurrentStream(int stream_id) {
+    current_stream = stream_id;
+}
@@ -0,0 +1,270 @@
+#ifndef COPY_ACCOUNTING_H
+#define COPY_ACCOUNTING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 批量拷贝计量：按调用点标签统计拷贝字节数，换算为每帧、每阶段、每条流
+ *
+ * 设计特点：
+ * 1. 调用点标签：标签格式为"<阶段>.<调用点>"（如cache.get、render.convert_staging），
+ *    每个调用点在首次执行时注册一次，之后只有relaxed原子加
+ * 2. 流归属：线程通过COPY_ACCOUNT_STREAM声明当前处理的流（video/audio），
+ *    该线程上的拷贝记入这条流；没有声明的记为未归属（缓存等与流无关的拷贝）
+ * 3. 每帧字节：COPY_ACCOUNT_FRAME在流的帧边界计数，流的拷贝字节除以帧数即每帧拷贝量
+ * 4. 编译期开关：未定义COPY_ACCOUNTING_ENABLED（CMake选项ENABLE_COPY_ACCOUNTING）时，
+ *    COPY_*宏展开为原始拷贝或空语句，调用点没有任何额外指令；统计类本身始终可用
+ *
+ * 用法：
+ *   COPY_ACCOUNT_STREAM("video");                              // 线程作用域
+ *   COPY_MEMCPY("framebus.publish", dst, src, bytes);          // 拷贝并计量
+ *   COPY_ACCOUNT("frame.clone", copyAccountingFrameBytes(frame));          // 只计量
+ *   COPY_ACCOUNT_IF(!av_frame_is_writable(frame), "frame.make_writable", ...); // 条件计量
+ *   COPY_ACCOUNT_FRAME("video");                               // 帧边界
+ */
+class CopyAccounting
+{
+public:
+    static constexpr size_t kMaxSites = 256;
+    static constexpr int kMaxStreams = 16;
+
+    /**
+     * @brief 单个调用点（地址固定，调用点缓存引用）
+     */
+    class Site {
+    public:
+        const std::string& tag() const { return tag_; }
+
+        /**
+         * @brief 记入一次拷贝，流取当前线程的归属
+         */
+        void record(size_t bytes);
+
+    private:
+        friend class CopyAccounting;
+
+        std::string tag_;
+        std::atomic<uint64_t> copies_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> stream_bytes_[kMaxStreams + 1] = {};    // 末位为未归属
+    };
+
+    /**
+     * @brief 调用点统计
+     */
+    struct SiteStatistics {
+        std::string tag;
+        std::string stage;                      // 标签第一段
+        uint64_t copies;
+        uint64_t bytes;
+        std::vector<uint64_t> stream_bytes;     // 下标与Snapshot::streams一致
+        uint64_t unattributed_bytes;
+    };
+
+    /**
+     * @brief 阶段统计（同一阶段的调用点合计）
+     */
+    struct StageStatistics {
+        std::string name;
+        uint64_t copies;
+        uint64_t bytes;
+    };
+
+    /**
+     * @brief 流统计
+     */
+    struct StreamStatistics {
+        std::string name;
+        uint64_t frames;
+        uint64_t bytes;
+
+        double bytesPerFrame() const {
+            return frames > 0 ? static_cast<double>(bytes) / frames : 0.0;
+        }
+    };
+
+    struct Snapshot {
+        std::vector<SiteStatistics> sites;      // 按字节数降序
+        std::vector<StageStatistics> stages;    // 按字节数降序
+        std::vector<StreamStatistics> streams;  // 按注册顺序
+        uint64_t total_bytes;
+        uint64_t unattributed_bytes;
+    };
+
+public:
+    static CopyAccounting& instance();
+
+    CopyAccounting();
+
+    CopyAccounting(const CopyAccounting&) = delete;
+    CopyAccounting& operator=(const CopyAccounting&) = delete;
+
+    /**
+     * @brief 获取或注册调用点（加锁，调用方缓存返回的引用）
+     *
+     * 槽位用尽时返回一个不参与统计的占位调用点。
+     */
+    Site& site(const std::string& tag);
+
+    /**
+     * @brief 获取或注册流（加锁），超过kMaxStreams时返回-1（记为未归属）
+     */
+    int stream(const std::string& name);
+
+    /**
+     * @brief 流的帧边界
+     */
+    void addFrame(int stream_id, uint64_t frames = 1);
+
+    Snapshot snapshot() const;
+
+    /**
+     * @brief 文本报告：调用点、阶段和流三张表
+     */
+    std::string report() const;
+
+    /**
+     * @brief 清零计数，保留已注册的调用点和流
+     */
+    void reset();
+
+    /**
+     * @brief 当前线程的流归属，-1表示未归属
+     */
+    static int currentStream();
+    static void setCurrentStream(int stream_id);
+
+private:
+    struct StreamSlot {
+        std::string name;
+        std::atomic<uint64_t> frames{0};
+    };
+
+    std::unique_ptr<Site[]> sites_;
+    std::atomic<size_t> site_count_{0};
+    Site overflow_;
+
+    StreamSlot streams_[kMaxStreams];
+    std::atomic<int> stream_count_{0};
+
+    std::mutex register_mutex_;
+};
+
+/**
+ * @brief 作用域内设置当前线程的流归属，析构时恢复
+ */
+class CopyStreamScope
+{
+public:
+    explicit CopyStreamScope(int stream_id)
+        : previous_(CopyAccounting::currentStream()) {
+        CopyAccounting::setCurrentStream(stream_id);
+    }
+
+    ~CopyStreamScope() {
+        CopyAccounting::setCurrentStream(previous_);
+    }
+
+    CopyStreamScope(const CopyStreamScope&) = delete;
+    CopyStreamScope& operator=(const CopyStreamScope&) = delete;
+
+private:
+    int previous_;
+};
+
+namespace copy_accounting_detail {
+
+template<typename T, typename = void>
+struct HasDataSize : std::false_type {};
+
+template<typename T>
+struct HasDataSize<T, std::void_t<decltype(std::declval<const T&>().data()),
+                                  decltype(std::declval<const T&>().size())>> : std::true_type {};
+
+} // namespace copy_accounting_detail
+
+/**
+ * @brief 值拷贝的字节数：连续容器（string、vector）按元素计，其余按对象大小
+ */
+template<typename T>
+size_t copyAccountingBytes(const T& value) {
+    if constexpr (copy_accounting_detail::HasDataSize<T>::value) {
+        return value.size() * sizeof(*value.data());
+    } else {
+        return sizeof(T);
+    }
+}
+
+/**
+ * @brief 帧引用的全部缓冲区字节数（AVFrame的buf与extended_buf），深拷贝时即拷贝量
+ */
+template<typename Frame>
+size_t copyAccountingFrameBytes(const Frame* frame) {
+    if (!frame) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (size_t i = 0; i < sizeof(frame->buf) / sizeof(frame->buf[0]); ++i) {
+        bytes += frame->buf[i] ? static_cast<size_t>(frame->buf[i]->size) : 0;
+    }
+    for (int i = 0; i < frame->nb_extended_buf; ++i) {
+        bytes += static_cast<size_t>(frame->extended_buf[i]->size);
+    }
+    return bytes;
+}
+
+#define COPY_ACCOUNTING_CONCAT_INNER(a, b) a##b
+#define COPY_ACCOUNTING_CONCAT(a, b) COPY_ACCOUNTING_CONCAT_INNER(a, b)
+
+#ifdef COPY_ACCOUNTING_ENABLED
+
+#define COPY_ACCOUNT(tag, bytes) \
+    do { \
+        static CopyAccounting::Site& copy_site_ = CopyAccounting::instance().site(tag); \
+        copy_site_.record(bytes); \
+    } while (0)
+
+#define COPY_ACCOUNT_IF(condition, tag, bytes) \
+    do { \
+        if (condition) { \
+            COPY_ACCOUNT(tag, bytes); \
+        } \
+    } while (0)
+
+#define COPY_MEMCPY(tag, dst, src, bytes) \
+    do { \
+        const size_t copy_bytes_ = (bytes); \
+        std::memcpy((dst), (src), copy_bytes_); \
+        COPY_ACCOUNT(tag, copy_bytes_); \
+    } while (0)
+
+#define COPY_ACCOUNT_STREAM(name) \
+    static const int COPY_ACCOUNTING_CONCAT(copy_stream_id_, __LINE__) = CopyAccounting::instance().stream(name); \
+    CopyStreamScope COPY_ACCOUNTING_CONCAT(copy_stream_scope_, __LINE__)(COPY_ACCOUNTING_CONCAT(copy_stream_id_, __LINE__))
+
+#define COPY_ACCOUNT_FRAME(name) \
+    do { \
+        static const int copy_stream_id_ = CopyAccounting::instance().stream(name); \
+        CopyAccounting::instance().addFrame(copy_stream_id_); \
+    } while (0)
+
+#else
+
+#define COPY_ACCOUNT(tag, bytes) do { } while (0)
+#define COPY_ACCOUNT_IF(condition, tag, bytes) do { } while (0)
+#define COPY_MEMCPY(tag, dst, src, bytes) std::memcpy((dst), (src), (bytes))
+#define COPY_ACCOUNT_STREAM(name) do { } while (0)
+#define COPY_ACCOUNT_FRAME(name) do { } while (0)
+
+#endif
+
+#endif // COPY_ACCOUNTING_H
@@ -4,7 +4,10 @@
 #include <iomanip>
 #include <chrono>
 
-MemoryManager::MemoryManager(const Config& config) : config_(config) {
+MemoryManager::MemoryManager(const Config& config)
+    : config_(config)
+    , pressure_metric_(media::MetricsRegistry::instance().gauge("memory.pressure_level")) {
+    pressure_metric_.set(static_cast<double>(PressureLevel::LOW));
 }
 
 MemoryManager::~MemoryManager() {
@@ -603,6 +606,7 @@ void MemoryManager::checkMemoryPressure() {
     }
 
     PressureLevel old_level = current_pressure_level_.exchange(new_level);
+    pressure_metric_.set(static_cast<double>(new_level));
 
     if (new_level != old_level && new_level >= PressureLevel::HIGH) {
         handleMemoryPressure(new_level);
@@ -18,6 +18,7 @@
 #include "packet_recycler.h"
 #include "cache_manager.h"
 #include "smart_pointers.h"
+#include "../utils/metrics_registry.h"
 
 /**
  * @brief 统一内存管理系统
@@ -344,6 +345,7 @@ private:
     // 状态标志
     std::atomic<bool> initialized_{false};
     std::atomic<PressureLevel> current_pressure_level_{PressureLevel::LOW};
+    media::Metric& pressure_metric_;    // 性能浮层：memory.pressure_level
 };
 
 /**
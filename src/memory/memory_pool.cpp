@@ -648,9 +648,9 @@ void MemoryPool::deallocateToPool(void* ptr)
     for(auto* pool : {small_pool_.get(), medium_pool_.get(), large_pool_.get()}){
         if(!pool) continue;
         
-        // 使用try_lock避免死锁
-        std::unique_lock<std::mutex> lock(pool->mutex, std::try_to_lock);
-        if(!lock.owns_lock()) continue;
+        // 必须阻塞等锁：try_lock失败时跳过本池会把池内指针交给std::free
+        // 调用方此时不持有任何池锁，不会死锁
+        std::lock_guard<std::mutex> lock(pool->mutex);
         
         // 检查指针是否在这个池的某个chunk中
         for(const auto& chunk : pool->chunks){
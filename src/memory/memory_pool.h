@@ -1,7 +1,6 @@
 #ifndef MEMORY_POOL_H
 #define MEMORY_POOL_H
 
-#include <QObject>
 #include <cstddef>              // size_t
 #include <vector>
 #include <memory>
@@ -29,12 +29,16 @@ MemoryTracker::~MemoryTracker()
     }
 }
 
-void MemoryTracker::recordAllocation(void* ptr,size_t size, const std::string& location)
+void MemoryTracker::recordAllocation(void* ptr,size_t size, const std::string& location, size_t alignment)
 {
     if(!ptr || shutdown_.load()){
         return ;
     }
 
+    if(isTracing()){
+        traceAllocation(ptr, size, alignment);
+    }
+
     // 更新统计信息
     stats_.allocation_count.fetch_add(1);
     stats_.total_allocated.fetch_add(size);
@@ -87,6 +91,10 @@ bool MemoryTracker::recordDeallocation(void* ptr)
         return false;
     }
 
+    if(isTracing()){
+        traceDeallocation(ptr);
+    }
+
     bool found = false;
     size_t size = 0;
 
@@ -418,3 +426,58 @@ std::string MemoryTracker::categorizeSize(size_t size) const {
     if (size <= 1024 * 1024) return "Large (64KB-1MB)";
     return "Huge (>1MB)";
 }
+
+void MemoryTracker::startTrace(size_t max_events) {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    trace_.clear();
+    trace_live_.clear();
+    trace_threads_.clear();
+    trace_max_events_ = max_events;
+    tracing_.store(true);
+}
+
+AllocationTrace MemoryTracker::stopTrace() {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    tracing_.store(false);
+    trace_live_.clear();
+    trace_threads_.clear();
+
+    AllocationTrace trace = std::move(trace_);
+    trace_.clear();
+    return trace;
+}
+
+void MemoryTracker::traceAllocation(void* ptr, size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    if (!tracing_.load() || trace_.eventCount() >= trace_max_events_) {
+        return;
+    }
+    const uint32_t thread = traceThreadIndex();
+    auto it = trace_live_.find(ptr);
+    if (it != trace_live_.end()) {
+        // 地址被复用说明漏记了释放：先补记旧分配的释放，否则回放时它一直存活，抬高峰值
+        trace_.addFree(thread, it->second);
+        it->second = trace_.addAllocation(thread, size, alignment);
+        return;
+    }
+    trace_live_.emplace(ptr, trace_.addAllocation(thread, size, alignment));
+}
+
+void MemoryTracker::traceDeallocation(void* ptr) {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    if (trace_.eventCount() >= trace_max_events_) {
+        return;
+    }
+    auto it = trace_live_.find(ptr);
+    if (it == trace_live_.end()) {
+        return;
+    }
+    trace_.addFree(traceThreadIndex(), it->second);
+    trace_live_.erase(it);
+}
+
+uint32_t MemoryTracker::traceThreadIndex() {
+    auto result = trace_threads_.emplace(std::this_thread::get_id(),
+                                         static_cast<uint32_t>(trace_threads_.size()));
+    return result.first->second;
+}
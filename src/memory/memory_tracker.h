@@ -1,7 +1,6 @@
 #ifndef MEMORY_TRACKER_H
 #define MEMORY_TRACKER_H
 
-#include <QObject>
 #include <atomic>
 #include <mutex>
 #include <unordered_map>
@@ -13,6 +12,7 @@
 #include <functional>
 #include <vector>
 
+#include "allocation_trace.h"
 
 /**
  * @brief 高级内存使用监控和分析系统
@@ -24,6 +24,8 @@
  * 4. 报告生成：详细的内存使用报告和图表数据
  * 5. 预警机制：内存使用过高时的回调通知
  * 6. 历史记录：保存一段时间的内存使用历史
+ * 7. 分配轨迹：按需记录紧凑的分配/释放序列（大小、对齐、线程、生命周期顺序），
+ *    供TraceReplayer离线回放比较分配器
  */
 class MemoryTracker
 {
@@ -154,8 +156,9 @@ public:
      * @param ptr 分配的内存指针
      * @param size 分配的字节数
      * @param location 分配位置（通常是文件名:行号）
+     * @param alignment 分配对齐（仅写入轨迹，0表示未知）
      */
-    void recordAllocation(void* ptr,size_t size, const std::string& location = "");
+    void recordAllocation(void* ptr,size_t size, const std::string& location = "", size_t alignment = 0);
 
     /**
      * @brief 记录内存释放
@@ -232,6 +235,20 @@ public:
      */
     bool isHealthy() const;
 
+    /**
+     * @brief 开始记录分配轨迹（丢弃之前的轨迹）
+     * @param max_events 事件数上限，达到后分配和释放都不再记录
+     * @note 开始前已存在的分配，其释放不会写入轨迹
+     */
+    void startTrace(size_t max_events = 50000000);
+
+    /**
+     * @brief 停止记录并取走轨迹
+     */
+    AllocationTrace stopTrace();
+
+    bool isTracing() const { return tracing_.load(std::memory_order_relaxed); }
+
 private:
     /**
      * @brief 历史记录线程函数
@@ -253,6 +270,17 @@ private:
      */
     std::string categorizeSize(size_t size) const;
 
+    /**
+     * @brief 写入轨迹事件（仅在isTracing()时调用）
+     */
+    void traceAllocation(void* ptr, size_t size, size_t alignment);
+    void traceDeallocation(void* ptr);
+
+    /**
+     * @brief 当前线程的轨迹编号，调用方持有trace_mutex_
+     */
+    uint32_t traceThreadIndex();
+
 private:
     Config config_;                         // 配置选项
     mutable Statistics stats_;              // 统计信息
@@ -278,12 +306,20 @@ private:
 
     // 生命周期管理
     std::atomic<bool> shutdown_{false};
+
+    // 分配轨迹
+    std::mutex trace_mutex_;
+    std::atomic<bool> tracing_{false};
+    AllocationTrace trace_;
+    size_t trace_max_events_ = 0;
+    std::unordered_map<void*, uint64_t> trace_live_;            // 指针 -> 分配编号
+    std::unordered_map<std::thread::id, uint32_t> trace_threads_;
 };
 
 #define MEMORY_TRACK_ALLOC(tracker, ptr, size) \
     do{ \
         if(tracker){ \
-            tracker->recordAllocation(ptr, size, __FILE__":" std::to_string(__LINE__)); \
+            tracker->recordAllocation(ptr, size, std::string(__FILE__ ":") + std::to_string(__LINE__)); \
         }\
     }while(0)
 
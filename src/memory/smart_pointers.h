@@ -6,6 +6,8 @@
 #include <vector>
 #include <mutex>
 
+#include "copy_accounting.h"
+
 // FFmpeg 头文件
 extern "C" {
 #include <libavformat/avformat.h>
@@ -442,7 +444,8 @@ public:
             return nullptr;
         }
 
-        // 确保缓冲区是可写的
+        // 确保缓冲区是可写的（新引用与原帧共享缓冲，这里必然复制整帧）
+        COPY_ACCOUNT("frame.clone", copyAccountingFrameBytes(new_frame));
         if (av_frame_make_writable(new_frame) < 0) {
             av_frame_free(&new_frame);
             return nullptr;
@@ -463,6 +466,9 @@ public:
      */
     bool makeWritable() {
         if (!frame_) return false;
+        // 缓冲仍被其他引用共享时会复制整帧
+        COPY_ACCOUNT_IF(!av_frame_is_writable(frame_.get()), "frame.make_writable",
+                        copyAccountingFrameBytes(frame_.get()));
         return av_frame_make_writable(frame_.get()) >= 0;
     }
 
@@ -0,0 +1,245 @@
+#include "trace_replayer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 槽位哨兵：分配失败/已释放的块在清理时跳过
+char g_failed_marker;
+char g_freed_marker;
+void* const kFailed = &g_failed_marker;
+void* const kFreed = &g_freed_marker;
+
+/**
+ * @brief 预先解码的轨迹：操作编码为 id<<1 | is_free，回放循环里不再解varint
+ */
+struct DecodedTrace {
+    std::vector<uint64_t> sizes;
+    std::vector<uint32_t> alignments;
+    std::vector<std::vector<uint64_t>> per_thread;
+    std::vector<uint64_t> ordered;
+    uint64_t operations = 0;
+    uint64_t peak_live_bytes = 0;
+};
+
+bool decode(const AllocationTrace& trace, bool threaded, DecodedTrace& out, std::string& error) {
+    out.sizes.reserve(trace.allocationCount());
+    out.alignments.reserve(trace.allocationCount());
+    if (threaded) {
+        out.per_thread.resize(std::max<uint32_t>(trace.threadCount(), 1));
+    } else {
+        out.ordered.reserve(trace.eventCount());
+    }
+
+    std::vector<bool> freed;
+    freed.reserve(trace.allocationCount());
+    uint64_t live_bytes = 0;
+
+    const bool ok = trace.forEach([&](const AllocationTrace::Event& event) {
+        const bool is_free = event.type == AllocationTrace::Event::Type::Free;
+        if (is_free) {
+            if (freed[event.id]) {
+                return true;                // 重复释放不回放
+            }
+            freed[event.id] = true;
+            live_bytes -= out.sizes[event.id];
+        } else {
+            out.sizes.push_back(event.size);
+            out.alignments.push_back(event.alignment);
+            freed.push_back(false);
+            live_bytes += event.size;
+            out.peak_live_bytes = std::max(out.peak_live_bytes, live_bytes);
+        }
+
+        const uint64_t op = (event.id << 1) | (is_free ? 1 : 0);
+        if (threaded) {
+            out.per_thread[event.thread].push_back(op);
+        } else {
+            out.ordered.push_back(op);
+        }
+        ++out.operations;
+        return true;
+    });
+
+    if (!ok) {
+        error = trace.getLastError();
+    }
+    return ok;
+}
+
+void touch(void* ptr, size_t size, size_t page_size) {
+    if (size == 0) {
+        return;
+    }
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(ptr);
+    for (size_t offset = 0; offset < size; offset += page_size) {
+        bytes[offset] = 1;
+    }
+    bytes[size - 1] = 1;
+}
+
+/**
+ * @brief 回放过程中的共享状态
+ */
+struct ReplayState {
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> live_bytes{0};
+    std::atomic<uint64_t> peak_live_bytes{0};
+};
+
+/**
+ * @brief 单个回放线程的操作循环，跨线程释放自旋等待对应分配完成
+ */
+void runOperations(const std::vector<uint64_t>& ops, const DecodedTrace& trace,
+                   std::atomic<void*>* slots, TraceReplayer::Allocator& allocator,
+                   const TraceReplayer::Config& config, ReplayState& state) {
+    for (uint64_t op : ops) {
+        const uint64_t id = op >> 1;
+        const size_t size = static_cast<size_t>(trace.sizes[id]);
+        const size_t alignment = trace.alignments[id];
+
+        if (op & 1) {
+            void* ptr = slots[id].load(std::memory_order_acquire);
+            while (!ptr) {
+                std::this_thread::yield();
+                ptr = slots[id].load(std::memory_order_acquire);
+            }
+            if (ptr != kFailed) {
+                allocator.deallocate(ptr, size, alignment);
+                state.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+            }
+            slots[id].store(kFreed, std::memory_order_relaxed);
+        } else {
+            void* ptr = allocator.allocate(size, alignment);
+            if (ptr) {
+                if (config.touch_pages) {
+                    touch(ptr, size, config.page_size);
+                }
+                const uint64_t live = state.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+                uint64_t peak = state.peak_live_bytes.load(std::memory_order_relaxed);
+                while (live > peak && !state.peak_live_bytes.compare_exchange_weak(
+                                          peak, live, std::memory_order_relaxed)) {
+                }
+            } else {
+                state.failed.fetch_add(1, std::memory_order_relaxed);
+                ptr = kFailed;
+            }
+            slots[id].store(ptr, std::memory_order_release);
+        }
+    }
+}
+
+size_t readStatusField(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const size_t length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0) {
+            return static_cast<size_t>(std::stoull(line.substr(length))) * 1024;   // kB
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+TraceReplayer::Result TraceReplayer::replay(const AllocationTrace& trace, Allocator& allocator,
+                                            const Config& config) {
+    Result result;
+    result.allocator = allocator.name();
+
+    DecodedTrace decoded;
+    if (!decode(trace, config.threaded, decoded, result.error)) {
+        return result;
+    }
+    result.operations = decoded.operations;
+    result.trace_peak_live_bytes = decoded.peak_live_bytes;
+
+    const size_t slot_count = decoded.sizes.size();
+    std::unique_ptr<std::atomic<void*>[]> slots(new std::atomic<void*>[slot_count]);
+    for (size_t i = 0; i < slot_count; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    ReplayState state;
+
+    result.peak_rss_reset = resetPeakRss();
+    result.baseline_rss_bytes = currentRss();
+
+    std::chrono::steady_clock::time_point start;
+    if (config.threaded) {
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        threads.reserve(decoded.per_thread.size());
+        for (const auto& ops : decoded.per_thread) {
+            threads.emplace_back([&, ops_ptr = &ops] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                runOperations(*ops_ptr, decoded, slots.get(), allocator, config, state);
+            });
+        }
+        while (ready.load() < threads.size()) {
+            std::this_thread::yield();
+        }
+        start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    } else {
+        start = std::chrono::steady_clock::now();
+        runOperations(decoded.ordered, decoded, slots.get(), allocator, config, state);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    result.peak_rss_bytes = peakRss();
+    result.fragmentation = allocator.fragmentation();
+
+    // 轨迹结束时仍存活的块（记录停止时还在用的缓冲区）不计时归还
+    for (size_t id = 0; id < slot_count; ++id) {
+        void* ptr = slots[id].load(std::memory_order_relaxed);
+        if (ptr && ptr != kFailed && ptr != kFreed) {
+            allocator.deallocate(ptr, static_cast<size_t>(decoded.sizes[id]), decoded.alignments[id]);
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.ns_per_operation = result.operations > 0 ? result.seconds * 1e9 / result.operations : 0.0;
+    result.failed_allocations = state.failed.load();
+    result.replay_peak_live_bytes = state.peak_live_bytes.load();
+
+    const size_t rss_growth = result.peak_rss_bytes > result.baseline_rss_bytes
+                                  ? result.peak_rss_bytes - result.baseline_rss_bytes : 0;
+    result.overhead_ratio = rss_growth > 0
+        ? 1.0 - static_cast<double>(result.replay_peak_live_bytes) / static_cast<double>(rss_growth) : 0.0;
+
+    result.success = true;
+    return result;
+}
+
+size_t TraceReplayer::currentRss() {
+    return readStatusField("VmRSS:");
+}
+
+size_t TraceReplayer::peakRss() {
+    return readStatusField("VmHWM:");
+}
+
+bool TraceReplayer::resetPeakRss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (!clear_refs) {
+        return false;
+    }
+    clear_refs << "5";
+    clear_refs.flush();
+    return static_cast<bool>(clear_refs);
+}
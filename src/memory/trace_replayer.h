@@ -0,0 +1,106 @@
+#ifndef TRACE_REPLAYER_H
+#define TRACE_REPLAYER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "allocation_trace.h"
+
+/**
+ * @brief 用记录的分配轨迹驱动任意分配器，测量时间、峰值RSS和碎片
+ *
+ * 设计特点：
+ * 1. 分配器无关：通过Allocator接口接入MemoryPool、系统malloc或其他池化实现
+ * 2. 保持原线程：默认每个记录线程一个回放线程，跨线程释放等待对应分配完成后才执行，
+ *    分配器看到的并发和跨线程归还与真实运行一致；线程之间只保留这种先后关系，
+ *    交错与记录时不同，存活量以回放中实际测到的为准
+ * 3. 触页：默认对每个分配按页写一个字节，RSS反映真实占用而不是虚拟预留
+ * 4. 峰值RSS：回放前通过/proc/self/clear_refs重置VmHWM（不支持时退化为进程生命周期峰值），
+ *    同一进程内回放多个分配器会互相影响，比较时每个分配器应在独立进程中回放
+ */
+class TraceReplayer
+{
+public:
+    /**
+     * @brief 被回放的分配器
+     */
+    class Allocator {
+    public:
+        virtual ~Allocator() = default;
+
+        virtual std::string name() const = 0;
+        virtual void* allocate(size_t size, size_t alignment) = 0;
+        virtual void deallocate(void* ptr, size_t size, size_t alignment) = 0;
+
+        /**
+         * @brief 分配器自身统计的碎片率（0-1），不支持时返回负数
+         */
+        virtual double fragmentation() const { return -1.0; }
+    };
+
+    /**
+     * @brief 回放选项
+     */
+    struct Config {
+        bool threaded;          // 按记录线程并行回放；false时单线程按全局顺序回放
+        bool touch_pages;       // 分配后按页写入
+        size_t page_size;       // 触页步长
+
+        Config()
+            : threaded(true)
+            , touch_pages(true)
+            , page_size(4096)
+        {}
+    };
+
+    /**
+     * @brief 回放结果
+     */
+    struct Result {
+        bool success;
+        std::string error;
+        std::string allocator;
+
+        double seconds;                 // 回放耗时（不含解码和轨迹末尾未释放块的清理）
+        uint64_t operations;            // 分配+释放次数
+        double ns_per_operation;
+        uint64_t failed_allocations;    // 分配器返回nullptr的次数
+
+        size_t baseline_rss_bytes;      // 回放前的RSS
+        size_t peak_rss_bytes;          // 回放期间的峰值RSS
+        bool peak_rss_reset;            // false表示峰值是整个进程生命周期的
+        uint64_t trace_peak_live_bytes;     // 按记录顺序同时存活的最大字节数
+        uint64_t replay_peak_live_bytes;    // 回放中实际同时存活的最大字节数
+
+        double overhead_ratio;          // 1 - 回放峰值存活字节 / 峰值RSS增量，越小越省
+        double fragmentation;           // 回放结束时分配器报告的碎片率，负数表示不支持
+
+        Result()
+            : success(false), seconds(0.0), operations(0), ns_per_operation(0.0)
+            , failed_allocations(0), baseline_rss_bytes(0), peak_rss_bytes(0)
+            , peak_rss_reset(false), trace_peak_live_bytes(0), replay_peak_live_bytes(0)
+            , overhead_ratio(0.0)
+            , fragmentation(-1.0)
+        {}
+    };
+
+public:
+    /**
+     * @brief 回放一遍轨迹
+     */
+    static Result replay(const AllocationTrace& trace, Allocator& allocator, const Config& config = Config{});
+
+    /**
+     * @brief 读取/proc/self/status里的VmRSS和VmHWM（字节），不支持时返回0
+     */
+    static size_t currentRss();
+    static size_t peakRss();
+
+    /**
+     * @brief 把VmHWM重置为当前RSS
+     */
+    static bool resetPeakRss();
+};
+
+#endif // TRACE_REPLAYER_H
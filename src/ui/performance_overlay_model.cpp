@@ -0,0 +1,202 @@
+#include "performance_overlay_model.h"
+
+#include <QStringList>
+#include <QVariantMap>
+#include <algorithm>
+#include <cstring>
+
+namespace media {
+
+namespace {
+
+constexpr int kDefaultIntervalMs = 500;
+constexpr int kMinIntervalMs = 50;
+
+// 去掉分组前缀：stage.video_decode -> video_decode
+QString shortName(const std::string& name) {
+    const size_t dot = name.find('.');
+    return QString::fromStdString(dot == std::string::npos ? name : name.substr(dot + 1));
+}
+
+// loudness.<流>.<字段>的字段名 -> QML属性名
+QString loudnessField(const std::string& field) {
+    if (field == "short_term") {
+        return QStringLiteral("shortTerm");
+    }
+    if (field == "true_peak") {
+        return QStringLiteral("truePeak");
+    }
+    return QString::fromStdString(field);
+}
+
+bool hasPrefix(const std::string& name, const char* prefix) {
+    return name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+}
+
+} // namespace
+
+PerformanceOverlayModel::PerformanceOverlayModel(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent)
+    , registry_(registry ? *registry : MetricsRegistry::instance()) {
+    timer_.setInterval(kDefaultIntervalMs);
+    connect(&timer_, &QTimer::timeout, this, &PerformanceOverlayModel::sampleNow);
+}
+
+PerformanceOverlayModel::~PerformanceOverlayModel() {
+    setActive(false);
+}
+
+void PerformanceOverlayModel::setActive(bool active) {
+    if (active_ == active) {
+        return;
+    }
+    active_ = active;
+    registry_.setCollecting(active);
+    if (active) {
+        // 第一个窗口从现在开始，避免把隐藏期间的累计量算进fps
+        previous_.clear();
+        sampleNow();
+        timer_.start();
+    } else {
+        timer_.stop();
+    }
+    emit activeChanged();
+}
+
+void PerformanceOverlayModel::setIntervalMs(int interval_ms) {
+    interval_ms = std::max(interval_ms, kMinIntervalMs);
+    if (timer_.interval() == interval_ms) {
+        return;
+    }
+    timer_.setInterval(interval_ms);
+    emit intervalMsChanged();
+}
+
+QString PerformanceOverlayModel::memoryPressure() const {
+    switch (memory_pressure_level_) {
+    case 0: return QStringLiteral("LOW");
+    case 1: return QStringLiteral("MODERATE");
+    case 2: return QStringLiteral("HIGH");
+    case 3: return QStringLiteral("CRITICAL");
+    default: return QStringLiteral("N/A");
+    }
+}
+
+void PerformanceOverlayModel::sampleNow() {
+    const double seconds = elapsed_.isValid() ? elapsed_.restart() / 1000.0 : 0.0;
+    if (!elapsed_.isValid()) {
+        elapsed_.start();
+    }
+    const bool have_window = seconds > 0.0 && !previous_.isEmpty();
+
+    QVariantList stages;
+    QVariantList queues;
+    QVariantList pools;
+    QVariantList drops;
+    QStringList loudness_streams;
+    QHash<QString, QVariantMap> loudness;
+    QStringList counter_stages;
+    QHash<QString, QHash<QString, double>> counters;
+    qulonglong dropped = 0;
+    int pressure = -1;
+
+    for (const MetricSample& sample : registry_.snapshot(true)) {
+        const QString key = QString::fromStdString(sample.name);
+        const Previous previous = previous_.value(key);
+        previous_.insert(key, Previous{sample.count, sample.total_us});
+
+        if (sample.type == MetricType::Latency && hasPrefix(sample.name, "stage.")) {
+            const uint64_t frames = sample.count - std::min(previous.count, sample.count);
+            const int64_t total_us = sample.total_us - previous.total_us;
+            QVariantMap stage;
+            stage.insert(QStringLiteral("name"), shortName(sample.name));
+            stage.insert(QStringLiteral("fps"), have_window ? frames / seconds : 0.0);
+            stage.insert(QStringLiteral("latencyMs"), frames > 0 ? total_us / 1000.0 / frames : 0.0);
+            stage.insert(QStringLiteral("maxLatencyMs"), sample.max_us / 1000.0);
+            stages.append(stage);
+        } else if (sample.type == MetricType::Gauge && hasPrefix(sample.name, "queue.")) {
+            QVariantMap queue;
+            queue.insert(QStringLiteral("name"), shortName(sample.name));
+            queue.insert(QStringLiteral("depth"), sample.value);
+            queues.append(queue);
+        } else if (hasPrefix(sample.name, "pool.")) {
+            QVariantMap pool;
+            pool.insert(QStringLiteral("name"), shortName(sample.name));
+            pool.insert(QStringLiteral("hitRate"), sample.value);
+            pools.append(pool);
+        } else if (sample.type == MetricType::Counter && hasPrefix(sample.name, "drop.")) {
+            const uint64_t delta = sample.count - std::min(previous.count, sample.count);
+            QVariantMap drop;
+            drop.insert(QStringLiteral("name"), shortName(sample.name));
+            drop.insert(QStringLiteral("total"), static_cast<qulonglong>(sample.count));
+            drop.insert(QStringLiteral("perSecond"), have_window ? delta / seconds : 0.0);
+            drops.append(drop);
+            dropped += sample.count;
+        } else if (sample.type == MetricType::Gauge && hasPrefix(sample.name, "loudness.")) {
+            // 流名称里可能有点，字段名取最后一段
+            const size_t prefix = std::strlen("loudness.");
+            const size_t field_dot = sample.name.rfind('.');
+            if (field_dot < prefix) {
+                continue;
+            }
+            const QString stream = QString::fromStdString(sample.name.substr(prefix, field_dot - prefix));
+            if (!loudness.contains(stream)) {
+                loudness_streams.append(stream);
+                loudness[stream].insert(QStringLiteral("name"), stream);
+            }
+            loudness[stream].insert(loudnessField(sample.name.substr(field_dot + 1)), sample.value);
+        } else if (sample.type == MetricType::Counter && hasPrefix(sample.name, "perf.")) {
+            const size_t prefix = std::strlen("perf.");
+            const size_t field_dot = sample.name.rfind('.');
+            if (field_dot < prefix) {
+                continue;
+            }
+            const QString stage = QString::fromStdString(sample.name.substr(prefix, field_dot - prefix));
+            if (!counters.contains(stage)) {
+                counter_stages.append(stage);
+            }
+            const std::string field = sample.name.substr(field_dot + 1);
+            counters[stage].insert(QString::fromStdString(field),
+                                   static_cast<double>(sample.count - std::min(previous.count, sample.count)));
+            if (field == "samples") {
+                counters[stage].insert(QStringLiteral("total"), static_cast<double>(sample.count));
+            }
+        } else if (sample.type == MetricType::Gauge && sample.name == "memory.pressure_level") {
+            pressure = static_cast<int>(sample.value);
+        }
+    }
+
+    stages_ = stages;
+    queues_ = queues;
+    pools_ = pools;
+    drops_ = drops;
+    loudness_.clear();
+    for (const QString& stream : loudness_streams) {
+        loudness_.append(loudness.value(stream));
+    }
+    counters_.clear();
+    for (const QString& stage : counter_stages) {
+        // 计数器未启用或不可用时阶段从未计入，不占浮层
+        const QHash<QString, double> delta = counters.value(stage);
+        if (delta.value(QStringLiteral("total")) <= 0) {
+            continue;
+        }
+        const double cycles = delta.value(QStringLiteral("cycles"));
+        const double instructions = delta.value(QStringLiteral("instructions"));
+        const double samples = delta.value(QStringLiteral("samples"));
+        QVariantMap entry;
+        entry.insert(QStringLiteral("name"), stage);
+        entry.insert(QStringLiteral("ipc"), cycles > 0 ? instructions / cycles : 0.0);
+        entry.insert(QStringLiteral("llcMpki"),
+                     instructions > 0 ? delta.value(QStringLiteral("llc_misses")) * 1000.0 / instructions : 0.0);
+        entry.insert(QStringLiteral("branchMpki"),
+                     instructions > 0 ? delta.value(QStringLiteral("branch_misses")) * 1000.0 / instructions : 0.0);
+        entry.insert(QStringLiteral("kcyclesPerCall"), samples > 0 ? cycles / 1000.0 / samples : 0.0);
+        counters_.append(entry);
+    }
+    dropped_frames_ = dropped;
+    memory_pressure_level_ = pressure;
+    emit sampled();
+}
+
+} // namespace media
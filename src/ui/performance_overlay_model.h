@@ -0,0 +1,132 @@
+#ifndef PERFORMANCE_OVERLAY_MODEL_H
+#define PERFORMANCE_OVERLAY_MODEL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+
+#include "../utils/metrics_registry.h"
+
+namespace media {
+
+/**
+ * @brief 性能浮层数据模型（QML端）
+ *
+ * 设计特点：
+ * 1. 定时采样：GUI线程按intervalMs读取MetricsRegistry快照，管道线程不加锁、不等待
+ * 2. 差值换算：Latency次数差值换算为fps，总耗时差值换算为窗口平均耗时，最大耗时按窗口重置
+ * 3. 隐藏零开销：active为false时停止定时器并通知注册表停止计时，热路径只剩原子计数
+ * 4. 分组输出：按指标名前缀分为阶段/队列/池/丢弃四组，外加内存压力级别
+ * 5. 响度：loudness.<流>.<字段> 按流合并为一行
+ * 6. 硬件计数：perf.<阶段>.<字段> 按阶段合并为一行，按窗口差值换算IPC和每千条指令未命中数
+ *
+ * QML用法：
+ *   PerformanceOverlay { model: performanceModel; visible: showStats }
+ *   // PerformanceOverlay内部把 model.active 绑定到自身visible
+ */
+class PerformanceOverlayModel : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(int intervalMs READ intervalMs WRITE setIntervalMs NOTIFY intervalMsChanged)
+    Q_PROPERTY(QVariantList stages READ stages NOTIFY sampled)
+    Q_PROPERTY(QVariantList queues READ queues NOTIFY sampled)
+    Q_PROPERTY(QVariantList pools READ pools NOTIFY sampled)
+    Q_PROPERTY(QVariantList drops READ drops NOTIFY sampled)
+    Q_PROPERTY(QVariantList loudness READ loudness NOTIFY sampled)
+    Q_PROPERTY(QVariantList counters READ counters NOTIFY sampled)
+    Q_PROPERTY(qulonglong droppedFrames READ droppedFrames NOTIFY sampled)
+    Q_PROPERTY(int memoryPressureLevel READ memoryPressureLevel NOTIFY sampled)
+    Q_PROPERTY(QString memoryPressure READ memoryPressure NOTIFY sampled)
+
+public:
+    /**
+     * @param registry 数据来源，nullptr表示全局注册表
+     */
+    explicit PerformanceOverlayModel(MetricsRegistry* registry = nullptr, QObject* parent = nullptr);
+    ~PerformanceOverlayModel() override;
+
+    bool active() const { return active_; }
+    void setActive(bool active);
+
+    int intervalMs() const { return timer_.interval(); }
+    void setIntervalMs(int interval_ms);
+
+    /**
+     * @brief 阶段列表：[{name, fps, latencyMs, maxLatencyMs}]
+     */
+    QVariantList stages() const { return stages_; }
+
+    /**
+     * @brief 队列列表：[{name, depth}]
+     */
+    QVariantList queues() const { return queues_; }
+
+    /**
+     * @brief 池列表：[{name, hitRate}]，命中率0~1
+     */
+    QVariantList pools() const { return pools_; }
+
+    /**
+     * @brief 丢弃列表：[{name, total, perSecond}]
+     */
+    QVariantList drops() const { return drops_; }
+
+    /**
+     * @brief 响度列表：[{name, momentary, shortTerm, integrated, range, truePeak}]，无有效值时为负无穷
+     */
+    QVariantList loudness() const { return loudness_; }
+
+    /**
+     * @brief 硬件计数列表：[{name, ipc, llcMpki, branchMpki, kcyclesPerCall}]，均为窗口内的值
+     */
+    QVariantList counters() const { return counters_; }
+
+    /**
+     * @brief 所有drop.*计数之和
+     */
+    qulonglong droppedFrames() const { return dropped_frames_; }
+
+    /**
+     * @brief MemoryManager::PressureLevel数值，未上报时为-1
+     */
+    int memoryPressureLevel() const { return memory_pressure_level_; }
+    QString memoryPressure() const;
+
+    /**
+     * @brief 立即采样一次（不要求active）
+     */
+    Q_INVOKABLE void sampleNow();
+
+signals:
+    void activeChanged();
+    void intervalMsChanged();
+    void sampled();
+
+private:
+    struct Previous {
+        uint64_t count = 0;
+        int64_t total_us = 0;
+    };
+
+    MetricsRegistry& registry_;
+    QTimer timer_;
+    QElapsedTimer elapsed_;
+    bool active_ = false;
+
+    QHash<QString, Previous> previous_;
+    QVariantList stages_;
+    QVariantList queues_;
+    QVariantList pools_;
+    QVariantList drops_;
+    QVariantList loudness_;
+    QVariantList counters_;
+    qulonglong dropped_frames_ = 0;
+    int memory_pressure_level_ = -1;
+};
+
+} // namespace media
+
+#endif // PERFORMANCE_OVERLAY_MODEL_H
@@ -0,0 +1,93 @@
+#include "metrics_registry.h"
+
+#include <algorithm>
+
+namespace media {
+
+void Metric::record(int64_t duration_us) {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_us_.fetch_add(duration_us, std::memory_order_relaxed);
+    int64_t current = max_us_.load(std::memory_order_relaxed);
+    while (duration_us > current &&
+           !max_us_.compare_exchange_weak(current, duration_us, std::memory_order_relaxed)) {
+    }
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : metrics_(new Metric[kMaxMetrics]) {
+}
+
+Metric& MetricsRegistry::metric(const std::string& name, MetricType type) {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+
+    const size_t count = published_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (metrics_[i].name_ == name) {
+            return metrics_[i].type_ == type ? metrics_[i] : overflow_;
+        }
+    }
+    if (count >= kMaxMetrics) {
+        return overflow_;
+    }
+
+    // 先写好名称和类型，再发布槽位，采样线程看到的槽位总是完整的
+    Metric& slot = metrics_[count];
+    slot.name_ = name;
+    slot.type_ = type;
+    published_.store(count + 1, std::memory_order_release);
+    return slot;
+}
+
+int MetricsRegistry::addProbe(const std::string& name, Probe probe) {
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    const int id = next_probe_id_++;
+    probes_.push_back({id, name, std::move(probe)});
+    return id;
+}
+
+void MetricsRegistry::removeProbe(int id) {
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    probes_.erase(std::remove_if(probes_.begin(), probes_.end(),
+                                 [id](const ProbeEntry& entry) { return entry.id == id; }),
+                  probes_.end());
+}
+
+std::vector<MetricSample> MetricsRegistry::snapshot(bool reset_max) {
+    const size_t count = published_.load(std::memory_order_acquire);
+    std::vector<MetricSample> samples;
+    samples.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        Metric& metric = metrics_[i];
+        MetricSample sample;
+        sample.name = metric.name_;
+        sample.type = metric.type_;
+        sample.count = metric.count();
+        sample.value = metric.value();
+        sample.total_us = metric.totalUs();
+        sample.max_us = reset_max ? metric.max_us_.exchange(0, std::memory_order_relaxed) : metric.maxUs();
+        samples.push_back(std::move(sample));
+    }
+
+    // 探针只在采样线程调用；探针表的锁与热路径无关
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    for (const ProbeEntry& entry : probes_) {
+        samples.push_back({entry.name, MetricType::Probe, 0, entry.probe ? entry.probe() : 0.0, 0, 0});
+    }
+    return samples;
+}
+
+void MetricsRegistry::setCollecting(bool collecting) {
+    if (collecting) {
+        collecting_.fetch_add(1, std::memory_order_relaxed);
+    } else if (collecting_.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+        collecting_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace media
@@ -0,0 +1,192 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace media {
+
+/**
+ * @brief 指标类型
+ */
+enum class MetricType {
+    Counter,    // 单调计数（丢帧数等），采样方按差值算速率
+    Gauge,      // 瞬时值（队列深度、压力级别等）
+    Latency,    // 耗时分布：次数/总耗时/最大值，次数的差值即该阶段fps
+    Probe       // 采样时回调取值（池命中率等已有统计）
+};
+
+/**
+ * @brief 单个指标
+ *
+ * 写入全部是relaxed原子操作，不加锁，可在解码/渲染/音频回调线程直接调用。
+ */
+class Metric {
+public:
+    const std::string& name() const { return name_; }
+    MetricType type() const { return type_; }
+
+    // Counter
+    void add(uint64_t n = 1) { count_.fetch_add(n, std::memory_order_relaxed); }
+
+    // Gauge
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+
+    // Latency
+    void record(int64_t duration_us);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+    int64_t totalUs() const { return total_us_.load(std::memory_order_relaxed); }
+    int64_t maxUs() const { return max_us_.load(std::memory_order_relaxed); }
+
+private:
+    friend class MetricsRegistry;
+
+    std::string name_;
+    MetricType type_ = MetricType::Counter;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<double> value_{0.0};
+    std::atomic<int64_t> total_us_{0};
+    std::atomic<int64_t> max_us_{0};
+};
+
+/**
+ * @brief 指标快照（采样方使用）
+ */
+struct MetricSample {
+    std::string name;
+    MetricType type;
+    uint64_t count;         // Counter/Latency：累计次数
+    double value;           // Gauge/Probe：当前值
+    int64_t total_us;       // Latency：累计耗时
+    int64_t max_us;         // Latency：上次重置以来的最大耗时
+};
+
+/**
+ * @brief 进程内指标注册表
+ *
+ * 设计特点：
+ * 1. 热路径无锁：指标槽位预先分配、地址固定，注册后调用方缓存Metric&，之后只有原子操作
+ * 2. 采样无锁：已发布的槽位数用release/acquire发布，采样线程遍历时不与注册互斥
+ * 3. 按需计时：采样方不活跃时isCollecting()为false，各阶段跳过取时间，只保留计数
+ * 4. 探针：已有统计（分配器、回收器）以回调接入，只在采样线程调用，探针表单独加锁
+ *
+ * 命名约定（性能浮层据此分组）：
+ *   stage.<名称>   Latency  每帧耗时，次数差值为fps
+ *   queue.<名称>   Gauge    队列深度
+ *   pool.<名称>    Probe    池命中率（0~1）
+ *   drop.<名称>    Counter  丢弃数
+ *   loudness.<流>.<字段>  Gauge  响度（momentary/short_term/integrated为LUFS，range为LU，true_peak为dBTP）
+ *   memory.pressure_level   Gauge  MemoryManager::PressureLevel
+ *   perf.<阶段>.<字段>   Counter  硬件计数（cycles/instructions/llc_misses/branch_misses/samples），见PerfStage
+ */
+class MetricsRegistry {
+public:
+    static constexpr size_t kMaxMetrics = 1024;
+
+    using Probe = std::function<double()>;
+
+    static MetricsRegistry& instance();
+
+    MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /**
+     * @brief 获取或创建指标（首次调用加锁，调用方应缓存返回的引用）
+     *
+     * 名称已存在但类型不同，或槽位用尽时，返回一个不参与采样的占位指标。
+     */
+    Metric& counter(const std::string& name) { return metric(name, MetricType::Counter); }
+    Metric& gauge(const std::string& name) { return metric(name, MetricType::Gauge); }
+    Metric& latency(const std::string& name) { return metric(name, MetricType::Latency); }
+
+    /**
+     * @brief 注册探针
+     * @return 探针id，用于removeProbe
+     */
+    int addProbe(const std::string& name, Probe probe);
+    void removeProbe(int id);
+
+    /**
+     * @brief 采样所有指标
+     * @param reset_max 是否重置Latency的最大值（单一采样方按窗口统计最大值时使用）
+     */
+    std::vector<MetricSample> snapshot(bool reset_max = false);
+
+    /**
+     * @brief 是否有采样方在读取（决定是否记录耗时）
+     */
+    bool isCollecting() const { return collecting_.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * @brief 采样方开始/停止读取（引用计数，可多个采样方）
+     */
+    void setCollecting(bool collecting);
+
+    size_t size() const { return published_.load(std::memory_order_acquire); }
+
+private:
+    Metric& metric(const std::string& name, MetricType type);
+
+    struct ProbeEntry {
+        int id;
+        std::string name;
+        Probe probe;
+    };
+
+private:
+    std::unique_ptr<Metric[]> metrics_;
+    std::atomic<size_t> published_{0};
+    std::mutex register_mutex_;
+    Metric overflow_;
+
+    std::mutex probe_mutex_;
+    std::vector<ProbeEntry> probes_;
+    int next_probe_id_ = 1;
+
+    std::atomic<int> collecting_{0};
+};
+
+/**
+ * @brief 作用域计时：析构时把耗时记入Latency指标，未采样时只计次数
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Metric& metric)
+        : metric_(metric)
+        , timed_(MetricsRegistry::instance().isCollecting()) {
+        if (timed_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedLatency() {
+        if (timed_) {
+            metric_.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_).count());
+        } else {
+            metric_.add();
+        }
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Metric& metric_;
+    bool timed_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace media
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,246 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace media {
+
+std::atomic<bool> PerfCounters::enabled_{false};
+
+namespace {
+
+const char* const kCounterNames[PerfCounters::kCounterCount] = {
+    "cycles", "instructions", "llc_misses", "branch_misses"
+};
+
+uint64_t PerfCounterValues::* const kCounterFields[PerfCounters::kCounterCount] = {
+    &PerfCounterValues::cycles,
+    &PerfCounterValues::instructions,
+    &PerfCounterValues::llc_misses,
+    &PerfCounterValues::branch_misses
+};
+
+#ifdef __linux__
+
+const uint64_t kEventConfigs[PerfCounters::kCounterCount] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,     // 多数PMU上即末级缓存未命中
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+std::string paranoidLevel() {
+    std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+    std::string level;
+    return (file >> level) ? level : std::string("unknown");
+}
+
+/**
+ * @brief 线程私有的计数组，线程退出时关闭
+ */
+class ThreadCounters {
+public:
+    ThreadCounters() {
+        for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+            fds_[i] = -1;
+            slots_[i] = -1;
+        }
+        open();
+    }
+
+    ~ThreadCounters() {
+        for (int i = PerfCounters::kCounterCount - 1; i >= 0; --i) {
+            if (fds_[i] >= 0) {
+                ::close(fds_[i]);
+            }
+        }
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    bool available() const { return fds_[PerfCounters::Cycles] >= 0; }
+
+    PerfCounters::Status status() const {
+        PerfCounters::Status status;
+        status.available = available();
+        for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+            status.supported[i] = slots_[i] >= 0;
+        }
+        status.error = error_;
+        return status;
+    }
+
+    bool read(PerfCounterValues* values) const {
+        if (!available()) {
+            return false;
+        }
+        // PERF_FORMAT_GROUP: nr, time_enabled, time_running, value[nr]
+        uint64_t buffer[3 + PerfCounters::kCounterCount];
+        const ssize_t bytes = ::read(fds_[PerfCounters::Cycles], buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != static_cast<uint64_t>(members_)) {
+            return false;
+        }
+        *values = PerfCounterValues{};
+        values->time_enabled_ns = buffer[1];
+        values->time_running_ns = buffer[2];
+        for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+            if (slots_[i] >= 0) {
+                values->*kCounterFields[i] = buffer[3 + slots_[i]];
+            }
+        }
+        return true;
+    }
+
+private:
+    void open() {
+        // 周期计数是组长，打不开就整体不可用；其余事件失败只影响自身
+        for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+            const bool leader = i == PerfCounters::Cycles;
+            const int fd = openEvent(kEventConfigs[i], leader ? -1 : fds_[PerfCounters::Cycles], leader);
+            if (fd < 0) {
+                if (leader) {
+                    error_ = std::string("perf_event_open: ") + std::strerror(errno) +
+                             " (perf_event_paranoid=" + paranoidLevel() + ")";
+                    return;
+                }
+                continue;
+            }
+            fds_[i] = fd;
+            slots_[i] = members_++;
+        }
+
+        if (::ioctl(fds_[PerfCounters::Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0 ||
+            ::ioctl(fds_[PerfCounters::Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+            error_ = std::string("PERF_EVENT_IOC_ENABLE: ") + std::strerror(errno);
+            for (int i = PerfCounters::kCounterCount - 1; i >= 0; --i) {
+                if (fds_[i] >= 0) {
+                    ::close(fds_[i]);
+                    fds_[i] = -1;
+                }
+                slots_[i] = -1;
+            }
+            members_ = 0;
+        }
+    }
+
+    static int openEvent(uint64_t config, int group_fd, bool leader) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader ? 1 : 0;     // 整组建好后由组长一起启用
+        // 只统计用户态：perf_event_paranoid=2（多数发行版默认）下非特权进程也能打开
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+    }
+
+private:
+    int fds_[PerfCounters::kCounterCount];
+    int slots_[PerfCounters::kCounterCount];    // 在组读数中的下标，-1表示未打开
+    int members_ = 0;
+    std::string error_;
+};
+
+ThreadCounters& threadCounters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+#endif
+
+} // namespace
+
+PerfCounterValues PerfCounterValues::delta(const PerfCounterValues& start, const PerfCounterValues& end) {
+    PerfCounterValues result;
+    result.time_enabled_ns = end.time_enabled_ns - start.time_enabled_ns;
+    result.time_running_ns = end.time_running_ns - start.time_running_ns;
+    // 作用域内计数组一直在调度时直接相减，被复用挤掉过则按enabled/running放大
+    const bool scaled = result.time_running_ns > 0 && result.time_running_ns < result.time_enabled_ns;
+    const double scale = scaled ? static_cast<double>(result.time_enabled_ns) / result.time_running_ns : 1.0;
+    for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+        const uint64_t raw = end.*kCounterFields[i] - start.*kCounterFields[i];
+        result.*kCounterFields[i] = scaled ? static_cast<uint64_t>(raw * scale) : raw;
+    }
+    return result;
+}
+
+void PerfCounters::setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+PerfCounters::Status PerfCounters::status() {
+#ifdef __linux__
+    return threadCounters().status();
+#else
+    Status status;
+    status.error = "perf_event_open is only available on Linux";
+    return status;
+#endif
+}
+
+bool PerfCounters::readThread(PerfCounterValues* values) {
+#ifdef __linux__
+    return values && threadCounters().read(values);
+#else
+    (void)values;
+    return false;
+#endif
+}
+
+const char* PerfCounters::counterName(Counter counter) {
+    return counter >= 0 && counter < kCounterCount ? kCounterNames[counter] : "";
+}
+
+double PerfStage::StatisticsSnapshot::instructionsPerCycle() const {
+    return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+}
+
+double PerfStage::StatisticsSnapshot::llcMissesPerKiloInstruction() const {
+    return instructions > 0 ? llc_misses * 1000.0 / instructions : 0.0;
+}
+
+double PerfStage::StatisticsSnapshot::branchMissesPerKiloInstruction() const {
+    return instructions > 0 ? branch_misses * 1000.0 / instructions : 0.0;
+}
+
+PerfStage::PerfStage(const std::string& name, MetricsRegistry& registry)
+    : name_(name)
+    , samples_metric_(registry.counter("perf." + name + ".samples")) {
+    for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+        metrics_[i] = &registry.counter("perf." + name + "." + kCounterNames[i]);
+    }
+}
+
+void PerfStage::add(const PerfCounterValues& delta) {
+    samples_.fetch_add(1, std::memory_order_relaxed);
+    samples_metric_.add();
+    for (int i = 0; i < PerfCounters::kCounterCount; ++i) {
+        const uint64_t value = delta.*kCounterFields[i];
+        values_[i].fetch_add(value, std::memory_order_relaxed);
+        metrics_[i]->add(value);
+    }
+}
+
+PerfStage::StatisticsSnapshot PerfStage::getStatistics() const {
+    StatisticsSnapshot snapshot;
+    snapshot.samples = samples_.load(std::memory_order_relaxed);
+    snapshot.cycles = values_[PerfCounters::Cycles].load(std::memory_order_relaxed);
+    snapshot.instructions = values_[PerfCounters::Instructions].load(std::memory_order_relaxed);
+    snapshot.llc_misses = values_[PerfCounters::LlcMisses].load(std::memory_order_relaxed);
+    snapshot.branch_misses = values_[PerfCounters::BranchMisses].load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+} // namespace media
@@ -0,0 +1,155 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "metrics_registry.h"
+
+namespace media {
+
+/**
+ * @brief 一组硬件计数器读数
+ *
+ * time_enabled_ns/time_running_ns用于计数器复用时的换算：
+ * PMU槽位不够时内核轮流调度计数组，只在running期间计数。
+ */
+struct PerfCounterValues {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t llc_misses = 0;
+    uint64_t branch_misses = 0;
+    uint64_t time_enabled_ns = 0;
+    uint64_t time_running_ns = 0;
+
+    /**
+     * @brief 两次读数的差值，按复用比例换算为全时估计值
+     */
+    static PerfCounterValues delta(const PerfCounterValues& start, const PerfCounterValues& end);
+};
+
+/**
+ * @brief 线程级硬件性能计数器（perf_event_open）
+ *
+ * 设计特点：
+ * 1. 按线程计数：每个线程首次读取时打开自己的计数组（pid=0, cpu=-1），
+ *    只统计本线程在用户态执行的周期、指令、末级缓存未命中和分支预测失败
+ * 2. 计数组：四个事件作为一组同时调度，一次read取全部读数，比值（IPC、每千条指令未命中）不受复用影响
+ * 3. 默认关闭：每次读数是一次系统调用（约1微秒），setEnabled(true)之前热路径只有一次relaxed读
+ * 4. 降级：非Linux、容器里被seccomp拦截、perf_event_paranoid过高或虚拟机没有PMU时，
+ *    打开失败，读取返回false，各阶段计数保持为0；单个事件不支持时其余事件照常计数
+ */
+class PerfCounters {
+public:
+    enum Counter {
+        Cycles = 0,
+        Instructions,
+        LlcMisses,
+        BranchMisses,
+        kCounterCount
+    };
+
+    /**
+     * @brief 调用线程上计数组的状态
+     */
+    struct Status {
+        bool available = false;                 // 计数组已打开
+        bool supported[kCounterCount] = {};     // 各事件是否打开成功
+        std::string error;                      // 不可用原因（含perf_event_paranoid）
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 在调用线程上打开（或复用）计数组并返回状态，不要求已启用
+     */
+    static Status status();
+
+    /**
+     * @brief 读取调用线程的累计计数（自本线程打开计数组起）
+     * @return 计数组不可用时返回false
+     */
+    static bool readThread(PerfCounterValues* values);
+
+    static const char* counterName(Counter counter);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief 单个管道阶段的计数累计
+ *
+ * 同时写入本实例的统计和注册表的perf.<阶段>.<字段>计数器
+ * （cycles/instructions/llc_misses/branch_misses/samples），
+ * 注册表中同名阶段的多个实例累加，与stage.*耗时指标一致。
+ */
+class PerfStage {
+public:
+    /**
+     * @brief 统计信息快照
+     */
+    struct StatisticsSnapshot {
+        uint64_t samples = 0;           // 计入的作用域次数
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t llc_misses = 0;
+        uint64_t branch_misses = 0;
+
+        double instructionsPerCycle() const;
+        double llcMissesPerKiloInstruction() const;
+        double branchMissesPerKiloInstruction() const;
+    };
+
+    explicit PerfStage(const std::string& name, MetricsRegistry& registry = MetricsRegistry::instance());
+
+    PerfStage(const PerfStage&) = delete;
+    PerfStage& operator=(const PerfStage&) = delete;
+
+    const std::string& name() const { return name_; }
+
+    void add(const PerfCounterValues& delta);
+
+    StatisticsSnapshot getStatistics() const;
+
+private:
+    std::string name_;
+    std::atomic<uint64_t> samples_{0};
+    std::atomic<uint64_t> values_[PerfCounters::kCounterCount] = {};
+    Metric& samples_metric_;
+    Metric* metrics_[PerfCounters::kCounterCount];
+};
+
+/**
+ * @brief 作用域计数：析构时把本线程在作用域内的计数差值记入阶段
+ *
+ * 未启用或本线程计数组不可用时什么也不做。嵌套作用域各自计入，外层包含内层。
+ */
+class ScopedPerfCounters {
+public:
+    explicit ScopedPerfCounters(PerfStage& stage)
+        : stage_(stage)
+        , active_(PerfCounters::isEnabled() && PerfCounters::readThread(&start_)) {
+    }
+
+    ~ScopedPerfCounters() {
+        PerfCounterValues end;
+        if (active_ && PerfCounters::readThread(&end)) {
+            stage_.add(PerfCounterValues::delta(start_, end));
+        }
+    }
+
+    ScopedPerfCounters(const ScopedPerfCounters&) = delete;
+    ScopedPerfCounters& operator=(const ScopedPerfCounters&) = delete;
+
+private:
+    PerfStage& stage_;
+    PerfCounterValues start_;
+    bool active_;
+};
+
+} // namespace media
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,109 @@
+#include "test_startup_coordinator.h"
+#include "media/media_pipeline.h"
+#include "media/renderer/video_item.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QQuickWindow>
+
+namespace {
+
+const media::StartupCoordinator::TaskTiming* findTask(const media::StartupCoordinator::Timeline& timeline,
+                                                      const QString& name) {
+    for (const auto& task : timeline.tasks) {
+        if (task.name == name) {
+            return &task;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void TestStartupCoordinator::initTestCase()
+{
+    qDebug() << "🚀 开始启动协调测试";
+    if (!QFile::exists(QStringLiteral(TEST_MEDIA_FILE))) {
+        QSKIP("测试视频不存在");
+    }
+}
+
+void TestStartupCoordinator::runStartup(bool parallel)
+{
+    // 窗口和视频项先于协调器声明：协调器先析构，管道先停止
+    QQuickWindow window;
+    window.resize(320, 180);
+    media::VideoItem item(window.contentItem());
+    item.setSize(QSizeF(320, 180));
+
+    media::StartupCoordinator::Config config;
+    config.media_url = QStringLiteral(TEST_MEDIA_FILE);
+    config.parallel = parallel;
+    media::StartupCoordinator startup(config);
+    QSignalSpy first_frame_spy(&startup, &media::StartupCoordinator::firstFrameShown);
+    QSignalSpy window_spy(&startup, &media::StartupCoordinator::windowShown);
+
+    startup.startBackground();
+    startup.markQmlLoaded();
+    startup.attach(&window, &item);
+    window.show();
+
+    QTRY_VERIFY_WITH_TIMEOUT(first_frame_spy.count() == 1, 10000);
+    QCOMPARE(window_spy.count(), 1);
+
+    const auto timeline = startup.timeline();
+    qDebug().noquote() << startup.report();
+
+    QVERIFY(timeline.window_shown_ms >= 0.0);
+    QVERIFY(timeline.media_ready_ms >= 0.0);
+    QVERIFY(timeline.first_frame_ms >= timeline.media_ready_ms);
+    QVERIFY(timeline.first_frame_ms >= timeline.window_shown_ms);
+
+    const auto* ffmpeg_init = findTask(timeline, QStringLiteral("ffmpeg_init"));
+    const auto* media_open = findTask(timeline, QStringLiteral("media_open"));
+    QVERIFY(ffmpeg_init && media_open && findTask(timeline, QStringLiteral("services")));
+    QVERIFY(media_open->success);
+    QVERIFY(media_open->start_ms >= ffmpeg_init->end_ms);
+
+    if (parallel) {
+        // 媒体打开与QML加载重叠：QML加载完成时媒体还没有打开完
+        QVERIFY(media_open->end_ms > timeline.qml_loaded_ms);
+    } else {
+        // 串行：QML加载之前所有任务都已完成
+        QVERIFY(media_open->end_ms <= timeline.qml_loaded_ms);
+    }
+
+    QVERIFY(startup.pipeline());
+    startup.shutdown();
+    QVERIFY(!startup.pipeline());
+}
+
+void TestStartupCoordinator::testParallelStartup()
+{
+    runStartup(true);
+}
+
+void TestStartupCoordinator::testSerialStartup()
+{
+    runStartup(false);
+}
+
+void TestStartupCoordinator::testMediaFailure()
+{
+    media::StartupCoordinator::Config config;
+    config.media_url = QStringLiteral("/nonexistent/startup.mp4");
+    media::StartupCoordinator startup(config);
+    QSignalSpy failed_spy(&startup, &media::StartupCoordinator::mediaFailed);
+    QSignalSpy ready_spy(&startup, &media::StartupCoordinator::mediaReady);
+
+    startup.startBackground();
+    QTRY_COMPARE_WITH_TIMEOUT(failed_spy.count(), 1, 5000);
+    QCOMPARE(ready_spy.count(), 0);
+    QVERIFY(!failed_spy.first().at(0).toString().isEmpty());
+
+    // 任务耗时在openMedia返回后才记录，可能晚于失败信号
+    QTRY_VERIFY_WITH_TIMEOUT(findTask(startup.timeline(), QStringLiteral("media_open")) != nullptr, 5000);
+    const auto timeline = startup.timeline();
+    QVERIFY(!findTask(timeline, QStringLiteral("media_open"))->success);
+    startup.shutdown();
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_STARTUP_COORDINATOR_H
+#define TEST_STARTUP_COORDINATOR_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "core/startup_coordinator.h"
+
+class TestStartupCoordinator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testParallelStartup();
+    void testSerialStartup();
+    void testMediaFailure();
+
+private:
+    void runStartup(bool parallel);
+};
+
+#endif // TEST_STARTUP_COORDINATOR_H
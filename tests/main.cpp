@@ -1,18 +1,48 @@
 #include <QtTest>
-#include <QCoreApplication>
+#include <QGuiApplication>
 
 // 包含测试类头文件（不是cpp文件）
 #include "memory/test_memory_pool.h"
 #include "memory/test_pool_performance.h"
+#include "memory/test_allocation_trace.h"
+#include "memory/test_copy_accounting.h"
+#include "ui/test_performance_overlay.h"
+#include "utils/test_perf_counters.h"
 
 #ifdef FFMPEG_AVAILABLE
 #include "media/allocator/test_ffmpeg_frame_allocator.h"
 #include "media/input/test_input_source.h"  // 新增输入源测试
+#include "media/renderer/test_frame_mailbox.h"
+#include "media/thumbnail/test_thumbnail_generator.h"
+#include "media/playback/test_reverse_playback.h"
+#include "media/playback/test_playlist_engine.h"
+#include "media/audio/test_audio_output.h"
+#include "media/audio/test_wsola_time_stretcher.h"
+#include "media/audio/test_loudness_meter.h"
+#include "media/pipeline/test_media_pipeline.h"
+#include "media/snapshot/test_snapshot_service.h"
+#include "core/test_startup_coordinator.h"
+#include "media/recording/test_recording_sink.h"
+#include "media/encoder/test_video_encoder.h"
+#include "media/restream/test_restream_server.h"
+#include "media/extract/test_frame_extractor.h"
+#include "media/framebus/test_frame_bus.h"
+#include "media/analytics/test_analytics_stage.h"
+#include "media/metadata/test_timed_metadata.h"
+#include "media/synthetic/test_synthetic_media.h"
 #endif
 
 int main(int argc, char *argv[])
 {
-    QCoreApplication app(argc, argv);
+    // 渲染测试无头运行：未显式指定时使用offscreen平台和software场景图后端
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    if (qEnvironmentVariableIsEmpty("QT_QUICK_BACKEND")) {
+        qputenv("QT_QUICK_BACKEND", "software");
+    }
+
+    QGuiApplication app(argc, argv);
     
     int result = 0;
     
@@ -57,6 +87,34 @@ int main(int argc, char *argv[])
                 qDebug() << "   ❌ 内存池性能测试有" << perfResult << "个失败";
             }
         }
+
+        // 分配轨迹
+        qDebug() << "\n🧾 1.3 分配轨迹记录与回放";
+        {
+            TestAllocationTrace traceTest;
+            int traceResult = QTest::qExec(&traceTest, argc, argv);
+            result += traceResult;
+
+            if (traceResult == 0) {
+                qDebug() << "   ✅ 分配轨迹全部通过";
+            } else {
+                qDebug() << "   ❌ 分配轨迹有" << traceResult << "个失败";
+            }
+        }
+
+        // 拷贝计量
+        qDebug() << "\n🧮 1.4 拷贝计量";
+        {
+            TestCopyAccounting copyTest;
+            int copyResult = QTest::qExec(&copyTest, argc, argv);
+            result += copyResult;
+
+            if (copyResult == 0) {
+                qDebug() << "   ✅ 拷贝计量全部通过";
+            } else {
+                qDebug() << "   ❌ 拷贝计量有" << copyResult << "个失败";
+            }
+        }
     }
     
 #ifdef FFMPEG_AVAILABLE
@@ -97,6 +155,140 @@ int main(int argc, char *argv[])
             }
         }
     }
+
+    // 4. 渲染帧交接测试
+    if (filter.isEmpty() || filter == "media" || filter == "renderer") {
+        qDebug() << "\n🖼️ 4. 渲染帧交接模块测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n⏱️ 4.1 三缓冲邮箱与帧节奏测试";
+        {
+            TestFrameMailbox rendererTest;
+            int rendererResult = QTest::qExec(&rendererTest, argc, argv);
+            result += rendererResult;
+
+            if (rendererResult == 0) {
+                qDebug() << "   ✅ 渲染帧交接模块全部通过";
+            } else {
+                qDebug() << "   ❌ 渲染帧交接模块有" << rendererResult << "个失败";
+            }
+        }
+    }
+
+    // 5. 缩略图测试
+    if (filter.isEmpty() || filter == "media" || filter == "thumbnail") {
+        qDebug() << "\n🎞️ 5. 缩略图模块测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔍 5.1 关键帧缩略图生成测试";
+        {
+            TestThumbnailGenerator thumbnailTest;
+            int thumbnailResult = QTest::qExec(&thumbnailTest, argc, argv);
+            result += thumbnailResult;
+
+            if (thumbnailResult == 0) {
+                qDebug() << "   ✅ 缩略图模块全部通过";
+            } else {
+                qDebug() << "   ❌ 缩略图模块有" << thumbnailResult << "个失败";
+            }
+        }
+    }
+
+    // 6. 倒放引擎与播放列表测试
+    if (filter.isEmpty() || filter == "media" || filter == "playback") {
+        qDebug() << "\n⏪ 6. 逐帧步进、倒放与播放列表模块测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🎯 6.1 精确定位、倒放与内存/CPU基准";
+        {
+            TestReversePlayback playbackTest;
+            int playbackResult = QTest::qExec(&playbackTest, argc, argv);
+            result += playbackResult;
+
+            if (playbackResult == 0) {
+                qDebug() << "   ✅ 倒放模块全部通过";
+            } else {
+                qDebug() << "   ❌ 倒放模块有" << playbackResult << "个失败";
+            }
+        }
+
+        qDebug() << "\n🔁 6.2 播放列表无缝衔接与回退";
+        {
+            TestPlaylistEngine playlistTest;
+            int playlistResult = QTest::qExec(&playlistTest, argc, argv);
+            result += playlistResult;
+
+            if (playlistResult == 0) {
+                qDebug() << "   ✅ 播放列表全部通过";
+            } else {
+                qDebug() << "   ❌ 播放列表有" << playlistResult << "个失败";
+            }
+        }
+    }
+
+    // 7. 音频输出测试
+    if (filter.isEmpty() || filter == "media" || filter == "audio") {
+        qDebug() << "\n🔊 7. 音频输出模块测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🎚️ 7.1 无锁环形缓冲、音频时钟与欠载统计";
+        {
+            TestAudioOutput audioTest;
+            int audioResult = QTest::qExec(&audioTest, argc, argv);
+            result += audioResult;
+
+            if (audioResult == 0) {
+                qDebug() << "   ✅ 音频输出模块全部通过";
+            } else {
+                qDebug() << "   ❌ 音频输出模块有" << audioResult << "个失败";
+            }
+        }
+
+        qDebug() << "\n🎼 7.2 WSOLA变速不变调";
+        {
+            TestWsolaTimeStretcher wsolaTest;
+            int wsolaResult = QTest::qExec(&wsolaTest, argc, argv);
+            result += wsolaResult;
+
+            if (wsolaResult == 0) {
+                qDebug() << "   ✅ WSOLA时间伸缩全部通过";
+            } else {
+                qDebug() << "   ❌ WSOLA时间伸缩有" << wsolaResult << "个失败";
+            }
+        }
+
+        qDebug() << "\n📏 7.3 EBU R128响度与真峰值";
+        {
+            TestLoudnessMeter loudnessTest;
+            int loudnessResult = QTest::qExec(&loudnessTest, argc, argv);
+            result += loudnessResult;
+
+            if (loudnessResult == 0) {
+                qDebug() << "   ✅ 响度测量全部通过";
+            } else {
+                qDebug() << "   ❌ 响度测量有" << loudnessResult << "个失败";
+            }
+        }
+    }
+
+    // 8. 变速播放管道测试
+    if (filter.isEmpty() || filter == "media" || filter == "pipeline") {
+        qDebug() << "\n⏩ 8. 变速播放管道测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🚀 8.1 音视频同步、变速切换与高倍速CPU基准";
+        {
+            TestMediaPipeline pipelineTest;
+            int pipelineResult = QTest::qExec(&pipelineTest, argc, argv);
+            result += pipelineResult;
+
+            if (pipelineResult == 0) {
+                qDebug() << "   ✅ 变速播放管道全部通过";
+            } else {
+                qDebug() << "   ❌ 变速播放管道有" << pipelineResult << "个失败";
+            }
+        }
+    }
 #else
     if (filter.isEmpty() || filter == "media") {
         qDebug() << "\n⚠️  2-3. 媒体模块测试";
@@ -108,6 +300,238 @@ int main(int argc, char *argv[])
         qDebug() << "3. 定义FFMPEG_AVAILABLE宏";
     }
 #endif
+
+    // 9. 性能浮层测试
+    if (filter.isEmpty() || filter == "overlay") {
+        qDebug() << "\n📈 9. 性能浮层测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔧 9.1 无锁指标注册表与浮层采样";
+        {
+            TestPerformanceOverlay overlayTest;
+            int overlayResult = QTest::qExec(&overlayTest, argc, argv);
+            result += overlayResult;
+
+            if (overlayResult == 0) {
+                qDebug() << "   ✅ 性能浮层全部通过";
+            } else {
+                qDebug() << "   ❌ 性能浮层有" << overlayResult << "个失败";
+            }
+        }
+    }
+
+#ifdef FFMPEG_AVAILABLE
+    // 10. 截图服务测试
+    if (filter.isEmpty() || filter == "media" || filter == "snapshot") {
+        qDebug() << "\n📸 10. 截图服务测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔧 10.1 后台JPEG/PNG编码、连拍限流与取消";
+        {
+            TestSnapshotService snapshotTest;
+            int snapshotResult = QTest::qExec(&snapshotTest, argc, argv);
+            result += snapshotResult;
+
+            if (snapshotResult == 0) {
+                qDebug() << "   ✅ 截图服务全部通过";
+            } else {
+                qDebug() << "   ❌ 截图服务有" << snapshotResult << "个失败";
+            }
+        }
+    }
+
+    // 11. 启动协调测试
+    if (filter.isEmpty() || filter == "startup") {
+        qDebug() << "\n🚀 11. 启动协调测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n⏱️ 11.1 并行/串行启动、出窗口与首帧时间";
+        {
+            TestStartupCoordinator startupTest;
+            int startupResult = QTest::qExec(&startupTest, argc, argv);
+            result += startupResult;
+
+            if (startupResult == 0) {
+                qDebug() << "   ✅ 启动协调全部通过";
+            } else {
+                qDebug() << "   ❌ 启动协调有" << startupResult << "个失败";
+            }
+        }
+    }
+
+    // 12. 录制输出测试
+    if (filter.isEmpty() || filter == "media" || filter == "recording") {
+        qDebug() << "\n📼 12. 录制输出测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n💾 12.1 批量写盘、分段轮换、预录触发与多路并发";
+        {
+            TestRecordingSink recordingTest;
+            int recordingResult = QTest::qExec(&recordingTest, argc, argv);
+            result += recordingResult;
+
+            if (recordingResult == 0) {
+                qDebug() << "   ✅ 录制输出全部通过";
+            } else {
+                qDebug() << "   ❌ 录制输出有" << recordingResult << "个失败";
+            }
+        }
+    }
+
+    // 13. 视频编码测试
+    if (filter.isEmpty() || filter == "media" || filter == "encoder") {
+        qDebug() << "\n🎞️ 13. 视频编码测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n⚙️ 13.1 编码往返、前瞻延迟、编码阶段、分段并行转码与性能基准";
+        {
+            TestVideoEncoder encoderTest;
+            int encoderResult = QTest::qExec(&encoderTest, argc, argv);
+            result += encoderResult;
+
+            if (encoderResult == 0) {
+                qDebug() << "   ✅ 视频编码全部通过";
+            } else {
+                qDebug() << "   ❌ 视频编码有" << encoderResult << "个失败";
+            }
+        }
+    }
+
+    // 14. 本地转发服务测试
+    if (filter.isEmpty() || filter == "media" || filter == "restream") {
+        qDebug() << "\n📡 14. 本地转发服务测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔀 14.1 HTTP-TS转发、慢客户端重同步、500路扇出与GOP缓存秒开";
+        {
+            TestRestreamServer restreamTest;
+            int restreamResult = QTest::qExec(&restreamTest, argc, argv);
+            result += restreamResult;
+
+            if (restreamResult == 0) {
+                qDebug() << "   ✅ 本地转发全部通过";
+            } else {
+                qDebug() << "   ❌ 本地转发有" << restreamResult << "个失败";
+            }
+        }
+    }
+
+    // 15. 批量抽帧测试
+    if (filter.isEmpty() || filter == "media" || filter == "extract") {
+        qDebug() << "\n🎞️ 15. 批量抽帧测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n📸 15.1 按需解码、多核分段与缓冲/图片输出";
+        {
+            TestFrameExtractor extractTest;
+            int extractResult = QTest::qExec(&extractTest, argc, argv);
+            result += extractResult;
+
+            if (extractResult == 0) {
+                qDebug() << "   ✅ 批量抽帧全部通过";
+            } else {
+                qDebug() << "   ❌ 批量抽帧有" << extractResult << "个失败";
+            }
+        }
+    }
+
+    // 16. 共享内存帧总线测试
+    if (filter.isEmpty() || filter == "media" || filter == "framebus") {
+        qDebug() << "\n🚌 16. 共享内存帧总线测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n📤 16.1 seqlock槽环、跨进程零拷贝读取与吞吐";
+        {
+            TestFrameBus frameBusTest;
+            int frameBusResult = QTest::qExec(&frameBusTest, argc, argv);
+            result += frameBusResult;
+
+            if (frameBusResult == 0) {
+                qDebug() << "   ✅ 帧总线全部通过";
+            } else {
+                qDebug() << "   ❌ 帧总线有" << frameBusResult << "个失败";
+            }
+        }
+    }
+
+    // 17. 画面分析测试
+    if (filter.isEmpty() || filter == "media" || filter == "analytics") {
+        qDebug() << "\n🎯 17. 画面分析测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔍 17.1 SIMD内核、场景切换与运动检测";
+        {
+            TestAnalyticsStage analyticsTest;
+            int analyticsResult = QTest::qExec(&analyticsTest, argc, argv);
+            result += analyticsResult;
+
+            if (analyticsResult == 0) {
+                qDebug() << "   ✅ 画面分析全部通过";
+            } else {
+                qDebug() << "   ❌ 画面分析有" << analyticsResult << "个失败";
+            }
+        }
+    }
+
+    // 18. 定时元数据测试
+    if (filter.isEmpty() || filter == "media" || filter == "metadata") {
+        qDebug() << "\n🏷️ 18. 定时元数据测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n⏱️ 18.1 SEI时间码、KLV、字幕旁路与时间索引";
+        {
+            TestTimedMetadata metadataTest;
+            int metadataResult = QTest::qExec(&metadataTest, argc, argv);
+            result += metadataResult;
+
+            if (metadataResult == 0) {
+                qDebug() << "   ✅ 定时元数据全部通过";
+            } else {
+                qDebug() << "   ❌ 定时元数据有" << metadataResult << "个失败";
+            }
+        }
+    }
+#endif
+
+    // 19. 硬件性能计数器测试
+    if (filter.isEmpty() || filter == "perfcounters") {
+        qDebug() << "\n📟 19. 硬件性能计数器测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🔧 19.1 perf_event_open计数组、阶段累计与降级";
+        {
+            TestPerfCounters perfCounterTest;
+            int perfCounterResult = QTest::qExec(&perfCounterTest, argc, argv);
+            result += perfCounterResult;
+
+            if (perfCounterResult == 0) {
+                qDebug() << "   ✅ 硬件性能计数器全部通过";
+            } else {
+                qDebug() << "   ❌ 硬件性能计数器有" << perfCounterResult << "个失败";
+            }
+        }
+    }
+
+#ifdef FFMPEG_AVAILABLE
+    // 20. 合成测试媒体测试
+    if (filter.isEmpty() || filter == "media" || filter == "synthetic") {
+        qDebug() << "\n🧪 20. 合成测试媒体测试";
+        qDebug() << "----------------------------------------";
+
+        qDebug() << "\n🎨 20.1 测试图案帧号戳、参数矩阵生成与HTTP/UDP/RTSP回环服务";
+        {
+            TestSyntheticMedia syntheticTest;
+            int syntheticResult = QTest::qExec(&syntheticTest, argc, argv);
+            result += syntheticResult;
+
+            if (syntheticResult == 0) {
+                qDebug() << "   ✅ 合成测试媒体全部通过";
+            } else {
+                qDebug() << "   ❌ 合成测试媒体有" << syntheticResult << "个失败";
+            }
+        }
+    }
+#endif
     
     // 总结
     qDebug() << "\n==========================================";
@@ -142,6 +566,23 @@ int main(int argc, char *argv[])
     qDebug() << "   ./run_tests media     # 运行所有媒体模块测试";
     qDebug() << "   ./run_tests allocator # 只运行Frame Allocator测试";
     qDebug() << "   ./run_tests input     # 只运行输入源测试";
+    qDebug() << "   ./run_tests renderer  # 只运行渲染帧交接测试";
+    qDebug() << "   ./run_tests thumbnail # 只运行缩略图测试";
+    qDebug() << "   ./run_tests playback  # 只运行倒放引擎和播放列表测试";
+    qDebug() << "   ./run_tests audio     # 只运行音频输出与响度测量测试";
+    qDebug() << "   ./run_tests pipeline  # 只运行变速播放管道测试";
+    qDebug() << "   ./run_tests overlay   # 只运行性能浮层测试";
+    qDebug() << "   ./run_tests snapshot  # 只运行截图服务测试";
+    qDebug() << "   ./run_tests startup   # 只运行启动协调测试";
+    qDebug() << "   ./run_tests recording # 只运行录制输出测试";
+    qDebug() << "   ./run_tests encoder   # 只运行视频编码测试";
+    qDebug() << "   ./run_tests restream  # 只运行本地转发服务测试";
+    qDebug() << "   ./run_tests extract   # 只运行批量抽帧测试";
+    qDebug() << "   ./run_tests framebus  # 只运行共享内存帧总线测试";
+    qDebug() << "   ./run_tests analytics # 只运行画面分析测试";
+    qDebug() << "   ./run_tests metadata  # 只运行定时元数据测试";
+    qDebug() << "   ./run_tests perfcounters # 只运行硬件性能计数器测试";
+    qDebug() << "   ./run_tests synthetic # 只运行合成测试媒体与回环服务测试";
     
     return result;
 }
\ No newline at end of file
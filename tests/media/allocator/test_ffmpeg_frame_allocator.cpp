@@ -1,5 +1,6 @@
 // test_ffmpeg_frame_allocator.cpp
 #include "test_ffmpeg_frame_allocator.h"
+#include <algorithm>
 
 void TestFrameAllocator::initTestCase()
 {
@@ -249,6 +250,62 @@ void TestFrameAllocator::testFFmpegPoolReuse()
     }
 }
 
+void TestFrameAllocator::testFFmpegSharedFrameOutlivesAllocator()
+{
+    qDebug() << "\n⏳ 测试共享帧比分配器活得久";
+
+    const media::FrameSpec spec(320, 240, media::FFmpegFormats::YUV420P);
+    auto allocator = std::make_shared<media::FFmpegFrameAllocator>();
+
+    // 一帧归还池后再取出，另一帧一直持有到分配器销毁之后
+    auto recycled = allocator->allocateSharedFrame(spec);
+    QVERIFY(recycled);
+    recycled->pts = 42;
+    recycled.reset();
+    auto frame = allocator->allocateSharedFrame(spec);
+    QVERIFY(frame);
+    QCOMPARE(frame->pts, int64_t(AV_NOPTS_VALUE));      // 池中取出的帧不带上一次的属性
+
+    allocator.reset();
+    std::fill(frame->data[0], frame->data[0] + frame->linesize[0] * frame->height, uint8_t(16));
+    frame.reset();                                      // 分配器已销毁：直接释放，不访问池
+
+    // 不由shared_ptr持有的分配器不能分配共享帧
+    media::FFmpegFrameAllocator unowned;
+    QVERIFY(!unowned.allocateSharedFrame(spec));
+}
+
+void TestFrameAllocator::testPacketRecyclerReusesBuffer()
+{
+    qDebug() << "\n♻️ 测试 PacketRecycler 缓冲区复用";
+
+    PacketRecycler::Config config;
+    config.cleanup_interval_ms = 0;
+    PacketRecycler recycler(config);
+
+    // TINY类别的池按4KB分配缓冲区，写入超过1KB后大小已落在SMALL范围
+    auto packet = recycler.allocatePacket(512);
+    QVERIFY(packet && packet->data);
+    QCOMPARE(packet->size, 512);
+    uint8_t* data = packet->data;
+    std::fill(data, data + 3000, uint8_t(0x5A));
+    packet->size = 3000;
+    packet->pts = 42;
+    packet.reset();
+
+    auto stats = recycler.getStatistics();
+    QCOMPARE(stats.total_recycled, size_t(1));
+    const size_t hits = stats.pool_hits;
+
+    // 按分配时的类别回到TINY池，缓冲区没有被av_packet_unref释放
+    auto reused = recycler.allocatePacket(512);
+    QVERIFY(reused);
+    QCOMPARE(reused->data, data);
+    QCOMPARE(reused->size, 512);
+    QCOMPARE(reused->pts, int64_t(AV_NOPTS_VALUE));
+    QCOMPARE(recycler.getStatistics().pool_hits, hits + 1);
+}
+
 void TestFrameAllocator::testFFmpegStatistics()
 {
     qDebug() << "\n📊 测试 FFmpeg 统计功能";
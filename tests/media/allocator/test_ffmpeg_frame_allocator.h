@@ -11,6 +11,7 @@
 
 #ifdef FFMPEG_AVAILABLE
     #include "media/allocator/ffmpeg_allocator/ffmpeg_frame_allocator.h"
+    #include "media/allocator/ffmpeg_allocator/packet_recycler.h"
 #endif
 
 /**
@@ -46,6 +47,8 @@ private slots:
     void testFFmpegFrameAllocation();   // FFmpeg帧分配
     void testFFmpegPoolReuse();         // FFmpeg池重用
     void testFFmpegStatistics();        // FFmpeg统计
+    void testFFmpegSharedFrameOutlivesAllocator(); // 共享帧比分配器活得久
+    void testPacketRecyclerReusesBuffer(); // 回收的packet保留缓冲区、回到原来的池
 #endif
 
     // 高级功能测试
@@ -0,0 +1,560 @@
+#include "test_analytics_stage.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "media/media_pipeline.h"
+#include "media/decoder/ffmpeg_decoder.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/buffer.h>
+}
+
+using namespace media;
+
+namespace {
+
+constexpr AVRational kTimeBase = {1, 25};
+
+/**
+ * @brief 分配一帧软件帧，亮度由fill(x, y)决定，色度填中性值
+ */
+AVFrame* makeFrame(int width, int height, AVPixelFormat format, int64_t pts,
+                   const std::function<uint8_t(int, int)>& fill)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = frame->data[0] + static_cast<size_t>(y) * frame->linesize[0];
+        for (int x = 0; x < width; ++x) {
+            row[x] = fill(x, y);
+        }
+    }
+    if (format == AV_PIX_FMT_YUV420P) {
+        for (int plane = 1; plane <= 2; ++plane) {
+            for (int y = 0; y < height / 2; ++y) {
+                memset(frame->data[plane] + static_cast<size_t>(y) * frame->linesize[plane], 128,
+                       static_cast<size_t>(width / 2));
+            }
+        }
+    }
+    frame->pts = pts;
+    frame->best_effort_timestamp = pts;
+    return frame;
+}
+
+// 固定纹理背景：有细节但帧间完全相同
+uint8_t texture(int x, int y, uint8_t base)
+{
+    return static_cast<uint8_t>(base + ((x * 7 + y * 13) % 32));
+}
+
+struct Square {
+    int x;
+    int y;
+    int size;
+};
+
+AVFrame* makeScene(int width, int height, int64_t pts, uint8_t base, const Square* square = nullptr)
+{
+    return makeFrame(width, height, AV_PIX_FMT_YUV420P, pts, [&](int x, int y) -> uint8_t {
+        if (square && x >= square->x && x < square->x + square->size &&
+            y >= square->y && y < square->y + square->size) {
+            return 235;
+        }
+        return texture(x, y, base);
+    });
+}
+
+std::vector<uint8_t> randomPlane(std::mt19937& rng, int stride, int height)
+{
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> plane(static_cast<size_t>(stride) * height);
+    for (uint8_t& value : plane) {
+        value = static_cast<uint8_t>(dist(rng));
+    }
+    return plane;
+}
+
+/**
+ * @brief 一次性闸门：回调在其中阻塞，测试线程放行
+ */
+class Gate {
+public:
+    void enterAndWait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        entered_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [this]() { return opened_; });
+    }
+
+    bool waitEntered(int timeout_ms) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() { return entered_; });
+    }
+
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        opened_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool entered_ = false;
+    bool opened_ = false;
+};
+
+/**
+ * @brief 单线程解码测试媒体的前max_frames帧，返回解码耗时（毫秒）
+ */
+double decodeFile(const QString& path, int max_frames, std::vector<ffmpeg::AVFrameSharedPtr>* frames,
+                  AVRational* time_base)
+{
+    const QByteArray file = path.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, file.constData(), nullptr, nullptr) < 0) {
+        return -1.0;
+    }
+    avformat_find_stream_info(input, nullptr);
+    const int stream_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_index < 0) {
+        avformat_close_input(&input);
+        return -1.0;
+    }
+    *time_base = input->streams[stream_index]->time_base;
+
+    FFmpegVideoDecoder::Config config;
+    config.thread_count = 1;
+    FFmpegVideoDecoder decoder(config);
+    if (!decoder.initialize(input->streams[stream_index]->codecpar)) {
+        avformat_close_input(&input);
+        return -1.0;
+    }
+
+    double decode_ms = 0.0;
+    AVPacket* packet = av_packet_alloc();
+    auto timed = [&decode_ms](const std::function<void()>& work) {
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        decode_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto drain = [&]() {
+        while (static_cast<int>(frames->size()) < max_frames) {
+            AVFrame* frame = av_frame_alloc();
+            bool got = false;
+            timed([&]() { got = decoder.receiveFrame(frame); });
+            if (!got) {
+                av_frame_free(&frame);
+                break;
+            }
+            frames->push_back(ffmpeg::SharedPointerFactory::wrapFrame(frame));
+        }
+    };
+    while (static_cast<int>(frames->size()) < max_frames && av_read_frame(input, packet) >= 0) {
+        if (packet->stream_index == stream_index) {
+            timed([&]() { decoder.sendPacket(packet); });
+            drain();
+        }
+        av_packet_unref(packet);
+    }
+    decoder.sendPacket(nullptr);
+    drain();
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    return decode_ms;
+}
+
+} // namespace
+
+void TestAnalyticsStage::initTestCase()
+{
+    qDebug() << "🎯 开始画面分析测试";
+    qDebug() << "   内核指令集:" << motion_kernels::isaName(motion_kernels::activeIsa());
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+}
+
+void TestAnalyticsStage::cleanup()
+{
+    motion_kernels::forceScalar(false);
+}
+
+// ==================== 内核 ====================
+
+void TestAnalyticsStage::testDownscaleMatchesScalar()
+{
+    if (motion_kernels::activeIsa() == motion_kernels::Isa::Scalar) {
+        QSKIP("CPU不支持AVX2");
+    }
+    std::mt19937 rng(1);
+    // 覆盖向量宽度的整数倍和带尾部的尺寸
+    const int sizes[][2] = {{64, 2}, {130, 9}, {1920, 1080}, {333, 77}, {66, 33}};
+    for (const auto& size : sizes) {
+        const int width = size[0];
+        const int height = size[1];
+        const int src_stride = width + 17;
+        const std::vector<uint8_t> src = randomPlane(rng, src_stride, height);
+        const int dst_stride = width / 2 + 5;
+        std::vector<uint8_t> simd(static_cast<size_t>(dst_stride) * (height / 2), 0);
+        std::vector<uint8_t> scalar(simd.size(), 0);
+
+        motion_kernels::downscale2x(src.data(), src_stride, width, height, simd.data(), dst_stride);
+        motion_kernels::forceScalar(true);
+        motion_kernels::downscale2x(src.data(), src_stride, width, height, scalar.data(), dst_stride);
+        motion_kernels::forceScalar(false);
+        QVERIFY2(simd == scalar, qPrintable(QString("%1x%2").arg(width).arg(height)));
+    }
+
+    // 四舍五入：(1+2+2+2)/4 = 1.75 -> 2
+    const uint8_t src[4] = {1, 2, 2, 2};
+    uint8_t out = 0;
+    motion_kernels::downscale2x(src, 2, 2, 2, &out, 1);
+    QCOMPARE(static_cast<int>(out), 2);
+}
+
+void TestAnalyticsStage::testBlockSadMatchesScalar()
+{
+    std::mt19937 rng(2);
+    const int sizes[][2] = {{320, 180}, {48, 16}, {16, 16}, {200, 70}};
+    for (const auto& size : sizes) {
+        const int width = size[0];
+        const int height = size[1];
+        const int stride = width + 32;
+        const std::vector<uint8_t> cur = randomPlane(rng, stride, height);
+        const std::vector<uint8_t> prev = randomPlane(rng, stride, height);
+        const int blocks = (width / motion_kernels::kBlockSize) * (height / motion_kernels::kBlockSize);
+        std::vector<uint32_t> simd(static_cast<size_t>(blocks), 0);
+        std::vector<uint32_t> scalar(simd.size(), 0);
+
+        motion_kernels::blockSad16(cur.data(), stride, prev.data(), stride, width, height, simd.data());
+        motion_kernels::forceScalar(true);
+        motion_kernels::blockSad16(cur.data(), stride, prev.data(), stride, width, height, scalar.data());
+        motion_kernels::forceScalar(false);
+        QVERIFY2(simd == scalar, qPrintable(QString("%1x%2").arg(width).arg(height)));
+    }
+
+    // 相同平面SAD为0，整块差3则为3*256
+    std::vector<uint8_t> a(32 * 16, 10);
+    std::vector<uint8_t> b(32 * 16, 10);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 16; x < 32; ++x) {
+            b[y * 32 + x] = 13;
+        }
+    }
+    uint32_t sad[2] = {1, 1};
+    motion_kernels::blockSad16(a.data(), 32, b.data(), 32, 32, 16, sad);
+    QCOMPARE(sad[0], 0u);
+    QCOMPARE(sad[1], 3u * 256u);
+}
+
+void TestAnalyticsStage::testHistogram()
+{
+    const int width = 37;
+    const int height = 5;
+    const int stride = 40;
+    std::vector<uint8_t> plane(static_cast<size_t>(stride) * height, 255);   // 行尾填充不应计入
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            plane[y * stride + x] = static_cast<uint8_t>(x % 3);
+        }
+    }
+    uint32_t hist[motion_kernels::kHistogramBins];
+    motion_kernels::histogram(plane.data(), stride, width, height, hist);
+    QCOMPARE(hist[0], 13u * height);
+    QCOMPARE(hist[1], 12u * height);
+    QCOMPARE(hist[2], 12u * height);
+    QCOMPARE(hist[255], 0u);
+}
+
+// ==================== 检测 ====================
+
+void TestAnalyticsStage::testStaticSceneNoEvents()
+{
+    AnalyticsStage stage;
+    std::vector<AnalyticsEvent> events;
+    stage.setEventCallback([&events](const AnalyticsEvent& event) { events.push_back(event); });
+
+    for (int i = 0; i < 30; ++i) {
+        AVFrame* frame = makeScene(640, 360, i, 40);
+        FrameAnalysis result;
+        QVERIFY(stage.analyze(frame, kTimeBase, &result));
+        av_frame_free(&frame);
+        QCOMPARE(result.analysis_width, 320);
+        QCOMPARE(result.analysis_height, 180);
+        QCOMPARE(result.timestamp_us, static_cast<int64_t>(i) * 40000);
+        QCOMPARE(result.mean_sad, 0.0);
+        QVERIFY(!result.in_motion);
+        QVERIFY(result.mean_luma > 40.0 && result.mean_luma < 72.0);
+        QVERIFY(result.luma_stddev > 1.0);
+    }
+    QVERIFY(events.empty());
+    QCOMPARE(stage.getStatistics().frames_analyzed, static_cast<uint64_t>(30));
+}
+
+void TestAnalyticsStage::testMotionStartEnd()
+{
+    AnalyticsStage::Config config;
+    config.motion_trigger_frames = 2;
+    config.motion_hold_frames = 5;
+    AnalyticsStage stage(config);
+    std::vector<AnalyticsEvent> events;
+    stage.setEventCallback([&events](const AnalyticsEvent& event) { events.push_back(event); });
+
+    // 10帧静止，20帧方块右移，之后静止
+    Square square{200, 120, 64};
+    int frame_index = 0;
+    Square at_start{0, 0, 0};
+    auto step = [&](bool moving) {
+        if (moving) {
+            square.x += 8;
+        }
+        AVFrame* frame = makeScene(640, 360, frame_index++, 40, &square);
+        const size_t before = events.size();
+        stage.analyze(frame, kTimeBase, nullptr);
+        av_frame_free(&frame);
+        if (events.size() > before && events.back().type == AnalyticsEvent::Type::MotionStart) {
+            at_start = square;
+        }
+    };
+    for (int i = 0; i < 10; ++i) {
+        step(false);
+    }
+    QVERIFY(events.empty());
+    for (int i = 0; i < 20; ++i) {
+        step(true);
+    }
+    for (int i = 0; i < 10; ++i) {
+        step(false);
+    }
+
+    QCOMPARE(static_cast<int>(events.size()), 2);
+    const AnalyticsEvent& start = events[0];
+    QVERIFY(start.type == AnalyticsEvent::Type::MotionStart);
+    // 第二个移动帧触发（motion_trigger_frames=2）
+    QCOMPARE(start.timestamp_us, static_cast<int64_t>(11) * 40000);
+    // 包围盒覆盖当前方块，而且远小于整幅画面
+    QVERIFY(start.x <= at_start.x && start.x + start.width >= at_start.x + at_start.size);
+    QVERIFY(start.y <= at_start.y && start.y + start.height >= at_start.y + at_start.size);
+    QVERIFY(start.width <= 4 * at_start.size && start.height <= 4 * at_start.size);
+    QVERIFY(start.score > 0.0 && start.score < 0.2);
+
+    const AnalyticsEvent& end = events[1];
+    QVERIFY(end.type == AnalyticsEvent::Type::MotionEnd);
+    // 最后一个移动帧之后第5个静止帧结束
+    QCOMPARE(end.timestamp_us, static_cast<int64_t>(34) * 40000);
+    QCOMPARE(stage.getStatistics().motion_events, static_cast<uint64_t>(1));
+}
+
+void TestAnalyticsStage::testSceneChange()
+{
+    AnalyticsStage stage;
+    std::vector<AnalyticsEvent> events;
+    stage.setEventCallback([&events](const AnalyticsEvent& event) { events.push_back(event); });
+
+    std::vector<FrameAnalysis> results;
+    for (int i = 0; i < 40; ++i) {
+        // 第20帧切到亮场景
+        AVFrame* frame = makeScene(640, 360, i, i < 20 ? 30 : 190);
+        FrameAnalysis result;
+        QVERIFY(stage.analyze(frame, kTimeBase, &result));
+        av_frame_free(&frame);
+        results.push_back(result);
+    }
+
+    QCOMPARE(static_cast<int>(events.size()), 1);
+    QVERIFY(events[0].type == AnalyticsEvent::Type::SceneChange);
+    QCOMPARE(events[0].timestamp_us, static_cast<int64_t>(20) * 40000);
+    QVERIFY(events[0].score > 0.9);
+    QVERIFY(results[20].scene_change);
+    QVERIFY(results[20].mean_sad > 100.0);
+    QVERIFY(!results[21].scene_change);
+    QCOMPARE(results[21].scene_score, 0.0);
+    QCOMPARE(stage.getStatistics().scene_changes, static_cast<uint64_t>(1));
+    QCOMPARE(stage.getStatistics().motion_events, static_cast<uint64_t>(0));
+}
+
+// ==================== 阶段行为 ====================
+
+void TestAnalyticsStage::testSharesFrameByReference()
+{
+    AnalyticsStage stage;
+    Gate gate;
+    stage.setFrameCallback([&gate](const FrameAnalysis&) { gate.enterAndWait(); });
+    QVERIFY(stage.start());
+
+    AVFrame* frame = makeScene(640, 360, 0, 40);
+    QCOMPARE(av_buffer_get_ref_count(frame->buf[0]), 1);
+    QVERIFY(stage.submit(frame, kTimeBase));
+
+    // 分析线程持有的是同一块缓冲区的引用，而不是拷贝
+    QVERIFY(gate.waitEntered(2000));
+    QCOMPARE(av_buffer_get_ref_count(frame->buf[0]), 2);
+
+    gate.open();
+    QVERIFY(stage.waitIdle(2000));
+    QCOMPARE(av_buffer_get_ref_count(frame->buf[0]), 1);
+    stage.stop();
+    av_frame_free(&frame);
+}
+
+void TestAnalyticsStage::testDropsWhenFull()
+{
+    AnalyticsStage::Config config;
+    config.queue_frames = 2;
+    AnalyticsStage stage(config);
+    Gate gate;
+    stage.setFrameCallback([&gate](const FrameAnalysis&) { gate.enterAndWait(); });
+    QVERIFY(stage.start());
+
+    AVFrame* frame = makeScene(320, 180, 0, 40);
+    QVERIFY(stage.submit(frame, kTimeBase));
+    QVERIFY(gate.waitEntered(2000));
+
+    // 分析线程被卡住：两帧入队，第三帧丢弃，submit不阻塞
+    const auto start = std::chrono::steady_clock::now();
+    QVERIFY(stage.submit(frame, kTimeBase));
+    QVERIFY(stage.submit(frame, kTimeBase));
+    QVERIFY(!stage.submit(frame, kTimeBase));
+    QVERIFY(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+
+    gate.open();
+    QVERIFY(stage.waitIdle(2000));
+    const AnalyticsStage::StatisticsSnapshot stats = stage.getStatistics();
+    QCOMPARE(stats.frames_submitted, static_cast<uint64_t>(4));
+    QCOMPARE(stats.frames_dropped, static_cast<uint64_t>(1));
+    QCOMPARE(stats.frames_analyzed, static_cast<uint64_t>(3));
+    stage.stop();
+
+    // 停止后不接收
+    QVERIFY(!stage.submit(frame, kTimeBase));
+    av_frame_free(&frame);
+}
+
+void TestAnalyticsStage::testRejectsUnsupportedFormat()
+{
+    AVFrame* rgb = makeFrame(64, 64, AV_PIX_FMT_RGB24, 0, [](int, int) -> uint8_t { return 0; });
+    AVFrame* nv12 = makeFrame(64, 64, AV_PIX_FMT_NV12, 0, [](int, int) -> uint8_t { return 0; });
+    AVFrame* gray = makeFrame(64, 64, AV_PIX_FMT_GRAY8, 0, [](int, int) -> uint8_t { return 0; });
+    AVFrame* tiny = makeFrame(8, 8, AV_PIX_FMT_YUV420P, 0, [](int, int) -> uint8_t { return 0; });
+    QVERIFY(!AnalyticsStage::isSupportedFormat(rgb));
+    QVERIFY(AnalyticsStage::isSupportedFormat(nv12));
+    QVERIFY(AnalyticsStage::isSupportedFormat(gray));
+    QVERIFY(!AnalyticsStage::isSupportedFormat(tiny));
+
+    AnalyticsStage stage;
+    QVERIFY(!stage.analyze(rgb, kTimeBase, nullptr));
+    QVERIFY(!stage.getLastError().empty());
+    QCOMPARE(stage.getStatistics().frames_unsupported, static_cast<uint64_t>(1));
+    QVERIFY(stage.analyze(nv12, kTimeBase, nullptr));
+
+    av_frame_free(&rgb);
+    av_frame_free(&nv12);
+    av_frame_free(&gray);
+    av_frame_free(&tiny);
+}
+
+void TestAnalyticsStage::testPipelineFeedsStage()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    MediaPipeline::Config config;
+    config.audio.sink_type = AudioSinkType::Null;
+    config.video_decoder_threads = 1;
+
+    MediaPipeline pipeline;
+    QVERIFY2(pipeline.open(media_file_.toStdString(), config), pipeline.getLastError().c_str());
+
+    auto stage = std::make_shared<AnalyticsStage>();
+    std::atomic<int> analyzed{0};
+    std::atomic<int64_t> last_timestamp{AV_NOPTS_VALUE};
+    stage->setFrameCallback([&](const FrameAnalysis& result) {
+        analyzed++;
+        last_timestamp = result.timestamp_us;
+    });
+    QVERIFY(stage->start());
+    pipeline.setAnalyticsStage(stage);
+
+    QVERIFY(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    pipeline.stop();
+    stage->waitIdle(2000);
+    stage->stop();
+
+    const MediaPipeline::StatisticsSnapshot pipeline_stats = pipeline.getStatistics();
+    const AnalyticsStage::StatisticsSnapshot stats = stage->getStatistics();
+    qDebug() << "   解码" << pipeline_stats.video_frames_decoded << "帧，提交" << stats.frames_submitted
+             << "帧，分析" << stats.frames_analyzed << "帧，丢弃" << stats.frames_dropped
+             << "帧，平均" << stats.average_analyze_us << "us";
+    QVERIFY(stats.frames_submitted > 0);
+    QCOMPARE(stats.frames_submitted, pipeline_stats.video_frames_decoded);
+    QVERIFY(analyzed.load() > 0);
+    QVERIFY(last_timestamp.load() != AV_NOPTS_VALUE);
+    pipeline.close();
+}
+
+// ==================== 基准 ====================
+
+void TestAnalyticsStage::benchmarkAnalyticsVsDecode()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    std::vector<ffmpeg::AVFrameSharedPtr> frames;
+    AVRational time_base{1, 1};
+    const double decode_ms = decodeFile(media_file_, 120, &frames, &time_base);
+    QVERIFY(decode_ms >= 0.0);
+    if (frames.size() < 10) {
+        QSKIP("测试媒体视频帧太少");
+    }
+    if (!AnalyticsStage::isSupportedFormat(frames.front().get())) {
+        QSKIP("测试媒体的像素格式不支持分析");
+    }
+    const double decode_per_frame = decode_ms / frames.size();
+
+    auto measure = [&frames, time_base]() {
+        AnalyticsStage stage;
+        const auto start = std::chrono::steady_clock::now();
+        for (const ffmpeg::AVFrameSharedPtr& frame : frames) {
+            stage.analyze(frame.get(), time_base, nullptr);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+               frames.size();
+    };
+
+    motion_kernels::forceScalar(true);
+    const double scalar_per_frame = measure();
+    motion_kernels::forceScalar(false);
+    const double simd_per_frame = measure();
+
+    qDebug() << "   " << frames.front()->width << "x" << frames.front()->height << "共" << frames.size() << "帧";
+    qDebug() << "   单线程解码:" << decode_per_frame << "ms/帧";
+    qDebug() << "   分析(标量):" << scalar_per_frame << "ms/帧";
+    qDebug() << "   分析(" << motion_kernels::isaName(motion_kernels::activeIsa()) << "):"
+             << simd_per_frame << "ms/帧";
+
+    // 分析必须明显便宜于解码，挂在管道里不能成为瓶颈
+    QVERIFY2(simd_per_frame < decode_per_frame * 0.5,
+             qPrintable(QString("分析%1ms/帧，解码%2ms/帧").arg(simd_per_frame).arg(decode_per_frame)));
+}
@@ -0,0 +1,41 @@
+#ifndef TEST_ANALYTICS_STAGE_H
+#define TEST_ANALYTICS_STAGE_H
+
+#include <QtTest>
+#include <QObject>
+#include <QString>
+
+#include "media/analytics/analytics_stage.h"
+
+class TestAnalyticsStage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    // 内核：AVX2与标量逐位一致
+    void testDownscaleMatchesScalar();
+    void testBlockSadMatchesScalar();
+    void testHistogram();
+
+    // 检测
+    void testStaticSceneNoEvents();
+    void testMotionStartEnd();
+    void testSceneChange();
+
+    // 阶段行为
+    void testSharesFrameByReference();
+    void testDropsWhenFull();
+    void testRejectsUnsupportedFormat();
+    void testPipelineFeedsStage();
+
+    // 基准：分析耗时相对解码耗时
+    void benchmarkAnalyticsVsDecode();
+
+private:
+    QString media_file_;
+};
+
+#endif // TEST_ANALYTICS_STAGE_H
@@ -0,0 +1,226 @@
+#include "test_audio_output.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTemporaryDir>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 生成n帧立体声S16，每个采样值为帧序号的低16位，便于校验顺序
+std::vector<int16_t> makeRamp(size_t frames, size_t start = 0) {
+    std::vector<int16_t> samples(frames * 2);
+    for (size_t i = 0; i < frames; ++i) {
+        samples[i * 2] = static_cast<int16_t>(start + i);
+        samples[i * 2 + 1] = static_cast<int16_t>(start + i);
+    }
+    return samples;
+}
+
+media::AudioOutput::Config nullConfig() {
+    media::AudioOutput::Config config;
+    config.sink_type = media::AudioSinkType::Null;
+    config.format.sample_rate = 48000;
+    config.format.channels = 2;
+    config.format.sample_fmt = AV_SAMPLE_FMT_S16;
+    config.period_frames = 256;
+    config.buffer_ms = 200;
+    return config;
+}
+
+} // namespace
+
+void TestAudioOutput::initTestCase()
+{
+    qDebug() << "🔊 开始音频输出模块测试";
+}
+
+void TestAudioOutput::testRingBufferWrapAround()
+{
+    media::AudioRingBuffer ring(100, 4);
+    QCOMPARE(ring.capacityFrames(), size_t(128));
+    QCOMPARE(ring.availableWrite(), size_t(128));
+
+    // 写满后只接受剩余空间
+    auto data = makeRamp(200);
+    QCOMPARE(ring.write(reinterpret_cast<const uint8_t*>(data.data()), 100), size_t(100));
+    QCOMPARE(ring.write(reinterpret_cast<const uint8_t*>(data.data() + 200), 100), size_t(28));
+    QCOMPARE(ring.availableRead(), size_t(128));
+
+    // 读走一部分再写，跨越缓冲区末尾
+    std::vector<int16_t> out(256 * 2);
+    QCOMPARE(ring.read(reinterpret_cast<uint8_t*>(out.data()), 90), size_t(90));
+    QCOMPARE(out[0], int16_t(0));
+    QCOMPARE(out[89 * 2], int16_t(89));
+
+    auto more = makeRamp(80, 1000);
+    QCOMPARE(ring.write(reinterpret_cast<const uint8_t*>(more.data()), 80), size_t(80));
+    QCOMPARE(ring.read(reinterpret_cast<uint8_t*>(out.data()), 256), size_t(118));
+    QCOMPARE(out[0], int16_t(90));
+    QCOMPARE(out[37 * 2], int16_t(127));        // 第二次写入的最后一帧（来自makeRamp(200)的第127帧）
+    QCOMPARE(out[38 * 2], int16_t(1000));
+    QCOMPARE(out[117 * 2 + 1], int16_t(1079));
+    QCOMPARE(ring.availableRead(), size_t(0));
+}
+
+void TestAudioOutput::testRingBufferDiscard()
+{
+    media::AudioRingBuffer ring(64, 4);
+    auto data = makeRamp(40);
+    ring.write(reinterpret_cast<const uint8_t*>(data.data()), 30);
+    const size_t flush_position = ring.writePosition();
+    ring.write(reinterpret_cast<const uint8_t*>(data.data() + 60), 10);
+
+    // 只丢弃flush之前的数据，之后写入的保留
+    ring.discardUntil(flush_position);
+    QCOMPARE(ring.availableRead(), size_t(10));
+    int16_t frame[2] = {0, 0};
+    ring.read(reinterpret_cast<uint8_t*>(frame), 1);
+    QCOMPARE(frame[0], int16_t(30));
+
+    // 旧的丢弃位置不会让读位置后退
+    ring.discardUntil(flush_position);
+    QCOMPARE(ring.availableRead(), size_t(9));
+}
+
+void TestAudioOutput::testRingBufferConcurrent()
+{
+    media::AudioRingBuffer ring(1024, sizeof(uint32_t));
+    const uint32_t total = 2000000;
+
+    std::thread producer([&ring, total]() {
+        uint32_t chunk[97];
+        uint32_t next = 0;
+        while (next < total) {
+            uint32_t count = std::min<uint32_t>(97, total - next);
+            for (uint32_t i = 0; i < count; ++i) {
+                chunk[i] = next + i;
+            }
+            size_t written = ring.write(reinterpret_cast<const uint8_t*>(chunk), count);
+            next += static_cast<uint32_t>(written);
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // 消费者按不同块大小读取，序列必须连续
+    uint32_t expected = 0;
+    bool ordered = true;
+    uint32_t buffer[61];
+    while (expected < total) {
+        size_t got = ring.read(reinterpret_cast<uint8_t*>(buffer), 61);
+        for (size_t i = 0; i < got; ++i) {
+            ordered = ordered && buffer[i] == expected;
+            expected++;
+        }
+        if (got == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    QVERIFY(ordered);
+    QCOMPARE(expected, total);
+}
+
+void TestAudioOutput::testClockAndUnderrun()
+{
+    media::AudioOutput output;
+    QVERIFY2(output.initialize(nullConfig()), qPrintable(QString::fromStdString(output.getLastError())));
+    QCOMPARE(QString::fromStdString(output.sinkName()), QStringLiteral("null"));
+    QCOMPARE(output.getClockUs(), int64_t(AV_NOPTS_VALUE));
+
+    // 100ms音频，第一帧pts为1秒
+    auto data = makeRamp(4800);
+    QCOMPARE(output.write(reinterpret_cast<const uint8_t*>(data.data()), 4800, 1000000), size_t(4800));
+    QVERIFY(output.start());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const int64_t clock1 = output.getClockUs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const int64_t clock2 = output.getClockUs();
+    qDebug() << "   音频时钟:" << clock1 << "->" << clock2;
+    QVERIFY(clock1 >= 1000000);
+    QVERIFY(clock1 < 1100000);
+    QVERIFY(clock2 > clock1);
+
+    // 数据耗尽后回调继续，欠载被计数，时钟停在数据末尾附近
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    output.stop();
+
+    const auto stats = output.getStatistics();
+    qDebug() << "   回调" << stats.callbacks << "次，欠载" << stats.underruns
+             << "次，静音" << stats.silence_frames << "帧，回调最大耗时" << stats.max_callback_us << "us";
+    QCOMPARE(stats.frames_written, uint64_t(4800));
+    QCOMPARE(stats.frames_rendered, uint64_t(4800));
+    QVERIFY(stats.underruns > 0);
+    QVERIFY(stats.silence_frames > 0);
+    QCOMPARE(stats.buffered_frames, size_t(0));
+    QVERIFY(output.getClockUs() <= 1100000);
+}
+
+void TestAudioOutput::testFlushRebasesClock()
+{
+    media::AudioOutput output;
+    QVERIFY(output.initialize(nullConfig()));
+
+    auto data = makeRamp(4800);
+    output.write(reinterpret_cast<const uint8_t*>(data.data()), 4800, 0);
+    QVERIFY(output.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // seek：丢弃旧数据，新数据从5秒开始
+    output.flush();
+    QCOMPARE(output.getClockUs(), int64_t(AV_NOPTS_VALUE));
+    output.write(reinterpret_cast<const uint8_t*>(data.data()), 4800, 5000000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+    const int64_t clock = output.getClockUs();
+    output.stop();
+    qDebug() << "   flush后时钟:" << clock;
+    QVERIFY(clock >= 5000000);
+    QVERIFY(clock < 5100000);
+    // 旧数据没有全部播出
+    QVERIFY(output.getStatistics().frames_rendered < 9600);
+}
+
+void TestAudioOutput::testFileSinkWritesWav()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("out.wav"));
+
+    media::AudioOutput::Config config = nullConfig();
+    config.sink_type = media::AudioSinkType::File;
+    config.target = path.toStdString();
+
+    {
+        media::AudioOutput output;
+        QVERIFY2(output.initialize(config), qPrintable(QString::fromStdString(output.getLastError())));
+        auto data = makeRamp(2400);
+        output.write(reinterpret_cast<const uint8_t*>(data.data()), 2400, 0);
+        QVERIFY(output.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        output.close();
+    }
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray bytes = file.readAll();
+    QVERIFY(bytes.size() > 44);
+    QCOMPARE(bytes.left(4), QByteArray("RIFF"));
+    QCOMPARE(bytes.mid(8, 8), QByteArray("WAVEfmt "));
+
+    // data块长度与文件长度一致，且是整帧
+    const uchar* header = reinterpret_cast<const uchar*>(bytes.constData());
+    const quint32 data_bytes = header[40] | (header[41] << 8) | (header[42] << 16) | (quint32(header[43]) << 24);
+    QCOMPARE(int(data_bytes), bytes.size() - 44);
+    QCOMPARE(data_bytes % 4, quint32(0));
+
+    // 开头就是写入的数据
+    const int16_t* samples = reinterpret_cast<const int16_t*>(bytes.constData() + 44);
+    QCOMPARE(samples[0], int16_t(0));
+    QCOMPARE(samples[2 * 100], int16_t(100));
+}
@@ -0,0 +1,28 @@
+#ifndef TEST_AUDIO_OUTPUT_H
+#define TEST_AUDIO_OUTPUT_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/audio/audio_output.h"
+#include "media/audio/audio_ring_buffer.h"
+
+class TestAudioOutput : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 环形缓冲
+    void testRingBufferWrapAround();
+    void testRingBufferDiscard();
+    void testRingBufferConcurrent();
+
+    // 输出与时钟
+    void testClockAndUnderrun();
+    void testFlushRebasesClock();
+    void testFileSinkWritesWav();
+};
+
+#endif // TEST_AUDIO_OUTPUT_H
@@ -0,0 +1,403 @@
+#include "test_loudness_meter.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "media/media_pipeline.h"
+#include "utils/metrics_registry.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+#include <libavutil/samplefmt.h>
+}
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+
+// 各声道相同的正弦，幅度按dBFS（峰值）给出
+std::vector<float> makeSine(double frequency, double dbfs, double seconds, int channels = 2,
+                            int sample_rate = kSampleRate, double phase = 0.0) {
+    const size_t frames = static_cast<size_t>(seconds * sample_rate);
+    const double amplitude = std::pow(10.0, dbfs / 20.0);
+    std::vector<float> samples(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        const float value = static_cast<float>(
+            amplitude * std::sin(2.0 * M_PI * frequency * i / sample_rate + phase));
+        for (int c = 0; c < channels; ++c) {
+            samples[i * channels + c] = value;
+        }
+    }
+    return samples;
+}
+
+// 按音频帧大小分块送入
+void feed(media::LoudnessMeter& meter, const std::vector<float>& samples, int channels = 2) {
+    const int frames = static_cast<int>(samples.size() / channels);
+    for (int offset = 0; offset < frames; offset += 480) {
+        meter.process(samples.data() + static_cast<size_t>(offset) * channels, std::min(480, frames - offset));
+    }
+}
+
+std::vector<float> makeNoise(std::mt19937& rng, size_t count, float amplitude) {
+    std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+    std::vector<float> samples(count);
+    for (float& value : samples) {
+        value = dist(rng);
+    }
+    return samples;
+}
+
+AVFrame* makeAudioFrame(AVSampleFormat format, int channels, int sample_rate, int nb_samples) {
+    AVFrame* frame = av_frame_alloc();
+    frame->format = format;
+    frame->sample_rate = sample_rate;
+    frame->nb_samples = nb_samples;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+    av_channel_layout_default(&frame->ch_layout, channels);
+#else
+    frame->channels = channels;
+    frame->channel_layout = av_get_default_channel_layout(channels);
+#endif
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+    }
+    return frame;
+}
+
+} // namespace
+
+void TestLoudnessMeter::initTestCase()
+{
+    qDebug() << "📏 开始响度测量测试";
+    qDebug() << "   内核指令集:" << media::loudness_kernels::isaName(media::loudness_kernels::activeIsa());
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+}
+
+void TestLoudnessMeter::cleanup()
+{
+    media::loudness_kernels::forceScalar(false);
+}
+
+// ==================== 内核 ====================
+
+void TestLoudnessMeter::testKWeightingCoefficients()
+{
+    // BS.1770-4 表1、表2（48kHz）
+    const auto filter = media::loudness_kernels::KWeighting::forSampleRate(48000);
+    QVERIFY(std::abs(filter.shelf.b0 - 1.53512485958697) < 1e-12);
+    QVERIFY(std::abs(filter.shelf.b1 - -2.69169618940638) < 1e-12);
+    QVERIFY(std::abs(filter.shelf.b2 - 1.19839281085285) < 1e-12);
+    QVERIFY(std::abs(filter.shelf.a1 - -1.69065929318241) < 1e-12);
+    QVERIFY(std::abs(filter.shelf.a2 - 0.73248077421585) < 1e-12);
+    QVERIFY(std::abs(filter.highpass.a1 - -1.99004745483398) < 1e-12);
+    QVERIFY(std::abs(filter.highpass.a2 - 0.99007225036621) < 1e-12);
+}
+
+void TestLoudnessMeter::testKernelsMatchScalar()
+{
+    {
+        // 超过kMaxChannels的输入直接拒绝，不按截断后的步长读错采样
+        namespace lk = media::loudness_kernels;
+        const int channels = lk::kMaxChannels + 1;
+        const std::vector<float> input(static_cast<size_t>(channels) * 64, 0.5f);
+        lk::KWeightState state;
+        double sums[lk::kMaxChannels + 1] = {};
+        lk::kWeight(input.data(), channels, 64, lk::KWeighting::forSampleRate(kSampleRate), state, sums);
+        for (double sum : sums) {
+            QCOMPARE(sum, 0.0);
+        }
+    }
+
+    if (media::loudness_kernels::activeIsa() == media::loudness_kernels::Isa::Scalar) {
+        QSKIP("没有可用的SIMD实现");
+    }
+    namespace lk = media::loudness_kernels;
+    std::mt19937 rng(7);
+    const auto filter = lk::KWeighting::forSampleRate(kSampleRate);
+    // 覆盖单声道、成对声道、4声道组加余数，以及不满一个向量的长度
+    const int cases[][2] = {{1, 1000}, {2, 4800}, {3, 17}, {6, 1024}, {8, 333}, {5, 7}};
+    for (const auto& test : cases) {
+        const int channels = test[0];
+        const int frames = test[1];
+        const std::vector<float> input = makeNoise(rng, static_cast<size_t>(frames) * channels, 1.0f);
+
+        lk::KWeightState simd_state;
+        lk::KWeightState scalar_state;
+        double simd_sums[lk::kMaxChannels] = {};
+        double scalar_sums[lk::kMaxChannels] = {};
+        lk::kWeight(input.data(), channels, frames, filter, simd_state, simd_sums);
+        lk::forceScalar(true);
+        lk::kWeight(input.data(), channels, frames, filter, scalar_state, scalar_sums);
+        lk::forceScalar(false);
+        for (int c = 0; c < channels; ++c) {
+            QCOMPARE(simd_sums[c], scalar_sums[c]);
+            QCOMPARE(simd_state.highpass_z1[c], scalar_state.highpass_z1[c]);
+        }
+
+        const std::vector<float> plane = makeNoise(rng, static_cast<size_t>(frames) + lk::kTruePeakHistory, 1.0f);
+        const float simd_peak = lk::truePeak4x(plane.data() + lk::kTruePeakHistory, frames);
+        lk::forceScalar(true);
+        const float scalar_peak = lk::truePeak4x(plane.data() + lk::kTruePeakHistory, frames);
+        lk::forceScalar(false);
+        QCOMPARE(simd_peak, scalar_peak);
+    }
+}
+
+// ==================== 一致性 ====================
+
+void TestLoudnessMeter::testSineCalibration()
+{
+    // Tech 3341 用例1/2：立体声1kHz正弦，-23/-33 dBFS -> M、S、I均为-23/-33 LUFS（±0.1）
+    for (const double level : {-23.0, -33.0}) {
+        media::LoudnessMeter meter;
+        feed(meter, makeSine(1000.0, level, 20.0));
+        const media::LoudnessMeter::Reading reading = meter.reading();
+        qDebug() << "   " << level << "dBFS: M" << reading.momentary_lufs << "S" << reading.short_term_lufs
+                 << "I" << reading.integrated_lufs;
+        QVERIFY(std::abs(reading.momentary_lufs - level) < 0.1);
+        QVERIFY(std::abs(reading.short_term_lufs - level) < 0.1);
+        QVERIFY(std::abs(reading.integrated_lufs - level) < 0.1);
+        QVERIFY(std::abs(reading.sample_peak_dbfs - level) < 0.01);
+        QVERIFY(std::abs(reading.measured_seconds - 20.0) < 1e-9);
+        QCOMPARE(reading.loudness_range_lu, 0.0);
+    }
+
+    // 44.1kHz同样校准
+    media::LoudnessMeter::Config config;
+    config.sample_rate = 44100;
+    media::LoudnessMeter meter(config);
+    feed(meter, makeSine(1000.0, -23.0, 10.0, 2, 44100));
+    QVERIFY(std::abs(meter.reading().integrated_lufs - -23.0) < 0.1);
+}
+
+void TestLoudnessMeter::testIntegratedGating()
+{
+    // Tech 3341 用例3：-36/-23/-36 dBFS 各10/60/10秒，相对门限去掉两端 -> -23 LUFS
+    {
+        media::LoudnessMeter meter;
+        feed(meter, makeSine(1000.0, -36.0, 10.0));
+        feed(meter, makeSine(1000.0, -23.0, 60.0));
+        feed(meter, makeSine(1000.0, -36.0, 10.0));
+        QVERIFY(std::abs(meter.reading().integrated_lufs - -23.0) < 0.1);
+    }
+    // Tech 3341 用例4：-72/-26/-72 dBFS，绝对门限去掉两端 -> -26 LUFS
+    {
+        media::LoudnessMeter meter;
+        feed(meter, makeSine(1000.0, -72.0, 10.0));
+        feed(meter, makeSine(1000.0, -26.0, 60.0));
+        feed(meter, makeSine(1000.0, -72.0, 10.0));
+        QVERIFY(std::abs(meter.reading().integrated_lufs - -26.0) < 0.1);
+    }
+    // 纯静音：没有门控块
+    {
+        media::LoudnessMeter meter;
+        feed(meter, std::vector<float>(kSampleRate * 2 * 2, 0.0f));
+        QVERIFY(std::isinf(meter.reading().integrated_lufs));
+        QVERIFY(std::isinf(meter.reading().momentary_lufs));
+    }
+}
+
+void TestLoudnessMeter::testLoudnessRange()
+{
+    // Tech 3342 用例1/2：-20/-30 dBFS、-20/-15 dBFS 各20秒 -> LRA 10/5 LU（±1）
+    media::LoudnessMeter first;
+    feed(first, makeSine(1000.0, -20.0, 20.0));
+    feed(first, makeSine(1000.0, -30.0, 20.0));
+    QVERIFY(std::abs(first.reading().loudness_range_lu - 10.0) < 1.0);
+
+    media::LoudnessMeter second;
+    feed(second, makeSine(1000.0, -20.0, 20.0));
+    feed(second, makeSine(1000.0, -15.0, 20.0));
+    QVERIFY(std::abs(second.reading().loudness_range_lu - 5.0) < 1.0);
+}
+
+void TestLoudnessMeter::testTruePeak()
+{
+    // fs/4正弦相位45°：采样点都落在0.707倍峰值处，真峰值应接近实际幅度
+    media::LoudnessMeter::Config config;
+    config.channels = 1;
+    media::LoudnessMeter meter(config);
+    feed(meter, makeSine(kSampleRate / 4.0, -6.0, 2.0, 1, kSampleRate, M_PI / 4.0), 1);
+    const media::LoudnessMeter::Reading reading = meter.reading();
+    qDebug() << "   采样峰值" << reading.sample_peak_dbfs << "dBFS，真峰值" << reading.true_peak_dbtp << "dBTP";
+    QVERIFY(std::abs(reading.sample_peak_dbfs - -9.01) < 0.05);
+    QVERIFY(std::abs(reading.true_peak_dbtp - -6.0) < 0.3);
+
+    // 关闭真峰值
+    config.true_peak = false;
+    media::LoudnessMeter sample_only(config);
+    feed(sample_only, makeSine(1000.0, -6.0, 1.0, 1), 1);
+    QVERIFY(std::isinf(sample_only.reading().true_peak_dbtp));
+    QVERIFY(std::abs(sample_only.reading().sample_peak_dbfs - -6.0) < 0.01);
+}
+
+void TestLoudnessMeter::testSurroundWeights()
+{
+    const std::vector<double> weights = media::LoudnessMeter::defaultChannelWeights(6);
+    QCOMPARE(weights[0], 1.0);
+    QCOMPARE(weights[3], 0.0);
+    QCOMPARE(weights[5], 1.41);
+
+    // 5.1各声道同一正弦：3个1.0 + 2个1.41，LFE不计 -> 比立体声高10*log10(5.82/2)
+    media::LoudnessMeter::Config config;
+    config.channels = 6;
+    media::LoudnessMeter meter(config);
+    feed(meter, makeSine(1000.0, -23.0, 10.0, 6), 6);
+    const double expected = -23.0 + 10.0 * std::log10(5.82 / 2.0);
+    QVERIFY(std::abs(meter.reading().integrated_lufs - expected) < 0.1);
+}
+
+// ==================== 接入 ====================
+
+void TestLoudnessMeter::testFrameInput()
+{
+    const std::vector<float> samples = makeSine(1000.0, -23.0, 5.0);
+    const int total = static_cast<int>(samples.size() / 2);
+
+    media::LoudnessMeter interleaved;
+    feed(interleaved, samples);
+
+    // 同样的数据以FLTP帧送入，结果一致
+    media::LoudnessMeter planar;
+    for (int offset = 0; offset < total; offset += 1024) {
+        const int count = std::min(1024, total - offset);
+        AVFrame* frame = makeAudioFrame(AV_SAMPLE_FMT_FLTP, 2, kSampleRate, count);
+        QVERIFY(frame);
+        for (int c = 0; c < 2; ++c) {
+            float* plane = reinterpret_cast<float*>(frame->extended_data[c]);
+            for (int i = 0; i < count; ++i) {
+                plane[i] = samples[static_cast<size_t>(offset + i) * 2 + c];
+            }
+        }
+        QVERIFY(planar.process(frame));
+        av_frame_free(&frame);
+    }
+    QCOMPARE(planar.reading().integrated_lufs, interleaved.reading().integrated_lufs);
+    QCOMPARE(planar.reading().true_peak_dbtp, interleaved.reading().true_peak_dbtp);
+
+    // 格式不符：S16、采样率不同
+    AVFrame* s16 = makeAudioFrame(AV_SAMPLE_FMT_S16, 2, kSampleRate, 256);
+    AVFrame* wrong_rate = makeAudioFrame(AV_SAMPLE_FMT_FLT, 2, 44100, 256);
+    QVERIFY(!planar.process(s16));
+    QVERIFY(!planar.process(wrong_rate));
+    QCOMPARE(planar.getStatistics().frames_rejected, static_cast<uint64_t>(2));
+    QVERIFY(!planar.getLastError().empty());
+    av_frame_free(&s16);
+    av_frame_free(&wrong_rate);
+
+    // reset清除测量
+    planar.reset();
+    QVERIFY(std::isinf(planar.reading().integrated_lufs));
+    QCOMPARE(planar.reading().measured_seconds, 0.0);
+}
+
+void TestLoudnessMeter::testPublishesMetrics()
+{
+    media::LoudnessMeter::Config config;
+    config.metric_name = "test.program";
+    media::LoudnessMeter meter(config);
+    feed(meter, makeSine(1000.0, -23.0, 4.0));
+
+    double integrated = 0.0;
+    double short_term = 0.0;
+    bool found_range = false;
+    for (const media::MetricSample& sample : media::MetricsRegistry::instance().snapshot()) {
+        if (sample.name == "loudness.test.program.integrated") {
+            integrated = sample.value;
+        } else if (sample.name == "loudness.test.program.short_term") {
+            short_term = sample.value;
+        } else if (sample.name == "loudness.test.program.range") {
+            found_range = true;
+        }
+    }
+    QVERIFY(std::abs(integrated - -23.0) < 0.1);
+    QVERIFY(std::abs(short_term - -23.0) < 0.1);
+    QVERIFY(found_range);
+}
+
+void TestLoudnessMeter::testPipelineFeedsMeter()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    media::MediaPipeline::Config config;
+    config.audio.sink_type = media::AudioSinkType::Null;
+    config.video_decoder_threads = 1;
+
+    media::MediaPipeline pipeline;
+    QVERIFY2(pipeline.open(media_file_.toStdString(), config), pipeline.getLastError().c_str());
+
+    media::LoudnessMeter::Config meter_config;
+    meter_config.sample_rate = config.audio.format.sample_rate;
+    meter_config.channels = config.audio.format.channels;
+    auto meter = std::make_shared<media::LoudnessMeter>(meter_config);
+    pipeline.setLoudnessMeter(meter);
+
+    QVERIFY(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    pipeline.stop();
+    pipeline.close();
+
+    const media::LoudnessMeter::StatisticsSnapshot stats = meter->getStatistics();
+    const media::LoudnessMeter::Reading reading = meter->reading();
+    qDebug() << "   测量" << reading.measured_seconds << "秒，M" << reading.momentary_lufs
+             << "，真峰值" << reading.true_peak_dbtp;
+    if (stats.frames_processed == 0 && stats.frames_rejected == 0) {
+        QSKIP("测试媒体没有音频流");
+    }
+    QCOMPARE(stats.frames_rejected, static_cast<uint64_t>(0));
+    QVERIFY(stats.blocks_measured > 0);
+}
+
+// ==================== 基准 ====================
+
+void TestLoudnessMeter::benchmarkHundredStreams()
+{
+    // 100路48kHz立体声各5秒，单线程处理；完整测量（K加权、门控、真峰值）
+    constexpr int kStreams = 100;
+    constexpr double kSeconds = 5.0;
+    std::mt19937 rng(11);
+    const std::vector<float> samples = makeNoise(rng, static_cast<size_t>(kSampleRate * kSeconds) * 2, 0.3f);
+
+    auto measure = [&samples]() {
+        std::vector<std::unique_ptr<media::LoudnessMeter>> meters;
+        for (int i = 0; i < kStreams; ++i) {
+            meters.push_back(std::make_unique<media::LoudnessMeter>());
+        }
+        const int total = static_cast<int>(samples.size() / 2);
+        const auto start = std::chrono::steady_clock::now();
+        // 与实际一样交替处理各路的一帧（1024个采样）
+        for (int offset = 0; offset < total; offset += 1024) {
+            const int count = std::min(1024, total - offset);
+            for (auto& meter : meters) {
+                meter->process(samples.data() + static_cast<size_t>(offset) * 2, count);
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    media::loudness_kernels::forceScalar(true);
+    const double scalar_seconds = measure();
+    media::loudness_kernels::forceScalar(false);
+    const double simd_seconds = measure();
+
+    qDebug() << "   100路x" << kSeconds << "秒: 标量" << scalar_seconds << "s（单核占用"
+             << scalar_seconds / kSeconds * 100.0 << "%），"
+             << media::loudness_kernels::isaName(media::loudness_kernels::activeIsa()) << simd_seconds
+             << "s（单核占用" << simd_seconds / kSeconds * 100.0 << "%）";
+
+    // 一个核要跟得上100路实时音频
+    QVERIFY2(simd_seconds < kSeconds,
+             qPrintable(QString("处理%1秒音频用了%2秒").arg(kSeconds).arg(simd_seconds)));
+}
@@ -0,0 +1,41 @@
+#ifndef TEST_LOUDNESS_METER_H
+#define TEST_LOUDNESS_METER_H
+
+#include <QtTest>
+#include <QObject>
+#include <QString>
+
+#include "media/audio/loudness_meter.h"
+
+class TestLoudnessMeter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    // 内核
+    void testKWeightingCoefficients();
+    void testKernelsMatchScalar();
+
+    // EBU Tech 3341/3342 一致性
+    void testSineCalibration();
+    void testIntegratedGating();
+    void testLoudnessRange();
+    void testTruePeak();
+    void testSurroundWeights();
+
+    // 接入
+    void testFrameInput();
+    void testPublishesMetrics();
+    void testPipelineFeedsMeter();
+
+    // 基准：单核100路立体声
+    void benchmarkHundredStreams();
+
+private:
+    QString media_file_;
+};
+
+#endif // TEST_LOUDNESS_METER_H
@@ -0,0 +1,110 @@
+#include "test_wsola_time_stretcher.h"
+
+#include <QDebug>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kChannels = 2;
+
+// 立体声正弦
+std::vector<float> makeSine(double frequency, size_t frames) {
+    std::vector<float> samples(frames * kChannels);
+    for (size_t i = 0; i < frames; ++i) {
+        const float value = static_cast<float>(0.5 * std::sin(2.0 * M_PI * frequency * i / kSampleRate));
+        samples[i * kChannels] = value;
+        samples[i * kChannels + 1] = value;
+    }
+    return samples;
+}
+
+// 按块送入并取出全部输出
+std::vector<float> stretch(media::WsolaTimeStretcher& stretcher, const std::vector<float>& input) {
+    std::vector<float> output;
+    std::vector<float> chunk;
+    const size_t total = input.size() / kChannels;
+    for (size_t offset = 0; offset < total; offset += 1024) {
+        const size_t frames = std::min<size_t>(1024, total - offset);
+        stretcher.push(input.data() + offset * kChannels, frames);
+        chunk.resize(stretcher.availableFrames() * kChannels);
+        const size_t pulled = stretcher.pull(chunk.data(), stretcher.availableFrames());
+        output.insert(output.end(), chunk.begin(), chunk.begin() + pulled * kChannels);
+    }
+    return output;
+}
+
+// 用过零点估计左声道频率（跳过首尾各10%）
+double estimateFrequency(const std::vector<float>& samples) {
+    const size_t frames = samples.size() / kChannels;
+    const size_t begin = frames / 10;
+    const size_t end = frames - frames / 10;
+    size_t crossings = 0;
+    for (size_t i = begin + 1; i < end; ++i) {
+        if (samples[(i - 1) * kChannels] < 0.0f && samples[i * kChannels] >= 0.0f) {
+            crossings++;
+        }
+    }
+    return crossings * static_cast<double>(kSampleRate) / (end - begin);
+}
+
+} // namespace
+
+void TestWsolaTimeStretcher::initTestCase()
+{
+    qDebug() << "🎚️ 开始WSOLA时间伸缩测试";
+}
+
+void TestWsolaTimeStretcher::testBypassAtNormalSpeed()
+{
+    media::WsolaTimeStretcher stretcher(kSampleRate, kChannels);
+    const auto input = makeSine(440.0, kSampleRate / 2);
+    const auto output = stretch(stretcher, input);
+    QCOMPARE(output.size(), input.size());
+    QVERIFY(output == input);
+}
+
+void TestWsolaTimeStretcher::testSpeedUpKeepsPitch()
+{
+    media::WsolaTimeStretcher stretcher(kSampleRate, kChannels);
+    stretcher.setSpeed(1.5);
+    const auto input = makeSine(440.0, kSampleRate * 2);
+    const auto output = stretch(stretcher, input);
+
+    const double ratio = static_cast<double>(input.size()) / output.size();
+    const double frequency = estimateFrequency(output);
+    qDebug() << "   1.5x: 长度比" << ratio << "，频率" << frequency << "Hz";
+    QVERIFY(std::abs(ratio - 1.5) < 0.05);
+    QVERIFY(std::abs(frequency - 440.0) < 440.0 * 0.02);
+}
+
+void TestWsolaTimeStretcher::testSlowDownKeepsPitch()
+{
+    media::WsolaTimeStretcher stretcher(kSampleRate, kChannels);
+    stretcher.setSpeed(0.5);
+    const auto input = makeSine(440.0, kSampleRate);
+    const auto output = stretch(stretcher, input);
+
+    const double ratio = static_cast<double>(output.size()) / input.size();
+    const double frequency = estimateFrequency(output);
+    qDebug() << "   0.5x: 长度比" << ratio << "，频率" << frequency << "Hz";
+    QVERIFY(std::abs(ratio - 2.0) < 0.1);
+    QVERIFY(std::abs(frequency - 440.0) < 440.0 * 0.02);
+}
+
+void TestWsolaTimeStretcher::testResetDropsState()
+{
+    media::WsolaTimeStretcher stretcher(kSampleRate, kChannels);
+    stretcher.setSpeed(2.0);
+    const auto input = makeSine(440.0, kSampleRate);
+    stretch(stretcher, input);
+
+    stretcher.reset();
+    QCOMPARE(stretcher.availableFrames(), size_t(0));
+
+    // reset后从头开始，输出长度只取决于新输入
+    const auto output = stretch(stretcher, input);
+    const double ratio = static_cast<double>(input.size()) / output.size();
+    QVERIFY(std::abs(ratio - 2.0) < 0.2);
+}
@@ -0,0 +1,22 @@
+#ifndef TEST_WSOLA_TIME_STRETCHER_H
+#define TEST_WSOLA_TIME_STRETCHER_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/audio/wsola_time_stretcher.h"
+
+class TestWsolaTimeStretcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testBypassAtNormalSpeed();
+    void testSpeedUpKeepsPitch();
+    void testSlowDownKeepsPitch();
+    void testResetDropsState();
+};
+
+#endif // TEST_WSOLA_TIME_STRETCHER_H
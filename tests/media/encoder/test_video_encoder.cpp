@@ -0,0 +1,547 @@
+#include "test_video_encoder.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "media/decoder/ffmpeg_decoder.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+using namespace media;
+
+namespace {
+
+/**
+ * @brief 生成一帧带运动的测试图（斜向渐变随帧号平移）
+ */
+ffmpeg::AVFrameSharedPtr makeFrame(int width, int height, AVPixelFormat format, int64_t index)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->width = width;
+    frame->height = height;
+    frame->format = format;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    for (int plane = 0; plane < 3 && frame->data[plane]; ++plane) {
+        const int shift_w = plane > 0 ? desc->log2_chroma_w : 0;
+        const int shift_h = plane > 0 ? desc->log2_chroma_h : 0;
+        const int plane_w = AV_CEIL_RSHIFT(width, shift_w);
+        const int plane_h = AV_CEIL_RSHIFT(height, shift_h);
+        for (int y = 0; y < plane_h; ++y) {
+            uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+            for (int x = 0; x < plane_w; ++x) {
+                row[x] = plane == 0 ? static_cast<uint8_t>(x + y + index * 4)
+                                    : static_cast<uint8_t>(128 + ((x * plane) ^ y) % 32);
+            }
+        }
+    }
+    frame->pts = index;
+    return ffmpeg::SharedPointerFactory::wrapFrame(frame);
+}
+
+/**
+ * @brief 解码测试文件开头max_frames帧，逐帧回调
+ * @return 解码帧数，打不开时返回-1
+ */
+int decodeFile(const QString& path, int max_frames, int thread_count, VideoEncodeFormat* format,
+               const std::function<void(ffmpeg::AVFrameSharedPtr)>& on_frame)
+{
+    const QByteArray file = path.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, file.constData(), nullptr, nullptr) < 0) {
+        return -1;
+    }
+    avformat_find_stream_info(input, nullptr);
+    const int stream_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_index < 0) {
+        avformat_close_input(&input);
+        return -1;
+    }
+    const AVStream* stream = input->streams[stream_index];
+    if (format) {
+        format->width = stream->codecpar->width;
+        format->height = stream->codecpar->height;
+        format->pix_fmt = static_cast<AVPixelFormat>(stream->codecpar->format);
+        format->time_base = stream->time_base;
+        format->frame_rate = av_guess_frame_rate(input, const_cast<AVStream*>(stream), nullptr);
+        format->sample_aspect_ratio = stream->codecpar->sample_aspect_ratio;
+    }
+
+    FFmpegVideoDecoder::Config config;
+    config.thread_count = thread_count;
+    FFmpegVideoDecoder decoder(config);
+    if (!decoder.initialize(stream->codecpar)) {
+        avformat_close_input(&input);
+        return -1;
+    }
+
+    int decoded = 0;
+    AVPacket* packet = av_packet_alloc();
+    auto drain = [&]() {
+        while (decoded < max_frames) {
+            AVFrame* frame = av_frame_alloc();
+            if (!decoder.receiveFrame(frame)) {
+                av_frame_free(&frame);
+                break;
+            }
+            ++decoded;
+            on_frame(ffmpeg::SharedPointerFactory::wrapFrame(frame));
+        }
+    };
+    while (decoded < max_frames && av_read_frame(input, packet) >= 0) {
+        if (packet->stream_index == stream_index) {
+            decoder.sendPacket(packet);
+            drain();
+        }
+        av_packet_unref(packet);
+    }
+    decoder.sendPacket(nullptr);
+    drain();
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    return decoded;
+}
+
+const char* fastPreset(EncoderCodec codec)
+{
+    switch (codec) {
+    case EncoderCodec::AV1:
+        return "10";
+    case EncoderCodec::H265:
+        return "ultrafast";
+    case EncoderCodec::H264:
+    default:
+        return "veryfast";
+    }
+}
+
+} // namespace
+
+void TestVideoEncoder::initTestCase()
+{
+    qDebug() << "🎞️ 开始视频编码测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!FFmpegVideoEncoder::isAvailable(EncoderCodec::H264)) {
+        QSKIP("FFmpeg未编译libx264");
+    }
+}
+
+void TestVideoEncoder::testEncodeRoundTrip()
+{
+    FFmpegVideoEncoder::Config config;
+    config.preset = "veryfast";
+    config.gop_size = 30;
+    FFmpegVideoEncoder encoder(config);
+
+    VideoEncodeFormat format;
+    format.width = 320;
+    format.height = 240;
+    QVERIFY(encoder.initialize(format));
+    QVERIFY(encoder.getState() == EncoderState::Ready);
+
+    const int frame_count = 60;
+    std::vector<AVPacket*> packets;
+    AVPacket* packet = av_packet_alloc();
+    auto drain = [&]() {
+        while (encoder.receivePacket(packet)) {
+            packets.push_back(av_packet_clone(packet));
+            av_packet_unref(packet);
+        }
+    };
+    for (int i = 0; i < frame_count; ++i) {
+        ffmpeg::AVFrameSharedPtr frame = makeFrame(format.width, format.height, format.pix_fmt, i);
+        QVERIFY(frame);
+        QVERIFY(encoder.sendFrame(frame.get()));
+        drain();
+    }
+    QVERIFY(encoder.sendFrame(nullptr));
+    drain();
+    av_packet_free(&packet);
+    QVERIFY(encoder.getState() == EncoderState::Finished);
+
+    const EncoderStats stats = encoder.getStats();
+    QCOMPARE(stats.frames_encoded, static_cast<uint64_t>(frame_count));
+    QCOMPARE(stats.packets_output, static_cast<uint64_t>(packets.size()));
+    QCOMPARE(stats.encode_errors, static_cast<uint64_t>(0));
+    QVERIFY(stats.bytes_output > 0);
+    QVERIFY(stats.avg_encode_time > 0.0);
+
+    // 两个GOP：第0帧和第30帧是关键帧
+    const auto keyframes = std::count_if(packets.begin(), packets.end(),
+                                         [](const AVPacket* p) { return (p->flags & AV_PKT_FLAG_KEY) != 0; });
+    QVERIFY(keyframes >= 2);
+
+    // 用解码器读回
+    AVCodecParameters* codecpar = avcodec_parameters_alloc();
+    QVERIFY(encoder.copyParameters(codecpar));
+    QVERIFY(codecpar->extradata_size > 0);
+    FFmpegVideoDecoder decoder;
+    QVERIFY(decoder.initialize(codecpar));
+    avcodec_parameters_free(&codecpar);
+
+    int decoded = 0;
+    AVFrame* frame = av_frame_alloc();
+    auto receive = [&]() {
+        while (decoder.receiveFrame(frame)) {
+            QCOMPARE(frame->width, format.width);
+            QCOMPARE(frame->height, format.height);
+            ++decoded;
+            av_frame_unref(frame);
+        }
+    };
+    for (AVPacket* p : packets) {
+        decoder.sendPacket(p);
+        receive();
+        av_packet_free(&p);
+    }
+    decoder.sendPacket(nullptr);
+    receive();
+    av_frame_free(&frame);
+    QCOMPARE(decoded, frame_count);
+}
+
+void TestVideoEncoder::testLookaheadLatency()
+{
+    // 出第一个包之前送了多少帧：前瞻越长，编码延迟越大
+    auto firstPacketDelay = [](int lookahead) {
+        FFmpegVideoEncoder::Config config;
+        config.preset = "veryfast";
+        config.thread_count = 1;
+        config.max_b_frames = 0;
+        config.lookahead = lookahead;
+        FFmpegVideoEncoder encoder(config);
+
+        VideoEncodeFormat format;
+        format.width = 320;
+        format.height = 240;
+        if (!encoder.initialize(format)) {
+            return -1;
+        }
+        AVPacket* packet = av_packet_alloc();
+        int sent = 0;
+        for (; sent < 100; ++sent) {
+            ffmpeg::AVFrameSharedPtr frame = makeFrame(format.width, format.height, format.pix_fmt, sent);
+            encoder.sendFrame(frame.get());
+            if (encoder.receivePacket(packet)) {
+                av_packet_unref(packet);
+                break;
+            }
+        }
+        av_packet_free(&packet);
+        return sent + 1;
+    };
+
+    const int without = firstPacketDelay(0);
+    const int with = firstPacketDelay(30);
+    qDebug() << "   首包延迟：无前瞻" << without << "帧，前瞻30" << with << "帧";
+    QVERIFY(without > 0);
+    QVERIFY(with > 0);
+    QVERIFY(without <= 2);
+    QVERIFY(with > without + 10);
+}
+
+void TestVideoEncoder::testStageConvertsPooledFrames()
+{
+    EncoderStage::Config config;
+    config.encoder.preset = "veryfast";
+    config.encoder.gop_size = 250;
+    config.output_width = 160;
+    config.output_height = 120;
+    config.queue_frames = 4;
+    EncoderStage stage(config);
+
+    std::atomic<int> packets{0};
+    std::atomic<int> keyframes{0};
+    stage.setPacketCallback([&](AVPacket* packet) {
+        packets++;
+        if (packet->flags & AV_PKT_FLAG_KEY) {
+            keyframes++;
+        }
+    });
+
+    VideoEncodeFormat input;
+    input.width = 320;
+    input.height = 240;
+    input.pix_fmt = AV_PIX_FMT_YUV444P;
+    QVERIFY(stage.start(input));
+    QVERIFY(stage.isRunning());
+
+    const int frame_count = 50;
+    for (int i = 0; i < frame_count; ++i) {
+        ffmpeg::AVFrameSharedPtr frame = makeFrame(input.width, input.height, input.pix_fmt, i);
+        // 模拟解码帧带着I帧标记：编码器不应照搬源关键帧位置
+        frame->pict_type = AV_PICTURE_TYPE_I;
+        if (i == 20) {
+            // 缺时间戳的帧按帧率补齐
+            frame->pts = AV_NOPTS_VALUE;
+        }
+        QVERIFY(stage.submit(frame));
+    }
+    // 时间戳回退的帧被丢弃
+    ffmpeg::AVFrameSharedPtr stale = makeFrame(input.width, input.height, input.pix_fmt, 10);
+    QVERIFY(stage.submit(stale));
+    QVERIFY(stage.finish());
+    QVERIFY(!stage.isRunning());
+    QVERIFY(!stage.submit(stale));
+
+    const EncoderStage::StatisticsSnapshot stats = stage.getStatistics();
+    QCOMPARE(stats.frames_submitted, static_cast<uint64_t>(frame_count + 1));
+    QCOMPARE(stats.frames_converted, static_cast<uint64_t>(frame_count));
+    QCOMPARE(stats.timestamp_drops, static_cast<uint64_t>(1));
+    QVERIFY(stats.max_queue_depth <= config.queue_frames);
+
+    const EncoderStats encoder_stats = stage.getEncoderStats();
+    QCOMPARE(encoder_stats.frames_encoded, static_cast<uint64_t>(frame_count));
+    QCOMPARE(encoder_stats.encode_errors, static_cast<uint64_t>(0));
+    QCOMPARE(packets.load(), frame_count);
+    QCOMPARE(keyframes.load(), 1);
+
+    AVCodecParameters* codecpar = avcodec_parameters_alloc();
+    QVERIFY(stage.copyParameters(codecpar));
+    QCOMPARE(codecpar->width, 160);
+    QCOMPARE(codecpar->height, 120);
+    avcodec_parameters_free(&codecpar);
+}
+
+void TestVideoEncoder::testSegmentParallelTranscode()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+
+    // 测试文件每5秒一个关键帧：开头20秒切成4段并行转码
+    SegmentTranscoder::Config config;
+    config.encoder.preset = "veryfast";
+    config.worker_count = 4;
+    config.min_segment_us = 5 * 1000000LL;
+    config.max_duration_us = 20 * 1000000LL;
+    SegmentTranscoder transcoder(config);
+
+    const QString output_path = temp_dir_.filePath("segmented.mp4");
+    QVERIFY2(transcoder.transcode(media_file_.toStdString(), output_path.toStdString()),
+             transcoder.getLastError().c_str());
+
+    const std::vector<SegmentTranscoder::SegmentInfo> segments = transcoder.getSegments();
+    QVERIFY(segments.size() >= 4);
+    uint64_t segment_frames = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        QVERIFY(segments[i].ok);
+        QVERIFY(segments[i].frames > 0);
+        QVERIFY(!segments[i].extradata.empty());
+        QVERIFY(!QFileInfo::exists(QString::fromStdString(segments[i].spill_path)));
+        // 段与段不重叠
+        if (i > 0) {
+            QVERIFY(segments[i].first_pts > segments[i - 1].last_pts);
+        }
+        segment_frames += segments[i].frames;
+    }
+
+    const SegmentTranscoder::StatisticsSnapshot stats = transcoder.getStatistics();
+    QCOMPARE(stats.frames_encoded, segment_frames);
+    QCOMPARE(stats.frames_decoded, segment_frames);
+    QCOMPARE(stats.video_packets_written, segment_frames);
+    QVERIFY(stats.audio_packets_written > 0);
+    qDebug() << "   " << segments.size() << "段，" << segment_frames << "帧，转码" << stats.transcode_ms
+             << "ms，拼接" << stats.concat_ms << "ms，修正dts" << stats.dts_fixups;
+
+    // 与顺序解码对照：同一范围内的源帧一帧不多一帧不少
+    const int64_t last_pts = segments.back().last_pts;
+    int reference = 0;
+    decodeFile(media_file_, 100000, 0, nullptr, [&](ffmpeg::AVFrameSharedPtr frame) {
+        const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp
+                                                                           : frame->pts;
+        if (pts <= last_pts) {
+            ++reference;
+        }
+    });
+    QCOMPARE(static_cast<uint64_t>(reference), segment_frames);
+
+    // 输出文件：帧数一致，dts严格递增，pts间隔均匀（段边界处没有空洞或重叠）
+    const QByteArray path = output_path.toUtf8();
+    AVFormatContext* output = nullptr;
+    QVERIFY(avformat_open_input(&output, path.constData(), nullptr, nullptr) >= 0);
+    avformat_find_stream_info(output, nullptr);
+    const int video_stream = av_find_best_stream(output, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    QVERIFY(video_stream >= 0);
+
+    std::vector<int64_t> pts_list;
+    int64_t previous_dts = AV_NOPTS_VALUE;
+    bool dts_monotonic = true;
+    AVPacket* packet = av_packet_alloc();
+    while (av_read_frame(output, packet) >= 0) {
+        if (packet->stream_index == video_stream) {
+            if (previous_dts != AV_NOPTS_VALUE && packet->dts <= previous_dts) {
+                dts_monotonic = false;
+            }
+            previous_dts = packet->dts;
+            pts_list.push_back(packet->pts);
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&output);
+
+    QVERIFY(dts_monotonic);
+    QCOMPARE(static_cast<uint64_t>(pts_list.size()), segment_frames);
+    std::sort(pts_list.begin(), pts_list.end());
+    std::vector<int64_t> steps;
+    for (size_t i = 1; i < pts_list.size(); ++i) {
+        steps.push_back(pts_list[i] - pts_list[i - 1]);
+    }
+    QVERIFY(!steps.empty());
+    std::vector<int64_t> sorted_steps = steps;
+    std::nth_element(sorted_steps.begin(), sorted_steps.begin() + sorted_steps.size() / 2, sorted_steps.end());
+    const int64_t frame_step = sorted_steps[sorted_steps.size() / 2];
+    QVERIFY(frame_step > 0);
+    for (int64_t step : steps) {
+        QVERIFY(std::llabs(step - frame_step) <= 1);
+    }
+}
+
+void TestVideoEncoder::benchmarkEncodeDecodeSharing()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+
+    // 1. 纯编码吞吐：先解码到内存，排除解码开销
+    const int frame_count = 90;
+    VideoEncodeFormat format;
+    std::vector<ffmpeg::AVFrameSharedPtr> frames;
+    frames.reserve(frame_count);
+    QVERIFY(decodeFile(media_file_, frame_count, 0, &format,
+                       [&](ffmpeg::AVFrameSharedPtr frame) { frames.push_back(std::move(frame)); }) > 0);
+
+    for (EncoderCodec codec : {EncoderCodec::H264, EncoderCodec::H265, EncoderCodec::AV1}) {
+        if (!FFmpegVideoEncoder::isAvailable(codec)) {
+            qDebug() << "   " << FFmpegVideoEncoder::encoderName(codec) << "未编译，跳过";
+            continue;
+        }
+        EncoderStage::Config config;
+        config.encoder.codec = codec;
+        config.encoder.preset = fastPreset(codec);
+        EncoderStage stage(config);
+        QVERIFY2(stage.start(format), stage.getLastError().c_str());
+
+        QElapsedTimer timer;
+        timer.start();
+        for (const ffmpeg::AVFrameSharedPtr& frame : frames) {
+            QVERIFY(stage.submit(frame));
+        }
+        QVERIFY2(stage.finish(), stage.getLastError().c_str());
+        const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-6);
+        const EncoderStats stats = stage.getEncoderStats();
+        qDebug() << "   " << FFmpegVideoEncoder::encoderName(codec) << config.encoder.preset.c_str()
+                 << ":" << stats.frames_encoded / seconds << "fps，平均" << stats.avg_encode_time
+                 << "ms/帧，输出" << stats.bytes_output / 1024 << "KiB";
+        QCOMPARE(stats.frames_encoded, static_cast<uint64_t>(frames.size()));
+    }
+    frames.clear();
+
+    // 2. 解码与编码共享CPU：不同的线程划分下整条转码链路的帧率
+    struct Split {
+        int decode_threads;
+        int encode_threads;
+        EncoderThreading threading;
+        const char* name;
+    };
+    const Split splits[] = {
+        {0, 0, EncoderThreading::Auto, "自动/自动"},
+        {1, 0, EncoderThreading::Frame, "解码1/编码帧级"},
+        {1, 0, EncoderThreading::Slice, "解码1/编码片级"},
+        {2, 2, EncoderThreading::Frame, "解码2/编码2帧级"},
+    };
+    for (const Split& split : splits) {
+        EncoderStage::Config config;
+        config.encoder.preset = "veryfast";
+        config.encoder.thread_count = split.encode_threads;
+        config.encoder.threading = split.threading;
+        EncoderStage stage(config);
+
+        bool started = false;
+        QElapsedTimer timer;
+        timer.start();
+        const int decoded = decodeFile(media_file_, frame_count * 2, split.decode_threads, &format,
+                                       [&](ffmpeg::AVFrameSharedPtr frame) {
+            if (!started) {
+                started = stage.start(format);
+            }
+            stage.submit(std::move(frame));
+        });
+        QVERIFY(started);
+        QVERIFY2(stage.finish(), stage.getLastError().c_str());
+        const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-6);
+
+        const EncoderStage::StatisticsSnapshot stage_stats = stage.getStatistics();
+        const EncoderStats stats = stage.getEncoderStats();
+        qDebug() << "   " << split.name << ": 转码" << decoded / seconds << "fps，解码端等待"
+                 << stage_stats.submit_waits << "次，编码平均" << stats.avg_encode_time << "ms/帧";
+        QCOMPARE(stats.frames_encoded, static_cast<uint64_t>(decoded));
+    }
+}
+
+void TestVideoEncoder::benchmarkSegmentScaling()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+
+    // 单个编码器实例用满线程 vs 分段并行（每段单线程编码）
+    struct Run {
+        int workers;
+        int encoder_threads;
+        const char* name;
+    };
+    const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const Run runs[] = {
+        {1, 0, "单实例（编码器自动线程）"},
+        {1, 1, "1段并行"},
+        {2, 1, "2段并行"},
+        {cores, 1, "按核数并行"},
+    };
+
+    uint64_t expected_frames = 0;
+    for (const Run& run : runs) {
+        SegmentTranscoder::Config config;
+        config.encoder.preset = "veryfast";
+        config.encoder.thread_count = run.encoder_threads;
+        config.worker_count = run.workers;
+        config.min_segment_us = 5 * 1000000LL;
+        config.max_duration_us = 30 * 1000000LL;
+        config.copy_audio = false;
+        SegmentTranscoder transcoder(config);
+
+        const QString output_path = temp_dir_.filePath(QStringLiteral("scaling_%1.mkv").arg(run.workers));
+        QVERIFY2(transcoder.transcode(media_file_.toStdString(), output_path.toStdString()),
+                 transcoder.getLastError().c_str());
+        const SegmentTranscoder::StatisticsSnapshot stats = transcoder.getStatistics();
+        const double seconds = std::max((stats.transcode_ms + stats.concat_ms) / 1000.0, 1e-6);
+        qDebug() << "   " << run.name << "(" << run.workers << "路，" << cores << "核) :"
+                 << stats.frames_encoded / seconds << "fps，拼接" << stats.concat_ms << "ms";
+
+        // 并行度不改变输出帧数
+        if (expected_frames == 0) {
+            expected_frames = stats.frames_encoded;
+        }
+        QCOMPARE(stats.frames_encoded, expected_frames);
+        QCOMPARE(stats.video_packets_written, expected_frames);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef TEST_VIDEO_ENCODER_H
+#define TEST_VIDEO_ENCODER_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "media/encoder/encoder_stage.h"
+#include "media/encoder/segment_transcoder.h"
+
+class TestVideoEncoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 编码器
+    void testEncodeRoundTrip();
+    void testLookaheadLatency();
+
+    // 编码阶段
+    void testStageConvertsPooledFrames();
+
+    // 分段并行转码
+    void testSegmentParallelTranscode();
+
+    // 性能基准
+    void benchmarkEncodeDecodeSharing();
+    void benchmarkSegmentScaling();
+
+private:
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_VIDEO_ENCODER_H
@@ -0,0 +1,276 @@
+#include "test_frame_extractor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace media;
+
+namespace {
+
+// 测试媒体：30fps，每5秒一个关键帧
+constexpr int64_t kFrameUs = 33367;
+
+} // namespace
+
+void TestFrameExtractor::initTestCase()
+{
+    qDebug() << "🎞️ 开始批量抽帧测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+}
+
+void TestFrameExtractor::testPlanSamples()
+{
+    SamplingSpec spec;
+    spec.interval_us = 2000000;
+    std::vector<int64_t> samples = FrameExtractor::planSamples(spec, 9000000);
+    QCOMPARE(samples.size(), static_cast<size_t>(5));
+    QCOMPARE(samples.front(), static_cast<int64_t>(0));
+    QCOMPARE(samples.back(), static_cast<int64_t>(8000000));
+
+    // 起止范围与每文件上限
+    spec.start_us = 1000000;
+    spec.end_us = 6000000;
+    samples = FrameExtractor::planSamples(spec, 9000000);
+    QCOMPARE(samples.size(), static_cast<size_t>(3));
+    QCOMPARE(samples.front(), static_cast<int64_t>(1000000));
+    spec.max_frames_per_file = 2;
+    QCOMPARE(FrameExtractor::planSamples(spec, 9000000).size(), static_cast<size_t>(2));
+
+    // 时长未知且没有end_us时无法规划
+    SamplingSpec open_ended;
+    QVERIFY(FrameExtractor::planSamples(open_ended, -1).empty());
+
+    // 时间点列表：排序、去重、丢掉范围外的
+    SamplingSpec list;
+    list.mode = SamplingSpec::Mode::Timestamps;
+    list.timestamps_us = {5000000, 1000000, 5000000, -1, 12000000};
+    samples = FrameExtractor::planSamples(list, 10000000);
+    QCOMPARE(samples.size(), static_cast<size_t>(2));
+    QCOMPARE(samples[0], static_cast<int64_t>(1000000));
+    QCOMPARE(samples[1], static_cast<int64_t>(5000000));
+}
+
+void TestFrameExtractor::testOutputSize()
+{
+    int width = 0;
+    int height = 0;
+    FrameExtractor::outputSize(854, 480, AVRational{1, 1}, 0, 0, &width, &height);
+    QCOMPARE(width, 854);
+    QCOMPARE(height, 480);
+
+    FrameExtractor::outputSize(854, 480, AVRational{1, 1}, 224, 0, &width, &height);
+    QCOMPARE(width, 224);
+    QCOMPARE(height, 126);
+
+    FrameExtractor::outputSize(854, 480, AVRational{1, 1}, 0, 240, &width, &height);
+    QCOMPARE(width, 426);
+    QCOMPARE(height, 240);
+
+    // 非方形像素按显示宽高比
+    FrameExtractor::outputSize(720, 576, AVRational{16, 15}, 0, 288, &width, &height);
+    QCOMPARE(width, 384);
+
+    FrameExtractor::outputSize(854, 480, AVRational{1, 1}, 320, 320, &width, &height);
+    QCOMPARE(width, 320);
+    QCOMPARE(height, 320);
+}
+
+void TestFrameExtractor::testExactTimestamps()
+{
+    FrameExtractor::Config config;
+    config.target = FrameExtractor::OutputTarget::Buffer;
+    config.output_width = 160;
+    config.worker_count = 2;
+    std::vector<uint8_t> buffer(16 * 1024 * 1024);
+    FrameExtractor extractor(config);
+    extractor.setOutputBuffer(buffer.data(), buffer.size());
+
+    SamplingSpec spec;
+    spec.mode = SamplingSpec::Mode::Timestamps;
+    spec.timestamps_us = {500000, 5200000, 5300000, 7000000, 20000000, 76000000};
+    QVERIFY2(extractor.run({media_file_.toStdString()}, spec), extractor.getLastError().c_str());
+
+    const std::vector<ExtractedFrame>& results = extractor.results();
+    QCOMPARE(results.size(), spec.timestamps_us.size());
+    size_t expected_offset_end = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ExtractedFrame& frame = results[i];
+        QCOMPARE(frame.sample_index, i);
+        QCOMPARE(frame.width, 160);
+        QCOMPARE(frame.height, 90);
+        QCOMPARE(frame.buffer_bytes, static_cast<size_t>(160 * 90 * 3));
+        // 第一帧显示时间不早于目标（允许半帧取整误差），且不晚于一帧
+        QVERIFY2(frame.timestamp_us >= frame.requested_us - kFrameUs / 2 &&
+                 frame.timestamp_us < frame.requested_us + kFrameUs,
+                 qPrintable(QString("请求%1 实际%2").arg(frame.requested_us).arg(frame.timestamp_us)));
+        expected_offset_end = std::max(expected_offset_end, frame.buffer_offset + frame.buffer_bytes);
+    }
+    QVERIFY(expected_offset_end <= buffer.size());
+
+    // 5.2s和5.3s、7s在同一个GOP里接着解码，不重新seek
+    const FrameExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+    QCOMPARE(stats.frames_extracted, static_cast<uint64_t>(results.size()));
+    QCOMPARE(stats.frames_failed, static_cast<uint64_t>(0));
+    QVERIFY(stats.seeks <= 4);
+    qDebug() << "   " << results.size() << "帧，seek" << stats.seeks << "次，解码" << stats.frames_decoded << "帧";
+}
+
+void TestFrameExtractor::testKeyframesOnly()
+{
+    FrameExtractor::Config config;
+    config.target = FrameExtractor::OutputTarget::Buffer;
+    config.output_width = 160;
+    std::vector<uint8_t> buffer(8 * 1024 * 1024);
+    FrameExtractor extractor(config);
+    extractor.setOutputBuffer(buffer.data(), buffer.size());
+
+    // 0~20秒每秒一个时间点，只落在0/5/10/15秒四个关键帧上
+    SamplingSpec spec;
+    spec.interval_us = 1000000;
+    spec.end_us = 20000000;
+    spec.keyframes_only = true;
+    QVERIFY(extractor.run({media_file_.toStdString()}, spec));
+
+    const std::vector<ExtractedFrame>& results = extractor.results();
+    QCOMPARE(results.size(), static_cast<size_t>(4));
+    for (size_t i = 0; i < results.size(); ++i) {
+        QVERIFY(results[i].keyframe);
+        QVERIFY(std::llabs(results[i].timestamp_us - static_cast<int64_t>(i) * 5000000) < 200000);
+    }
+    const FrameExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+    QCOMPARE(stats.frames_decoded, static_cast<uint64_t>(4));
+}
+
+void TestFrameExtractor::testWritesImages()
+{
+    const QString directory = temp_dir_.filePath("images");
+    QVERIFY(QDir().mkpath(directory));
+
+    FrameExtractor::Config config;
+    config.output_directory = directory.toStdString();
+    config.output_width = 320;
+    config.worker_count = 2;
+    FrameExtractor extractor(config);
+
+    SamplingSpec spec;
+    spec.interval_us = 10000000;
+    spec.max_frames_per_file = 3;
+    const std::vector<std::string> files = {media_file_.toStdString(), media_file_.toStdString()};
+    QVERIFY(extractor.run(files, spec));
+
+    const std::vector<ExtractedFrame>& results = extractor.results();
+    QCOMPARE(results.size(), static_cast<size_t>(6));
+    QCOMPARE(results.front().file_index, static_cast<size_t>(0));
+    QCOMPARE(results.back().file_index, static_cast<size_t>(1));
+    for (const ExtractedFrame& frame : results) {
+        QFile file(QString::fromStdString(frame.path));
+        QVERIFY2(file.open(QIODevice::ReadOnly), frame.path.c_str());
+        const QByteArray head = file.read(2);
+        QCOMPARE(static_cast<uint8_t>(head[0]), static_cast<uint8_t>(0xFF));
+        QCOMPARE(static_cast<uint8_t>(head[1]), static_cast<uint8_t>(0xD8));
+    }
+    QVERIFY(extractor.getStatistics().bytes_written > 0);
+}
+
+void TestFrameExtractor::testBufferFull()
+{
+    FrameExtractor::Config config;
+    config.target = FrameExtractor::OutputTarget::Buffer;
+    config.output_width = 160;
+    config.worker_count = 1;
+    const size_t frame_bytes = 160 * 90 * 3;
+    std::vector<uint8_t> buffer(frame_bytes * 3);
+    FrameExtractor extractor(config);
+    extractor.setOutputBuffer(buffer.data(), buffer.size());
+
+    SamplingSpec spec;
+    spec.interval_us = 2000000;
+    spec.max_frames_per_file = 5;
+    QVERIFY(extractor.run({media_file_.toStdString()}, spec));
+
+    // 装满三帧，其余计为失败，不越界
+    QCOMPARE(extractor.results().size(), static_cast<size_t>(3));
+    QCOMPARE(extractor.getStatistics().frames_failed, static_cast<uint64_t>(2));
+
+    // 缓冲输出必须先设置缓冲
+    FrameExtractor no_buffer(config);
+    QVERIFY(!no_buffer.run({media_file_.toStdString()}, spec));
+    QVERIFY(!no_buffer.getLastError().empty());
+}
+
+void TestFrameExtractor::testSplitsLongFile()
+{
+    FrameExtractor::Config config;
+    config.target = FrameExtractor::OutputTarget::Buffer;
+    config.output_width = 64;
+    config.worker_count = 4;
+    config.samples_per_job = 4;
+    std::vector<uint8_t> buffer(16 * 1024 * 1024);
+    FrameExtractor extractor(config);
+    extractor.setOutputBuffer(buffer.data(), buffer.size());
+
+    // 一个文件约38个时间点，切成10个任务分给4个线程；再加一个打不开的文件
+    SamplingSpec spec;
+    spec.interval_us = 2000000;
+    const std::vector<std::string> files = {media_file_.toStdString(), "/nonexistent/missing.mp4"};
+    QVERIFY(extractor.run(files, spec));
+
+    const std::vector<ExtractedFrame>& results = extractor.results();
+    const std::vector<int64_t> planned = FrameExtractor::planSamples(spec, 76900000);
+    QVERIFY(results.size() + 1 >= planned.size() && results.size() <= planned.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        QCOMPARE(results[i].file_index, static_cast<size_t>(0));
+        QCOMPARE(results[i].sample_index, i);
+    }
+
+    const FrameExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+    QCOMPARE(stats.files_done, static_cast<uint64_t>(1));
+    QCOMPARE(stats.files_failed, static_cast<uint64_t>(1));
+    QVERIFY(stats.jobs >= (planned.size() + 3) / 4 + 1);
+    QCOMPARE(extractor.getErrors().size(), static_cast<size_t>(1));
+}
+
+void TestFrameExtractor::benchmarkFramesPerCore()
+{
+    const int cores = std::max(1, std::min(8, static_cast<int>(std::thread::hardware_concurrency())));
+    const std::vector<std::string> files(4, media_file_.toStdString());
+    std::vector<uint8_t> buffer(64 * 1024 * 1024);
+
+    qDebug() << "   模式      线程  帧数  耗时(ms)  帧/秒  每核帧/秒  解码帧";
+    for (bool keyframes_only : {false, true}) {
+        for (int workers : {1, cores}) {
+            FrameExtractor::Config config;
+            config.target = FrameExtractor::OutputTarget::Buffer;
+            config.output_width = 224;
+            config.worker_count = workers;
+            FrameExtractor extractor(config);
+            extractor.setOutputBuffer(buffer.data(), buffer.size());
+
+            SamplingSpec spec;
+            spec.interval_us = 2000000;
+            spec.keyframes_only = keyframes_only;
+            QVERIFY(extractor.run(files, spec));
+
+            const FrameExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+            const double fps = stats.elapsed_ms > 0.0 ? stats.frames_extracted * 1000.0 / stats.elapsed_ms : 0.0;
+            qDebug() << "  " << (keyframes_only ? "关键帧" : "精确  ") << workers << "  "
+                     << stats.frames_extracted << " " << static_cast<int>(stats.elapsed_ms) << "  "
+                     << static_cast<int>(fps) << "  " << static_cast<int>(fps / workers) << "  "
+                     << stats.frames_decoded;
+            QVERIFY(stats.frames_extracted > 0);
+            QCOMPARE(stats.frames_failed, static_cast<uint64_t>(0));
+        }
+    }
+}
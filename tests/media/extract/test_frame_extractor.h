@@ -0,0 +1,36 @@
+#ifndef TEST_FRAME_EXTRACTOR_H
+#define TEST_FRAME_EXTRACTOR_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "media/extract/frame_extractor.h"
+
+class TestFrameExtractor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 采样规划与输出尺寸
+    void testPlanSamples();
+    void testOutputSize();
+
+    // 真实文件抽帧
+    void testExactTimestamps();
+    void testKeyframesOnly();
+    void testWritesImages();
+    void testBufferFull();
+    void testSplitsLongFile();
+
+    // 基准：每核抽帧吞吐
+    void benchmarkFramesPerCore();
+
+private:
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_FRAME_EXTRACTOR_H
@@ -0,0 +1,557 @@
+#include "test_frame_bus.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+using namespace media;
+
+namespace {
+
+constexpr AVRational kTimeBase = {1, 90000};
+
+// 每个平面填同一个字节，内容由序号决定，消费者据此校验没有读到混合帧
+uint8_t patternByte(uint64_t seq, int plane) {
+    return static_cast<uint8_t>(seq * 7 + static_cast<uint64_t>(plane) * 85);
+}
+
+AVFrame* makeFrame(int width, int height, AVPixelFormat format, uint64_t seq) {
+    AVFrame* frame = av_frame_alloc();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    int line_bytes[4] = {0, 0, 0, 0};
+    av_image_fill_linesizes(line_bytes, format, width);
+    for (int plane = 0; plane < av_pix_fmt_count_planes(format); ++plane) {
+        const int rows = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height;
+        for (int y = 0; y < rows; ++y) {
+            memset(frame->data[plane] + static_cast<size_t>(y) * frame->linesize[plane],
+                   patternByte(seq, plane), static_cast<size_t>(line_bytes[plane]));
+        }
+    }
+    frame->pts = static_cast<int64_t>(seq) * 3000;
+    frame->best_effort_timestamp = frame->pts;
+    return frame;
+}
+
+bool viewMatches(const FrameBusConsumer::FrameView& view, uint64_t seq) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(view.format);
+    if (!desc) {
+        return false;
+    }
+    int line_bytes[4] = {0, 0, 0, 0};
+    av_image_fill_linesizes(line_bytes, view.format, view.width);
+    for (int plane = 0; plane < av_pix_fmt_count_planes(view.format); ++plane) {
+        if (!view.data[plane]) {
+            return false;
+        }
+        const int rows = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(view.height, desc->log2_chroma_h)
+                                                    : view.height;
+        const uint8_t expected = patternByte(seq, plane);
+        for (int y = 0; y < rows; ++y) {
+            const uint8_t* row = view.data[plane] + static_cast<size_t>(y) * view.linesize[plane];
+            for (int x = 0; x < line_bytes[plane]; ++x) {
+                if (row[x] != expected) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool publishPattern(FrameBusProducer& producer, int width, int height, uint64_t seq) {
+    AVFrame* frame = makeFrame(width, height, AV_PIX_FMT_YUV420P, seq);
+    const bool ok = frame && producer.publish(frame, kTimeBase);
+    av_frame_free(&frame);
+    return ok;
+}
+
+FrameBusProducer::Config smallBus(uint32_t slots) {
+    FrameBusProducer::Config config;
+    config.name = "test-frame-bus";
+    config.slot_count = slots;
+    config.max_width = 320;
+    config.max_height = 240;
+    return config;
+}
+
+/**
+ * @brief 子进程消费者的读取结果（通过管道传回）
+ */
+struct ChildReport {
+    uint64_t frames_read = 0;
+    uint64_t frames_missed = 0;
+    uint64_t frames_torn = 0;
+    uint64_t mismatched = 0;        // 通过finish却内容不符的帧（协议错误）
+    uint64_t out_of_order = 0;
+    int64_t latency_sum_ns = 0;
+    int64_t latency_max_ns = 0;
+    int64_t last_pts = AV_NOPTS_VALUE;
+};
+
+/**
+ * @brief fork一个消费者进程：打开总线后写一个就绪字节，读到last_pts或生产者关闭后写回报告
+ */
+pid_t spawnConsumer(const std::function<bool(FrameBusConsumer&)>& open, int64_t last_pts,
+                    bool verify, int* read_fd) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    const pid_t pid = fork();
+    if (pid != 0) {
+        close(fds[1]);
+        *read_fd = fds[0];
+        return pid;
+    }
+
+    close(fds[0]);
+    FrameBusConsumer consumer;
+    if (!open(consumer)) {
+        _exit(2);
+    }
+    const char ready = 'R';
+    if (write(fds[1], &ready, 1) != 1) {
+        _exit(3);
+    }
+
+    ChildReport report;
+    FrameBusConsumer::FrameView view;
+    uint64_t previous = 0;
+    bool first = true;
+    while (consumer.next(view, 3000)) {
+        const int64_t latency = FrameBusLayout::monotonicNs() - view.publish_time_ns;
+        const uint64_t seq = static_cast<uint64_t>(view.pts / 3000);
+        const bool content_ok = !verify || viewMatches(view, seq);
+        if (!consumer.finish(view)) {
+            continue;
+        }
+        if (!content_ok) {
+            report.mismatched++;
+        }
+        if (!first && view.sequence <= previous) {
+            report.out_of_order++;
+        }
+        first = false;
+        previous = view.sequence;
+        report.latency_sum_ns += latency;
+        report.latency_max_ns = std::max(report.latency_max_ns, latency);
+        report.last_pts = view.pts;
+        if (view.pts == last_pts) {
+            break;
+        }
+    }
+    const FrameBusConsumer::StatisticsSnapshot stats = consumer.getStatistics();
+    report.frames_read = stats.frames_read;
+    report.frames_missed = stats.frames_missed;
+    report.frames_torn = stats.frames_torn;
+    const ssize_t written = write(fds[1], &report, sizeof(report));
+    _exit(written == static_cast<ssize_t>(sizeof(report)) ? 0 : 4);
+}
+
+bool waitReady(int fd) {
+    char ready = 0;
+    return read(fd, &ready, 1) == 1 && ready == 'R';
+}
+
+bool collectReport(pid_t pid, int fd, ChildReport* report) {
+    size_t got = 0;
+    auto* out = reinterpret_cast<char*>(report);
+    while (got < sizeof(*report)) {
+        const ssize_t n = read(fd, out + got, sizeof(*report) - got);
+        if (n <= 0) {
+            break;
+        }
+        got += static_cast<size_t>(n);
+    }
+    close(fd);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == sizeof(*report) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+void TestFrameBus::initTestCase()
+{
+    qDebug() << "🚌 开始共享内存帧总线测试";
+}
+
+void TestFrameBus::testOpenAndLayout()
+{
+    FrameBusProducer::Config bad = smallBus(1);
+    FrameBusProducer rejected(bad);
+    QVERIFY(!rejected.open());
+    QVERIFY(!rejected.getLastError().empty());
+
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY2(producer.open(), producer.getLastError().c_str());
+    QVERIFY(producer.fd() >= 0);
+    QVERIFY(producer.path().find("/proc/") == 0);
+
+    // 槽按页对齐，至少容纳一帧最大尺寸的YUV420P
+    QVERIFY(producer.slotBytes() >= static_cast<size_t>(320 * 240 * 3 / 2));
+    QCOMPARE(producer.slotBytes() % FrameBusLayout::kPageSize, static_cast<size_t>(0));
+    QCOMPARE(producer.totalBytes(), FrameBusLayout::totalBytes(4, producer.slotBytes()));
+
+    FrameBusConsumer consumer;
+    QVERIFY2(consumer.openFd(producer.fd()), consumer.getLastError().c_str());
+    QCOMPARE(consumer.slotCount(), static_cast<uint32_t>(4));
+    QVERIFY(!consumer.producerClosed());
+
+    FrameBusConsumer::FrameView view;
+    QVERIFY(!consumer.next(view, 0));
+
+    producer.close();
+    QVERIFY(consumer.producerClosed());
+    QVERIFY(!consumer.next(view, 100));
+}
+
+void TestFrameBus::testMetadataRoundtrip()
+{
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY(producer.open());
+    FrameBusConsumer consumer;
+    QVERIFY(consumer.openFd(producer.fd()));
+
+    AVFrame* frame = makeFrame(318, 238, AV_PIX_FMT_YUV420P, 5);
+    QVERIFY(frame);
+#ifdef AV_FRAME_FLAG_KEY
+    frame->flags |= AV_FRAME_FLAG_KEY;
+#else
+    frame->key_frame = 1;
+#endif
+    QVERIFY2(producer.publish(frame, kTimeBase), producer.getLastError().c_str());
+    av_frame_free(&frame);
+
+    // 格式和尺寸每帧可以不同
+    AVFrame* gray = makeFrame(200, 100, AV_PIX_FMT_GRAY8, 6);
+    QVERIFY(gray);
+    QVERIFY(producer.publish(gray, AVRational{1, 1000}));
+    av_frame_free(&gray);
+
+    FrameBusConsumer::FrameView view;
+    QVERIFY(consumer.next(view, 0));
+    QCOMPARE(view.sequence, static_cast<uint64_t>(0));
+    QCOMPARE(view.pts, static_cast<int64_t>(15000));
+    QCOMPARE(view.time_base.num, 1);
+    QCOMPARE(view.time_base.den, 90000);
+    QVERIFY(view.format == AV_PIX_FMT_YUV420P);
+    QCOMPARE(view.width, 318);
+    QCOMPARE(view.height, 238);
+    QVERIFY(view.keyframe);
+    QVERIFY(view.publish_time_ns > 0);
+    for (int plane = 0; plane < 3; ++plane) {
+        QCOMPARE(view.linesize[plane] % FrameBusLayout::kPlaneAlign, 0);
+        QCOMPARE(reinterpret_cast<uintptr_t>(view.data[plane]) % FrameBusLayout::kPlaneAlign,
+                 static_cast<uintptr_t>(0));
+    }
+    QVERIFY(viewMatches(view, 5));
+    QVERIFY(consumer.finish(view));
+
+    QVERIFY(consumer.next(view, 0));
+    QCOMPARE(view.sequence, static_cast<uint64_t>(1));
+    QVERIFY(view.format == AV_PIX_FMT_GRAY8);
+    QCOMPARE(view.width, 200);
+    QCOMPARE(view.time_base.den, 1000);
+    QVERIFY(!view.keyframe);
+    QVERIFY(viewMatches(view, 6));
+
+    // 零拷贝包装成AVFrame
+    AVFrame* wrapped = av_frame_alloc();
+    FrameBusConsumer::fillFrame(view, wrapped);
+    QCOMPARE(wrapped->width, 200);
+    QVERIFY(wrapped->data[0] == view.data[0]);
+    QVERIFY(wrapped->buf[0] == nullptr);
+    av_frame_free(&wrapped);
+
+    QVERIFY(consumer.finish(view));
+    QVERIFY(!consumer.next(view, 0));
+
+    const FrameBusProducer::StatisticsSnapshot stats = producer.getStatistics();
+    QCOMPARE(stats.frames_published, static_cast<uint64_t>(2));
+    QCOMPARE(consumer.getStatistics().frames_read, static_cast<uint64_t>(2));
+}
+
+void TestFrameBus::testBeginCommitInPlace()
+{
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY(producer.open());
+    FrameBusConsumer consumer;
+    QVERIFY(consumer.openFd(producer.fd()));
+
+    AVFrame* slot = av_frame_alloc();
+    QVERIFY(producer.beginFrame(160, 120, AV_PIX_FMT_YUV420P, slot));
+    // 写入完成前不能再发布
+    QVERIFY(!publishPattern(producer, 160, 120, 1));
+    FrameBusConsumer::FrameView view;
+    QVERIFY(!consumer.next(view, 0));
+
+    for (int plane = 0; plane < 3; ++plane) {
+        const int rows = plane == 0 ? 120 : 60;
+        const int bytes = plane == 0 ? 160 : 80;
+        for (int y = 0; y < rows; ++y) {
+            memset(slot->data[plane] + static_cast<size_t>(y) * slot->linesize[plane], patternByte(9, plane),
+                   static_cast<size_t>(bytes));
+        }
+    }
+    producer.commitFrame(27000, kTimeBase, true);
+    av_frame_free(&slot);
+
+    QVERIFY(consumer.next(view, 0));
+    QCOMPARE(view.pts, static_cast<int64_t>(27000));
+    QCOMPARE(view.width, 160);
+    QVERIFY(view.keyframe);
+    QVERIFY(viewMatches(view, 9));
+    QVERIFY(consumer.finish(view));
+}
+
+void TestFrameBus::testRejectsOversizedFrame()
+{
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY(producer.open());
+
+    AVFrame* frame = makeFrame(640, 480, AV_PIX_FMT_YUV420P, 0);
+    QVERIFY(frame);
+    QVERIFY(!producer.publish(frame, kTimeBase));
+    av_frame_free(&frame);
+    QVERIFY(!producer.publish(nullptr, kTimeBase));
+
+    const FrameBusProducer::StatisticsSnapshot stats = producer.getStatistics();
+    QCOMPARE(stats.frames_rejected, static_cast<uint64_t>(2));
+    QCOMPARE(stats.frames_published, static_cast<uint64_t>(0));
+    QCOMPARE(producer.nextSequence(), static_cast<uint64_t>(0));
+
+    // 拒绝之后仍能正常发布
+    QVERIFY(publishPattern(producer, 320, 240, 1));
+}
+
+void TestFrameBus::testOverrunSkipsToOldest()
+{
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY(producer.open());
+    FrameBusConsumer consumer;
+    QVERIFY(consumer.openFd(producer.fd()));
+
+    // 生产者从不等待：消费者落后两圈多
+    for (uint64_t seq = 0; seq < 10; ++seq) {
+        QVERIFY(publishPattern(producer, 320, 240, seq));
+    }
+
+    // 最旧的安全帧是10-4+1=7（第6帧所在的槽是下一次写入的位置）
+    FrameBusConsumer::FrameView view;
+    for (uint64_t expected = 7; expected < 10; ++expected) {
+        QVERIFY(consumer.next(view, 0));
+        QCOMPARE(view.sequence, expected);
+        QVERIFY(viewMatches(view, expected));
+        QVERIFY(consumer.finish(view));
+    }
+    QVERIFY(!consumer.next(view, 0));
+
+    const FrameBusConsumer::StatisticsSnapshot stats = consumer.getStatistics();
+    QCOMPARE(stats.frames_read, static_cast<uint64_t>(3));
+    QCOMPARE(stats.frames_missed, static_cast<uint64_t>(7));
+    QCOMPARE(stats.frames_torn, static_cast<uint64_t>(0));
+}
+
+void TestFrameBus::testTornReadDetected()
+{
+    FrameBusProducer producer(smallBus(4));
+    QVERIFY(producer.open());
+    FrameBusConsumer consumer;
+    QVERIFY(consumer.openFd(producer.fd()));
+
+    QVERIFY(publishPattern(producer, 320, 240, 0));
+    FrameBusConsumer::FrameView view;
+    QVERIFY(consumer.next(view, 0));
+    QVERIFY(viewMatches(view, 0));
+
+    // 消费者还在处理时生产者绕回同一个槽
+    for (uint64_t seq = 1; seq <= 4; ++seq) {
+        QVERIFY(publishPattern(producer, 320, 240, seq));
+    }
+    QVERIFY(!viewMatches(view, 0));
+    QVERIFY(!consumer.finish(view));
+    QCOMPARE(consumer.getStatistics().frames_torn, static_cast<uint64_t>(1));
+
+    // 之后继续读到仍然有效的帧
+    QVERIFY(consumer.next(view, 0));
+    QCOMPARE(view.sequence, static_cast<uint64_t>(2));
+    QVERIFY(consumer.finish(view));
+}
+
+void TestFrameBus::testLatestOnly()
+{
+    FrameBusProducer producer(smallBus(8));
+    QVERIFY(producer.open());
+    FrameBusConsumer::Config config;
+    config.latest_only = true;
+    FrameBusConsumer consumer(config);
+    QVERIFY(consumer.openFd(producer.fd()));
+
+    for (uint64_t seq = 0; seq < 5; ++seq) {
+        QVERIFY(publishPattern(producer, 320, 240, seq));
+    }
+    FrameBusConsumer::FrameView view;
+    QVERIFY(consumer.next(view, 0));
+    QCOMPARE(view.sequence, static_cast<uint64_t>(4));
+    QVERIFY(viewMatches(view, 4));
+    QCOMPARE(consumer.getStatistics().frames_missed, static_cast<uint64_t>(4));
+    QVERIFY(!consumer.next(view, 0));
+
+    // 顺序消费者也可以先跳到最新
+    FrameBusConsumer sequential;
+    QVERIFY(sequential.openFd(producer.fd()));
+    sequential.seekToLatest();
+    QVERIFY(sequential.next(view, 0));
+    QCOMPARE(view.sequence, static_cast<uint64_t>(4));
+}
+
+void TestFrameBus::testCrossProcessPosixShm()
+{
+    const std::string name = "/media_framebus_test_" + std::to_string(getpid());
+    FrameBusProducer::Config config = smallBus(16);
+    config.name = name;
+    FrameBusProducer producer(config);
+    QVERIFY2(producer.open(), producer.getLastError().c_str());
+    QVERIFY(producer.path() == name);
+
+    constexpr uint64_t kFrames = 120;
+    int fd = -1;
+    const pid_t pid = spawnConsumer([&name](FrameBusConsumer& consumer) { return consumer.open(name); },
+                                    static_cast<int64_t>(kFrames - 1) * 3000, true, &fd);
+    QVERIFY(pid > 0);
+    QVERIFY(waitReady(fd));
+
+    // 略慢于消费者的节奏，所有帧都应被读到
+    for (uint64_t seq = 0; seq < kFrames; ++seq) {
+        QVERIFY(publishPattern(producer, 320, 240, seq));
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    ChildReport report;
+    QVERIFY(collectReport(pid, fd, &report));
+    QCOMPARE(report.mismatched, static_cast<uint64_t>(0));
+    QCOMPARE(report.out_of_order, static_cast<uint64_t>(0));
+    QCOMPARE(report.last_pts, static_cast<int64_t>(kFrames - 1) * 3000);
+    QVERIFY(report.frames_read + report.frames_missed + report.frames_torn >= kFrames);
+    qDebug() << "   POSIX shm: 读取" << report.frames_read << "丢帧" << report.frames_missed
+             << "撕裂" << report.frames_torn;
+
+    producer.close();
+    FrameBusConsumer after;
+    QVERIFY(!after.open(name));    // 关闭时已删除名称
+}
+
+void TestFrameBus::testCrossProcessMemfdPath()
+{
+    FrameBusProducer producer(smallBus(16));
+    QVERIFY(producer.open());
+    const std::string path = producer.path();
+
+    constexpr uint64_t kFrames = 60;
+    int fd = -1;
+    // 不依赖继承的描述符：按/proc路径打开，与无亲缘关系的进程相同
+    const pid_t pid = spawnConsumer([&path](FrameBusConsumer& consumer) { return consumer.open(path); },
+                                    static_cast<int64_t>(kFrames - 1) * 3000, true, &fd);
+    QVERIFY(pid > 0);
+    QVERIFY(waitReady(fd));
+
+    for (uint64_t seq = 0; seq < kFrames; ++seq) {
+        QVERIFY(publishPattern(producer, 320, 240, seq));
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    ChildReport report;
+    QVERIFY(collectReport(pid, fd, &report));
+    QCOMPARE(report.mismatched, static_cast<uint64_t>(0));
+    QCOMPARE(report.last_pts, static_cast<int64_t>(kFrames - 1) * 3000);
+}
+
+void TestFrameBus::benchmarkFrameBusThroughput()
+{
+    constexpr int kWidth = 1920;
+    constexpr int kHeight = 1080;
+    constexpr uint64_t kFrames = 600;
+
+    std::vector<AVFrame*> frames;
+    for (uint64_t seq = 0; seq < 4; ++seq) {
+        frames.push_back(makeFrame(kWidth, kHeight, AV_PIX_FMT_YUV420P, seq));
+        QVERIFY(frames.back());
+    }
+
+    qDebug() << "   节奏      发布帧/秒  GB/s   读取  丢帧  撕裂  平均延迟(us)  最大延迟(us)";
+    for (int pace_fps : {0, 240}) {
+        FrameBusProducer::Config config;
+        config.name = "bench-frame-bus";
+        config.slot_count = 8;
+        config.max_width = kWidth;
+        config.max_height = kHeight;
+        FrameBusProducer producer(config);
+        QVERIFY(producer.open());
+
+        const int producer_fd = producer.fd();
+        const uint64_t frame_count = pace_fps > 0 ? kFrames / 5 : kFrames;
+        int fd = -1;
+        // 子进程继承memfd描述符，只读映射
+        const pid_t pid = spawnConsumer([producer_fd](FrameBusConsumer& consumer) {
+                                            return consumer.openFd(producer_fd);
+                                        },
+                                        static_cast<int64_t>(frame_count - 1) * 3000, false, &fd);
+        QVERIFY(pid > 0);
+        QVERIFY(waitReady(fd));
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t seq = 0; seq < frame_count; ++seq) {
+            AVFrame* frame = frames[seq % frames.size()];
+            frame->pts = static_cast<int64_t>(seq) * 3000;
+            frame->best_effort_timestamp = frame->pts;
+            QVERIFY(producer.publish(frame, kTimeBase));
+            if (pace_fps > 0) {
+                std::this_thread::sleep_until(start + std::chrono::microseconds((seq + 1) * 1000000 / pace_fps));
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        producer.close();     // 消费者没读到最后一帧时也能结束
+
+        ChildReport report;
+        QVERIFY(collectReport(pid, fd, &report));
+        QCOMPARE(report.mismatched, static_cast<uint64_t>(0));
+
+        const FrameBusProducer::StatisticsSnapshot stats = producer.getStatistics();
+        const double fps = seconds > 0.0 ? stats.frames_published / seconds : 0.0;
+        const double gbps = seconds > 0.0 ? stats.bytes_published / seconds / 1e9 : 0.0;
+        const double avg_latency_us = report.frames_read > 0
+                                          ? report.latency_sum_ns / 1000.0 / report.frames_read : 0.0;
+        qDebug() << "  " << (pace_fps > 0 ? "240fps " : "满速   ") << static_cast<int>(fps) << "    "
+                 << QString::number(gbps, 'f', 2) << " " << report.frames_read << " "
+                 << report.frames_missed << " " << report.frames_torn << " "
+                 << static_cast<int>(avg_latency_us) << "        "
+                 << static_cast<int>(report.latency_max_ns / 1000);
+        QCOMPARE(stats.frames_published, frame_count);
+        QVERIFY(report.frames_read > 0);
+    }
+
+    for (AVFrame* frame : frames) {
+        av_frame_free(&frame);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef TEST_FRAME_BUS_H
+#define TEST_FRAME_BUS_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/framebus/frame_bus.h"
+
+class TestFrameBus : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 布局与元数据
+    void testOpenAndLayout();
+    void testMetadataRoundtrip();
+    void testBeginCommitInPlace();
+    void testRejectsOversizedFrame();
+
+    // 无锁协议：落后、撕裂、只取最新
+    void testOverrunSkipsToOldest();
+    void testTornReadDetected();
+    void testLatestOnly();
+
+    // 跨进程
+    void testCrossProcessPosixShm();
+    void testCrossProcessMemfdPath();
+
+    // 基准：跨进程吞吐与延迟
+    void benchmarkFrameBusThroughput();
+};
+
+#endif // TEST_FRAME_BUS_H
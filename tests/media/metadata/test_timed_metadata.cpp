@@ -0,0 +1,1032 @@
+#include "test_timed_metadata.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "media/media_pipeline.h"
+#include "media/demux/ffmpeg_demuxer.h"
+#include "media/input/input_source.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+using namespace media;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+/**
+ * @brief 按比特写码流（构造SPS/SEI用）
+ */
+class BitWriter {
+public:
+    void bits(uint32_t value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            bit((value >> i) & 1);
+        }
+    }
+
+    void bit(uint32_t value) {
+        if (used_ == 0) {
+            bytes_.push_back(0);
+        }
+        if (value) {
+            bytes_.back() |= static_cast<uint8_t>(0x80 >> used_);
+        }
+        used_ = (used_ + 1) & 7;
+    }
+
+    void ue(uint32_t value) {
+        const uint32_t coded = value + 1;
+        int length = 0;
+        while ((coded >> length) > 1) {
+            ++length;
+        }
+        bits(0, length);
+        bits(coded, length + 1);
+    }
+
+    // SEI负载末尾按0补齐到字节
+    void alignZero() {
+        while (used_ != 0) {
+            bit(0);
+        }
+    }
+
+    // rbsp_trailing_bits
+    void trailing() {
+        bit(1);
+        alignZero();
+    }
+
+    const Bytes& bytes() const { return bytes_; }
+
+private:
+    Bytes bytes_;
+    int used_ = 0;
+};
+
+// RBSP加防竞争字节
+Bytes escape(const Bytes& rbsp)
+{
+    Bytes out;
+    int zeros = 0;
+    for (uint8_t byte : rbsp) {
+        if (zeros >= 2 && byte <= 3) {
+            out.push_back(3);
+            zeros = 0;
+        }
+        out.push_back(byte);
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    return out;
+}
+
+Bytes nal(const Bytes& header, const Bytes& rbsp)
+{
+    Bytes out = header;
+    const Bytes escaped = escape(rbsp);
+    out.insert(out.end(), escaped.begin(), escaped.end());
+    return out;
+}
+
+// 一条SEI消息的RBSP（含rbsp_trailing_bits）
+Bytes seiRbsp(int payload_type, const Bytes& payload)
+{
+    Bytes rbsp;
+    int type = payload_type;
+    while (type >= 255) {
+        rbsp.push_back(0xFF);
+        type -= 255;
+    }
+    rbsp.push_back(static_cast<uint8_t>(type));
+    size_t size = payload.size();
+    while (size >= 255) {
+        rbsp.push_back(0xFF);
+        size -= 255;
+    }
+    rbsp.push_back(static_cast<uint8_t>(size));
+    rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+    rbsp.push_back(0x80);
+    return rbsp;
+}
+
+void appendAnnexB(Bytes& stream, const Bytes& unit)
+{
+    static const uint8_t kStartCode[4] = {0, 0, 0, 1};
+    stream.insert(stream.end(), kStartCode, kStartCode + 4);
+    stream.insert(stream.end(), unit.begin(), unit.end());
+}
+
+void appendLengthPrefixed(Bytes& stream, const Bytes& unit)
+{
+    const uint32_t size = static_cast<uint32_t>(unit.size());
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        stream.push_back(static_cast<uint8_t>(size >> shift));
+    }
+    stream.insert(stream.end(), unit.begin(), unit.end());
+}
+
+/**
+ * @brief High profile 1080p SPS：VUI带NAL HRD（延时字段各24位，time_offset_length 24）和pic_struct
+ */
+Bytes h264Sps()
+{
+    BitWriter w;
+    w.bits(100, 8);         // profile_idc
+    w.bits(0, 8);
+    w.bits(40, 8);          // level_idc
+    w.ue(0);                // sps_id
+    w.ue(1);                // chroma_format_idc
+    w.ue(0);
+    w.ue(0);
+    w.bit(0);
+    w.bit(0);               // seq_scaling_matrix_present_flag
+    w.ue(0);                // log2_max_frame_num_minus4
+    w.ue(0);                // poc_type
+    w.ue(2);
+    w.ue(1);                // max_num_ref_frames
+    w.bit(0);
+    w.ue(119);
+    w.ue(67);
+    w.bit(1);               // frame_mbs_only_flag
+    w.bit(1);
+    w.bit(1);               // frame_cropping_flag
+    w.ue(0);
+    w.ue(0);
+    w.ue(0);
+    w.ue(4);
+    w.bit(1);               // vui_parameters_present_flag
+    w.bit(1);               // aspect_ratio_info_present_flag
+    w.bits(1, 8);
+    w.bit(0);
+    w.bit(0);
+    w.bit(0);
+    w.bit(1);               // timing_info_present_flag
+    w.bits(1001, 32);
+    w.bits(60000, 32);
+    w.bit(1);
+    w.bit(1);               // nal_hrd_parameters_present_flag
+    w.ue(0);                // cpb_cnt_minus1
+    w.bits(4, 4);
+    w.bits(6, 4);
+    w.ue(12345);
+    w.ue(23456);
+    w.bit(0);
+    w.bits(23, 5);
+    w.bits(23, 5);          // cpb_removal_delay_length_minus1
+    w.bits(23, 5);          // dpb_output_delay_length_minus1
+    w.bits(24, 5);          // time_offset_length
+    w.bit(0);               // vcl_hrd_parameters_present_flag
+    w.bit(0);               // low_delay_hrd_flag
+    w.bit(1);               // pic_struct_present_flag
+    w.bit(0);               // bitstream_restriction_flag
+    w.trailing();
+    return nal({0x67}, w.bytes());
+}
+
+/**
+ * @brief pic_timing：full为false时只带秒
+ */
+Bytes h264PicTiming(const Timecode& tc, bool full)
+{
+    BitWriter w;
+    w.bits(0xABCDEF, 24);   // cpb_removal_delay
+    w.bits(0x000102, 24);   // dpb_output_delay
+    w.bits(0, 4);           // pic_struct：帧
+    w.bit(1);               // clock_timestamp_flag
+    w.bits(0, 2);
+    w.bit(0);
+    w.bits(4, 5);           // counting_type
+    w.bit(full);
+    w.bit(0);
+    w.bit(tc.drop_frame);
+    w.bits(static_cast<uint32_t>(tc.frames), 8);
+    if (full) {
+        w.bits(static_cast<uint32_t>(tc.seconds), 6);
+        w.bits(static_cast<uint32_t>(tc.minutes), 6);
+        w.bits(static_cast<uint32_t>(tc.hours), 5);
+    } else {
+        w.bit(1);           // seconds_flag
+        w.bits(static_cast<uint32_t>(tc.seconds), 6);
+        w.bit(0);           // minutes_flag
+    }
+    w.bits(0, 24);          // time_offset
+    w.alignZero();
+    return nal({0x06}, seiRbsp(SeiParser::kH264PicTiming, w.bytes()));
+}
+
+Bytes hevcTimeCode(const Timecode& tc)
+{
+    BitWriter w;
+    w.bits(1, 2);           // num_clock_ts
+    w.bit(1);
+    w.bit(0);
+    w.bits(0, 5);
+    w.bit(1);               // full_timestamp_flag
+    w.bit(0);
+    w.bit(tc.drop_frame);
+    w.bits(static_cast<uint32_t>(tc.frames), 9);
+    w.bits(static_cast<uint32_t>(tc.seconds), 6);
+    w.bits(static_cast<uint32_t>(tc.minutes), 6);
+    w.bits(static_cast<uint32_t>(tc.hours), 5);
+    w.bits(0, 5);           // time_offset_length
+    w.alignZero();
+    return nal({0x4E, 0x01}, seiRbsp(SeiParser::kHevcTimeCode, w.bytes()));
+}
+
+// 假的IDR片：随机字节加防竞争，不会出现起始码
+Bytes fakeSlice(std::mt19937& rng, size_t size, uint8_t header)
+{
+    Bytes rbsp(size);
+    for (uint8_t& byte : rbsp) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    rbsp.back() = 0x80;
+    return nal({header}, rbsp);
+}
+
+Timecode makeTimecode(int h, int m, int s, int f, bool drop)
+{
+    Timecode tc;
+    tc.hours = h;
+    tc.minutes = m;
+    tc.seconds = s;
+    tc.frames = f;
+    tc.drop_frame = drop;
+    return tc;
+}
+
+StreamInfo streamInfo(int index, AVMediaType type, AVCodecID codec, AVRational time_base)
+{
+    StreamInfo info;
+    info.index = index;
+    info.type = type;
+    info.codec_id = codec;
+    info.time_base = time_base;
+    return info;
+}
+
+// 不持有引用的包，数据指向调用方内存
+AVPacket makePacket(int stream_index, const Bytes& data, int64_t pts, int64_t duration = 0)
+{
+    AVPacket packet;
+    std::memset(&packet, 0, sizeof(packet));
+    packet.stream_index = stream_index;
+    packet.data = const_cast<uint8_t*>(data.data());
+    packet.size = static_cast<int>(data.size());
+    packet.pts = pts;
+    packet.dts = pts;
+    packet.duration = duration;
+    return packet;
+}
+
+std::vector<TimedMetadata> collect(const TimedMetadataTrack& track, int64_t from_us, int64_t to_us,
+                                   std::vector<std::string>* payloads = nullptr)
+{
+    std::vector<TimedMetadata> entries;
+    track.visit(from_us, to_us, [&](const TimedMetadata& entry) {
+        entries.push_back(entry);
+        if (payloads) {
+            payloads->push_back(entry.text());
+        }
+    });
+    return entries;
+}
+
+TimedMetadata textEntry(TimedMetadata::Kind kind, int64_t pts_us, int64_t duration_us, const std::string& text)
+{
+    TimedMetadata entry;
+    entry.kind = kind;
+    entry.stream_index = 2;
+    entry.pts_us = pts_us;
+    entry.duration_us = duration_us;
+    entry.data = reinterpret_cast<const uint8_t*>(text.data());
+    entry.size = text.size();
+    return entry;
+}
+
+} // namespace
+
+void TestTimedMetadata::initTestCase()
+{
+    qDebug() << "🏷️ 开始定时元数据测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    QVERIFY(temp_dir_.isValid());
+}
+
+// ==================== 轨道 ====================
+
+void TestTimedMetadata::testTimecodeToString()
+{
+    QCOMPARE(QString::fromStdString(makeTimecode(1, 2, 3, 4, false).toString()), QStringLiteral("01:02:03:04"));
+    QCOMPARE(QString::fromStdString(makeTimecode(23, 59, 59, 29, true).toString()), QStringLiteral("23:59:59;29"));
+}
+
+void TestTimedMetadata::testTrackOrdersAndQueries()
+{
+    TimedMetadataTrack track;
+
+    // SEI按解码顺序到达：I P B B的显示时间戳乱序
+    const int64_t frame_us = 40000;
+    const int64_t order[] = {0, 3, 1, 2, 6, 4, 5};
+    for (int64_t index : order) {
+        TimedMetadata entry;
+        entry.kind = TimedMetadata::Kind::Timecode;
+        entry.pts_us = index * frame_us;
+        entry.timecode = makeTimecode(0, 0, 0, static_cast<int>(index), false);
+        QVERIFY(track.add(entry));
+    }
+    // 持续1秒的字幕从第2帧开始
+    const std::string text = "subtitle";
+    QVERIFY(track.add(textEntry(TimedMetadata::Kind::Subtitle, 2 * frame_us, 1000000, text)));
+    QCOMPARE(track.size(), size_t(8));
+
+    // 全部按时间排序
+    const std::vector<TimedMetadata> all = collect(track, 0, 10 * frame_us);
+    QCOMPARE(all.size(), size_t(8));
+    for (size_t i = 1; i < all.size(); ++i) {
+        QVERIFY(all[i - 1].pts_us <= all[i].pts_us);
+    }
+
+    // 第5帧：自己的时间码和还在显示的字幕
+    std::vector<std::string> payloads;
+    std::vector<TimedMetadata> frame = [&]() {
+        std::vector<TimedMetadata> entries;
+        track.visitFrame(5 * frame_us, frame_us, [&](const TimedMetadata& entry) {
+            entries.push_back(entry);
+            payloads.push_back(entry.text());
+        });
+        return entries;
+    }();
+    QCOMPARE(frame.size(), size_t(2));
+    QVERIFY(frame[0].kind == TimedMetadata::Kind::Subtitle);
+    QCOMPARE(payloads[0], text);
+    QVERIFY(frame[1].kind == TimedMetadata::Kind::Timecode);
+    QCOMPARE(frame[1].timecode.frames, 5);
+
+    // 字幕结束之后没有条目
+    QCOMPARE(collect(track, 2 * frame_us + 1000000, 2 * frame_us + 1000000 + frame_us).size(), size_t(0));
+
+    Timecode latest;
+    int64_t latest_pts = 0;
+    QVERIFY(track.latestTimecode(4 * frame_us + 100, &latest, &latest_pts));
+    QCOMPARE(latest.frames, 4);
+    QCOMPARE(latest_pts, 4 * frame_us);
+    QVERIFY(!track.latestTimecode(-1, &latest));
+
+    track.clear();
+    QCOMPARE(track.size(), size_t(0));
+    QCOMPARE(collect(track, 0, 10 * frame_us).size(), size_t(0));
+}
+
+void TestTimedMetadata::testTrackEvictsOldest()
+{
+    // 条目数上限
+    {
+        TimedMetadataTrack::Config config;
+        config.max_entries = 16;
+        TimedMetadataTrack track(config);
+        for (int i = 0; i < 40; ++i) {
+            QVERIFY(track.add(textEntry(TimedMetadata::Kind::Data, i * 1000, 0, "x")));
+        }
+        QCOMPARE(track.size(), size_t(16));
+        const std::vector<TimedMetadata> entries = collect(track, 0, 100000);
+        QCOMPARE(entries.size(), size_t(16));
+        QCOMPARE(entries.front().pts_us, int64_t(24000));
+        QCOMPARE(track.getStatistics().entries_evicted, uint64_t(24));
+    }
+
+    // 负载字节区绕回：最旧的负载被覆盖后条目一并淘汰，剩下的负载完整
+    {
+        TimedMetadataTrack::Config config;
+        config.max_entries = 1024;
+        config.max_payload_bytes = 1000;
+        TimedMetadataTrack track(config);
+        for (int i = 0; i < 100; ++i) {
+            const std::string text = "payload-" + std::to_string(i) + std::string(static_cast<size_t>(i % 50), '#');
+            QVERIFY(track.add(textEntry(TimedMetadata::Kind::Klv, i * 1000, 0, text)));
+        }
+        std::vector<std::string> payloads;
+        const std::vector<TimedMetadata> entries = collect(track, 0, 1000000, &payloads);
+        QVERIFY(!entries.empty());
+        QVERIFY(entries.size() < 100);
+        QCOMPARE(entries.back().pts_us, int64_t(99000));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const int index = static_cast<int>(entries[i].pts_us / 1000);
+            const std::string expected = "payload-" + std::to_string(index) +
+                                         std::string(static_cast<size_t>(index % 50), '#');
+            QCOMPARE(payloads[i], expected);
+        }
+
+        // 超过字节区1/4的负载被拒绝
+        const std::string huge(300, 'h');
+        QVERIFY(!track.add(textEntry(TimedMetadata::Kind::Data, 0, 0, huge)));
+        QCOMPARE(track.getStatistics().entries_rejected, uint64_t(1));
+    }
+}
+
+void TestTimedMetadata::testTrackItemSwitch()
+{
+    TimedMetadataTrack track;
+    const int64_t frame_us = 40000;
+
+    // 当前条目的尾部
+    for (int i = 0; i < 5; ++i) {
+        TimedMetadata entry;
+        entry.kind = TimedMetadata::Kind::Timecode;
+        entry.pts_us = (100 + i) * frame_us;
+        entry.timecode = makeTimecode(1, 0, 4, i, false);
+        QVERIFY(track.add(entry));
+    }
+
+    // 解封装切到下一条目：时间戳从0重新开始，与上一条目的尾部交错写入
+    const uint64_t next = track.beginItem();
+    QVERIFY(next != 0);
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(track.add(textEntry(TimedMetadata::Kind::Subtitle, i * frame_us, frame_us,
+                                    "next-" + std::to_string(i))));
+    }
+    QVERIFY(track.add(textEntry(TimedMetadata::Kind::Data, 200 * frame_us, 0, "next-late")));
+    QCOMPARE(track.size(), size_t(11));
+
+    // 视频还没切换：上一条目最后几帧仍能查到自己的元数据，看不到新条目的
+    Timecode timecode;
+    QVERIFY(track.latestTimecode(104 * frame_us, &timecode));
+    QCOMPARE(timecode.frames, 4);
+    QCOMPARE(collect(track, 100 * frame_us, 105 * frame_us).size(), size_t(5));
+    QVERIFY(collect(track, 0, 5 * frame_us).empty());
+    QVERIFY(collect(track, 200 * frame_us, 201 * frame_us).empty());
+
+    // 视频切换后只看新条目，上一条目被丢弃
+    track.activateItem(next);
+    QCOMPARE(track.size(), size_t(6));
+    QVERIFY(!track.latestTimecode(104 * frame_us, &timecode));
+    QVERIFY(collect(track, 100 * frame_us, 105 * frame_us).empty());
+    std::vector<std::string> payloads;
+    const std::vector<TimedMetadata> entries = collect(track, 0, 5 * frame_us, &payloads);
+    QCOMPARE(entries.size(), size_t(5));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        QCOMPARE(entries[i].pts_us, static_cast<int64_t>(i) * frame_us);
+        QCOMPARE(payloads[i], "next-" + std::to_string(i));
+    }
+    QCOMPARE(collect(track, 200 * frame_us, 201 * frame_us).size(), size_t(1));
+}
+
+// ==================== SEI解析 ====================
+
+void TestTimedMetadata::testH264PicTimingAnnexB()
+{
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 90000}), nullptr, 0));
+
+    // 第一个包带带内SPS（TS流常见），第二个包只有秒，分和时沿用上一个
+    std::mt19937 rng(7);
+    Bytes first;
+    appendAnnexB(first, h264Sps());
+    appendAnnexB(first, h264PicTiming(makeTimecode(1, 2, 3, 4, true), true));
+    appendAnnexB(first, fakeSlice(rng, 4000, 0x65));
+    Bytes second;
+    appendAnnexB(second, h264PicTiming(makeTimecode(0, 0, 4, 5, true), false));
+    appendAnnexB(second, fakeSlice(rng, 2000, 0x41));
+
+    AVPacket packet = makePacket(0, first, 90000);
+    QVERIFY(extractor.processPacket(&packet));
+    packet = makePacket(0, second, 93600);
+    QVERIFY(extractor.processPacket(&packet));
+
+    const std::vector<TimedMetadata> entries = collect(*track, 0, 2000000);
+    QCOMPARE(entries.size(), size_t(2));
+    QVERIFY(entries[0].kind == TimedMetadata::Kind::Timecode);
+    QCOMPARE(entries[0].pts_us, int64_t(1000000));
+    QCOMPARE(entries[0].stream_index, 0);
+    QCOMPARE(QString::fromStdString(entries[0].timecode.toString()), QStringLiteral("01:02:03;04"));
+    QCOMPARE(entries[1].pts_us, int64_t(1040000));
+    QCOMPARE(QString::fromStdString(entries[1].timecode.toString()), QStringLiteral("01:02:04;05"));
+
+    const TimedMetadataExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+    QCOMPARE(stats.packets_scanned, uint64_t(2));
+    QCOMPARE(stats.timecodes, uint64_t(2));
+    QCOMPARE(stats.parse_errors, uint64_t(0));
+}
+
+void TestTimedMetadata::testH264AvccExtradata()
+{
+    // avcC：SPS只在extradata里，包为4字节长度前缀
+    const Bytes sps = h264Sps();
+    Bytes avcc = {1, 100, 0, 40, 0xFF, 0xE1,
+                  static_cast<uint8_t>(sps.size() >> 8), static_cast<uint8_t>(sps.size())};
+    avcc.insert(avcc.end(), sps.begin(), sps.end());
+    avcc.push_back(0);      // numOfPictureParameterSets
+
+    SeiParser parser(SeiParser::Codec::H264, 0);
+    parser.parseExtradata(avcc.data(), avcc.size());
+    QCOMPARE(parser.nalLengthSize(), 4);
+    QVERIFY(parser.hasSps());
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 1000}),
+                                avcc.data(), avcc.size()));
+
+    std::mt19937 rng(3);
+    Bytes packet_data;
+    appendLengthPrefixed(packet_data, h264PicTiming(makeTimecode(10, 0, 0, 0, false), true));
+    appendLengthPrefixed(packet_data, fakeSlice(rng, 3000, 0x65));
+    AVPacket packet = makePacket(0, packet_data, 500);
+    QVERIFY(extractor.processPacket(&packet));
+
+    Timecode timecode;
+    QVERIFY(track->latestTimecode(500000, &timecode));
+    QCOMPARE(QString::fromStdString(timecode.toString()), QStringLiteral("10:00:00:00"));
+
+    // 没有SPS时不能解析pic_timing，但不算错误
+    auto other_track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor no_sps(other_track);
+    QVERIFY(no_sps.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 1000}), nullptr, 0));
+    Bytes annexb;
+    appendAnnexB(annexb, h264PicTiming(makeTimecode(10, 0, 0, 0, false), true));
+    packet = makePacket(0, annexb, 500);
+    QVERIFY(no_sps.processPacket(&packet));
+    QCOMPARE(other_track->size(), size_t(0));
+    QCOMPARE(no_sps.getStatistics().sei_messages, uint64_t(1));
+    QCOMPARE(no_sps.getStatistics().parse_errors, uint64_t(0));
+}
+
+void TestTimedMetadata::testHevcTimeCode()
+{
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+
+    // hvcC：只用到第21字节的lengthSizeMinusOne
+    Bytes hvcc(23, 0);
+    hvcc[0] = 1;
+    hvcc[21] = 0x03;
+    QVERIFY(extractor.addStream(streamInfo(1, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_HEVC, {1, 90000}),
+                                hvcc.data(), hvcc.size()));
+
+    std::mt19937 rng(11);
+    Bytes packet_data;
+    appendLengthPrefixed(packet_data, hevcTimeCode(makeTimecode(23, 20, 10, 59, false)));
+    appendLengthPrefixed(packet_data, fakeSlice(rng, 3000, 0x26));
+    AVPacket packet = makePacket(1, packet_data, 180000);
+    QVERIFY(extractor.processPacket(&packet));
+
+    const std::vector<TimedMetadata> entries = collect(*track, 0, 3000000);
+    QCOMPARE(entries.size(), size_t(1));
+    QCOMPARE(entries[0].stream_index, 1);
+    QCOMPARE(entries[0].pts_us, int64_t(2000000));
+    QCOMPARE(QString::fromStdString(entries[0].timecode.toString()), QStringLiteral("23:20:10:59"));
+
+    // 其他流的包不处理
+    packet.stream_index = 0;
+    QVERIFY(!extractor.processPacket(&packet));
+}
+
+void TestTimedMetadata::testUserDataWithEmulationPrevention()
+{
+    // UUID + 含连续零字节的负载：码流里必然出现防竞争字节，取出来应与原负载一致
+    Bytes payload = {0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7,
+                     0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF};
+    const uint8_t body[] = {0, 0, 0, 0, 1, 0, 0, 2, 0, 0, 3, 'k', 'l', 'v', 0, 0};
+    payload.insert(payload.end(), body, body + sizeof(body));
+    const Bytes unit = nal({0x06}, seiRbsp(SeiParser::kUserDataUnregistered, payload));
+    Bytes stream;
+    appendAnnexB(stream, unit);
+    QVERIFY(stream.size() > payload.size() + 7);    // 至少插入了防竞争字节
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 1000}), nullptr, 0));
+    AVPacket packet = makePacket(0, stream, 40);
+    QVERIFY(extractor.processPacket(&packet));
+
+    std::vector<TimedMetadata> entries;
+    Bytes extracted;
+    track->visit(0, 1000000, [&](const TimedMetadata& entry) {
+        entries.push_back(entry);
+        extracted.assign(entry.data, entry.data + entry.size);
+    });
+    QCOMPARE(entries.size(), size_t(1));
+    QVERIFY(entries[0].kind == TimedMetadata::Kind::SeiUserData);
+    QCOMPARE(entries[0].pts_us, int64_t(40000));
+    QVERIFY(extracted == payload);
+
+    // 关掉user data后只留时间码
+    TimedMetadataExtractor::Config config;
+    config.video_user_data = false;
+    auto other_track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor filtered(other_track, config);
+    QVERIFY(filtered.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 1000}), nullptr, 0));
+    QVERIFY(filtered.processPacket(&packet));
+    QCOMPARE(other_track->size(), size_t(0));
+}
+
+void TestTimedMetadata::testMalformedPackets()
+{
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    Bytes hvcc(23, 0);
+    hvcc[0] = 1;
+    hvcc[21] = 0x03;
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_HEVC, {1, 1000}),
+                                hvcc.data(), hvcc.size()));
+
+    Bytes packet_data;
+    appendLengthPrefixed(packet_data, hevcTimeCode(makeTimecode(1, 1, 1, 1, false)));
+
+    // 每种截断都不能越界，也不能写出条目
+    std::mt19937 rng(5);
+    for (size_t cut = 1; cut < packet_data.size(); ++cut) {
+        Bytes truncated(packet_data.begin(), packet_data.begin() + static_cast<long>(cut));
+        AVPacket packet = makePacket(0, truncated, 0);
+        extractor.processPacket(&packet);
+    }
+    // 随机字节
+    for (int i = 0; i < 200; ++i) {
+        Bytes noise(static_cast<size_t>(rng() % 300 + 1));
+        for (uint8_t& byte : noise) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        AVPacket packet = makePacket(0, noise, 0);
+        extractor.processPacket(&packet);
+    }
+    QVERIFY(extractor.getStatistics().parse_errors > 0);
+
+    // 没有时间戳的包被忽略
+    AVPacket packet = makePacket(0, packet_data, AV_NOPTS_VALUE);
+    QVERIFY(extractor.processPacket(&packet));
+    QCOMPARE(extractor.getStatistics().untimed_packets, uint64_t(1));
+}
+
+// ==================== 字幕/数据流 ====================
+
+void TestTimedMetadata::testKlvSplit()
+{
+    // UAS本地集合（短格式长度）+ 另一个键（长格式长度，0x82两字节）
+    const uint8_t uas_key[16] = {0x06, 0x0E, 0x2B, 0x34, 0x02, 0x0B, 0x01, 0x01,
+                                 0x0E, 0x01, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00};
+    Bytes first(uas_key, uas_key + 16);
+    first.push_back(5);
+    const uint8_t local_set[] = {0x02, 0x03, 0x01, 0x02, 0x03};
+    first.insert(first.end(), local_set, local_set + sizeof(local_set));
+
+    Bytes second(uas_key, uas_key + 16);
+    second[15] = 0x42;
+    second.push_back(0x82);
+    second.push_back(0x01);
+    second.push_back(0x2C);     // 300字节
+    for (int i = 0; i < 300; ++i) {
+        second.push_back(static_cast<uint8_t>(i));
+    }
+
+    size_t header = 0;
+    size_t value = 0;
+    QVERIFY(TimedMetadataExtractor::parseKlv(first.data(), first.size(), &header, &value));
+    QCOMPARE(header, size_t(17));
+    QCOMPARE(value, size_t(5));
+    QVERIFY(TimedMetadataExtractor::parseKlv(second.data(), second.size(), &header, &value));
+    QCOMPARE(header, size_t(19));
+    QCOMPARE(value, size_t(300));
+    QVERIFY(!TimedMetadataExtractor::parseKlv(second.data(), second.size() - 1, &header, &value));
+
+    Bytes packet_data = first;
+    packet_data.insert(packet_data.end(), second.begin(), second.end());
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(3, AVMEDIA_TYPE_DATA, AV_CODEC_ID_SMPTE_KLV, {1, 90000}), nullptr, 0));
+    AVPacket packet = makePacket(3, packet_data, 900000);
+    QVERIFY(extractor.processPacket(&packet));
+
+    std::vector<Bytes> items;
+    track->visit(0, 20000000, [&](const TimedMetadata& entry) {
+        QVERIFY(entry.kind == TimedMetadata::Kind::Klv);
+        QCOMPARE(entry.pts_us, int64_t(10000000));
+        items.emplace_back(entry.data, entry.data + entry.size);
+    });
+    QCOMPARE(items.size(), size_t(2));
+    QVERIFY(items[0] == first);
+    QVERIFY(items[1] == second);
+    QCOMPARE(extractor.getStatistics().klv_items, uint64_t(2));
+
+    // 尾部残缺：完整的三元组照常写入，残缺部分计错误
+    Bytes broken = first;
+    broken.insert(broken.end(), second.begin(), second.begin() + 40);
+    packet = makePacket(3, broken, 990000);
+    QVERIFY(extractor.processPacket(&packet));
+    QCOMPARE(extractor.getStatistics().klv_items, uint64_t(3));
+    QCOMPARE(extractor.getStatistics().parse_errors, uint64_t(1));
+}
+
+void TestTimedMetadata::testMovTextAndData()
+{
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(2, AVMEDIA_TYPE_SUBTITLE, AV_CODEC_ID_MOV_TEXT, {1, 1000}), nullptr, 0));
+    QVERIFY(extractor.addStream(streamInfo(4, AVMEDIA_TYPE_DATA, AV_CODEC_ID_BIN_DATA, {1, 1000}), nullptr, 0));
+    // 音频流不处理
+    QVERIFY(!extractor.addStream(streamInfo(1, AVMEDIA_TYPE_AUDIO, AV_CODEC_ID_AAC, {1, 48000}), nullptr, 0));
+
+    // tx3g：长度前缀 + 文本 + 样式盒
+    const std::string text = "Hello, world";
+    Bytes tx3g = {0, static_cast<uint8_t>(text.size())};
+    tx3g.insert(tx3g.end(), text.begin(), text.end());
+    const uint8_t style_box[] = {0, 0, 0, 10, 's', 't', 'y', 'l', 0, 0};
+    tx3g.insert(tx3g.end(), style_box, style_box + sizeof(style_box));
+    AVPacket packet = makePacket(2, tx3g, 1500, 2000);
+    QVERIFY(extractor.processPacket(&packet));
+
+    const Bytes blob = {1, 2, 3, 4};
+    packet = makePacket(4, blob, 2000);
+    QVERIFY(extractor.processPacket(&packet));
+
+    std::vector<std::string> payloads;
+    std::vector<TimedMetadata> entries = collect(*track, 3000000, 3040000, &payloads);
+    QCOMPARE(entries.size(), size_t(1));
+    QVERIFY(entries[0].kind == TimedMetadata::Kind::Subtitle);
+    QCOMPARE(entries[0].pts_us, int64_t(1500000));
+    QCOMPARE(entries[0].duration_us, int64_t(2000000));
+    QCOMPARE(payloads[0], text);
+
+    entries = collect(*track, 2000000, 2000001);
+    QCOMPARE(entries.size(), size_t(2));
+    QVERIFY(entries[1].kind == TimedMetadata::Kind::Data);
+    QCOMPARE(entries[1].size, blob.size());
+
+    // 禁用字幕
+    TimedMetadataExtractor::Config config;
+    config.subtitles = false;
+    TimedMetadataExtractor no_subtitles(track, config);
+    QVERIFY(!no_subtitles.addStream(streamInfo(2, AVMEDIA_TYPE_SUBTITLE, AV_CODEC_ID_SUBRIP, {1, 1000}),
+                                    nullptr, 0));
+}
+
+void TestTimedMetadata::testVideoPacketUntouched()
+{
+    std::mt19937 rng(13);
+    Bytes data;
+    appendAnnexB(data, h264Sps());
+    appendAnnexB(data, h264PicTiming(makeTimecode(0, 0, 1, 0, false), true));
+    appendAnnexB(data, fakeSlice(rng, 20000, 0x65));
+
+    AVPacket* packet = av_packet_alloc();
+    QVERIFY(av_new_packet(packet, static_cast<int>(data.size())) == 0);
+    std::memcpy(packet->data, data.data(), data.size());
+    packet->pts = 0;
+    packet->dts = 0;
+    packet->stream_index = 0;
+    const uint8_t* before_data = packet->data;
+    const int before_refs = av_buffer_get_ref_count(packet->buf);
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 90000}), nullptr, 0));
+    for (int i = 0; i < 10; ++i) {
+        packet->pts = i * 3600;
+        QVERIFY(extractor.processPacket(packet));
+    }
+
+    // 同一块内存、没有新增引用、内容不变
+    QVERIFY(packet->data == before_data);
+    QCOMPARE(av_buffer_get_ref_count(packet->buf), before_refs);
+    QCOMPARE(packet->size, static_cast<int>(data.size()));
+    QVERIFY(std::memcmp(packet->data, data.data(), data.size()) == 0);
+    QCOMPARE(track->size(), size_t(10));
+    av_packet_free(&packet);
+}
+
+QString TestTimedMetadata::writeSubtitledClip(const QString& name, double seconds)
+{
+    // 测试媒体开头一段视频（流复制）加一路SRT字幕
+    const QString path = temp_dir_.filePath(name);
+    const QByteArray src = media_file_.toUtf8();
+    const QByteArray dst = path.toUtf8();
+
+    AVFormatContext* in = nullptr;
+    if (avformat_open_input(&in, src.constData(), nullptr, nullptr) < 0) {
+        return QString();
+    }
+    avformat_find_stream_info(in, nullptr);
+    const int video = av_find_best_stream(in, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+
+    AVFormatContext* out = nullptr;
+    avformat_alloc_output_context2(&out, nullptr, "matroska", dst.constData());
+    bool ok = out != nullptr && video >= 0;
+
+    AVStream* video_out = ok ? avformat_new_stream(out, nullptr) : nullptr;
+    ok = ok && video_out && avcodec_parameters_copy(video_out->codecpar, in->streams[video]->codecpar) >= 0;
+    AVStream* subtitle_out = ok ? avformat_new_stream(out, nullptr) : nullptr;
+    if (ok && subtitle_out) {
+        video_out->codecpar->codec_tag = 0;
+        video_out->time_base = in->streams[video]->time_base;
+        subtitle_out->codecpar->codec_type = AVMEDIA_TYPE_SUBTITLE;
+        subtitle_out->codecpar->codec_id = AV_CODEC_ID_SUBRIP;
+        subtitle_out->time_base = {1, 1000};
+        av_dict_set(&subtitle_out->metadata, "language", "eng", 0);
+    }
+    ok = ok && subtitle_out && avio_open(&out->pb, dst.constData(), AVIO_FLAG_WRITE) >= 0;
+    ok = ok && avformat_write_header(out, nullptr) >= 0;
+
+    AVPacket* packet = av_packet_alloc();
+    // 两条字幕：0.2s起0.5s，1.0s起0.4s
+    const struct { int64_t start_ms; int64_t duration_ms; const char* text; } cues[] = {
+        {200, 500, "first line"},
+        {1000, 400, "second line"},
+    };
+    for (const auto& cue : cues) {
+        if (!ok || !packet || av_new_packet(packet, static_cast<int>(std::strlen(cue.text))) < 0) {
+            ok = false;
+            break;
+        }
+        std::memcpy(packet->data, cue.text, std::strlen(cue.text));
+        packet->stream_index = subtitle_out->index;
+        packet->pts = av_rescale_q(cue.start_ms, {1, 1000}, subtitle_out->time_base);
+        packet->dts = packet->pts;
+        packet->duration = av_rescale_q(cue.duration_ms, {1, 1000}, subtitle_out->time_base);
+        ok = av_interleaved_write_frame(out, packet) >= 0;
+    }
+
+    const int64_t limit_us = static_cast<int64_t>(seconds * 1000000);
+    while (ok && packet && av_read_frame(in, packet) >= 0) {
+        const AVStream* in_stream = in->streams[packet->stream_index];
+        if (packet->stream_index == video && packet->pts != AV_NOPTS_VALUE) {
+            const int64_t start = in_stream->start_time != AV_NOPTS_VALUE ? in_stream->start_time : 0;
+            if (av_rescale_q(packet->pts - start, in_stream->time_base, AV_TIME_BASE_Q) < limit_us) {
+                av_packet_rescale_ts(packet, in_stream->time_base, video_out->time_base);
+                packet->stream_index = video_out->index;
+                packet->pos = -1;
+                ok = av_interleaved_write_frame(out, packet) >= 0;
+            }
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+
+    if (ok) {
+        av_write_trailer(out);
+    }
+    if (out) {
+        avio_closep(&out->pb);
+        avformat_free_context(out);
+    }
+    avformat_close_input(&in);
+    return ok ? path : QString();
+}
+
+void TestTimedMetadata::testDemuxedSubtitleStream()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    const QString clip = writeSubtitledClip(QStringLiteral("subtitled.mkv"), 1.5);
+    if (clip.isEmpty()) {
+        QSKIP("无法写出带字幕的mkv（muxer不可用）");
+    }
+
+    const std::string url = clip.toStdString();
+    std::shared_ptr<IInputSource> input = InputSourceFactory::create(url);
+    QVERIFY(input && input->open(url));
+    FFmpegDemuxer demuxer;
+    QVERIFY2(demuxer.initialize(input), demuxer.getLastError().c_str());
+
+    int video_index = -1;
+    int subtitle_index = -1;
+    for (const StreamInfo& info : demuxer.getStreamInfos()) {
+        if (info.isVideo()) {
+            video_index = info.index;
+        } else if (info.isSubtitle()) {
+            subtitle_index = info.index;
+            QVERIFY(info.codec_id == AV_CODEC_ID_SUBRIP);
+            QCOMPARE(QString::fromStdString(info.language), QStringLiteral("eng"));
+            QVERIFY(!info.isData());
+        }
+    }
+    QVERIFY(video_index >= 0);
+    QVERIFY(subtitle_index >= 0);
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.configure(demuxer, video_index) >= 1);
+
+    AVPacket* packet = av_packet_alloc();
+    while (demuxer.readPacket(packet)) {
+        extractor.processPacket(packet);
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+
+    QCOMPARE(extractor.getStatistics().subtitles, uint64_t(2));
+
+    // 0.5s的帧落在第一条字幕里，1.2s落在第二条里，0.8s没有字幕
+    std::vector<std::string> texts;
+    track->visitFrame(500000, 40000, [&](const TimedMetadata& entry) {
+        if (entry.kind == TimedMetadata::Kind::Subtitle) {
+            QCOMPARE(entry.stream_index, subtitle_index);
+            texts.push_back(entry.text());
+        }
+    });
+    QCOMPARE(texts.size(), size_t(1));
+    QCOMPARE(texts[0], std::string("first line"));
+
+    texts.clear();
+    track->visitFrame(1200000, 40000, [&](const TimedMetadata& entry) {
+        if (entry.kind == TimedMetadata::Kind::Subtitle) {
+            texts.push_back(entry.text());
+        }
+    });
+    QCOMPARE(texts.size(), size_t(1));
+    QCOMPARE(texts[0], std::string("second line"));
+
+    int subtitles_at_gap = 0;
+    track->visitFrame(800000, 40000, [&](const TimedMetadata& entry) {
+        subtitles_at_gap += entry.kind == TimedMetadata::Kind::Subtitle ? 1 : 0;
+    });
+    QCOMPARE(subtitles_at_gap, 0);
+}
+
+void TestTimedMetadata::testPipelineExtractsSubtitles()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    const QString clip = writeSubtitledClip(QStringLiteral("pipeline.mkv"), 1.5);
+    if (clip.isEmpty()) {
+        QSKIP("无法写出带字幕的mkv（muxer不可用）");
+    }
+
+    MediaPipeline::Config config;
+    config.enable_audio = false;
+    config.video_decoder_threads = 1;
+
+    MediaPipeline pipeline;
+    QVERIFY2(pipeline.open(clip.toStdString(), config), pipeline.getLastError().c_str());
+    auto extractor = std::make_shared<TimedMetadataExtractor>(std::make_shared<TimedMetadataTrack>());
+    pipeline.setMetadataExtractor(extractor);
+
+    QVERIFY(pipeline.start());
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pipeline.isFinished() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    pipeline.stop();
+
+    const MediaPipeline::StatisticsSnapshot stats = pipeline.getStatistics();
+    qDebug() << "   解码" << stats.video_frames_decoded << "帧，字幕" << extractor->getStatistics().subtitles << "条";
+    QVERIFY(stats.video_frames_decoded > 0);
+    QCOMPARE(extractor->getStatistics().subtitles, uint64_t(2));
+    QCOMPARE(extractor->track()->size(), size_t(2));
+}
+
+// ==================== 基准 ====================
+
+void TestTimedMetadata::benchmarkSeiScan()
+{
+    // 1080p量级的Annex B包：SEI时间码 + 200KB片数据，扫描必须远低于解码一帧的耗时
+    std::mt19937 rng(17);
+    const int kPackets = 50;
+    std::vector<Bytes> packets(kPackets);
+    for (int i = 0; i < kPackets; ++i) {
+        appendAnnexB(packets[i], h264PicTiming(makeTimecode(0, 0, i / 25, i % 25, false), true));
+        appendAnnexB(packets[i], fakeSlice(rng, 200000, 0x65));
+    }
+
+    auto track = std::make_shared<TimedMetadataTrack>();
+    TimedMetadataExtractor extractor(track);
+    QVERIFY(extractor.addStream(streamInfo(0, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, {1, 25}), nullptr, 0));
+    // SPS单独一包
+    Bytes sps;
+    appendAnnexB(sps, h264Sps());
+    AVPacket packet = makePacket(0, sps, 0);
+    extractor.processPacket(&packet);
+
+    const int kRounds = 10;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (int i = 0; i < kPackets; ++i) {
+            packet = makePacket(0, packets[i], round * kPackets + i);
+            extractor.processPacket(&packet);
+        }
+    }
+    const double elapsed_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    const double per_packet_us = elapsed_us / (kRounds * kPackets);
+    const double mb_per_s = (packets[0].size() * kRounds * kPackets) / elapsed_us;
+
+    qDebug() << "   Annex B 200KB包扫描:" << per_packet_us << "us/包，" << mb_per_s << "MB/s";
+    QCOMPARE(extractor.getStatistics().timecodes, uint64_t(kRounds * kPackets));
+    QVERIFY2(per_packet_us < 2000.0, "SEI扫描过慢");
+}
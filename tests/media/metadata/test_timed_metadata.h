@@ -0,0 +1,48 @@
+#ifndef TEST_TIMED_METADATA_H
+#define TEST_TIMED_METADATA_H
+
+#include <QtTest>
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "media/metadata/timed_metadata_extractor.h"
+
+class TestTimedMetadata : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 轨道：排序、按帧查询、淘汰
+    void testTimecodeToString();
+    void testTrackOrdersAndQueries();
+    void testTrackEvictsOldest();
+    void testTrackItemSwitch();
+
+    // SEI解析
+    void testH264PicTimingAnnexB();
+    void testH264AvccExtradata();
+    void testHevcTimeCode();
+    void testUserDataWithEmulationPrevention();
+    void testMalformedPackets();
+
+    // 字幕/数据流
+    void testKlvSplit();
+    void testMovTextAndData();
+    void testVideoPacketUntouched();
+    void testDemuxedSubtitleStream();
+    void testPipelineExtractsSubtitles();
+
+    // 基准：每包扫描耗时
+    void benchmarkSeiScan();
+
+private:
+    QString writeSubtitledClip(const QString& name, double seconds);
+
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_TIMED_METADATA_H
@@ -0,0 +1,166 @@
+#include "test_media_pipeline.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+namespace {
+
+double processCpuMs() {
+#if defined(__linux__) || defined(__APPLE__)
+    timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    }
+#endif
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+void TestMediaPipeline::initTestCase()
+{
+    qDebug() << "⏩ 开始变速播放管道测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    qDebug() << "   测试媒体:" << media_file_;
+}
+
+media::MediaPipeline::Config TestMediaPipeline::pipelineConfig() const
+{
+    media::MediaPipeline::Config config;
+    config.audio.sink_type = media::AudioSinkType::Null;
+    config.video_decoder_threads = 1;
+    return config;
+}
+
+TestMediaPipeline::RunResult TestMediaPipeline::runAtSpeed(double speed, int duration_ms)
+{
+    RunResult result{};
+    media::MediaPipeline pipeline;
+    if (!pipeline.open(media_file_.toStdString(), pipelineConfig())) {
+        qWarning() << "打开失败:" << QString::fromStdString(pipeline.getLastError());
+        return result;
+    }
+    pipeline.setPlaybackSpeed(speed);
+
+    const double cpu_start = processCpuMs();
+    const auto wall_start = std::chrono::steady_clock::now();
+    pipeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    pipeline.stop();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    result.cpu_ms_per_second = (processCpuMs() - cpu_start) / wall_s;
+    result.stats = pipeline.getStatistics();
+    result.decoded_frames_per_second = result.stats.video_frames_decoded / wall_s;
+    return result;
+}
+
+void TestMediaPipeline::testSpeedClamp()
+{
+    media::MediaPipeline pipeline;
+    QCOMPARE(pipeline.setPlaybackSpeed(100.0), media::MediaPipeline::kMaxSpeed);
+    QCOMPARE(pipeline.setPlaybackSpeed(0.1), media::MediaPipeline::kMinSpeed);
+    QCOMPARE(pipeline.setPlaybackSpeed(1.5), 1.5);
+    QCOMPARE(pipeline.getPlaybackSpeed(), 1.5);
+}
+
+void TestMediaPipeline::testStretchedAudioKeepsSync()
+{
+    media::MediaPipeline pipeline;
+    QVERIFY2(pipeline.open(media_file_.toStdString(), pipelineConfig()),
+             qPrintable(QString::fromStdString(pipeline.getLastError())));
+    if (!pipeline.getAudioStreamInfo().isValid()) {
+        QSKIP("测试媒体没有音频流");
+    }
+
+    pipeline.setPlaybackSpeed(1.5);
+    QVERIFY(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+    // 1.5x下音频经过伸缩，主时钟仍由音频驱动，且按1.5倍推进
+    const int64_t clock1 = pipeline.getMasterClockUs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const int64_t clock2 = pipeline.getMasterClockUs();
+    pipeline.stop();
+
+    const auto stats = pipeline.getStatistics();
+    qDebug() << "   1.5x: 显示" << stats.video_frames_presented << "帧，晚到丢弃" << stats.video_frames_dropped_late
+             << "帧，平均同步误差" << stats.average_sync_error_ms << "ms，最大" << stats.max_sync_error_ms
+             << "ms，时钟推进" << (clock2 - clock1) / 1000 << "ms/500ms";
+    QVERIFY(stats.audio_clock_master);
+    QVERIFY(stats.audio_frames_written > 0);
+    QVERIFY(stats.video_frames_presented > 0);
+    QVERIFY(stats.average_sync_error_ms < 20.0);
+    QVERIFY(clock2 - clock1 > 600000);
+    QVERIFY(clock2 - clock1 < 900000);
+}
+
+void TestMediaPipeline::testSpeedChangeKeepsClockContinuous()
+{
+    media::MediaPipeline pipeline;
+    QVERIFY(pipeline.open(media_file_.toStdString(), pipelineConfig()));
+    QVERIFY(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(800));
+
+    // 1x -> 8x -> 1x：每次切换前后主时钟都不应大幅跳变
+    int64_t max_jump_us = 0;
+    for (double speed : {8.0, 1.0}) {
+        const int64_t before = pipeline.getMasterClockUs();
+        pipeline.setPlaybackSpeed(speed);
+        const int64_t after = pipeline.getMasterClockUs();
+        max_jump_us = std::max<int64_t>(max_jump_us, std::abs(after - before));
+        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    }
+    const int64_t end_clock = pipeline.getMasterClockUs();
+    pipeline.stop();
+
+    const auto stats = pipeline.getStatistics();
+    qDebug() << "   切换时钟跳变" << max_jump_us / 1000 << "ms，结束时钟" << end_clock / 1000
+             << "ms，跳过" << stats.video_packets_skipped << "个视频包";
+    QVERIFY(max_jump_us < 100000);
+    // 0.8s@1x + 0.8s@8x + 0.8s@1x 约为8s媒体时间
+    QVERIFY(end_clock > 5000000);
+    QVERIFY(stats.video_frames_presented > 0);
+}
+
+void TestMediaPipeline::benchmarkSpeedCpuCost()
+{
+    const int duration_ms = 2000;
+    const RunResult normal = runAtSpeed(1.0, duration_ms);
+    const RunResult fast = runAtSpeed(8.0, duration_ms);
+    const RunResult fastest = runAtSpeed(16.0, duration_ms);
+
+    for (const RunResult* run : {&normal, &fast, &fastest}) {
+        qDebug() << "   " << run->stats.playback_speed << "x: CPU" << run->cpu_ms_per_second << "ms/s，读包"
+                 << run->stats.video_packets_read << "，跳过" << run->stats.video_packets_skipped
+                 << "，解码" << run->stats.video_frames_decoded << "（" << run->decoded_frames_per_second
+                 << "帧/s），显示" << run->stats.video_frames_presented
+                 << "，音频丢包" << run->stats.audio_packets_dropped;
+    }
+
+    QVERIFY(normal.stats.video_frames_presented > 0);
+    QVERIFY(fastest.stats.video_frames_presented > 0);
+
+    // 高倍速只解关键帧：非关键帧包不解码直接跳过，音频整体不解码
+    for (const RunResult* run : {&fast, &fastest}) {
+        QVERIFY(run->stats.video_packets_skipped > 0);
+        QVERIFY(run->stats.video_frames_decoded < run->stats.video_packets_read);
+        // 每秒解码的帧数不超过1x：解码量不随速度增长
+        QVERIFY(run->decoded_frames_per_second <= normal.decoded_frames_per_second);
+    }
+    QVERIFY(fastest.stats.audio_packets_dropped > 0 || fastest.stats.audio_frames_written == 0);
+
+    // CPU与1x接近：至多1.5倍，另留20ms/s容忍测试机抖动
+    QVERIFY(fast.cpu_ms_per_second <= normal.cpu_ms_per_second * 1.5 + 20.0);
+    QVERIFY(fastest.cpu_ms_per_second <= normal.cpu_ms_per_second * 1.5 + 20.0);
+}
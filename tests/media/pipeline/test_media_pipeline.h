@@ -0,0 +1,36 @@
+#ifndef TEST_MEDIA_PIPELINE_H
+#define TEST_MEDIA_PIPELINE_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/media_pipeline.h"
+
+class TestMediaPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testSpeedClamp();
+    void testStretchedAudioKeepsSync();
+    void testSpeedChangeKeepsClockContinuous();
+
+    // 高倍速CPU基准
+    void benchmarkSpeedCpuCost();
+
+private:
+    struct RunResult {
+        double cpu_ms_per_second;
+        double decoded_frames_per_second;
+        media::MediaPipeline::StatisticsSnapshot stats;
+    };
+
+    media::MediaPipeline::Config pipelineConfig() const;
+    RunResult runAtSpeed(double speed, int duration_ms);
+
+    QString media_file_;
+};
+
+#endif // TEST_MEDIA_PIPELINE_H
@@ -0,0 +1,224 @@
+#include "test_playlist_engine.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+int64_t nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 每一帧上屏时刻的墙钟和主时钟
+struct PresentedFrame {
+    int64_t wall_us;
+    int64_t clock_us;
+};
+
+} // namespace
+
+void TestPlaylistEngine::initTestCase()
+{
+    qDebug() << "🔁 开始播放列表无缝衔接测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+    qDebug() << "   测试媒体:" << media_file_;
+}
+
+media::PlaylistEngine::Config TestPlaylistEngine::engineConfig() const
+{
+    media::PlaylistEngine::Config config;
+    config.pipeline.audio.sink_type = media::AudioSinkType::Null;
+    config.pipeline.video_decoder_threads = 1;
+    return config;
+}
+
+QString TestPlaylistEngine::writeClip(const QString& name, double seconds, bool keep_audio)
+{
+    // 从测试媒体开头截取一段（流复制，不重新编码），条目足够短才能在测试里播完
+    const QString path = temp_dir_.filePath(name);
+    const QByteArray src = media_file_.toUtf8();
+    const QByteArray dst = path.toUtf8();
+
+    AVFormatContext* in = nullptr;
+    if (avformat_open_input(&in, src.constData(), nullptr, nullptr) < 0) {
+        return QString();
+    }
+    avformat_find_stream_info(in, nullptr);
+
+    AVFormatContext* out = nullptr;
+    avformat_alloc_output_context2(&out, nullptr, nullptr, dst.constData());
+    bool ok = out != nullptr;
+
+    std::vector<int> mapping(in->nb_streams, -1);
+    for (unsigned i = 0; ok && i < in->nb_streams; ++i) {
+        const AVMediaType type = in->streams[i]->codecpar->codec_type;
+        if (type != AVMEDIA_TYPE_VIDEO && !(keep_audio && type == AVMEDIA_TYPE_AUDIO)) {
+            continue;
+        }
+        AVStream* stream = avformat_new_stream(out, nullptr);
+        ok = stream && avcodec_parameters_copy(stream->codecpar, in->streams[i]->codecpar) >= 0;
+        if (ok) {
+            stream->codecpar->codec_tag = 0;
+            stream->time_base = in->streams[i]->time_base;
+            mapping[i] = stream->index;
+        }
+    }
+    ok = ok && avio_open(&out->pb, dst.constData(), AVIO_FLAG_WRITE) >= 0;
+    ok = ok && avformat_write_header(out, nullptr) >= 0;
+
+    AVPacket* packet = av_packet_alloc();
+    const int64_t limit_us = static_cast<int64_t>(seconds * 1000000);
+    while (ok && packet && av_read_frame(in, packet) >= 0) {
+        const int index = mapping[packet->stream_index];
+        const AVStream* in_stream = in->streams[packet->stream_index];
+        if (index >= 0 && packet->pts != AV_NOPTS_VALUE) {
+            const int64_t start = in_stream->start_time != AV_NOPTS_VALUE ? in_stream->start_time : 0;
+            if (av_rescale_q(packet->pts - start, in_stream->time_base, AV_TIME_BASE_Q) < limit_us) {
+                av_packet_rescale_ts(packet, in_stream->time_base, out->streams[index]->time_base);
+                packet->stream_index = index;
+                packet->pos = -1;
+                ok = av_interleaved_write_frame(out, packet) >= 0;
+            }
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+
+    if (ok) {
+        av_write_trailer(out);
+    }
+    if (out) {
+        avio_closep(&out->pb);
+        avformat_free_context(out);
+    }
+    avformat_close_input(&in);
+    return ok ? path : QString();
+}
+
+void TestPlaylistEngine::testGaplessSwitch()
+{
+    const QString clip = writeClip(QStringLiteral("clip.mp4"), 1.5, true);
+    QVERIFY(!clip.isEmpty());
+
+    media::PlaylistEngine engine(engineConfig());
+    engine.setItems({clip.toStdString(), clip.toStdString(), clip.toStdString()});
+
+    std::mutex mutex;
+    std::vector<PresentedFrame> frames;
+    std::vector<size_t> items;
+    std::vector<size_t> frames_at_switch;
+    std::atomic<int64_t> audio_samples{0};
+    std::atomic<int> sample_rate{0};
+    std::atomic<bool> finished{false};
+
+    engine.setVideoFrameCallback([&](AVFrame*) {
+        const PresentedFrame presented{nowUs(), engine.pipeline().getMasterClockUs()};
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.push_back(presented);
+    });
+    engine.setAudioFrameCallback([&](AVFrame* frame) {
+        audio_samples.fetch_add(frame->nb_samples);
+        sample_rate.store(frame->sample_rate);
+    });
+    engine.setItemChangedCallback([&](size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(index);
+        frames_at_switch.push_back(frames.size());
+    });
+    engine.setFinishedCallback([&]() { finished.store(true); });
+
+    QVERIFY2(engine.play(0), qPrintable(QString::fromStdString(engine.getLastError())));
+    QTRY_VERIFY_WITH_TIMEOUT(finished.load(), 20000);
+    const int64_t end_clock = engine.pipeline().getMasterClockUs();
+    const auto pipeline_stats = engine.pipeline().getStatistics();
+    const auto stats = engine.getStatistics();
+    engine.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    QVERIFY(items == (std::vector<size_t>{0, 1, 2}));
+    QCOMPARE(stats.gapless_switches, uint64_t(2));
+    QCOMPARE(stats.reopen_switches, uint64_t(0));
+    QCOMPARE(pipeline_stats.items_switched, uint64_t(2));
+    QVERIFY(frames.size() > 10);
+
+    // 切换处前后两帧的墙钟间隔和主时钟推进都应接近一个帧间隔，时钟不回退
+    int64_t max_gap_us = 0;
+    int64_t max_clock_step_us = 0;
+    int64_t min_clock_step_us = 0;
+    for (size_t i = 1; i < frames_at_switch.size(); ++i) {
+        const size_t at = frames_at_switch[i];
+        QVERIFY(at > 0 && at < frames.size());
+        const int64_t gap = frames[at].wall_us - frames[at - 1].wall_us;
+        const int64_t step = frames[at].clock_us - frames[at - 1].clock_us;
+        max_gap_us = std::max(max_gap_us, gap);
+        max_clock_step_us = std::max(max_clock_step_us, step);
+        min_clock_step_us = std::min(min_clock_step_us, step);
+    }
+
+    // 音频样本连续写入同一输出：结束时的音频时钟约等于写出的样本总时长
+    const double audio_s = sample_rate.load() > 0 ? static_cast<double>(audio_samples.load()) / sample_rate.load() : 0.0;
+    qDebug() << "   无缝切换" << stats.gapless_switches << "次，共" << frames.size() << "帧，切换处最大间隔"
+             << max_gap_us / 1000.0 << "ms，时钟步进" << min_clock_step_us / 1000.0 << "~"
+             << max_clock_step_us / 1000.0 << "ms，预备平均" << stats.avg_prepare_ms << "ms";
+    qDebug() << "   写出音频" << audio_s << "s，结束时钟" << end_clock / 1e6 << "s";
+    QVERIFY(max_gap_us < 100000);
+    QVERIFY(min_clock_step_us >= 0);
+    QVERIFY(max_clock_step_us < 100000);
+    QVERIFY(audio_s > 4.0);
+    QVERIFY(std::abs(end_clock / 1e6 - audio_s) < 0.2);
+}
+
+void TestPlaylistEngine::testFallbackReopen()
+{
+    const QString clip = writeClip(QStringLiteral("clip_av.mp4"), 1.0, true);
+    const QString video_only = writeClip(QStringLiteral("clip_video.mp4"), 1.0, false);
+    QVERIFY(!clip.isEmpty());
+    QVERIFY(!video_only.isEmpty());
+
+    // 打不开的条目被跳过；只有视频的条目与下一条目组成不同，回退为重新打开
+    media::PlaylistEngine engine(engineConfig());
+    engine.setItems({clip.toStdString(), temp_dir_.filePath(QStringLiteral("missing.mp4")).toStdString(),
+                     video_only.toStdString(), clip.toStdString()});
+
+    std::mutex mutex;
+    std::vector<size_t> items;
+    std::atomic<bool> finished{false};
+    engine.setItemChangedCallback([&](size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(index);
+    });
+    engine.setFinishedCallback([&]() { finished.store(true); });
+
+    QVERIFY(engine.play(0));
+    QTRY_VERIFY_WITH_TIMEOUT(finished.load(), 20000);
+    const auto stats = engine.getStatistics();
+    engine.stop();
+
+    qDebug() << "   预备失败" << stats.prepare_failures << "次，重新打开" << stats.reopen_switches
+             << "次，跳过" << stats.skipped_items << "个条目";
+    std::lock_guard<std::mutex> lock(mutex);
+    QVERIFY(items == (std::vector<size_t>{0, 2, 3}));
+    QCOMPARE(stats.gapless_switches, uint64_t(0));
+    QCOMPARE(stats.reopen_switches, uint64_t(2));
+    QCOMPARE(stats.prepare_failures, uint64_t(2));
+    QCOMPARE(stats.skipped_items, uint64_t(1));
+    QVERIFY(!engine.isPlaying());
+}
@@ -0,0 +1,28 @@
+#ifndef TEST_PLAYLIST_ENGINE_H
+#define TEST_PLAYLIST_ENGINE_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "media/playback/playlist_engine.h"
+
+class TestPlaylistEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testGaplessSwitch();
+    void testFallbackReopen();
+
+private:
+    media::PlaylistEngine::Config engineConfig() const;
+    QString writeClip(const QString& name, double seconds, bool keep_audio);
+
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_PLAYLIST_ENGINE_H
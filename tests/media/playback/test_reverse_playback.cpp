@@ -0,0 +1,155 @@
+#include "test_reverse_playback.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <vector>
+
+void TestReversePlayback::initTestCase()
+{
+    qDebug() << "⏪ 开始倒放引擎测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    qDebug() << "   测试媒体:" << media_file_;
+}
+
+bool TestReversePlayback::openEngine(media::ReversePlaybackEngine& engine)
+{
+    if (!engine.open(media_file_.toStdString())) {
+        qWarning() << "打开失败:" << QString::fromStdString(engine.getLastError());
+        return false;
+    }
+    return engine.gopCount() > 0 && engine.durationUs() > 0;
+}
+
+void TestReversePlayback::testFrameAccurateSeek()
+{
+    media::ReversePlaybackEngine engine;
+    QVERIFY(openEngine(engine));
+
+    const int64_t target = engine.durationUs() / 2;
+    QVERIFY(engine.seek(target));
+    const int64_t landed = engine.currentTimestampUs();
+    QVERIFY(landed >= 0);
+    QVERIFY(landed <= target);
+
+    // 下一帧必须已经越过目标，否则说明停在了更早的帧
+    auto next = engine.stepForward();
+    QVERIFY(next);
+    QVERIFY(engine.toMicroseconds(next->pts) > target);
+
+    // 精确命中某一帧的时间戳时停在该帧
+    const int64_t exact = engine.toMicroseconds(next->pts);
+    QVERIFY(engine.seek(exact));
+    QCOMPARE(engine.currentTimestampUs(), exact);
+
+    // 目标早于第一帧时停在第一帧
+    QVERIFY(engine.seek(-1000000));
+    QVERIFY(!engine.stepBackward());
+}
+
+void TestReversePlayback::testStepBackwardAcrossGops()
+{
+    media::ReversePlaybackEngine engine;
+    QVERIFY(openEngine(engine));
+    QVERIFY(engine.seek(engine.durationUs()));
+
+    // 倒退到跨过至少两个GOP边界，时间戳严格递减
+    int64_t previous = engine.currentTimestampUs();
+    int steps = 0;
+    while (steps < 2000) {
+        auto frame = engine.stepBackward();
+        if (!frame) {
+            break;
+        }
+        const int64_t ts = engine.toMicroseconds(frame->pts);
+        QVERIFY2(ts < previous, qPrintable(QString("pts未递减: %1 -> %2").arg(previous).arg(ts)));
+        previous = ts;
+        steps++;
+    }
+
+    const auto stats = engine.getStatistics();
+    qDebug() << "   倒退" << steps << "帧，解码GOP" << stats.gops_decoded
+             << "命中" << stats.cache_hits << "等待" << stats.cache_misses;
+    QVERIFY(steps > 0);
+    if (engine.gopCount() > 2) {
+        QVERIFY(stats.gops_decoded >= 3);
+    }
+}
+
+void TestReversePlayback::testStepRoundTrip()
+{
+    media::ReversePlaybackEngine engine;
+    QVERIFY(openEngine(engine));
+    QVERIFY(engine.seek(engine.durationUs() / 3));
+
+    // 后退N帧再前进N帧，应回到完全相同的帧序列
+    std::vector<int64_t> backward{engine.currentTimestampUs()};
+    for (int i = 0; i < 60; ++i) {
+        auto frame = engine.stepBackward();
+        if (!frame) {
+            break;
+        }
+        backward.push_back(engine.toMicroseconds(frame->pts));
+    }
+    QVERIFY(backward.size() > 1);
+
+    for (size_t i = backward.size() - 1; i > 0; --i) {
+        auto frame = engine.stepForward();
+        QVERIFY(frame);
+        QCOMPARE(engine.toMicroseconds(frame->pts), backward[i - 1]);
+    }
+}
+
+void TestReversePlayback::testCacheBudget()
+{
+    media::ReversePlaybackEngine::Config config;
+    config.cache_byte_budget = 1;   // 只保留当前GOP和预取窗口
+    config.prefetch_gops = 1;
+    media::ReversePlaybackEngine engine(config);
+    QVERIFY(openEngine(engine));
+    if (engine.gopCount() < 4) {
+        QSKIP("GOP数量不足");
+    }
+
+    QVERIFY(engine.seek(engine.durationUs()));
+    for (int i = 0; i < 2000 && engine.stepBackward(); ++i) {
+    }
+
+    // 缓存中最多剩下当前GOP、预取窗口和调用线程等待的GOP
+    const auto stats = engine.getStatistics();
+    QVERIFY(stats.gops_decoded > 0);
+    QVERIFY(stats.evictions + config.prefetch_gops + 2 >= stats.gops_decoded);
+}
+
+void TestReversePlayback::benchmarkReversePlayback()
+{
+    media::ReversePlaybackEngine engine;
+    QVERIFY(openEngine(engine));
+    QVERIFY(engine.seek(engine.durationUs()));
+
+    QElapsedTimer timer;
+    timer.start();
+    int frames = 0;
+    while (frames < 3000 && engine.stepBackward()) {
+        frames++;
+    }
+    const double elapsed_ms = timer.nsecsElapsed() / 1e6;
+    QVERIFY(frames > 0);
+
+    const auto stats = engine.getStatistics();
+    const AVRational rate = engine.frameRate();
+    qDebug() << "   ⏪ 倒放基准:" << frames << "帧，耗时" << elapsed_ms << "ms，"
+             << frames * 1000.0 / elapsed_ms << "fps（源"
+             << (rate.den > 0 ? static_cast<double>(rate.num) / rate.den : 0.0) << "fps）";
+    qDebug() << "      GOP:" << stats.gops_decoded << "平均" << stats.getAvgGopDecodeMs() << "ms，"
+             << "等待" << stats.stall_ms << "ms";
+    qDebug() << "      内存峰值:" << stats.peak_cache_bytes / (1024.0 * 1024.0) << "MB，"
+             << "淘汰" << stats.evictions << "，CPU" << stats.getCpuMsPerFrame() << "ms/帧";
+
+    QVERIFY(stats.peak_cache_bytes > 0);
+}
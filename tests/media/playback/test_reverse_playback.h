@@ -0,0 +1,31 @@
+#ifndef TEST_REVERSE_PLAYBACK_H
+#define TEST_REVERSE_PLAYBACK_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/playback/reverse_playback_engine.h"
+
+class TestReversePlayback : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 定位与步进
+    void testFrameAccurateSeek();
+    void testStepBackwardAcrossGops();
+    void testStepRoundTrip();
+
+    // 字节预算与性能基准
+    void testCacheBudget();
+    void benchmarkReversePlayback();
+
+private:
+    bool openEngine(media::ReversePlaybackEngine& engine);
+
+    QString media_file_;
+};
+
+#endif // TEST_REVERSE_PLAYBACK_H
@@ -0,0 +1,379 @@
+#include "test_recording_sink.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+// 按输入文件的音视频流建立输出流
+bool addStreams(media::RecordingSink& sink, const AVFormatContext* input)
+{
+    bool added = false;
+    for (unsigned i = 0; i < input->nb_streams; ++i) {
+        const AVStream* stream = input->streams[i];
+        const AVMediaType type = stream->codecpar->codec_type;
+        if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO) {
+            continue;
+        }
+        if (!sink.addStream(stream->index, stream->codecpar, stream->time_base)) {
+            return false;
+        }
+        added = true;
+    }
+    return added;
+}
+
+double packetSeconds(const AVFormatContext* input, const AVPacket* packet)
+{
+    const int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (ts == AV_NOPTS_VALUE) {
+        return -1.0;
+    }
+    return ts * av_q2d(input->streams[packet->stream_index]->time_base);
+}
+
+} // namespace
+
+void TestRecordingSink::initTestCase()
+{
+    qDebug() << "📼 开始录制输出测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+}
+
+bool TestRecordingSink::feed(media::RecordingSink& sink, double limit_s,
+                             const std::function<void(double)>& on_packet)
+{
+    const QByteArray path = media_file_.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, path.constData(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    avformat_find_stream_info(input, nullptr);
+
+    bool ok = addStreams(sink, input);
+    AVPacket* packet = av_packet_alloc();
+    while (ok && av_read_frame(input, packet) >= 0) {
+        const double t = packetSeconds(input, packet);
+        if (t > limit_s) {
+            av_packet_unref(packet);
+            break;
+        }
+        sink.writePacket(packet);
+        av_packet_unref(packet);
+        if (on_packet) {
+            on_packet(t);
+        }
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    return ok;
+}
+
+double TestRecordingSink::probeDuration(const QString& path, int* video_packets)
+{
+    const QByteArray file = path.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, file.constData(), nullptr, nullptr) < 0) {
+        return -1.0;
+    }
+    if (avformat_find_stream_info(input, nullptr) < 0) {
+        avformat_close_input(&input);
+        return -1.0;
+    }
+
+    // 时长取最后一个数据包的结束时间，分片MP4和TS的duration字段可能是估算值
+    double duration = 0.0;
+    int videos = 0;
+    AVPacket* packet = av_packet_alloc();
+    while (av_read_frame(input, packet) >= 0) {
+        const AVStream* stream = input->streams[packet->stream_index];
+        if (packet->pts != AV_NOPTS_VALUE) {
+            const int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+            duration = std::max(duration, (packet->pts - start + packet->duration) * av_q2d(stream->time_base));
+        }
+        if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videos++;
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+
+    if (video_packets) {
+        *video_packets = videos;
+    }
+    return duration;
+}
+
+void TestRecordingSink::testDiskWriterRoundTrip()
+{
+    media::DiskWriter::Config config;
+    config.block_bytes = 8192;
+    config.max_buffers = 4;
+    media::DiskWriter writer(config);
+
+    const QString path = temp_dir_.filePath(QStringLiteral("round_trip.bin"));
+    media::DiskWriter::FileOptions options;
+    options.sync = media::DiskWriter::SyncPolicy::Interval;
+    options.sync_interval_bytes = 32 * 1024;
+    auto file = writer.open(path.toStdString(), options);
+    QVERIFY2(file, writer.getLastError().c_str());
+
+    // 不整齐的小块写入，跨越多个块
+    std::vector<uint8_t> expected(100000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    for (size_t offset = 0; offset < expected.size(); offset += 777) {
+        const size_t count = std::min<size_t>(777, expected.size() - offset);
+        QVERIFY(file->write(expected.data() + offset, count));
+    }
+    QCOMPARE(file->size(), int64_t(100000));
+
+    // 回写已经提交的位置（MP4回填mdat大小的情形），再回到末尾追加
+    const uint8_t patch[] = {'P', 'A', 'T', 'C', 'H'};
+    QCOMPARE(file->seek(10, SEEK_SET), int64_t(10));
+    QVERIFY(file->write(patch, sizeof(patch)));
+    std::copy(patch, patch + sizeof(patch), expected.begin() + 10);
+    QCOMPARE(file->seek(0, SEEK_END), int64_t(100000));
+    const uint8_t tail[] = {1, 2, 3};
+    QVERIFY(file->write(tail, sizeof(tail)));
+    expected.insert(expected.end(), tail, tail + sizeof(tail));
+    QCOMPARE(file->seek(1, SEEK_END), int64_t(-1));
+
+    QVERIFY(file->close());
+    QVERIFY(writer.waitIdle(5000));
+
+    QFile result(path);
+    QVERIFY(result.open(QIODevice::ReadOnly));
+    const QByteArray data = result.readAll();
+    QCOMPARE(data.size(), static_cast<int>(expected.size()));
+    QVERIFY(std::equal(expected.begin(), expected.end(), reinterpret_cast<const uint8_t*>(data.constData())));
+
+    const auto stats = writer.getStatistics();
+    qDebug() << "   写入" << stats.write_calls << "次（O_DIRECT" << stats.direct_writes << "次），同步"
+             << stats.syncs << "次";
+    QCOMPARE(stats.files_closed, uint64_t(1));
+    QCOMPARE(stats.write_errors, uint64_t(0));
+    QVERIFY(stats.syncs >= 1);
+    QCOMPARE(stats.pending_blocks, size_t(0));
+    QCOMPARE(stats.buffers_in_use, size_t(0));
+}
+
+void TestRecordingSink::testSegmentRotation()
+{
+    QDir dir(temp_dir_.path());
+    QVERIFY(dir.mkpath(QStringLiteral("rotation")));
+
+    media::RecordingSink::Config config;
+    config.directory = temp_dir_.filePath(QStringLiteral("rotation")).toStdString();
+    config.container = media::RecordingContainer::MPEGTS;
+    config.segment_duration_us = 5 * 1000000LL;
+    media::RecordingSink sink(config);
+
+    std::vector<media::RecordingSink::SegmentInfo> segments;
+    sink.setSegmentCallback([&](const media::RecordingSink::SegmentInfo& info) { segments.push_back(info); });
+
+    QVERIFY(feed(sink, 20.0));
+    sink.close();
+    QVERIFY(media::DiskWriter::instance().waitIdle(10000));
+
+    const auto stats = sink.getStatistics();
+    qDebug() << "   分段" << segments.size() << "个，写入" << stats.packets_written << "包，丢弃"
+             << stats.packets_dropped << "包";
+    QVERIFY(segments.size() >= 3);
+    QCOMPARE(stats.mux_errors, uint64_t(0));
+
+    double total_s = 0.0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const auto& segment = segments[i];
+        const QString path = QString::fromStdString(segment.path);
+        QVERIFY(segment.ok);
+        QCOMPARE(QFileInfo(path).size(), static_cast<qint64>(segment.bytes));
+
+        // 每个分段都能独立打开，从关键帧开始
+        int video_packets = 0;
+        const double duration_s = probeDuration(path, &video_packets);
+        qDebug() << "   " << QFileInfo(path).fileName() << "起点" << segment.start_us / 1e6 << "s，时长"
+                 << duration_s << "s";
+        QVERIFY(duration_s > 0.0);
+        QVERIFY(video_packets > 0);
+        if (i + 1 < segments.size()) {
+            QVERIFY(segment.duration_us >= 5 * 1000000LL - 100000);
+        }
+        total_s += segment.duration_us / 1e6;
+    }
+    QVERIFY(std::abs(total_s - 20.0) < 1.0);
+}
+
+void TestRecordingSink::testPreEventTrigger()
+{
+    QDir dir(temp_dir_.path());
+    QVERIFY(dir.mkpath(QStringLiteral("event")));
+
+    media::RecordingSink::Config config;
+    config.directory = temp_dir_.filePath(QStringLiteral("event")).toStdString();
+    config.container = media::RecordingContainer::FragmentedMP4;
+    config.mode = media::RecordingMode::Triggered;
+    config.segment_duration_us = 0;
+    config.pre_event_us = 3 * 1000000LL;
+    config.post_event_us = 2 * 1000000LL;
+    media::RecordingSink sink(config);
+
+    std::vector<media::RecordingSink::SegmentInfo> segments;
+    sink.setSegmentCallback([&](const media::RecordingSink::SegmentInfo& info) { segments.push_back(info); });
+
+    // 第10秒触发，另一个线程触发也只是置标志
+    bool triggered = false;
+    bool recording_before = true;
+    QVERIFY(feed(sink, 15.0, [&](double t) {
+        if (!triggered && t >= 10.0) {
+            recording_before = sink.isRecording();
+            std::thread([&sink]() { sink.trigger(); }).join();
+            triggered = true;
+        }
+    }));
+    const bool recording_after = sink.isRecording();
+    sink.close();
+    QVERIFY(media::DiskWriter::instance().waitIdle(10000));
+
+    QVERIFY(triggered);
+    QVERIFY(!recording_before);
+    QVERIFY(!recording_after);
+    QCOMPARE(segments.size(), size_t(1));
+
+    const auto& segment = segments.front();
+    const double start_s = segment.start_us / 1e6;
+    const double end_s = start_s + segment.duration_us / 1e6;
+    const double file_s = probeDuration(QString::fromStdString(segment.path));
+    const auto stats = sink.getStatistics();
+    qDebug() << "   事件录像" << start_s << "~" << end_s << "s，文件时长" << file_s << "s，预录溢出"
+             << stats.pre_event_overflows;
+
+    // 从事件前至少3秒处的关键帧开始，到事件后2秒结束
+    QVERIFY(segment.ok);
+    QVERIFY(start_s <= 7.05);
+    QVERIFY(start_s >= 2.0);
+    QVERIFY(end_s >= 11.8 && end_s <= 12.3);
+    QVERIFY(file_s >= (end_s - start_s) - 0.3);
+    QCOMPARE(stats.triggers, uint64_t(1));
+    QCOMPARE(stats.mux_errors, uint64_t(0));
+}
+
+void TestRecordingSink::testConcurrentSinks()
+{
+    constexpr int kSinks = 100;
+    constexpr int kThreads = 4;
+    constexpr double kSeconds = 6.0;
+
+    QDir dir(temp_dir_.path());
+    QVERIFY(dir.mkpath(QStringLiteral("concurrent")));
+
+    // 多路共用一个写入器，I/O线程数与路数无关
+    media::DiskWriter::Config writer_config;
+    writer_config.block_bytes = 256 * 1024;
+    media::DiskWriter writer(writer_config);
+
+    std::vector<std::unique_ptr<media::RecordingSink>> sinks;
+    std::mutex mutex;
+    std::vector<media::RecordingSink::SegmentInfo> segments;
+    for (int i = 0; i < kSinks; ++i) {
+        media::RecordingSink::Config config;
+        config.directory = temp_dir_.filePath(QStringLiteral("concurrent")).toStdString();
+        config.name_prefix = "cam" + std::to_string(i);
+        config.container = media::RecordingContainer::FragmentedMP4;
+        config.segment_duration_us = 2 * 1000000LL;
+        config.writer = &writer;
+        sinks.push_back(std::make_unique<media::RecordingSink>(config));
+        sinks.back()->setSegmentCallback([&](const media::RecordingSink::SegmentInfo& info) {
+            std::lock_guard<std::mutex> lock(mutex);
+            segments.push_back(info);
+        });
+    }
+
+    // 每个线程读一遍测试媒体，同一个包写给自己负责的几路
+    const QByteArray path = media_file_.toUtf8();
+    std::atomic<bool> failed{false};
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            AVFormatContext* input = nullptr;
+            if (avformat_open_input(&input, path.constData(), nullptr, nullptr) < 0) {
+                failed.store(true);
+                return;
+            }
+            avformat_find_stream_info(input, nullptr);
+            for (int i = t; i < kSinks; i += kThreads) {
+                if (!addStreams(*sinks[i], input)) {
+                    failed.store(true);
+                }
+            }
+            AVPacket* packet = av_packet_alloc();
+            while (av_read_frame(input, packet) >= 0) {
+                if (packetSeconds(input, packet) > kSeconds) {
+                    av_packet_unref(packet);
+                    break;
+                }
+                for (int i = t; i < kSinks; i += kThreads) {
+                    if (!sinks[i]->writePacket(packet)) {
+                        failed.store(true);
+                    }
+                }
+                av_packet_unref(packet);
+            }
+            av_packet_free(&packet);
+            avformat_close_input(&input);
+            for (int i = t; i < kSinks; i += kThreads) {
+                sinks[i]->close();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const qint64 submit_ms = timer.elapsed();
+    QVERIFY(writer.waitIdle(30000));
+    const qint64 total_ms = timer.elapsed();
+
+    QVERIFY(!failed.load());
+    const auto stats = writer.getStatistics();
+    const double mib = stats.bytes_written / (1024.0 * 1024.0);
+    qDebug() << "   " << kSinks << "路 x" << kSeconds << "s：提交" << submit_ms << "ms，落盘" << total_ms
+             << "ms，" << mib << "MiB，pwrite" << stats.write_calls << "次，缓冲等待" << stats.buffer_stalls << "次";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    QVERIFY(segments.size() >= static_cast<size_t>(kSinks * 2));
+    QCOMPARE(stats.files_closed, static_cast<uint64_t>(segments.size()));
+    QCOMPARE(stats.write_errors, uint64_t(0));
+    for (const auto& segment : segments) {
+        QVERIFY(segment.ok);
+        QCOMPARE(QFileInfo(QString::fromStdString(segment.path)).size(), static_cast<qint64>(segment.bytes));
+    }
+    // 抽查一个分段能播放
+    QVERIFY(probeDuration(QString::fromStdString(segments.front().path)) > 0.0);
+    // 大块写：平均每次pwrite远大于复用器的小块
+    QVERIFY(stats.write_calls > 0);
+    QVERIFY(stats.bytes_written / stats.write_calls >= 64 * 1024);
+}
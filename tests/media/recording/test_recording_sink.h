@@ -0,0 +1,43 @@
+#ifndef TEST_RECORDING_SINK_H
+#define TEST_RECORDING_SINK_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <functional>
+
+#include "media/recording/recording_sink.h"
+
+class TestRecordingSink : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 磁盘写入器
+    void testDiskWriterRoundTrip();
+
+    // 分段与预录
+    void testSegmentRotation();
+    void testPreEventTrigger();
+
+    // 多路并发
+    void testConcurrentSinks();
+
+private:
+    /**
+     * @brief 把测试媒体开头limit_s秒的数据包送进sink
+     * @param on_packet 每送一个包后调用，参数为包的时间（秒）
+     */
+    bool feed(media::RecordingSink& sink, double limit_s,
+              const std::function<void(double)>& on_packet = nullptr);
+
+    // 探测录好的文件：能否打开以及时长（秒）
+    double probeDuration(const QString& path, int* video_packets = nullptr);
+
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_RECORDING_SINK_H
@@ -0,0 +1,305 @@
+#include "test_frame_mailbox.h"
+
+#include <QQuickWindow>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+void TestFrameMailbox::initTestCase()
+{
+    qDebug() << "🖼️ 开始帧交接/节奏模块测试";
+    qDebug() << "   QT_QUICK_BACKEND =" << qgetenv("QT_QUICK_BACKEND");
+    qDebug() << "   QT_QPA_PLATFORM  =" << qgetenv("QT_QPA_PLATFORM");
+}
+
+ffmpeg::AVFrameSharedPtr TestFrameMailbox::makeFrame(int64_t pts, int width, int height)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    frame->pts = pts;
+    // 填充灰色画面
+    for (int plane = 0; plane < 3; ++plane) {
+        int plane_height = plane == 0 ? height : height / 2;
+        memset(frame->data[plane], 128, frame->linesize[plane] * plane_height);
+    }
+    return ffmpeg::AVFrameSharedPtr(frame, [](AVFrame* f) { av_frame_free(&f); });
+}
+
+void TestFrameMailbox::testLatestFrameWins()
+{
+    media::FrameMailbox mailbox;
+
+    bool is_new = true;
+    const auto& empty = mailbox.acquire(&is_new);
+    QVERIFY(!is_new);
+    QVERIFY(!empty.frame);
+
+    mailbox.publish(makeFrame(1), 100);
+    mailbox.publish(makeFrame(2), 200);
+    mailbox.publish(makeFrame(3), 300);
+    QVERIFY(mailbox.hasNewFrame());
+
+    const auto& latest = mailbox.acquire(&is_new);
+    QVERIFY(is_new);
+    QCOMPARE(latest.frame->pts, int64_t(3));
+    QCOMPARE(latest.sequence, uint64_t(3));
+    QCOMPARE(latest.publish_time_us, int64_t(300));
+
+    // 没有新帧时重复上一帧
+    const auto& repeated = mailbox.acquire(&is_new);
+    QVERIFY(!is_new);
+    QCOMPARE(repeated.frame->pts, int64_t(3));
+    QCOMPARE(mailbox.publishedCount(), uint64_t(3));
+}
+
+void TestFrameMailbox::testDroppedFrameReported()
+{
+    media::FrameMailbox mailbox;
+
+    QVERIFY(!mailbox.publish(makeFrame(1), 1));
+    QVERIFY(mailbox.publish(makeFrame(2), 2));   // 帧1未被取走
+    mailbox.acquire();
+    QVERIFY(!mailbox.publish(makeFrame(3), 3));
+}
+
+void TestFrameMailbox::testConcurrentHandoff()
+{
+    media::FrameMailbox mailbox;
+    const int64_t frame_count = 20000;
+    auto frame = makeFrame(0, 16, 16);
+
+    std::atomic<bool> done{false};
+    std::thread producer([&]() {
+        for (int64_t i = 1; i <= frame_count; ++i) {
+            // 共享同一块像素，仅用pts区分，避免测试被分配开销主导
+            auto ref = ffmpeg::AVFrameSharedPtr(av_frame_clone(frame.get()),
+                                                [](AVFrame* f) { av_frame_free(&f); });
+            ref->pts = i;
+            mailbox.publish(std::move(ref), i);
+        }
+        done.store(true);
+    });
+
+    uint64_t last_sequence = 0;
+    uint64_t received = 0;
+    while (true) {
+        bool finished = done.load();
+        bool is_new = false;
+        const auto& entry = mailbox.acquire(&is_new);
+        if (is_new) {
+            // 序号单调递增，且帧内容与序号一致（没有撕裂）
+            QVERIFY(entry.sequence > last_sequence);
+            QCOMPARE(entry.frame->pts, static_cast<int64_t>(entry.sequence));
+            QCOMPARE(entry.publish_time_us, static_cast<int64_t>(entry.sequence));
+            last_sequence = entry.sequence;
+            ++received;
+        }
+        if (finished && !mailbox.hasNewFrame()) {
+            break;
+        }
+    }
+    producer.join();
+
+    QCOMPARE(last_sequence, static_cast<uint64_t>(frame_count));
+    QVERIFY(received > 0);
+    qDebug() << "   并发交接:" << frame_count << "帧发布，" << received << "帧被取走";
+}
+
+void TestFrameMailbox::testLastSequenceCoversAcquired()
+{
+    // VideoItem::clear()在GUI线程读lastSequence，与生产者并发：
+    // 渲染线程已经取到的帧，序号不能大于之后读到的lastSequence，否则清空会漏掉它
+    media::FrameMailbox mailbox;
+    const int64_t frame_count = 200000;
+    auto frame = makeFrame(0, 16, 16);
+
+    std::atomic<bool> done{false};
+    std::thread producer([&]() {
+        for (int64_t i = 1; i <= frame_count; ++i) {
+            mailbox.publish(frame, i);
+        }
+        done.store(true);
+    });
+
+    uint64_t checks = 0;
+    uint64_t violations = 0;
+    while (!done.load()) {
+        const uint64_t acquired = mailbox.acquire().sequence;
+        if (acquired > mailbox.lastSequence()) {
+            ++violations;
+        }
+        ++checks;
+    }
+    producer.join();
+
+    QCOMPARE(violations, uint64_t(0));
+    QCOMPARE(mailbox.lastSequence(), static_cast<uint64_t>(frame_count));
+    qDebug() << "   清空序号:" << checks << "次检查";
+}
+
+void TestFrameMailbox::testPacerRepeatedFrames()
+{
+    media::FramePacer pacer;
+    pacer.setRefreshRate(60.0);
+    const int64_t vsync_us = pacer.refreshIntervalUs();
+
+    // 30fps内容在60Hz屏幕上：每帧显示两次
+    int64_t now = vsync_us;
+    for (int i = 0; i < 60; ++i) {
+        bool is_new = (i % 2) == 0;
+        pacer.onFrameSynced(is_new, (i / 2) * 2 * vsync_us);
+        pacer.onVsync(now);
+        now += vsync_us;
+    }
+
+    auto stats = pacer.getStatistics();
+    QCOMPARE(stats.vsync_count, uint64_t(60));
+    QCOMPARE(stats.presented_frames, uint64_t(30));
+    QCOMPARE(stats.repeated_frames, uint64_t(30));
+    QCOMPARE(stats.missed_vsyncs, uint64_t(0));
+    QVERIFY(stats.judder_ms < 0.5);
+}
+
+void TestFrameMailbox::testPacerMissedVsync()
+{
+    media::FramePacer pacer;
+    pacer.setRefreshRate(60.0);
+    const int64_t vsync_us = pacer.refreshIntervalUs();
+
+    pacer.onVsync(vsync_us);
+    pacer.onVsync(2 * vsync_us);
+    pacer.onVsync(5 * vsync_us);    // 错过两个vsync
+    pacer.onVsync(6 * vsync_us);
+
+    QCOMPARE(pacer.getStatistics().missed_vsyncs, uint64_t(2));
+
+    pacer.recordDroppedFrame();
+    QCOMPARE(pacer.getStatistics().dropped_frames, uint64_t(1));
+
+    pacer.reset();
+    QCOMPARE(pacer.getStatistics().vsync_count, uint64_t(0));
+}
+
+void TestFrameMailbox::testPacerJudder()
+{
+    media::FramePacer pacer;
+    pacer.setRefreshRate(60.0);
+    const int64_t vsync_us = pacer.refreshIntervalUs();
+
+    // 24fps内容在60Hz屏幕上：3:2交替显示，显示时长与发布间隔不一致
+    const int64_t frame_us = 1000000 / 24;
+    int64_t now = vsync_us;
+    for (int i = 0; i < 48; ++i) {
+        pacer.onFrameSynced(true, i * frame_us);
+        pacer.onVsync(now);
+        now += ((i % 2) == 0 ? 3 : 2) * vsync_us;
+    }
+
+    auto stats = pacer.getStatistics();
+    QCOMPARE(stats.presented_frames, uint64_t(48));
+    // 误差约为±8.3ms
+    QVERIFY(stats.judder_ms > 5.0);
+    QVERIFY(stats.judder_ms < 12.0);
+}
+
+void TestFrameMailbox::testVideoItemHeadless()
+{
+    QQuickWindow window;
+    window.resize(160, 120);
+
+    media::VideoItem item(window.contentItem());
+    item.setSize(QSizeF(160, 120));
+
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    QSignalSpy size_spy(&item, &media::VideoItem::frameSizeChanged);
+
+    // 模拟同步线程以约100fps送帧，速度高于大多数显示刷新率
+    std::atomic<bool> running{true};
+    std::thread producer([&]() {
+        int64_t pts = 0;
+        while (running.load()) {
+            item.presentFrame(makeFrame(pts++, 64, 48));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    QTRY_VERIFY_WITH_TIMEOUT(item.pacingSnapshot().presented_frames >= 10, 5000);
+    running.store(false);
+    producer.join();
+
+    QTRY_COMPARE(size_spy.count(), 1);
+    QCOMPARE(item.frameSize(), QSize(64, 48));
+
+    auto stats = item.pacingSnapshot();
+    QVERIFY(stats.vsync_count > 0);
+    QVERIFY(stats.refresh_rate > 0.0);
+
+    QVariantMap map = item.pacingStatistics();
+    QVERIFY(map.contains("judderMs"));
+    QVERIFY(map.value("presentedFrames").toULongLong() >= 10);
+
+    qDebug() << "   无头渲染:" << map;
+
+    item.clear();
+    QTRY_COMPARE(item.frameSize(), QSize());
+
+    // 清空不经过邮箱，之后生产者再送帧照常显示
+    const uint64_t presented = item.pacingSnapshot().presented_frames;
+    item.presentFrame(makeFrame(0, 64, 48));
+    QTRY_COMPARE(item.frameSize(), QSize(64, 48));
+    QTRY_VERIFY(item.pacingSnapshot().presented_frames > presented);
+}
+
+void TestFrameMailbox::testVideoItemClearRace()
+{
+    QQuickWindow window;
+    window.resize(160, 120);
+
+    media::VideoItem item(window.contentItem());
+    item.setSize(QSizeF(160, 120));
+
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    // GUI线程反复清空，同时同步线程持续送帧
+    std::atomic<bool> running{true};
+    std::thread producer([&]() {
+        int64_t pts = 0;
+        while (running.load()) {
+            item.presentFrame(makeFrame(pts++, 64, 48));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 1000) {
+        item.clear();
+        QTest::qWait(1);
+    }
+    running.store(false);
+    producer.join();
+
+    // 生产者停下后清空：之前发布的帧都不再显示
+    item.clear();
+    QTRY_COMPARE(item.frameSize(), QSize());
+    QTest::qWait(100);
+    const uint64_t presented = item.pacingSnapshot().presented_frames;
+    window.update();
+    QTest::qWait(100);
+    QCOMPARE(item.pacingSnapshot().presented_frames, presented);
+}
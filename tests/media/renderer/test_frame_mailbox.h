@@ -0,0 +1,37 @@
+#ifndef TEST_FRAME_MAILBOX_H
+#define TEST_FRAME_MAILBOX_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/renderer/frame_mailbox.h"
+#include "media/renderer/frame_pacer.h"
+#include "media/renderer/video_item.h"
+
+class TestFrameMailbox : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 三缓冲邮箱
+    void testLatestFrameWins();
+    void testDroppedFrameReported();
+    void testConcurrentHandoff();
+    void testLastSequenceCoversAcquired();
+
+    // 帧节奏统计
+    void testPacerRepeatedFrames();
+    void testPacerMissedVsync();
+    void testPacerJudder();
+
+    // 无头渲染（QT_QUICK_BACKEND=software + offscreen）
+    void testVideoItemHeadless();
+    void testVideoItemClearRace();
+
+private:
+    ffmpeg::AVFrameSharedPtr makeFrame(int64_t pts, int width = 64, int height = 48);
+};
+
+#endif // TEST_FRAME_MAILBOX_H
@@ -0,0 +1,593 @@
+#include "test_restream_server.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "media/decoder/ffmpeg_decoder.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+const QByteArray kHeaderEnd("\r\n\r\n");
+
+/**
+ * @brief 连接服务并发出HTTP请求
+ * @param receive_buffer 大于0时设置接收缓冲（模拟慢客户端）
+ */
+int connectClient(uint16_t port, const char* path, int receive_buffer = 0)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (receive_buffer > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    const std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 读到对端关闭（或超时）
+ */
+QByteArray readAll(int fd, int timeout_ms)
+{
+    QByteArray data;
+    char buffer[65536];
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeout_ms) {
+        pollfd entry{fd, POLLIN, 0};
+        if (poll(&entry, 1, 100) <= 0) {
+            continue;
+        }
+        const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        data.append(buffer, static_cast<int>(received));
+    }
+    return data;
+}
+
+QByteArray bodyOf(const QByteArray& response)
+{
+    const int end = response.indexOf(kHeaderEnd);
+    return end < 0 ? QByteArray() : response.mid(end + kHeaderEnd.size());
+}
+
+} // namespace
+
+void TestRestreamServer::initTestCase()
+{
+    qDebug() << "📡 开始本地转发服务测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+    QVERIFY(temp_dir_.isValid());
+
+    // 500个客户端两端共1000个描述符，默认软限制可能不够
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < 4096) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, 4096);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+bool TestRestreamServer::addStreams(media::RestreamServer& server)
+{
+    const QByteArray path = media_file_.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, path.constData(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    avformat_find_stream_info(input, nullptr);
+    bool added = false;
+    for (unsigned i = 0; i < input->nb_streams; ++i) {
+        const AVStream* stream = input->streams[i];
+        const AVMediaType type = stream->codecpar->codec_type;
+        if (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO) {
+            added = server.addStream(stream->index, stream->codecpar, stream->time_base) || added;
+        }
+    }
+    avformat_close_input(&input);
+    return added;
+}
+
+bool TestRestreamServer::addStreams(media::GopCache& cache)
+{
+    const QByteArray path = media_file_.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, path.constData(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    avformat_find_stream_info(input, nullptr);
+    const int video_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    const int audio_index = av_find_best_stream(input, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    bool added = video_index >= 0 && cache.addStream(video_index, input->streams[video_index]->time_base, true);
+    if (added && audio_index >= 0) {
+        cache.addStream(audio_index, input->streams[audio_index]->time_base, false);
+    }
+    avformat_close_input(&input);
+    return added;
+}
+
+int TestRestreamServer::feed(media::RestreamServer& server, double limit_s, double speed)
+{
+    return feed([&server](const AVPacket* packet, double, bool) { server.writePacket(packet); }, limit_s, speed);
+}
+
+int TestRestreamServer::feed(const PacketSink& sink, double limit_s, double speed)
+{
+    const QByteArray path = media_file_.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, path.constData(), nullptr, nullptr) < 0) {
+        return -1;
+    }
+    avformat_find_stream_info(input, nullptr);
+
+    int video_packets = 0;
+    AVPacket* packet = av_packet_alloc();
+    QElapsedTimer timer;
+    timer.start();
+    while (av_read_frame(input, packet) >= 0) {
+        const AVStream* stream = input->streams[packet->stream_index];
+        const int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        const double t = ts != AV_NOPTS_VALUE ? ts * av_q2d(stream->time_base) : 0.0;
+        if (t > limit_s) {
+            av_packet_unref(packet);
+            break;
+        }
+        if (speed > 0.0) {
+            const qint64 due_ms = static_cast<qint64>(t * 1000.0 / speed);
+            if (due_ms > timer.elapsed()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(due_ms - timer.elapsed()));
+            }
+        }
+        const bool video = stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+        if (video) {
+            video_packets++;
+        }
+        sink(packet, t, video);
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    return video_packets;
+}
+
+bool TestRestreamServer::waitStreaming(const media::RestreamServer& server, size_t count, int timeout_ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (server.getStatistics().clients_streaming < count) {
+        if (timer.elapsed() > timeout_ms) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+int TestRestreamServer::probeVideoPackets(const QByteArray& body, const QString& name)
+{
+    const QString path = temp_dir_.filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(body) != body.size()) {
+        return -1;
+    }
+    file.close();
+
+    const QByteArray file_path = path.toUtf8();
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, file_path.constData(), nullptr, nullptr) < 0) {
+        return -1;
+    }
+    avformat_find_stream_info(input, nullptr);
+    int videos = 0;
+    AVPacket* packet = av_packet_alloc();
+    while (av_read_frame(input, packet) >= 0) {
+        if (input->streams[packet->stream_index]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videos++;
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    return videos;
+}
+
+void TestRestreamServer::testSingleClientReceivesTs()
+{
+    media::RestreamServer server;
+    QVERIFY(addStreams(server));
+    QVERIFY2(server.start(), server.getLastError().c_str());
+    QVERIFY(server.port() != 0);
+
+    const int fd = connectClient(server.port(), "/stream.ts?camera=1");
+    QVERIFY(fd >= 0);
+    QVERIFY(waitStreaming(server, 1));
+
+    QByteArray response;
+    std::thread reader([&]() { response = readAll(fd, 20000); });
+    const int fed = feed(server, 10.0);
+    QVERIFY(server.waitIdle(10000));
+    server.stop();
+    reader.join();
+    close(fd);
+
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK"));
+    QVERIFY(response.contains("Content-Type: video/mp2t"));
+    const QByteArray body = bodyOf(response);
+    QVERIFY(!body.isEmpty());
+    QCOMPARE(body.size() % 188, 0);
+    QCOMPARE(static_cast<uint8_t>(body[0]), static_cast<uint8_t>(0x47));
+    // 从关键帧起步：开头几个TS包里有PAT（前面可能是SDT）
+    bool has_pat = false;
+    for (int offset = 0; offset + 188 <= body.size() && offset < 4 * 188; offset += 188) {
+        const int pid = ((static_cast<uint8_t>(body[offset + 1]) & 0x1f) << 8) |
+                        static_cast<uint8_t>(body[offset + 2]);
+        has_pat = has_pat || pid == 0;
+    }
+    QVERIFY(has_pat);
+
+    const media::RestreamServer::StatisticsSnapshot stats = server.getStatistics();
+    QCOMPARE(stats.bytes_sent, static_cast<uint64_t>(body.size()));
+    QCOMPARE(stats.keyframe_resyncs, static_cast<uint64_t>(0));
+    QVERIFY(stats.chunk_pool_hits > 0);
+
+    const int received = probeVideoPackets(body, "single.ts");
+    qDebug() << "   送入" << fed << "个视频包，客户端收到" << received << "个，" << body.size() << "字节";
+    QVERIFY(received >= fed - 1 && received <= fed);
+}
+
+void TestRestreamServer::testRejectsUnknownPath()
+{
+    media::RestreamServer server;
+    QVERIFY(addStreams(server));
+    QVERIFY(server.start());
+
+    const int fd = connectClient(server.port(), "/other.ts");
+    QVERIFY(fd >= 0);
+    const QByteArray response = readAll(fd, 5000);
+    close(fd);
+
+    QVERIFY(response.startsWith("HTTP/1.1 404"));
+    QCOMPARE(server.getStatistics().clients_rejected, static_cast<uint64_t>(1));
+    QCOMPARE(server.getStatistics().clients_streaming, static_cast<size_t>(0));
+    server.stop();
+}
+
+void TestRestreamServer::testSlowClientResyncs()
+{
+    media::RestreamServer::Config config;
+    config.client_queue_bytes = 128 * 1024;
+    config.send_buffer_bytes = 8 * 1024;
+    media::RestreamServer server(config);
+    QVERIFY(addStreams(server));
+    QVERIFY(server.start());
+
+    // 慢客户端只连不读，快客户端正常读
+    const int slow = connectClient(server.port(), "/stream.ts", 4096);
+    const int fast = connectClient(server.port(), "/stream.ts");
+    QVERIFY(slow >= 0 && fast >= 0);
+    QVERIFY(waitStreaming(server, 2));
+
+    QByteArray response;
+    std::thread reader([&]() { response = readAll(fast, 30000); });
+    const int fed = feed(server, 20.0, 20.0);
+
+    const media::RestreamServer::StatisticsSnapshot during = server.getStatistics();
+    QVERIFY(during.keyframe_resyncs > 0);
+    QVERIFY(during.chunks_dropped > 0);
+
+    // 慢客户端断开后剩下的数据都能发完
+    close(slow);
+    QVERIFY(server.waitIdle(10000));
+    server.stop();
+    reader.join();
+    close(fast);
+
+    const int received = probeVideoPackets(bodyOf(response), "fast.ts");
+    qDebug() << "   慢客户端重同步" << during.keyframe_resyncs << "次，丢块" << during.chunks_dropped
+             << "；快客户端收到" << received << "/" << fed << "个视频包";
+    QVERIFY(received >= fed - 1 && received <= fed);
+}
+
+void TestRestreamServer::testFanOut500Clients()
+{
+    const int client_count = 500;
+    media::RestreamServer::Config config;
+    config.max_clients = client_count;
+    media::RestreamServer server(config);
+    QVERIFY(addStreams(server));
+    QVERIFY(server.start());
+
+    std::vector<int> fds;
+    fds.reserve(client_count);
+    for (int i = 0; i < client_count; ++i) {
+        const int fd = connectClient(server.port(), "/stream.ts");
+        QVERIFY2(fd >= 0, strerror(errno));
+        fds.push_back(fd);
+    }
+    QVERIFY(waitStreaming(server, client_count, 10000));
+
+    // 一个线程poll所有客户端
+    std::vector<uint64_t> received(client_count, 0);
+    std::vector<QByteArray> heads(client_count);
+    std::thread reader([&]() {
+        std::vector<pollfd> entries;
+        for (int fd : fds) {
+            entries.push_back(pollfd{fd, POLLIN, 0});
+        }
+        char buffer[65536];
+        int open_count = client_count;
+        QElapsedTimer timer;
+        timer.start();
+        while (open_count > 0 && timer.elapsed() < 60000) {
+            if (poll(entries.data(), entries.size(), 100) <= 0) {
+                continue;
+            }
+            for (int i = 0; i < client_count; ++i) {
+                if (entries[i].fd < 0 || !(entries[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                const ssize_t n = recv(entries[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n > 0) {
+                    received[i] += static_cast<uint64_t>(n);
+                    if (heads[i].size() < 256) {
+                        heads[i].append(buffer, static_cast<int>(std::min<ssize_t>(n, 256)));
+                    }
+                } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    entries[i].fd = -1;
+                    open_count--;
+                }
+            }
+        }
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    const int fed = feed(server, 10.0);
+    QVERIFY(server.waitIdle(30000));
+    const qint64 elapsed_ms = timer.elapsed();
+    const media::RestreamServer::StatisticsSnapshot stats = server.getStatistics();
+    server.stop();
+    reader.join();
+    for (int fd : fds) {
+        close(fd);
+    }
+
+    QVERIFY(fed > 0);
+    QCOMPARE(stats.clients_accepted, static_cast<uint64_t>(client_count));
+    QCOMPARE(stats.keyframe_resyncs, static_cast<uint64_t>(0));
+
+    // 所有客户端同时加入，收到的字节完全相同
+    const QByteArray header = heads[0].left(heads[0].indexOf(kHeaderEnd) + kHeaderEnd.size());
+    QVERIFY(header.startsWith("HTTP/1.1 200 OK"));
+    const uint64_t body_bytes = received[0] - static_cast<uint64_t>(header.size());
+    QVERIFY(body_bytes > 0);
+    QCOMPARE(body_bytes % 188, static_cast<uint64_t>(0));
+    for (int i = 0; i < client_count; ++i) {
+        QCOMPARE(received[i], received[0]);
+        QVERIFY(heads[i].startsWith(header));
+    }
+    QCOMPARE(stats.bytes_sent, body_bytes * client_count);
+
+    qDebug() << "   " << client_count << "个客户端，每个" << body_bytes << "字节，共"
+             << stats.bytes_sent / (1024 * 1024) << "MiB，耗时" << elapsed_ms << "ms，sendmsg"
+             << stats.send_calls << "次";
+}
+
+void TestRestreamServer::testGopCacheKeepsLastGop()
+{
+    media::GopCache cache;
+    QVERIFY(addStreams(cache));
+
+    // 测试媒体每5秒一个关键帧：送到7秒时缓存的是5秒开始的GOP
+    size_t gop_videos = 0;
+    QVERIFY(feed([&](const AVPacket* packet, double, bool video) {
+        cache.push(packet);
+        if (video) {
+            gop_videos = (packet->flags & AV_PKT_FLAG_KEY) ? 1 : gop_videos + 1;
+        }
+    }, 7.0) > 0);
+
+    media::GopCache::Snapshot snapshot = cache.snapshot();
+    QVERIFY(snapshot.isValid());
+    QVERIFY(snapshot.packets.front()->flags & AV_PKT_FLAG_KEY);
+    QVERIFY(std::llabs(snapshot.keyframe_us - 5000000) < 200000);
+    QVERIFY(std::llabs(snapshot.newest_us - 7000000) < 200000);
+    QVERIFY(snapshot.video_packets > 0);
+    QCOMPARE(snapshot.video_packets, gop_videos);
+    QVERIFY(snapshot.packets.size() > snapshot.video_packets);   // 带着音频
+
+    media::GopCache::StatisticsSnapshot stats = cache.getStatistics();
+    QCOMPARE(stats.gops_started, static_cast<uint64_t>(2));
+    QCOMPARE(stats.overflows, static_cast<uint64_t>(0));
+    QCOMPARE(stats.cached_packets, snapshot.packets.size());
+    QCOMPARE(stats.cached_bytes, snapshot.bytes);
+
+    // 清空缓存后，快照持有的包仍然有效
+    cache.clear();
+    QVERIFY(!cache.snapshot().isValid());
+    for (const auto& packet : snapshot.packets) {
+        QVERIFY(packet->data != nullptr && packet->size > 0);
+    }
+    const size_t old_packets = snapshot.packets.size();
+
+    // 从头再送12秒：只留10秒开始的GOP；旧快照释放后包壳被复用
+    snapshot = media::GopCache::Snapshot{};
+    feed([&](const AVPacket* packet, double, bool) { cache.push(packet); }, 12.0);
+    snapshot = cache.snapshot();
+    QVERIFY(std::llabs(snapshot.keyframe_us - 10000000) < 200000);
+    stats = cache.getStatistics();
+    QCOMPARE(stats.gops_started, static_cast<uint64_t>(5));
+    QVERIFY(stats.pool_hits >= old_packets);
+}
+
+void TestRestreamServer::testGopCacheBudget()
+{
+    // 只缓存视频，字节上限远小于一个GOP：每个GOP都作废，不留没有关键帧的后半段
+    media::GopCache::Config config;
+    config.max_bytes = 64 * 1024;
+    config.include_audio = false;
+    media::GopCache cache(config);
+    QVERIFY(addStreams(cache));
+
+    feed([&](const AVPacket* packet, double, bool) { cache.push(packet); }, 7.0);
+    QVERIFY(!cache.snapshot().isValid());
+    media::GopCache::StatisticsSnapshot stats = cache.getStatistics();
+    QCOMPARE(stats.overflows, static_cast<uint64_t>(2));
+    QCOMPARE(stats.cached_bytes, static_cast<size_t>(0));
+
+    // 放宽上限后同样的数据能缓存，且没有音频包
+    media::GopCache::Config relaxed;
+    relaxed.include_audio = false;
+    media::GopCache video_only(relaxed);
+    QVERIFY(addStreams(video_only));
+    feed([&](const AVPacket* packet, double, bool) { video_only.push(packet); }, 7.0);
+    const media::GopCache::Snapshot snapshot = video_only.snapshot();
+    QVERIFY(snapshot.isValid());
+    QCOMPARE(snapshot.packets.size(), snapshot.video_packets);
+    QVERIFY(snapshot.bytes > config.max_bytes);
+}
+
+void TestRestreamServer::testNewClientPrimedFromGop()
+{
+    media::RestreamServer server;
+    QVERIFY(addStreams(server));
+    QVERIFY(server.start());
+
+    // 先送7秒，没有客户端；同时用GopCache记下最后一个GOP作为对照
+    media::GopCache cache;
+    QVERIFY(addStreams(cache));
+    QVERIFY(feed([&](const AVPacket* packet, double, bool) {
+        server.writePacket(packet);
+        cache.push(packet);
+    }, 7.0) > 0);
+    QVERIFY(server.waitIdle(5000));
+    QVERIFY(server.getStatistics().gop_cached_bytes > 0);
+
+    // 之后不再有新数据，新客户端也能立即从5秒的关键帧开始收到数据
+    QElapsedTimer timer;
+    timer.start();
+    const int fd = connectClient(server.port(), "/stream.ts");
+    QVERIFY(fd >= 0);
+    QVERIFY(waitStreaming(server, 1));
+    QVERIFY(server.waitIdle(5000));
+    const qint64 primed_ms = timer.elapsed();
+    server.stop();
+    const QByteArray response = readAll(fd, 5000);
+    close(fd);
+
+    const QByteArray body = bodyOf(response);
+    QVERIFY(!body.isEmpty());
+    QCOMPARE(body.size() % 188, 0);
+    QCOMPARE(server.getStatistics().clients_primed, static_cast<uint64_t>(1));
+
+    const size_t expected = cache.snapshot().video_packets;
+    const int received = probeVideoPackets(body, "primed.ts");
+    qDebug() << "   加入后" << primed_ms << "ms收到缓存的GOP：" << received << "/" << expected << "个视频包，"
+             << body.size() << "字节";
+    QVERIFY(received >= static_cast<int>(expected) - 1 && received <= static_cast<int>(expected));
+}
+
+void TestRestreamServer::benchmarkTimeToFirstFrame()
+{
+    const QByteArray path = media_file_.toUtf8();
+    AVFormatContext* input = nullptr;
+    QVERIFY(avformat_open_input(&input, path.constData(), nullptr, nullptr) >= 0);
+    avformat_find_stream_info(input, nullptr);
+    const int video_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    QVERIFY(video_index >= 0);
+    AVCodecParameters* codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_copy(codecpar, input->streams[video_index]->codecpar);
+    avformat_close_input(&input);
+
+    // 在GOP中的不同位置加入：不缓存要等到下一个关键帧；缓存时连续解码整个GOP追到直播点
+    qDebug() << "   加入时间  等关键帧(ms)  GOP包数  首帧(ms)  追到直播点(ms)";
+    for (double join_s : {5.5, 7.5, 9.5}) {
+        media::GopCache cache;
+        QVERIFY(addStreams(cache));
+        double next_keyframe_s = -1.0;
+        feed([&](const AVPacket* packet, double t, bool video) {
+            if (t <= join_s) {
+                cache.push(packet);
+            } else if (video && (packet->flags & AV_PKT_FLAG_KEY) && next_keyframe_s < 0.0) {
+                next_keyframe_s = t;
+            }
+        }, join_s + 6.0);
+        QVERIFY(next_keyframe_s > join_s);
+        const media::GopCache::Snapshot snapshot = cache.snapshot();
+        QVERIFY(snapshot.isValid());
+
+        media::FFmpegVideoDecoder decoder;
+        QVERIFY(decoder.initialize(codecpar));
+        AVFrame* frame = av_frame_alloc();
+        QElapsedTimer timer;
+        timer.start();
+        qint64 first_frame_ms = -1;
+        size_t decoded = 0;
+        auto drain = [&]() {
+            while (decoder.receiveFrame(frame)) {
+                if (first_frame_ms < 0) {
+                    first_frame_ms = timer.elapsed();
+                }
+                decoded++;
+                av_frame_unref(frame);
+            }
+        };
+        for (const auto& packet : snapshot.packets) {
+            if (packet->stream_index == video_index) {
+                decoder.sendPacket(packet.get());
+                drain();
+            }
+        }
+        decoder.sendPacket(nullptr);
+        drain();
+        const qint64 live_ms = timer.elapsed();
+        av_frame_free(&frame);
+
+        const qint64 wait_ms = static_cast<qint64>((next_keyframe_s - join_s) * 1000.0);
+        qDebug() << "   " << join_s << "s    " << wait_ms << "        " << snapshot.video_packets << "     "
+                 << first_frame_ms << "      " << live_ms;
+        QVERIFY(decoded + 1 >= snapshot.video_packets);
+        QVERIFY(first_frame_ms >= 0 && first_frame_ms < wait_ms);
+    }
+    avcodec_parameters_free(&codecpar);
+}
@@ -0,0 +1,63 @@
+#ifndef TEST_RESTREAM_SERVER_H
+#define TEST_RESTREAM_SERVER_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <functional>
+
+#include "media/restream/gop_cache.h"
+#include "media/restream/restream_server.h"
+
+class TestRestreamServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 单客户端
+    void testSingleClientReceivesTs();
+    void testRejectsUnknownPath();
+
+    // 慢客户端隔离
+    void testSlowClientResyncs();
+
+    // 扇出
+    void testFanOut500Clients();
+
+    // GOP缓存
+    void testGopCacheKeepsLastGop();
+    void testGopCacheBudget();
+    void testNewClientPrimedFromGop();
+
+    // 基准：加入直播的首帧时间
+    void benchmarkTimeToFirstFrame();
+
+private:
+    // 数据包、以秒计的时间戳、是否视频
+    using PacketSink = std::function<void(const AVPacket*, double, bool)>;
+
+    // 按测试媒体的音视频流建立输出流
+    bool addStreams(media::RestreamServer& server);
+    bool addStreams(media::GopCache& cache);
+
+    /**
+     * @brief 把测试媒体开头limit_s秒的音视频数据包送进sink
+     * @param speed 相对实时的送包速度，<=0不限速
+     * @return 送入的视频包数，打不开时返回-1
+     */
+    int feed(const PacketSink& sink, double limit_s, double speed = 0.0);
+    int feed(media::RestreamServer& server, double limit_s, double speed = 0.0);
+
+    // 等到正在接收流的客户端达到count
+    bool waitStreaming(const media::RestreamServer& server, size_t count, int timeout_ms = 5000);
+
+    // 去掉HTTP响应头后写成文件，统计其中的视频包数
+    int probeVideoPackets(const QByteArray& body, const QString& name);
+
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_RESTREAM_SERVER_H
@@ -0,0 +1,258 @@
+#include "test_snapshot_service.h"
+#include "media/renderer/video_item.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+void TestSnapshotService::initTestCase()
+{
+    qDebug() << "📸 开始截图服务测试";
+}
+
+ffmpeg::AVFrameSharedPtr TestSnapshotService::makeFrame(int width, int height)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    // 水平亮度渐变 + 灰色色度
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < width; ++x) {
+            row[x] = static_cast<uint8_t>(16 + x * 219 / width);
+        }
+    }
+    for (int plane = 1; plane < 3; ++plane) {
+        memset(frame->data[plane], 128, frame->linesize[plane] * (height / 2));
+    }
+    return ffmpeg::AVFrameSharedPtr(frame, [](AVFrame* f) { av_frame_free(&f); });
+}
+
+void TestSnapshotService::testEncodeJpegAndPng()
+{
+    media::SnapshotService service;
+    auto frame = makeFrame(320, 240);
+    QVERIFY(frame);
+
+    std::mutex mutex;
+    std::vector<media::SnapshotService::Result> results;
+    auto collect = [&](const media::SnapshotService::Result& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(result);
+    };
+
+    media::SnapshotService::Request jpeg;
+    jpeg.frame = frame;
+    jpeg.format = media::SnapshotService::ImageFormat::JPEG;
+    jpeg.callback = collect;
+    QVERIFY(service.submit(jpeg) != 0);
+
+    media::SnapshotService::Request png = jpeg;
+    png.format = media::SnapshotService::ImageFormat::PNG;
+    QVERIFY(service.submit(png) != 0);
+
+    QVERIFY(service.waitIdle(5000));
+    QCOMPARE(results.size(), size_t(2));
+
+    for (const auto& result : results) {
+        QVERIFY2(result.success, result.error.c_str());
+        QVERIFY(result.data && result.data->size() > 8);
+        QCOMPARE(result.width, 320);
+        QCOMPARE(result.height, 240);
+        const uint8_t* bytes = result.data->data();
+        if (result.format == media::SnapshotService::ImageFormat::JPEG) {
+            // SOI ... EOI
+            QCOMPARE(bytes[0], uint8_t(0xFF));
+            QCOMPARE(bytes[1], uint8_t(0xD8));
+            QCOMPARE(result.data->back(), uint8_t(0xD9));
+        } else {
+            QCOMPARE(bytes[0], uint8_t(0x89));
+            QCOMPARE(bytes[1], uint8_t('P'));
+            QImage image = QImage::fromData(result.data->data(), static_cast<int>(result.data->size()), "PNG");
+            QCOMPARE(image.size(), QSize(320, 240));
+            // 渐变方向保留：左暗右亮
+            QVERIFY(qGray(image.pixel(10, 120)) < qGray(image.pixel(310, 120)));
+        }
+    }
+
+    const auto stats = service.getStatistics();
+    QCOMPARE(stats.completed, uint64_t(2));
+    QCOMPARE(stats.failed, uint64_t(0));
+}
+
+void TestSnapshotService::testWriteFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("shot.PNG"));
+    QVERIFY(media::SnapshotService::formatForPath(path.toStdString()) == media::SnapshotService::ImageFormat::PNG);
+    QVERIFY(media::SnapshotService::formatForPath("a/b.c/shot") == media::SnapshotService::ImageFormat::JPEG);
+
+    media::SnapshotService service;
+    media::SnapshotService::Request request;
+    request.frame = makeFrame(160, 120);
+    request.path = path.toStdString();
+    request.format = media::SnapshotService::formatForPath(request.path);
+    size_t encoded_size = 0;
+    request.callback = [&encoded_size](const media::SnapshotService::Result& result) {
+        encoded_size = result.data ? result.data->size() : 0;
+    };
+    QVERIFY(service.submit(std::move(request)) != 0);
+    QVERIFY(service.waitIdle(5000));
+
+    QFile file(path);
+    QVERIFY(file.exists());
+    QCOMPARE(static_cast<size_t>(file.size()), encoded_size);
+    QVERIFY(!QFile::exists(path + QStringLiteral(".part")));
+
+    // 目录不存在：失败并带错误信息
+    media::SnapshotService::Request bad;
+    bad.frame = makeFrame(160, 120);
+    bad.path = dir.filePath(QStringLiteral("missing/shot.jpg")).toStdString();
+    std::string error;
+    bad.callback = [&error](const media::SnapshotService::Result& result) { error = result.error; };
+    QVERIFY(service.submit(std::move(bad)) != 0);
+    QVERIFY(service.waitIdle(5000));
+    QVERIFY(!error.empty());
+    QCOMPARE(service.getStatistics().failed, uint64_t(1));
+}
+
+void TestSnapshotService::testFrameReferenceReleased()
+{
+    media::SnapshotService service;
+    auto frame = makeFrame(640, 360);
+    const uint8_t* pixels = frame->data[0];
+
+    // 入队只增加引用计数，不复制像素
+    std::atomic<long> use_count_in_callback{0};
+    media::SnapshotService::Request request;
+    request.frame = frame;
+    request.callback = [&](const media::SnapshotService::Result&) {
+        use_count_in_callback = frame.use_count();
+    };
+    QVERIFY(service.submit(std::move(request)) != 0);
+    QVERIFY(service.waitIdle(5000));
+
+    QCOMPARE(frame->data[0], pixels);
+    QCOMPARE(use_count_in_callback.load(), 1L);  // 回调之前已经释放
+    QCOMPARE(frame.use_count(), 1L);
+}
+
+void TestSnapshotService::testBurstDoesNotBlockSubmitter()
+{
+    media::SnapshotService::Config config;
+    config.worker_count = 2;
+    config.max_pending = 16;
+    config.max_pending_per_stream = 4;
+    media::SnapshotService service(config);
+
+    auto frame = makeFrame(3840, 2160);
+    QVERIFY(frame);
+
+    // 8路流各连拍10张：每路最多4张在处理，其余被拒绝
+    const int streams = 8;
+    const int burst = 10;
+    std::atomic<int> done{0};
+    int accepted = 0;
+    qint64 max_submit_ns = 0;
+    QElapsedTimer timer;
+    for (int shot = 0; shot < burst; ++shot) {
+        for (int stream = 1; stream <= streams; ++stream) {
+            media::SnapshotService::Request request;
+            request.frame = frame;
+            request.stream_id = stream;
+            request.callback = [&done](const media::SnapshotService::Result&) { done++; };
+            timer.start();
+            if (service.submit(std::move(request)) != 0) {
+                accepted++;
+            }
+            max_submit_ns = std::max(max_submit_ns, timer.nsecsElapsed());
+        }
+    }
+    QVERIFY(service.pendingCount() <= config.max_pending);
+    QVERIFY(service.waitIdle(60000));
+
+    const auto stats = service.getStatistics();
+    qDebug() << "   4K连拍:" << accepted << "张接受," << stats.rejected << "张拒绝"
+             << "| 提交最长" << max_submit_ns / 1000.0 << "us"
+             << "| 平均编码" << stats.avg_encode_ms << "ms, 最长排队" << stats.max_queue_ms << "ms";
+    QCOMPARE(done.load(), accepted);
+    QCOMPARE(stats.completed, uint64_t(accepted));
+    QCOMPARE(stats.submitted + stats.rejected, uint64_t(streams * burst));
+    QVERIFY(stats.rejected > 0);
+    QVERIFY(accepted >= static_cast<int>(config.max_pending));
+    // 提交方只做一次入队，4K编码耗时不会落到提交线程上
+    QVERIFY(max_submit_ns < 5 * 1000 * 1000);
+    QCOMPARE(frame.use_count(), 1L);
+}
+
+void TestSnapshotService::testCancelStream()
+{
+    media::SnapshotService::Config config;
+    config.worker_count = 1;
+    media::SnapshotService service(config);
+
+    auto frame = makeFrame(1920, 1080);
+    std::atomic<int> callbacks_a{0};
+    std::atomic<int> callbacks_b{0};
+    for (int i = 0; i < 6; ++i) {
+        media::SnapshotService::Request a;
+        a.frame = frame;
+        a.stream_id = 1;
+        a.callback = [&callbacks_a](const media::SnapshotService::Result&) { callbacks_a++; };
+        service.submit(std::move(a));
+
+        media::SnapshotService::Request b;
+        b.frame = frame;
+        b.stream_id = 2;
+        b.callback = [&callbacks_b](const media::SnapshotService::Result&) { callbacks_b++; };
+        service.submit(std::move(b));
+    }
+
+    // cancel返回后该路不再有回调
+    service.cancel(1);
+    const int after_cancel = callbacks_a.load();
+    QVERIFY(service.waitIdle(30000));
+    QCOMPARE(callbacks_a.load(), after_cancel);
+    QCOMPARE(callbacks_b.load(), 6);
+    QVERIFY(service.getStatistics().cancelled > 0);
+    QCOMPARE(frame.use_count(), 1L);
+}
+
+void TestSnapshotService::testVideoItemSaveSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    media::VideoItem item;
+    QCOMPARE(item.saveSnapshot(dir.filePath(QStringLiteral("empty.jpg"))), qulonglong(0));
+
+    item.presentFrame(makeFrame(320, 180));
+    QSignalSpy spy(&item, &media::VideoItem::snapshotSaved);
+    const QString path = dir.filePath(QStringLiteral("item.jpg"));
+    const qulonglong id = item.saveSnapshot(QUrl::fromLocalFile(path).toString());
+    QVERIFY(id != 0);
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 5000);
+    const QList<QVariant> args = spy.takeFirst();
+    QCOMPARE(args.at(0).toULongLong(), id);
+    QCOMPARE(args.at(1).toString(), path);
+    QVERIFY2(args.at(2).toBool(), qPrintable(args.at(3).toString()));
+    QVERIFY(QFile::exists(path));
+}
@@ -0,0 +1,32 @@
+#ifndef TEST_SNAPSHOT_SERVICE_H
+#define TEST_SNAPSHOT_SERVICE_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/snapshot/snapshot_service.h"
+
+class TestSnapshotService : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 编码与写文件
+    void testEncodeJpegAndPng();
+    void testWriteFile();
+    void testFrameReferenceReleased();
+
+    // 突发与多路
+    void testBurstDoesNotBlockSubmitter();
+    void testCancelStream();
+
+    // QML入口
+    void testVideoItemSaveSnapshot();
+
+private:
+    ffmpeg::AVFrameSharedPtr makeFrame(int width, int height);
+};
+
+#endif // TEST_SNAPSHOT_SERVICE_H
@@ -0,0 +1,65 @@
+#ifndef TEST_SYNTHETIC_MEDIA_H
+#define TEST_SYNTHETIC_MEDIA_H
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <vector>
+
+#include "media/synthetic/loopback_media_server.h"
+#include "media/synthetic/synthetic_media.h"
+#include "media/synthetic/synthetic_pattern.h"
+
+class TestSyntheticMedia : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 测试图案
+    void testStampRoundTrip();
+    void testPatternDeterministic();
+    void testAudioToneContinuous();
+
+    // 参数矩阵
+    void testMatrixExpand();
+    void testParseCodec();
+
+    // 生成
+    void testGenerateDecodesFrameStamps();
+    void testGenerateBFrameGop();
+    void testEnsureReusesFile();
+
+    // 回环服务
+    void testLoopbackHttp();
+    void testLoopbackUdp();
+    void testLoopbackRtsp();
+
+private:
+    /**
+     * @brief 解码结果：显示顺序的帧号戳（读不出为-1）和关键帧在解码顺序中的位置
+     */
+    struct DecodeResult {
+        std::vector<int64_t> stamps;
+        std::vector<int> keyframe_packets;
+        int video_packets = 0;
+        int audio_packets = 0;
+        int b_frames = 0;
+    };
+
+    /**
+     * @brief 打开url解码视频，最多max_frames帧或timeout_ms
+     */
+    bool decode(const QString& url, DecodeResult* result, int max_frames = 0, int timeout_ms = 10000);
+
+    // 从回环服务读流，校验帧号戳连续（跨循环回到0）
+    void checkLoopback(media::LoopbackMediaServer::Protocol protocol, bool allow_loss);
+
+    media::SyntheticMediaGenerator::Spec smallSpec() const;
+
+    QTemporaryDir temp_dir_;
+    QString loop_file_;     // 回环服务测试共用的短文件
+};
+
+#endif // TEST_SYNTHETIC_MEDIA_H
@@ -0,0 +1,196 @@
+#include "test_thumbnail_generator.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <set>
+
+void TestThumbnailGenerator::initTestCase()
+{
+    qDebug() << "🖼️ 开始缩略图模块测试";
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+    qDebug() << "   测试媒体:" << media_file_;
+}
+
+void TestThumbnailGenerator::testProgressiveOrder()
+{
+    for (int count : {1, 2, 7, 100, 128, 129}) {
+        auto order = media::ThumbnailGenerator::progressiveOrder(count);
+        QCOMPARE(static_cast<int>(order.size()), count);
+
+        // 每个索引恰好一次
+        std::set<int> unique(order.begin(), order.end());
+        QCOMPARE(static_cast<int>(unique.size()), count);
+        QCOMPARE(*unique.begin(), 0);
+        QCOMPARE(*unique.rbegin(), count - 1);
+    }
+
+    // 前几张均匀覆盖：100张时前4张为0/64/32/96
+    auto order = media::ThumbnailGenerator::progressiveOrder(100);
+    QCOMPARE(order[0], 0);
+    QCOMPARE(order[1], 64);
+    QCOMPARE(order[2], 32);
+    QCOMPARE(order[3], 96);
+}
+
+void TestThumbnailGenerator::testCacheEviction()
+{
+    media::ThumbnailGenerator::ThumbnailCache::Config config;
+    config.l1_capacity = 2;
+    config.l2_capacity = 2;
+    config.l3_capacity = 2;
+    config.enable_compression = false;
+    config.enable_prefetch = false;
+    config.cleanup_interval_ms = 0;
+    media::ThumbnailGenerator::ThumbnailCache cache(config);
+
+    cache.put("a", std::vector<uint8_t>(4, 1), 4);
+    cache.put("b", std::vector<uint8_t>(4, 2), 4);
+    QVERIFY(cache.get("a"));            // a变为最近使用
+    cache.put("c", std::vector<uint8_t>(4, 3), 4);
+
+    // LRU淘汰b，而不是插入一个默认键
+    QVERIFY(cache.contains("a"));
+    QVERIFY(!cache.contains("b"));
+    QVERIFY(cache.contains("c"));
+    QVERIFY(!cache.contains(""));
+    QCOMPARE(std::get<0>(cache.getCacheSizes()), size_t(2));
+}
+
+void TestThumbnailGenerator::testGenerateStrip()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+
+    media::ThumbnailGenerator::Config config;
+    config.count = 20;
+    config.thumb_width = 160;
+    media::ThumbnailGenerator generator(config);
+
+    std::atomic<int> callbacks{0};
+    generator.setThumbnailCallback([&](int) { callbacks.fetch_add(1); });
+
+    QVERIFY(generator.start(media_file_.toStdString()));
+    QTRY_VERIFY_WITH_TIMEOUT(!generator.isRunning(), 30000);
+
+    auto stats = generator.getStatistics();
+    qDebug() << "   首张耗时(ms):" << stats.first_thumbnail_ms
+             << "总耗时(ms):" << stats.total_ms
+             << "生成:" << stats.generated << "失败:" << stats.failed;
+
+    QCOMPARE(generator.readyCount(), config.count);
+    QCOMPARE(callbacks.load(), config.count);
+    QVERIFY(stats.first_thumbnail_ms > 0.0);
+    // 每张缩略图只解一个关键帧
+    QVERIFY(stats.keyframes_decoded <= static_cast<uint64_t>(config.count));
+
+    auto thumbnail = generator.getThumbnail(config.count / 2);
+    QVERIFY(thumbnail.isValid());
+    QCOMPARE(thumbnail.width, 160);
+    QVERIFY(thumbnail.height > 0 && thumbnail.height % 2 == 0);
+    QCOMPARE(thumbnail.pixels->size(), static_cast<size_t>(thumbnail.stride) * thumbnail.height);
+
+    // 时间点单调递增
+    QVERIFY(generator.timestampOf(1) > generator.timestampOf(0));
+}
+
+void TestThumbnailGenerator::testLongFileFirstThumbnail()
+{
+    // 2小时的合成文件：10秒一个关键帧，每秒1帧，生成只需几秒
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    media::SyntheticMediaGenerator::Spec spec;
+    spec.codec = media::EncoderCodec::Mpeg4;
+    spec.width = 160;
+    spec.height = 96;
+    spec.frame_rate = {1, 1};
+    spec.duration_s = 2 * 3600.0;
+    spec.gop_size = 10;
+    spec.max_b_frames = 0;
+    spec.noise = 0;
+    spec.audio = false;
+    media::SyntheticMediaGenerator synthetic;
+    media::SyntheticMediaGenerator::Result input;
+    QVERIFY2(synthetic.ensure(spec, dir.path().toStdString(), &input), synthetic.getLastError().c_str());
+
+    media::ThumbnailGenerator::Config config;
+    config.count = 100;
+    media::ThumbnailGenerator generator(config);
+    QVERIFY(generator.start(input.path));
+    QTRY_VERIFY_WITH_TIMEOUT(!generator.isRunning(), 60000);
+
+    const auto stats = generator.getStatistics();
+    qDebug() << "   2小时文件: 首张耗时(ms):" << stats.first_thumbnail_ms << "总耗时(ms):" << stats.total_ms
+             << "关键帧解码:" << stats.keyframes_decoded << "首张前:" << stats.first_thumbnail_keyframes;
+
+    // 首张只取决于seek和一次关键帧解码，与文件长度无关：每个工作线程最多各解一帧
+    QCOMPARE(generator.readyCount(), config.count);
+    QVERIFY(stats.first_thumbnail_keyframes >= 1);
+    QVERIFY(stats.first_thumbnail_keyframes <= static_cast<uint64_t>(config.worker_count));
+    QVERIFY(stats.keyframes_decoded <= static_cast<uint64_t>(config.count));
+    // 时间点按整个文件时长分布：中间一张落在1小时之后
+    QVERIFY(generator.timestampOf(config.count / 2) > 3000LL * 1000000);
+}
+
+void TestThumbnailGenerator::testCacheHitOnRestart()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+
+    media::ThumbnailGenerator::Config config;
+    config.count = 8;
+    auto cache = std::make_shared<media::ThumbnailGenerator::ThumbnailCache>();
+
+    {
+        media::ThumbnailGenerator first(config, cache);
+        QVERIFY(first.start(media_file_.toStdString()));
+        QTRY_VERIFY_WITH_TIMEOUT(!first.isRunning(), 30000);
+        QCOMPARE(first.getStatistics().cache_hits, uint64_t(0));
+    }
+
+    media::ThumbnailGenerator second(config, cache);
+    QVERIFY(second.start(media_file_.toStdString()));
+    QTRY_VERIFY_WITH_TIMEOUT(!second.isRunning(), 30000);
+
+    auto stats = second.getStatistics();
+    QCOMPARE(stats.cache_hits, uint64_t(config.count));
+    QCOMPARE(stats.generated, uint64_t(0));
+    QCOMPARE(second.readyCount(), config.count);
+}
+
+void TestThumbnailGenerator::testImageProvider()
+{
+    if (!QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体文件不存在");
+    }
+
+    media::ThumbnailService service;
+    media::ThumbnailImageProvider provider(&service);
+
+    QSignalSpy ready_spy(&service, &media::ThumbnailService::thumbnailReady);
+    service.setCount(10);
+    service.setSource(media_file_);
+    QTRY_COMPARE_WITH_TIMEOUT(service.readyCount(), 10, 30000);
+    QTRY_COMPARE(ready_spy.count(), 10);
+
+    const QString url = service.thumbnailUrl(3);
+    QVERIFY(url.startsWith("image://thumbnails/"));
+
+    QSize size;
+    QImage image = provider.requestImage(url.mid(QStringLiteral("image://thumbnails/").size()), &size, QSize());
+    QVERIFY(!image.isNull());
+    QCOMPARE(size, service.thumbnailSize());
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+
+    // 未知索引返回占位图而不是空图
+    QImage placeholder = provider.requestImage("1/999", &size, QSize(80, 45));
+    QCOMPARE(placeholder.size(), QSize(80, 45));
+
+    QCOMPARE(service.indexAt(0.0), 0);
+    QCOMPARE(service.indexAt(1.0), 9);
+}
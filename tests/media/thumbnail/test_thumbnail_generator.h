@@ -0,0 +1,32 @@
+#ifndef TEST_THUMBNAIL_GENERATOR_H
+#define TEST_THUMBNAIL_GENERATOR_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "media/thumbnail/thumbnail_generator.h"
+#include "media/thumbnail/thumbnail_service.h"
+#include "media/synthetic/synthetic_media.h"
+
+class TestThumbnailGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 渐进顺序与缓存
+    void testProgressiveOrder();
+    void testCacheEviction();
+
+    // 真实文件生成
+    void testGenerateStrip();
+    void testLongFileFirstThumbnail();
+    void testCacheHitOnRestart();
+    void testImageProvider();
+
+private:
+    QString media_file_;
+};
+
+#endif // TEST_THUMBNAIL_GENERATOR_H
@@ -0,0 +1,485 @@
+#include "test_allocation_trace.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "memory/allocation_trace.h"
+#include "memory/memory_pool.h"
+#include "memory/memory_tracker.h"
+#include "memory/trace_replayer.h"
+
+#ifdef FFMPEG_AVAILABLE
+#include <deque>
+
+#include "media/allocator/ffmpeg_allocator/buffer_tracking.h"
+#include "media/decoder/ffmpeg_decoder.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+#endif
+
+namespace {
+
+using Event = AllocationTrace::Event;
+
+std::vector<Event> decodeAll(const AllocationTrace& trace) {
+    std::vector<Event> events;
+    trace.forEach([&events](const Event& event) {
+        events.push_back(event);
+        return true;
+    });
+    return events;
+}
+
+MemoryTracker::Config quietTrackerConfig() {
+    MemoryTracker::Config config;
+    config.enable_history = false;
+    return config;
+}
+
+/**
+ * @brief 基于malloc的计数分配器：检查对齐，结束时应全部归还
+ */
+class CountingAllocator : public TraceReplayer::Allocator {
+public:
+    std::string name() const override { return "counting"; }
+
+    void* allocate(size_t size, size_t alignment) override {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, std::max<size_t>(alignment, sizeof(void*)), size ? size : 1) != 0) {
+            return nullptr;
+        }
+        if (alignment && reinterpret_cast<uintptr_t>(ptr) % alignment != 0) {
+            misaligned.fetch_add(1);
+        }
+        live.fetch_add(1);
+        allocations.fetch_add(1);
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t, size_t) override {
+        live.fetch_sub(1);
+        std::free(ptr);
+    }
+
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> allocations{0};
+    std::atomic<int64_t> misaligned{0};
+};
+
+class PoolAllocator : public TraceReplayer::Allocator {
+public:
+    std::string name() const override { return "memory_pool"; }
+    void* allocate(size_t size, size_t alignment) override { return pool.allocate(size, alignment); }
+    void deallocate(void* ptr, size_t, size_t) override { pool.deallocate(ptr); }
+    double fragmentation() const override { return pool.getFragmentationRate(); }
+
+    MemoryPool pool;
+};
+
+/**
+ * @brief 三线程流水线：0号线程分配包，1号线程释放包并分配帧，2号线程释放帧（最多4帧在途）
+ */
+AllocationTrace makePipelineTrace(int packets) {
+    AllocationTrace trace;
+    std::vector<uint64_t> frames;
+    size_t released = 0;
+    for (int i = 0; i < packets; ++i) {
+        const uint64_t packet = trace.addAllocation(0, 2000 + static_cast<uint64_t>(i % 17) * 1500, 64);
+        trace.addFree(1, packet);
+        frames.push_back(trace.addAllocation(1, 640 * 360 * 3 / 2, 64));
+        if (frames.size() - released > 4) {
+            trace.addFree(2, frames[released++]);
+        }
+    }
+    while (released + 1 < frames.size()) {
+        trace.addFree(2, frames[released++]);
+    }
+    return trace;       // 最后一帧保持存活（对应渲染器还持有的帧）
+}
+
+} // namespace
+
+void TestAllocationTrace::initTestCase()
+{
+    QVERIFY(temp_dir_.isValid());
+#ifdef TEST_MEDIA_FILE
+    media_file_ = QStringLiteral(TEST_MEDIA_FILE);
+#endif
+}
+
+void TestAllocationTrace::testEncodeDecodeRoundTrip()
+{
+    AllocationTrace trace;
+    const uint64_t a = trace.addAllocation(0, 0, 0);
+    const uint64_t b = trace.addAllocation(3, 127, 16);
+    const uint64_t c = trace.addAllocation(200, 3110400, 64);      // 线程号超出标记字节
+    const uint64_t d = trace.addAllocation(1, 1ull << 40, 48);       // 非2的幂向下取整
+    trace.addFree(200, b);
+    trace.addFree(0, d);
+    trace.addFree(3, a);
+    trace.addFree(1, 99);                                            // 未知编号被忽略
+
+    QCOMPARE(trace.eventCount(), uint64_t(7));
+    QCOMPARE(trace.allocationCount(), uint64_t(4));
+    QCOMPARE(trace.threadCount(), uint32_t(201));
+
+    const std::vector<Event> events = decodeAll(trace);
+    QCOMPARE(events.size(), size_t(7));
+
+    QCOMPARE(events[0].type, Event::Type::Allocate);
+    QCOMPARE(events[0].id, a);
+    QCOMPARE(events[0].size, uint64_t(0));
+    QCOMPARE(events[0].alignment, uint32_t(0));
+
+    QCOMPARE(events[1].thread, uint32_t(3));
+    QCOMPARE(events[1].size, uint64_t(127));
+    QCOMPARE(events[1].alignment, uint32_t(16));
+
+    QCOMPARE(events[2].id, c);
+    QCOMPARE(events[2].thread, uint32_t(200));
+    QCOMPARE(events[2].size, uint64_t(3110400));
+    QCOMPARE(events[2].alignment, uint32_t(64));
+
+    QCOMPARE(events[3].size, uint64_t(1) << 40);
+    QCOMPARE(events[3].alignment, uint32_t(32));
+
+    QCOMPARE(events[4].type, Event::Type::Free);
+    QCOMPARE(events[4].thread, uint32_t(200));
+    QCOMPARE(events[4].id, b);
+    QCOMPARE(events[5].id, d);
+    QCOMPARE(events[6].id, a);
+    QCOMPARE(events[6].thread, uint32_t(3));
+}
+
+void TestAllocationTrace::testCompactEncoding()
+{
+    const AllocationTrace trace = makePipelineTrace(10000);
+    const double bytes_per_event = static_cast<double>(trace.encodedBytes()) / trace.eventCount();
+    qDebug() << "   流水线轨迹:" << trace.eventCount() << "个事件," << bytes_per_event << "字节/事件";
+    QVERIFY(bytes_per_event < 5.0);
+}
+
+void TestAllocationTrace::testSaveLoad()
+{
+    const AllocationTrace original = makePipelineTrace(500);
+    const std::string path = temp_dir_.filePath(QStringLiteral("pipeline.atrc")).toStdString();
+    QVERIFY2(original.save(path), original.getLastError().c_str());
+
+    AllocationTrace loaded;
+    QVERIFY2(loaded.load(path), loaded.getLastError().c_str());
+    QCOMPARE(loaded.eventCount(), original.eventCount());
+    QCOMPARE(loaded.allocationCount(), original.allocationCount());
+    QCOMPARE(loaded.threadCount(), original.threadCount());
+    QCOMPARE(loaded.encodedBytes(), original.encodedBytes());
+
+    const std::vector<Event> a = decodeAll(original);
+    const std::vector<Event> b = decodeAll(loaded);
+    QCOMPARE(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        QCOMPARE(a[i].type, b[i].type);
+        QCOMPARE(a[i].thread, b[i].thread);
+        QCOMPARE(a[i].id, b[i].id);
+        QCOMPARE(a[i].size, b[i].size);
+        QCOMPARE(a[i].alignment, b[i].alignment);
+    }
+}
+
+void TestAllocationTrace::testRejectsCorruptFile()
+{
+    const AllocationTrace original = makePipelineTrace(50);
+    const QString path = temp_dir_.filePath(QStringLiteral("corrupt.atrc"));
+    QVERIFY(original.save(path.toStdString()));
+
+    AllocationTrace trace = makePipelineTrace(3);
+    const uint64_t events_before = trace.eventCount();
+
+    // 截断：头部计数与事件流不一致
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 5));
+    file.close();
+    QVERIFY(!trace.load(path.toStdString()));
+    QVERIFY(!trace.getLastError().empty());
+    QCOMPARE(trace.eventCount(), events_before);
+
+    // 头部线程数小于事件流中的线程编号：回放会越界索引
+    QVERIFY(original.save(path.toStdString()));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(24));
+    file.write(QByteArray("\x01\x00\x00\x00", 4));
+    file.close();
+    QVERIFY(!trace.load(path.toStdString()));
+    QVERIFY(trace.getLastError().find("thread index") != std::string::npos);
+    QCOMPARE(trace.eventCount(), events_before);
+
+    // 魔数不对
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QByteArray(64, 'x'));
+    file.close();
+    QVERIFY(!trace.load(path.toStdString()));
+    QVERIFY(!trace.load(temp_dir_.filePath(QStringLiteral("missing.atrc")).toStdString()));
+    QCOMPARE(trace.eventCount(), events_before);
+}
+
+void TestAllocationTrace::testSummary()
+{
+    const AllocationTrace trace = makePipelineTrace(100);
+    const AllocationTrace::Summary summary = trace.summarize();
+
+    QCOMPARE(summary.allocations, uint64_t(200));
+    QCOMPARE(summary.frees, uint64_t(199));
+    QCOMPARE(summary.threads, uint32_t(3));
+    QCOMPARE(summary.unfreed_blocks, uint64_t(1));
+    QCOMPARE(summary.cross_thread_frees, uint64_t(199));    // 包和帧都在另一个线程释放
+    QCOMPARE(summary.max_size, uint64_t(640 * 360 * 3 / 2));
+    // 峰值：5帧在途加刚分配的1个包
+    QVERIFY(summary.peak_live_blocks >= 5 && summary.peak_live_blocks <= 6);
+    QVERIFY(summary.peak_live_bytes >= 5ull * 640 * 360 * 3 / 2);
+}
+
+void TestAllocationTrace::testTrackerRecordsTrace()
+{
+    MemoryTracker tracker(quietTrackerConfig());
+    QVERIFY(!tracker.isTracing());
+
+    // 开始之前的分配，其释放不进轨迹
+    std::vector<char> before(16);
+    tracker.recordAllocation(before.data(), before.size());
+
+    tracker.startTrace();
+    QVERIFY(tracker.isTracing());
+
+    alignas(64) static char blocks[4][128];
+    tracker.recordAllocation(blocks[0], 128, "main", 64);
+    tracker.recordAllocation(blocks[1], 64, "main");
+    tracker.recordDeallocation(before.data());
+
+    std::thread worker([&tracker]() {
+        tracker.recordDeallocation(blocks[0]);          // 跨线程释放
+        tracker.recordAllocation(blocks[2], 32, "worker", 32);
+        tracker.recordDeallocation(blocks[2]);
+    });
+    worker.join();
+
+    const AllocationTrace trace = tracker.stopTrace();
+    QVERIFY(!tracker.isTracing());
+
+    // 停止之后不再记录
+    tracker.recordAllocation(blocks[3], 16);
+    tracker.recordDeallocation(blocks[1]);
+
+    const std::vector<Event> events = decodeAll(trace);
+    QCOMPARE(events.size(), size_t(5));
+    QCOMPARE(trace.threadCount(), uint32_t(2));
+
+    QCOMPARE(events[0].type, Event::Type::Allocate);
+    QCOMPARE(events[0].size, uint64_t(128));
+    QCOMPARE(events[0].alignment, uint32_t(64));
+    QCOMPARE(events[0].thread, uint32_t(0));
+
+    QCOMPARE(events[2].type, Event::Type::Free);
+    QCOMPARE(events[2].id, events[0].id);
+    QCOMPARE(events[2].thread, uint32_t(1));
+
+    QCOMPARE(events[3].thread, uint32_t(1));
+    QCOMPARE(events[3].alignment, uint32_t(32));
+    QCOMPARE(events[4].id, events[3].id);
+
+    const AllocationTrace::Summary summary = trace.summarize();
+    QCOMPARE(summary.unfreed_blocks, uint64_t(1));              // blocks[1]
+    QCOMPARE(summary.cross_thread_frees, uint64_t(1));
+}
+
+void TestAllocationTrace::testTrackerEventLimit()
+{
+    MemoryTracker tracker(quietTrackerConfig());
+    tracker.startTrace(6);
+
+    static char blocks[6];
+    for (int i = 0; i < 4; ++i) {
+        tracker.recordAllocation(&blocks[i], 1);
+    }
+    tracker.recordDeallocation(&blocks[0]);
+    tracker.recordDeallocation(&blocks[1]);
+    // 达到上限后分配和释放都不再记录
+    tracker.recordDeallocation(&blocks[2]);
+    tracker.recordAllocation(&blocks[4], 1);
+    tracker.recordDeallocation(&blocks[3]);
+
+    const AllocationTrace trace = tracker.stopTrace();
+    QCOMPARE(trace.eventCount(), uint64_t(6));
+    const AllocationTrace::Summary summary = trace.summarize();
+    QCOMPARE(summary.allocations, uint64_t(4));
+    QCOMPARE(summary.frees, uint64_t(2));
+    QCOMPARE(summary.unfreed_blocks, uint64_t(2));
+}
+
+void TestAllocationTrace::testTrackerAddressReuse()
+{
+    MemoryTracker tracker(quietTrackerConfig());
+    tracker.startTrace();
+
+    // 同一地址再次分配而中间漏记了释放：补记旧分配的释放，回放时不会一直存活
+    static char block[64];
+    tracker.recordAllocation(block, 32);
+    tracker.recordAllocation(block, 64);
+    tracker.recordDeallocation(block);
+
+    const AllocationTrace trace = tracker.stopTrace();
+    const std::vector<Event> events = decodeAll(trace);
+    QCOMPARE(events.size(), size_t(4));
+    QCOMPARE(events[1].type, Event::Type::Free);
+    QCOMPARE(events[1].id, events[0].id);
+    QCOMPARE(events[2].type, Event::Type::Allocate);
+    QCOMPARE(events[2].size, uint64_t(64));
+    QCOMPARE(events[3].id, events[2].id);
+
+    const AllocationTrace::Summary summary = trace.summarize();
+    QCOMPARE(summary.unfreed_blocks, uint64_t(0));
+    QCOMPARE(summary.peak_live_bytes, uint64_t(64));
+}
+
+void TestAllocationTrace::testReplaySerial()
+{
+    const AllocationTrace trace = makePipelineTrace(300);
+    CountingAllocator allocator;
+    TraceReplayer::Config config;
+    config.threaded = false;
+
+    const TraceReplayer::Result result = TraceReplayer::replay(trace, allocator, config);
+    QVERIFY2(result.success, result.error.c_str());
+    QCOMPARE(result.allocator, std::string("counting"));
+    QCOMPARE(result.operations, trace.eventCount());
+    QCOMPARE(result.failed_allocations, uint64_t(0));
+    QCOMPARE(allocator.allocations.load(), int64_t(600));
+    QCOMPARE(allocator.live.load(), int64_t(0));                // 末尾存活块也已归还
+    QCOMPARE(allocator.misaligned.load(), int64_t(0));
+
+    // 单线程按记录顺序回放，存活峰值与轨迹一致
+    QCOMPARE(result.replay_peak_live_bytes, result.trace_peak_live_bytes);
+    QVERIFY(result.seconds > 0.0);
+    QVERIFY(result.fragmentation < 0.0);                        // 计数分配器不报告碎片
+#ifdef Q_OS_LINUX
+    QVERIFY(result.peak_rss_bytes > 0);
+    QVERIFY(result.peak_rss_bytes >= result.baseline_rss_bytes);
+#endif
+    qDebug() << "   串行回放:" << result.ns_per_operation << "ns/op, 峰值RSS"
+             << result.peak_rss_bytes / 1024 << "KB";
+}
+
+void TestAllocationTrace::testReplayThreadedCrossThreadFrees()
+{
+    const AllocationTrace trace = makePipelineTrace(2000);
+    CountingAllocator allocator;
+
+    const TraceReplayer::Result result = TraceReplayer::replay(trace, allocator);
+    QVERIFY2(result.success, result.error.c_str());
+    QCOMPARE(result.operations, trace.eventCount());
+    QCOMPARE(result.failed_allocations, uint64_t(0));
+    QCOMPARE(allocator.allocations.load(), int64_t(4000));
+    QCOMPARE(allocator.live.load(), int64_t(0));
+    QCOMPARE(allocator.misaligned.load(), int64_t(0));
+    QVERIFY(result.replay_peak_live_bytes > 0);
+}
+
+void TestAllocationTrace::testReplayMemoryPool()
+{
+    const AllocationTrace trace = makePipelineTrace(500);
+    PoolAllocator allocator;
+
+    const TraceReplayer::Result result = TraceReplayer::replay(trace, allocator);
+    QVERIFY2(result.success, result.error.c_str());
+    QCOMPARE(result.failed_allocations, uint64_t(0));
+    QVERIFY(result.fragmentation >= 0.0 && result.fragmentation <= 1.0);
+
+    const MemoryPool::StatisticsSnapshot stats = allocator.pool.getStatistics();
+    QCOMPARE(stats.allocation_count, size_t(1000));
+    QCOMPARE(stats.free_count, size_t(1000));
+}
+
+#ifdef FFMPEG_AVAILABLE
+void TestAllocationTrace::testDecoderBufferTracking()
+{
+    if (media_file_.isEmpty() || !QFileInfo::exists(media_file_)) {
+        QSKIP("测试媒体不存在");
+    }
+
+    auto tracker = std::make_shared<MemoryTracker>(quietTrackerConfig());
+    tracker->startTrace();
+
+    {
+        const QByteArray file = media_file_.toUtf8();
+        AVFormatContext* input = nullptr;
+        QVERIFY(avformat_open_input(&input, file.constData(), nullptr, nullptr) >= 0);
+        avformat_find_stream_info(input, nullptr);
+        const int stream_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        QVERIFY(stream_index >= 0);
+
+        media::FFmpegVideoDecoder::Config config;
+        config.thread_count = 2;
+        config.memory_tracker = tracker;
+        media::FFmpegVideoDecoder decoder(config);
+        QVERIFY(decoder.initialize(input->streams[stream_index]->codecpar));
+
+        // 模拟渲染端持有最近几帧
+        std::deque<AVFrame*> held;
+        int frames = 0;
+        AVPacket* packet = av_packet_alloc();
+        while (frames < 30 && av_read_frame(input, packet) >= 0) {
+            if (packet->stream_index == stream_index) {
+                QVERIFY(media::trackPacketBuffer(tracker, packet, "test/packet"));
+                decoder.sendPacket(packet);
+                AVFrame* frame = av_frame_alloc();
+                while (decoder.receiveFrame(frame)) {
+                    ++frames;
+                    held.push_back(frame);
+                    frame = av_frame_alloc();
+                    if (held.size() > 3) {
+                        av_frame_free(&held.front());
+                        held.pop_front();
+                    }
+                }
+                av_frame_free(&frame);
+            }
+            av_packet_unref(packet);
+        }
+        QVERIFY(frames > 0);
+
+        for (AVFrame*& frame : held) {
+            av_frame_free(&frame);
+        }
+        av_packet_free(&packet);
+        avformat_close_input(&input);
+    }   // 解码器关闭后所有帧缓冲都已归还
+
+    const AllocationTrace trace = tracker->stopTrace();
+    const AllocationTrace::Summary summary = trace.summarize();
+    qDebug() << "   解码轨迹:" << summary.allocations << "次分配," << summary.threads << "个线程,"
+             << "峰值存活" << summary.peak_live_bytes / 1024 << "KB";
+
+    QVERIFY(summary.allocations > 30);                          // 每帧至少一个平面缓冲，加上数据包
+    QCOMPARE(summary.frees, summary.allocations);
+    QCOMPARE(summary.unfreed_blocks, uint64_t(0));
+    QVERIFY(summary.max_size > 0);
+
+    // 观察到的对齐来自FFmpeg的缓冲（至少16字节）
+    bool aligned = true;
+    trace.forEach([&aligned](const Event& event) {
+        if (event.type == Event::Type::Allocate && event.alignment < 16) {
+            aligned = false;
+        }
+        return true;
+    });
+    QVERIFY(aligned);
+}
+#endif
@@ -0,0 +1,43 @@
+#ifndef TEST_ALLOCATION_TRACE_H
+#define TEST_ALLOCATION_TRACE_H
+
+#include <QtTest>
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+class TestAllocationTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 编码与文件格式
+    void testEncodeDecodeRoundTrip();
+    void testCompactEncoding();
+    void testSaveLoad();
+    void testRejectsCorruptFile();
+    void testSummary();
+
+    // MemoryTracker记录
+    void testTrackerRecordsTrace();
+    void testTrackerEventLimit();
+    void testTrackerAddressReuse();
+
+    // 回放
+    void testReplaySerial();
+    void testReplayThreadedCrossThreadFrees();
+    void testReplayMemoryPool();
+
+#ifdef FFMPEG_AVAILABLE
+    // 真实解码的帧缓冲轨迹
+    void testDecoderBufferTracking();
+#endif
+
+private:
+    QString media_file_;
+    QTemporaryDir temp_dir_;
+};
+
+#endif // TEST_ALLOCATION_TRACE_H
@@ -0,0 +1,279 @@
+#include "test_copy_accounting.h"
+
+#include <QDebug>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "memory/copy_accounting.h"
+
+#ifdef FFMPEG_AVAILABLE
+#include "memory/smart_pointers.h"
+#endif
+
+namespace {
+
+const CopyAccounting::SiteStatistics* findSite(const CopyAccounting::Snapshot& snapshot, const std::string& tag) {
+    for (const auto& site : snapshot.sites) {
+        if (site.tag == tag) {
+            return &site;
+        }
+    }
+    return nullptr;
+}
+
+const CopyAccounting::StageStatistics* findStage(const CopyAccounting::Snapshot& snapshot, const std::string& name) {
+    for (const auto& stage : snapshot.stages) {
+        if (stage.name == name) {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+// 只有缓冲区大小的帧替身：copyAccountingFrameBytes只读buf/extended_buf
+struct FakeBuffer {
+    int size;
+};
+
+struct FakeFrame {
+    FakeBuffer* buf[8] = {};
+    FakeBuffer** extended_buf = nullptr;
+    int nb_extended_buf = 0;
+};
+
+} // namespace
+
+void TestCopyAccounting::initTestCase()
+{
+#ifdef COPY_ACCOUNTING_ENABLED
+    qDebug() << "📋 开始拷贝计量测试（COPY_*宏已启用）";
+#else
+    qDebug() << "📋 开始拷贝计量测试（COPY_*宏已关闭）";
+#endif
+}
+
+void TestCopyAccounting::testStreamAttribution()
+{
+    CopyAccounting accounting;
+    CopyAccounting::Site& site = accounting.site("decode.copy");
+    QCOMPARE(&accounting.site("decode.copy"), &site);
+
+    const int video = accounting.stream("video");
+    const int audio = accounting.stream("audio");
+    QCOMPARE(accounting.stream("video"), video);
+    QVERIFY(video != audio);
+
+    // 流归属是线程私有的：各线程声明自己的流，作用域结束后恢复
+    std::thread video_thread([&]() {
+        CopyStreamScope scope(video);
+        site.record(1000);
+        site.record(1000);
+    });
+    std::thread audio_thread([&]() {
+        CopyStreamScope scope(audio);
+        site.record(64);
+    });
+    video_thread.join();
+    audio_thread.join();
+
+    QCOMPARE(CopyAccounting::currentStream(), -1);
+    {
+        CopyStreamScope outer(video);
+        {
+            CopyStreamScope inner(audio);
+            QCOMPARE(CopyAccounting::currentStream(), audio);
+        }
+        QCOMPARE(CopyAccounting::currentStream(), video);
+    }
+    site.record(7);     // 未归属
+
+    const CopyAccounting::Snapshot snapshot = accounting.snapshot();
+    const CopyAccounting::SiteStatistics* stats = findSite(snapshot, "decode.copy");
+    QVERIFY(stats != nullptr);
+    QCOMPARE(stats->copies, uint64_t(4));
+    QCOMPARE(stats->bytes, uint64_t(2071));
+    QCOMPARE(stats->stream_bytes[video], uint64_t(2000));
+    QCOMPARE(stats->stream_bytes[audio], uint64_t(64));
+    QCOMPARE(stats->unattributed_bytes, uint64_t(7));
+    QCOMPARE(snapshot.unattributed_bytes, uint64_t(7));
+}
+
+void TestCopyAccounting::testStagesAndBytesPerFrame()
+{
+    CopyAccounting accounting;
+    const int video = accounting.stream("video");
+    accounting.addFrame(video, 10);
+    accounting.addFrame(-1);            // 未注册的流忽略
+    accounting.addFrame(42);
+
+    {
+        CopyStreamScope scope(video);
+        for (int i = 0; i < 10; ++i) {
+            accounting.site("render.convert_staging").record(3110400);     // 1080p YUV420P一帧
+            accounting.site("render.upload").record(100);
+        }
+        accounting.site("framebus.publish").record(5000);
+    }
+    accounting.site("cache.get").record(4096);
+
+    const CopyAccounting::Snapshot snapshot = accounting.snapshot();
+    QCOMPARE(snapshot.total_bytes, uint64_t(31104000 + 1000 + 5000 + 4096));
+
+    // 调用点按字节数降序
+    QCOMPARE(snapshot.sites.front().tag, std::string("render.convert_staging"));
+    QCOMPARE(snapshot.sites.front().stage, std::string("render"));
+
+    // 同一阶段合计
+    const CopyAccounting::StageStatistics* render = findStage(snapshot, "render");
+    QVERIFY(render != nullptr);
+    QCOMPARE(render->copies, uint64_t(20));
+    QCOMPARE(render->bytes, uint64_t(31105000));
+    QCOMPARE(snapshot.stages.front().name, std::string("render"));
+    QVERIFY(findStage(snapshot, "cache") != nullptr);
+
+    // 每帧拷贝量只计入归属到该流的字节
+    QCOMPARE(snapshot.streams.size(), size_t(1));
+    QCOMPARE(snapshot.streams[0].frames, uint64_t(10));
+    QCOMPARE(snapshot.streams[0].bytes, uint64_t(31110000));
+    QCOMPARE(snapshot.streams[0].bytesPerFrame(), 3111000.0);
+}
+
+void TestCopyAccounting::testReportAndReset()
+{
+    CopyAccounting accounting;
+    const int video = accounting.stream("video");
+    accounting.addFrame(video, 2);
+    {
+        CopyStreamScope scope(video);
+        accounting.site("snapshot.make_writable").record(2 * 1024 * 1024);
+    }
+
+    const QString report = QString::fromStdString(accounting.report());
+    QVERIFY(report.contains("Copy Accounting"));
+    QVERIFY(report.contains("snapshot.make_writable"));
+    QVERIFY(report.contains("video 1.00 MB/frame"));
+
+    // 清零后调用点和流保持注册，引用仍然有效
+    CopyAccounting::Site& site = accounting.site("snapshot.make_writable");
+    accounting.reset();
+    CopyAccounting::Snapshot snapshot = accounting.snapshot();
+    QCOMPARE(snapshot.sites.size(), size_t(1));
+    QCOMPARE(snapshot.total_bytes, uint64_t(0));
+    QCOMPARE(snapshot.streams[0].frames, uint64_t(0));
+
+    site.record(10);
+    snapshot = accounting.snapshot();
+    QCOMPARE(snapshot.total_bytes, uint64_t(10));
+}
+
+void TestCopyAccounting::testSiteOverflow()
+{
+    CopyAccounting accounting;
+    for (size_t i = 0; i < CopyAccounting::kMaxSites; ++i) {
+        accounting.site("s." + std::to_string(i));
+    }
+    // 槽位用尽返回占位调用点，不进入快照
+    CopyAccounting::Site& overflow = accounting.site("s.overflow");
+    overflow.record(100);
+    const CopyAccounting::Snapshot snapshot = accounting.snapshot();
+    QCOMPARE(snapshot.sites.size(), CopyAccounting::kMaxSites);
+    QCOMPARE(snapshot.total_bytes, uint64_t(0));
+
+    for (int i = 0; i < CopyAccounting::kMaxStreams; ++i) {
+        QCOMPARE(accounting.stream("stream" + std::to_string(i)), i);
+    }
+    QCOMPARE(accounting.stream("one_too_many"), -1);
+}
+
+void TestCopyAccounting::testByteHelpers()
+{
+    QCOMPARE(copyAccountingBytes(std::string("abcdef")), size_t(6));
+    QCOMPARE(copyAccountingBytes(std::vector<uint32_t>(5)), size_t(20));
+    QCOMPARE(copyAccountingBytes(uint64_t(1)), sizeof(uint64_t));
+
+    FakeBuffer plane0{1000};
+    FakeBuffer plane1{250};
+    FakeBuffer extended{30};
+    FakeBuffer* extended_list[] = {&extended};
+    FakeFrame frame;
+    frame.buf[0] = &plane0;
+    frame.buf[2] = &plane1;
+    frame.extended_buf = extended_list;
+    frame.nb_extended_buf = 1;
+    QCOMPARE(copyAccountingFrameBytes(&frame), size_t(1280));
+    QCOMPARE(copyAccountingFrameBytes(static_cast<const FakeFrame*>(nullptr)), size_t(0));
+}
+
+void TestCopyAccounting::testMacros()
+{
+    CopyAccounting::instance().reset();
+    std::vector<uint8_t> source(4096, 0x5A);
+    std::vector<uint8_t> target(4096, 0);
+    int evaluated = 0;
+
+    COPY_MEMCPY("test.memcpy", target.data(), source.data(), source.size());
+    QVERIFY(target == source);
+
+    COPY_ACCOUNT("test.account", (++evaluated, size_t(100)));
+    COPY_ACCOUNT_IF(evaluated > 0, "test.account_if", size_t(5));
+    COPY_ACCOUNT_IF(false, "test.account_if", size_t(1000));
+    {
+        COPY_ACCOUNT_STREAM("test_stream");
+        COPY_ACCOUNT_FRAME("test_stream");
+        COPY_ACCOUNT("test.account", size_t(1));
+    }
+
+    const CopyAccounting::Snapshot snapshot = CopyAccounting::instance().snapshot();
+#ifdef COPY_ACCOUNTING_ENABLED
+    QCOMPARE(evaluated, 1);
+    QCOMPARE(findSite(snapshot, "test.memcpy")->bytes, uint64_t(4096));
+    QCOMPARE(findSite(snapshot, "test.account")->bytes, uint64_t(101));
+    QCOMPARE(findSite(snapshot, "test.account_if")->copies, uint64_t(1));
+    const CopyAccounting::SiteStatistics* account = findSite(snapshot, "test.account");
+    const int stream = CopyAccounting::instance().stream("test_stream");
+    QCOMPARE(account->stream_bytes[stream], uint64_t(1));
+    QCOMPARE(snapshot.streams[stream].frames, uint64_t(1));
+#else
+    // 关闭时宏不注册调用点，字节数表达式也不求值
+    QCOMPARE(evaluated, 0);
+    QVERIFY(findSite(snapshot, "test.memcpy") == nullptr);
+    QVERIFY(findSite(snapshot, "test.account") == nullptr);
+#endif
+}
+
+#ifdef FFMPEG_AVAILABLE
+void TestCopyAccounting::testRefCountedFrameCopies()
+{
+    AVFrame* raw = av_frame_alloc();
+    QVERIFY(raw != nullptr);
+    raw->format = AV_PIX_FMT_YUV420P;
+    raw->width = 320;
+    raw->height = 240;
+    QVERIFY(av_frame_get_buffer(raw, 0) >= 0);
+    const size_t frame_bytes = copyAccountingFrameBytes(raw);
+    QVERIFY(frame_bytes >= size_t(320 * 240 * 3 / 2));
+
+    CopyAccounting::instance().reset();
+    ffmpeg::RefCountedFrame frame{ffmpeg::AVFramePtr(raw)};
+
+    // 独占缓冲时makeWritable不复制
+    QVERIFY(frame.makeWritable());
+
+    // 另有引用时makeWritable和clone各复制一次整帧
+    ffmpeg::AVFramePtr ref = frame.createRef();
+    QVERIFY(ref);
+    QVERIFY(frame.makeWritable());
+    ffmpeg::AVFramePtr copy = frame.clone();
+    QVERIFY(copy);
+
+    const CopyAccounting::Snapshot snapshot = CopyAccounting::instance().snapshot();
+#ifdef COPY_ACCOUNTING_ENABLED
+    QCOMPARE(findSite(snapshot, "frame.make_writable")->copies, uint64_t(1));
+    QCOMPARE(findSite(snapshot, "frame.make_writable")->bytes, uint64_t(frame_bytes));
+    QCOMPARE(findSite(snapshot, "frame.clone")->bytes, uint64_t(frame_bytes));
+#else
+    QVERIFY(findSite(snapshot, "frame.make_writable") == nullptr);
+#endif
+}
+#endif
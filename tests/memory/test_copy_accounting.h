@@ -0,0 +1,30 @@
+#ifndef TEST_COPY_ACCOUNTING_H
+#define TEST_COPY_ACCOUNTING_H
+
+#include <QtTest>
+#include <QObject>
+
+class TestCopyAccounting : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 统计与报告
+    void testStreamAttribution();
+    void testStagesAndBytesPerFrame();
+    void testReportAndReset();
+    void testSiteOverflow();
+    void testByteHelpers();
+
+    // 宏（随ENABLE_COPY_ACCOUNTING开关）
+    void testMacros();
+
+#ifdef FFMPEG_AVAILABLE
+    // RefCountedFrame的整帧复制
+    void testRefCountedFrameCopies();
+#endif
+};
+
+#endif // TEST_COPY_ACCOUNTING_H
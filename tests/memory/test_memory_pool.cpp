@@ -1,5 +1,7 @@
 #include "test_memory_pool.h"
 #include "memory/memory_pool.h"
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 void TestMemoryPool::testBasicAllocation()
@@ -70,4 +72,52 @@ void TestMemoryPool::testStatistics()
     delete pool;
 }
 
+void TestMemoryPool::testConcurrentDeallocation()
+{
+    // 多线程同时释放同一个池的块：等不到池锁时不能跳过该池（否则池内指针会被交给std::free）
+    MemoryPool::Config config;
+    config.enable_statistics = true;
+    pool = new MemoryPool(config);
+
+    const int kThreads = 8;
+    const int kBlocksPerThread = 256;
+    const int kRounds = 1000;
+    for (int round = 0; round < kRounds; ++round) {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < kThreads * kBlocksPerThread; ++i) {
+            void* ptr = pool->allocate(256);
+            QVERIFY(ptr != nullptr);
+            ptrs.push_back(ptr);
+        }
+        const std::unordered_set<void*> blocks(ptrs.begin(), ptrs.end());
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = t; i < ptrs.size(); i += kThreads) {
+                    pool->deallocate(ptrs[i]);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        QCOMPARE(pool->getStatistics().current_usage, size_t(0));
+
+        // 全部回到了空闲链表：再分配同样数量拿到的还是这些块
+        for (void*& ptr : ptrs) {
+            ptr = pool->allocate(256);
+            QVERIFY(blocks.count(ptr) == 1);
+        }
+        for (void* ptr : ptrs) {
+            pool->deallocate(ptr);
+        }
+    }
+
+    const auto stats = pool->getStatistics();
+    QCOMPARE(stats.free_count, stats.allocation_count);
+    QCOMPARE(stats.pool_hit_count, stats.allocation_count);
+    delete pool;
+}
+
 #include "test_memory_pool.moc"
\ No newline at end of file
@@ -16,6 +16,7 @@ private slots:
     void testMultipleAllocations();
     void testDeallocation();
     void testStatistics();
+    void testConcurrentDeallocation();
 
 private:
     MemoryPool* pool;
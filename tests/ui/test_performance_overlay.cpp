@@ -0,0 +1,270 @@
+#include "test_performance_overlay.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const media::MetricSample* findSample(const std::vector<media::MetricSample>& samples, const std::string& name) {
+    for (const auto& sample : samples) {
+        if (sample.name == name) {
+            return &sample;
+        }
+    }
+    return nullptr;
+}
+
+QVariantMap findEntry(const QVariantList& list, const QString& name) {
+    for (const QVariant& item : list) {
+        const QVariantMap map = item.toMap();
+        if (map.value(QStringLiteral("name")).toString() == name) {
+            return map;
+        }
+    }
+    return QVariantMap();
+}
+
+} // namespace
+
+void TestPerformanceOverlay::initTestCase()
+{
+    qDebug() << "📈 开始性能浮层测试";
+}
+
+void TestPerformanceOverlay::testConcurrentWritersAndSampler()
+{
+    media::MetricsRegistry registry;
+    media::Metric& frames = registry.counter("drop.frames");
+    media::Metric& decode = registry.latency("stage.decode");
+
+    const int writers = 4;
+    const int iterations = 200000;
+    std::atomic<bool> done{false};
+    std::atomic<int> snapshots{0};
+    std::atomic<bool> incomplete{false};
+
+    // 采样线程与写入线程、注册线程并发，写入方不应被阻塞
+    std::thread sampler([&]() {
+        while (!done.load()) {
+            const auto samples = registry.snapshot(true);
+            if (samples.size() < 2) {
+                incomplete.store(true);
+            }
+            snapshots++;
+        }
+    });
+    std::thread registrar([&]() {
+        for (int i = 0; i < 100; ++i) {
+            registry.gauge("queue.q" + std::to_string(i)).set(i);
+        }
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < iterations; ++i) {
+                frames.add();
+                decode.record(t + 1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const qint64 write_ms = timer.elapsed();
+    registrar.join();
+    done.store(true);
+    sampler.join();
+
+    const auto samples = registry.snapshot();
+    qDebug() << "   " << writers * iterations * 2 << "次写入耗时" << write_ms << "ms，期间采样" << snapshots.load() << "次";
+    QVERIFY(!incomplete.load());
+    QCOMPARE(frames.count(), uint64_t(writers * iterations));
+    QCOMPARE(decode.count(), uint64_t(writers * iterations));
+    QCOMPARE(decode.totalUs(), int64_t(iterations) * (1 + 2 + 3 + 4));
+    QCOMPARE(registry.size(), size_t(102));
+    QVERIFY(findSample(samples, "queue.q99") != nullptr);
+    QCOMPARE(findSample(samples, "queue.q99")->value, 99.0);
+}
+
+void TestPerformanceOverlay::testTypeMismatchReturnsPlaceholder()
+{
+    media::MetricsRegistry registry;
+    media::Metric& counter = registry.counter("drop.x");
+    media::Metric& same = registry.counter("drop.x");
+    QCOMPARE(&counter, &same);
+
+    // 同名不同类型：返回不参与采样的占位指标，写入不影响已注册的指标
+    media::Metric& mismatch = registry.gauge("drop.x");
+    QVERIFY(&mismatch != &counter);
+    mismatch.set(42.0);
+    counter.add(3);
+
+    const auto samples = registry.snapshot();
+    QCOMPARE(samples.size(), size_t(1));
+    QCOMPARE(samples[0].type, media::MetricType::Counter);
+    QCOMPARE(samples[0].count, uint64_t(3));
+}
+
+void TestPerformanceOverlay::testProbeLifecycle()
+{
+    media::MetricsRegistry registry;
+    int calls = 0;
+    const int id = registry.addProbe("pool.test", [&calls]() {
+        calls++;
+        return 0.75;
+    });
+
+    auto samples = registry.snapshot();
+    const media::MetricSample* sample = findSample(samples, "pool.test");
+    QVERIFY(sample);
+    QCOMPARE(sample->type, media::MetricType::Probe);
+    QCOMPARE(sample->value, 0.75);
+    QCOMPARE(calls, 1);
+
+    registry.removeProbe(id);
+    samples = registry.snapshot();
+    QVERIFY(!findSample(samples, "pool.test"));
+    QCOMPARE(calls, 1);
+}
+
+void TestPerformanceOverlay::testModelGroupsAndRates()
+{
+    media::MetricsRegistry registry;
+    media::Metric& decode = registry.latency("stage.decode");
+    media::Metric& queue = registry.gauge("queue.video_packets");
+    media::Metric& late = registry.counter("drop.video_late");
+    media::Metric& pressure = registry.gauge("memory.pressure_level");
+    registry.addProbe("pool.frames", []() { return 0.9; });
+
+    media::PerformanceOverlayModel model(&registry);
+    QSignalSpy spy(&model, &media::PerformanceOverlayModel::sampled);
+    model.sampleNow();
+
+    // 一个窗口内：50帧、每帧2ms，最大5ms
+    for (int i = 0; i < 49; ++i) {
+        decode.record(2000);
+    }
+    decode.record(5000);
+    queue.set(12);
+    late.add(7);
+    pressure.set(2);
+    QTest::qWait(200);
+    model.sampleNow();
+    QCOMPARE(spy.count(), 2);
+
+    const QVariantMap stage = findEntry(model.stages(), QStringLiteral("decode"));
+    const double fps = stage.value(QStringLiteral("fps")).toDouble();
+    qDebug() << "   decode:" << fps << "fps，平均" << stage.value(QStringLiteral("latencyMs")).toDouble()
+             << "ms，最大" << stage.value(QStringLiteral("maxLatencyMs")).toDouble() << "ms";
+    QVERIFY(fps > 50.0 && fps < 500.0);
+    QVERIFY(qAbs(stage.value(QStringLiteral("latencyMs")).toDouble() - 2.06) < 0.01);
+    QCOMPARE(stage.value(QStringLiteral("maxLatencyMs")).toDouble(), 5.0);
+
+    QCOMPARE(findEntry(model.queues(), QStringLiteral("video_packets")).value(QStringLiteral("depth")).toDouble(), 12.0);
+    QCOMPARE(findEntry(model.pools(), QStringLiteral("frames")).value(QStringLiteral("hitRate")).toDouble(), 0.9);
+    QCOMPARE(findEntry(model.drops(), QStringLiteral("video_late")).value(QStringLiteral("total")).toULongLong(), 7ULL);
+    QCOMPARE(model.droppedFrames(), 7ULL);
+    QCOMPARE(model.memoryPressureLevel(), 2);
+    QCOMPARE(model.memoryPressure(), QStringLiteral("HIGH"));
+
+    // 最大耗时按窗口重置；没有新帧时fps归零
+    QTest::qWait(50);
+    model.sampleNow();
+    const QVariantMap idle = findEntry(model.stages(), QStringLiteral("decode"));
+    QCOMPARE(idle.value(QStringLiteral("fps")).toDouble(), 0.0);
+    QCOMPARE(idle.value(QStringLiteral("maxLatencyMs")).toDouble(), 0.0);
+}
+
+void TestPerformanceOverlay::testModelGroupsLoudness()
+{
+    media::MetricsRegistry registry;
+    registry.gauge("loudness.main.momentary").set(-22.5);
+    registry.gauge("loudness.main.short_term").set(-23.0);
+    registry.gauge("loudness.main.integrated").set(-23.1);
+    registry.gauge("loudness.main.range").set(4.5);
+    registry.gauge("loudness.main.true_peak").set(-1.5);
+    registry.gauge("loudness.cam.2.momentary").set(-std::numeric_limits<double>::infinity());
+
+    media::PerformanceOverlayModel model(&registry);
+    model.sampleNow();
+
+    // 每个流合并为一行，流名称可以带点
+    QCOMPARE(model.loudness().size(), 2);
+    const QVariantMap main = findEntry(model.loudness(), QStringLiteral("main"));
+    QCOMPARE(main.value(QStringLiteral("momentary")).toDouble(), -22.5);
+    QCOMPARE(main.value(QStringLiteral("shortTerm")).toDouble(), -23.0);
+    QCOMPARE(main.value(QStringLiteral("integrated")).toDouble(), -23.1);
+    QCOMPARE(main.value(QStringLiteral("range")).toDouble(), 4.5);
+    QCOMPARE(main.value(QStringLiteral("truePeak")).toDouble(), -1.5);
+    const QVariantMap camera = findEntry(model.loudness(), QStringLiteral("cam.2"));
+    QVERIFY(std::isinf(camera.value(QStringLiteral("momentary")).toDouble()));
+
+    // 响度指标不混入其他分组
+    QVERIFY(model.queues().isEmpty());
+}
+
+void TestPerformanceOverlay::testModelGroupsCounters()
+{
+    media::MetricsRegistry registry;
+    registry.counter("perf.video_decode.samples").add(10);
+    registry.counter("perf.video_decode.cycles").add(2000000);
+    registry.counter("perf.video_decode.instructions").add(3000000);
+    registry.counter("perf.video_decode.llc_misses").add(6000);
+    registry.counter("perf.video_decode.branch_misses").add(1500);
+    // 注册了但从未计入（计数器未启用）的阶段不显示
+    registry.counter("perf.render.samples");
+    registry.counter("perf.render.cycles");
+
+    media::PerformanceOverlayModel model(&registry);
+    model.sampleNow();
+
+    QCOMPARE(model.counters().size(), 1);
+    QVariantMap decode = findEntry(model.counters(), QStringLiteral("video_decode"));
+    QCOMPARE(decode.value(QStringLiteral("ipc")).toDouble(), 1.5);
+    QCOMPARE(decode.value(QStringLiteral("llcMpki")).toDouble(), 2.0);
+    QCOMPARE(decode.value(QStringLiteral("branchMpki")).toDouble(), 0.5);
+    QCOMPARE(decode.value(QStringLiteral("kcyclesPerCall")).toDouble(), 200.0);
+
+    // 第二个窗口按差值计算
+    registry.counter("perf.video_decode.samples").add(10);
+    registry.counter("perf.video_decode.cycles").add(1000000);
+    registry.counter("perf.video_decode.instructions").add(3000000);
+    model.sampleNow();
+    decode = findEntry(model.counters(), QStringLiteral("video_decode"));
+    QCOMPARE(decode.value(QStringLiteral("ipc")).toDouble(), 3.0);
+    QCOMPARE(decode.value(QStringLiteral("llcMpki")).toDouble(), 0.0);
+    QCOMPARE(decode.value(QStringLiteral("kcyclesPerCall")).toDouble(), 100.0);
+
+    // 计数指标不混入丢弃分组
+    QVERIFY(model.drops().isEmpty());
+}
+
+void TestPerformanceOverlay::testActiveTogglesCollecting()
+{
+    media::MetricsRegistry registry;
+    media::PerformanceOverlayModel model(&registry);
+    QVERIFY(!registry.isCollecting());
+
+    model.setIntervalMs(10);
+    QCOMPARE(model.intervalMs(), 50);
+
+    QSignalSpy spy(&model, &media::PerformanceOverlayModel::sampled);
+    model.setActive(true);
+    QVERIFY(registry.isCollecting());
+    QTRY_VERIFY_WITH_TIMEOUT(spy.count() >= 3, 1000);
+
+    // 隐藏后不再采样、不再计时
+    model.setActive(false);
+    QVERIFY(!registry.isCollecting());
+    const int count = spy.count();
+    QTest::qWait(200);
+    QCOMPARE(spy.count(), count);
+}
@@ -0,0 +1,29 @@
+#ifndef TEST_PERFORMANCE_OVERLAY_H
+#define TEST_PERFORMANCE_OVERLAY_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "utils/metrics_registry.h"
+#include "ui/performance_overlay_model.h"
+
+class TestPerformanceOverlay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // 指标注册表
+    void testConcurrentWritersAndSampler();
+    void testTypeMismatchReturnsPlaceholder();
+    void testProbeLifecycle();
+
+    // 浮层模型
+    void testModelGroupsAndRates();
+    void testModelGroupsLoudness();
+    void testModelGroupsCounters();
+    void testActiveTogglesCollecting();
+};
+
+#endif // TEST_PERFORMANCE_OVERLAY_H
@@ -0,0 +1,201 @@
+#include "test_perf_counters.h"
+
+#include <QDebug>
+#include <thread>
+
+namespace {
+
+const media::MetricSample* findSample(const std::vector<media::MetricSample>& samples, const std::string& name) {
+    for (const auto& sample : samples) {
+        if (sample.name == name) {
+            return &sample;
+        }
+    }
+    return nullptr;
+}
+
+// 依赖链上的浮点运算，编译器不能消掉
+double spin(int iterations) {
+    volatile double value = 1.0;
+    for (int i = 0; i < iterations; ++i) {
+        value = value * 1.0000001 + 0.5;
+    }
+    return value;
+}
+
+} // namespace
+
+void TestPerfCounters::initTestCase()
+{
+    qDebug() << "📟 开始硬件性能计数器测试";
+    const media::PerfCounters::Status status = media::PerfCounters::status();
+    if (status.available) {
+        qDebug() << "   计数组可用，事件:"
+                 << status.supported[media::PerfCounters::Cycles]
+                 << status.supported[media::PerfCounters::Instructions]
+                 << status.supported[media::PerfCounters::LlcMisses]
+                 << status.supported[media::PerfCounters::BranchMisses];
+    } else {
+        qDebug() << "   计数组不可用:" << QString::fromStdString(status.error);
+    }
+}
+
+void TestPerfCounters::cleanup()
+{
+    media::PerfCounters::setEnabled(false);
+}
+
+void TestPerfCounters::testStatusReportsReason()
+{
+    const media::PerfCounters::Status status = media::PerfCounters::status();
+    media::PerfCounterValues values;
+    QCOMPARE(media::PerfCounters::readThread(&values), status.available);
+
+    if (status.available) {
+        QVERIFY(status.supported[media::PerfCounters::Cycles]);
+        QVERIFY(status.error.empty());
+    } else {
+        // 不可用时必须给出原因，且没有事件处于打开状态
+        QVERIFY(!status.error.empty());
+        for (int i = 0; i < media::PerfCounters::kCounterCount; ++i) {
+            QVERIFY(!status.supported[i]);
+        }
+    }
+
+    QCOMPARE(QString(media::PerfCounters::counterName(media::PerfCounters::LlcMisses)), QString("llc_misses"));
+}
+
+void TestPerfCounters::testDisabledScopeIsNoop()
+{
+    media::MetricsRegistry registry;
+    media::PerfStage stage("disabled", registry);
+
+    media::PerfCounters::setEnabled(false);
+    for (int i = 0; i < 10; ++i) {
+        media::ScopedPerfCounters counters(stage);
+        spin(1000);
+    }
+
+    const media::PerfStage::StatisticsSnapshot stats = stage.getStatistics();
+    QCOMPARE(stats.samples, uint64_t(0));
+    QCOMPARE(stats.cycles, uint64_t(0));
+    QCOMPARE(stats.instructionsPerCycle(), 0.0);
+
+    // 指标已注册（浮层按samples总数判断是否显示），但没有计数
+    const auto samples = registry.snapshot();
+    const media::MetricSample* count = findSample(samples, "perf.disabled.samples");
+    QVERIFY(count != nullptr);
+    QCOMPARE(count->count, uint64_t(0));
+}
+
+void TestPerfCounters::testDeltaScalesMultiplexedCounts()
+{
+    media::PerfCounterValues start;
+    start.cycles = 1000;
+    start.instructions = 2000;
+    start.time_enabled_ns = 100;
+    start.time_running_ns = 100;
+
+    // 作用域内一直在调度：直接相减
+    media::PerfCounterValues end = start;
+    end.cycles = 1500;
+    end.instructions = 3000;
+    end.llc_misses = 7;
+    end.time_enabled_ns = 200;
+    end.time_running_ns = 200;
+    media::PerfCounterValues delta = media::PerfCounterValues::delta(start, end);
+    QCOMPARE(delta.cycles, uint64_t(500));
+    QCOMPARE(delta.instructions, uint64_t(1000));
+    QCOMPARE(delta.llc_misses, uint64_t(7));
+
+    // 只调度了一半时间：按enabled/running放大，比值不变
+    end.time_running_ns = 150;
+    delta = media::PerfCounterValues::delta(start, end);
+    QCOMPARE(delta.cycles, uint64_t(1000));
+    QCOMPARE(delta.instructions, uint64_t(2000));
+    QCOMPARE(delta.llc_misses, uint64_t(14));
+
+    // 从未调度：原始差值为0，不做除零
+    end = start;
+    end.time_enabled_ns = 300;
+    delta = media::PerfCounterValues::delta(start, end);
+    QCOMPARE(delta.cycles, uint64_t(0));
+}
+
+void TestPerfCounters::testStageExportsToRegistry()
+{
+    media::MetricsRegistry registry;
+    media::PerfStage first("decode", registry);
+    media::PerfStage second("decode", registry);
+
+    media::PerfCounterValues delta;
+    delta.cycles = 4000;
+    delta.instructions = 8000;
+    delta.llc_misses = 16;
+    delta.branch_misses = 40;
+    first.add(delta);
+    first.add(delta);
+    second.add(delta);
+
+    // 实例统计各自独立
+    const media::PerfStage::StatisticsSnapshot stats = first.getStatistics();
+    QCOMPARE(stats.samples, uint64_t(2));
+    QCOMPARE(stats.cycles, uint64_t(8000));
+    QCOMPARE(stats.instructionsPerCycle(), 2.0);
+    QCOMPARE(stats.llcMissesPerKiloInstruction(), 2.0);
+    QCOMPARE(stats.branchMissesPerKiloInstruction(), 5.0);
+    QCOMPARE(second.getStatistics().samples, uint64_t(1));
+
+    // 注册表中同名阶段累加
+    const auto samples = registry.snapshot();
+    QCOMPARE(findSample(samples, "perf.decode.samples")->count, uint64_t(3));
+    QCOMPARE(findSample(samples, "perf.decode.cycles")->count, uint64_t(12000));
+    QCOMPARE(findSample(samples, "perf.decode.instructions")->count, uint64_t(24000));
+    QCOMPARE(findSample(samples, "perf.decode.llc_misses")->count, uint64_t(48));
+    QCOMPARE(findSample(samples, "perf.decode.branch_misses")->count, uint64_t(120));
+    QCOMPARE(findSample(samples, "perf.decode.cycles")->type, media::MetricType::Counter);
+}
+
+void TestPerfCounters::testCountsPerThreadAndStage()
+{
+    if (!media::PerfCounters::status().available) {
+        QSKIP("perf_event_open不可用（容器、虚拟机或perf_event_paranoid限制）");
+    }
+
+    media::MetricsRegistry registry;
+    media::PerfStage light("light", registry);
+    media::PerfStage heavy("heavy", registry);
+    media::PerfCounters::setEnabled(true);
+
+    // 每个线程有自己的计数组，只计本线程在作用域内的工作
+    std::thread light_thread([&]() {
+        for (int i = 0; i < 5; ++i) {
+            media::ScopedPerfCounters counters(light);
+            spin(100000);
+        }
+    });
+    std::thread heavy_thread([&]() {
+        for (int i = 0; i < 5; ++i) {
+            media::ScopedPerfCounters counters(heavy);
+            spin(1000000);
+        }
+    });
+    light_thread.join();
+    heavy_thread.join();
+
+    const media::PerfStage::StatisticsSnapshot light_stats = light.getStatistics();
+    const media::PerfStage::StatisticsSnapshot heavy_stats = heavy.getStatistics();
+    QCOMPARE(light_stats.samples, uint64_t(5));
+    QCOMPARE(heavy_stats.samples, uint64_t(5));
+    QVERIFY(light_stats.cycles > 0);
+    QVERIFY(heavy_stats.cycles > light_stats.cycles);
+
+    if (media::PerfCounters::status().supported[media::PerfCounters::Instructions]) {
+        // 工作量相差10倍，指令数至少相差5倍
+        QVERIFY(heavy_stats.instructions > light_stats.instructions * 5);
+        QVERIFY(heavy_stats.instructionsPerCycle() > 0.0);
+    }
+    qDebug() << "   heavy IPC:" << heavy_stats.instructionsPerCycle()
+             << "LLC MPKI:" << heavy_stats.llcMissesPerKiloInstruction()
+             << "branch MPKI:" << heavy_stats.branchMissesPerKiloInstruction();
+}
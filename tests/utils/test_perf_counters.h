@@ -0,0 +1,27 @@
+#ifndef TEST_PERF_COUNTERS_H
+#define TEST_PERF_COUNTERS_H
+
+#include <QtTest>
+#include <QObject>
+
+#include "utils/perf_counters.h"
+
+class TestPerfCounters : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    // 降级与换算（不依赖PMU）
+    void testStatusReportsReason();
+    void testDisabledScopeIsNoop();
+    void testDeltaScalesMultiplexedCounts();
+    void testStageExportsToRegistry();
+
+    // 真实计数（容器/虚拟机里没有权限或PMU时跳过）
+    void testCountsPerThreadAndStage();
+};
+
+#endif // TEST_PERF_COUNTERS_H
@@ -0,0 +1,343 @@
+/**
+ * @brief 分配轨迹回放：用真实运行记录的分配序列比较分配器
+ *
+ * 用法：
+ *   alloc_replay [选项] <轨迹文件>
+ *
+ * 轨迹由播放器的--alloc-trace <文件>记录（MemoryTracker::startTrace/stopTrace）。
+ * 每个分配器在独立的子进程中回放，峰值RSS互不影响。
+ *
+ * 选项：
+ *   -a <名称,...>     回放的分配器，默认全部：malloc,memory_pool,pmr_pool
+ *   --serial          单线程按全局顺序回放（默认按记录线程并行）
+ *   --no-touch        分配后不写页（只比较分配器本身的开销）
+ *   --json            以JSON输出结果，便于版本之间比较
+ */
+
+#include "memory/allocation_trace.h"
+#include "memory/memory_pool.h"
+#include "memory/trace_replayer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::fprintf(stderr, "用法: %s [-a malloc,memory_pool,pmr_pool] [--serial] [--no-touch] [--json] <轨迹文件>\n",
+                 program);
+}
+
+size_t effectiveAlignment(size_t alignment) {
+    return std::max(alignment, alignof(std::max_align_t));
+}
+
+class MallocAllocator : public TraceReplayer::Allocator {
+public:
+    std::string name() const override { return "malloc"; }
+
+    void* allocate(size_t size, size_t alignment) override {
+        if (alignment <= alignof(std::max_align_t)) {
+            return std::malloc(size ? size : 1);
+        }
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, alignment, size ? size : 1) == 0 ? ptr : nullptr;
+    }
+
+    void deallocate(void* ptr, size_t, size_t) override {
+        std::free(ptr);
+    }
+};
+
+class MemoryPoolAllocator : public TraceReplayer::Allocator {
+public:
+    std::string name() const override { return "memory_pool"; }
+
+    void* allocate(size_t size, size_t alignment) override {
+        return pool_.allocate(size ? size : 1, alignment);
+    }
+
+    void deallocate(void* ptr, size_t, size_t) override {
+        pool_.deallocate(ptr);
+    }
+
+    double fragmentation() const override {
+        return pool_.getFragmentationRate();
+    }
+
+private:
+    MemoryPool pool_;
+};
+
+/**
+ * @brief 池化对照：按大小分档的标准库池（最大池化块4MB，覆盖4K帧平面）
+ */
+class PmrPoolAllocator : public TraceReplayer::Allocator {
+public:
+    PmrPoolAllocator()
+        : resource_(options()) {}
+
+    std::string name() const override { return "pmr_pool"; }
+
+    void* allocate(size_t size, size_t alignment) override {
+        try {
+            return resource_.allocate(size ? size : 1, effectiveAlignment(alignment));
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    void deallocate(void* ptr, size_t size, size_t alignment) override {
+        resource_.deallocate(ptr, size ? size : 1, effectiveAlignment(alignment));
+    }
+
+private:
+    static std::pmr::pool_options options() {
+        std::pmr::pool_options options;
+        options.largest_required_pool_block = 4 * 1024 * 1024;
+        return options;
+    }
+
+    std::pmr::synchronized_pool_resource resource_;
+};
+
+std::unique_ptr<TraceReplayer::Allocator> createAllocator(const std::string& name) {
+    if (name == "malloc") {
+        return std::make_unique<MallocAllocator>();
+    }
+    if (name == "memory_pool") {
+        return std::make_unique<MemoryPoolAllocator>();
+    }
+    if (name == "pmr_pool") {
+        return std::make_unique<PmrPoolAllocator>();
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 子进程通过管道传回的结果（定长，不含指针）
+ */
+struct WireResult {
+    int success;
+    char error[256];
+    double seconds;
+    uint64_t operations;
+    double ns_per_operation;
+    uint64_t failed_allocations;
+    uint64_t baseline_rss_bytes;
+    uint64_t peak_rss_bytes;
+    int peak_rss_reset;
+    uint64_t replay_peak_live_bytes;
+    double overhead_ratio;
+    double fragmentation;
+};
+
+WireResult toWire(const TraceReplayer::Result& result) {
+    WireResult wire{};
+    wire.success = result.success ? 1 : 0;
+    std::snprintf(wire.error, sizeof(wire.error), "%s", result.error.c_str());
+    wire.seconds = result.seconds;
+    wire.operations = result.operations;
+    wire.ns_per_operation = result.ns_per_operation;
+    wire.failed_allocations = result.failed_allocations;
+    wire.baseline_rss_bytes = result.baseline_rss_bytes;
+    wire.peak_rss_bytes = result.peak_rss_bytes;
+    wire.peak_rss_reset = result.peak_rss_reset ? 1 : 0;
+    wire.replay_peak_live_bytes = result.replay_peak_live_bytes;
+    wire.overhead_ratio = result.overhead_ratio;
+    wire.fragmentation = result.fragmentation;
+    return wire;
+}
+
+WireResult replayOnce(const AllocationTrace& trace, const std::string& name, const TraceReplayer::Config& config) {
+    std::unique_ptr<TraceReplayer::Allocator> allocator = createAllocator(name);
+    if (!allocator) {
+        WireResult wire{};
+        std::snprintf(wire.error, sizeof(wire.error), "未知分配器: %s", name.c_str());
+        return wire;
+    }
+    return toWire(TraceReplayer::replay(trace, *allocator, config));
+}
+
+/**
+ * @brief 在子进程中回放，fork失败时退化为进程内回放
+ */
+WireResult replayIsolated(const AllocationTrace& trace, const std::string& name, const TraceReplayer::Config& config) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return replayOnce(trace, name, config);
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return replayOnce(trace, name, config);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const WireResult wire = replayOnce(trace, name, config);
+        const ssize_t written = write(fds[1], &wire, sizeof(wire));
+        _exit(written == static_cast<ssize_t>(sizeof(wire)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    WireResult wire{};
+    size_t received = 0;
+    while (received < sizeof(wire)) {
+        const ssize_t n = read(fds[0], reinterpret_cast<char*>(&wire) + received, sizeof(wire) - received);
+        if (n <= 0) {
+            break;
+        }
+        received += static_cast<size_t>(n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (received != sizeof(wire)) {
+        wire = WireResult{};
+        std::snprintf(wire.error, sizeof(wire.error), "回放进程异常退出（状态%d）", status);
+    }
+    return wire;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+double toMiB(uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void printText(const std::string& path, const AllocationTrace::Summary& summary, const AllocationTrace& trace,
+               const std::vector<std::string>& names, const std::vector<WireResult>& results) {
+    std::printf("轨迹: %s\n", path.c_str());
+    std::printf("  事件 %llu（分配 %llu，释放 %llu），线程 %u，%.1f 字节/事件\n",
+                static_cast<unsigned long long>(summary.events),
+                static_cast<unsigned long long>(summary.allocations),
+                static_cast<unsigned long long>(summary.frees), summary.threads,
+                summary.events ? static_cast<double>(trace.encodedBytes()) / summary.events : 0.0);
+    std::printf("  累计分配 %.1f MiB，峰值存活 %.1f MiB / %llu 块，最大单块 %.1f MiB\n",
+                toMiB(summary.total_bytes), toMiB(summary.peak_live_bytes),
+                static_cast<unsigned long long>(summary.peak_live_blocks), toMiB(summary.max_size));
+    std::printf("  跨线程释放 %llu，结束时未释放 %llu\n\n",
+                static_cast<unsigned long long>(summary.cross_thread_frees),
+                static_cast<unsigned long long>(summary.unfreed_blocks));
+
+    std::printf("%-12s %10s %8s %13s %13s %13s %9s %8s %7s\n", "分配器", "耗时(ms)", "ns/op",
+                "峰值存活(MiB)", "峰值RSS(MiB)", "RSS增量(MiB)", "额外占用", "碎片率", "失败");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const WireResult& r = results[i];
+        if (!r.success) {
+            std::printf("%-12s 失败: %s\n", names[i].c_str(), r.error);
+            continue;
+        }
+        const uint64_t growth = r.peak_rss_bytes > r.baseline_rss_bytes ? r.peak_rss_bytes - r.baseline_rss_bytes : 0;
+        char fragmentation[16];
+        if (r.fragmentation < 0.0) {
+            std::snprintf(fragmentation, sizeof(fragmentation), "-");
+        } else {
+            std::snprintf(fragmentation, sizeof(fragmentation), "%.1f%%", r.fragmentation * 100.0);
+        }
+        std::printf("%-12s %10.2f %8.1f %13.1f %13.1f %13.1f %8.1f%% %8s %7llu%s\n",
+                    names[i].c_str(), r.seconds * 1000.0, r.ns_per_operation, toMiB(r.replay_peak_live_bytes),
+                    toMiB(r.peak_rss_bytes),
+                    toMiB(growth), r.overhead_ratio * 100.0, fragmentation,
+                    static_cast<unsigned long long>(r.failed_allocations),
+                    r.peak_rss_reset ? "" : "  (峰值RSS未能重置)");
+    }
+}
+
+void printJson(const std::string& path, const AllocationTrace::Summary& summary,
+               const std::vector<std::string>& names, const std::vector<WireResult>& results) {
+    std::printf("{\n  \"trace\": \"%s\",\n", path.c_str());
+    std::printf("  \"events\": %llu, \"allocations\": %llu, \"threads\": %u, \"peak_live_bytes\": %llu,\n",
+                static_cast<unsigned long long>(summary.events),
+                static_cast<unsigned long long>(summary.allocations), summary.threads,
+                static_cast<unsigned long long>(summary.peak_live_bytes));
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const WireResult& r = results[i];
+        std::printf("    {\"allocator\": \"%s\", \"success\": %s, \"seconds\": %.6f, \"ns_per_op\": %.2f, "
+                    "\"peak_live_bytes\": %llu, \"peak_rss_bytes\": %llu, \"baseline_rss_bytes\": %llu, "
+                    "\"overhead_ratio\": %.4f, "
+                    "\"fragmentation\": %.4f, \"failed_allocations\": %llu}%s\n",
+                    names[i].c_str(), r.success ? "true" : "false", r.seconds, r.ns_per_operation,
+                    static_cast<unsigned long long>(r.replay_peak_live_bytes),
+                    static_cast<unsigned long long>(r.peak_rss_bytes),
+                    static_cast<unsigned long long>(r.baseline_rss_bytes), r.overhead_ratio, r.fragmentation,
+                    static_cast<unsigned long long>(r.failed_allocations), i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> names = {"malloc", "memory_pool", "pmr_pool"};
+    TraceReplayer::Config config;
+    bool json = false;
+    std::string path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-a" && i + 1 < argc) {
+            names = splitList(argv[++i]);
+        } else if (arg == "--serial") {
+            config.threaded = false;
+        } else if (arg == "--no-touch") {
+            config.touch_pages = false;
+        } else if (arg == "--json") {
+            json = true;
+        } else if (!arg.empty() && arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty() || names.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    AllocationTrace trace;
+    if (!trace.load(path)) {
+        std::fprintf(stderr, "%s\n", trace.getLastError().c_str());
+        return 1;
+    }
+    const AllocationTrace::Summary summary = trace.summarize();
+
+    std::vector<WireResult> results;
+    for (const std::string& name : names) {
+        results.push_back(replayIsolated(trace, name, config));
+    }
+
+    if (json) {
+        printJson(path, summary, names, results);
+    } else {
+        printText(path, summary, trace, names, results);
+    }
+
+    const bool all_ok = std::all_of(results.begin(), results.end(),
+                                    [](const WireResult& r) { return r.success != 0; });
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * @brief 批量抽帧命令行工具
+ *
+ * 用法：
+ *   frame_extract [选项] <文件|@列表文件>...
+ *
+ * 选项：
+ *   -o <目录>          图片输出目录（默认当前目录）
+ *   -i <秒>            抽帧间隔（默认1）
+ *   -t <秒,秒,...>     指定时间点（与-i二选一）
+ *   --start <秒>       起始时间
+ *   --end <秒>         结束时间
+ *   -k                 只取关键帧（最快，时间不精确）
+ *   -n <帧数>          每个文件最多抽取的帧数
+ *   -w <宽> -h <高>    输出尺寸，只给一边时按宽高比计算
+ *   -f jpg|png         图片格式
+ *   -j <线程数>        工作线程数（默认CPU核数）
+ *   --shm <名称> --shm-size <字节>
+ *                      把RGB24原始像素写进POSIX共享内存，不写图片；帧索引以CSV输出到stdout
+ */
+
+#include "media/extract/frame_extractor.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "用法: %s [选项] <文件|@列表文件>...\n"
+                 "  -o <目录>  -i <秒>  -t <秒,秒,...>  --start <秒>  --end <秒>  -k  -n <帧数>\n"
+                 "  -w <宽>  -h <高>  -f jpg|png  -j <线程数>  --shm <名称> --shm-size <字节>\n",
+                 program);
+}
+
+int64_t secondsToUs(const char* text) {
+    return static_cast<int64_t>(std::atof(text) * 1000000.0);
+}
+
+// @开头的参数是文件列表，每行一个路径
+bool appendFiles(const std::string& arg, std::vector<std::string>& files) {
+    if (arg.empty() || arg[0] != '@') {
+        files.push_back(arg);
+        return true;
+    }
+    std::ifstream list(arg.substr(1));
+    if (!list) {
+        std::fprintf(stderr, "无法读取文件列表: %s\n", arg.c_str() + 1);
+        return false;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            files.push_back(line);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    media::FrameExtractor::Config config;
+    config.output_directory = ".";
+    media::SamplingSpec spec;
+    std::vector<std::string> files;
+    std::string shm_name;
+    size_t shm_size = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-o" && has_value) {
+            config.output_directory = argv[++i];
+        } else if (arg == "-i" && has_value) {
+            spec.mode = media::SamplingSpec::Mode::Interval;
+            spec.interval_us = secondsToUs(argv[++i]);
+        } else if (arg == "-t" && has_value) {
+            spec.mode = media::SamplingSpec::Mode::Timestamps;
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                spec.timestamps_us.push_back(secondsToUs(item.c_str()));
+            }
+        } else if (arg == "--start" && has_value) {
+            spec.start_us = secondsToUs(argv[++i]);
+        } else if (arg == "--end" && has_value) {
+            spec.end_us = secondsToUs(argv[++i]);
+        } else if (arg == "-k") {
+            spec.keyframes_only = true;
+        } else if (arg == "-n" && has_value) {
+            spec.max_frames_per_file = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "-w" && has_value) {
+            config.output_width = std::atoi(argv[++i]);
+        } else if (arg == "-h" && has_value) {
+            config.output_height = std::atoi(argv[++i]);
+        } else if (arg == "-f" && has_value) {
+            const std::string format = argv[++i];
+            config.image_format = format == "png" ? media::SnapshotService::ImageFormat::PNG
+                                                  : media::SnapshotService::ImageFormat::JPEG;
+        } else if (arg == "-j" && has_value) {
+            config.worker_count = std::atoi(argv[++i]);
+        } else if (arg == "--shm" && has_value) {
+            shm_name = argv[++i];
+        } else if (arg == "--shm-size" && has_value) {
+            shm_size = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage(argv[0]);
+            return 2;
+        } else if (!appendFiles(arg, files)) {
+            return 2;
+        }
+    }
+    if (files.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // 共享内存输出：调用方（如训练进程）按stdout中的索引直接读取像素
+    uint8_t* buffer = nullptr;
+    int shm_fd = -1;
+    if (!shm_name.empty()) {
+        if (shm_size == 0) {
+            std::fprintf(stderr, "--shm 需要 --shm-size\n");
+            return 2;
+        }
+        shm_fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0600);
+        if (shm_fd < 0 || ftruncate(shm_fd, static_cast<off_t>(shm_size)) != 0) {
+            std::fprintf(stderr, "创建共享内存失败: %s\n", std::strerror(errno));
+            return 1;
+        }
+        void* mapped = mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::fprintf(stderr, "映射共享内存失败: %s\n", std::strerror(errno));
+            close(shm_fd);
+            return 1;
+        }
+        buffer = static_cast<uint8_t*>(mapped);
+        config.target = media::FrameExtractor::OutputTarget::Buffer;
+        config.buffer_format = AV_PIX_FMT_RGB24;
+    }
+
+    media::FrameExtractor extractor(config);
+    if (buffer) {
+        extractor.setOutputBuffer(buffer, shm_size);
+    }
+    const bool ok = extractor.run(files, spec);
+
+    for (const std::string& error : extractor.getErrors()) {
+        std::fprintf(stderr, "⚠️  %s\n", error.c_str());
+    }
+    if (buffer) {
+        std::printf("file,sample,requested_us,timestamp_us,keyframe,width,height,offset,bytes\n");
+        for (const media::ExtractedFrame& frame : extractor.results()) {
+            std::printf("%s,%zu,%lld,%lld,%d,%d,%d,%zu,%zu\n", files[frame.file_index].c_str(),
+                        frame.sample_index, static_cast<long long>(frame.requested_us),
+                        static_cast<long long>(frame.timestamp_us), frame.keyframe ? 1 : 0,
+                        frame.width, frame.height, frame.buffer_offset, frame.buffer_bytes);
+        }
+        munmap(buffer, shm_size);
+        close(shm_fd);
+    }
+
+    const media::FrameExtractor::StatisticsSnapshot stats = extractor.getStatistics();
+    const double seconds = stats.elapsed_ms / 1000.0;
+    const double fps = seconds > 0.0 ? stats.frames_extracted / seconds : 0.0;
+    std::fprintf(stderr,
+                 "📊 %llu个文件（失败%llu），抽出%llu帧（失败%llu），耗时%.2fs，%.1f帧/秒，"
+                 "每核%.1f帧/秒（%d线程），seek %llu次，解码%llu帧\n",
+                 static_cast<unsigned long long>(stats.files_done),
+                 static_cast<unsigned long long>(stats.files_failed),
+                 static_cast<unsigned long long>(stats.frames_extracted),
+                 static_cast<unsigned long long>(stats.frames_failed),
+                 seconds, fps, stats.workers > 0 ? fps / stats.workers : 0.0, stats.workers,
+                 static_cast<unsigned long long>(stats.seeks),
+                 static_cast<unsigned long long>(stats.frames_decoded));
+    if (!ok) {
+        std::fprintf(stderr, "❌ %s\n", extractor.getLastError().c_str());
+        return 1;
+    }
+    return 0;
+}
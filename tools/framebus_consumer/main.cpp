@@ -0,0 +1,295 @@
+/**
+ * @brief 帧总线示例消费者（以及用于演示的发布端）
+ *
+ * 用法：
+ *   framebus_consumer [选项] <总线名称|路径>
+ *       读取帧总线，零拷贝计算每帧的平均亮度，每秒打印帧率、跨进程延迟、丢帧和撕裂计数
+ *   framebus_consumer --publish <媒体文件> <总线名称>
+ *       解码文件并按原始帧率发布到POSIX shm帧总线（名称以'/'开头）
+ *
+ * 选项：
+ *   -l                 只取最新帧（实时分析，跟不上时跳帧）
+ *   -n <帧数>          读取指定帧数后退出
+ *   -o <文件>          把读到的帧按原始平面追加写入文件（会产生拷贝，仅用于检查）
+ *   --slots <数量>     发布端的槽数（默认8）
+ */
+
+#include "media/framebus/frame_bus.h"
+#include "media/decoder/ffmpeg_decoder.h"
+#include "media/demux/ffmpeg_demuxer.h"
+#include "media/input/input_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "用法: %s [-l] [-n <帧数>] [-o <文件>] <总线名称|路径>\n"
+                 "      %s --publish <媒体文件> <总线名称> [--slots <数量>]\n",
+                 program, program);
+}
+
+// 示例分析：直接在共享内存上计算亮度平面均值
+double meanLuma(const media::FrameBusConsumer::FrameView& view) {
+    if (!view.data[0] || view.width <= 0 || view.height <= 0) {
+        return 0.0;
+    }
+    uint64_t sum = 0;
+    for (int y = 0; y < view.height; ++y) {
+        const uint8_t* row = view.data[0] + static_cast<size_t>(y) * view.linesize[0];
+        for (int x = 0; x < view.width; ++x) {
+            sum += row[x];
+        }
+    }
+    return static_cast<double>(sum) / (static_cast<double>(view.width) * view.height);
+}
+
+void writePlanes(std::FILE* out, const media::FrameBusConsumer::FrameView& view) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(view.format);
+    if (!desc) {
+        return;
+    }
+    int line_bytes[4] = {0, 0, 0, 0};
+    av_image_fill_linesizes(line_bytes, view.format, view.width);
+    for (int plane = 0; plane < 4 && view.data[plane]; ++plane) {
+        const int rows = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(view.height, desc->log2_chroma_h)
+                                                    : view.height;
+        for (int y = 0; y < rows; ++y) {
+            std::fwrite(view.data[plane] + static_cast<size_t>(y) * view.linesize[plane], 1,
+                        static_cast<size_t>(line_bytes[plane]), out);
+        }
+    }
+}
+
+int runConsumer(const std::string& name, bool latest_only, uint64_t max_frames, const std::string& output) {
+    media::FrameBusConsumer::Config config;
+    config.latest_only = latest_only;
+    media::FrameBusConsumer consumer(config);
+
+    // 生产者可能稍后才启动
+    while (!consumer.open(name)) {
+        if (g_stop) {
+            return 1;
+        }
+        std::fprintf(stderr, "⏳ %s，重试中\n", consumer.getLastError().c_str());
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    std::fprintf(stderr, "✅ 已打开帧总线 %s（%u个槽）\n", name.c_str(), consumer.slotCount());
+
+    std::FILE* out = output.empty() ? nullptr : std::fopen(output.c_str(), "wb");
+    if (!output.empty() && !out) {
+        std::fprintf(stderr, "无法写入 %s\n", output.c_str());
+        return 1;
+    }
+
+    uint64_t frames = 0;
+    uint64_t window_frames = 0;
+    int64_t window_latency_ns = 0;
+    int64_t window_max_latency_ns = 0;
+    double luma = 0.0;
+    auto window_start = std::chrono::steady_clock::now();
+    media::FrameBusConsumer::FrameView view;
+
+    while (!g_stop && (max_frames == 0 || frames < max_frames)) {
+        if (consumer.next(view, 500)) {
+            const int64_t latency = media::FrameBusLayout::monotonicNs() - view.publish_time_ns;
+            const double value = meanLuma(view);
+            if (out) {
+                writePlanes(out, view);
+            }
+            // 处理期间被覆盖的帧结果作废
+            if (consumer.finish(view)) {
+                luma = value;
+                ++frames;
+                ++window_frames;
+                window_latency_ns += latency;
+                window_max_latency_ns = std::max(window_max_latency_ns, latency);
+            }
+        } else if (consumer.producerClosed()) {
+            std::fprintf(stderr, "生产者已关闭\n");
+            break;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - window_start).count();
+        if (elapsed >= 1.0) {
+            const media::FrameBusConsumer::StatisticsSnapshot stats = consumer.getStatistics();
+            std::fprintf(stderr,
+                         "📊 %.1f帧/秒，延迟平均%.1fus 最大%.1fus，%dx%d %s，亮度%.1f，丢帧%llu，撕裂%llu\n",
+                         window_frames / elapsed,
+                         window_frames > 0 ? window_latency_ns / 1000.0 / window_frames : 0.0,
+                         window_max_latency_ns / 1000.0, view.width, view.height,
+                         view.format != AV_PIX_FMT_NONE ? av_get_pix_fmt_name(view.format) : "-", luma,
+                         static_cast<unsigned long long>(stats.frames_missed),
+                         static_cast<unsigned long long>(stats.frames_torn));
+            window_start = now;
+            window_frames = 0;
+            window_latency_ns = 0;
+            window_max_latency_ns = 0;
+        }
+    }
+
+    if (out) {
+        std::fclose(out);
+    }
+    const media::FrameBusConsumer::StatisticsSnapshot stats = consumer.getStatistics();
+    std::fprintf(stderr, "共读取%llu帧，丢帧%llu，撕裂%llu\n",
+                 static_cast<unsigned long long>(stats.frames_read),
+                 static_cast<unsigned long long>(stats.frames_missed),
+                 static_cast<unsigned long long>(stats.frames_torn));
+    return 0;
+}
+
+int runPublisher(const std::string& url, const std::string& name, uint32_t slots) {
+    std::shared_ptr<media::IInputSource> input(media::InputSourceFactory::create(url));
+    media::FFmpegDemuxer demuxer;
+    if (!input || !input->open(url) || !demuxer.initialize(input)) {
+        std::fprintf(stderr, "无法打开 %s\n", url.c_str());
+        return 1;
+    }
+    const int video_index = demuxer.findStream(AVMEDIA_TYPE_VIDEO);
+    const AVCodecParameters* codecpar = demuxer.getCodecParameters(video_index);
+    if (video_index < 0 || !codecpar) {
+        std::fprintf(stderr, "%s 没有视频流\n", url.c_str());
+        return 1;
+    }
+    const AVRational time_base = input->getFormatContext()->streams[video_index]->time_base;
+
+    media::FFmpegVideoDecoder decoder;
+    if (!decoder.initialize(codecpar)) {
+        std::fprintf(stderr, "解码器初始化失败: %s\n", decoder.getLastError().c_str());
+        return 1;
+    }
+
+    media::FrameBusProducer::Config config;
+    config.name = name;
+    config.slot_count = slots;
+    config.max_width = codecpar->width;
+    config.max_height = codecpar->height;
+    config.max_format = static_cast<AVPixelFormat>(codecpar->format) != AV_PIX_FMT_NONE
+                            ? static_cast<AVPixelFormat>(codecpar->format) : AV_PIX_FMT_YUV420P;
+    media::FrameBusProducer producer(config);
+    if (!producer.open()) {
+        std::fprintf(stderr, "创建帧总线失败: %s\n", producer.getLastError().c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "📤 发布 %s -> %s（%dx%d，%u个槽，每槽%zu字节）\n", url.c_str(), name.c_str(),
+                 codecpar->width, codecpar->height, slots, producer.slotBytes());
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    const auto start = std::chrono::steady_clock::now();
+    int64_t first_pts = AV_NOPTS_VALUE;
+    bool draining = false;
+
+    while (!g_stop) {
+        if (!draining) {
+            if (demuxer.readPacket(packet)) {
+                if (packet->stream_index == video_index) {
+                    decoder.sendPacket(packet);
+                }
+                av_packet_unref(packet);
+            } else {
+                decoder.sendPacket(nullptr);
+                draining = true;
+            }
+        }
+        bool got_frame = false;
+        while (decoder.receiveFrame(frame)) {
+            got_frame = true;
+            // 按显示时间节奏发布，模拟实时源
+            const int64_t pts = frame->best_effort_timestamp;
+            if (pts != AV_NOPTS_VALUE) {
+                if (first_pts == AV_NOPTS_VALUE) {
+                    first_pts = pts;
+                }
+                const int64_t due_us = av_rescale_q(pts - first_pts, time_base, AV_TIME_BASE_Q);
+                std::this_thread::sleep_until(start + std::chrono::microseconds(due_us));
+            }
+            if (!producer.publish(frame, time_base)) {
+                std::fprintf(stderr, "⚠️  %s\n", producer.getLastError().c_str());
+            }
+            av_frame_unref(frame);
+        }
+        if (draining && !got_frame) {
+            break;
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    const media::FrameBusProducer::StatisticsSnapshot stats = producer.getStatistics();
+    std::fprintf(stderr, "共发布%llu帧（%.1fMB），拒绝%llu帧\n",
+                 static_cast<unsigned long long>(stats.frames_published),
+                 stats.bytes_published / (1024.0 * 1024.0),
+                 static_cast<unsigned long long>(stats.frames_rejected));
+    producer.close();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    bool latest_only = false;
+    uint64_t max_frames = 0;
+    std::string output;
+    std::string publish_url;
+    uint32_t slots = 8;
+    std::string name;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-l") {
+            latest_only = true;
+        } else if (arg == "-n" && has_value) {
+            max_frames = static_cast<uint64_t>(std::atoll(argv[++i]));
+        } else if (arg == "-o" && has_value) {
+            output = argv[++i];
+        } else if (arg == "--publish" && has_value) {
+            publish_url = argv[++i];
+        } else if (arg == "--slots" && has_value) {
+            slots = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage(argv[0]);
+            return 2;
+        } else {
+            name = arg;
+        }
+    }
+    if (name.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (!publish_url.empty()) {
+        return runPublisher(publish_url, name, slots);
+    }
+    return runConsumer(name, latest_only, max_frames, output);
+}
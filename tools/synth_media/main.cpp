@@ -0,0 +1,255 @@
+/**
+ * @brief 合成测试媒体命令行工具
+ *
+ * 用法：
+ *   synth_media [选项]                          按参数矩阵生成测试文件（已有的复用）
+ *   synth_media --serve http|udp|rtsp <文件>    把文件当作直播流在回环地址上循环发布
+ *
+ * 生成选项：
+ *   -o <目录>                    输出目录（默认synthetic_media）
+ *   --codecs h264,mpeg4          编解码器（h264/h265/av1/mpeg4），没有编译的跳过
+ *   --resolutions 640x360,...    分辨率
+ *   --gops 1x0,60x2              关键帧间隔x最大B帧
+ *   --bitrates 0,2000k,4M        码率，0为恒定质量（crf）
+ *   --duration <秒>  --fps <帧率>  --crf <值>  --preset <预设>  --noise <0~64>
+ *   --container mp4|mkv|ts  --no-audio
+ *   --force                      忽略已有文件，重新生成
+ *
+ * 发布选项：
+ *   --port <端口>                默认系统分配
+ *   --path <路径>                HTTP/RTSP地址路径（默认/stream）
+ *   --rate <倍数>                发送速度，0为尽快发送（仅HTTP/RTSP）
+ *   --no-loop                    读完不循环
+ */
+
+#include "media/synthetic/loopback_media_server.h"
+#include "media/synthetic/synthetic_media.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void onSignal(int) {
+    g_stop.store(true);
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "用法: %s [-o <目录>] [--codecs h264,mpeg4] [--resolutions 640x360,1280x720] [--gops 1x0,60x2]\n"
+                 "          [--bitrates 0,2000k] [--duration <秒>] [--fps <帧率>] [--crf <值>] [--preset <预设>]\n"
+                 "          [--noise <0~64>] [--container mp4|mkv|ts] [--no-audio] [--force]\n"
+                 "       %s --serve http|udp|rtsp [--port <端口>] [--path <路径>] [--rate <倍数>] [--no-loop] <文件>\n",
+                 program, program);
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// "1280x720"、"60x2"
+bool parsePair(const std::string& text, std::pair<int, int>* pair) {
+    const size_t separator = text.find('x');
+    if (separator == std::string::npos) {
+        return false;
+    }
+    pair->first = std::atoi(text.c_str());
+    pair->second = std::atoi(text.c_str() + separator + 1);
+    return pair->first > 0 && pair->second >= 0;
+}
+
+// "0"、"2000k"、"4M"
+int64_t parseBitRate(const std::string& text) {
+    double value = std::atof(text.c_str());
+    if (!text.empty() && (text.back() == 'k' || text.back() == 'K')) {
+        value *= 1000.0;
+    } else if (!text.empty() && (text.back() == 'm' || text.back() == 'M')) {
+        value *= 1000000.0;
+    }
+    return static_cast<int64_t>(value);
+}
+
+int serve(const media::LoopbackMediaServer::Config& config, const std::string& file) {
+    media::LoopbackMediaServer server(config);
+    if (!server.start(file)) {
+        std::fprintf(stderr, "❌ %s\n", server.getLastError().c_str());
+        return 1;
+    }
+    std::printf("%s\n", server.url().c_str());
+    std::fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    auto last_report = std::chrono::steady_clock::now();
+    while (!g_stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (!server.isRunning()) {
+            break;
+        }
+        if (std::chrono::steady_clock::now() - last_report < std::chrono::seconds(5)) {
+            continue;
+        }
+        last_report = std::chrono::steady_clock::now();
+        const media::LoopbackMediaServer::StatisticsSnapshot stats = server.getStatistics();
+        std::fprintf(stderr, "📊 已发送%llu包/%.1fMB，循环%llu次，RTSP会话%llu，断开慢客户端%llu\n",
+                     static_cast<unsigned long long>(stats.packets_sent), stats.bytes_sent / 1e6,
+                     static_cast<unsigned long long>(stats.loops),
+                     static_cast<unsigned long long>(stats.rtsp_sessions),
+                     static_cast<unsigned long long>(stats.clients_dropped));
+    }
+
+    const std::string error = server.getLastError();
+    const bool failed = !g_stop.load() && !error.empty();
+    server.stop();
+    if (failed) {
+        std::fprintf(stderr, "❌ %s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    media::SyntheticMediaGenerator::Matrix matrix;
+    matrix.base.duration_s = 10.0;
+    std::string output_directory = "synthetic_media";
+    bool force = false;
+
+    media::LoopbackMediaServer::Config serve_config;
+    bool serving = false;
+    std::string serve_file;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-o" && has_value) {
+            output_directory = argv[++i];
+        } else if (arg == "--codecs" && has_value) {
+            for (const std::string& name : splitList(argv[++i])) {
+                media::EncoderCodec codec;
+                if (!media::SyntheticMediaGenerator::parseCodec(name, &codec)) {
+                    std::fprintf(stderr, "未知的编解码器: %s\n", name.c_str());
+                    return 2;
+                }
+                matrix.codecs.push_back(codec);
+            }
+        } else if (arg == "--resolutions" && has_value) {
+            for (const std::string& item : splitList(argv[++i])) {
+                std::pair<int, int> resolution;
+                if (!parsePair(item, &resolution)) {
+                    std::fprintf(stderr, "无效的分辨率: %s\n", item.c_str());
+                    return 2;
+                }
+                matrix.resolutions.push_back(resolution);
+            }
+        } else if (arg == "--gops" && has_value) {
+            for (const std::string& item : splitList(argv[++i])) {
+                std::pair<int, int> gop;
+                if (!parsePair(item, &gop)) {
+                    std::fprintf(stderr, "无效的GOP（关键帧间隔x最大B帧）: %s\n", item.c_str());
+                    return 2;
+                }
+                matrix.gops.push_back(gop);
+            }
+        } else if (arg == "--bitrates" && has_value) {
+            for (const std::string& item : splitList(argv[++i])) {
+                matrix.bit_rates.push_back(parseBitRate(item));
+            }
+        } else if (arg == "--duration" && has_value) {
+            matrix.base.duration_s = std::atof(argv[++i]);
+        } else if (arg == "--fps" && has_value) {
+            matrix.base.frame_rate = {std::atoi(argv[++i]), 1};
+        } else if (arg == "--crf" && has_value) {
+            matrix.base.crf = std::atoi(argv[++i]);
+        } else if (arg == "--preset" && has_value) {
+            matrix.base.preset = argv[++i];
+        } else if (arg == "--noise" && has_value) {
+            matrix.base.noise = std::atoi(argv[++i]);
+        } else if (arg == "--container" && has_value) {
+            matrix.base.container = argv[++i];
+        } else if (arg == "--no-audio") {
+            matrix.base.audio = false;
+        } else if (arg == "--force") {
+            force = true;
+        } else if (arg == "--serve" && has_value) {
+            if (!media::LoopbackMediaServer::parseProtocol(argv[++i], &serve_config.protocol)) {
+                std::fprintf(stderr, "未知的协议: %s\n", argv[i]);
+                return 2;
+            }
+            serving = true;
+        } else if (arg == "--port" && has_value) {
+            serve_config.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--path" && has_value) {
+            serve_config.path = argv[++i];
+        } else if (arg == "--rate" && has_value) {
+            serve_config.rate = std::atof(argv[++i]);
+        } else if (arg == "--no-loop") {
+            serve_config.loop = false;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (serving && serve_file.empty() && !arg.empty() && arg[0] != '-') {
+            serve_file = arg;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (serving) {
+        if (serve_file.empty()) {
+            printUsage(argv[0]);
+            return 2;
+        }
+        return serve(serve_config, serve_file);
+    }
+
+    media::SyntheticMediaGenerator generator;
+    std::vector<media::SyntheticMediaGenerator::Result> results;
+    if (force) {
+        // 先删掉矩阵里已有的文件，ensure就会重新生成
+        for (const auto& spec : matrix.expand()) {
+            std::remove((output_directory + "/" + spec.name()).c_str());
+        }
+    }
+    const bool ok = generator.ensureMatrix(matrix, output_directory, &results);
+
+    std::printf("path,codec,width,height,gop,max_b_frames,bit_rate,generated,video_frames,video_bytes,encode_ms\n");
+    double total_ms = 0.0;
+    size_t generated = 0;
+    for (const auto& result : results) {
+        const auto& spec = result.spec;
+        std::printf("%s,%s,%d,%d,%d,%d,%lld,%d,%llu,%llu,%.1f\n", result.path.c_str(),
+                    media::SyntheticMediaGenerator::codecName(spec.codec), spec.width, spec.height,
+                    spec.gop_size, spec.max_b_frames, static_cast<long long>(spec.effectiveBitRate()),
+                    result.generated ? 1 : 0, static_cast<unsigned long long>(result.video_frames),
+                    static_cast<unsigned long long>(result.video_bytes), result.encode_ms);
+        total_ms += result.encode_ms;
+        generated += result.generated ? 1 : 0;
+    }
+    std::fprintf(stderr, "📊 %zu个文件（新生成%zu个，复用%zu个），编码耗时%.2fs\n",
+                 results.size(), generated, results.size() - generated, total_ms / 1000.0);
+    if (!ok) {
+        std::fprintf(stderr, "❌ %s\n", generator.getLastError().c_str());
+        return 1;
+    }
+    return 0;
+}